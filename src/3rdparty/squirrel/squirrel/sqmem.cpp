@@ -9,8 +9,11 @@
 #include "../../../core/alloc_func.hpp"
 #include "../../../safeguards.h"
 
-void *sq_vm_malloc(SQUnsignedInteger size){	return MallocT<char>((size_t)size); }
+/** Bytes allocated by all Squirrel VMs together. */
+size_t _sq_vm_allocated = 0;
 
-void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize, SQUnsignedInteger size){ return ReallocT<char>(static_cast<char*>(p), (size_t)size); }
+void *sq_vm_malloc(SQUnsignedInteger size){	_sq_vm_allocated += (size_t)size; return MallocT<char>((size_t)size); }
 
-void sq_vm_free(void *p, SQUnsignedInteger size){	free(p); }
+void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize, SQUnsignedInteger size){ _sq_vm_allocated += (size_t)size - (size_t)oldsize; return ReallocT<char>(static_cast<char*>(p), (size_t)size); }
+
+void sq_vm_free(void *p, SQUnsignedInteger size){	_sq_vm_allocated -= (size_t)size; free(p); }
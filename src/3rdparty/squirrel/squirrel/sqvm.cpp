@@ -907,7 +907,14 @@ common_call:
 				if(!IsEqual(STK(arg2),COND_LITERAL,res)) { SQ_THROW(); }
 				TARGET = (!res)?_true_:_false_;
 				} continue;
-			case _OP_ARITH: _GUARD(ARITH_OP( arg3 , temp_reg, STK(arg2), STK(arg1))); TARGET = temp_reg; continue;
+			case _OP_ARITH:
+				/* Fast path for integer arithmetic that cannot fail; no temporary is needed. */
+				if (type(STK(arg2)) == OT_INTEGER && type(STK(arg1)) == OT_INTEGER && (arg3 == '+' || arg3 == '-' || arg3 == '*')) {
+					SQInteger i1 = _integer(STK(arg2)), i2 = _integer(STK(arg1));
+					TARGET = (arg3 == '+') ? i1 + i2 : ((arg3 == '-') ? i1 - i2 : i1 * i2);
+					continue;
+				}
+				_GUARD(ARITH_OP( arg3 , temp_reg, STK(arg2), STK(arg1))); TARGET = temp_reg; continue;
 			case _OP_BITW:	_GUARD(BW_OP( arg3,TARGET,STK(arg2),STK(arg1))); continue;
 			case _OP_RETURN:
 				if(ci->_generator) {
@@ -936,12 +943,49 @@ common_call:
 			case _OP_APPENDARRAY: _array(STK(arg0))->Append(COND_LITERAL);	continue;
 			case _OP_GETPARENT: _GUARD(GETPARENT_OP(STK(arg1),TARGET)); continue;
 			case _OP_COMPARITH: _GUARD(DerefInc(arg3, TARGET, STK((((SQUnsignedInteger)arg1&0xFFFF0000)>>16)), STK(arg2), STK(arg1&0x0000FFFF), false)); continue;
-			case _OP_COMPARITHL: _GUARD(LOCAL_INC(arg3, TARGET, STK(arg1), STK(arg2))); continue;
+			case _OP_COMPARITHL:
+				if (type(STK(arg1)) == OT_INTEGER && type(STK(arg2)) == OT_INTEGER && (arg3 == '+' || arg3 == '-' || arg3 == '*')) {
+					SQInteger i1 = _integer(STK(arg1)), i2 = _integer(STK(arg2));
+					SQInteger res = (arg3 == '+') ? i1 + i2 : ((arg3 == '-') ? i1 - i2 : i1 * i2);
+					TARGET = res;
+					STK(arg1) = res;
+					continue;
+				}
+				_GUARD(LOCAL_INC(arg3, TARGET, STK(arg1), STK(arg2))); continue;
 			case _OP_INC: {SQObjectPtr o(sarg3); _GUARD(DerefInc('+',TARGET, STK(arg1), STK(arg2), o, false));} continue;
-			case _OP_INCL: {SQObjectPtr o(sarg3); _GUARD(LOCAL_INC('+',TARGET, STK(arg1), o));} continue;
+			case _OP_INCL:
+				/* Increments of integer locals, as in loops, need no temporaries. */
+				if (type(STK(arg1)) == OT_INTEGER) {
+					SQInteger res = _integer(STK(arg1)) + sarg3;
+					TARGET = res;
+					STK(arg1) = res;
+					continue;
+				}
+				{SQObjectPtr o(sarg3); _GUARD(LOCAL_INC('+',TARGET, STK(arg1), o));} continue;
 			case _OP_PINC: {SQObjectPtr o(sarg3); _GUARD(DerefInc('+',TARGET, STK(arg1), STK(arg2), o, true));} continue;
-			case _OP_PINCL:	{SQObjectPtr o(sarg3); _GUARD(PLOCAL_INC('+',TARGET, STK(arg1), o));} continue;
-			case _OP_CMP:	_GUARD(CMP_OP((CmpOP)arg3,STK(arg2),STK(arg1),TARGET))	continue;
+			case _OP_PINCL:
+				if (type(STK(arg1)) == OT_INTEGER) {
+					SQInteger old = _integer(STK(arg1));
+					TARGET = old;
+					STK(arg1) = old + sarg3;
+					continue;
+				}
+				{SQObjectPtr o(sarg3); _GUARD(PLOCAL_INC('+',TARGET, STK(arg1), o));} continue;
+			case _OP_CMP:
+				if (type(STK(arg2)) == OT_INTEGER && type(STK(arg1)) == OT_INTEGER) {
+					SQInteger i1 = _integer(STK(arg2)), i2 = _integer(STK(arg1));
+					bool res;
+					switch (arg3) {
+						case CMP_G:  res = i1 > i2; break;
+						case CMP_GE: res = i1 >= i2; break;
+						case CMP_L:  res = i1 < i2; break;
+						case CMP_LE: res = i1 <= i2; break;
+						default: assert(0); res = false; break;
+					}
+					TARGET = res ? _true_ : _false_;
+					continue;
+				}
+				_GUARD(CMP_OP((CmpOP)arg3,STK(arg2),STK(arg1),TARGET))	continue;
 			case _OP_EXISTS: TARGET = Get(STK(arg1), STK(arg2), temp_reg, true,false)?_true_:_false_;continue;
 			case _OP_INSTANCEOF:
 				if(type(STK(arg1)) != OT_CLASS || type(STK(arg2)) != OT_INSTANCE)
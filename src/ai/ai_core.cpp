@@ -22,6 +22,9 @@
 #include "ai_config.hpp"
 #include "ai_info.hpp"
 #include "ai.hpp"
+#include <algorithm>
+#include <chrono>
+#include <vector>
 
 #include "../safeguards.h"
 
@@ -66,6 +69,41 @@
 	return;
 }
 
+/** Sorter for AIs, so the ones that were busy for the most turns go first. */
+static bool AIBacklogSorter(const Company *a, const Company *b)
+{
+	return a->ai_instance->GetBacklog() > b->ai_instance->GetBacklog();
+}
+
+/**
+ * Give the AIs that ran out of opcodes further turns, until the extra time
+ * per tick is used up or none of them has anything left to do.
+ * @param cur_company The backup of the current company.
+ */
+static void RunExtraAIOpcodes(Backup<CompanyByte> &cur_company)
+{
+	if (_settings_game.script.script_extra_time_per_tick == 0) return;
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_settings_game.script.script_extra_time_per_tick);
+
+	std::vector<const Company *> busy;
+	for (;;) {
+		busy.clear();
+		const Company *c;
+		FOR_ALL_COMPANIES(c) {
+			if (c->is_ai && c->ai_instance->GetBacklog() > 0) busy.push_back(c);
+		}
+		if (busy.empty()) return;
+		std::stable_sort(busy.begin(), busy.end(), AIBacklogSorter);
+
+		for (std::vector<const Company *>::iterator it = busy.begin(); it != busy.end(); it++) {
+			if (std::chrono::steady_clock::now() >= deadline) return;
+			cur_company.Change((*it)->index);
+			(*it)->ai_instance->RunExtraOpcodes();
+		}
+	}
+}
+
 /* static */ void AI::GameLoop()
 {
 	/* If we are in networking, only servers run this function, and that only if it is allowed */
@@ -87,6 +125,7 @@
 			PerformanceMeasurer::SetInactive((PerformanceElement)(PFE_AI0 + c->index));
 		}
 	}
+	RunExtraAIOpcodes(cur_company);
 	cur_company.Restore();
 
 	/* Occasionally collect garbage; every 255 ticks do one company.
@@ -168,6 +207,7 @@
 
 	AI::frame_counter = 0;
 	if (AI::scanner_info == NULL) {
+		FileScanCache scan_cache;
 		TarScanner::DoScan(TarScanner::AI);
 		AI::scanner_info = new AIScannerInfo();
 		AI::scanner_info->Initialize();
@@ -351,10 +391,13 @@
 
 /* static */ void AI::Rescan()
 {
-	TarScanner::DoScan(TarScanner::AI);
+	{
+		FileScanCache scan_cache;
+		TarScanner::DoScan(TarScanner::AI);
 
-	AI::scanner_info->RescanDir();
-	AI::scanner_library->RescanDir();
+		AI::scanner_info->RescanDir();
+		AI::scanner_library->RescanDir();
+	}
 	ResetConfig();
 
 	InvalidateWindowData(WC_AI_LIST, 0, 1);
@@ -30,6 +30,7 @@
  * Note: this line is a marker in squirrel_export.sh. Do not change! */
 #include "../script/api/ai/ai_accounting.hpp.sq"
 #include "../script/api/ai/ai_airport.hpp.sq"
+#include "../script/api/ai/ai_asyncmode.hpp.sq"
 #include "../script/api/ai/ai_base.hpp.sq"
 #include "../script/api/ai/ai_basestation.hpp.sq"
 #include "../script/api/ai/ai_bridge.hpp.sq"
@@ -106,6 +107,7 @@ void AIInstance::RegisterAPI()
 	SQAIList_Register(this->engine);
 	SQAIAccounting_Register(this->engine);
 	SQAIAirport_Register(this->engine);
+	SQAIAsyncMode_Register(this->engine);
 	SQAIBase_Register(this->engine);
 	SQAIBaseStation_Register(this->engine);
 	SQAIBridge_Register(this->engine);
@@ -260,8 +262,7 @@ void CcAI(const CommandCost &result, TileIndex tile, uint32 p1, uint32 p2)
 	const Company *c = Company::GetIfValid(_current_company);
 	if (c == NULL || c->ai_instance == NULL) return;
 
-	c->ai_instance->DoCommandCallback(result, tile, p1, p2);
-	c->ai_instance->Continue();
+	if (c->ai_instance->DoCommandCallback(result, tile, p1, p2)) c->ai_instance->Continue();
 }
 
 CommandCallback *AIInstance::GetDoCommandCallback()
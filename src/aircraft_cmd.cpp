@@ -32,6 +32,7 @@
 #include "company_func.h"
 #include "effectvehicle_func.h"
 #include "station_base.h"
+#include "station_kdtree.h"
 #include "engine_base.h"
 #include "core/random_func.hpp"
 #include "core/backup_type.hpp"
@@ -121,35 +122,51 @@ enum HelicopterRotorStates {
  */
 static StationID FindNearestHangar(const Aircraft *v)
 {
-	const Station *st;
 	uint best = 0;
 	StationID index = INVALID_STATION;
+	/* v->tile can't be used here, when aircraft is flying v->tile is set to 0 */
 	TileIndex vtile = TileVirtXY(v->x_pos, v->y_pos);
 	const AircraftVehicleInfo *avi = AircraftVehInfo(v->engine_type);
+	const Station *cur_dest = v->acache.cached_max_range_sqr != 0 ? GetTargetAirportIfValid(v) : NULL;
 
-	FOR_ALL_STATIONS(st) {
-		if (st->owner != v->owner || !(st->facilities & FACIL_AIRPORT) || !st->airport.HasHangar()) continue;
+	auto can_use = [&](StationID id) -> bool {
+		const Station *st = Station::Get(id);
+		if (st->owner != v->owner || !st->airport.HasHangar()) return false;
 
 		const AirportFTAClass *afc = st->airport.GetFTA();
 
 		/* don't crash the plane if we know it can't land at the airport */
-		if ((afc->flags & AirportFTAClass::SHORT_STRIP) && (avi->subtype & AIR_FAST) && !_cheats.no_jetcrash.value) continue;
+		if ((afc->flags & AirportFTAClass::SHORT_STRIP) && (avi->subtype & AIR_FAST) && !_cheats.no_jetcrash.value) return false;
 
 		/* the plane won't land at any helicopter station */
-		if (!(afc->flags & AirportFTAClass::AIRPLANES) && (avi->subtype & AIR_CTOL)) continue;
-
-		/* v->tile can't be used here, when aircraft is flying v->tile is set to 0 */
-		uint distance = DistanceSquare(vtile, st->airport.tile);
-		if (v->acache.cached_max_range_sqr != 0) {
-			/* Check if our current destination can be reached from the depot airport. */
-			const Station *cur_dest = GetTargetAirportIfValid(v);
-			if (cur_dest != NULL && DistanceSquare(st->airport.tile, cur_dest->airport.tile) > v->acache.cached_max_range_sqr) continue;
-		}
-		if (distance < best || index == INVALID_STATION) {
-			best = distance;
-			index = st->index;
-		}
-	}
+		if (!(afc->flags & AirportFTAClass::AIRPLANES) && (avi->subtype & AIR_CTOL)) return false;
+
+		/* Check if our current destination can be reached from the depot airport. */
+		if (cur_dest != NULL && DistanceSquare(st->airport.tile, cur_dest->airport.tile) > v->acache.cached_max_range_sqr) return false;
+
+		return true;
+	};
+
+	/* The k-d tree finds the nearest usable hangar by Manhattan distance, but the
+	 * aircraft goes to the hangar that is nearest as the crow flies. That one is
+	 * never further away in either direction than the Manhattan nearest one. */
+	StationID nearest;
+	if (!_airport_kdtree.FindNearest(TileX(vtile), TileY(vtile), INT_MAX, can_use, &nearest)) return INVALID_STATION;
+	uint radius = DistanceManhattan(vtile, Station::Get(nearest)->airport.tile);
+
+	uint16 x1 = (uint16)max<int>(0, TileX(vtile) - radius);
+	uint16 x2 = (uint16)min<int>(TileX(vtile) + radius + 1, MapSizeX());
+	uint16 y1 = (uint16)max<int>(0, TileY(vtile) - radius);
+	uint16 y2 = (uint16)min<int>(TileY(vtile) + radius + 1, MapSizeY());
+
+	_airport_kdtree.FindContained(x1, y1, x2, y2, [&](StationID id) {
+		uint distance = DistanceSquare(vtile, Station::Get(id)->airport.tile);
+		/* Equally near hangars go to the lowest station ID, like the pool order used to decide. */
+		if (index != INVALID_STATION && (distance > best || (distance == best && id > index))) return;
+		if (!can_use(id)) return;
+		best = distance;
+		index = id;
+	});
 	return index;
 }
 
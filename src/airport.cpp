@@ -133,14 +133,7 @@ AirportFTAClass::AirportFTAClass(
 
 AirportFTAClass::~AirportFTAClass()
 {
-	for (uint i = 0; i < nofelements; i++) {
-		AirportFTA *current = layout[i].next;
-		while (current != NULL) {
-			AirportFTA *next = current->next;
-			free(current);
-			current = next;
-		}
-	}
+	/* The extra movement choices live in the same allocation as the positions. */
 	free(layout);
 }
 
@@ -166,13 +159,21 @@ static uint16 AirportGetNofElements(const AirportFTAbuildup *apFA)
 
 /**
  * Construct the FTA given a description.
+ * The first \a nofelements entries of the returned array are the positions,
+ * the extra movement choices of each position follow them in the same array,
+ * so walking the choices of a position stays within a small block of memory.
  * @param nofelements The number of elements in the FTA.
  * @param apFA The description of the FTA.
  * @return The FTA describing the airport.
  */
 static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildup *apFA)
 {
-	AirportFTA *FAutomata = MallocT<AirportFTA>(nofelements);
+	uint nofnodes = 0;
+	while (apFA[nofnodes].position != MAX_ELEMENTS) nofnodes++;
+	assert(nofnodes >= nofelements);
+
+	AirportFTA *FAutomata = MallocT<AirportFTA>(nofnodes);
+	AirportFTA *extra = FAutomata + nofelements;
 	uint16 internalcounter = 0;
 
 	for (uint i = 0; i < nofelements; i++) {
@@ -184,7 +185,8 @@ static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildu
 
 		/* outgoing nodes from the same position, create linked list */
 		while (current->position == apFA[internalcounter + 1].position) {
-			AirportFTA *newNode = MallocT<AirportFTA>(1);
+			AirportFTA *newNode = extra++;
+			assert(newNode < FAutomata + nofnodes);
 
 			newNode->position      = apFA[internalcounter + 1].position;
 			newNode->heading       = apFA[internalcounter + 1].heading;
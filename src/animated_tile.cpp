@@ -15,22 +15,30 @@
 #include "tile_cmd.h"
 #include "viewport_func.h"
 #include "framerate_type.h"
+#include <unordered_map>
 
 #include "safeguards.h"
 
-/** The table/list with animated tiles. */
+/**
+ * The table/list with animated tiles. Deleting a tile leaves an #INVALID_TILE
+ * hole in its place, which is closed by the next #AnimateAnimatedTiles.
+ */
 SmallVector<TileIndex, 256> _animated_tiles;
 
+/** Position of every animated tile in #_animated_tiles. */
+static std::unordered_map<TileIndex, uint> _animated_tile_index;
+
 /**
  * Removes the given tile from the animated tile table.
  * @param tile the tile to remove
  */
 void DeleteAnimatedTile(TileIndex tile)
 {
-	TileIndex *to_remove = _animated_tiles.Find(tile);
-	if (to_remove != _animated_tiles.End()) {
+	std::unordered_map<TileIndex, uint>::iterator it = _animated_tile_index.find(tile);
+	if (it != _animated_tile_index.end()) {
 		/* The order of the remaining elements must stay the same, otherwise the animation loop may miss a tile. */
-		_animated_tiles.ErasePreservingOrder(to_remove);
+		_animated_tiles[it->second] = INVALID_TILE;
+		_animated_tile_index.erase(it);
 		MarkTileDirtyByTile(tile);
 	}
 }
@@ -43,7 +51,9 @@ void DeleteAnimatedTile(TileIndex tile)
 void AddAnimatedTile(TileIndex tile)
 {
 	MarkTileDirtyByTile(tile);
-	_animated_tiles.Include(tile);
+	if (_animated_tile_index.insert(std::make_pair(tile, _animated_tiles.Length())).second) {
+		*_animated_tiles.Append() = tile;
+	}
 }
 
 /**
@@ -53,21 +63,42 @@ void AnimateAnimatedTiles()
 {
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
 
-	const TileIndex *ti = _animated_tiles.Begin();
-	while (ti < _animated_tiles.End()) {
-		const TileIndex curr = *ti;
+	/* Close the holes of deleted tiles while walking the list. During the
+	 * AnimateTile call tiles may be deleted, which only leaves a hole, or
+	 * added, which appends them to the list so they are animated as well. */
+	uint keep = 0;
+	for (uint i = 0; i < _animated_tiles.Length(); i++) {
+		TileIndex curr = _animated_tiles[i];
+		if (curr == INVALID_TILE) continue;
+
 		AnimateTile(curr);
-		/* During the AnimateTile call, DeleteAnimatedTile could have been called,
-		 * deleting an element we've already processed and pushing the rest one
-		 * slot to the left. We can detect this by checking whether the index
-		 * in the current slot has changed - if it has, an element has been deleted,
-		 * and we should process the current slot again instead of going forward.
-		 * NOTE: this will still break if more than one animated tile is being
-		 *       deleted during the same AnimateTile call, but no code seems to
-		 *       be doing this anyway.
-		 */
-		if (*ti == curr) ++ti;
+		if (_animated_tiles[i] == INVALID_TILE) continue;
+
+		if (keep != i) {
+			_animated_tiles[keep] = curr;
+			_animated_tiles[i] = INVALID_TILE;
+			_animated_tile_index[curr] = keep;
+		}
+		keep++;
+	}
+	_animated_tiles.Resize(keep);
+}
+
+/**
+ * Rebuild the positions of the animated tiles after loading the table,
+ * dropping duplicate entries of old savegames.
+ */
+void RebuildAnimatedTileIndex()
+{
+	_animated_tile_index.clear();
+
+	uint keep = 0;
+	for (uint i = 0; i < _animated_tiles.Length(); i++) {
+		TileIndex tile = _animated_tiles[i];
+		if (tile == INVALID_TILE || !_animated_tile_index.insert(std::make_pair(tile, keep)).second) continue;
+		_animated_tiles[keep++] = tile;
 	}
+	_animated_tiles.Resize(keep);
 }
 
 /**
@@ -76,4 +107,5 @@ void AnimateAnimatedTiles()
 void InitializeAnimatedTiles()
 {
 	_animated_tiles.Clear();
+	_animated_tile_index.clear();
 }
@@ -18,5 +18,6 @@ void AddAnimatedTile(TileIndex tile);
 void DeleteAnimatedTile(TileIndex tile);
 void AnimateAnimatedTiles();
 void InitializeAnimatedTiles();
+void RebuildAnimatedTileIndex();
 
 #endif /* ANIMATED_TILE_FUNC_H */
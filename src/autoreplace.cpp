@@ -15,6 +15,9 @@
 #include "autoreplace_base.h"
 #include "core/pool_func.hpp"
 
+#include <map>
+#include <tuple>
+
 #include "safeguards.h"
 
 /** The pool of autoreplace "orders". */
@@ -36,6 +39,28 @@ static EngineRenew *GetEngineReplacement(EngineRenewList erl, EngineID engine, G
 	return NULL;
 }
 
+/** Key of #_engine_replacement_cache: the renewlist, the engine type and the group. */
+typedef std::tuple<EngineRenewList, EngineID, GroupID> EngineReplacementKey;
+
+/**
+ * Results of #EngineReplacement, as every wagon of every vehicle entering a
+ * depot asks for them (several times, while testing and executing the
+ * replacement) and each lookup walks the renewlist and the group hierarchy.
+ * It holds the replacement itself rather than its target, so changes to an
+ * existing replacement need no invalidation.
+ */
+static std::map<EngineReplacementKey, const EngineRenew *> _engine_replacement_cache;
+
+/**
+ * Forget all cached engine replacement lookups. Needed when a replacement is
+ * added or removed, and when the parent or the replace protection of a group
+ * changes.
+ */
+void InvalidateEngineReplacementCache()
+{
+	_engine_replacement_cache.clear();
+}
+
 /**
  * Remove all engine replacement settings for the company.
  * @param  erl The renewlist for a given company.
@@ -65,11 +90,17 @@ void RemoveAllEngineReplacement(EngineRenewList *erl)
  */
 EngineID EngineReplacement(EngineRenewList erl, EngineID engine, GroupID group, bool *replace_when_old)
 {
-	const EngineRenew *er = GetEngineReplacement(erl, engine, group);
-	if (er == NULL && (group == DEFAULT_GROUP || (Group::IsValidID(group) && !Group::Get(group)->replace_protection))) {
-		/* We didn't find anything useful in the vehicle's own group so we will try ALL_GROUP */
-		er = GetEngineReplacement(erl, engine, ALL_GROUP);
+	std::pair<std::map<EngineReplacementKey, const EngineRenew *>::iterator, bool> cached = _engine_replacement_cache.emplace(EngineReplacementKey(erl, engine, group), (const EngineRenew *)NULL);
+	if (cached.second) {
+		const EngineRenew *er = GetEngineReplacement(erl, engine, group);
+		if (er == NULL && (group == DEFAULT_GROUP || (Group::IsValidID(group) && !Group::Get(group)->replace_protection))) {
+			/* We didn't find anything useful in the vehicle's own group so we will try ALL_GROUP */
+			er = GetEngineReplacement(erl, engine, ALL_GROUP);
+		}
+		cached.first->second = er;
 	}
+
+	const EngineRenew *er = cached.first->second;
 	if (replace_when_old != NULL) *replace_when_old = er == NULL ? false : er->replace_when_old;
 	return er == NULL ? INVALID_ENGINE : er->to;
 }
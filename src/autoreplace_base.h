@@ -27,6 +27,8 @@ typedef uint16 EngineRenewID;
 typedef Pool<EngineRenew, EngineRenewID, 16, 64000> EngineRenewPool;
 extern EngineRenewPool _enginerenew_pool;
 
+void InvalidateEngineReplacementCache();
+
 /**
  * Struct to store engine replacements. DO NOT USE outside of engine.c. Is
  * placed here so the only exception to this rule, the saveload code, can use
@@ -39,8 +41,8 @@ struct EngineRenew : EngineRenewPool::PoolItem<&_enginerenew_pool> {
 	GroupID group_id;
 	bool replace_when_old; ///< Do replacement only when vehicle is old.
 
-	EngineRenew(EngineID from = INVALID_ENGINE, EngineID to = INVALID_ENGINE) : from(from), to(to) {}
-	~EngineRenew() {}
+	EngineRenew(EngineID from = INVALID_ENGINE, EngineID to = INVALID_ENGINE) : from(from), to(to) { InvalidateEngineReplacementCache(); }
+	~EngineRenew() { InvalidateEngineReplacementCache(); }
 };
 
 #define FOR_ALL_ENGINE_RENEWS_FROM(var, start) FOR_ALL_ITEMS_FROM(EngineRenew, enginerenew_index, var, start)
@@ -20,6 +20,7 @@
 #include "articulated_vehicles.h"
 #include "core/random_func.hpp"
 #include "vehiclelist.h"
+#include "core/name_registry_type.hpp"
 
 #include "table/strings.h"
 
@@ -369,7 +370,9 @@ static CommandCost CopyHeadSpecificThings(Vehicle *old_head, Vehicle *new_head,
 	/* Last do those things which do never fail (resp. we do not care about), but which are not undo-able */
 	if (cost.Succeeded() && old_head != new_head && (flags & DC_EXEC) != 0) {
 		/* Copy other things which cannot be copied by a command and which shall not stay resetted from the build vehicle command */
+		_vehicle_names.Remove(new_head->name);
 		new_head->CopyVehicleConfigAndStatistics(old_head);
+		_vehicle_names.Add(new_head->name);
 
 		/* Switch vehicle windows/news to the new vehicle, so they are not closed/deleted when the old vehicle is sold */
 		ChangeVehicleViewports(old_head->index, new_head->index);
@@ -0,0 +1,582 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark.cpp Microbenchmarks of core data structures and kernels on synthetic inputs. */
+
+#include "stdafx.h"
+#include "console_func.h"
+#include "console_type.h"
+#include "string_func.h"
+#include "strings_func.h"
+#include "core/random_func.hpp"
+#include "core/smallmap_type.hpp"
+#include "core/multimap.hpp"
+#include "core/kdtree.hpp"
+#include "core/pool_type.hpp"
+#include "core/pool_func.hpp"
+#include "misc/binaryheap.hpp"
+#include "misc/hashtable.hpp"
+#include "saveload/saveload.h"
+#include "blitter/factory.hpp"
+#include "landscape.h"
+#include "water_map.h"
+#include "pathfinder/water_regions.h"
+#include "table/strings.h"
+#include <chrono>
+
+#include "safeguards.h"
+
+/** Sink for the results of the benchmarks, so the compiler cannot optimise the work away. */
+static volatile uint64 _benchmark_sink;
+
+/** Clock used for timing the benchmarks. */
+typedef std::chrono::steady_clock BenchmarkClock;
+
+/**
+ * Print the time per operation of a benchmark.
+ * @param name  Name of the benchmark.
+ * @param start When the benchmark started.
+ * @param ops   Number of operations the benchmark did.
+ */
+static void PrintBenchmark(const char *name, BenchmarkClock::time_point start, uint64 ops)
+{
+	uint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchmarkClock::now() - start).count();
+	IConsolePrintF(CC_DEFAULT, "  %-36s %10.1f ns/op", name, (double)ns / max<uint64>(ops, 1));
+}
+
+/**
+ * Benchmark the small containers.
+ * @param n Number of operations per benchmark.
+ */
+static void BenchmarkContainers(uint n)
+{
+	Randomizer r;
+	r.SetSeed(1);
+	uint64 sum = 0;
+
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	SmallVector<uint32, 16> vec;
+	for (uint i = 0; i < n; i++) *vec.Append() = r.Next();
+	for (const uint32 *it = vec.Begin(); it != vec.End(); it++) sum += *it;
+	PrintBenchmark("SmallVector append + iterate", start, n);
+
+	/* SmallMap is a linear map, so keep it at the sizes it is used for. */
+	start = BenchmarkClock::now();
+	SmallMap<uint32, uint32> smap;
+	for (uint i = 0; i < n; i++) {
+		uint32 key = r.Next(64);
+		SmallPair<uint32, uint32> *pair = smap.Find(key);
+		if (pair == smap.End()) {
+			smap.Insert(key, i);
+		} else {
+			pair->second += i;
+		}
+	}
+	sum += smap.Length();
+	PrintBenchmark("SmallMap find/insert (64 keys)", start, n);
+
+	start = BenchmarkClock::now();
+	MultiMap<uint32, uint32> mmap;
+	for (uint i = 0; i < n; i++) mmap.Insert(r.Next(n / 4 + 1), i);
+	for (MultiMap<uint32, uint32>::iterator it = mmap.begin(); it != mmap.end(); ++it) sum += *it;
+	PrintBenchmark("MultiMap insert + iterate", start, n);
+
+	_benchmark_sink += sum;
+}
+
+/** Key of the nodes of the hash table benchmark. */
+struct BenchmarkKey {
+	uint32 value; ///< The key itself.
+
+	int CalcHash() const { return this->value * 0x9E3779B1U >> (32 - 12); }
+	bool operator ==(const BenchmarkKey &other) const { return this->value == other.value; }
+};
+
+/** Item for the hash table and heap benchmarks, shaped like a path finder node. */
+struct BenchmarkNode {
+	typedef BenchmarkKey Key;
+
+	Key key;                  ///< Key of the node.
+	int cost;                 ///< Sort key of the node.
+	uint heap_index;          ///< Position of the node in a CQuaternaryHeapT.
+	BenchmarkNode *hash_next; ///< Next node in the hash table slot.
+
+	const Key &GetKey() const { return this->key; }
+	BenchmarkNode *GetHashNext() { return this->hash_next; }
+	const BenchmarkNode *GetHashNext() const { return this->hash_next; }
+	void SetHashNext(BenchmarkNode *next) { this->hash_next = next; }
+
+	int GetCostEstimate() const { return this->cost; }
+	uint GetHeapIndex() const { return this->heap_index; }
+	void SetHeapIndex(uint index) { this->heap_index = index; }
+
+	bool operator <(const BenchmarkNode &other) const { return this->cost < other.cost; }
+};
+
+/**
+ * Benchmark the data structures of the YAPF path finder.
+ * @param n Number of operations per benchmark.
+ */
+static void BenchmarkPathfinderStructures(uint n)
+{
+	Randomizer r;
+	r.SetSeed(2);
+	uint64 sum = 0;
+
+	BenchmarkNode *nodes = CallocT<BenchmarkNode>(n);
+	for (uint i = 0; i < n; i++) {
+		nodes[i].key.value = i * 2654435761U;
+		nodes[i].cost = r.Next(1 << 20);
+	}
+
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	CHashTableT<BenchmarkNode, 12> *hash = new CHashTableT<BenchmarkNode, 12>();
+	for (uint i = 0; i < n; i++) hash->Push(nodes[i]);
+	for (uint i = 0; i < n; i++) sum += hash->Find(nodes[r.Next(n)].key)->cost;
+	for (uint i = 0; i < n; i++) hash->Pop(nodes[i]);
+	delete hash;
+	PrintBenchmark("CHashTableT push/find/pop", start, 3 * (uint64)n);
+
+	start = BenchmarkClock::now();
+	CBinaryHeapT<BenchmarkNode> bheap(n);
+	for (uint i = 0; i < n; i++) bheap.Include(&nodes[i]);
+	while (!bheap.IsEmpty()) sum += bheap.Shift()->cost;
+	PrintBenchmark("CBinaryHeapT include/shift", start, 2 * (uint64)n);
+
+	start = BenchmarkClock::now();
+	CQuaternaryHeapT<BenchmarkNode> qheap(16);
+	for (uint i = 0; i < n; i++) qheap.Include(&nodes[i]);
+	while (!qheap.IsEmpty()) sum += qheap.Shift()->cost;
+	PrintBenchmark("CQuaternaryHeapT include/shift", start, 2 * (uint64)n);
+
+	free(nodes);
+	_benchmark_sink += sum;
+}
+
+/** Extract the coordinates of a packed benchmark point for the k-d tree. */
+struct BenchmarkKdtreeXYFunc {
+	inline uint16 operator()(uint32 point, int dim) const { return dim == 0 ? GB(point, 0, 16) : GB(point, 16, 16); }
+};
+
+/**
+ * Benchmark the k-d tree with uniformly distributed points.
+ * @param n Number of operations per benchmark.
+ */
+static void BenchmarkKdtree(uint n)
+{
+	Randomizer r;
+	r.SetSeed(3);
+	uint64 sum = 0;
+
+	std::vector<uint32> points;
+	points.reserve(n);
+	for (uint i = 0; i < n; i++) points.push_back((r.Next(4096) << 16) | r.Next(4096));
+
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	Kdtree<uint32, BenchmarkKdtreeXYFunc, uint16, int> tree(BenchmarkKdtreeXYFunc(), points.begin(), points.end());
+	PrintBenchmark("Kdtree build", start, n);
+
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) sum += tree.FindNearest(r.Next(4096), r.Next(4096));
+	PrintBenchmark("Kdtree find nearest", start, n);
+
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) {
+		uint16 x = r.Next(4096 - 32);
+		uint16 y = r.Next(4096 - 32);
+		tree.FindContained(x, y, x + 32, y + 32, [&sum](uint32 point) { sum += point; });
+	}
+	PrintBenchmark("Kdtree find contained (32x32)", start, n);
+
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) tree.Remove(points[i]);
+	PrintBenchmark("Kdtree remove", start, n);
+
+	_benchmark_sink += sum;
+}
+
+struct BenchmarkItem;
+/** Pool for the pool allocator benchmark; not of any type that is cleaned with the game. */
+typedef Pool<BenchmarkItem, uint32, 64, 0x100000, PT_NONE> BenchmarkPool;
+static BenchmarkPool _benchmark_pool("Benchmark");
+
+/** Item of the pool allocator benchmark. */
+struct BenchmarkItem : BenchmarkPool::PoolItem<&_benchmark_pool> {
+	uint32 value; ///< Payload of the item.
+
+	BenchmarkItem(uint32 value) : value(value) {}
+};
+
+INSTANTIATE_POOL_METHODS(Benchmark)
+
+/**
+ * Benchmark allocating and freeing items of a pool, like vehicles being built and sold.
+ * @param n Number of operations per benchmark.
+ */
+static void BenchmarkPoolAllocator(uint n)
+{
+	Randomizer r;
+	r.SetSeed(4);
+	uint64 sum = 0;
+	uint items = min<uint>(n, BenchmarkPool::MAX_SIZE / 2);
+
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	for (uint i = 0; i < items; i++) new BenchmarkItem(i);
+	PrintBenchmark("Pool allocate", start, items);
+
+	/* Free and reallocate random items, so the allocator has to search for holes. */
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) {
+		BenchmarkItem *item = BenchmarkItem::GetIfValid(r.Next(items));
+		if (item != NULL) {
+			delete item;
+		} else {
+			new BenchmarkItem(i);
+		}
+	}
+	PrintBenchmark("Pool free/allocate random", start, n);
+
+	start = BenchmarkClock::now();
+	const BenchmarkItem *item;
+	FOR_ALL_ITEMS_FROM(BenchmarkItem, index, item, 0) sum += item->value;
+	PrintBenchmark("Pool iterate", start, items);
+
+	_benchmark_pool.CleanPool();
+	_benchmark_sink += sum;
+}
+
+/**
+ * Benchmark the savegame compression formats on map-like data.
+ * @param n Scale of the data to compress.
+ */
+static void BenchmarkSaveloadFilters(uint n)
+{
+	static const char * const formats[] = { "none", "lzo", "zlib", "zlibmt", "zstd", "lzma" };
+
+	/* Long runs of similar bytes with some noise, like the map arrays. */
+	Randomizer r;
+	r.SetSeed(5);
+	size_t len = n * 64;
+	byte *buf = MallocT<byte>(len);
+	byte value = 0;
+	for (size_t i = 0; i < len; i++) {
+		if (r.Next(16) == 0) value = r.Next(256);
+		buf[i] = value;
+	}
+
+	for (uint i = 0; i < lengthof(formats); i++) {
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		size_t compressed = CompressWithSavegameFormat(formats[i], buf, len);
+		if (compressed == 0) continue;
+
+		char name[64];
+		seprintf(name, lastof(name), "Save filter %s (%u%%)", formats[i], (uint)(compressed * 100 / len));
+		PrintBenchmark(name, start, len / 1024);
+		_benchmark_sink += compressed;
+	}
+	IConsolePrint(CC_DEFAULT, "  (save filters are timed per KiB)");
+
+	free(buf);
+}
+
+/** Allocator for the encoded sprites of the blitter benchmark. */
+static void *BenchmarkSpriteAllocate(size_t size)
+{
+	return MallocT<byte>(size);
+}
+
+/**
+ * Benchmark encoding and drawing a synthetic sprite with the blitters that do not need a screen.
+ * @param n Number of operations per benchmark.
+ */
+static void BenchmarkBlitters(uint n)
+{
+	static const char * const blitters[] = {
+		"8bpp-simple", "8bpp-optimized", "32bpp-simple", "32bpp-optimized", "32bpp-sse2", "32bpp-ssse3", "32bpp-sse4",
+	};
+	static const uint SPRITE_SIZE = 64;
+
+	Randomizer r;
+	r.SetSeed(6);
+
+	/* A roughly diamond shaped sprite like a tile, with transparent corners and some company colour. */
+	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
+	for (ZoomLevel zoom = ZOOM_LVL_BEGIN; zoom != ZOOM_LVL_END; zoom++) {
+		uint size = max(1U, (SPRITE_SIZE * 4) >> zoom);
+		sprite[zoom].width = size;
+		sprite[zoom].height = size;
+		sprite[zoom].x_offs = 0;
+		sprite[zoom].y_offs = 0;
+		sprite[zoom].type = ST_NORMAL;
+		sprite[zoom].data = CallocT<SpriteLoader::CommonPixel>(size * size);
+		for (uint y = 0; y < size; y++) {
+			for (uint x = 0; x < size; x++) {
+				SpriteLoader::CommonPixel *pixel = &sprite[zoom].data[y * size + x];
+				if (Delta(x * 2, size) + Delta(y * 2, size) > size) continue;
+				pixel->r = r.Next(256);
+				pixel->g = r.Next(256);
+				pixel->b = r.Next(256);
+				pixel->a = 0xFF;
+				pixel->m = r.Next(8) == 0 ? 0xC6 + r.Next(8) : r.Next(0xC0) + 1;
+			}
+		}
+	}
+
+	uint draws = max(1U, n / 64);
+	for (uint i = 0; i < lengthof(blitters); i++) {
+		BlitterFactory *factory = BlitterFactory::GetBlitterFactory(blitters[i]);
+		if (factory == NULL) continue;
+		Blitter *blitter = factory->CreateInstance();
+
+		char name[64];
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		::Sprite *encoded = NULL;
+		for (uint j = 0; j < draws; j++) {
+			free(encoded);
+			encoded = blitter->Encode(sprite, BenchmarkSpriteAllocate);
+		}
+		seprintf(name, lastof(name), "Encode %s", blitters[i]);
+		PrintBenchmark(name, start, draws);
+
+		/* Leave room around the sprite, as the vectorised blitters may touch a few pixels beyond it. */
+		int pitch = encoded->width + 16;
+		void *dst = CallocT<byte>(blitter->BufferSize(pitch, encoded->height + 1));
+
+		Blitter::BlitterParams bp;
+		bp.sprite = encoded->data;
+		bp.remap = NULL;
+		bp.skip_left = 0;
+		bp.skip_top = 0;
+		bp.width = encoded->width;
+		bp.height = encoded->height;
+		bp.sprite_width = encoded->width;
+		bp.sprite_height = encoded->height;
+		bp.left = 0;
+		bp.top = 0;
+		bp.dst = dst;
+		bp.pitch = pitch;
+
+		start = BenchmarkClock::now();
+		for (uint j = 0; j < draws; j++) blitter->Draw(&bp, BM_NORMAL, ZOOM_LVL_NORMAL);
+		seprintf(name, lastof(name), "Draw %s (%ux%u)", blitters[i], encoded->width, encoded->height);
+		PrintBenchmark(name, start, draws);
+
+		_benchmark_sink += *(byte *)dst;
+		free(dst);
+		free(encoded);
+		delete blitter;
+	}
+
+	for (ZoomLevel zoom = ZOOM_LVL_BEGIN; zoom != ZOOM_LVL_END; zoom++) free(sprite[zoom].data);
+}
+
+/**
+ * Benchmark formatting numbers and strings.
+ * @param n Number of operations per benchmark.
+ */
+static void BenchmarkStrings(uint n)
+{
+	Randomizer r;
+	r.SetSeed(7);
+	uint64 sum = 0;
+	char buf[256];
+
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) sum += seprintf(buf, lastof(buf), "%u: %s %d", r.Next(), "text", (int)r.Next(1000));
+	PrintBenchmark("seprintf", start, n);
+
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) {
+		SetDParam(0, (int64)r.Next() * r.Next(1000));
+		sum += GetString(buf, STR_JUST_CURRENCY_LONG, lastof(buf)) - buf;
+	}
+	PrintBenchmark("GetString currency", start, n);
+
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) {
+		SetDParam(0, r.Next(3650000));
+		sum += GetString(buf, STR_JUST_DATE_LONG, lastof(buf)) - buf;
+	}
+	PrintBenchmark("GetString date", start, n);
+
+	_benchmark_sink += sum;
+}
+
+/**
+ * Benchmark the height and slope queries on random tiles of the current map.
+ * @param n Number of operations per benchmark.
+ */
+static void BenchmarkLandscapeQueries(uint n)
+{
+	Randomizer r;
+	r.SetSeed(8);
+	uint64 sum = 0;
+
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) {
+		int z;
+		sum += GetTileSlope(r.Next(MapSize()), &z) + z;
+	}
+	PrintBenchmark("GetTileSlope", start, n);
+
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) sum += GetTileMaxZ(r.Next(MapSize()));
+	PrintBenchmark("GetTileMaxZ", start, n);
+
+	/* Vehicles query the height of their position in pixels, in small steps. */
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) {
+		uint x = r.Next(MapMaxX() * TILE_SIZE);
+		uint y = r.Next(MapMaxY() * TILE_SIZE);
+		for (uint step = 0; step < TILE_SIZE; step++) sum += GetSlopePixelZ(x + step, y);
+	}
+	PrintBenchmark("GetSlopePixelZ (per step)", start, (uint64)n * TILE_SIZE);
+
+	_benchmark_sink += sum;
+}
+
+static const uint MAP_BENCHMARK_BUF_SIZE = 4096; ///< Tiles copied per step of the map chunk benchmark, like the map chunk savers do.
+
+/**
+ * Copy one field of all tiles through a small buffer, like the map chunk savers do.
+ * @param buf Buffer of #MAP_BENCHMARK_BUF_SIZE entries.
+ * @param get Functor getting the field of a tile.
+ * @return Checksum of the copied values.
+ */
+template <typename Tget>
+static uint64 BenchmarkCopyMapField(uint16 *buf, Tget get)
+{
+	uint64 sum = 0;
+	TileIndex size = MapSize();
+	for (TileIndex t = 0; t < size;) {
+		uint count = min<uint>(MAP_BENCHMARK_BUF_SIZE, size - t);
+		for (uint j = 0; j < count; j++) buf[j] = get(t++);
+		sum += buf[count - 1];
+	}
+	return sum;
+}
+
+/**
+ * Benchmark the passes over the map arrays of the current map, to compare the
+ * array-of-structs and structure-of-arrays map layouts between two builds.
+ * @param n Number of operations of the random access benchmark.
+ */
+static void BenchmarkMapLayout(uint n)
+{
+	Randomizer r;
+	r.SetSeed(9);
+	uint64 sum = 0;
+	TileIndex size = MapSize();
+
+#ifdef WITH_SOA_MAP
+	IConsolePrintF(CC_DEFAULT, "  (map layout: structure of arrays, %u tiles)", size);
+#else
+	IConsolePrintF(CC_DEFAULT, "  (map layout: array of structs, %u tiles)", size);
+#endif /* WITH_SOA_MAP */
+
+	/* The smallmap and similar passes only look at the type and height of each tile. */
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	for (TileIndex t = 0; t < size; t++) sum += _m[t].type + _m[t].height;
+	PrintBenchmark("Map scan type + height (per tile)", start, size);
+
+	/* The tile loop visits the tiles out of order and mostly reads the type, owner and m5. */
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < n; i++) {
+		TileIndex t = r.Next(size);
+		sum += _m[t].type + _m[t].m1 + _m[t].m5;
+	}
+	PrintBenchmark("Map random access type + m1 + m5", start, n);
+
+	/* The map chunks are saved one field at a time. */
+	uint16 *buf = MallocT<uint16>(MAP_BENCHMARK_BUF_SIZE);
+	start = BenchmarkClock::now();
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _m[t].type; });
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _m[t].height; });
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _m[t].m1; });
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _m[t].m2; });
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _m[t].m3; });
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _m[t].m4; });
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _m[t].m5; });
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _me[t].m6; });
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _me[t].m7; });
+	sum += BenchmarkCopyMapField(buf, [](TileIndex t) { return _me[t].m8; });
+	PrintBenchmark("Map chunk copy, all fields (per tile)", start, size);
+	free(buf);
+
+	_benchmark_sink += sum;
+}
+
+/**
+ * Benchmark the coarse water region search between random water tiles of the
+ * current map; it is only meaningful on maps with large oceans.
+ * @param n Scale of the benchmark; one search is done per 4096 operations.
+ */
+static void BenchmarkWaterRegions(uint n)
+{
+	Randomizer r;
+	r.SetSeed(10);
+	uint64 sum = 0;
+
+	/* Pick the end points like ships crossing the sea; the sampling stops when there is hardly any water. */
+	std::vector<TileIndex> tiles;
+	uint searches = max(16U, n >> 12);
+	for (uint tries = 0; tiles.size() < 2 * searches && tries < 64 * searches; tries++) {
+		TileIndex t = r.Next(MapSize());
+		if (IsTileType(t, MP_WATER) && IsWater(t)) tiles.push_back(t);
+	}
+	if (tiles.size() < 2 * searches) {
+		IConsolePrint(CC_DEFAULT, "  (not enough water on this map for the water region benchmark)");
+		return;
+	}
+
+	/* Dropping the network only costs rebuilding it; it is no part of the game state. */
+	InvalidateAllWaterRegions();
+	RegionCorridor corridor;
+	uint found = 0;
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+	for (uint i = 0; i < searches; i++) {
+		if (FindWaterRegionCorridor(tiles[2 * i], tiles[2 * i + 1], corridor)) found++;
+	}
+	char name[64];
+	seprintf(name, lastof(name), "Water region search, cold (%u%% found)", found * 100 / searches);
+	PrintBenchmark(name, start, searches);
+
+	start = BenchmarkClock::now();
+	for (uint i = 0; i < searches; i++) {
+		if (FindWaterRegionCorridor(tiles[2 * i], tiles[2 * i + 1], corridor)) sum += corridor.size();
+	}
+	PrintBenchmark("Water region search, built regions", start, searches);
+
+	_benchmark_sink += sum;
+}
+
+/**
+ * Run all microbenchmarks and print their time per operation to the console.
+ * The inputs are synthetic and generated with a fixed seed, so runs of different builds can be compared.
+ * None of the benchmarks change the game state; the landscape queries, map passes and water region
+ * searches use the current map.
+ * @param scale Multiplier for the number of operations of each benchmark.
+ */
+void RunMicrobenchmarks(uint scale)
+{
+	uint n = (1 << 16) * Clamp(scale, 1U, 64U);
+
+	IConsolePrintF(CC_INFO, "Running microbenchmarks with %u operations:", n);
+	BenchmarkContainers(n);
+	BenchmarkPathfinderStructures(n);
+	BenchmarkKdtree(n);
+	BenchmarkPoolAllocator(n);
+	BenchmarkSaveloadFilters(n);
+	BenchmarkBlitters(n);
+	BenchmarkStrings(n);
+	BenchmarkLandscapeQueries(n);
+	BenchmarkMapLayout(n);
+	BenchmarkWaterRegions(n);
+	IConsolePrintF(CC_DEFAULT, "Checksum: " OTTD_PRINTF64, (uint64)_benchmark_sink);
+}
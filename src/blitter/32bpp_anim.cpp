@@ -11,6 +11,7 @@
 
 #include "../stdafx.h"
 #include "../video/video_driver.hpp"
+#include "../thread/thread_pool.h"
 #include "32bpp_anim.hpp"
 #include "common.hpp"
 
@@ -24,6 +25,7 @@ static FBlitter_32bppAnim iFBlitter_32bppAnim;
 Blitter_32bppAnim::~Blitter_32bppAnim()
 {
 	free(this->anim_alloc);
+	free(this->anim_lines);
 }
 
 template <BlitterMode mode>
@@ -261,6 +263,9 @@ void Blitter_32bppAnim::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomL
 		return;
 	}
 
+	/* Drawing transparent only clears the animation buffer. */
+	if (mode != BM_TRANSPARENT) this->MarkAnimatedLines(this->ScreenToLine((uint32 *)bp->dst + bp->top * bp->pitch), bp->height);
+
 	switch (mode) {
 		default: NOT_REACHED();
 		case BM_NORMAL:       Draw<BM_NORMAL>      (bp, zoom); return;
@@ -319,6 +324,7 @@ void Blitter_32bppAnim::SetPixel(void *video, int x, int y, uint8 colour)
 	/* Set the colour in the anim-buffer too, if we are rendering to the screen */
 	if (_screen_disable_anim) return;
 
+	if (colour >= PALETTE_ANIM_START) this->MarkAnimatedLines(this->ScreenToLine(video) + y, 1);
 	this->anim_buf[this->ScreenToAnimOffset((uint32 *)video) + x + y * this->anim_buf_pitch] = colour | (DEFAULT_BRIGHTNESS << 8);
 }
 
@@ -331,6 +337,12 @@ void Blitter_32bppAnim::DrawLine(void *video, int x, int y, int x2, int y2, int
 			*((Colour *)video + x + y * _screen.pitch) = c;
 		});
 	} else {
+		if (colour >= PALETTE_ANIM_START) {
+			/* Wide lines extend at most their width beyond their end points. */
+			int top = this->ScreenToLine(video);
+			this->MarkAnimatedLines(top + min(y, y2) - width, abs(y2 - y) + 2 * width + 1);
+		}
+
 		uint16 * const offset_anim_buf = this->anim_buf + this->ScreenToAnimOffset((uint32 *)video);
 		const uint16 anim_colour = colour | (DEFAULT_BRIGHTNESS << 8);
 		this->DrawLineGeneric(x, y, x2, y2, screen_width, screen_height, width, dash, [&](int x, int y) {
@@ -348,6 +360,8 @@ void Blitter_32bppAnim::DrawRect(void *video, int width, int height, uint8 colou
 		return;
 	}
 
+	if (colour >= PALETTE_ANIM_START) this->MarkAnimatedLines(this->ScreenToLine(video), height);
+
 	Colour colour32 = LookupColourInPalette(colour);
 	uint16 *anim_line = this->ScreenToAnimOffset((uint32 *)video) + this->anim_buf;
 
@@ -375,6 +389,8 @@ void Blitter_32bppAnim::CopyFromBuffer(void *video, const void *src, int width,
 	const uint32 *usrc = (const uint32 *)src;
 	uint16 *anim_line = this->ScreenToAnimOffset((uint32 *)video) + this->anim_buf;
 
+	this->MarkAnimatedLines(this->ScreenToLine(video), height);
+
 	for (; height > 0; height--) {
 		/* We need to keep those for palette animation. */
 		Colour *dst_pal = dst;
@@ -435,6 +451,9 @@ void Blitter_32bppAnim::ScrollBuffer(void *video, int &left, int &top, int &widt
 	assert(video >= _screen.dst_ptr && video <= (uint32 *)_screen.dst_ptr + _screen.width + _screen.height * _screen.pitch);
 	uint16 *dst, *src;
 
+	/* Animated pixels may move to any line of the scrolled area. */
+	this->MarkAnimatedLines(top, height);
+
 	/* We need to scroll the anim-buffer too */
 	if (scroll_y > 0) {
 		dst = this->anim_buf + left + (top + height - 1) * this->anim_buf_pitch;
@@ -485,6 +504,58 @@ int Blitter_32bppAnim::BufferSize(int width, int height)
 	return width * height * (sizeof(uint32) + sizeof(uint16));
 }
 
+/**
+ * Update the palette animated pixels of one line of the screen.
+ * @param dst  The first pixel of the line on the screen.
+ * @param anim The first pixel of the line in the animation buffer.
+ * @return Whether the line contains palette animated pixels.
+ */
+bool Blitter_32bppAnim::PaletteAnimateLine(Colour *dst, const uint16 *anim)
+{
+	bool animated = false;
+	for (int x = this->anim_buf_width; x != 0 ; x--) {
+		uint16 value = *anim;
+		uint8 colour = GB(value, 0, 8);
+		if (colour >= PALETTE_ANIM_START) {
+			/* Update this pixel */
+			*dst = this->AdjustBrightness(LookupColourInPalette(colour), GB(value, 8, 8));
+			animated = true;
+		}
+		dst++;
+		anim++;
+	}
+	return animated;
+}
+
+/**
+ * Update the palette animated pixels of a range of lines of the screen.
+ * Lines that had no animated pixels last time and have not been drawn
+ * on since are skipped.
+ * @param first The first line.
+ * @param last  One past the last line.
+ */
+void Blitter_32bppAnim::PaletteAnimateLines(uint first, uint last)
+{
+	for (uint y = first; y < last; y++) {
+		if (!this->anim_lines[y]) continue;
+		this->anim_lines[y] = this->PaletteAnimateLine((Colour *)_screen.dst_ptr + y * _screen.pitch, this->anim_buf + y * this->anim_buf_pitch);
+	}
+}
+
+/**
+ * Thread pool procedure to palette animate a range of lines.
+ * @param data  The blitter.
+ * @param first The first line.
+ * @param last  One past the last line.
+ */
+/* static */ void Blitter_32bppAnim::PaletteAnimateProc(void *data, uint first, uint last)
+{
+	static_cast<Blitter_32bppAnim *>(data)->PaletteAnimateLines(first, last);
+}
+
+/** Number of lines a thread palette animates at once. */
+static const uint PALETTE_ANIMATE_CHUNK_SIZE = 64;
+
 void Blitter_32bppAnim::PaletteAnimate(const Palette &palette)
 {
 	assert(!_screen_disable_anim);
@@ -495,30 +566,20 @@ void Blitter_32bppAnim::PaletteAnimate(const Palette &palette)
 	 *  Especially when going between toyland and non-toyland. */
 	assert(this->palette.first_dirty == PALETTE_ANIM_START || this->palette.first_dirty == 0);
 
-	const uint16 *anim = this->anim_buf;
-	Colour *dst = (Colour *)_screen.dst_ptr;
-
-	/* Let's walk the anim buffer and try to find the pixels */
-	const int width = this->anim_buf_width;
-	const int pitch_offset = _screen.pitch - width;
-	const int anim_pitch_offset = this->anim_buf_pitch - width;
-	for (int y = this->anim_buf_height; y != 0 ; y--) {
-		for (int x = width; x != 0 ; x--) {
-			uint16 value = *anim;
-			uint8 colour = GB(value, 0, 8);
-			if (colour >= PALETTE_ANIM_START) {
-				/* Update this pixel */
-				*dst = this->AdjustBrightness(LookupColourInPalette(colour), GB(value, 8, 8));
-			}
-			dst++;
-			anim++;
+	/* The lines are independent, and only the palette and the buffers are read. */
+	ThreadPoolParallelFor(&Blitter_32bppAnim::PaletteAnimateProc, this, this->anim_buf_height, PALETTE_ANIMATE_CHUNK_SIZE);
+
+	/* Make sure the backend presents the runs of lines with animated pixels; the rest did not change. */
+	int y = 0;
+	while (y < this->anim_buf_height) {
+		if (!this->anim_lines[y]) {
+			y++;
+			continue;
 		}
-		dst += pitch_offset;
-		anim += anim_pitch_offset;
+		int top = y;
+		while (y < this->anim_buf_height && this->anim_lines[y]) y++;
+		VideoDriver::GetInstance()->MakeDirty(0, top, _screen.width, y - top);
 	}
-
-	/* Make sure the backend redraws the whole screen */
-	VideoDriver::GetInstance()->MakeDirty(0, 0, _screen.width, _screen.height);
 }
 
 Blitter::PaletteAnimation Blitter_32bppAnim::UsePaletteAnimation()
@@ -539,5 +600,12 @@ void Blitter_32bppAnim::PostResize()
 
 		/* align buffer to next 16 byte boundary */
 		this->anim_buf = reinterpret_cast<uint16 *>((reinterpret_cast<uintptr_t>(this->anim_alloc) + 0xF) & (~0xF));
+
+		/* The new buffer has no animated pixels. */
+		free(this->anim_lines);
+		this->anim_lines = CallocT<bool>(this->anim_buf_height);
 	}
+
+	/* Start the workers for PaletteAnimate from the main thread; video drivers may animate from their drawing thread. */
+	InitThreadPool();
 }
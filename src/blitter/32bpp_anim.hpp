@@ -13,6 +13,7 @@
 #define BLITTER_32BPP_ANIM_HPP
 
 #include "32bpp_optimized.hpp"
+#include "../core/mem_func.hpp"
 
 /** The optimised 32 bpp blitter with palette animation. */
 class Blitter_32bppAnim : public Blitter_32bppOptimized {
@@ -22,15 +23,44 @@ protected:
 	int anim_buf_width;  ///< The width of the animation buffer.
 	int anim_buf_height; ///< The height of the animation buffer.
 	int anim_buf_pitch;  ///< The pitch of the animation buffer (width rounded up to 16 byte boundary).
+	bool *anim_lines;    ///< For every line of the animation buffer whether it may contain palette animated pixels.
 	Palette palette;     ///< The current palette.
 
+	/**
+	 * Get the line of the screen a pointer into the screen buffer points to.
+	 * @param video Pointer into the screen buffer.
+	 * @return The line.
+	 */
+	inline int ScreenToLine(const void *video)
+	{
+		return (int)((const uint32 *)video - (const uint32 *)_screen.dst_ptr) / _screen.pitch;
+	}
+
+	/**
+	 * Mark lines of the animation buffer as possibly containing palette
+	 * animated pixels, so the next #PaletteAnimate looks at them.
+	 * @param top    The first line; lines outside of the buffer are ignored.
+	 * @param height The number of lines.
+	 */
+	inline void MarkAnimatedLines(int top, int height)
+	{
+		int first = max(top, 0);
+		int last = min(top + height, this->anim_buf_height);
+		if (first < last) MemSetT(this->anim_lines + first, true, last - first);
+	}
+
+	virtual bool PaletteAnimateLine(Colour *dst, const uint16 *anim);
+	void PaletteAnimateLines(uint first, uint last);
+	static void PaletteAnimateProc(void *data, uint first, uint last);
+
 public:
 	Blitter_32bppAnim() :
 		anim_buf(NULL),
 		anim_alloc(NULL),
 		anim_buf_width(0),
 		anim_buf_height(0),
-		anim_buf_pitch(0)
+		anim_buf_pitch(0),
+		anim_lines(NULL)
 	{
 		this->palette = _cur_palette;
 	}
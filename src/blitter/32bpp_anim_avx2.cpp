@@ -0,0 +1,69 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_anim_avx2.cpp Implementation of the AVX2 32 bpp blitter with animation support. */
+
+#ifdef WITH_SSE
+
+#include "../stdafx.h"
+#include "../video/video_driver.hpp"
+#include "32bpp_anim_avx2.hpp"
+#include "32bpp_avx2_func.hpp"
+
+#include "../safeguards.h"
+
+/** Instantiation of the AVX2 32bpp blitter factory. */
+static FBlitter_32bppAVX2_Anim iFBlitter_32bppAVX2_Anim;
+
+/**
+ * Draws a sprite to a (screen) buffer. Calls adequate templated function.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void Blitter_32bppAVX2_Anim::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	const Blitter_32bppSSE_Base::SpriteFlags sprite_flags = ((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags;
+	uint16 *anim_line = this->anim_buf + this->ScreenToAnimOffset((uint32 *)bp->dst) + bp->top * this->anim_buf_pitch + bp->left;
+	switch (mode) {
+		case BM_COLOUR_REMAP:
+			if (!(sprite_flags & SF_NO_REMAP)) break;
+			FALLTHROUGH;
+
+		case BM_NORMAL:
+			/* Palette animated pixels need to be written to the animation buffer. */
+			if (!(sprite_flags & SF_NO_ANIM)) break;
+
+			if (bp->skip_left != 0 || bp->width <= MARGIN_NORMAL_THRESHOLD) {
+				if (sprite_flags & SF_TRANSLUCENT) {
+					DrawAVX2<BM_NORMAL, RM_WITH_SKIP, true>(bp, zoom, anim_line, this->anim_buf_pitch);
+				} else {
+					DrawAVX2<BM_NORMAL, RM_WITH_SKIP, false>(bp, zoom, anim_line, this->anim_buf_pitch);
+				}
+			} else {
+				if (sprite_flags & SF_TRANSLUCENT) {
+					DrawAVX2<BM_NORMAL, RM_WITH_MARGIN, true>(bp, zoom, anim_line, this->anim_buf_pitch);
+				} else {
+					DrawAVX2<BM_NORMAL, RM_WITH_MARGIN, false>(bp, zoom, anim_line, this->anim_buf_pitch);
+				}
+			}
+			return;
+
+		case BM_TRANSPARENT:
+			DrawAVX2<BM_TRANSPARENT, RM_NONE, true>(bp, zoom, anim_line, this->anim_buf_pitch);
+			return;
+
+		default: break;
+	}
+
+	Blitter_32bppSSE4_Anim::Draw(bp, mode, zoom);
+}
+
+#endif /* WITH_SSE */
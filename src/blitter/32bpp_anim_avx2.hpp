@@ -0,0 +1,39 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_anim_avx2.hpp An AVX2 32 bpp blitter with animation support. */
+
+#ifndef BLITTER_32BPP_AVX2_ANIM_HPP
+#define BLITTER_32BPP_AVX2_ANIM_HPP
+
+#ifdef WITH_SSE
+
+#include "32bpp_anim_sse4.hpp"
+
+/**
+ * The AVX2 32 bpp blitter with palette animation. It draws eight pixels at
+ * once for sprites without palette animated pixels in the modes that do not
+ * need the map values of the sprite; the other sprites and modes are drawn
+ * by the SSE4 blitter.
+ */
+class Blitter_32bppAVX2_Anim FINAL : public Blitter_32bppSSE4_Anim {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+	/* virtual */ const char *GetName() { return "32bpp-avx2-anim"; }
+};
+
+/** Factory for the AVX2 32 bpp blitter (with palette animation). */
+class FBlitter_32bppAVX2_Anim: public BlitterFactory {
+public:
+	FBlitter_32bppAVX2_Anim() : BlitterFactory("32bpp-avx2-anim", "AVX2 Blitter (palette animation)", HasCPUIDFlag(7, 1, 5) && HasOSAVXSupport()) {}
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppAVX2_Anim(); }
+};
+
+#endif /* WITH_SSE */
+#endif /* BLITTER_32BPP_AVX2_ANIM_HPP */
@@ -27,8 +27,10 @@
 
 /** A partially 32 bpp blitter with palette animation. */
 class Blitter_32bppSSE2_Anim : public Blitter_32bppAnim {
+protected:
+	/* virtual */ bool PaletteAnimateLine(Colour *dst, const uint16 *anim);
+
 public:
-	/* virtual */ void PaletteAnimate(const Palette &palette);
 	/* virtual */ const char *GetName() { return "32bpp-sse2-anim"; }
 };
 
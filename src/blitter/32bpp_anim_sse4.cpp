@@ -368,6 +368,11 @@ IGNORE_UNINITIALIZED_WARNING_STOP
 void Blitter_32bppSSE4_Anim::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
 {
 	const Blitter_32bppSSE_Base::SpriteFlags sprite_flags = ((const Blitter_32bppSSE_Base::SpriteData *) bp->sprite)->flags;
+
+	/* Drawing transparent or sprites without animated pixels only clears the animation buffer. */
+	bool clears_anim = mode == BM_TRANSPARENT || ((mode == BM_NORMAL || mode == BM_COLOUR_REMAP) && (sprite_flags & SF_NO_ANIM));
+	if (!clears_anim) this->MarkAnimatedLines(this->ScreenToLine((uint32 *)bp->dst + bp->top * bp->pitch), bp->height);
+
 	switch (mode) {
 		default: {
 bm_normal:
@@ -0,0 +1,65 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2.cpp Implementation of the AVX2 32 bpp blitter. */
+
+#ifdef WITH_SSE
+
+#include "../stdafx.h"
+#include "../zoom_func.h"
+#include "32bpp_avx2.hpp"
+#include "32bpp_avx2_func.hpp"
+
+#include "../safeguards.h"
+
+/** Instantiation of the AVX2 32bpp blitter factory. */
+static FBlitter_32bppAVX2 iFBlitter_32bppAVX2;
+
+/**
+ * Draws a sprite to a (screen) buffer. Calls adequate templated function.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void Blitter_32bppAVX2::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	const SpriteFlags sprite_flags = ((const SpriteData *) bp->sprite)->flags;
+	switch (mode) {
+		case BM_COLOUR_REMAP:
+			if (!(sprite_flags & SF_NO_REMAP)) break;
+			FALLTHROUGH;
+
+		case BM_NORMAL:
+			if (bp->skip_left != 0 || bp->width <= MARGIN_NORMAL_THRESHOLD) {
+				if (sprite_flags & SF_TRANSLUCENT) {
+					DrawAVX2<BM_NORMAL, RM_WITH_SKIP, true>(bp, zoom, NULL, 0);
+				} else {
+					DrawAVX2<BM_NORMAL, RM_WITH_SKIP, false>(bp, zoom, NULL, 0);
+				}
+			} else {
+				if (sprite_flags & SF_TRANSLUCENT) {
+					DrawAVX2<BM_NORMAL, RM_WITH_MARGIN, true>(bp, zoom, NULL, 0);
+				} else {
+					DrawAVX2<BM_NORMAL, RM_WITH_MARGIN, false>(bp, zoom, NULL, 0);
+				}
+			}
+			return;
+
+		case BM_TRANSPARENT:
+			DrawAVX2<BM_TRANSPARENT, RM_NONE, true>(bp, zoom, NULL, 0);
+			return;
+
+		default: break;
+	}
+
+	Blitter_32bppSSE4::Draw(bp, mode, zoom);
+}
+
+#endif /* WITH_SSE */
@@ -0,0 +1,187 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2_func.hpp Functions related to AVX2 32 bpp blitter. */
+
+#ifndef BLITTER_32BPP_AVX2_FUNC_HPP
+#define BLITTER_32BPP_AVX2_FUNC_HPP
+
+#ifdef WITH_SSE
+
+#include <immintrin.h>
+
+#define ALPHA_CONTROL_MASK_256 _mm256_setr_epi8(6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1, 6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1)
+
+/**
+ * Get the mask selecting the first pixels of a block of eight.
+ * @param count Number of pixels to select, less than eight.
+ * @return The mask.
+ */
+static inline __m256i TailMask(int count)
+{
+	return _mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+/**
+ * Load eight pixels, or fewer at the end of a line. Pixels past the end are not read.
+ * @param src The pixels.
+ * @param count Number of pixels left in the line.
+ * @return The pixels; the ones past the end are zero.
+ */
+static inline __m256i LoadEightPixels(const Colour *src, int count)
+{
+	if (count >= 8) return _mm256_loadu_si256((const __m256i *) src);
+	return _mm256_maskload_epi32((const int *) src, TailMask(count));
+}
+
+/**
+ * Store eight pixels, or fewer at the end of a line. Pixels past the end are not written.
+ * @param dst Where to store the pixels.
+ * @param pixels The pixels.
+ * @param count Number of pixels left in the line.
+ */
+static inline void StoreEightPixels(Colour *dst, __m256i pixels, int count)
+{
+	if (count >= 8) {
+		_mm256_storeu_si256((__m256i *) dst, pixels);
+	} else {
+		_mm256_maskstore_epi32((int *) dst, TailMask(count), pixels);
+	}
+}
+
+/**
+ * Alpha blend eight pixels; the same calculation as AlphaBlendTwoPixels().
+ * @param src The pixels to draw.
+ * @param dst The pixels to draw on.
+ * @param distribution_mask #ALPHA_CONTROL_MASK_256.
+ * @return The blended pixels.
+ */
+static inline __m256i AlphaBlendEightPixels(__m256i src, __m256i dst, const __m256i &distribution_mask)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i low_bytes = _mm256_set1_epi16(0xFF);
+	/* The unpacks work per 128 bit lane: the low halves get pixels 0, 1, 4 and 5; the high ones 2, 3, 6 and 7. Packing restores the order. */
+	__m256i src_lo = _mm256_unpacklo_epi8(src, zero);
+	__m256i src_hi = _mm256_unpackhi_epi8(src, zero);
+	__m256i dst_lo = _mm256_unpacklo_epi8(dst, zero);
+	__m256i dst_hi = _mm256_unpackhi_epi8(dst, zero);
+
+	__m256i alpha_lo = _mm256_add_epi16(_mm256_srli_epi16(_mm256_cmpgt_epi16(src_lo, zero), 15), src_lo); // if (alpha > 0) a++;
+	__m256i alpha_hi = _mm256_add_epi16(_mm256_srli_epi16(_mm256_cmpgt_epi16(src_hi, zero), 15), src_hi);
+	alpha_lo = _mm256_shuffle_epi8(alpha_lo, distribution_mask);
+	alpha_hi = _mm256_shuffle_epi8(alpha_hi, distribution_mask);
+
+	src_lo = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(src_lo, dst_lo), alpha_lo), 8), dst_lo); // a*(r - Cr)/256 + Cr
+	src_hi = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(src_hi, dst_hi), alpha_hi), 8), dst_hi);
+	/* Like PACK_LOW_CONTROL_MASK, clear the alpha of the result. */
+	return _mm256_and_si256(_mm256_packus_epi16(_mm256_and_si256(src_lo, low_bytes), _mm256_and_si256(src_hi, low_bytes)), _mm256_set1_epi32(0x00FFFFFF));
+}
+
+/**
+ * Darken eight pixels; the same calculation as DarkenTwoPixels().
+ * @param src The pixels whose alpha gives the amount of darkening.
+ * @param dst The pixels to darken.
+ * @param distribution_mask #ALPHA_CONTROL_MASK_256.
+ * @return The darkened pixels.
+ */
+static inline __m256i DarkenEightPixels(__m256i src, __m256i dst, const __m256i &distribution_mask)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i tr_nom_base = _mm256_set1_epi16(256);
+	__m256i alpha_lo = _mm256_srli_epi16(_mm256_shuffle_epi8(_mm256_unpacklo_epi8(src, zero), distribution_mask), 2);
+	__m256i alpha_hi = _mm256_srli_epi16(_mm256_shuffle_epi8(_mm256_unpackhi_epi8(src, zero), distribution_mask), 2);
+	__m256i dst_lo = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), _mm256_sub_epi16(tr_nom_base, alpha_lo)), 8);
+	__m256i dst_hi = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), _mm256_sub_epi16(tr_nom_base, alpha_hi)), 8);
+	return _mm256_packus_epi16(dst_lo, dst_hi);
+}
+
+/**
+ * Draws a sprite to a (screen) buffer, eight pixels at once. Only handles the
+ * modes that do not need to look at the map values of the sprite.
+ *
+ * @tparam mode blitter mode, #BM_NORMAL or #BM_TRANSPARENT
+ * @tparam read_mode how to find the pixels to draw in a line
+ * @tparam translucent whether the sprite has pixels that are neither fully opaque nor fully transparent
+ * @param bp further blitting parameters
+ * @param zoom zoom level at which we are drawing
+ * @param anim_line the animation buffer at the first pixel to draw, or NULL if there is none; pixels drawn over are cleared in it
+ * @param anim_pitch the pitch of the animation buffer
+ */
+template <BlitterMode mode, Blitter_32bppSSE_Base::ReadMode read_mode, bool translucent>
+static inline void DrawAVX2(const Blitter::BlitterParams *bp, ZoomLevel zoom, uint16 *anim_line, int anim_pitch)
+{
+	Colour *dst_line = (Colour *) bp->dst + bp->top * bp->pitch + bp->left;
+	int effective_width = bp->width;
+
+	/* Find where to start reading in the source sprite. */
+	const Blitter_32bppSSE_Base::SpriteData * const sd = (const Blitter_32bppSSE_Base::SpriteData *) bp->sprite;
+	const Blitter_32bppSSE_Base::SpriteInfo * const si = &sd->infos[zoom];
+	const Colour *src_rgba_line = (const Colour *) ((const byte *) &sd->data[si->sprite_offset] + bp->skip_top * si->sprite_line_size);
+	if (read_mode != Blitter_32bppSSE_Base::RM_WITH_MARGIN) src_rgba_line += bp->skip_left;
+
+	const __m256i a_cm = ALPHA_CONTROL_MASK_256;
+	const __m256i zero = _mm256_setzero_si256();
+
+	for (int y = bp->height; y != 0; y--) {
+		Colour *dst = dst_line;
+		const Colour *src = src_rgba_line + META_LENGTH;
+		uint16 *anim = anim_line;
+
+		if (read_mode == Blitter_32bppSSE_Base::RM_WITH_MARGIN) {
+			src += src_rgba_line[0].data;
+			dst += src_rgba_line[0].data;
+			if (anim != NULL) anim += src_rgba_line[0].data;
+			const int width_diff = si->sprite_width - bp->width;
+			effective_width = bp->width - (int) src_rgba_line[0].data;
+			const int delta_diff = (int) src_rgba_line[1].data - width_diff;
+			const int new_width = effective_width - delta_diff;
+			effective_width = delta_diff > 0 ? new_width : effective_width;
+			if (effective_width <= 0) goto next_line;
+		}
+
+		for (int x = effective_width; x > 0; x -= 8) {
+			__m256i srcABCD = LoadEightPixels(src, x);
+			__m256i dstABCD = LoadEightPixels(dst, x);
+			/* All ones for the pixels that are fully transparent. */
+			const __m256i transparent = _mm256_cmpeq_epi32(_mm256_srli_epi32(srcABCD, 24), zero);
+
+			if (mode == BM_TRANSPARENT) {
+				dstABCD = DarkenEightPixels(srcABCD, dstABCD, a_cm);
+			} else if (translucent) {
+				dstABCD = AlphaBlendEightPixels(srcABCD, dstABCD, a_cm);
+			} else {
+				dstABCD = _mm256_blendv_epi8(srcABCD, dstABCD, transparent);
+			}
+			StoreEightPixels(dst, dstABCD, x);
+
+			if (anim != NULL) {
+				if (x >= 8) {
+					/* Narrow the mask to 16 bits per pixel; packing works per lane, so gather the two lanes afterwards. */
+					__m256i keep = _mm256_permute4x64_epi64(_mm256_packs_epi32(transparent, transparent), 0x08);
+					_mm_storeu_si128((__m128i *) anim, _mm_and_si128(_mm_loadu_si128((const __m128i *) anim), _mm256_castsi256_si128(keep)));
+				} else {
+					for (int i = 0; i < x; i++) {
+						if (src[i].a != 0) anim[i] = 0;
+					}
+				}
+				anim += 8;
+			}
+			src += 8;
+			dst += 8;
+		}
+
+next_line:
+		src_rgba_line = (const Colour*) ((const byte*) src_rgba_line + si->sprite_line_size);
+		dst_line += bp->pitch;
+		if (anim_line != NULL) anim_line += anim_pitch;
+	}
+}
+
+#endif /* WITH_SSE */
+#endif /* BLITTER_32BPP_AVX2_FUNC_HPP */
@@ -13,15 +13,108 @@
 #include "landscape.h"
 #include "tunnelbridge_map.h"
 
+#include <map>
+
 #include "safeguards.h"
 
+/** The ends of one bridge. */
+struct BridgeSpan {
+	TileIndex north; ///< The northern ramp.
+	TileIndex south; ///< The southern ramp.
+};
+
+/**
+ * The bridges of each axis, by the key of their northern ramp. The keys put
+ * the bridges crossing one row or column of the map next to each other, so
+ * the bridge above a tile is the last one starting at or before its key.
+ * The index is not part of the game state; it is rebuilt after loading.
+ */
+static std::map<uint, BridgeSpan> _bridge_index[AXIS_END];
+static bool _bridge_index_valid = false; ///< Whether #_bridge_index has all bridges of the map.
+
+/**
+ * Get the key of a tile in the bridge index.
+ * @param tile The tile.
+ * @param axis The axis of the bridge.
+ * @return The key; consecutive along \a axis.
+ */
+static inline uint GetBridgeIndexKey(TileIndex tile, Axis axis)
+{
+	return axis == AXIS_X ? (uint)tile : (TileX(tile) << MapLogY()) | TileY(tile);
+}
+
+/**
+ * Find the bridge of the given axis that is above or starts at a tile.
+ * @param tile The tile.
+ * @param axis The axis of the bridge.
+ * @return The bridge, or \c NULL if the index has no such bridge.
+ */
+static const BridgeSpan *FindBridgeSpan(TileIndex tile, Axis axis)
+{
+	const std::map<uint, BridgeSpan> &index = _bridge_index[axis];
+	uint key = GetBridgeIndexKey(tile, axis);
+
+	std::map<uint, BridgeSpan>::const_iterator it = index.upper_bound(key);
+	if (it == index.begin()) return NULL;
+	--it;
+	if (GetBridgeIndexKey(it->second.south, axis) < key) return NULL;
+	return &it->second;
+}
+
+/**
+ * Add a bridge to the index, or update it when it is rebuilt.
+ * @param tile_start One ramp of the bridge.
+ * @param tile_end The other ramp of the bridge.
+ */
+void AddBridgeToIndex(TileIndex tile_start, TileIndex tile_end)
+{
+	if (!_bridge_index_valid) return;
+
+	Axis axis = DiagDirToAxis(GetTunnelBridgeDirection(tile_start));
+	if (GetBridgeIndexKey(tile_end, axis) < GetBridgeIndexKey(tile_start, axis)) Swap(tile_start, tile_end);
+
+	BridgeSpan &span = _bridge_index[axis][GetBridgeIndexKey(tile_start, axis)];
+	span.north = tile_start;
+	span.south = tile_end;
+}
+
+/**
+ * Remove a bridge from the index, before its ramps are removed.
+ * @param tile One ramp of the bridge.
+ */
+void RemoveBridgeFromIndex(TileIndex tile)
+{
+	if (!_bridge_index_valid) return;
+
+	Axis axis = DiagDirToAxis(GetTunnelBridgeDirection(tile));
+	const BridgeSpan *span = FindBridgeSpan(tile, axis);
+	assert(span != NULL);
+	_bridge_index[axis].erase(GetBridgeIndexKey(span->north, axis));
+}
+
+/** Forget all bridges; the map is about to be set up without any. */
+void ResetBridgeIndex()
+{
+	for (uint axis = AXIS_X; axis < AXIS_END; axis++) _bridge_index[axis].clear();
+	_bridge_index_valid = true;
+}
+
+/**
+ * Stop using the bridge index, as the map is about to be loaded or converted
+ * without the index being kept up to date.
+ */
+void InvalidateBridgeIndex()
+{
+	for (uint axis = AXIS_X; axis < AXIS_END; axis++) _bridge_index[axis].clear();
+	_bridge_index_valid = false;
+}
 
 /**
  * Finds the end of a bridge in the specified direction starting at a middle tile
  * @param tile the bridge tile to find the bridge ramp for
  * @param dir  the direction to search in
  */
-static TileIndex GetBridgeEnd(TileIndex tile, DiagDirection dir)
+static TileIndex WalkToBridgeEnd(TileIndex tile, DiagDirection dir)
 {
 	TileIndexDiff delta = TileOffsByDiagDir(dir);
 
@@ -33,6 +126,41 @@ static TileIndex GetBridgeEnd(TileIndex tile, DiagDirection dir)
 	return tile;
 }
 
+/** Fill the bridge index with all bridges on the map. */
+void RebuildBridgeIndex()
+{
+	ResetBridgeIndex();
+
+	for (TileIndex t = 0; t < MapSize(); t++) {
+		if (!IsBridgeTile(t)) continue;
+		/* Only take the northern ramps, which face towards the south. */
+		DiagDirection dir = GetTunnelBridgeDirection(t);
+		if (dir != DIAGDIR_SW && dir != DIAGDIR_SE) continue;
+		AddBridgeToIndex(t, WalkToBridgeEnd(t, dir));
+	}
+}
+
+/**
+ * Finds the end of a bridge in the specified direction starting at a middle tile
+ * or at a ramp, using the bridge index when it is available.
+ * @param tile the bridge tile to find the bridge ramp for
+ * @param dir  the direction to search in
+ */
+static TileIndex GetBridgeEnd(TileIndex tile, DiagDirection dir)
+{
+	Axis axis = DiagDirToAxis(dir);
+	if (_bridge_index_valid && IsValidAxis(axis)) {
+		const BridgeSpan *span = FindBridgeSpan(tile, axis);
+		if (span != NULL) {
+			TileIndex end = (dir == DIAGDIR_SW || dir == DIAGDIR_SE) ? span->south : span->north;
+			assert(end != tile && IsBridgeTile(end) && GetTunnelBridgeDirection(end) == ReverseDiagDir(dir));
+			return end;
+		}
+	}
+
+	return WalkToBridgeEnd(tile, dir);
+}
+
 
 /**
  * Finds the northern end of a bridge starting at a middle tile
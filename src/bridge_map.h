@@ -75,6 +75,12 @@ TileIndex GetNorthernBridgeEnd(TileIndex t);
 TileIndex GetSouthernBridgeEnd(TileIndex t);
 TileIndex GetOtherBridgeEnd(TileIndex t);
 
+void AddBridgeToIndex(TileIndex tile_start, TileIndex tile_end);
+void RemoveBridgeFromIndex(TileIndex tile);
+void ResetBridgeIndex();
+void InvalidateBridgeIndex();
+void RebuildBridgeIndex();
+
 int GetBridgeHeight(TileIndex tile);
 /**
  * Get the height ('z') of a bridge in pixels.
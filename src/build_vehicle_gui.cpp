@@ -37,6 +37,8 @@
 
 #include "table/strings.h"
 
+#include <vector>
+
 #include "safeguards.h"
 
 /**
@@ -97,6 +99,69 @@ bool _engine_sort_last_order[]          = {false, false, false, false}; ///< Las
 bool _engine_sort_show_hidden_engines[] = {false, false, false, false}; ///< Last set 'show hidden engines' setting for each vehicle type.
 static CargoID _engine_sort_last_cargo_criteria[] = {CF_ANY, CF_ANY, CF_ANY, CF_ANY}; ///< Last set filter criteria, for each vehicle type.
 
+/**
+ * Properties of an engine used for sorting and filtering the engine lists.
+ * Most of them can be changed by NewGRF callbacks, which are too expensive
+ * to call for every comparison when there are thousands of engines.
+ */
+struct EngineSortValues {
+	bool valid;                ///< Whether the values have been determined.
+	Money cost;                ///< Purchase cost.
+	Money running_cost;        ///< Running cost per year.
+	uint speed;                ///< Maximum speed for display purposes.
+	uint power;                ///< Power; only for trains and road vehicles.
+	uint tractive_effort;      ///< Maximum tractive effort for display purposes; only for trains and road vehicles.
+	uint total_capacity;       ///< Capacity of all articulated parts together.
+	uint default_capacity;     ///< Capacity of the default cargo for display purposes.
+	uint16 mail_capacity;      ///< Mail capacity of aircraft.
+	uint16 range;              ///< Range; only for aircraft.
+	CargoTypes refit_mask;     ///< Standard cargoes any of the articulated parts can carry.
+};
+
+static std::vector<EngineSortValues> _engine_sort_values; ///< Cached sort values, indexed by EngineID.
+static Year _engine_sort_values_year = INVALID_YEAR;      ///< Year the cached sort values were determined in.
+
+/**
+ * Forget the cached sort values of all engines, because the engines or
+ * the NewGRFs defining them changed.
+ * The cache is also cleared automatically at the start of every year.
+ */
+void InvalidateEngineSortValues()
+{
+	_engine_sort_values.clear();
+	_engine_sort_values_year = INVALID_YEAR;
+}
+
+/**
+ * Get the sort values of an engine, determining them when that has not been done this year.
+ * @param eid The engine to get the values of.
+ * @return The cached values.
+ */
+static const EngineSortValues &GetEngineSortValues(EngineID eid)
+{
+	if (_engine_sort_values_year != _cur_year) {
+		_engine_sort_values.clear();
+		_engine_sort_values_year = _cur_year;
+	}
+	if (eid >= _engine_sort_values.size()) _engine_sort_values.resize(max<size_t>(eid + 1, Engine::GetPoolSize()), EngineSortValues());
+
+	EngineSortValues &v = _engine_sort_values[eid];
+	if (v.valid) return v;
+
+	const Engine *e = Engine::Get(eid);
+	v.cost = e->GetCost();
+	v.running_cost = e->GetRunningCost();
+	v.speed = e->GetDisplayMaxSpeed();
+	v.power = (e->type == VEH_TRAIN || e->type == VEH_ROAD) ? e->GetPower() : 0;
+	v.tractive_effort = (e->type == VEH_TRAIN || e->type == VEH_ROAD) ? e->GetDisplayMaxTractiveEffort() : 0;
+	v.total_capacity = GetTotalCapacityOfArticulatedParts(eid);
+	v.default_capacity = e->GetDisplayDefaultCapacity(&v.mail_capacity);
+	v.range = e->type == VEH_AIRCRAFT ? e->GetRange() : 0;
+	v.refit_mask = GetUnionOfArticulatedRefitMasks(eid, true) & _standard_cargo_mask;
+	v.valid = true;
+	return v;
+}
+
 /**
  * Determines order of engines by engineID
  * @param *a first engine to compare
@@ -185,8 +250,8 @@ static int CDECL EngineReliabilitySorter(const EngineID *a, const EngineID *b)
  */
 static int CDECL EngineCostSorter(const EngineID *a, const EngineID *b)
 {
-	Money va = Engine::Get(*a)->GetCost();
-	Money vb = Engine::Get(*b)->GetCost();
+	Money va = GetEngineSortValues(*a).cost;
+	Money vb = GetEngineSortValues(*b).cost;
 	int r = ClampToI32(va - vb);
 
 	/* Use EngineID to sort instead since we want consistent sorting */
@@ -202,8 +267,8 @@ static int CDECL EngineCostSorter(const EngineID *a, const EngineID *b)
  */
 static int CDECL EngineSpeedSorter(const EngineID *a, const EngineID *b)
 {
-	int va = Engine::Get(*a)->GetDisplayMaxSpeed();
-	int vb = Engine::Get(*b)->GetDisplayMaxSpeed();
+	int va = GetEngineSortValues(*a).speed;
+	int vb = GetEngineSortValues(*b).speed;
 	int r = va - vb;
 
 	/* Use EngineID to sort instead since we want consistent sorting */
@@ -219,8 +284,8 @@ static int CDECL EngineSpeedSorter(const EngineID *a, const EngineID *b)
  */
 static int CDECL EnginePowerSorter(const EngineID *a, const EngineID *b)
 {
-	int va = Engine::Get(*a)->GetPower();
-	int vb = Engine::Get(*b)->GetPower();
+	int va = GetEngineSortValues(*a).power;
+	int vb = GetEngineSortValues(*b).power;
 	int r = va - vb;
 
 	/* Use EngineID to sort instead since we want consistent sorting */
@@ -236,8 +301,8 @@ static int CDECL EnginePowerSorter(const EngineID *a, const EngineID *b)
  */
 static int CDECL EngineTractiveEffortSorter(const EngineID *a, const EngineID *b)
 {
-	int va = Engine::Get(*a)->GetDisplayMaxTractiveEffort();
-	int vb = Engine::Get(*b)->GetDisplayMaxTractiveEffort();
+	int va = GetEngineSortValues(*a).tractive_effort;
+	int vb = GetEngineSortValues(*b).tractive_effort;
 	int r = va - vb;
 
 	/* Use EngineID to sort instead since we want consistent sorting */
@@ -253,8 +318,8 @@ static int CDECL EngineTractiveEffortSorter(const EngineID *a, const EngineID *b
  */
 static int CDECL EngineRunningCostSorter(const EngineID *a, const EngineID *b)
 {
-	Money va = Engine::Get(*a)->GetRunningCost();
-	Money vb = Engine::Get(*b)->GetRunningCost();
+	Money va = GetEngineSortValues(*a).running_cost;
+	Money vb = GetEngineSortValues(*b).running_cost;
 	int r = ClampToI32(va - vb);
 
 	/* Use EngineID to sort instead since we want consistent sorting */
@@ -270,8 +335,8 @@ static int CDECL EngineRunningCostSorter(const EngineID *a, const EngineID *b)
  */
 static int CDECL EnginePowerVsRunningCostSorter(const EngineID *a, const EngineID *b)
 {
-	const Engine *e_a = Engine::Get(*a);
-	const Engine *e_b = Engine::Get(*b);
+	const EngineSortValues &e_a = GetEngineSortValues(*a);
+	const EngineSortValues &e_b = GetEngineSortValues(*b);
 
 	/* Here we are using a few tricks to get the right sort.
 	 * We want power/running cost, but since we usually got higher running cost than power and we store the result in an int,
@@ -279,8 +344,8 @@ static int CDECL EnginePowerVsRunningCostSorter(const EngineID *a, const EngineI
 	 * Because of this, the return value have to be reversed as well and we return b - a instead of a - b.
 	 * Another thing is that both power and running costs should be doubled for multiheaded engines.
 	 * Since it would be multiplying with 2 in both numerator and denominator, it will even themselves out and we skip checking for multiheaded. */
-	Money va = (e_a->GetRunningCost()) / max(1U, (uint)e_a->GetPower());
-	Money vb = (e_b->GetRunningCost()) / max(1U, (uint)e_b->GetPower());
+	Money va = e_a.running_cost / max(1U, e_a.power);
+	Money vb = e_b.running_cost / max(1U, e_b.power);
 	int r = ClampToI32(vb - va);
 
 	/* Use EngineID to sort instead since we want consistent sorting */
@@ -301,8 +366,8 @@ static int CDECL TrainEngineCapacitySorter(const EngineID *a, const EngineID *b)
 	const RailVehicleInfo *rvi_a = RailVehInfo(*a);
 	const RailVehicleInfo *rvi_b = RailVehInfo(*b);
 
-	int va = GetTotalCapacityOfArticulatedParts(*a) * (rvi_a->railveh_type == RAILVEH_MULTIHEAD ? 2 : 1);
-	int vb = GetTotalCapacityOfArticulatedParts(*b) * (rvi_b->railveh_type == RAILVEH_MULTIHEAD ? 2 : 1);
+	int va = GetEngineSortValues(*a).total_capacity * (rvi_a->railveh_type == RAILVEH_MULTIHEAD ? 2 : 1);
+	int vb = GetEngineSortValues(*b).total_capacity * (rvi_b->railveh_type == RAILVEH_MULTIHEAD ? 2 : 1);
 	int r = va - vb;
 
 	/* Use EngineID to sort instead since we want consistent sorting */
@@ -337,8 +402,8 @@ static int CDECL TrainEnginesThenWagonsSorter(const EngineID *a, const EngineID
  */
 static int CDECL RoadVehEngineCapacitySorter(const EngineID *a, const EngineID *b)
 {
-	int va = GetTotalCapacityOfArticulatedParts(*a);
-	int vb = GetTotalCapacityOfArticulatedParts(*b);
+	int va = GetEngineSortValues(*a).total_capacity;
+	int vb = GetEngineSortValues(*b).total_capacity;
 	int r = va - vb;
 
 	/* Use EngineID to sort instead since we want consistent sorting */
@@ -356,11 +421,8 @@ static int CDECL RoadVehEngineCapacitySorter(const EngineID *a, const EngineID *
  */
 static int CDECL ShipEngineCapacitySorter(const EngineID *a, const EngineID *b)
 {
-	const Engine *e_a = Engine::Get(*a);
-	const Engine *e_b = Engine::Get(*b);
-
-	int va = e_a->GetDisplayDefaultCapacity();
-	int vb = e_b->GetDisplayDefaultCapacity();
+	int va = GetEngineSortValues(*a).default_capacity;
+	int vb = GetEngineSortValues(*b).default_capacity;
 	int r = va - vb;
 
 	/* Use EngineID to sort instead since we want consistent sorting */
@@ -378,17 +440,16 @@ static int CDECL ShipEngineCapacitySorter(const EngineID *a, const EngineID *b)
  */
 static int CDECL AircraftEngineCargoSorter(const EngineID *a, const EngineID *b)
 {
-	const Engine *e_a = Engine::Get(*a);
-	const Engine *e_b = Engine::Get(*b);
+	const EngineSortValues &e_a = GetEngineSortValues(*a);
+	const EngineSortValues &e_b = GetEngineSortValues(*b);
 
-	uint16 mail_a, mail_b;
-	int va = e_a->GetDisplayDefaultCapacity(&mail_a);
-	int vb = e_b->GetDisplayDefaultCapacity(&mail_b);
+	int va = e_a.default_capacity;
+	int vb = e_b.default_capacity;
 	int r = va - vb;
 
 	if (r == 0) {
 		/* The planes have the same passenger capacity. Check mail capacity instead */
-		r = mail_a - mail_b;
+		r = e_a.mail_capacity - e_b.mail_capacity;
 
 		if (r == 0) {
 			/* Use EngineID to sort instead since we want consistent sorting */
@@ -406,8 +467,8 @@ static int CDECL AircraftEngineCargoSorter(const EngineID *a, const EngineID *b)
  */
 static int CDECL AircraftRangeSorter(const EngineID *a, const EngineID *b)
 {
-	uint16 r_a = Engine::Get(*a)->GetRange();
-	uint16 r_b = Engine::Get(*b)->GetRange();
+	uint16 r_a = GetEngineSortValues(*a).range;
+	uint16 r_b = GetEngineSortValues(*b).range;
 
 	int r = r_a - r_b;
 
@@ -524,7 +585,7 @@ const StringID _engine_sort_listing[][12] = {{
 static bool CDECL CargoFilter(const EngineID *eid, const CargoID cid)
 {
 	if (cid == CF_ANY) return true;
-	CargoTypes refit_mask = GetUnionOfArticulatedRefitMasks(*eid, true) & _standard_cargo_mask;
+	CargoTypes refit_mask = GetEngineSortValues(*eid).refit_mask;
 	return (cid == CF_NONE ? refit_mask == 0 : HasBit(refit_mask, cid));
 }
 
@@ -205,9 +205,11 @@ bool StationCargoReroute::operator()(CargoPacket *cp)
 		this->destination->AddToCache(cp_new);
 	}
 
-	/* Legal, as insert doesn't invalidate iterators in the MultiMap, however
-	 * this might insert the packet between range.first and range.second (which might be end())
-	 * This is why we check for GetKey above to avoid infinite loops. */
+	/* Legal, as insert doesn't invalidate iterators in the MultiMap as long as
+	 * it goes to another key than the one being iterated (asserted above).
+	 * However, this might insert the packet between range.first and range.second
+	 * (which might be end()). This is why we check for GetKey above to avoid
+	 * infinite loops. */
 	this->destination->packets.Insert(next, cp_new);
 	return cp_new == cp;
 }
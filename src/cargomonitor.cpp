@@ -32,12 +32,11 @@ static void ClearCargoMonitoring(CargoMonitorMap &cargo_monitor_map, CompanyID c
 		return;
 	}
 
-	CargoMonitorMap::iterator next;
-	for (CargoMonitorMap::iterator it = cargo_monitor_map.begin(); it != cargo_monitor_map.end(); it = next) {
-		next = it;
-		next++;
+	for (CargoMonitorMap::iterator it = cargo_monitor_map.begin(); it != cargo_monitor_map.end();) {
 		if (DecodeMonitorCompany(it->first) == company) {
-			cargo_monitor_map.erase(it);
+			it = cargo_monitor_map.erase(it);
+		} else {
+			it++;
 		}
 	}
 }
@@ -117,13 +116,16 @@ int32 GetPickupAmount(CargoMonitorID monitor, bool keep_monitoring)
  * @param src_type type of \a src.
  * @param src index of source.
  * @param st station where the cargo is delivered to.
- * @param dest industry index where the cargo is delivered to.
+ * @param dest industry index where the cargo is delivered to; it must be one of the industries near \a st.
+ * @note This is called once per batch of cargo paid for by #CargoPayment::FlushDelivery,
+ *       and returns right away when no game script monitors anything.
  */
 void AddCargoDelivery(CargoID cargo_type, CompanyID company, uint32 amount, SourceType src_type, SourceID src, const Station *st, IndustryID dest)
 {
 	if (amount == 0) return;
+	if (_cargo_pickups.empty() && _cargo_deliveries.empty()) return;
 
-	if (src != INVALID_SOURCE) {
+	if (src != INVALID_SOURCE && !_cargo_pickups.empty()) {
 		/* Handle pickup update. */
 		switch (src_type) {
 			case ST_INDUSTRY: {
@@ -145,15 +147,17 @@ void AddCargoDelivery(CargoID cargo_type, CompanyID company, uint32 amount, Sour
 	/* Handle delivery.
 	 * Note that delivery in the right area is sufficient to prevent trouble with neighbouring industries or houses. */
 
+	if (_cargo_deliveries.empty()) return;
+
 	/* Town delivery. */
 	CargoMonitorID num = EncodeCargoTownMonitor(company, cargo_type, st->town->index);
 	CargoMonitorMap::iterator iter = _cargo_deliveries.find(num);
 	if (iter != _cargo_deliveries.end()) iter->second += amount;
 
 	/* Industry delivery. */
-	for (Industry *ind : st->industries_near) {
-		if (ind->index != dest) continue;
-		CargoMonitorID num = EncodeCargoIndustryMonitor(company, cargo_type, ind->index);
+	if (dest != INVALID_INDUSTRY) {
+		assert(st->industries_near.find(Industry::Get(dest)) != st->industries_near.end());
+		CargoMonitorID num = EncodeCargoIndustryMonitor(company, cargo_type, dest);
 		CargoMonitorMap::iterator iter = _cargo_deliveries.find(num);
 		if (iter != _cargo_deliveries.end()) iter->second += amount;
 	}
@@ -23,6 +23,26 @@
 CargoPacketPool _cargopacket_pool("CargoPacket");
 INSTANTIATE_POOL_METHODS(CargoPacket)
 
+uint _cargo_packets_reclaimed = 0; ///< Number of cargo packets freed by compacting cargo lists since this was last reset.
+
+/** Properties of a cargo packet that have to match for merging it with another one. */
+struct CargoPacketMergeKey {
+	TileIndex source_xy;          ///< Origin of the cargo.
+	TileOrStationID loaded_at_xy; ///< Place the cargo was loaded or its next hop, if that matters.
+	SourceID source_id;           ///< Source of the cargo for subsidies.
+	byte days_in_transit;         ///< Age of the cargo.
+	SourceType source_type;       ///< Type of the source of the cargo.
+
+	bool operator<(const CargoPacketMergeKey &other) const
+	{
+		if (this->source_xy != other.source_xy) return this->source_xy < other.source_xy;
+		if (this->loaded_at_xy != other.loaded_at_xy) return this->loaded_at_xy < other.loaded_at_xy;
+		if (this->source_id != other.source_id) return this->source_id < other.source_id;
+		if (this->days_in_transit != other.days_in_transit) return this->days_in_transit < other.days_in_transit;
+		return this->source_type < other.source_type;
+	}
+};
+
 /**
  * Create a new packet for savegame loading.
  */
@@ -230,6 +250,51 @@ template <class Tinst, class Tcont>
 	}
 }
 
+/**
+ * Merges packets into earlier ones in the same part of a list if possible.
+ * Packets only get merged on appending them, but many end up next to fitting
+ * ones later, e.g. after partial loading or aging. The remaining packets keep
+ * their order; each merged packet is added to the first fitting one.
+ * @param list Container of the packets.
+ * @param first First packet to compact.
+ * @param last Packet after the last one to compact.
+ * @param in_vehicle If the packets are in a vehicle, so that their loading
+ *                   place (or next hop for transfers) has to match as well.
+ * @return Number of packets that have been merged into others and freed.
+ */
+template <class Tinst, class Tcont>
+template <class Tlist>
+/* static */ uint CargoList<Tinst, Tcont>::CompactPackets(Tlist &list, typename Tlist::iterator first, typename Tlist::iterator last, bool in_vehicle)
+{
+	typedef std::map<CargoPacketMergeKey, CargoPacket *> TargetMap;
+	TargetMap targets;
+	uint reclaimed = 0;
+	typename Tlist::iterator keep = first;
+	for (typename Tlist::iterator it = first; it != last; ++it) {
+		CargoPacket *cp = *it;
+		CargoPacketMergeKey key;
+		key.source_xy = cp->source_xy;
+		key.loaded_at_xy = in_vehicle ? cp->loaded_at_xy : 0;
+		key.source_id = cp->source_id;
+		key.days_in_transit = cp->days_in_transit;
+		key.source_type = cp->source_type;
+
+		std::pair<typename TargetMap::iterator, bool> target = targets.insert(std::make_pair(key, cp));
+		if (!target.second) {
+			if (Tinst::TryMerge(target.first->second, cp)) {
+				reclaimed++;
+				continue;
+			}
+			/* The earlier packet is full; later ones are merged into this one. */
+			target.first->second = cp;
+		}
+		*keep++ = cp;
+	}
+	list.erase(keep, last);
+	_cargo_packets_reclaimed += reclaimed;
+	return reclaimed;
+}
+
 /*
  *
  * Vehicle cargo list implementation.
@@ -394,6 +459,28 @@ void VehicleCargoList::AgeCargo()
 	}
 }
 
+/**
+ * Merges packets that could have been merged when they were added. Packets are
+ * only merged with others designated for the same action.
+ * @return Number of packets that have been freed.
+ */
+uint VehicleCargoList::Compact()
+{
+	uint reclaimed = 0;
+	Iterator first(this->packets.begin());
+	for (int action = MTA_BEGIN; action != MTA_END; action++) {
+		Iterator last(first);
+		for (uint sum = 0; sum < this->action_counts[action]; ++last) {
+			assert(last != this->packets.end());
+			sum += (*last)->count;
+		}
+		reclaimed += CompactPackets(this->packets, first, last, true);
+		first = last;
+	}
+	assert(first == this->packets.end());
+	return reclaimed;
+}
+
 /**
  * Sets loaded_at_xy to the current station for all cargo to be transfered.
  * This is done when stopping or skipping while the vehicle is unloading. In
@@ -459,6 +546,17 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 	bool force_keep = (order_flags & OUFB_NO_UNLOAD) != 0;
 	bool force_unload = (order_flags & OUFB_UNLOAD) != 0;
 	bool force_transfer = (order_flags & (OUFB_TRANSFER | OUFB_UNLOAD)) != 0;
+
+	/* Consecutive packets often come from the same source. The flows to
+	 * choose from only depend on the source, so look them up only when the
+	 * source changes. The random next hop is still drawn per packet. For
+	 * forced transfers the shares without the excluded stations are kept. */
+	StationID flow_source = INVALID_STATION;
+	bool flow_looked_up = false;
+	FlowStatMap::const_iterator flow_it = ge->flows.end();
+	FlowStat transfer_shares(INVALID_STATION, 1);
+	bool transfer_routable = false;
+
 	assert(this->count > 0 || it == this->packets.end());
 	while (sum < this->count) {
 		CargoPacket *cp = *it;
@@ -474,22 +572,22 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 			action = MTA_TRANSFER;
 			/* We cannot send the cargo to any of the possible next hops and
 			 * also not to the current station. */
-			FlowStatMap::const_iterator flow_it(ge->flows.find(cp->source));
-			if (flow_it == ge->flows.end()) {
-				cargo_next = INVALID_STATION;
-			} else {
-				FlowStat new_shares = flow_it->second;
-				new_shares.ChangeShare(current_station, INT_MIN);
-				StationIDStack excluded = next_station;
-				while (!excluded.IsEmpty() && !new_shares.GetShares()->empty()) {
-					new_shares.ChangeShare(excluded.Pop(), INT_MIN);
-				}
-				if (new_shares.GetShares()->empty()) {
-					cargo_next = INVALID_STATION;
-				} else {
-					cargo_next = new_shares.GetVia();
+			if (!flow_looked_up || flow_source != cp->source) {
+				flow_looked_up = true;
+				flow_source = cp->source;
+				flow_it = ge->flows.find(cp->source);
+				transfer_routable = false;
+				if (flow_it != ge->flows.end()) {
+					transfer_shares = flow_it->second;
+					transfer_shares.ChangeShare(current_station, INT_MIN);
+					StationIDStack excluded = next_station;
+					while (!excluded.IsEmpty() && !transfer_shares.GetShares()->empty()) {
+						transfer_shares.ChangeShare(excluded.Pop(), INT_MIN);
+					}
+					transfer_routable = !transfer_shares.GetShares()->empty();
 				}
 			}
+			cargo_next = transfer_routable ? transfer_shares.GetVia() : INVALID_STATION;
 		} else {
 			/* Rewrite an invalid source station to some random other one to
 			 * avoid keeping the cargo in the vehicle forever. */
@@ -497,7 +595,11 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 				cp->source = ge->flows.begin()->first;
 			}
 			bool restricted = false;
-			FlowStatMap::const_iterator flow_it(ge->flows.find(cp->source));
+			if (!flow_looked_up || flow_source != cp->source) {
+				flow_looked_up = true;
+				flow_source = cp->source;
+				flow_it = ge->flows.find(cp->source);
+			}
 			if (flow_it == ge->flows.end()) {
 				cargo_next = INVALID_STATION;
 			} else {
@@ -677,6 +779,27 @@ uint VehicleCargoList::Reroute(uint max_move, VehicleCargoList *dest, StationID
 	return max_move;
 }
 
+/**
+ * Routes all packets staged for transfer with any of the given stations as
+ * next hop to a different place. Unlike Reroute this only changes the next
+ * hops in place, so the packets are walked only once for all stations.
+ * @param avoid Stations to exclude from routing and current next hops of packets to reroute.
+ * @param avoid2 Additional station to exclude from routing.
+ * @param ge GoodsEntry to get the routing info from.
+ */
+void VehicleCargoList::RerouteTransfers(const StationIDSet &avoid, StationID avoid2, const GoodsEntry *ge)
+{
+	uint sum = 0;
+	for (Iterator it(this->packets.begin()); sum < this->action_counts[MTA_TRANSFER]; ++it) {
+		CargoPacket *cp = *it;
+		sum += cp->count;
+		StationID next = cp->next_station;
+		if (next == avoid2 || avoid.find(next) != avoid.end()) {
+			cp->next_station = ge->GetVia(cp->source, next, avoid2);
+		}
+	}
+}
+
 /*
  *
  * Station cargo list implementation.
@@ -706,6 +829,20 @@ void StationCargoList::Append(CargoPacket *cp, StationID next)
 	list.push_back(cp);
 }
 
+/**
+ * Merges packets with the same next hop that could have been merged when they
+ * were added.
+ * @return Number of packets that have been freed.
+ */
+uint StationCargoList::Compact()
+{
+	uint reclaimed = 0;
+	for (StationCargoPacketMap::MapIterator it(this->packets.Map::begin()); it != this->packets.Map::end(); ++it) {
+		reclaimed += CompactPackets(it->second, it->second.begin(), it->second.end(), false);
+	}
+	return reclaimed;
+}
+
 /**
  * Shifts cargo from the front of the packet list for a specific station and
  * applies some action to it.
@@ -778,38 +915,56 @@ uint StationCargoList::Truncate(uint max_move, StationCargoAmountMap *cargo_per_
 	uint loop = 0;
 	bool do_count = cargo_per_source != NULL;
 	while (max_move > moved) {
-		for (Iterator it(this->packets.begin()); it != this->packets.end();) {
-			CargoPacket *cp = *it;
-			if (prev_count > max_move && RandomRange(prev_count) < prev_count - max_move) {
-				if (do_count && loop == 0) {
-					(*cargo_per_source)[cp->source] += cp->count;
+		/* The packets of each next hop are compacted in place while walking
+		 * them, so that removing many of them doesn't move the rest for
+		 * every single one. */
+		for (StationCargoPacketMap::MapIterator map_it(this->packets.Map::begin()); map_it != this->packets.Map::end();) {
+			StationCargoPacketMap::List &list = map_it->second;
+			StationCargoPacketMap::ListIterator keep(list.begin());
+			bool done = false;
+			for (StationCargoPacketMap::ListIterator it(list.begin()); it != list.end(); ++it) {
+				CargoPacket *cp = *it;
+				if (done) {
+					*keep++ = cp;
+					continue;
 				}
-				++it;
-				continue;
-			}
-			uint diff = max_move - moved;
-			if (cp->count > diff) {
-				if (diff > 0) {
-					this->RemoveFromCache(cp, diff);
-					cp->Reduce(diff);
-					moved += diff;
+				if (prev_count > max_move && RandomRange(prev_count) < prev_count - max_move) {
+					if (do_count && loop == 0) {
+						(*cargo_per_source)[cp->source] += cp->count;
+					}
+					*keep++ = cp;
+					continue;
 				}
-				if (loop > 0) {
-					if (do_count) (*cargo_per_source)[cp->source] -= diff;
-					return moved;
+				uint diff = max_move - moved;
+				if (cp->count > diff) {
+					if (diff > 0) {
+						this->RemoveFromCache(cp, diff);
+						cp->Reduce(diff);
+						moved += diff;
+					}
+					if (loop > 0) {
+						if (do_count) (*cargo_per_source)[cp->source] -= diff;
+						done = true;
+					} else {
+						if (do_count) (*cargo_per_source)[cp->source] += cp->count;
+					}
+					*keep++ = cp;
 				} else {
-					if (do_count) (*cargo_per_source)[cp->source] += cp->count;
-					++it;
+					if (do_count && loop > 0) {
+						(*cargo_per_source)[cp->source] -= cp->count;
+					}
+					moved += cp->count;
+					this->RemoveFromCache(cp, cp->count);
+					delete cp;
 				}
+			}
+			list.erase(keep, list.end());
+			if (list.empty()) {
+				this->packets.Map::erase(map_it++);
 			} else {
-				it = this->packets.erase(it);
-				if (do_count && loop > 0) {
-					(*cargo_per_source)[cp->source] -= cp->count;
-				}
-				moved += cp->count;
-				this->RemoveFromCache(cp, cp->count);
-				delete cp;
+				++map_it;
 			}
+			if (done) return moved;
 		}
 		loop++;
 	}
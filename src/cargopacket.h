@@ -19,6 +19,7 @@
 #include "cargo_type.h"
 #include "vehicle_type.h"
 #include "core/multimap.hpp"
+#include "core/flatdeque_type.hpp"
 #include <list>
 
 /** Unique identifier for a single cargo packet. */
@@ -26,7 +27,7 @@ typedef uint32 CargoPacketID;
 struct CargoPacket;
 
 /** Type of the pool for cargo packets for a little over 16 million packets. */
-typedef Pool<CargoPacket, CargoPacketID, 1024, 0xFFF000, PT_NORMAL, true, false> CargoPacketPool;
+typedef Pool<CargoPacket, CargoPacketID, 1024, 0xFFF000, PT_NORMAL, false, false, true> CargoPacketPool;
 /** The actual pool with cargo packets. */
 extern CargoPacketPool _cargopacket_pool;
 
@@ -246,6 +247,9 @@ protected:
 
 	static bool TryMerge(CargoPacket *cp, CargoPacket *icp);
 
+	template <class Tlist>
+	static uint CompactPackets(Tlist &list, typename Tlist::iterator first, typename Tlist::iterator last, bool in_vehicle);
+
 public:
 	/** Create the cargo list. */
 	CargoList() {}
@@ -277,6 +281,8 @@ public:
 
 typedef std::list<CargoPacket *> CargoPacketList;
 
+extern uint _cargo_packets_reclaimed;
+
 /**
  * CargoList that is used for vehicles.
  */
@@ -408,6 +414,8 @@ public:
 
 	void AgeCargo();
 
+	uint Compact();
+
 	void InvalidateCache();
 
 	void SetTransferLoadPlace(TileIndex xy);
@@ -436,6 +444,7 @@ public:
 	uint Shift(uint max_move, VehicleCargoList *dest);
 	uint Truncate(uint max_move = UINT_MAX);
 	uint Reroute(uint max_move, VehicleCargoList *dest, StationID avoid, StationID avoid2, const GoodsEntry *ge);
+	void RerouteTransfers(const StationIDSet &avoid, StationID avoid2, const GoodsEntry *ge);
 
 	/**
 	 * Are two the two CargoPackets mergeable in the context of
@@ -454,7 +463,12 @@ public:
 	}
 };
 
-typedef MultiMap<StationID, CargoPacket *> StationCargoPacketMap;
+/**
+ * Packets waiting at a station, by next hop. The packets of each next hop are
+ * kept in one contiguous block as they are mostly added at the back and taken
+ * from the front.
+ */
+typedef MultiMap<StationID, CargoPacket *, std::less<StationID>, FlatDeque<CargoPacket *> > StationCargoPacketMap;
 typedef std::map<StationID, uint> StationCargoAmountMap;
 
 /**
@@ -491,6 +505,8 @@ public:
 
 	void Append(CargoPacket *cp, StationID next);
 
+	uint Compact();
+
 	/**
 	 * Check for cargo headed for a specific station.
 	 * @param next Station the cargo is headed for.
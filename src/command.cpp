@@ -26,6 +26,7 @@
 #include "signal_func.h"
 #include "core/backup_type.hpp"
 #include "object_base.h"
+#include "viewport_func.h"
 
 #include "table/strings.h"
 
@@ -429,6 +430,63 @@ bool IsCommandAllowedWhilePaused(uint32 cmd)
 
 static int _docommand_recursive = 0;
 
+/** State of the plan a top level command hands from its test run to its execution run. */
+enum CommandPlanState {
+	CPS_NONE,   ///< There is no plan; commands run every step.
+	CPS_RECORD, ///< The test run records the outcome of its steps.
+	CPS_REPLAY, ///< The execution run may skip the steps that failed in the test run.
+};
+
+static CommandPlanState _command_plan_state = CPS_NONE; ///< State of #_command_plan.
+static std::vector<bool> _command_plan;                 ///< Whether each step of the test run of the top level command succeeded.
+
+/**
+ * Record the outcome of a step of a command that repeats a sub command over
+ * many tiles, e.g. a drag. This only records anything during the test run
+ * of a command executed through #DoCommandP, not for nested commands.
+ * @param flags The flags the command has been called with.
+ * @param success Whether the step succeeded.
+ */
+void RecordCommandPlanStep(DoCommandFlag flags, bool success)
+{
+	if (_command_plan_state == CPS_RECORD && _docommand_recursive == 1 && (flags & DC_EXEC) == 0) _command_plan.push_back(success);
+}
+
+/**
+ * Check whether the execution run of a command can use the outcome of the
+ * steps recorded by its test run with #RecordCommandPlanStep.
+ * @param flags The flags the command has been called with.
+ * @return True if #GetCommandPlanLength and #IsCommandPlanStepDone may be used.
+ */
+bool HasCommandPlan(DoCommandFlag flags)
+{
+	return _command_plan_state == CPS_REPLAY && _docommand_recursive == 1 && (flags & DC_EXEC) != 0;
+}
+
+/**
+ * Get the number of steps the test run of the command did.
+ * @return The number of recorded steps.
+ * @pre HasCommandPlan()
+ */
+uint GetCommandPlanLength()
+{
+	assert(_command_plan_state == CPS_REPLAY);
+	return (uint)_command_plan.size();
+}
+
+/**
+ * Check whether a step of the command succeeded in the test run. Steps that
+ * failed without side effects need not be tried again when executing.
+ * @param step The step to check.
+ * @return True if the step succeeded in the test run.
+ * @pre HasCommandPlan() && step < GetCommandPlanLength()
+ */
+bool IsCommandPlanStepDone(uint step)
+{
+	assert(_command_plan_state == CPS_REPLAY && step < _command_plan.size());
+	return _command_plan[step];
+}
+
 /**
  * Shorthand for calling the long DoCommand with a container.
  *
@@ -493,6 +551,7 @@ CommandCost DoCommand(TileIndex tile, uint32 p1, uint32 p2, DoCommandFlag flags,
 	/* Execute the command here. All cost-relevant functions set the expenses type
 	 * themselves to the cost object at some point */
 	if (_docommand_recursive == 1) _cleared_object_areas.Clear();
+	_company_infrastructure_touched = true;
 	res = proc(tile, flags, p1, p2, text);
 	if (res.Failed()) {
 error:
@@ -608,7 +667,7 @@ bool DoCommandP(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd, CommandCallbac
  * Helper to deduplicate the code for returning.
  * @param cmd   the command cost to return.
  */
-#define return_dcpi(cmd) { _docommand_recursive = 0; return cmd; }
+#define return_dcpi(cmd) { _docommand_recursive = 0; _command_plan_state = CPS_NONE; return cmd; }
 
 /*!
  * Helper function for the toplevel network safe docommand function for the current company.
@@ -669,13 +728,17 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd,
 
 	bool test_and_exec_can_differ = (cmd_flags & CMD_NO_TEST) != 0;
 
-	/* Test the command. */
+	/* Test the command. When the test and execution cannot differ, the
+	 * steps that failed in the test run need not be tried again. */
 	_cleared_object_areas.Clear();
+	_command_plan.clear();
+	_command_plan_state = test_and_exec_can_differ ? CPS_NONE : CPS_RECORD;
 	SetTownRatingTestMode(true);
 	BasePersistentStorageArray::SwitchMode(PSM_ENTER_TESTMODE);
 	CommandCost res = proc(tile, flags, p1, p2, text);
 	BasePersistentStorageArray::SwitchMode(PSM_LEAVE_TESTMODE);
 	SetTownRatingTestMode(false);
+	_command_plan_state = CPS_NONE;
 
 	/* Make sure we're not messing things up here. */
 	assert(exec_as_spectator ? _current_company == COMPANY_SPECTATOR : cur_company.Verify());
@@ -717,9 +780,17 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd,
 	/* Actually try and execute the command. If no cost-type is given
 	 * use the construction one */
 	_cleared_object_areas.Clear();
+	if (!test_and_exec_can_differ) _command_plan_state = CPS_REPLAY;
 	BasePersistentStorageArray::SwitchMode(PSM_ENTER_COMMAND);
-	CommandCost res2 = proc(tile, flags | DC_EXEC, p1, p2, text);
+	CommandCost res2;
+	{
+		/* Drags and area commands mark many tiles next to each other dirty. */
+		ViewportDirtyBatch dirty_batch;
+		_company_infrastructure_touched = true;
+		res2 = proc(tile, flags | DC_EXEC, p1, p2, text);
+	}
 	BasePersistentStorageArray::SwitchMode(PSM_LEAVE_COMMAND);
+	_command_plan_state = CPS_NONE;
 
 	if (cmd_id == CMD_COMPANY_CTRL) {
 		cur_company.Trash();
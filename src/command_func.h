@@ -48,6 +48,11 @@ void NetworkSendCommand(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd, Comman
 
 extern Money _additional_cash_required;
 
+void RecordCommandPlanStep(DoCommandFlag flags, bool success);
+bool HasCommandPlan(DoCommandFlag flags);
+uint GetCommandPlanLength();
+bool IsCommandPlanStepDone(uint step);
+
 bool IsValidCommand(uint32 cmd);
 CommandFlags GetCommandFlags(uint32 cmd);
 const char *GetCommandName(uint32 cmd);
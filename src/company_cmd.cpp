@@ -49,6 +49,7 @@ Colours _company_colours[MAX_COMPANIES];  ///< NOSAVE: can be determined from co
 CompanyManagerFace _company_manager_face; ///< for company manager face storage in openttd.cfg
 uint _next_competitor_start;              ///< the number of ticks before the next AI is started
 uint _cur_company_tick_index;             ///< used to generate a name for one company that doesn't have a name yet per tick
+bool _company_infrastructure_touched;     ///< NOSAVE: a command was executed or ownership changed since the infrastructure cache was last checked.
 
 CompanyPool _company_pool("Company"); ///< Pool of companies.
 INSTANTIATE_POOL_METHODS(Company)
@@ -793,7 +794,10 @@ void CompanyNewsInformation::FillData(const Company *c, const Company *other)
 void CompanyAdminUpdate(const Company *company)
 {
 #ifdef ENABLE_NETWORK
-	if (_network_server) NetworkAdminCompanyUpdate(company);
+	if (_network_server) {
+		NetworkAdminCompanyUpdate(company);
+		NetworkUDPInvalidateServerInfo();
+	}
 #endif /* ENABLE_NETWORK */
 }
 
@@ -805,7 +809,10 @@ void CompanyAdminUpdate(const Company *company)
 void CompanyAdminRemove(CompanyID company_id, CompanyRemoveReason reason)
 {
 #ifdef ENABLE_NETWORK
-	if (_network_server) NetworkAdminCompanyRemove(company_id, (AdminCompanyRemoveReason)reason);
+	if (_network_server) {
+		NetworkAdminCompanyRemove(company_id, (AdminCompanyRemoveReason)reason);
+		NetworkUDPInvalidateServerInfo();
+	}
 #endif /* ENABLE_NETWORK */
 }
 
@@ -37,6 +37,7 @@ extern CompanyByte _current_company;
 
 extern Colours _company_colours[MAX_COMPANIES];
 extern CompanyManagerFace _company_manager_face;
+extern bool _company_infrastructure_touched;
 
 /**
  * Is the current company the local company?
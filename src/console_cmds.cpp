@@ -24,6 +24,7 @@
 #include "settings_func.h"
 #include "fios.h"
 #include "fileio_func.h"
+#include "framerate_type.h"
 #include "screenshot.h"
 #include "genworld.h"
 #include "strings_func.h"
@@ -38,6 +39,16 @@
 #include "console_func.h"
 #include "engine_base.h"
 #include "game/game.hpp"
+#include "vehicle_func.h"
+#include "pathfinder/pathfinder_stats.h"
+#include "viewport_sprite_sorter.h"
+#include "newgrf_spritegroup.h"
+#include "spritecache.h"
+#include "map_func.h"
+#include "linkgraph/linkgraph.h"
+#include "linkgraph/linkgraphjob.h"
+#include "script/squirrel.hpp"
+#include "core/pool_type.hpp"
 #include "table/strings.h"
 
 #include "safeguards.h"
@@ -1314,6 +1325,18 @@ DEF_CONSOLE_CMD(ConGetSeed)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConVehicleHash)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the occupancy of the vehicle location hashes. Usage: 'vehicle_hash'");
+		return true;
+	}
+
+	PrintVehicleTileHashStats();
+	PrintVehicleViewportHashStats();
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConGetDate)
 {
 	if (argc == 0) {
@@ -1352,9 +1375,10 @@ DEF_CONSOLE_CMD(ConAlias)
 DEF_CONSOLE_CMD(ConScreenShot)
 {
 	if (argc == 0) {
-		IConsoleHelp("Create a screenshot of the game. Usage: 'screenshot [big | giant | no_con] [file name]'");
+		IConsoleHelp("Create a screenshot of the game. Usage: 'screenshot [big | giant | tiles | no_con] [file name]'");
 		IConsoleHelp("'big' makes a zoomed-in screenshot of the visible area, 'giant' makes a screenshot of the "
-				"whole map, 'no_con' hides the console to create the screenshot. 'big' or 'giant' "
+				"whole map, 'tiles' makes a pyramid of tiles of the whole map for every zoom level in a directory, "
+				"'no_con' hides the console to create the screenshot. 'big', 'giant' or 'tiles' "
 				"screenshots are always drawn without console");
 		return true;
 	}
@@ -1373,6 +1397,10 @@ DEF_CONSOLE_CMD(ConScreenShot)
 			/* screenshot giant [filename] */
 			type = SC_WORLD;
 			if (argc > 2) name = argv[2];
+		} else if (strcmp(argv[1], "tiles") == 0) {
+			/* screenshot tiles [directory name] */
+			type = SC_WORLD_TILES;
+			if (argc > 2) name = argv[2];
 		} else if (strcmp(argv[1], "no_con") == 0) {
 			/* screenshot no_con [filename] */
 			IConsoleClose();
@@ -1390,6 +1418,28 @@ DEF_CONSOLE_CMD(ConScreenShot)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConMinimap)
+{
+	if (argc == 0) {
+		IConsoleHelp("Create an image of the whole map as the small map shows it, one pixel per tile. Usage: 'minimap [<mode>] [file name]'");
+		IConsoleHelp("Modes are 'contour' (default), 'vehicles', 'industries', 'linkstats', 'routes', 'vegetation' and 'owner'. "
+				"The image is written in the background; this also works on a dedicated server");
+		return true;
+	}
+
+	if (argc > 3) return false;
+
+	const char *mode = argc > 1 ? argv[1] : "contour";
+	const char *name = argc > 2 ? argv[2] : NULL;
+	if (!MakeSmallMapScreenshot(mode, name)) {
+		IConsoleError("Unknown small map mode.");
+		return true;
+	}
+
+	IConsolePrintF(CC_DEFAULT, "Writing minimap '%s' in the background.", _full_screenshot_name);
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConInfoCmd)
 {
 	if (argc == 0) {
@@ -1908,6 +1958,211 @@ DEF_CONSOLE_CMD(ConFramerate)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConPathfinderStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show statistics about the pathfinder calls of each company. Usage: 'pf_stats [hist | reset]'");
+		IConsoleHelp("  'hist' also shows histograms of the nodes expanded and microseconds spent per call");
+		IConsoleHelp("  'reset' forgets all statistics gathered so far");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		ResetPathfinderStats();
+		IConsolePrint(CC_DEFAULT, "Pathfinder statistics reset.");
+		return true;
+	}
+
+	ConPrintPathfinderStats(argc == 2 && strcmp(argv[1], "hist") == 0);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConVehicleTickStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the time spent ticking the vehicles of each company and vehicle type. Usage: 'tick_stats [reset]'");
+		IConsoleHelp("  'reset' forgets all statistics gathered so far");
+		IConsoleHelp("  The vehicle ticks are only timed after this command was used once");
+		return true;
+	}
+
+	if (argc > 2) return false;
+	if (argc == 2 && strcmp(argv[1], "reset") != 0) return false;
+
+	if (!_vehicle_tick_stats_enabled) {
+		StartVehicleTickStats();
+		IConsolePrint(CC_DEFAULT, "Vehicle tick statistics are gathered from now on.");
+		return true;
+	}
+
+	if (argc == 2) {
+		ResetVehicleTickStats();
+		IConsolePrint(CC_DEFAULT, "Vehicle tick statistics reset.");
+		return true;
+	}
+
+	ConPrintVehicleTickStats();
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConMemoryStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the memory used by the pools and the major caches. Usage: 'mem_stats'");
+		IConsoleHelp("  Sizes are approximate: pooled items count with the size of their base class");
+		return true;
+	}
+
+	if (argc != 1) return false;
+
+	size_t total = 0;
+
+	IConsolePrint(CC_INFO, "Pools (items / room / maximum):");
+	const PoolVector *pools = PoolBase::GetPools();
+	for (PoolBase * const *ppool = pools->Begin(); ppool != pools->End(); ppool++) {
+		PoolMemoryUsage usage;
+		(*ppool)->GetMemoryUsage(&usage);
+		IConsolePrintF(CC_DEFAULT, "  %-20s " PRINTF_SIZE " / " PRINTF_SIZE " / " PRINTF_SIZE ", " PRINTF_SIZE " KiB",
+				usage.name, usage.items, usage.size, usage.max_size, usage.bytes / 1024);
+		total += usage.bytes;
+	}
+
+	IConsolePrint(CC_INFO, "Caches and other data:");
+
+	size_t map_bytes = (size_t)MapSize() * (sizeof(Tile) + sizeof(TileExtended));
+	IConsolePrintF(CC_DEFAULT, "  map arrays           %ux%u tiles, " PRINTF_SIZE " KiB", MapSizeX(), MapSizeY(), map_bytes / 1024);
+	total += map_bytes;
+
+	size_t sprite_used, sprite_total, sprite_high_water, sprite_index;
+	GetSpriteCacheUsage(&sprite_used, &sprite_total, &sprite_high_water, &sprite_index);
+	IConsolePrintF(CC_DEFAULT, "  sprite cache         " PRINTF_SIZE " KiB used of " PRINTF_SIZE " KiB, high water mark " PRINTF_SIZE " KiB",
+			sprite_used / 1024, sprite_total / 1024, sprite_high_water / 1024);
+	IConsolePrintF(CC_DEFAULT, "  sprite index         %u sprites, " PRINTF_SIZE " KiB", GetMaxSpriteID(), sprite_index / 1024);
+	total += sprite_total + sprite_index;
+
+	size_t lg_bytes = 0;
+	const LinkGraph *lg;
+	FOR_ALL_LINK_GRAPHS(lg) lg_bytes += lg->GetMemoryUsage();
+	size_t lgj_bytes = 0;
+	const LinkGraphJob *lgj;
+	FOR_ALL_LINK_GRAPH_JOBS(lgj) lgj_bytes += lgj->GetMemoryUsage();
+	IConsolePrintF(CC_DEFAULT, "  link graphs          " PRINTF_SIZE " KiB in nodes and edges, " PRINTF_SIZE " KiB in running jobs", lg_bytes / 1024, lgj_bytes / 1024);
+	total += lg_bytes + lgj_bytes;
+
+	size_t script_bytes = Squirrel::GetAllocatedMemory();
+	IConsolePrintF(CC_DEFAULT, "  script VMs           " PRINTF_SIZE " KiB", script_bytes / 1024);
+	total += script_bytes;
+
+	IConsolePrintF(CC_INFO, "Total: " PRINTF_SIZE " KiB", total / 1024);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConTrace)
+{
+	if (argc == 0) {
+		IConsoleHelp("Record a trace of the game loop phases, link graph jobs, saving and loading, pathfinder calls and scripts. Usage: 'trace start' or 'trace stop [<file>]'");
+		IConsoleHelp("  'stop' writes the trace to <file> in the personal directory, 'trace.json' by default; open it with chrome://tracing or Perfetto");
+		return true;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "start") == 0) {
+		if (!StartPerformanceTrace()) {
+			IConsoleError("A trace is running already.");
+			return true;
+		}
+		IConsolePrint(CC_DEFAULT, "Trace started.");
+		return true;
+	}
+
+	if ((argc == 2 || argc == 3) && strcmp(argv[1], "stop") == 0) {
+		const char *name = argc == 3 ? argv[2] : "trace.json";
+		if (strchr(name, PATHSEPCHAR) != NULL || strchr(name, '/') != NULL || strcmp(name, "..") == 0) {
+			IConsoleError("The file name must not contain a directory.");
+			return true;
+		}
+
+		char filename[MAX_PATH];
+		seprintf(filename, lastof(filename), "%s%s", _personal_dir, name);
+
+		uint events, dropped;
+		if (!StopPerformanceTrace(filename, &events, &dropped)) {
+			IConsoleError("No trace is running, or the trace could not be written.");
+			return true;
+		}
+		IConsolePrintF(CC_DEFAULT, "Trace with %u events written to '%s'.", events, filename);
+		if (dropped != 0) IConsolePrintF(CC_WARNING, "%u events did not fit in the trace and were dropped.", dropped);
+		return true;
+	}
+
+	return false;
+}
+
+DEF_CONSOLE_CMD(ConCallbackMemoStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show how often NewGRF callback results were memoised. Usage: 'callback_memo [reset]'");
+		IConsoleHelp("  'reset' forgets all memoised results and statistics");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	if (argc == 2) {
+		if (strcmp(argv[1], "reset") != 0) return false;
+		ClearCallbackMemo();
+		IConsolePrint(CC_DEFAULT, "Callback memo reset.");
+		return true;
+	}
+
+	const CallbackMemoStats &stats = _callback_memo_stats;
+	uint64 total = stats.hits + stats.stored + stats.uncacheable;
+	IConsolePrintF(CC_DEFAULT, "Callbacks resolved: " OTTD_PRINTF64, total);
+	IConsolePrintF(CC_DEFAULT, "  answered from memo: " OTTD_PRINTF64 " (%u%%)", stats.hits, total == 0 ? 0 : (uint)(stats.hits * 100 / total));
+	IConsolePrintF(CC_DEFAULT, "  stored in memo:     " OTTD_PRINTF64, stats.stored);
+	IConsolePrintF(CC_DEFAULT, "  depending on state: " OTTD_PRINTF64, stats.uncacheable);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConBenchmarkSpriteSorters)
+{
+	if (argc == 0) {
+		IConsoleHelp("Measure and compare the viewport sprite sorters. Usage: 'benchmark_sprite_sorters [<sprites> [<runs>]]'");
+		IConsoleHelp("  Sorts sprites of a densely built town, by default 5000 sprites 10 times");
+		return true;
+	}
+
+	if (argc > 3) return false;
+
+	uint32 count = 5000;
+	uint32 runs = 10;
+	if (argc > 1 && (!GetArgumentInteger(&count, argv[1]) || count == 0)) return false;
+	if (argc > 2 && (!GetArgumentInteger(&runs, argv[2]) || runs == 0)) return false;
+
+	BenchmarkSpriteSorters(count, runs);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConBenchmark)
+{
+	extern void RunMicrobenchmarks(uint scale); // benchmark.cpp
+
+	if (argc == 0) {
+		IConsoleHelp("Measure core data structures, save filters, blitters and string formatting on synthetic data. Usage: 'benchmark [<scale>]'");
+		IConsoleHelp("  Reports the time per operation; <scale> (1 to 64) multiplies the number of operations");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint32 scale = 1;
+	if (argc > 1 && (!GetArgumentInteger(&scale, argv[1]) || scale == 0)) return false;
+
+	RunMicrobenchmarks(scale);
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConFramerateWindow)
 {
 	extern void ShowFramerateWindow();
@@ -1946,11 +2201,13 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("restart",      ConRestart);
 	IConsoleCmdRegister("getseed",      ConGetSeed);
 	IConsoleCmdRegister("getdate",      ConGetDate);
+	IConsoleCmdRegister("vehicle_hash", ConVehicleHash);
 	IConsoleCmdRegister("quit",         ConExit);
 	IConsoleCmdRegister("resetengines", ConResetEngines, ConHookNoNetwork);
 	IConsoleCmdRegister("reset_enginepool", ConResetEnginePool, ConHookNoNetwork);
 	IConsoleCmdRegister("return",       ConReturn);
 	IConsoleCmdRegister("screenshot",   ConScreenShot);
+	IConsoleCmdRegister("minimap",      ConMinimap);
 	IConsoleCmdRegister("script",       ConScript);
 	IConsoleCmdRegister("scrollto",     ConScrollToTile);
 	IConsoleCmdRegister("alias",        ConAlias);
@@ -2058,6 +2315,13 @@ void IConsoleStdLibRegister()
 #endif
 	IConsoleCmdRegister("fps",     ConFramerate);
 	IConsoleCmdRegister("fps_wnd", ConFramerateWindow);
+	IConsoleCmdRegister("pf_stats", ConPathfinderStats);
+	IConsoleCmdRegister("tick_stats", ConVehicleTickStats);
+	IConsoleCmdRegister("mem_stats", ConMemoryStats);
+	IConsoleCmdRegister("trace", ConTrace);
+	IConsoleCmdRegister("callback_memo", ConCallbackMemoStats);
+	IConsoleCmdRegister("benchmark_sprite_sorters", ConBenchmarkSpriteSorters);
+	IConsoleCmdRegister("benchmark", ConBenchmark);
 
 	/* NewGRF development stuff */
 	IConsoleCmdRegister("reload_newgrfs",  ConNewGRFReload, ConHookNewGRFDeveloperTool);
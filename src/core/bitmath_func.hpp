@@ -227,6 +227,21 @@ static inline uint8 FindFirstBit2x64(const int value)
 uint8 FindFirstBit(uint32 x);
 uint8 FindLastBit(uint64 x);
 
+/**
+ * Search the first set bit in a 64 bit variable.
+ * @param x The value to search
+ * @return The position of the first bit set, or 0 if x is 0.
+ */
+static inline uint8 FindFirstBit64(uint64 x)
+{
+	if (x == 0) return 0;
+#if !defined(__ICC) && defined(__GNUC__)
+	return (uint8)__builtin_ctzll(x);
+#else
+	return (uint32)x != 0 ? FindFirstBit((uint32)x) : FindFirstBit((uint32)(x >> 32)) + 32;
+#endif
+}
+
 /**
  * Clear the first bit in an integer.
  *
@@ -0,0 +1,147 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file flatdeque_type.hpp Queue in one contiguous block of memory. */
+
+#ifndef FLATDEQUE_TYPE_HPP
+#define FLATDEQUE_TYPE_HPP
+
+#include <vector>
+
+/**
+ * Queue of items in one contiguous block of memory. Items are added at the
+ * back and are usually removed from the front, which only moves the start
+ * of the used part of the block. The unused part in front is reclaimed when
+ * it gets as large as the used part. Unlike a list, no memory is allocated
+ * for every item, and going over the items touches as little memory as
+ * possible.
+ *
+ * Adding items invalidates all iterators; removing the first item only
+ * invalidates iterators to that item.
+ * @tparam T Type of the items.
+ */
+template <typename T>
+class FlatDeque {
+protected:
+	typedef std::vector<T> Storage;
+
+	Storage items; ///< The items; the ones before #first are not used anymore.
+	size_t first;  ///< Index of the first used item in #items.
+
+public:
+	typedef T value_type;
+	typedef typename Storage::iterator iterator;
+	typedef typename Storage::const_iterator const_iterator;
+	typedef typename Storage::reverse_iterator reverse_iterator;
+	typedef typename Storage::const_reverse_iterator const_reverse_iterator;
+
+	FlatDeque() : first(0) {}
+
+	inline iterator begin() { return this->items.begin() + this->first; }
+	inline const_iterator begin() const { return this->items.begin() + this->first; }
+	inline iterator end() { return this->items.end(); }
+	inline const_iterator end() const { return this->items.end(); }
+	inline reverse_iterator rbegin() { return this->items.rbegin(); }
+	inline const_reverse_iterator rbegin() const { return this->items.rbegin(); }
+	inline reverse_iterator rend() { return reverse_iterator(this->begin()); }
+	inline const_reverse_iterator rend() const { return const_reverse_iterator(this->begin()); }
+
+	inline bool empty() const { return this->first == this->items.size(); }
+	inline size_t size() const { return this->items.size() - this->first; }
+
+	inline T &front() { return this->items[this->first]; }
+	inline const T &front() const { return this->items[this->first]; }
+	inline T &back() { return this->items.back(); }
+	inline const T &back() const { return this->items.back(); }
+
+	/**
+	 * Add an item at the back.
+	 * @param item The item.
+	 */
+	void push_back(const T &item)
+	{
+		if (this->first > 0 && this->first * 2 >= this->items.size()) {
+			/* Reclaim the space of the removed items before growing. */
+			this->items.erase(this->items.begin(), this->items.begin() + this->first);
+			this->first = 0;
+		}
+		this->items.push_back(item);
+	}
+
+	/**
+	 * Remove the first item.
+	 * @pre !this->empty()
+	 */
+	void pop_front()
+	{
+		assert(!this->empty());
+		if (++this->first == this->items.size()) this->clear();
+	}
+
+	/**
+	 * Remove an item.
+	 * @param it Iterator to the item.
+	 * @return Iterator to the item after the removed one.
+	 */
+	iterator erase(iterator it)
+	{
+		if (it == this->begin()) {
+			this->pop_front();
+			return this->begin();
+		}
+		return this->items.erase(it);
+	}
+
+	/**
+	 * Remove a range of items.
+	 * @param from Iterator to the first item to remove.
+	 * @param to Iterator to the item after the last one to remove.
+	 * @return Iterator to the item after the removed ones.
+	 */
+	iterator erase(iterator from, iterator to)
+	{
+		if (from == this->begin()) {
+			this->first += to - from;
+			if (this->empty()) this->clear();
+			return this->begin();
+		}
+		return this->items.erase(from, to);
+	}
+
+	/**
+	 * Replace the contents by a copy of a range of items.
+	 * @param from Iterator to the first item to copy.
+	 * @param to Iterator to the item after the last one to copy.
+	 */
+	template <typename Titer>
+	void assign(Titer from, Titer to)
+	{
+		this->items.assign(from, to);
+		this->first = 0;
+	}
+
+	/** Remove all items and release the memory. */
+	void clear()
+	{
+		Storage().swap(this->items);
+		this->first = 0;
+	}
+
+	/**
+	 * Swap the contents with another queue.
+	 * @param other The other queue.
+	 */
+	void swap(FlatDeque &other)
+	{
+		this->items.swap(other.items);
+		std::swap(this->first, other.first);
+	}
+};
+
+#endif /* FLATDEQUE_TYPE_HPP */
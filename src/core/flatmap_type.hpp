@@ -0,0 +1,183 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file flatmap_type.hpp Sorted map in one contiguous block of memory. */
+
+#ifndef FLATMAP_TYPE_HPP
+#define FLATMAP_TYPE_HPP
+
+#include <vector>
+#include <algorithm>
+
+/**
+ * Map of keys to values, kept as a vector of pairs sorted by key. It offers
+ * the parts of the std::map interface needed for small maps that are looked
+ * up and iterated much more often than they are changed. Lookups are binary
+ * searches over one block of memory and no memory is allocated for every
+ * item. Appending items with increasing keys is cheap; inserting in the
+ * middle moves all items behind.
+ *
+ * Unlike std::map, inserting or erasing items invalidates all iterators to
+ * items behind the changed position, and the key of an item can be changed
+ * through an iterator. Don't do that.
+ * @tparam Tkey   Type of the keys.
+ * @tparam Tvalue Type of the values.
+ */
+template <typename Tkey, typename Tvalue>
+class FlatMap {
+public:
+	typedef Tkey key_type;
+	typedef Tvalue mapped_type;
+	typedef std::pair<Tkey, Tvalue> value_type;
+
+protected:
+	typedef std::vector<value_type> Storage;
+
+	Storage items; ///< The items, sorted by key.
+
+	/** Comparator ordering items by key. */
+	struct KeyLess {
+		inline bool operator()(const value_type &a, const Tkey &b) const { return a.first < b; }
+		inline bool operator()(const Tkey &a, const value_type &b) const { return a < b.first; }
+		inline bool operator()(const value_type &a, const value_type &b) const { return a.first < b.first; }
+	};
+
+public:
+	typedef typename Storage::iterator iterator;
+	typedef typename Storage::const_iterator const_iterator;
+	typedef typename Storage::reverse_iterator reverse_iterator;
+	typedef typename Storage::const_reverse_iterator const_reverse_iterator;
+
+	inline iterator begin() { return this->items.begin(); }
+	inline const_iterator begin() const { return this->items.begin(); }
+	inline iterator end() { return this->items.end(); }
+	inline const_iterator end() const { return this->items.end(); }
+	inline reverse_iterator rbegin() { return this->items.rbegin(); }
+	inline const_reverse_iterator rbegin() const { return this->items.rbegin(); }
+	inline reverse_iterator rend() { return this->items.rend(); }
+	inline const_reverse_iterator rend() const { return this->items.rend(); }
+
+	inline bool empty() const { return this->items.empty(); }
+	inline size_t size() const { return this->items.size(); }
+
+	/**
+	 * Get the first item with a key not less than the given one.
+	 * @param key Key to look for.
+	 * @return Iterator to the item or end().
+	 */
+	inline iterator lower_bound(const Tkey &key) { return std::lower_bound(this->items.begin(), this->items.end(), key, KeyLess()); }
+	inline const_iterator lower_bound(const Tkey &key) const { return std::lower_bound(this->items.begin(), this->items.end(), key, KeyLess()); }
+
+	/**
+	 * Get the first item with a key greater than the given one.
+	 * @param key Key to look for.
+	 * @return Iterator to the item or end().
+	 */
+	inline iterator upper_bound(const Tkey &key) { return std::upper_bound(this->items.begin(), this->items.end(), key, KeyLess()); }
+	inline const_iterator upper_bound(const Tkey &key) const { return std::upper_bound(this->items.begin(), this->items.end(), key, KeyLess()); }
+
+	/**
+	 * Find the item with the given key.
+	 * @param key Key to look for.
+	 * @return Iterator to the item or end() if there is none.
+	 */
+	inline iterator find(const Tkey &key)
+	{
+		iterator it = this->lower_bound(key);
+		return (it != this->items.end() && !(key < it->first)) ? it : this->items.end();
+	}
+
+	inline const_iterator find(const Tkey &key) const
+	{
+		const_iterator it = this->lower_bound(key);
+		return (it != this->items.end() && !(key < it->first)) ? it : this->items.end();
+	}
+
+	/**
+	 * Insert an item, unless there is one with the same key already.
+	 * @param item Item to insert.
+	 * @return Iterator to the item with the key, and whether it was inserted.
+	 */
+	std::pair<iterator, bool> insert(const value_type &item)
+	{
+		if (this->items.empty() || this->items.back().first < item.first) {
+			/* Fast path for appending in order. */
+			this->items.push_back(item);
+			return std::make_pair(this->items.end() - 1, true);
+		}
+		iterator it = this->lower_bound(item.first);
+		if (it != this->items.end() && !(item.first < it->first)) return std::make_pair(it, false);
+		return std::make_pair(this->items.insert(it, item), true);
+	}
+
+	/**
+	 * Insert a range of items; items with keys already in the map are skipped.
+	 * @param from Iterator to the first item to insert.
+	 * @param to Iterator to the item after the last one to insert.
+	 */
+	template <typename Titer>
+	void insert(Titer from, Titer to)
+	{
+		size_t old_size = this->items.size();
+		this->items.insert(this->items.end(), from, to);
+		if (this->items.size() == old_size) return;
+		/* Sort stably so that for equal keys the item present before comes first and is kept. */
+		std::stable_sort(this->items.begin(), this->items.end(), KeyLess());
+		this->items.erase(std::unique(this->items.begin(), this->items.end(),
+				[](const value_type &a, const value_type &b) { return !(a.first < b.first) && !(b.first < a.first); }),
+				this->items.end());
+	}
+
+	/**
+	 * Get the value for a key, inserting a default constructed value if there is none.
+	 * @param key Key to look for.
+	 * @return Reference to the value.
+	 */
+	Tvalue &operator[](const Tkey &key)
+	{
+		return this->insert(value_type(key, Tvalue())).first->second;
+	}
+
+	/**
+	 * Remove an item.
+	 * @param it Iterator to the item.
+	 * @return Iterator to the item after the removed one.
+	 */
+	inline iterator erase(iterator it) { return this->items.erase(it); }
+
+	/**
+	 * Remove the item with the given key, if there is one.
+	 * @param key Key of the item.
+	 * @return Number of items removed.
+	 */
+	size_t erase(const Tkey &key)
+	{
+		iterator it = this->find(key);
+		if (it == this->items.end()) return 0;
+		this->items.erase(it);
+		return 1;
+	}
+
+	/**
+	 * Reserve memory for a number of items.
+	 * @param count Number of items.
+	 */
+	inline void reserve(size_t count) { this->items.reserve(count); }
+
+	/** Remove all items. */
+	inline void clear() { this->items.clear(); }
+
+	/**
+	 * Swap the contents with another map.
+	 * @param other The other map.
+	 */
+	inline void swap(FlatMap &other) { this->items.swap(other.items); }
+};
+
+#endif /* FLATMAP_TYPE_HPP */
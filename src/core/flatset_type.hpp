@@ -0,0 +1,140 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file flatset_type.hpp Sorted set in one contiguous block of memory. */
+
+#ifndef FLATSET_TYPE_HPP
+#define FLATSET_TYPE_HPP
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+/**
+ * Set of keys, kept as a sorted vector. It offers the parts of the std::set
+ * interface needed for small sets that are iterated much more often than they
+ * are changed, like the lists of stations near towns and industries.
+ * Iterating visits one block of memory instead of chasing tree nodes.
+ *
+ * Unlike std::set, inserting or erasing keys invalidates all iterators to
+ * keys behind the changed position.
+ * @tparam Tkey     Type of the keys.
+ * @tparam Tcompare Comparator ordering the keys.
+ * @see FlatMap
+ */
+template <typename Tkey, typename Tcompare = std::less<Tkey> >
+class FlatSet {
+public:
+	typedef Tkey key_type;
+	typedef Tkey value_type;
+
+protected:
+	typedef std::vector<Tkey> Storage;
+
+	Storage items; ///< The keys, sorted by #Tcompare.
+
+	/**
+	 * Check whether two keys are equivalent.
+	 * @param a First key.
+	 * @param b Second key.
+	 * @return True if neither key orders before the other.
+	 */
+	static inline bool Equivalent(const Tkey &a, const Tkey &b) { return !Tcompare()(a, b) && !Tcompare()(b, a); }
+
+public:
+	/* Keys may not be changed through iterators, as with std::set. */
+	typedef typename Storage::const_iterator iterator;
+	typedef typename Storage::const_iterator const_iterator;
+
+	inline const_iterator begin() const { return this->items.begin(); }
+	inline const_iterator end() const { return this->items.end(); }
+
+	inline bool empty() const { return this->items.empty(); }
+	inline size_t size() const { return this->items.size(); }
+
+	/**
+	 * Find a key.
+	 * @param key Key to look for.
+	 * @return Iterator to the key or end() if it is not in the set.
+	 */
+	const_iterator find(const Tkey &key) const
+	{
+		const_iterator it = std::lower_bound(this->items.begin(), this->items.end(), key, Tcompare());
+		return (it != this->items.end() && !Tcompare()(key, *it)) ? it : this->items.end();
+	}
+
+	/**
+	 * Insert a key, unless it is in the set already.
+	 * @param key Key to insert.
+	 * @return Iterator to the key, and whether it was inserted.
+	 */
+	std::pair<iterator, bool> insert(const Tkey &key)
+	{
+		if (this->items.empty() || Tcompare()(this->items.back(), key)) {
+			/* Fast path for appending in order. */
+			this->items.push_back(key);
+			return std::make_pair(const_iterator(this->items.end() - 1), true);
+		}
+		typename Storage::iterator it = std::lower_bound(this->items.begin(), this->items.end(), key, Tcompare());
+		if (it != this->items.end() && !Tcompare()(key, *it)) return std::make_pair(const_iterator(it), false);
+		return std::make_pair(const_iterator(this->items.insert(it, key)), true);
+	}
+
+	/**
+	 * Insert a range of keys; keys already in the set are skipped.
+	 * @param from Iterator to the first key to insert.
+	 * @param to Iterator to the key after the last one to insert.
+	 */
+	template <typename Titer>
+	void insert(Titer from, Titer to)
+	{
+		size_t old_size = this->items.size();
+		this->items.insert(this->items.end(), from, to);
+		if (this->items.size() == old_size) return;
+		std::sort(this->items.begin(), this->items.end(), Tcompare());
+		this->items.erase(std::unique(this->items.begin(), this->items.end(), &FlatSet::Equivalent), this->items.end());
+	}
+
+	/**
+	 * Remove a key.
+	 * @param it Iterator to the key.
+	 * @return Iterator to the key after the removed one.
+	 */
+	inline iterator erase(const_iterator it) { return this->items.erase(this->items.begin() + (it - this->items.begin())); }
+
+	/**
+	 * Remove a key, if it is in the set.
+	 * @param key The key.
+	 * @return Number of keys removed.
+	 */
+	size_t erase(const Tkey &key)
+	{
+		const_iterator it = this->find(key);
+		if (it == this->items.end()) return 0;
+		this->erase(it);
+		return 1;
+	}
+
+	/**
+	 * Reserve memory for a number of keys.
+	 * @param count Number of keys.
+	 */
+	inline void reserve(size_t count) { this->items.reserve(count); }
+
+	/** Remove all keys. */
+	inline void clear() { this->items.clear(); }
+
+	/**
+	 * Swap the contents with another set.
+	 * @param other The other set.
+	 */
+	inline void swap(FlatSet &other) { this->items.swap(other.items); }
+};
+
+#endif /* FLATSET_TYPE_HPP */
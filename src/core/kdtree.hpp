@@ -29,6 +29,9 @@
  *
  * The element type T must be less-than comparable for FindNearest to work.
  *
+ * The coordinates of an element are extracted once, when it is added to the tree, and stored
+ * alongside it. The coordinates of an element must therefore not change while it is in the tree.
+ *
  * @tparam T       Type stored in the tree, should be cheap to copy.
  * @tparam TxyFunc Functor type to extract coordinate from a T value and dimension index (0 or 1).
  * @tparam CoordT  Type of coordinate values extracted via TxyFunc.
@@ -39,10 +42,11 @@ class Kdtree {
 	/** Type of a node in the tree */
 	struct node {
 		T      element;  ///< Element stored at node
+		CoordT xy[2];    ///< Coordinates of the element
 		size_t left;     ///< Index of node to the left, INVALID_NODE if none
 		size_t right;    ///< Index of node to the right, INVALID_NODE if none
 
-		node(T element) : element(element), left(INVALID_NODE), right(INVALID_NODE) { }
+		node(T element, CoordT x, CoordT y) : element(element), xy{ x, y }, left(INVALID_NODE), right(INVALID_NODE) { }
 	};
 
 	static const size_t INVALID_NODE = SIZE_MAX; ///< Index value indicating no-such-node
@@ -53,32 +57,40 @@ class Kdtree {
 	TxyFunc xyfunc;                ///< Functor to extract a coordinate from an element
 	size_t unbalanced;             ///< Number approximating how unbalanced the tree might be
 
-	/** Create one new node in the tree, return its index in the pool */
-	size_t AddNode(const T &element)
+	/** Iterator over a collection of detached nodes */
+	typedef typename std::vector<node>::iterator NodeIterator;
+
+	/** Create a detached node for an element, extracting its coordinates */
+	node MakeNode(const T &element) const
+	{
+		return node(element, this->xyfunc(element, 0), this->xyfunc(element, 1));
+	}
+
+	/** Create one new node in the tree from a detached node, return its index in the pool */
+	size_t AddNode(const node &entry)
 	{
 		if (this->free_list.size() == 0) {
-			this->nodes.emplace_back(element);
+			this->nodes.emplace_back(entry.element, entry.xy[0], entry.xy[1]);
 			return this->nodes.size() - 1;
 		} else {
 			size_t newidx = this->free_list.back();
 			this->free_list.pop_back();
-			this->nodes[newidx] = node{ element };
+			this->nodes[newidx] = node(entry.element, entry.xy[0], entry.xy[1]);
 			return newidx;
 		}
 	}
 
-	/** Find a coordinate value to split a range of elements at */
-	template <typename It>
-	CoordT SelectSplitCoord(It begin, It end, int level)
+	/** Find a coordinate value to split a range of detached nodes at */
+	CoordT SelectSplitCoord(NodeIterator begin, NodeIterator end, int level)
 	{
-		It mid = begin + (end - begin) / 2;
-		std::nth_element(begin, mid, end, [&](T a, T b) { return this->xyfunc(a, level % 2) < this->xyfunc(b, level % 2); });
-		return this->xyfunc(*mid, level % 2);
+		int dim = level % 2;
+		NodeIterator mid = begin + (end - begin) / 2;
+		std::nth_element(begin, mid, end, [dim](const node &a, const node &b) { return a.xy[dim] < b.xy[dim]; });
+		return mid->xy[dim];
 	}
 
-	/** Construct a subtree from elements between begin and end iterators, return index of root */
-	template <typename It>
-	size_t BuildSubtree(It begin, It end, int level)
+	/** Construct a subtree from detached nodes between begin and end iterators, return index of root */
+	size_t BuildSubtree(NodeIterator begin, NodeIterator end, int level)
 	{
 		ptrdiff_t count = end - begin;
 
@@ -87,8 +99,9 @@ class Kdtree {
 		} else if (count == 1) {
 			return this->AddNode(*begin);
 		} else if (count > 1) {
+			int dim = level % 2;
 			CoordT split_coord = SelectSplitCoord(begin, end, level);
-			It split = std::partition(begin, end, [&](T v) { return this->xyfunc(v, level % 2) < split_coord; });
+			NodeIterator split = std::partition(begin, end, [dim, split_coord](const node &v) { return v.xy[dim] < split_coord; });
 			size_t newidx = this->AddNode(*split);
 			this->nodes[newidx].left = this->BuildSubtree(begin, split, level + 1);
 			this->nodes[newidx].right = this->BuildSubtree(split + 1, end, level + 1);
@@ -104,27 +117,28 @@ class Kdtree {
 		size_t initial_count = this->Count();
 		if (initial_count < 8) return false; // arbitrary value for "not worth rebalancing"
 
-		T root_element = this->nodes[this->root].element;
-		std::vector<T> elements = this->FreeSubtree(this->root);
-		elements.push_back(root_element);
+		node root_entry = this->nodes[this->root];
+		std::vector<node> entries = this->FreeSubtree(this->root);
+		entries.push_back(root_entry);
 
 		if (include_element != NULL) {
-			elements.push_back(*include_element);
+			entries.push_back(this->MakeNode(*include_element));
 			initial_count++;
 		}
 		if (exclude_element != NULL) {
-			typename std::vector<T>::iterator removed = std::remove(elements.begin(), elements.end(), *exclude_element);
-			elements.erase(removed, elements.end());
+			const T &excluded = *exclude_element;
+			NodeIterator removed = std::remove_if(entries.begin(), entries.end(), [&excluded](const node &n) { return n.element == excluded; });
+			entries.erase(removed, entries.end());
 			initial_count--;
 		}
 
-		this->Build(elements.begin(), elements.end());
+		this->BuildFromNodes(entries);
 		assert(initial_count == this->Count());
 		return true;
 	}
 
 	/** Insert one element in the tree somewhere below node_idx */
-	void InsertRecursive(const T &element, size_t node_idx, int level)
+	void InsertRecursive(const node &element, size_t node_idx, int level)
 	{
 		/* Dimension index of current level */
 		int dim = level % 2;
@@ -132,9 +146,9 @@ class Kdtree {
 		node &n = this->nodes[node_idx];
 
 		/* Coordinate of element splitting at this node */
-		CoordT nc = this->xyfunc(n.element, dim);
+		CoordT nc = n.xy[dim];
 		/* Coordinate of the new element */
-		CoordT ec = this->xyfunc(element, dim);
+		CoordT ec = element.xy[dim];
 		/* Which side to insert on */
 		size_t &next = (ec < nc) ? n.left : n.right;
 
@@ -151,11 +165,11 @@ class Kdtree {
 
 	/**
 	 * Free all children of the given node
-	 * @return Collection of elements that were removed from tree.
+	 * @return Collection of detached nodes of the elements that were removed from tree.
 	 */
-	std::vector<T> FreeSubtree(size_t node_idx)
+	std::vector<node> FreeSubtree(size_t node_idx)
 	{
-		std::vector<T> subtree_elements;
+		std::vector<node> subtree_elements;
 		node &n = this->nodes[node_idx];
 
 		/* We'll be appending items to the free_list, get index of our first item */
@@ -168,7 +182,7 @@ class Kdtree {
 		/* Recursively free the nodes being collected */
 		for (size_t i = first_free; i < this->free_list.size(); i++) {
 			node &fn = this->nodes[this->free_list[i]];
-			subtree_elements.push_back(fn.element);
+			subtree_elements.push_back(fn);
 			if (fn.left != INVALID_NODE) this->free_list.push_back(fn.left);
 			if (fn.right != INVALID_NODE) this->free_list.push_back(fn.right);
 			fn.left = fn.right = INVALID_NODE;
@@ -197,7 +211,7 @@ class Kdtree {
 				return INVALID_NODE;
 			} else {
 				/* Complex case, rebuild the sub-tree */
-				std::vector<T> subtree_elements = this->FreeSubtree(node_idx);
+				std::vector<node> subtree_elements = this->FreeSubtree(node_idx);
 				return this->BuildSubtree(subtree_elements.begin(), subtree_elements.end(), level);;
 			}
 		} else {
@@ -205,7 +219,7 @@ class Kdtree {
 			/* Dimension index of current level */
 			int dim = level % 2;
 			/* Coordinate of element splitting at this node */
-			CoordT nc = this->xyfunc(n.element, dim);
+			CoordT nc = n.xy[dim];
 			/* Coordinate of the element being removed */
 			CoordT ec = this->xyfunc(element, dim);
 			/* Which side to remove from */
@@ -223,9 +237,9 @@ class Kdtree {
 	}
 
 
-	DistT ManhattanDistance(const T &element, CoordT x, CoordT y) const
+	DistT ManhattanDistance(const node &n, CoordT x, CoordT y) const
 	{
-		return abs((DistT)this->xyfunc(element, 0) - (DistT)x) + abs((DistT)this->xyfunc(element, 1) - (DistT)y);
+		return abs((DistT)n.xy[0] - (DistT)x) + abs((DistT)n.xy[1] - (DistT)y);
 	}
 
 	/** A data element and its distance to a searched-for point */
@@ -248,9 +262,9 @@ class Kdtree {
 		const node &n = this->nodes[node_idx];
 
 		/* Coordinate of element splitting at this node */
-		CoordT c = this->xyfunc(n.element, dim);
+		CoordT c = n.xy[dim];
 		/* This node's distance to target */
-		DistT thisdist = ManhattanDistance(n.element, xy[0], xy[1]);
+		DistT thisdist = ManhattanDistance(n, xy[0], xy[1]);
 		/* Assume this node is the best choice for now */
 		node_distance best = std::make_pair(n.element, thisdist);
 
@@ -272,8 +286,46 @@ class Kdtree {
 		return best;
 	}
 
-	template <typename Outputter>
-	void FindContainedRecursive(CoordT p1[2], CoordT p2[2], size_t node_idx, int level, Outputter outputter) const
+	/**
+	 * Search a sub-tree for the element nearest to a given point that is accepted by a filter.
+	 * @param xy     The point to search around.
+	 * @param node_idx The root of the sub-tree.
+	 * @param level  The depth of the sub-tree's root.
+	 * @param filter Predicate taking an element, returning whether it may be found.
+	 * @param best   The best element found so far; its distance limits the search.
+	 * @param found  Whether \a best holds an element, or only the initial distance limit.
+	 */
+	template <typename Filter>
+	void FindNearestRecursive(CoordT xy[2], size_t node_idx, int level, Filter &filter, node_distance &best, bool &found) const
+	{
+		/* Dimension index of current level */
+		int dim = level % 2;
+		/* Node reference */
+		const node &n = this->nodes[node_idx];
+
+		/* Coordinate of element splitting at this node */
+		CoordT c = n.xy[dim];
+		/* This node's distance to target */
+		DistT thisdist = ManhattanDistance(n, xy[0], xy[1]);
+		/* Only ask the filter about elements that would improve the result */
+		if ((thisdist < best.second || (found && thisdist == best.second && n.element < best.first)) && filter(n.element)) {
+			best = std::make_pair(n.element, thisdist);
+			found = true;
+		}
+
+		/* Next node to visit */
+		size_t next = (xy[dim] < c) ? n.left : n.right;
+		if (next != INVALID_NODE) this->FindNearestRecursive(xy, next, level + 1, filter, best, found);
+
+		/* Only visit the other side of the split if it can contain an element at least as near as the current best. */
+		size_t opposite = (xy[dim] >= c) ? n.left : n.right; // reverse of above
+		if (opposite != INVALID_NODE && best.second >= abs((int)xy[dim] - (int)c)) {
+			this->FindNearestRecursive(xy, opposite, level + 1, filter, best, found);
+		}
+	}
+
+	template <typename Filter, typename Outputter>
+	void FindContainedRecursive(CoordT p1[2], CoordT p2[2], size_t node_idx, int level, Filter &filter, Outputter &outputter) const
 	{
 		/* Dimension index of current level */
 		int dim = level % 2;
@@ -281,18 +333,18 @@ class Kdtree {
 		const node &n = this->nodes[node_idx];
 
 		/* Coordinate of element splitting at this node */
-		CoordT ec = this->xyfunc(n.element, dim);
+		CoordT ec = n.xy[dim];
 		/* Opposite coordinate of element */
-		CoordT oc = this->xyfunc(n.element, 1 - dim);
+		CoordT oc = n.xy[1 - dim];
 
-		/* Test if this element is within rectangle */
-		if (ec >= p1[dim] && ec < p2[dim] && oc >= p1[1 - dim] && oc < p2[1 - dim]) outputter(n.element);
+		/* Test if this element is within rectangle and accepted by the filter */
+		if (ec >= p1[dim] && ec < p2[dim] && oc >= p1[1 - dim] && oc < p2[1 - dim] && filter(n.xy[0], n.xy[1])) outputter(n.element);
 
 		/* Recurse left if part of rectangle is left of split */
-		if (p1[dim] < ec && n.left != INVALID_NODE) this->FindContainedRecursive(p1, p2, n.left, level + 1, outputter);
+		if (p1[dim] < ec && n.left != INVALID_NODE) this->FindContainedRecursive(p1, p2, n.left, level + 1, filter, outputter);
 
 		/* Recurse right if part of rectangle is right of split */
-		if (p2[dim] > ec && n.right != INVALID_NODE) this->FindContainedRecursive(p1, p2, n.right, level + 1, outputter);
+		if (p2[dim] > ec && n.right != INVALID_NODE) this->FindContainedRecursive(p1, p2, n.right, level + 1, filter, outputter);
 	}
 
 	/** Debugging function, counts number of occurrences of an element regardless of its correct position in the tree */
@@ -322,8 +374,11 @@ class Kdtree {
 		if (node_idx == INVALID_NODE) return;
 
 		const node &n = this->nodes[node_idx];
-		CoordT cx = this->xyfunc(n.element, 0);
-		CoordT cy = this->xyfunc(n.element, 1);
+		CoordT cx = n.xy[0];
+		CoordT cy = n.xy[1];
+
+		assert(cx == this->xyfunc(n.element, 0));
+		assert(cy == this->xyfunc(n.element, 1));
 
 		assert(cx >= min_x);
 		assert(cx < max_x);
@@ -349,12 +404,41 @@ class Kdtree {
 #endif
 	}
 
+	/** Clear and rebuild the tree from a collection of detached nodes, which gets reordered */
+	void BuildFromNodes(std::vector<node> &entries)
+	{
+		this->nodes.clear();
+		this->free_list.clear();
+		this->unbalanced = 0;
+		this->root = INVALID_NODE;
+		if (entries.empty()) return;
+		this->nodes.reserve(entries.size());
+
+		this->root = this->BuildSubtree(entries.begin(), entries.end(), 0);
+		CheckInvariant();
+	}
+
 public:
 	/** Construct a new Kdtree with the given xyfunc */
 	Kdtree(TxyFunc xyfunc) : root(INVALID_NODE), xyfunc(xyfunc), unbalanced(0) { }
 
+	/**
+	 * Construct a new Kdtree with the given xyfunc, and fill it with a sequence of elements.
+	 * This is cheaper than inserting the elements one by one, and results in a balanced tree.
+	 * @tparam It      Iterator type for element sequence.
+	 * @param  xyfunc  Functor to extract a coordinate from an element.
+	 * @param  begin   First element in sequence.
+	 * @param  end     One past last element in sequence.
+	 */
+	template <typename It>
+	Kdtree(TxyFunc xyfunc, It begin, It end) : root(INVALID_NODE), xyfunc(xyfunc), unbalanced(0)
+	{
+		this->Build(begin, end);
+	}
+
 	/**
 	 * Clear and rebuild the tree from a new sequence of elements,
+	 * The coordinates of every element are extracted exactly once.
 	 * @tparam It    Iterator type for element sequence.
 	 * @param  begin First element in sequence.
 	 * @param  end   One past last element in sequence.
@@ -362,14 +446,11 @@ public:
 	template <typename It>
 	void Build(It begin, It end)
 	{
-		this->nodes.clear();
-		this->free_list.clear();
-		this->unbalanced = 0;
-		if (begin == end) return;
-		this->nodes.reserve(end - begin);
+		std::vector<node> entries;
+		entries.reserve(end - begin);
+		for (It it = begin; it != end; ++it) entries.push_back(this->MakeNode(*it));
 
-		this->root = this->BuildSubtree(begin, end, 0);
-		CheckInvariant();
+		this->BuildFromNodes(entries);
 	}
 
 	/**
@@ -388,10 +469,10 @@ public:
 	void Insert(const T &element)
 	{
 		if (this->Count() == 0) {
-			this->root = this->AddNode(element);
+			this->root = this->AddNode(this->MakeNode(element));
 		} else {
 			if (!this->IsUnbalanced() || !this->Rebuild(&element, NULL)) {
-				this->InsertRecursive(element, this->root, 0);
+				this->InsertRecursive(this->MakeNode(element), this->root, 0);
 				this->IncrementUnbalanced();
 			}
 			CheckInvariant();
@@ -436,6 +517,32 @@ public:
 		return this->FindNearestRecursive(xy, this->root, 0).first;
 	}
 
+	/**
+	 * Find the element closest to given coordinate, in Manhattan distance, that is accepted by a filter
+	 * and nearer than a given distance.
+	 * For multiple elements with the same distance, the one comparing smaller with
+	 * a less-than comparison is chosen.
+	 * The filter is only asked about elements that are nearer than the best element found so far.
+	 * @param x      First coordinate of the point to search around.
+	 * @param y      Second coordinate of the point to search around.
+	 * @param limit  Elements at this distance or further away are not found.
+	 * @param filter Predicate taking an element, returning whether it may be found.
+	 * @param[out] result The element found, untouched if none was found.
+	 * @return Whether an element was found.
+	 */
+	template <typename Filter>
+	bool FindNearest(CoordT x, CoordT y, DistT limit, Filter filter, T *result) const
+	{
+		if (this->Count() == 0) return false;
+
+		CoordT xy[2] = { x, y };
+		node_distance best = std::make_pair(T(), limit);
+		bool found = false;
+		this->FindNearestRecursive(xy, this->root, 0, filter, best, found);
+		if (found) *result = best.first;
+		return found;
+	}
+
 	/**
 	* Find all items contained within the given rectangle.
 	* @note Start coordinates are inclusive, end coordinates are exclusive. x1<x2 && y1<y2 is a precondition.
@@ -447,6 +554,24 @@ public:
 	*/
 	template <typename Outputter>
 	void FindContained(CoordT x1, CoordT y1, CoordT x2, CoordT y2, Outputter outputter) const
+	{
+		this->FindContained(x1, y1, x2, y2, [](CoordT, CoordT) { return true; }, outputter);
+	}
+
+	/**
+	 * Find all items contained within the given rectangle, whose coordinates are accepted by a filter.
+	 * The filter is evaluated on the coordinates stored in the tree, so elements that are rejected
+	 * by it never have to be looked at by the caller.
+	 * @note Start coordinates are inclusive, end coordinates are exclusive. x1<x2 && y1<y2 is a precondition.
+	 * @param x1 Start first coordinate, points found are greater or equals to this.
+	 * @param y1 Start second coordinate, points found are greater or equals to this.
+	 * @param x2 End first coordinate, points found are less than this.
+	 * @param y2 End second coordinate, points found are less than this.
+	 * @param filter Predicate taking the two coordinates of an element, returning whether to output it.
+	 * @param outputter Callback used to return values from the search.
+	 */
+	template <typename Filter, typename Outputter>
+	void FindContained(CoordT x1, CoordT y1, CoordT x2, CoordT y2, Filter filter, Outputter outputter) const
 	{
 		assert(x1 < x2);
 		assert(y1 < y2);
@@ -455,7 +580,7 @@ public:
 
 		CoordT p1[2] = { x1, y1 };
 		CoordT p2[2] = { x2, y2 };
-		this->FindContainedRecursive(p1, p2, this->root, 0, outputter);
+		this->FindContainedRecursive(p1, p2, this->root, 0, filter, outputter);
 	}
 
 	/**
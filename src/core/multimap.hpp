@@ -15,7 +15,7 @@
 #include <map>
 #include <list>
 
-template<typename Tkey, typename Tvalue, typename Tcompare>
+template<typename Tkey, typename Tvalue, typename Tcompare, typename Tlist>
 class MultiMap;
 
 /**
@@ -29,7 +29,7 @@ class MultiMap;
 template<class Tmap_iter, class Tlist_iter, class Tkey, class Tvalue, class Tcompare>
 class MultiMapIterator {
 protected:
-	friend class MultiMap<Tkey, Tvalue, Tcompare>;
+	template<typename, typename, typename, typename> friend class MultiMap;
 	typedef MultiMapIterator<Tmap_iter, Tlist_iter, Tkey, Tvalue, Tcompare> Self;
 
 	Tlist_iter list_iter; ///< Iterator pointing to current position in the current list of items with equal keys.
@@ -281,11 +281,13 @@ bool operator!=(const Tmap_iter2 &iter2, const MultiMapIterator<Tmap_iter1, Tlis
  * internally ordered in a deterministic way (contrary to STL multimap). All
  * STL-compatible members are named in STL style, all others are named in OpenTTD
  * style.
+ * @tparam Tlist Container for the items with equal keys. It has to support
+ *               erase(), push_back() and begin()/end() like std::list does.
  */
-template<typename Tkey, typename Tvalue, typename Tcompare = std::less<Tkey> >
-class MultiMap : public std::map<Tkey, std::list<Tvalue>, Tcompare > {
+template<typename Tkey, typename Tvalue, typename Tcompare = std::less<Tkey>, typename Tlist = std::list<Tvalue> >
+class MultiMap : public std::map<Tkey, Tlist, Tcompare > {
 public:
-	typedef typename std::list<Tvalue> List;
+	typedef Tlist List;
 	typedef typename List::iterator ListIterator;
 	typedef typename List::const_iterator ConstListIterator;
 
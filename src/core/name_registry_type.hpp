@@ -0,0 +1,120 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file name_registry_type.hpp Hashed set of the names in use in one namespace. */
+
+#ifndef NAME_REGISTRY_TYPE_HPP
+#define NAME_REGISTRY_TYPE_HPP
+
+#include <string>
+#include <unordered_set>
+
+/**
+ * Hashed multiset of the names in use in one namespace, like the custom names
+ * of the vehicles, so a name can be checked for uniqueness without walking
+ * and formatting the whole pool.
+ *
+ * The registry fills itself on the first query after it was invalidated, by
+ * calling its fill procedure, which has to #Add every name in use. While the
+ * registry is filled, every change of a name must be reported with #Add and
+ * #Remove; where that is awkward, #Invalidate may be called instead.
+ */
+class NameRegistry {
+public:
+	/** Procedure adding all names of the namespace to a registry. */
+	typedef void FillProc(NameRegistry &registry);
+
+private:
+	std::unordered_multiset<std::string> names; ///< The names in use, when #valid.
+	FillProc *fill;                             ///< Procedure to fill the registry with.
+	bool valid;                                 ///< Whether #names is complete.
+	NameRegistry *next;                         ///< Next registry in the list of all registries.
+
+	/**
+	 * Get the first of all registries.
+	 * @return Reference to the head of the list of all registries.
+	 */
+	static NameRegistry *&First()
+	{
+		static NameRegistry *first = NULL;
+		return first;
+	}
+
+public:
+	/**
+	 * Create a registry.
+	 * @param fill Procedure to fill the registry with all names of the namespace.
+	 */
+	NameRegistry(FillProc *fill) : fill(fill), valid(false), next(First())
+	{
+		First() = this;
+	}
+
+	/**
+	 * Check whether the registry is filled, i.e. whether changes have to be reported.
+	 * @return True if the registry is filled.
+	 */
+	bool IsValid() const
+	{
+		return this->valid;
+	}
+
+	/**
+	 * Forget all names; the registry fills itself again on its next query.
+	 */
+	void Invalidate()
+	{
+		this->valid = false;
+		this->names.clear();
+	}
+
+	/**
+	 * Report that a name came into use.
+	 * @param name The name; may be \c NULL, which is not a name.
+	 */
+	void Add(const char *name)
+	{
+		if (this->valid && name != NULL) this->names.insert(name);
+	}
+
+	/**
+	 * Report that a name went out of use.
+	 * @param name The name; may be \c NULL, which is not a name.
+	 */
+	void Remove(const char *name)
+	{
+		if (!this->valid || name == NULL) return;
+		std::unordered_multiset<std::string>::iterator it = this->names.find(name);
+		if (it != this->names.end()) this->names.erase(it);
+	}
+
+	/**
+	 * Check whether a name is in use.
+	 * @param name The name to look for.
+	 * @return True if the name is in use.
+	 */
+	bool Contains(const char *name)
+	{
+		if (!this->valid) {
+			this->valid = true;
+			this->fill(*this);
+		}
+		return this->names.find(name) != this->names.end();
+	}
+
+	/**
+	 * Invalidate all registries, e.g. because a game was loaded.
+	 */
+	static void InvalidateAll()
+	{
+		for (NameRegistry *r = First(); r != NULL; r = r->next) r->Invalidate();
+	}
+};
+
+#endif /* NAME_REGISTRY_TYPE_HPP */
@@ -21,8 +21,8 @@
  * @param type The return type of the method.
  */
 #define DEFINE_POOL_METHOD(type) \
-	template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type, bool Tcache, bool Tzero> \
-	type Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero>
+	template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type, bool Tcache, bool Tzero, bool Tslab> \
+	type Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero, Tslab>
 
 /**
  * Create a clean pool.
@@ -40,6 +40,8 @@ DEFINE_POOL_METHOD(inline)::Pool(const char *name) :
 #endif /* OTTD_ASSERT */
 		cleaning(false),
 		data(NULL),
+		used(NULL),
+		slabs(NULL),
 		alloc_cache(NULL)
 { }
 
@@ -59,6 +61,19 @@ DEFINE_POOL_METHOD(inline void)::ResizeFor(size_t index)
 	this->data = ReallocT(this->data, new_size);
 	MemSetT(this->data + this->size, 0, new_size - this->size);
 
+	size_t old_words = CeilDiv(this->size, 64);
+	size_t new_words = CeilDiv(new_size, 64);
+	this->used = ReallocT(this->used, new_words);
+	MemSetT(this->used + old_words, 0, new_words - old_words);
+
+	if (Tslab) {
+		/* The slabs themselves are only allocated when an item is put in them. */
+		size_t old_slabs = CeilDiv(this->size, Tgrowth_step);
+		size_t new_slabs = CeilDiv(new_size, Tgrowth_step);
+		this->slabs = ReallocT(this->slabs, new_slabs);
+		MemSetT(this->slabs + old_slabs, 0, new_slabs - old_slabs);
+	}
+
 	this->size = new_size;
 }
 
@@ -106,7 +121,14 @@ DEFINE_POOL_METHOD(inline void *)::AllocateItem(size_t size, size_t index)
 	this->items++;
 
 	Titem *item;
-	if (Tcache && this->alloc_cache != NULL) {
+	if (Tslab) {
+		size_t slot_size = GetSlabSlotSize();
+		assert(size <= slot_size);
+		byte *&slab = this->slabs[index / Tgrowth_step];
+		if (slab == NULL) slab = MallocT<byte>(slot_size * Tgrowth_step);
+		item = (Titem *)(slab + (index % Tgrowth_step) * slot_size);
+		if (Tzero) memset((void *)item, 0, size);
+	} else if (Tcache && this->alloc_cache != NULL) {
 		assert(sizeof(Titem) == size);
 		item = (Titem *)this->alloc_cache;
 		this->alloc_cache = this->alloc_cache->next;
@@ -121,6 +143,7 @@ DEFINE_POOL_METHOD(inline void *)::AllocateItem(size_t size, size_t index)
 		item = (Titem *)MallocT<byte>(size);
 	}
 	this->data[index] = item;
+	SetBit(this->used[index / 64], index % 64);
 	item->index = (Tindex)(uint)index;
 	return item;
 }
@@ -181,7 +204,9 @@ DEFINE_POOL_METHOD(void)::FreeItem(size_t index)
 {
 	assert(index < this->size);
 	assert(this->data[index] != NULL);
-	if (Tcache) {
+	if (Tslab) {
+		/* The slot stays reserved for this index. */
+	} else if (Tcache) {
 		AllocCache *ac = (AllocCache *)this->data[index];
 		ac->next = this->alloc_cache;
 		this->alloc_cache = ac;
@@ -189,6 +214,7 @@ DEFINE_POOL_METHOD(void)::FreeItem(size_t index)
 		free(this->data[index]);
 	}
 	this->data[index] = NULL;
+	ClrBit(this->used[index / 64], index % 64);
 	this->first_free = min(this->first_free, index);
 	this->items--;
 	if (!this->cleaning) Titem::PostDestructor(index);
@@ -202,12 +228,19 @@ DEFINE_POOL_METHOD(void)::CleanPool()
 		delete this->Get(i); // 'delete NULL;' is very valid
 	}
 	assert(this->items == 0);
+	if (Tslab) {
+		for (size_t i = 0; i < CeilDiv(this->size, Tgrowth_step); i++) free(this->slabs[i]);
+		free(this->slabs);
+		this->slabs = NULL;
+	}
 	free(this->data);
+	free(this->used);
+	this->used = NULL;
 	this->first_unused = this->first_free = this->size = 0;
 	this->data = NULL;
 	this->cleaning = false;
 
-	if (Tcache) {
+	if (Tcache && !Tslab) {
 		while (this->alloc_cache != NULL) {
 			AllocCache *ac = this->alloc_cache;
 			this->alloc_cache = ac->next;
@@ -216,6 +249,33 @@ DEFINE_POOL_METHOD(void)::CleanPool()
 	}
 }
 
+/**
+ * Tell how much memory this pool uses.
+ * @param[out] usage The memory usage of the pool.
+ */
+DEFINE_POOL_METHOD(void)::GetMemoryUsage(PoolMemoryUsage *usage) const
+{
+	usage->name = this->name;
+	usage->items = this->items;
+	usage->size = this->size;
+	usage->max_size = Tmax_size;
+	usage->bytes = this->size * sizeof(Titem *) + CeilDiv(this->size, 64) * sizeof(uint64);
+
+	if (Tslab) {
+		size_t num_slabs = CeilDiv(this->size, Tgrowth_step);
+		usage->bytes += num_slabs * sizeof(byte *);
+		for (size_t i = 0; i < num_slabs; i++) {
+			if (this->slabs[i] != NULL) usage->bytes += GetSlabSlotSize() * Tgrowth_step;
+		}
+	} else {
+		size_t cached = 0;
+		if (Tcache) {
+			for (const AllocCache *ac = this->alloc_cache; ac != NULL; ac = ac->next) cached++;
+		}
+		usage->bytes += (this->items + cached) * sizeof(Titem);
+	}
+}
+
 #undef DEFINE_POOL_METHOD
 
 /**
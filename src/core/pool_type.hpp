@@ -12,6 +12,7 @@
 #ifndef POOL_TYPE_HPP
 #define POOL_TYPE_HPP
 
+#include "bitmath_func.hpp"
 #include "smallvec_type.hpp"
 #include "enum_type.hpp"
 
@@ -28,6 +29,15 @@ DECLARE_ENUM_AS_BIT_SET(PoolType)
 
 typedef SmallVector<struct PoolBase *, 4> PoolVector; ///< Vector of pointers to PoolBase
 
+/** Memory used by a pool. */
+struct PoolMemoryUsage {
+	const char *name; ///< Name of the pool.
+	size_t items;     ///< Number of items in the pool.
+	size_t size;      ///< Number of indices the pool currently has room for.
+	size_t max_size;  ///< Maximum number of indices of the pool.
+	size_t bytes;     ///< Bytes allocated by the pool, counting each item with the size of the pooled base class.
+};
+
 /** Base class for base of all pools. */
 struct PoolBase {
 	const PoolType type; ///< Type of this pool.
@@ -60,6 +70,12 @@ struct PoolBase {
 	 */
 	virtual void CleanPool() = 0;
 
+	/**
+	 * Virtual method that tells how much memory the pool uses.
+	 * @param[out] usage The memory usage of the pool.
+	 */
+	virtual void GetMemoryUsage(PoolMemoryUsage *usage) const = 0;
+
 private:
 	/**
 	 * Dummy private copy constructor to prevent compilers from
@@ -77,9 +93,11 @@ private:
  * @tparam Tpool_type   Type of this pool
  * @tparam Tcache       Whether to perform 'alloc' caching, i.e. don't actually free/malloc just reuse the memory
  * @tparam Tzero        Whether to zero the memory
+ * @tparam Tslab        Whether to store the items in contiguous blocks of Tgrowth_step slots, the slot being determined by the index.
+ *                      Each slot is PoolItem::GetPoolSlotSize() bytes; Tcache has no effect then.
  * @warning when Tcache is enabled *all* instances of this pool's item must be of the same size.
  */
-template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type = PT_NORMAL, bool Tcache = false, bool Tzero = true>
+template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type = PT_NORMAL, bool Tcache = false, bool Tzero = true, bool Tslab = false>
 struct Pool : PoolBase {
 	/* Ensure Tmax_size is within the bounds of Tindex. */
 	assert_compile((uint64)(Tmax_size - 1) >> 8 * sizeof(Tindex) == 0);
@@ -98,9 +116,12 @@ struct Pool : PoolBase {
 	bool cleaning;       ///< True if cleaning pool (deleting all items)
 
 	Titem **data;        ///< Pointer to array of pointers to Titem
+	uint64 *used;        ///< Bitmap of the indices up to #size that hold an item, to skip holes quickly when iterating
+	byte **slabs;        ///< Blocks of Tgrowth_step item slots, one per Tgrowth_step indices; only used when Tslab is set
 
 	Pool(const char *name);
 	virtual void CleanPool();
+	virtual void GetMemoryUsage(PoolMemoryUsage *usage) const;
 
 	/**
 	 * Returns Titem with given index
@@ -124,6 +145,26 @@ struct Pool : PoolBase {
 		return index < this->first_unused && this->Get(index) != NULL;
 	}
 
+	/**
+	 * Find the first index at or after the given one that holds an item.
+	 * Runs of free indices are skipped 64 at a time, so iterating is
+	 * proportional to the number of items rather than the pool size.
+	 * @param index The index to start searching at.
+	 * @return Index of the next item, or #first_unused if there is none.
+	 */
+	inline size_t GetNextValidIndex(size_t index)
+	{
+		if (index >= this->first_unused) return this->first_unused;
+
+		size_t word = index / 64;
+		uint64 bits = this->used[word] & (UINT64_MAX << (index % 64));
+		while (bits == 0) {
+			if (++word * 64 >= this->first_unused) return this->first_unused;
+			bits = this->used[word];
+		}
+		return word * 64 + FindFirstBit64(bits);
+	}
+
 	/**
 	 * Tests whether we can allocate 'n' items
 	 * @param n number of items we want to allocate
@@ -142,7 +183,7 @@ struct Pool : PoolBase {
 	 * Base class for all PoolItems
 	 * @tparam Tpool The pool this item is going to be part of
 	 */
-	template <struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero> *Tpool>
+	template <struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero, Tslab> *Tpool>
 	struct PoolItem {
 		Tindex index; ///< Index of this pool item
 
@@ -269,6 +310,17 @@ struct Pool : PoolBase {
 			return Tpool->first_unused;
 		}
 
+		/**
+		 * Returns the first index at or after the given one that holds an item.
+		 * Useful when iterating over all pool items.
+		 * @param index index to start searching at
+		 * @return index of the next valid item, or GetPoolSize() if there is none
+		 */
+		static inline size_t GetNextValidIndex(size_t index)
+		{
+			return Tpool->GetNextValidIndex(index);
+		}
+
 		/**
 		 * Returns number of valid items in the pool
 		 * @return number of valid items in the pool
@@ -286,6 +338,14 @@ struct Pool : PoolBase {
 		 * @note it's called only when !CleaningPool()
 		 */
 		static inline void PostDestructor(size_t index) { }
+
+		/**
+		 * Get the number of bytes to reserve for each item when the pool stores its items in slabs.
+		 * If subclasses of Titem are allocated in the pool, override it in PoolItem's subclass
+		 * to return the size of the largest of them.
+		 * @return size of one slot
+		 */
+		static inline size_t GetPoolSlotSize() { return sizeof(Titem); }
 	};
 
 private:
@@ -303,6 +363,15 @@ private:
 	/** Cache of freed pointers */
 	AllocCache *alloc_cache;
 
+	/**
+	 * Get the distance between two items in a slab.
+	 * @return Size of a slot, aligned so every slot is suitably aligned for Titem.
+	 */
+	static inline size_t GetSlabSlotSize()
+	{
+		return Align(Titem::GetPoolSlotSize(), sizeof(uint64));
+	}
+
 	void *AllocateItem(size_t size, size_t index);
 	void ResizeFor(size_t index);
 	size_t FindFirstFree();
@@ -314,7 +383,7 @@ private:
 };
 
 #define FOR_ALL_ITEMS_FROM(type, iter, var, start) \
-	for (size_t iter = start; var = NULL, iter < type::GetPoolSize(); iter++) \
+	for (size_t iter = type::GetNextValidIndex(start); var = NULL, iter < type::GetPoolSize(); iter = type::GetNextValidIndex(iter + 1)) \
 		if ((var = type::Get(iter)) != NULL)
 
 #define FOR_ALL_ITEMS(type, iter, var) FOR_ALL_ITEMS_FROM(type, iter, var, 0)
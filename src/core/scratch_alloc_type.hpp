@@ -0,0 +1,153 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file scratch_alloc_type.hpp Monotonic per thread memory for short lived containers. */
+
+#ifndef SCRATCH_ALLOC_TYPE_HPP
+#define SCRATCH_ALLOC_TYPE_HPP
+
+#include "alloc_func.hpp"
+#include "math_func.hpp"
+
+/**
+ * Memory for temporary containers that only live during a part of a game tick.
+ * Allocating just moves a pointer forward; freeing does nothing. All memory is
+ * handed back at once by #Reset, after which the blocks are reused, so once
+ * the arena has grown to its working size no calls to malloc remain.
+ * Every thread has its own arena, see #Get.
+ * @warning Nothing allocated from the arena may live past the next #Reset.
+ */
+class ScratchArena {
+private:
+	/** A block of memory; the memory to hand out directly follows the header. */
+	struct Block {
+		Block *next; ///< The next block, or \c NULL.
+		size_t size; ///< The number of bytes in the block after the header.
+	};
+
+	static const size_t BLOCK_SIZE = 64 * 1024; ///< Default number of bytes of a block.
+
+	Block *first;   ///< First block of the arena.
+	Block *current; ///< Block memory is handed out from.
+	size_t used;    ///< Bytes of #current that are handed out.
+
+	/**
+	 * Get the start of the memory of a block.
+	 * @param b The block.
+	 * @return The first byte after the block header.
+	 */
+	static inline byte *Data(Block *b)
+	{
+		return reinterpret_cast<byte *>(b) + Align(sizeof(Block), sizeof(void *) * 2);
+	}
+
+	/**
+	 * Continue in the next block that can hold the allocation, adding one if needed.
+	 * @param size The number of bytes that will be allocated.
+	 */
+	void NextBlock(size_t size)
+	{
+		Block **next = this->current == NULL ? &this->first : &this->current->next;
+		/* Blocks that are too small for the allocation are skipped, but kept for after the next reset. */
+		while (*next != NULL && (*next)->size < size) next = &(*next)->next;
+		if (*next == NULL) {
+			size_t block_size = max(size, BLOCK_SIZE);
+			Block *b = reinterpret_cast<Block *>(MallocT<byte>(Align(sizeof(Block), sizeof(void *) * 2) + block_size));
+			b->next = NULL;
+			b->size = block_size;
+			*next = b;
+		}
+		this->current = *next;
+		this->used = 0;
+	}
+
+public:
+	ScratchArena() : first(NULL), current(NULL), used(0) {}
+
+	~ScratchArena()
+	{
+		while (this->first != NULL) {
+			Block *next = this->first->next;
+			free(this->first);
+			this->first = next;
+		}
+	}
+
+	/**
+	 * Allocate memory from the arena.
+	 * @param size  The number of bytes to allocate.
+	 * @param align The alignment of the memory; a power of two.
+	 * @return The memory.
+	 */
+	void *Allocate(size_t size, size_t align)
+	{
+		size_t offset = this->current == NULL ? 0 : Align(this->used, (uint)align);
+		if (this->current == NULL || offset + size > this->current->size) {
+			this->NextBlock(size);
+			offset = 0;
+		}
+		this->used = offset + size;
+		return Data(this->current) + offset;
+	}
+
+	/**
+	 * Hand back all memory allocated from the arena, keeping the blocks for reuse.
+	 * The blocks appear in the order they were added, so allocation restarts in the first one.
+	 */
+	void Reset()
+	{
+		this->current = NULL;
+		this->used = 0;
+	}
+
+	/**
+	 * Get the arena of the calling thread.
+	 * @return The arena.
+	 */
+	static ScratchArena &Get()
+	{
+		static thread_local ScratchArena arena;
+		return arena;
+	}
+};
+
+/**
+ * STL allocator handing out memory from the #ScratchArena of the allocating thread.
+ * Containers using it must not be passed to other threads nor outlive the
+ * game loop phase they were created in.
+ * @tparam T The type to allocate.
+ */
+template <typename T>
+struct ScratchAllocator {
+	typedef T value_type; ///< The type to allocate.
+
+	ScratchAllocator() {}
+	template <typename U> ScratchAllocator(const ScratchAllocator<U> &) {}
+
+	/**
+	 * Allocate memory for some objects.
+	 * @param n The number of objects.
+	 * @return The uninitialised memory.
+	 */
+	T *allocate(size_t n)
+	{
+		return static_cast<T *>(ScratchArena::Get().Allocate(n * sizeof(T), alignof(T)));
+	}
+
+	/** Memory is only handed back to the arena by ScratchArena::Reset. */
+	void deallocate(T *, size_t) {}
+
+	/** Rebind the allocator to another type; needed for pre C++11 libraries. */
+	template <typename U> struct rebind { typedef ScratchAllocator<U> other; };
+};
+
+template <typename T, typename U> inline bool operator ==(const ScratchAllocator<T> &, const ScratchAllocator<U> &) { return true; }
+template <typename T, typename U> inline bool operator !=(const ScratchAllocator<T> &, const ScratchAllocator<U> &) { return false; }
+
+#endif /* SCRATCH_ALLOC_TYPE_HPP */
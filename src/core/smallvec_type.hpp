@@ -22,6 +22,10 @@
  *       to care about that you grab an item which is
  *       inside the list.
  *
+ * The capacity grows geometrically, rounded up to multiples of the
+ * allocation step, so appending many items one by one takes amortised
+ * constant time instead of a reallocation every \a S items.
+ *
  * @tparam T The type of the items stored
  * @tparam S The steps of allocation
  */
@@ -32,6 +36,19 @@ protected:
 	uint items;    ///< The number of items stored
 	uint capacity; ///< The available space for storing items
 
+	/**
+	 * Make sure there is space for at least \a num_items items.
+	 * @param num_items The number of items that has to fit.
+	 */
+	inline void Grow(uint num_items)
+	{
+		if (num_items <= this->capacity) return;
+
+		/* Double the storage, so filling the vector item by item reallocates logarithmically often. */
+		this->capacity = Align(max(num_items, this->capacity * 2), S);
+		this->data = ReallocT(this->data, this->capacity);
+	}
+
 public:
 	SmallVector() : data(NULL), items(0), capacity(0) { }
 
@@ -114,6 +131,17 @@ public:
 		data = NULL;
 	}
 
+	/**
+	 * Exchange the items with those of another list, without copying them.
+	 * @param other The other list.
+	 */
+	inline void Swap(SmallVector &other)
+	{
+		::Swap(this->data, other.data);
+		::Swap(this->items, other.items);
+		::Swap(this->capacity, other.capacity);
+	}
+
 	/**
 	 * Compact the list down to the smallest block size boundary.
 	 */
@@ -134,13 +162,9 @@ public:
 	inline T *Append(uint to_add = 1)
 	{
 		uint begin = this->items;
+		this->Grow(this->items + to_add);
 		this->items += to_add;
 
-		if (this->items > this->capacity) {
-			this->capacity = Align(this->items, S);
-			this->data = ReallocT(this->data, this->capacity);
-		}
-
 		return &this->data[begin];
 	}
 
@@ -150,12 +174,20 @@ public:
 	 */
 	inline void Resize(uint num_items)
 	{
+		this->Grow(num_items);
 		this->items = num_items;
+	}
 
-		if (this->items > this->capacity) {
-			this->capacity = Align(this->items, S);
-			this->data = ReallocT(this->data, this->capacity);
-		}
+	/**
+	 * Allocate storage for a number of items up front, without changing the number of items.
+	 * @param num_items The number of items the vector should be able to hold.
+	 */
+	inline void Reserve(uint num_items)
+	{
+		if (num_items <= this->capacity) return;
+
+		this->capacity = Align(num_items, S);
+		this->data = ReallocT(this->data, this->capacity);
 	}
 
 	/**
@@ -292,6 +324,16 @@ public:
 		return this->items;
 	}
 
+	/**
+	 * Get the number of items the list has room for without reallocating.
+	 *
+	 * @return The number of items allocated.
+	 */
+	inline uint Capacity() const
+	{
+		return this->capacity;
+	}
+
 	/**
 	 * Get the pointer to the first item (const)
 	 *
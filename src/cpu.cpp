@@ -90,7 +90,7 @@ uint64 ottd_rdtsc() {return 0;}
 #if defined(_MSC_VER)
 void ottd_cpuid(int info[4], int type)
 {
-	__cpuid(info, type);
+	__cpuidex(info, type, 0);
 }
 #elif defined(__x86_64__) || defined(__i386)
 void ottd_cpuid(int info[4], int type)
@@ -110,13 +110,13 @@ void ottd_cpuid(int info[4], int type)
 			/* It is safe to write "=r" for (info[1]) as in case that PIC is enabled for i386,
 			 * the compiler will not choose EBX as target register (but something else).
 			 */
-			: "a" (type)
+			: "a" (type), "c" (0)
 	);
 #else
 	__asm__ __volatile__ (
 			"cpuid           \n\t"
 			: "=a" (info[0]), "=b" (info[1]), "=c" (info[2]), "=d" (info[3])
-			: "a" (type)
+			: "a" (type), "c" (0)
 	);
 #endif /* i386 PIC */
 }
@@ -137,3 +137,26 @@ bool HasCPUIDFlag(uint type, uint index, uint bit)
 	ottd_cpuid(cpu_info, type);
 	return HasBit(cpu_info[index], bit);
 }
+
+/**
+ * Check whether the operating system saves the state of the AVX registers on
+ * context switches, i.e. whether AVX instructions can be used at all.
+ * @return True when the CPU has AVX and the operating system enabled it.
+ */
+bool HasOSAVXSupport()
+{
+	/* OSXSAVE: the XGETBV instruction is enabled; AVX: the CPU supports AVX. */
+	if (!HasCPUIDFlag(1, 2, 27) || !HasCPUIDFlag(1, 2, 28)) return false;
+
+#if defined(_MSC_VER)
+	uint64 xcr0 = _xgetbv(0);
+#elif defined(__x86_64__) || defined(__i386)
+	uint32 eax, edx;
+	__asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	uint64 xcr0 = eax | (uint64)edx << 32;
+#else
+	uint64 xcr0 = 0;
+#endif
+	/* Both the SSE and the AVX state must be saved. */
+	return (xcr0 & 0x6) == 0x6;
+}
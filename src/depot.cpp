@@ -11,6 +11,7 @@
 
 #include "stdafx.h"
 #include "depot_base.h"
+#include "depot_kdtree.h"
 #include "order_backup.h"
 #include "order_func.h"
 #include "window_func.h"
@@ -24,6 +25,19 @@
 DepotPool _depot_pool("Depot");
 INSTANTIATE_POOL_METHODS(Depot)
 
+DepotKdtree _depot_kdtree(Kdtree_DepotXYFunc);
+
+/** Rebuild the k-d tree of depots from the depot pool. */
+void RebuildDepotKdtree()
+{
+	std::vector<DepotID> depot_ids;
+	const Depot *d;
+	FOR_ALL_DEPOTS(d) {
+		depot_ids.push_back(d->index);
+	}
+	_depot_kdtree.Build(depot_ids.begin(), depot_ids.end());
+}
+
 /**
  * Clean up a depot
  */
@@ -31,6 +45,8 @@ Depot::~Depot()
 {
 	if (CleaningPool()) return;
 
+	_depot_kdtree.Remove(this->index);
+
 	if (!IsDepotTile(this->xy) || GetDepotIndex(this->xy) != this->index) {
 		/* It can happen there is no depot here anymore (TTO/TTD savegames) */
 		return;
@@ -101,39 +101,71 @@ Prices _price;
 Money _additional_cash_required;
 static PriceMultipliers _price_base_multiplier;
 
+/** Totals over the vehicles and stations of a company, as needed for its value and rating. */
+struct CompanyAssets {
+	uint station_parts;          ///< Number of facilities of all stations.
+	uint serviced_station_parts; ///< Number of facilities of recently serviced stations.
+	Money vehicle_value;         ///< Value of all vehicles, as counted for the company value.
+	uint profitable_vehicles;    ///< Number of primary vehicles with a profit last year.
+	Money min_profit;            ///< Lowest profit last year of the primary vehicles older than two years.
+	bool has_min_profit;         ///< Whether there is any primary vehicle older than two years.
+};
+
 /**
- * Calculate the value of the company. That is the value of all
- * assets (vehicles, stations, etc) and money minus the loan,
- * except when including_loan is \c false which is useful when
- * we want to calculate the value for bankruptcy.
- * @param c              the company to get the value of.
- * @param including_loan include the loan in the company value.
- * @return the value of the company.
+ * Gather the assets of all companies in one pass over the vehicles and stations.
+ * @param[out] assets The assets, indexed by company.
  */
-Money CalculateCompanyValue(const Company *c, bool including_loan)
+static void GetCompanyAssets(CompanyAssets assets[MAX_COMPANIES])
 {
-	Owner owner = c->index;
-
-	Station *st;
-	uint num = 0;
+	std::fill(assets, assets + MAX_COMPANIES, CompanyAssets());
 
+	const Station *st;
 	FOR_ALL_STATIONS(st) {
-		if (st->owner == owner) num += CountBits((byte)st->facilities);
-	}
+		if (st->owner >= MAX_COMPANIES) continue;
 
-	Money value = num * _price[PR_STATION_VALUE] * 25;
+		CompanyAssets &a = assets[st->owner];
+		uint parts = CountBits((byte)st->facilities);
+		a.station_parts += parts;
+		/* Only count stations that are actually serviced */
+		if (st->time_since_load <= 20 || st->time_since_unload <= 20) a.serviced_station_parts += parts;
+	}
 
-	Vehicle *v;
+	const Vehicle *v;
 	FOR_ALL_VEHICLES(v) {
-		if (v->owner != owner) continue;
+		if (v->owner >= MAX_COMPANIES) continue;
 
+		CompanyAssets &a = assets[v->owner];
 		if (v->type == VEH_TRAIN ||
 				v->type == VEH_ROAD ||
 				(v->type == VEH_AIRCRAFT && Aircraft::From(v)->IsNormalAircraft()) ||
 				v->type == VEH_SHIP) {
-			value += v->value * 3 >> 1;
+			a.vehicle_value += v->value * 3 >> 1;
+		}
+
+		if (IsCompanyBuildableVehicleType(v->type) && v->IsPrimaryVehicle()) {
+			if (v->profit_last_year > 0) a.profitable_vehicles++; // For the vehicle score only count profitable vehicles
+			if (v->age > 730) {
+				/* Find the vehicle with the lowest amount of profit */
+				if (!a.has_min_profit || a.min_profit > v->profit_last_year) {
+					a.min_profit = v->profit_last_year;
+					a.has_min_profit = true;
+				}
+			}
 		}
 	}
+}
+
+/**
+ * Calculate the value of the company from its gathered assets.
+ * @param c              the company to get the value of.
+ * @param assets         the assets of the company.
+ * @param including_loan include the loan in the company value.
+ * @return the value of the company.
+ */
+static Money CalculateCompanyValue(const Company *c, const CompanyAssets &assets, bool including_loan)
+{
+	Money value = assets.station_parts * _price[PR_STATION_VALUE] * 25;
+	value += assets.vehicle_value;
 
 	/* Add real money value */
 	if (including_loan) value -= c->current_loan;
@@ -142,15 +174,32 @@ Money CalculateCompanyValue(const Company *c, bool including_loan)
 	return max(value, (Money)1);
 }
 
+/**
+ * Calculate the value of the company. That is the value of all
+ * assets (vehicles, stations, etc) and money minus the loan,
+ * except when including_loan is \c false which is useful when
+ * we want to calculate the value for bankruptcy.
+ * @param c              the company to get the value of.
+ * @param including_loan include the loan in the company value.
+ * @return the value of the company.
+ */
+Money CalculateCompanyValue(const Company *c, bool including_loan)
+{
+	CompanyAssets assets[MAX_COMPANIES];
+	GetCompanyAssets(assets);
+	return CalculateCompanyValue(c, assets[c->index], including_loan);
+}
+
 /**
  * if update is set to true, the economy is updated with this score
  *  (also the house is updated, should only be true in the on-tick event)
- * @param update the economy with calculated score
  * @param c company been evaluated
+ * @param assets the assets of the company
+ * @param update the economy with calculated score
  * @return actual score of this company
  *
  */
-int UpdateCompanyRatingAndValue(Company *c, bool update)
+static int UpdateCompanyRatingAndValue(Company *c, const CompanyAssets &assets, bool update)
 {
 	Owner owner = c->index;
 	int score = 0;
@@ -159,28 +208,11 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 
 	/* Count vehicles */
 	{
-		Vehicle *v;
-		Money min_profit = 0;
-		bool min_profit_first = true;
-		uint num = 0;
-
-		FOR_ALL_VEHICLES(v) {
-			if (v->owner != owner) continue;
-			if (IsCompanyBuildableVehicleType(v->type) && v->IsPrimaryVehicle()) {
-				if (v->profit_last_year > 0) num++; // For the vehicle score only count profitable vehicles
-				if (v->age > 730) {
-					/* Find the vehicle with the lowest amount of profit */
-					if (min_profit_first || min_profit > v->profit_last_year) {
-						min_profit = v->profit_last_year;
-						min_profit_first = false;
-					}
-				}
-			}
-		}
+		Money min_profit = assets.has_min_profit ? assets.min_profit : (Money)0;
 
 		min_profit >>= 8; // remove the fract part
 
-		_score_part[owner][SCORE_VEHICLES] = num;
+		_score_part[owner][SCORE_VEHICLES] = assets.profitable_vehicles;
 		/* Don't allow negative min_profit to show */
 		if (min_profit > 0) {
 			_score_part[owner][SCORE_MIN_PROFIT] = min_profit;
@@ -189,14 +221,7 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 
 	/* Count stations */
 	{
-		uint num = 0;
-		const Station *st;
-
-		FOR_ALL_STATIONS(st) {
-			/* Only count stations that are actually serviced */
-			if (st->owner == owner && (st->time_since_load <= 20 || st->time_since_unload <= 20)) num += CountBits((byte)st->facilities);
-		}
-		_score_part[owner][SCORE_STATIONS] = num;
+		_score_part[owner][SCORE_STATIONS] = assets.serviced_station_parts;
 	}
 
 	/* Generate statistics depending on recent income statistics */
@@ -274,13 +299,28 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 	if (update) {
 		c->old_economy[0].performance_history = score;
 		UpdateCompanyHQ(c->location_of_HQ, score);
-		c->old_economy[0].company_value = CalculateCompanyValue(c);
+		c->old_economy[0].company_value = CalculateCompanyValue(c, assets, true);
 	}
 
 	SetWindowDirty(WC_PERFORMANCE_DETAIL, 0);
 	return score;
 }
 
+/**
+ * if update is set to true, the economy is updated with this score
+ *  (also the house is updated, should only be true in the on-tick event)
+ * @param update the economy with calculated score
+ * @param c company been evaluated
+ * @return actual score of this company
+ *
+ */
+int UpdateCompanyRatingAndValue(Company *c, bool update)
+{
+	CompanyAssets assets[MAX_COMPANIES];
+	GetCompanyAssets(assets);
+	return UpdateCompanyRatingAndValue(c, assets[c->index], update);
+}
+
 /**
  * Change the ownership of all the items of a company.
  * @param old_owner The company that gets removed.
@@ -288,6 +328,8 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
  */
 void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 {
+	_company_infrastructure_touched = true;
+
 	/* We need to set _current_company to old_owner before we try to move
 	 * the client. This is needed as it needs to know whether "you" really
 	 * are the current local company. */
@@ -491,6 +533,10 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 		do {
 			ChangeTileOwner(tile, old_owner, new_owner);
 		} while (++tile != MapSize());
+		/* Reservations may now be followed onto tiles of another owner. */
+		NotifyTrackReservationChange();
+		/* Signal segments may now span tiles of another owner too. */
+		InvalidateSignalSegmentCache();
 
 		if (new_owner != INVALID_OWNER) {
 			/* Update all signals because there can be new segment that was owned by two companies
@@ -695,6 +741,10 @@ static void CompaniesGenStatistics()
 	/* Only run the economic statics and update company stats every 3rd month (1st of quarter). */
 	if (!HasBit(1 << 0 | 1 << 3 | 1 << 6 | 1 << 9, _cur_month)) return;
 
+	/* Gather the assets of all companies at once instead of once per company. */
+	CompanyAssets assets[MAX_COMPANIES];
+	GetCompanyAssets(assets);
+
 	FOR_ALL_COMPANIES(c) {
 		/* Drop the oldest history off the end */
 		std::copy_backward(c->old_economy, c->old_economy + MAX_HISTORY_QUARTERS - 1, c->old_economy + MAX_HISTORY_QUARTERS);
@@ -703,7 +753,7 @@ static void CompaniesGenStatistics()
 
 		if (c->num_valid_stat_ent != MAX_HISTORY_QUARTERS) c->num_valid_stat_ent++;
 
-		UpdateCompanyRatingAndValue(c, true);
+		UpdateCompanyRatingAndValue(c, assets[c->index], true);
 		if (c->block_preview != 0) c->block_preview--;
 	}
 
@@ -1023,6 +1073,9 @@ Money GetTransportedGoodsIncome(uint num_pieces, uint dist, byte transit_days, C
 /** The industries we've currently brought cargo to. */
 static SmallIndustryList _cargo_delivery_destinations;
 
+static uint _load_unload_idle_skips = 0;    ///< Number of calls to #LoadUnloadVehicle while waiting that did nothing since this was last reset.
+static uint _load_unload_reserve_skips = 0; ///< Number of reservations in #LoadUnloadVehicle skipped for fully reserved consists since this was last reset.
+
 /**
  * Transfer goods from station to industry.
  * All cargo is delivered to the nearest (Manhattan) industry to the station sign, which is inside the acceptance rectangle and actually accepts the cargo.
@@ -1174,7 +1227,8 @@ static void TriggerIndustryProduction(Industry *i)
  */
 CargoPayment::CargoPayment(Vehicle *front) :
 	front(front),
-	current_station(front->last_station_visited)
+	current_station(front->last_station_visited),
+	pending_count(0)
 {
 }
 
@@ -1182,6 +1236,7 @@ CargoPayment::~CargoPayment()
 {
 	if (this->CleaningPool()) return;
 
+	this->FlushDelivery();
 	this->front->cargo_payment = NULL;
 
 	if (this->visual_profit == 0 && this->visual_transfer == 0) return;
@@ -1208,6 +1263,9 @@ CargoPayment::~CargoPayment()
 
 /**
  * Handle payment for final delivery of the given cargo packet.
+ * Consecutive packets with the same origin and transit time are delivered
+ * and paid for together by #FlushDelivery, so the acceptance, income,
+ * cargo monitor and subsidy bookkeeping is done once for all of them.
  * @param cp The cargo packet to pay for.
  * @param count The number of packets to pay for.
  */
@@ -1217,12 +1275,36 @@ void CargoPayment::PayFinalDelivery(const CargoPacket *cp, uint count)
 		this->owner = Company::Get(this->front->owner);
 	}
 
-	/* Handle end of route payment */
-	Money profit = DeliverGoods(count, this->ct, this->current_station, cp->SourceStationXY(), cp->DaysInTransit(), this->owner, cp->SourceSubsidyType(), cp->SourceSubsidyID());
-	this->route_profit += profit;
+	if (this->pending_count != 0 && (this->pending_xy != cp->SourceStationXY() || this->pending_days != cp->DaysInTransit() ||
+			this->pending_src_type != cp->SourceSubsidyType() || this->pending_src != cp->SourceSubsidyID())) {
+		this->FlushDelivery();
+	}
+
+	if (this->pending_count == 0) {
+		this->pending_xy = cp->SourceStationXY();
+		this->pending_days = cp->DaysInTransit();
+		this->pending_src_type = cp->SourceSubsidyType();
+		this->pending_src = cp->SourceSubsidyID();
+	}
+	this->pending_count += count;
 
 	/* The vehicle's profit is whatever route profit there is minus feeder shares. */
-	this->visual_profit += profit - cp->FeederShare(count);
+	this->visual_profit -= cp->FeederShare(count);
+}
+
+/**
+ * Deliver and pay for the cargo collected by #PayFinalDelivery.
+ * This has to be done before anything else delivers cargo at the station.
+ */
+void CargoPayment::FlushDelivery()
+{
+	if (this->pending_count == 0) return;
+
+	/* Handle end of route payment */
+	Money profit = DeliverGoods(this->pending_count, this->ct, this->current_station, this->pending_xy, this->pending_days, this->owner, this->pending_src_type, this->pending_src);
+	this->route_profit += profit;
+	this->visual_profit += profit;
+	this->pending_count = 0;
 }
 
 /**
@@ -1560,13 +1642,15 @@ struct ReserveCargoAction {
  * @param u Front of the loading vehicle consist.
  * @param consist_capleft If given, save free capacities after reserving there.
  * @param next_station Station(s) the vehicle will stop at next.
+ * @return True if no part of the consist has capacity left for further reservations.
  */
-static void ReserveConsist(Station *st, Vehicle *u, CargoArray *consist_capleft, StationIDStack *next_station)
+static bool ReserveConsist(Station *st, Vehicle *u, CargoArray *consist_capleft, StationIDStack *next_station)
 {
 	/* If there is a cargo payment not all vehicles of the consist have tried to do the refit.
 	 * In that case, only reserve if it's a fixed refit and the equivalent of "articulated chain"
 	 * a vehicle belongs to already has the right cargo. */
 	bool must_reserve = !u->current_order.IsRefit() || u->cargo_payment == NULL;
+	bool all_reserved = true;
 	for (Vehicle *v = u; v != NULL; v = v->Next()) {
 		assert(v->cargo_cap >= v->cargo.RemainingCount());
 
@@ -1579,9 +1663,11 @@ static void ReserveConsist(Station *st, Vehicle *u, CargoArray *consist_capleft,
 				(must_reserve || u->current_order.GetRefitCargo() == v->cargo_type)) {
 			IterateVehicleParts(v, ReserveCargoAction(st, next_station));
 		}
+		if (v->cargo_cap > v->cargo.RemainingCount()) all_reserved = false;
 		if (consist_capleft == NULL || v->cargo_cap == 0) continue;
 		(*consist_capleft)[v->cargo_type] += v->cargo_cap - v->cargo.RemainingCount();
 	}
+	return all_reserved;
 }
 
 /**
@@ -1616,12 +1702,21 @@ static void LoadUnloadVehicle(Vehicle *front)
 	StationID last_visited = front->last_station_visited;
 	Station *st = Station::Get(last_visited);
 
-	StationIDStack next_station = front->GetNextStoppingStation();
 	bool use_autorefit = front->current_order.IsRefit() && front->current_order.GetRefitCargo() == CT_AUTO_REFIT;
+	bool reserve = _settings_game.order.improved_load && use_autorefit ?
+			front->cargo_payment == NULL : (front->current_order.GetLoadType() & OLFB_FULL_LOAD) != 0;
+
+	/* While waiting, a consist without anything left to reserve has nothing to do. */
+	if (front->load_unload_ticks != 0 && (!reserve || front->consist_reserved)) {
+		if (reserve) _load_unload_reserve_skips++;
+		_load_unload_idle_skips++;
+		return;
+	}
+
+	StationIDStack next_station = front->GetNextStoppingStation();
 	CargoArray consist_capleft;
-	if (_settings_game.order.improved_load && use_autorefit ?
-			front->cargo_payment == NULL : (front->current_order.GetLoadType() & OLFB_FULL_LOAD) != 0) {
-		ReserveConsist(st, front,
+	if (reserve) {
+		front->consist_reserved = ReserveConsist(st, front,
 				(use_autorefit && front->load_unload_ticks != 0) ? &consist_capleft : NULL,
 				&next_station);
 	}
@@ -1629,6 +1724,9 @@ static void LoadUnloadVehicle(Vehicle *front)
 	/* We have not waited enough time till the next round of loading/unloading */
 	if (front->load_unload_ticks != 0) return;
 
+	/* Loading and unloading below change the cargo of the consist. */
+	front->consist_reserved = false;
+
 	if (front->type == VEH_TRAIN && (!IsTileType(front->tile, MP_STATION) || GetStationIndex(front->tile) != st->index)) {
 		/* The train reversed in the station. Take the "easy" way
 		 * out and let the train just leave as it always did. */
@@ -1818,6 +1916,9 @@ static void LoadUnloadVehicle(Vehicle *front)
 		}
 	}
 
+	/* Other vehicles may unload at this station before this one continues. */
+	if (payment != NULL) payment->FlushDelivery();
+
 	if (anything_loaded || anything_unloaded) {
 		if (front->type == VEH_TRAIN) {
 			TriggerStationRandomisation(st, front->tile, SRT_TRAIN_LOADS);
@@ -1959,6 +2060,10 @@ void LoadUnloadStation(Station *st)
  */
 void CompaniesMonthlyLoop()
 {
+	DEBUG(misc, 3, "Loading vehicles skipped %u idle waits this month, %u of them fully reserved", _load_unload_idle_skips, _load_unload_reserve_skips);
+	_load_unload_idle_skips = 0;
+	_load_unload_reserve_skips = 0;
+
 	CompaniesGenStatistics();
 	if (_settings_game.economy.inflation) {
 		AddInflation();
@@ -34,19 +34,31 @@ struct CargoPayment : CargoPaymentPool::PoolItem<&_cargo_payment_pool> {
 	StationID current_station; ///< The current station
 	CargoID ct;                ///< The currently handled cargo type
 
+	/* Final delivery not paid yet, of consecutive packets with the same origin and transit time. */
+	uint pending_count;          ///< Amount of cargo in the pending delivery.
+	TileIndex pending_xy;        ///< Source station tile of the pending delivery.
+	byte pending_days;           ///< Days in transit of the pending delivery.
+	SourceType pending_src_type; ///< Subsidy source type of the pending delivery.
+	SourceID pending_src;        ///< Subsidy source of the pending delivery.
+
 	/** Constructor for pool saveload */
-	CargoPayment() {}
+	CargoPayment() : pending_count(0) {}
 	CargoPayment(Vehicle *front);
 	~CargoPayment();
 
 	Money PayTransfer(const CargoPacket *cp, uint count);
 	void PayFinalDelivery(const CargoPacket *cp, uint count);
+	void FlushDelivery();
 
 	/**
 	 * Sets the currently handled cargo type.
 	 * @param ct the cargo type to handle from now on.
 	 */
-	void SetCargo(CargoID ct) { this->ct = ct; }
+	void SetCargo(CargoID ct)
+	{
+		if (ct != this->ct) this->FlushDelivery();
+		this->ct = ct;
+	}
 };
 
 /**
@@ -18,10 +18,27 @@
 #include "animated_tile_func.h"
 #include "effectvehicle_func.h"
 #include "effectvehicle_base.h"
+#include "network/network.h"
 
 #include "safeguards.h"
 
 
+/**
+ * Update the position of an effect vehicle after it moved or changed its sprite.
+ * Effect vehicles are part of the game state, so they are created and moved on
+ * every machine, but a dedicated server has no viewport to show them in and
+ * can skip determining their screen area and marking it dirty.
+ * @param v The effect vehicle.
+ */
+static inline void UpdateEffectVehiclePosition(EffectVehicle *v)
+{
+	if (_network_dedicated) {
+		v->UpdatePosition();
+	} else {
+		v->UpdatePositionAndViewport();
+	}
+}
+
 /**
  * Increment the sprite unless it has reached the end of the animation.
  * @param v Vehicle to increment sprite of.
@@ -60,7 +77,7 @@ static bool ChimneySmokeTick(EffectVehicle *v)
 			v->sprite_seq.Set(SPR_CHIMNEY_SMOKE_0);
 		}
 		v->progress = 7;
-		v->UpdatePositionAndViewport();
+		UpdateEffectVehiclePosition(v);
 	}
 
 	return true;
@@ -91,7 +108,7 @@ static bool SteamSmokeTick(EffectVehicle *v)
 		moved = true;
 	}
 
-	if (moved) v->UpdatePositionAndViewport();
+	if (moved) UpdateEffectVehiclePosition(v);
 
 	return true;
 }
@@ -108,13 +125,13 @@ static bool DieselSmokeTick(EffectVehicle *v)
 
 	if ((v->progress & 3) == 0) {
 		v->z_pos++;
-		v->UpdatePositionAndViewport();
+		UpdateEffectVehiclePosition(v);
 	} else if ((v->progress & 7) == 1) {
 		if (!IncrementSprite(v, SPR_DIESEL_SMOKE_5)) {
 			delete v;
 			return false;
 		}
-		v->UpdatePositionAndViewport();
+		UpdateEffectVehiclePosition(v);
 	}
 
 	return true;
@@ -137,7 +154,7 @@ static bool ElectricSparkTick(EffectVehicle *v)
 			delete v;
 			return false;
 		}
-		v->UpdatePositionAndViewport();
+		UpdateEffectVehiclePosition(v);
 	}
 
 	return true;
@@ -168,7 +185,7 @@ static bool SmokeTick(EffectVehicle *v)
 		moved = true;
 	}
 
-	if (moved) v->UpdatePositionAndViewport();
+	if (moved) UpdateEffectVehiclePosition(v);
 
 	return true;
 }
@@ -187,7 +204,7 @@ static bool ExplosionLargeTick(EffectVehicle *v)
 			delete v;
 			return false;
 		}
-		v->UpdatePositionAndViewport();
+		UpdateEffectVehiclePosition(v);
 	}
 
 	return true;
@@ -206,7 +223,7 @@ static bool BreakdownSmokeTick(EffectVehicle *v)
 		if (!IncrementSprite(v, SPR_BREAKDOWN_SMOKE_3)) {
 			v->sprite_seq.Set(SPR_BREAKDOWN_SMOKE_0);
 		}
-		v->UpdatePositionAndViewport();
+		UpdateEffectVehiclePosition(v);
 	}
 
 	v->animation_state--;
@@ -232,7 +249,7 @@ static bool ExplosionSmallTick(EffectVehicle *v)
 			delete v;
 			return false;
 		}
-		v->UpdatePositionAndViewport();
+		UpdateEffectVehiclePosition(v);
 	}
 
 	return true;
@@ -305,7 +322,7 @@ static bool BulldozerTick(EffectVehicle *v)
 				return false;
 			}
 		}
-		v->UpdatePositionAndViewport();
+		UpdateEffectVehiclePosition(v);
 	}
 
 	return true;
@@ -478,7 +495,7 @@ static bool BubbleTick(EffectVehicle *v)
 	if (v->spritenum == 0) {
 		v->sprite_seq.seq[0].sprite++;
 		if (v->sprite_seq.seq[0].sprite < SPR_BUBBLE_GENERATE_3) {
-			v->UpdatePositionAndViewport();
+			UpdateEffectVehiclePosition(v);
 			return true;
 		}
 		if (v->animation_substate != 0) {
@@ -524,7 +541,7 @@ static bool BubbleTick(EffectVehicle *v)
 	v->z_pos += b->z;
 	v->sprite_seq.Set(SPR_BUBBLE_0 + b->image);
 
-	v->UpdatePositionAndViewport();
+	UpdateEffectVehiclePosition(v);
 
 	return true;
 }
@@ -608,7 +625,7 @@ EffectVehicle *CreateEffectVehicle(int x, int y, int z, EffectVehicleType type)
 
 	_effect_init_procs[type](v);
 
-	v->UpdatePositionAndViewport();
+	UpdateEffectVehiclePosition(v);
 
 	return v;
 }
@@ -268,10 +268,63 @@ void DrawRailCatenaryOnTunnel(const TileInfo *ti)
 }
 
 /**
- * Draws wires and, if required, pylons on a given tile
- * @param ti The Tileinfo to draw the tile for
+ * The pylons and wires of a tile. They follow from the tracks of the tile
+ * and its four neighbours, which takes many map lookups, so the layout is
+ * cached until the tile or one of its neighbours is marked dirty.
  */
-static void DrawRailCatenaryRailway(const TileInfo *ti)
+struct CatenaryLayout {
+	TileIndex tile;                    ///< The tile the layout was determined for.
+	uint32 generation;                 ///< Value of #_catenary_layout_generation the layout was determined at; 0 if not valid.
+	uint32 state[4];                   ///< Map contents, slope and height of the tile the layout was determined for.
+	Corner halftile_corner;            ///< Raised corner of a half tile slope, or #CORNER_INVALID.
+	Direction pylon_ppp[DIAGDIR_END];  ///< PPP of the pylon at each PCP, or #INVALID_DIR if no pylon is drawn there.
+	int16 pylon_z[DIAGDIR_END];        ///< Elevation of the pylon at each PCP.
+	TrackBits wires;                   ///< Tracks with a wire.
+	bool wires_below_bridge;           ///< Whether the wires are hidden by a low bridge, unless bridges are transparent.
+	byte wire_sprite[TRACK_END];       ///< Index in #RailCatenarySpriteData of the wire of each track.
+	int16 wire_z[TRACK_END];           ///< Elevation of the ground below the wire of each track.
+};
+
+static const uint CATENARY_LAYOUT_CACHE_BITS = 7; ///< Number of bits of the tile coordinates used to find the slot of a tile in #_catenary_layout_cache.
+static const uint CATENARY_LAYOUT_CACHE_MASK = (1 << CATENARY_LAYOUT_CACHE_BITS) - 1;
+
+static CatenaryLayout _catenary_layout_cache[1 << (2 * CATENARY_LAYOUT_CACHE_BITS)]; ///< The cache; tiles share slots when they are a multiple of 128 tiles apart.
+static uint32 _catenary_layout_generation = 1; ///< Layouts determined at another generation are not valid.
+
+/**
+ * Get the slot of a tile in #_catenary_layout_cache.
+ * @param x X coordinate of the tile.
+ * @param y Y coordinate of the tile.
+ * @return The slot.
+ */
+static inline CatenaryLayout *GetCachedCatenaryLayout(uint x, uint y)
+{
+	return &_catenary_layout_cache[(x & CATENARY_LAYOUT_CACHE_MASK) | (y & CATENARY_LAYOUT_CACHE_MASK) << CATENARY_LAYOUT_CACHE_BITS];
+}
+
+/**
+ * Forget the cached catenary layout of a tile, because it or one of its neighbours changed.
+ * @param x X coordinate of the tile.
+ * @param y Y coordinate of the tile.
+ */
+void InvalidateCatenaryLayout(uint x, uint y)
+{
+	GetCachedCatenaryLayout(x, y)->generation = 0;
+}
+
+/** Forget the cached catenary layouts of all tiles. */
+void InvalidateAllCatenaryLayouts()
+{
+	_catenary_layout_generation++;
+	if (_catenary_layout_generation == 0) _catenary_layout_generation = 1;
+}
+
+/**
+ * Determine where the pylons and wires of a tile go.
+ * @param ti The Tileinfo of the tile
+ * @param[out] layout Where to store the layout
+ */
+static void DetermineRailCatenaryLayout(const TileInfo *ti, CatenaryLayout *layout)
 {
 	/* Pylons are placed on a tile edge, so we need to take into account
 	 * the track configuration of 2 adjacent tiles. trackconfig[0] stores the
@@ -289,6 +342,7 @@ static void DrawRailCatenaryRailway(const TileInfo *ti)
 		halftile_corner = GetHalftileSlopeCorner(tileh[TS_HOME]);
 		tileh[TS_HOME] = SLOPE_FLAT;
 	}
+	layout->halftile_corner = halftile_corner;
 
 	TLG tlg = GetTLG(ti->tile);
 	byte PCPstatus = 0;
@@ -309,19 +363,11 @@ static void DrawRailCatenaryRailway(const TileInfo *ti)
 
 	AdjustTileh(ti->tile, &tileh[TS_HOME]);
 
-	SpriteID pylon_normal = GetPylonBase(ti->tile);
-	SpriteID pylon_halftile = (halftile_corner != CORNER_INVALID) ? GetPylonBase(ti->tile, TCX_UPPER_HALFTILE) : pylon_normal;
-
 	for (DiagDirection i = DIAGDIR_BEGIN; i < DIAGDIR_END; i++) {
-		static const uint edge_corners[] = {
-			1 << CORNER_N | 1 << CORNER_E, // DIAGDIR_NE
-			1 << CORNER_S | 1 << CORNER_E, // DIAGDIR_SE
-			1 << CORNER_S | 1 << CORNER_W, // DIAGDIR_SW
-			1 << CORNER_N | 1 << CORNER_W, // DIAGDIR_NW
-		};
-		SpriteID pylon_base = (halftile_corner != CORNER_INVALID && HasBit(edge_corners[i], halftile_corner)) ? pylon_halftile : pylon_normal;
 		TileIndex neighbour = ti->tile + TileOffsByDiagDir(i);
 		int elevation = GetPCPElevation(ti->tile, i);
+		layout->pylon_ppp[i] = INVALID_DIR;
+		layout->pylon_z[i] = elevation;
 
 		/* Here's one of the main headaches. GetTileSlope does not correct for possibly
 		 * existing foundataions, so we do have to do that manually later on.*/
@@ -424,9 +470,6 @@ static void DrawRailCatenaryRailway(const TileInfo *ti)
 				byte temp = PPPorder[i][GetTLG(ti->tile)][k];
 
 				if (HasBit(PPPallowed[i], temp)) {
-					uint x  = ti->x + x_pcp_offsets[i] + x_ppp_offsets[temp];
-					uint y  = ti->y + y_pcp_offsets[i] + y_ppp_offsets[temp];
-
 					/* Don't build the pylon if it would be outside the tile */
 					if (!HasBit(OwnedPPPonPCP[i], temp)) {
 						/* We have a neighbour that will draw it, bail out */
@@ -434,60 +477,115 @@ static void DrawRailCatenaryRailway(const TileInfo *ti)
 						continue; // No neighbour, go looking for a better position
 					}
 
-					AddSortableSpriteToDraw(pylon_base + pylon_sprites[temp], PAL_NONE, x, y, 1, 1, BB_HEIGHT_UNDER_BRIDGE,
-						elevation, IsTransparencySet(TO_CATENARY), -1, -1);
-
-					break; // We already have drawn a pylon, bail out
+					layout->pylon_ppp[i] = (Direction)temp;
+					break; // We already have a pylon, bail out
 				}
 			}
 		}
 	}
 
+	layout->wires = TRACK_BIT_NONE;
+	layout->wires_below_bridge = false;
+
 	/* The wire above the tunnel is drawn together with the tunnel-roof (see DrawRailCatenaryOnTunnel()) */
 	if (IsTunnelTile(ti->tile)) return;
 
 	/* Don't draw a wire under a low bridge */
-	if (IsBridgeAbove(ti->tile) && !IsTransparencySet(TO_BRIDGES)) {
+	if (IsBridgeAbove(ti->tile)) {
 		int height = GetBridgeHeight(GetNorthernBridgeEnd(ti->tile));
 
-		if (height <= GetTileMaxZ(ti->tile) + 1) return;
+		layout->wires_below_bridge = height <= GetTileMaxZ(ti->tile) + 1;
 	}
 
 	/* Don't draw a wire if the station tile does not want any */
 	if (IsRailStationTile(ti->tile) && !CanStationTileHaveWires(ti->tile)) return;
 
-	SpriteID wire_normal = GetWireBase(ti->tile);
-	SpriteID wire_halftile = (halftile_corner != CORNER_INVALID) ? GetWireBase(ti->tile, TCX_UPPER_HALFTILE) : wire_normal;
-	Track halftile_track;
-	switch (halftile_corner) {
-		case CORNER_W: halftile_track = TRACK_LEFT; break;
-		case CORNER_S: halftile_track = TRACK_LOWER; break;
-		case CORNER_E: halftile_track = TRACK_RIGHT; break;
-		case CORNER_N: halftile_track = TRACK_UPPER; break;
-		default:       halftile_track = INVALID_TRACK; break;
-	}
+	layout->wires = wireconfig[TS_HOME];
 
-	/* Drawing of pylons is finished, now draw the wires */
 	Track t;
 	FOR_EACH_SET_TRACK(t, wireconfig[TS_HOME]) {
-		SpriteID wire_base = (t == halftile_track) ? wire_halftile : wire_normal;
 		byte PCPconfig = HasBit(PCPstatus, PCPpositions[t][0]) +
 			(HasBit(PCPstatus, PCPpositions[t][1]) << 1);
 
-		const SortableSpriteStruct *sss;
 		int tileh_selector = !(tileh[TS_HOME] % 3) * tileh[TS_HOME] / 3; // tileh for the slopes, 0 otherwise
 
 		assert(PCPconfig != 0); // We have a pylon on neither end of the wire, that doesn't work (since we have no sprites for that)
 		assert(!IsSteepSlope(tileh[TS_HOME]));
-		sss = &RailCatenarySpriteData[Wires[tileh_selector][t][PCPconfig]];
+		layout->wire_sprite[t] = Wires[tileh_selector][t][PCPconfig];
 
 		/*
 		 * The "wire"-sprite position is inside the tile, i.e. 0 <= sss->?_offset < TILE_SIZE.
 		 * Therefore it is safe to use GetSlopePixelZ() for the elevation.
 		 * Also note that the result of GetSlopePixelZ() is very special for bridge-ramps.
 		 */
+		const SortableSpriteStruct *sss = &RailCatenarySpriteData[layout->wire_sprite[t]];
+		layout->wire_z[t] = GetSlopePixelZ(ti->x + sss->x_offset, ti->y + sss->y_offset);
+	}
+}
+
+/**
+ * Draws wires and, if required, pylons on a given tile
+ * @param ti The Tileinfo to draw the tile for
+ */
+static void DrawRailCatenaryRailway(const TileInfo *ti)
+{
+	TileIndex tile = ti->tile;
+	uint32 state[4];
+	GetTileDrawState(ti, state);
+
+	CatenaryLayout *layout = GetCachedCatenaryLayout(TileX(tile), TileY(tile));
+	if (layout->generation != _catenary_layout_generation || layout->tile != tile || memcmp(layout->state, state, sizeof(state)) != 0) {
+		DetermineRailCatenaryLayout(ti, layout);
+		layout->tile = tile;
+		layout->generation = _catenary_layout_generation;
+		memcpy(layout->state, state, sizeof(state));
+	}
+
+	/* The sprites of NewGRF rail types may change at any time, so they are not part of the layout. */
+	Corner halftile_corner = layout->halftile_corner;
+	SpriteID pylon_normal = GetPylonBase(tile);
+	SpriteID pylon_halftile = (halftile_corner != CORNER_INVALID) ? GetPylonBase(tile, TCX_UPPER_HALFTILE) : pylon_normal;
+
+	for (DiagDirection i = DIAGDIR_BEGIN; i < DIAGDIR_END; i++) {
+		static const uint edge_corners[] = {
+			1 << CORNER_N | 1 << CORNER_E, // DIAGDIR_NE
+			1 << CORNER_S | 1 << CORNER_E, // DIAGDIR_SE
+			1 << CORNER_S | 1 << CORNER_W, // DIAGDIR_SW
+			1 << CORNER_N | 1 << CORNER_W, // DIAGDIR_NW
+		};
+		Direction ppp = layout->pylon_ppp[i];
+		if (ppp == INVALID_DIR) continue;
+
+		SpriteID pylon_base = (halftile_corner != CORNER_INVALID && HasBit(edge_corners[i], halftile_corner)) ? pylon_halftile : pylon_normal;
+		uint x = ti->x + x_pcp_offsets[i] + x_ppp_offsets[ppp];
+		uint y = ti->y + y_pcp_offsets[i] + y_ppp_offsets[ppp];
+
+		AddSortableSpriteToDraw(pylon_base + pylon_sprites[ppp], PAL_NONE, x, y, 1, 1, BB_HEIGHT_UNDER_BRIDGE,
+			layout->pylon_z[i], IsTransparencySet(TO_CATENARY), -1, -1);
+	}
+
+	if (layout->wires == TRACK_BIT_NONE) return;
+	if (layout->wires_below_bridge && !IsTransparencySet(TO_BRIDGES)) return;
+
+	SpriteID wire_normal = GetWireBase(tile);
+	SpriteID wire_halftile = (halftile_corner != CORNER_INVALID) ? GetWireBase(tile, TCX_UPPER_HALFTILE) : wire_normal;
+	Track halftile_track;
+	switch (halftile_corner) {
+		case CORNER_W: halftile_track = TRACK_LEFT; break;
+		case CORNER_S: halftile_track = TRACK_LOWER; break;
+		case CORNER_E: halftile_track = TRACK_RIGHT; break;
+		case CORNER_N: halftile_track = TRACK_UPPER; break;
+		default:       halftile_track = INVALID_TRACK; break;
+	}
+
+	/* Drawing of pylons is finished, now draw the wires */
+	Track t;
+	FOR_EACH_SET_TRACK(t, layout->wires) {
+		SpriteID wire_base = (t == halftile_track) ? wire_halftile : wire_normal;
+		const SortableSpriteStruct *sss = &RailCatenarySpriteData[layout->wire_sprite[t]];
+
 		AddSortableSpriteToDraw(wire_base + sss->image_offset, PAL_NONE, ti->x + sss->x_offset, ti->y + sss->y_offset,
-			sss->x_size, sss->y_size, sss->z_size, GetSlopePixelZ(ti->x + sss->x_offset, ti->y + sss->y_offset) + sss->z_offset,
+			sss->x_size, sss->y_size, sss->z_size, layout->wire_z[t] + sss->z_offset,
 			IsTransparencySet(TO_CATENARY));
 	}
 }
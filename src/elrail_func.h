@@ -37,6 +37,8 @@ static inline bool HasRailCatenaryDrawn(RailType rt)
 void DrawRailCatenary(const TileInfo *ti);
 void DrawRailCatenaryOnTunnel(const TileInfo *ti);
 void DrawRailCatenaryOnBridge(const TileInfo *ti);
+void InvalidateCatenaryLayout(uint x, uint y);
+void InvalidateAllCatenaryLayouts();
 
 bool SettingsDisableElrail(int32 p1); ///< _settings_game.disable_elrail callback
 
@@ -711,6 +711,7 @@ void StartupEngines()
 	}
 
 	/* Invalidate any open purchase lists */
+	InvalidateEngineSortValues();
 	InvalidateWindowClassesData(WC_BUILD_VEHICLE);
 }
 
@@ -39,6 +39,8 @@ extern bool _engine_sort_show_hidden_engines[];
 extern const StringID _engine_sort_listing[][12];
 extern EngList_SortTypeFunction * const _engine_sort_functions[][11];
 
+void InvalidateEngineSortValues();
+
 uint GetEngineListHeight(VehicleType type);
 void DisplayVehicleSortDropDown(Window *w, VehicleType vehicle_type, int selected, int button);
 
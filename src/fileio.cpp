@@ -25,6 +25,11 @@
 #include <unistd.h>
 #include <pwd.h>
 #endif
+#if defined(UNIX) && !defined(__OS2__)
+#include <sys/mman.h>
+#include <fcntl.h>
+#define WITH_MMAP_FILES
+#endif
 #include <sys/stat.h>
 #include <algorithm>
 
@@ -80,15 +85,27 @@ const char *FioGetFilename(uint8 slot)
 	return _fio.shortnames[slot];
 }
 
+/** Forget the contents of the data buffer, e.g. because they belong to another file. */
+static inline void FioInvalidateBuffer()
+{
+	_fio.buffer = _fio.buffer_end = _fio.buffer_start;
+}
+
 /**
  * Seek in the current file.
+ * When the new position is within the data that has been read into the buffer
+ * already, only the position in the buffer is changed.
  * @param pos New position.
  * @param mode Type of seek (\c SEEK_CUR means \a pos is relative to current position, \c SEEK_SET means \a pos is absolute).
  */
 void FioSeekTo(size_t pos, int mode)
 {
 	if (mode == SEEK_CUR) pos += FioGetPos();
-	_fio.buffer = _fio.buffer_end = _fio.buffer_start + FIO_BUFFER_SIZE;
+	if (pos <= _fio.pos && _fio.pos - pos <= (size_t)(_fio.buffer_end - _fio.buffer_start)) {
+		_fio.buffer = _fio.buffer_end - (_fio.pos - pos);
+		return;
+	}
+	FioInvalidateBuffer();
 	_fio.pos = pos;
 	if (fseek(_fio.cur_fh, _fio.pos, SEEK_SET) < 0) {
 		DEBUG(misc, 0, "Seeking in %s failed", _fio.filename);
@@ -121,6 +138,11 @@ void FioSeekToFile(uint8 slot, size_t pos)
 #endif /* LIMITED_FDS */
 	f = _fio.handles[slot];
 	assert(f != NULL);
+	if (f != _fio.cur_fh) {
+		/* The buffer and position belong to the previous file; force a real seek. */
+		FioInvalidateBuffer();
+		_fio.pos = SIZE_MAX;
+	}
 	_fio.cur_fh = f;
 	_fio.filename = _fio.filenames[slot];
 	FioSeekTo(pos, SEEK_SET);
@@ -186,8 +208,15 @@ uint32 FioReadDword()
  */
 void FioReadBlock(void *ptr, size_t size)
 {
-	FioSeekTo(FioGetPos(), SEEK_SET);
-	_fio.pos += fread(ptr, 1, size, _fio.cur_fh);
+	/* Use what is in the buffer already, then read the rest directly. */
+	size_t buffered = min<size_t>(_fio.buffer_end - _fio.buffer, size);
+	memcpy(ptr, _fio.buffer, buffered);
+	_fio.buffer += buffered;
+	size -= buffered;
+	if (size == 0) return;
+
+	FioInvalidateBuffer();
+	_fio.pos += fread((byte *)ptr + buffered, 1, size, _fio.cur_fh);
 }
 
 /**
@@ -197,6 +226,8 @@ void FioReadBlock(void *ptr, size_t size)
 static inline void FioCloseFile(int slot)
 {
 	if (_fio.handles[slot] != NULL) {
+		/* A new file might get the same handle, so do not keep using the buffer. */
+		if (_fio.handles[slot] == _fio.cur_fh) _fio.cur_fh = NULL;
 		fclose(_fio.handles[slot]);
 
 		free(_fio.shortnames[slot]);
@@ -1211,6 +1242,8 @@ void DeterminePaths(const char *exe)
 	_hotkeys_file = str_fmt("%shotkeys.cfg", config_dir);
 	extern char *_windows_file;
 	_windows_file = str_fmt("%swindows.cfg", config_dir);
+	extern char *_newgrf_scan_cache_file;
+	_newgrf_scan_cache_file = str_fmt("%snewgrf_scan.dat", config_dir);
 
 #if defined(WITH_XDG_BASEDIR) && defined(WITH_PERSONAL_DIR)
 	if (config_dir == config_home) {
@@ -1318,6 +1351,56 @@ void *ReadFileToMem(const char *filename, size_t *lenp, size_t maxsize)
 	return mem;
 }
 
+/**
+ * Map a file read-only into memory. Processes mapping the same file share
+ * its memory, and only the parts that are used are actually read. Where
+ * mapping is not supported, the file is loaded with #ReadFileToMem instead.
+ * @param filename Name of the file to map.
+ * @param[out] lenp Length of the mapped data.
+ * @param maxsize Maximum size to map.
+ * @return Pointer to the data of the file, or \c NULL if mapping failed. Release it with #UnmapFileFromMem.
+ * @note Unlike #ReadFileToMem, the data is not followed by a terminating zero.
+ */
+const void *MapFileToMem(const char *filename, size_t *lenp, size_t maxsize)
+{
+#ifdef WITH_MMAP_FILES
+	int fd = open(OTTD2FS(filename), O_RDONLY);
+	if (fd < 0) return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0 || (size_t)st.st_size > maxsize) {
+		close(fd);
+		return NULL;
+	}
+
+	size_t len = st.st_size;
+	void *mem = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	/* The mapping stays valid after closing the file. */
+	close(fd);
+	if (mem == MAP_FAILED) return NULL;
+
+	*lenp = len;
+	return mem;
+#else
+	return ReadFileToMem(filename, lenp, maxsize);
+#endif
+}
+
+/**
+ * Release the memory of a file mapped with #MapFileToMem.
+ * @param mem The data of the file; may be \c NULL.
+ * @param len Length of the mapped data.
+ */
+void UnmapFileFromMem(const void *mem, size_t len)
+{
+	if (mem == NULL) return;
+#ifdef WITH_MMAP_FILES
+	munmap(const_cast<void *>(mem), len);
+#else
+	free(const_cast<void *>(mem));
+#endif
+}
+
 /**
  * Helper to see whether a given filename matches the extension.
  * @param extension The extension to look for.
@@ -1332,6 +1415,64 @@ static bool MatchesExtension(const char *extension, const char *filename)
 	return ext != NULL && strcasecmp(ext, extension) == 0;
 }
 
+/** The outermost #FileScanCache of this thread, or NULL if there is none. */
+static thread_local FileScanCache *_file_scan_cache = NULL;
+
+FileScanCache::FileScanCache() : outer(_file_scan_cache)
+{
+	if (_file_scan_cache == NULL) _file_scan_cache = this;
+}
+
+FileScanCache::~FileScanCache()
+{
+	if (_file_scan_cache == this) _file_scan_cache = this->outer;
+}
+
+/**
+ * Read the directories and regular files of a directory.
+ * @param path    The directory, ending with a path separator.
+ * @param listing [out] The entries of the directory.
+ * @return False if the directory cannot be opened.
+ */
+static bool ReadDirectoryListing(const char *path, FileScanCache::Listing &listing)
+{
+	extern bool FiosIsValidFile(const char *path, const struct dirent *ent, struct stat *sb);
+
+	struct stat sb;
+	struct dirent *dirent;
+	DIR *dir;
+
+	if (path == NULL || (dir = ttd_opendir(path)) == NULL) return false;
+
+	while ((dirent = readdir(dir)) != NULL) {
+		if (!FiosIsValidFile(path, dirent, &sb)) continue;
+		if (!S_ISDIR(sb.st_mode) && !S_ISREG(sb.st_mode)) continue;
+		listing.push_back(std::make_pair(std::string(FS2OTTD(dirent->d_name)), S_ISDIR(sb.st_mode)));
+	}
+
+	closedir(dir);
+	return true;
+}
+
+/**
+ * Get the listing of a directory from the active cache, reading it if needed.
+ * Directories that cannot be opened get an empty listing; most search paths
+ * do not exist, so remembering that saves a lot of lookups too.
+ * @param path The directory, ending with a path separator.
+ * @return The listing, or NULL if no cache is active.
+ */
+/* static */ const FileScanCache::Listing *FileScanCache::GetListing(const char *path)
+{
+	if (_file_scan_cache == NULL || path == NULL) return NULL;
+
+	std::map<std::string, Listing>::iterator it = _file_scan_cache->listings.find(path);
+	if (it == _file_scan_cache->listings.end()) {
+		it = _file_scan_cache->listings.insert(std::make_pair(std::string(path), Listing())).first;
+		ReadDirectoryListing(path, it->second);
+	}
+	return &it->second;
+}
+
 /**
  * Scan a single directory (and recursively its children) and add
  * any graphics sets that are found.
@@ -1343,37 +1484,33 @@ static bool MatchesExtension(const char *extension, const char *filename)
  */
 static uint ScanPath(FileScanner *fs, const char *extension, const char *path, size_t basepath_length, bool recursive)
 {
-	extern bool FiosIsValidFile(const char *path, const struct dirent *ent, struct stat *sb);
-
 	uint num = 0;
-	struct stat sb;
-	struct dirent *dirent;
-	DIR *dir;
 
-	if (path == NULL || (dir = ttd_opendir(path)) == NULL) return 0;
+	FileScanCache::Listing uncached;
+	const FileScanCache::Listing *listing = FileScanCache::GetListing(path);
+	if (listing == NULL) {
+		if (!ReadDirectoryListing(path, uncached)) return 0;
+		listing = &uncached;
+	}
 
-	while ((dirent = readdir(dir)) != NULL) {
-		const char *d_name = FS2OTTD(dirent->d_name);
+	for (FileScanCache::Listing::const_iterator it = listing->begin(); it != listing->end(); ++it) {
+		const char *d_name = it->first.c_str();
 		char filename[MAX_PATH];
 
-		if (!FiosIsValidFile(path, dirent, &sb)) continue;
-
 		seprintf(filename, lastof(filename), "%s%s", path, d_name);
 
-		if (S_ISDIR(sb.st_mode)) {
+		if (it->second) {
 			/* Directory */
 			if (!recursive) continue;
 			if (strcmp(d_name, ".") == 0 || strcmp(d_name, "..") == 0) continue;
 			if (!AppendPathSeparator(filename, lastof(filename))) continue;
 			num += ScanPath(fs, extension, filename, basepath_length, recursive);
-		} else if (S_ISREG(sb.st_mode)) {
+		} else {
 			/* File */
 			if (MatchesExtension(extension, filename) && fs->AddFile(filename, basepath_length, NULL)) num++;
 		}
 	}
 
-	closedir(dir);
-
 	return num;
 }
 
@@ -14,6 +14,9 @@
 
 #include "core/enum_type.hpp"
 #include "fileio_type.h"
+#include <map>
+#include <string>
+#include <vector>
 
 void FioSeekTo(size_t pos, int mode);
 void FioSeekToFile(uint8 slot, size_t pos);
@@ -63,6 +66,8 @@ void SanitizeFilename(char *filename);
 bool AppendPathSeparator(char *buf, const char *last);
 void DeterminePaths(const char *exe);
 void *ReadFileToMem(const char *filename, size_t *lenp, size_t maxsize);
+const void *MapFileToMem(const char *filename, size_t *lenp, size_t maxsize);
+void UnmapFileFromMem(const void *mem, size_t len);
 bool FileExists(const char *filename);
 const char *FioTarFirstDir(const char *tarname, Subdirectory subdir);
 void FioTarAddLink(const char *src, const char *dest, Subdirectory subdir);
@@ -117,6 +122,28 @@ public:
 
 DECLARE_ENUM_AS_BIT_SET(TarScanner::Mode)
 
+/**
+ * While an instance exists, the directory listings read by a #FileScanner on
+ * this thread are kept, so scanning the same directories again, e.g. for
+ * another extension or by another scanner, does not go to the disk again.
+ * Only use it around a series of scans during which no files are added or
+ * removed. Nested instances share the listings of the outermost one.
+ */
+class FileScanCache {
+public:
+	/** Directories and regular files of a directory, with whether they are a directory. */
+	typedef std::vector<std::pair<std::string, bool> > Listing;
+
+	FileScanCache();
+	~FileScanCache();
+
+	static const Listing *GetListing(const char *path);
+
+private:
+	FileScanCache *outer;                   ///< Instance that was active when this one was created.
+	std::map<std::string, Listing> listings; ///< Listings read so far, by path.
+};
+
 /* Implementation of opendir/readdir/closedir for Windows */
 #if defined(_WIN32)
 struct DIR;
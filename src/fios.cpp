@@ -19,6 +19,9 @@
 #include "screenshot.h"
 #include "string_func.h"
 #include <sys/stat.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #ifndef _WIN32
 # include <unistd.h>
@@ -256,6 +259,20 @@ bool FiosDelete(const char *name)
 
 typedef FiosType fios_getlist_callback_proc(SaveLoadOperation fop, const char *filename, const char *ext, char *title, const char *last);
 
+/**
+ * What the callback of a file list found out about a file, so building the
+ * list again does not need to open the file (or its title file) again.
+ */
+struct FiosFileInfo {
+	uint64 mtime;                              ///< Modification time of the file when it was looked at.
+	SaveLoadOperation fop;                     ///< Purpose of the list the file was looked at for.
+	fios_getlist_callback_proc *callback_proc; ///< Callback that looked at the file.
+	char title[64];                            ///< Title the callback found; empty when it found none.
+};
+
+/** The files looked at for file lists, by name. */
+static std::unordered_map<std::string, FiosFileInfo> _fios_file_info;
+
 /**
  * Scanner to scan for a particular type of FIOS file.
  */
@@ -263,6 +280,7 @@ class FiosFileScanner : public FileScanner {
 	SaveLoadOperation fop;   ///< The kind of file we are looking for.
 	fios_getlist_callback_proc *callback_proc; ///< Callback to check whether the file may be added
 	FileList &file_list;     ///< Destination of the found files.
+	std::unordered_set<std::string> names; ///< Names of the files added to #file_list.
 public:
 	/**
 	 * Create the scanner
@@ -288,15 +306,11 @@ bool FiosFileScanner::AddFile(const char *filename, size_t basepath_length, cons
 	const char *ext = strrchr(filename, '.');
 	if (ext == NULL) return false;
 
-	char fios_title[64];
-	fios_title[0] = '\0'; // reset the title;
-
-	FiosType type = this->callback_proc(this->fop, filename, ext, fios_title, lastof(fios_title));
+	/* Only determine the type; looking up the title may need to open files. */
+	FiosType type = this->callback_proc(this->fop, filename, ext, NULL, NULL);
 	if (type == FIOS_TYPE_INVALID) return false;
 
-	for (const FiosItem *fios = file_list.Begin(); fios != file_list.End(); fios++) {
-		if (strcmp(fios->name, filename) == 0) return false;
-	}
+	if (!this->names.insert(filename).second) return false;
 
 	FiosItem *fios = file_list.Append();
 #ifdef _WIN32
@@ -311,6 +325,17 @@ bool FiosFileScanner::AddFile(const char *filename, size_t basepath_length, cons
 		fios->mtime = 0;
 	}
 
+	/* Look up the title, unless the file did not change since it was looked at last. */
+	FiosFileInfo &info = _fios_file_info[filename];
+	if (fios->mtime == 0 || info.mtime != fios->mtime || info.fop != this->fop || info.callback_proc != this->callback_proc) {
+		info.mtime = fios->mtime;
+		info.fop = this->fop;
+		info.callback_proc = this->callback_proc;
+		info.title[0] = '\0'; // reset the title;
+		this->callback_proc(this->fop, filename, ext, info.title, lastof(info.title));
+	}
+	const char *fios_title = info.title;
+
 	fios->type = type;
 	strecpy(fios->name, filename, lastof(fios->name));
 
@@ -405,12 +430,14 @@ static void FiosGetFileList(SaveLoadOperation fop, fios_getlist_callback_proc *c
  * Get the title of a file, which (if exists) is stored in a file named
  * the same as the data file but with '.title' added to it.
  * @param file filename to get the title for
- * @param title the title buffer to fill
+ * @param title the title buffer to fill; NULL to skip the lookup
  * @param last the last element in the title buffer
  * @param subdir the sub directory to search in
  */
 static void GetFileTitle(const char *file, char *title, const char *last, Subdirectory subdir)
 {
+	if (title == NULL) return;
+
 	char buf[MAX_PATH];
 	strecpy(buf, file, lastof(buf));
 	strecat(buf, ".title", lastof(buf));
@@ -491,8 +518,8 @@ void FiosGetSavegameList(SaveLoadOperation fop, FileList &file_list)
  * @param fop Purpose of collecting the list.
  * @param file Name of the file to check.
  * @param ext A pointer to the extension identifier inside file
- * @param title Buffer if a callback wants to lookup the title of the file
- * @param last Last available byte in buffer (to prevent buffer overflows)
+ * @param title Buffer if a callback wants to lookup the title of the file; NULL to skip the lookup
+ * @param last Last available byte in buffer (to prevent buffer overflows); not used when title == NULL
  * @return a FIOS_TYPE_* type of the found file, FIOS_TYPE_INVALID if not a scenario
  * @see FiosGetFileList
  * @see FiosGetScenarioList
@@ -510,7 +537,7 @@ static FiosType FiosGetScenarioListCallback(SaveLoadOperation fop, const char *f
 
 	if (fop == SLO_LOAD) {
 		if (strcasecmp(ext, ".sv0") == 0 || strcasecmp(ext, ".ss0") == 0 ) {
-			GetOldSaveGameName(file, title, last);
+			if (title != NULL) GetOldSaveGameName(file, title, last);
 			return FIOS_TYPE_OLD_SCENARIO;
 		}
 	}
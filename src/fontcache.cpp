@@ -205,6 +205,12 @@ bool SpriteFontCache::GetDrawGlyphShadow()
 #include FT_GLYPH_H
 #include FT_TRUETYPE_TABLES_H
 
+#include <vector>
+
+static const size_t GLYPH_ATLAS_BLOCK_SIZE = 64 * 1024; ///< Size of the blocks of memory the glyph atlas is made of.
+static const char GLYPH_PREWARM_FIRST = ASCII_LETTERSTART; ///< First character that is rasterised when a font cache is filled.
+static const char GLYPH_PREWARM_LAST  = '~';               ///< Last character that is rasterised when a font cache is filled.
+
 /** Font cache for fonts that are based on a freetype font. */
 class FreeTypeFontCache : public FontCache {
 private:
@@ -237,9 +243,24 @@ private:
 	 */
 	GlyphEntry **glyph_to_sprite;
 
+	/**
+	 * The glyph atlas. The encoded sprites of the glyphs are packed into a
+	 * few large blocks instead of being allocated one by one, so the glyphs
+	 * of a string are drawn from contiguous memory and freeing them all only
+	 * takes a few calls.
+	 */
+	std::vector<byte *> atlas_blocks;
+	size_t atlas_used; ///< Number of bytes used of the last block of the atlas.
+
+	static FreeTypeFontCache *encoding; ///< Font cache whose atlas receives the glyph that is being encoded.
+
 	GlyphEntry *GetGlyphPtr(GlyphID key);
 	void SetGlyphPtr(GlyphID key, const GlyphEntry *glyph, bool duplicate = false);
 	void SetFontSize(FontSize fs, FT_Face face, int pixels);
+	void *AllocateGlyphMemory(size_t size);
+	Sprite *EncodeGlyph(const SpriteLoader::Sprite *sprite);
+	void PrewarmGlyphs();
+	static void *AllocateFont(size_t size);
 
 public:
 	FreeTypeFontCache(FontSize fs, FT_Face face, int pixels);
@@ -265,13 +286,15 @@ FreeTypeSettings _freetype;
 static const byte FACE_COLOUR   = 1;
 static const byte SHADOW_COLOUR = 2;
 
+/* static */ FreeTypeFontCache *FreeTypeFontCache::encoding = NULL;
+
 /**
  * Create a new FreeTypeFontCache.
  * @param fs     The font size that is going to be cached.
  * @param face   The font that has to be loaded.
  * @param pixels The number of pixels this font should be high.
  */
-FreeTypeFontCache::FreeTypeFontCache(FontSize fs, FT_Face face, int pixels) : FontCache(fs), face(face), req_size(pixels), glyph_to_sprite(NULL)
+FreeTypeFontCache::FreeTypeFontCache(FontSize fs, FT_Face face, int pixels) : FontCache(fs), face(face), req_size(pixels), glyph_to_sprite(NULL), atlas_used(GLYPH_ATLAS_BLOCK_SIZE)
 {
 	assert(face != NULL);
 
@@ -429,17 +452,17 @@ void FreeTypeFontCache::ClearFontCache()
 	for (int i = 0; i < 256; i++) {
 		if (this->glyph_to_sprite[i] == NULL) continue;
 
-		for (int j = 0; j < 256; j++) {
-			if (this->glyph_to_sprite[i][j].duplicate) continue;
-			free(this->glyph_to_sprite[i][j].sprite);
-		}
-
 		free(this->glyph_to_sprite[i]);
 	}
 
 	free(this->glyph_to_sprite);
 	this->glyph_to_sprite = NULL;
 
+	/* The sprites of all glyphs live in the atlas. */
+	for (std::vector<byte *>::iterator it = this->atlas_blocks.begin(); it != this->atlas_blocks.end(); ++it) free(*it);
+	this->atlas_blocks.clear();
+	this->atlas_used = GLYPH_ATLAS_BLOCK_SIZE;
+
 	Layouter::ResetFontCache(this->fs);
 }
 
@@ -469,9 +492,75 @@ void FreeTypeFontCache::SetGlyphPtr(GlyphID key, const GlyphEntry *glyph, bool d
 	this->glyph_to_sprite[GB(key, 8, 8)][GB(key, 0, 8)].duplicate = duplicate;
 }
 
-static void *AllocateFont(size_t size)
+/**
+ * Get memory for an encoded glyph from the glyph atlas.
+ * @param size The number of bytes needed.
+ * @return The memory for the glyph; it is freed when the font cache is cleared.
+ */
+void *FreeTypeFontCache::AllocateGlyphMemory(size_t size)
+{
+	/* Keep the sprites aligned like malloc would, as some blitters use aligned loads. */
+	size = Align(size, 16);
+
+	if (size > GLYPH_ATLAS_BLOCK_SIZE / 4) {
+		/* Do not waste most of a block on a huge glyph; give it a block of its own
+		 * at the front, so the last block can still be filled. */
+		byte *block = MallocT<byte>(size);
+		this->atlas_blocks.insert(this->atlas_blocks.begin(), block);
+		return block;
+	}
+
+	if (this->atlas_used + size > GLYPH_ATLAS_BLOCK_SIZE) {
+		DEBUG(freetype, 3, "Allocating glyph atlas block %u for size %u", (uint)this->atlas_blocks.size(), this->fs);
+		this->atlas_blocks.push_back(MallocT<byte>(GLYPH_ATLAS_BLOCK_SIZE));
+		this->atlas_used = 0;
+	}
+
+	void *mem = this->atlas_blocks.back() + this->atlas_used;
+	this->atlas_used += size;
+	return mem;
+}
+
+/**
+ * Sprite allocator for the blitter, which puts the sprite into the atlas of the font cache that is encoding a glyph.
+ * @param size The number of bytes needed.
+ * @return The memory for the sprite.
+ */
+/* static */ void *FreeTypeFontCache::AllocateFont(size_t size)
+{
+	assert(FreeTypeFontCache::encoding != NULL);
+	return FreeTypeFontCache::encoding->AllocateGlyphMemory(size);
+}
+
+/**
+ * Encode a rendered glyph for the current blitter into the glyph atlas.
+ * @param sprite The rendered glyph.
+ * @return The encoded sprite.
+ */
+Sprite *FreeTypeFontCache::EncodeGlyph(const SpriteLoader::Sprite *sprite)
 {
-	return MallocT<byte>(size);
+	FreeTypeFontCache::encoding = this;
+	Sprite *spr = BlitterFactory::GetCurrentBlitter()->Encode(sprite, FreeTypeFontCache::AllocateFont);
+	FreeTypeFontCache::encoding = NULL;
+	return spr;
+}
+
+/**
+ * Rasterise the glyphs of the printable ASCII characters in one go when the
+ * cache is (re)filled. Nearly every string uses them, so they end up next to
+ * each other in the atlas and the first redraw does not rasterise them one
+ * string at a time.
+ */
+void FreeTypeFontCache::PrewarmGlyphs()
+{
+	/* Allocate the root table first, so the glyphs below do not prewarm again. */
+	DEBUG(freetype, 3, "Allocating root glyph cache for size %u", this->fs);
+	this->glyph_to_sprite = CallocT<GlyphEntry*>(256);
+
+	for (WChar c = GLYPH_PREWARM_FIRST; c <= (WChar)GLYPH_PREWARM_LAST; c++) {
+		GlyphID glyph = this->MapCharToGlyph(c);
+		if (glyph != 0) this->GetGlyph(glyph);
+	}
 }
 
 
@@ -499,6 +588,14 @@ const Sprite *FreeTypeFontCache::GetGlyph(GlyphID key)
 	GlyphEntry *glyph = this->GetGlyphPtr(key);
 	if (glyph != NULL && glyph->sprite != NULL) return glyph->sprite;
 
+	if (this->glyph_to_sprite == NULL) {
+		this->PrewarmGlyphs();
+
+		/* The glyph might have been one of the prewarmed ones. */
+		glyph = this->GetGlyphPtr(key);
+		if (glyph != NULL && glyph->sprite != NULL) return glyph->sprite;
+	}
+
 	FT_GlyphSlot slot = this->face->glyph;
 
 	bool aa = GetFontAAState(this->fs);
@@ -534,7 +631,7 @@ const Sprite *FreeTypeFontCache::GetGlyph(GlyphID key)
 				builtin_questionmark_data
 			};
 
-			Sprite *spr = BlitterFactory::GetCurrentBlitter()->Encode(&builtin_questionmark, AllocateFont);
+			Sprite *spr = this->EncodeGlyph(&builtin_questionmark);
 			assert(spr != NULL);
 			new_glyph.sprite = spr;
 			new_glyph.width  = spr->width + (this->fs != FS_NORMAL);
@@ -591,7 +688,7 @@ const Sprite *FreeTypeFontCache::GetGlyph(GlyphID key)
 		}
 	}
 
-	new_glyph.sprite = BlitterFactory::GetCurrentBlitter()->Encode(&sprite, AllocateFont);
+	new_glyph.sprite = this->EncodeGlyph(&sprite);
 	new_glyph.width  = slot->advance.x >> 6;
 
 	this->SetGlyphPtr(key, &new_glyph);
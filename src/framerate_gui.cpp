@@ -11,7 +11,12 @@
 
 #include "framerate_type.h"
 #include <chrono>
+#include <atomic>
+#include <vector>
+#include "thread/thread.h"
 #include "gfx_func.h"
+#include "gfx_layout.h"
+#include "viewport_func.h"
 #include "window_gui.h"
 #include "window_func.h"
 #include "table/sprites.h"
@@ -22,6 +27,7 @@
 #include "guitimer_func.h"
 #include "company_base.h"
 #include "ai/ai_info.hpp"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "widgets/framerate_widget.h"
 #include "safeguards.h"
@@ -59,13 +65,18 @@ namespace {
 		/** Start time for current accumulation cycle */
 		TimingMeasurement acc_timestamp;
 
+		/** Sum of the durations of all cycles since the totals were last reset */
+		TimingMeasurement total_duration;
+		/** Number of cycles since the totals were last reset */
+		uint32 total_count;
+
 		/**
 		 * Initialize a data element with an expected collection rate
 		 * @param expected_rate
 		 * Expected number of cycles per second of the performance element. Use 1 if unknown or not relevant.
 		 * The rate is used for highlighting slow-running elements in the GUI.
 		 */
-		explicit PerformanceData(double expected_rate) : expected_rate(expected_rate), next_index(0), prev_index(0), num_valid(0) { }
+		explicit PerformanceData(double expected_rate) : expected_rate(expected_rate), next_index(0), prev_index(0), num_valid(0), total_duration(0), total_count(0) { }
 
 		/** Collect a complete measurement, given start and ending times for a processing block */
 		void Add(TimingMeasurement start_time, TimingMeasurement end_time)
@@ -76,6 +87,9 @@ namespace {
 			this->next_index += 1;
 			if (this->next_index >= NUM_FRAMERATE_POINTS) this->next_index = 0;
 			this->num_valid = min(NUM_FRAMERATE_POINTS, this->num_valid + 1);
+
+			this->total_duration += end_time - start_time;
+			this->total_count++;
 		}
 
 		/** Begin an accumulation of multiple measurements into a single value, from a given start time */
@@ -88,6 +102,9 @@ namespace {
 			if (this->next_index >= NUM_FRAMERATE_POINTS) this->next_index = 0;
 			this->num_valid = min(NUM_FRAMERATE_POINTS, this->num_valid + 1);
 
+			this->total_duration += this->acc_duration;
+			this->total_count++;
+
 			this->acc_duration = 0;
 			this->acc_timestamp = start_time;
 		}
@@ -222,6 +239,132 @@ static TimingMeasurement GetPerformanceTimer()
 }
 
 
+/** One event of the performance trace. */
+struct PerformanceTraceEvent {
+	const char *name;       ///< Name of the event; a string that lives as long as the game.
+	TimingMeasurement start; ///< Begin of the event.
+	uint32 duration;        ///< Length of the event.
+	uint32 thread;          ///< Number of the thread the event happened on.
+};
+
+/** Maximum number of events of one trace; later events are dropped. */
+static const uint MAX_PERFORMANCE_TRACE_EVENTS = 1 << 22;
+
+static std::atomic<bool> _pf_trace_active(false);      ///< Whether a trace is running.
+static ThreadMutex *_pf_trace_mutex = ThreadMutex::New(); ///< Protects the trace data below.
+static std::vector<PerformanceTraceEvent> _pf_trace_events; ///< The events of the running trace.
+static TimingMeasurement _pf_trace_start;                ///< Begin of the running trace.
+static uint _pf_trace_dropped;                           ///< Number of events dropped because the trace was full.
+static uint32 _pf_trace_threads;                         ///< Number of threads that recorded events.
+
+/**
+ * Add an event to the running trace.
+ * @param name  Name of the event.
+ * @param start Begin of the event.
+ * @param end   End of the event.
+ */
+static void AddTraceEvent(const char *name, TimingMeasurement start, TimingMeasurement end)
+{
+	static thread_local uint32 thread = 0;
+
+	ThreadMutexLocker lock(_pf_trace_mutex);
+	if (!_pf_trace_active.load(std::memory_order_relaxed)) return;
+	if (_pf_trace_events.size() >= MAX_PERFORMANCE_TRACE_EVENTS) {
+		_pf_trace_dropped++;
+		return;
+	}
+	if (thread == 0) thread = ++_pf_trace_threads;
+
+	PerformanceTraceEvent ev;
+	ev.name = name;
+	ev.start = start;
+	ev.duration = (uint32)min<TimingMeasurement>(end - start, UINT32_MAX);
+	ev.thread = thread;
+	_pf_trace_events.push_back(ev);
+}
+
+/**
+ * Start recording a trace of the measured elements and other marked scopes.
+ * @return False if a trace is running already.
+ */
+bool StartPerformanceTrace()
+{
+	ThreadMutexLocker lock(_pf_trace_mutex);
+	if (_pf_trace_active.load(std::memory_order_relaxed)) return false;
+
+	_pf_trace_events.clear();
+	_pf_trace_start = GetPerformanceTimer();
+	_pf_trace_dropped = 0;
+	_pf_trace_active.store(true, std::memory_order_relaxed);
+	return true;
+}
+
+/**
+ * Stop the running trace and write it in the trace event format of Chrome,
+ * which can be read by chrome://tracing and Perfetto.
+ * @param filename      File to write the trace to.
+ * @param[out] events  Number of events written.
+ * @param[out] dropped Number of events that did not fit in the trace.
+ * @return False if no trace was running or the file could not be written.
+ */
+bool StopPerformanceTrace(const char *filename, uint *events, uint *dropped)
+{
+	std::vector<PerformanceTraceEvent> trace;
+	TimingMeasurement trace_start;
+	{
+		ThreadMutexLocker lock(_pf_trace_mutex);
+		if (!_pf_trace_active.load(std::memory_order_relaxed)) return false;
+		_pf_trace_active.store(false, std::memory_order_relaxed);
+
+		trace.swap(_pf_trace_events);
+		trace_start = _pf_trace_start;
+		*dropped = _pf_trace_dropped;
+	}
+	*events = (uint)trace.size();
+
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) return false;
+
+	fputs("{\"traceEvents\":[\n", f);
+	for (std::vector<PerformanceTraceEvent>::const_iterator it = trace.begin(); it != trace.end(); ++it) {
+		fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":" OTTD_PRINTF64 ",\"dur\":%u}\n",
+				it == trace.begin() ? "" : ",", it->name, it->thread, (int64)(it->start - trace_start), it->duration);
+	}
+	fputs("],\"displayTimeUnit\":\"ms\"}\n", f);
+
+	bool ok = ferror(f) == 0;
+	fclose(f);
+	return ok;
+}
+
+/**
+ * Add an event that ends now to the running trace, if any.
+ * @param name        Name of the event; a string that lives as long as the game.
+ * @param duration_us Length of the event, in microseconds.
+ */
+void AddPerformanceTraceEvent(const char *name, uint duration_us)
+{
+	if (!_pf_trace_active.load(std::memory_order_relaxed)) return;
+	TimingMeasurement now = GetPerformanceTimer();
+	AddTraceEvent(name, now - min<TimingMeasurement>(duration_us, now), now);
+}
+
+/**
+ * Begin an event of the performance trace.
+ * @param name Name of the event; a string that lives as long as the game.
+ */
+PerformanceTraceScope::PerformanceTraceScope(const char *name) : name(name)
+{
+	this->start_time = _pf_trace_active.load(std::memory_order_relaxed) ? GetPerformanceTimer() : 0;
+}
+
+/** End an event of the performance trace. */
+PerformanceTraceScope::~PerformanceTraceScope()
+{
+	if (this->start_time == 0 || !_pf_trace_active.load(std::memory_order_relaxed)) return;
+	AddTraceEvent(this->name, this->start_time, GetPerformanceTimer());
+}
+
 /**
  * Begin a cycle of a measured element.
  * @param elem The element to be measured
@@ -246,7 +389,9 @@ PerformanceMeasurer::~PerformanceMeasurer()
 			return;
 		}
 	}
-	_pf_data[this->elem].Add(this->start_time, GetPerformanceTimer());
+	TimingMeasurement end_time = GetPerformanceTimer();
+	_pf_data[this->elem].Add(this->start_time, end_time);
+	if (_pf_trace_active.load(std::memory_order_relaxed)) AddTraceEvent(GetPerformanceElementKey(this->elem), this->start_time, end_time);
 }
 
 /** Set the rate of expected cycles per second of a performance element. */
@@ -288,7 +433,9 @@ PerformanceAccumulator::PerformanceAccumulator(PerformanceElement elem)
 /** Finish and add one block of the accumulating value. */
 PerformanceAccumulator::~PerformanceAccumulator()
 {
-	_pf_data[this->elem].AddAccumulate(GetPerformanceTimer() - this->start_time);
+	TimingMeasurement end_time = GetPerformanceTimer();
+	_pf_data[this->elem].AddAccumulate(end_time - this->start_time);
+	if (_pf_trace_active.load(std::memory_order_relaxed)) AddTraceEvent(GetPerformanceElementKey(this->elem), this->start_time, end_time);
 }
 
 /**
@@ -301,6 +448,63 @@ void PerformanceAccumulator::Reset(PerformanceElement elem)
 	_pf_data[elem].BeginAccumulate(GetPerformanceTimer());
 }
 
+/**
+ * Get a summary of the measurements of a performance element, for reporting them outside of the framerate window.
+ * @param elem The element to get the summary of.
+ * @param[out] rate The current rate, in cycles per second.
+ * @param[out] short_ms The average processing time of the last few cycles, in milliseconds.
+ * @param[out] long_ms The average processing time of all recorded cycles, in milliseconds.
+ * @return Whether there are measurements for the element.
+ */
+bool GetPerformanceSummary(PerformanceElement elem, double *rate, double *short_ms, double *long_ms)
+{
+	PerformanceData &pf = _pf_data[elem];
+	*rate = pf.GetRate();
+	*short_ms = pf.GetAverageDurationMilliseconds(8);
+	*long_ms = pf.GetAverageDurationMilliseconds(NUM_FRAMERATE_POINTS);
+	return pf.num_valid > 0;
+}
+
+/** Start counting the totals of all performance elements anew. */
+void ResetPerformanceTotals()
+{
+	for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) {
+		_pf_data[e].total_duration = 0;
+		_pf_data[e].total_count = 0;
+	}
+}
+
+/**
+ * Get the total processing time of a performance element since the totals were last reset.
+ * @param elem The element to get the total of.
+ * @param[out] total_ms The total processing time, in milliseconds.
+ * @return The number of cycles the total is of.
+ */
+uint32 GetPerformanceTotals(PerformanceElement elem, double *total_ms)
+{
+	PerformanceData &pf = _pf_data[elem];
+	*total_ms = (double)pf.total_duration * 1000 / TIMESTAMP_PRECISION;
+	return pf.total_count;
+}
+
+/**
+ * Get a short name of a performance element, for machine readable output.
+ * @param elem The element.
+ * @return The name.
+ */
+const char *GetPerformanceElementKey(PerformanceElement elem)
+{
+	static const char * const keys[] = {
+		"gameloop", "gl_economy", "gl_trains", "gl_roadvehs", "gl_ships", "gl_aircraft", "gl_landscape", "gl_linkgraph",
+		"drawing", "drawworld", "video", "sound", "allscripts", "gamescript",
+		"ai1", "ai2", "ai3", "ai4", "ai5", "ai6", "ai7", "ai8", "ai9", "ai10", "ai11", "ai12", "ai13", "ai14", "ai15",
+	};
+	assert_compile(lengthof(keys) == PFE_MAX);
+
+	assert(elem < PFE_MAX);
+	return keys[elem];
+}
+
 
 void ShowFrametimeGraphWindow(PerformanceElement elem);
 
@@ -356,6 +560,10 @@ static const NWidgetPart _framerate_window_widgets[] = {
 			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_RATE_GAMELOOP), SetDataTip(STR_FRAMERATE_RATE_GAMELOOP, STR_FRAMERATE_RATE_GAMELOOP_TOOLTIP),
 			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_RATE_DRAWING),  SetDataTip(STR_FRAMERATE_RATE_BLITTER,  STR_FRAMERATE_RATE_BLITTER_TOOLTIP),
 			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_RATE_FACTOR),   SetDataTip(STR_FRAMERATE_SPEED_FACTOR,  STR_FRAMERATE_SPEED_FACTOR_TOOLTIP),
+			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_RATE_PF_CACHE), SetDataTip(STR_FRAMERATE_RAIL_PF_CACHE, STR_FRAMERATE_RAIL_PF_CACHE_TOOLTIP),
+			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_INVALIDATIONS), SetDataTip(STR_FRAMERATE_WINDOW_INVALIDATIONS, STR_FRAMERATE_WINDOW_INVALIDATIONS_TOOLTIP),
+			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_LINE_CACHE),    SetDataTip(STR_FRAMERATE_LINE_CACHE, STR_FRAMERATE_LINE_CACHE_TOOLTIP),
+			NWidget(WWT_TEXT, COLOUR_GREY, WID_FRW_VIEWPORT_SPRITES), SetDataTip(STR_FRAMERATE_VIEWPORT_SPRITES, STR_FRAMERATE_VIEWPORT_SPRITES_TOOLTIP),
 		EndContainer(),
 	EndContainer(),
 	NWidget(NWID_HORIZONTAL),
@@ -497,6 +705,37 @@ struct FramerateWindow : Window {
 			case WID_FRW_RATE_FACTOR:
 				this->speed_gameloop.InsertDParams(0);
 				break;
+			case WID_FRW_RATE_PF_CACHE: {
+				uint64 hits, misses;
+				YapfGetRailSegmentCacheStats(&hits, &misses);
+				SetDParam(0, hits);
+				SetDParam(1, misses);
+				break;
+			}
+			case WID_FRW_INVALIDATIONS: {
+				uint64 scheduled, merged;
+				GetWindowInvalidationStats(&scheduled, &merged);
+				SetDParam(0, scheduled);
+				SetDParam(1, merged);
+				break;
+			}
+			case WID_FRW_LINE_CACHE: {
+				uint64 hits, misses;
+				uint size;
+				Layouter::GetLineCacheStats(&hits, &misses, &size);
+				SetDParam(0, hits);
+				SetDParam(1, misses);
+				SetDParam(2, size);
+				break;
+			}
+			case WID_FRW_VIEWPORT_SPRITES: {
+				uint tile, parent, child;
+				GetViewportSpriteStats(&tile, &parent, &child);
+				SetDParam(0, tile);
+				SetDParam(1, parent);
+				SetDParam(2, child);
+				break;
+			}
 			case WID_FRW_INFO_DATA_POINTS:
 				SetDParam(0, NUM_FRAMERATE_POINTS);
 				break;
@@ -523,6 +762,28 @@ struct FramerateWindow : Window {
 				SetDParam(1, 2);
 				*size = GetStringBoundingBox(STR_FRAMERATE_SPEED_FACTOR);
 				break;
+			case WID_FRW_RATE_PF_CACHE:
+				SetDParamMaxDigits(0, 12);
+				SetDParamMaxDigits(1, 12);
+				*size = GetStringBoundingBox(STR_FRAMERATE_RAIL_PF_CACHE);
+				break;
+			case WID_FRW_INVALIDATIONS:
+				SetDParamMaxDigits(0, 12);
+				SetDParamMaxDigits(1, 12);
+				*size = GetStringBoundingBox(STR_FRAMERATE_WINDOW_INVALIDATIONS);
+				break;
+			case WID_FRW_LINE_CACHE:
+				SetDParamMaxDigits(0, 12);
+				SetDParamMaxDigits(1, 12);
+				SetDParamMaxDigits(2, 5);
+				*size = GetStringBoundingBox(STR_FRAMERATE_LINE_CACHE);
+				break;
+			case WID_FRW_VIEWPORT_SPRITES:
+				SetDParamMaxDigits(0, 7);
+				SetDParamMaxDigits(1, 7);
+				SetDParamMaxDigits(2, 7);
+				*size = GetStringBoundingBox(STR_FRAMERATE_VIEWPORT_SPRITES);
+				break;
 
 			case WID_FRW_TIMES_NAMES: {
 				size->width = 0;
@@ -122,6 +122,27 @@ public:
 	static void Reset(PerformanceElement elem);
 };
 
+/**
+ * RAII class for marking a scope as an event in the performance trace.
+ * Nothing is recorded while no trace is running, see #StartPerformanceTrace.
+ */
+class PerformanceTraceScope {
+	const char *name;
+	TimingMeasurement start_time;
+public:
+	PerformanceTraceScope(const char *name);
+	~PerformanceTraceScope();
+};
+
+bool StartPerformanceTrace();
+bool StopPerformanceTrace(const char *filename, uint *events, uint *dropped);
+void AddPerformanceTraceEvent(const char *name, uint duration_us);
+
+bool GetPerformanceSummary(PerformanceElement elem, double *rate, double *short_ms, double *long_ms);
+void ResetPerformanceTotals();
+uint32 GetPerformanceTotals(PerformanceElement elem, double *total_ms);
+const char *GetPerformanceElementKey(PerformanceElement elem);
+
 void ShowFramerateWindow();
 
 #endif /* FRAMERATE_TYPE_H */
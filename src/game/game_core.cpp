@@ -63,6 +63,7 @@
 	Game::frame_counter = 0;
 
 	if (Game::scanner_info == NULL) {
+		FileScanCache scan_cache;
 		TarScanner::DoScan(TarScanner::GAME);
 		Game::scanner_info = new GameScannerInfo();
 		Game::scanner_info->Initialize();
@@ -192,10 +193,13 @@
 
 /* static */ void Game::Rescan()
 {
-	TarScanner::DoScan(TarScanner::GAME);
+	{
+		FileScanCache scan_cache;
+		TarScanner::DoScan(TarScanner::GAME);
 
-	Game::scanner_info->RescanDir();
-	Game::scanner_library->RescanDir();
+		Game::scanner_info->RescanDir();
+		Game::scanner_library->RescanDir();
+	}
 	ResetConfig();
 
 	InvalidateWindowData(WC_AI_LIST, 0, 1);
@@ -27,6 +27,7 @@
 #include "../script/api/game/game_accounting.hpp.sq"
 #include "../script/api/game/game_admin.hpp.sq"
 #include "../script/api/game/game_airport.hpp.sq"
+#include "../script/api/game/game_asyncmode.hpp.sq"
 #include "../script/api/game/game_base.hpp.sq"
 #include "../script/api/game/game_basestation.hpp.sq"
 #include "../script/api/game/game_bridge.hpp.sq"
@@ -113,6 +114,7 @@ void GameInstance::RegisterAPI()
 	SQGSAccounting_Register(this->engine);
 	SQGSAdmin_Register(this->engine);
 	SQGSAirport_Register(this->engine);
+	SQGSAsyncMode_Register(this->engine);
 	SQGSBase_Register(this->engine);
 	SQGSBaseStation_Register(this->engine);
 	SQGSBridge_Register(this->engine);
@@ -258,8 +260,7 @@ void GameInstance::Died()
  */
 void CcGame(const CommandCost &result, TileIndex tile, uint32 p1, uint32 p2)
 {
-	Game::GetGameInstance()->DoCommandCallback(result, tile, p1, p2);
-	Game::GetGameInstance()->Continue();
+	if (Game::GetGameInstance()->DoCommandCallback(result, tile, p1, p2)) Game::GetGameInstance()->Continue();
 }
 
 CommandCallback *GameInstance::GetDoCommandCallback()
@@ -417,11 +417,15 @@ bool GamelogTestEmergency()
 {
 	const LoggedChange *emergency = NULL;
 
-	const LoggedAction *laend = &_gamelog_action[_gamelog_actions];
-	for (const LoggedAction *la = _gamelog_action; la != laend; la++) {
-		const LoggedChange *lcend = &la->change[la->changes];
-		for (const LoggedChange *lc = la->change; lc != lcend; lc++) {
-			if (lc->ct == GLCT_EMERGENCY) emergency = lc;
+	/* Only the last one matters, so search from the end. */
+	for (const LoggedAction *la = &_gamelog_action[_gamelog_actions]; emergency == NULL && la != _gamelog_action;) {
+		la--;
+		for (const LoggedChange *lc = &la->change[la->changes]; lc != la->change;) {
+			lc--;
+			if (lc->ct == GLCT_EMERGENCY) {
+				emergency = lc;
+				break;
+			}
 		}
 	}
 
@@ -483,6 +487,20 @@ void GamelogSetting(const char *name, int32 oldval, int32 newval)
 {
 	assert(_gamelog_action_type == GLAT_SETTING);
 
+	/* When the same setting was the last thing changed, update that change
+	 * instead of logging another one. It keeps the tick and the value of the
+	 * first change, and stays logged even when the setting is changed back. */
+	if (_current_action == NULL && _gamelog_actions > 0) {
+		LoggedAction *la = &_gamelog_action[_gamelog_actions - 1];
+		LoggedChange *last = la->change;
+		if (la->at == GLAT_SETTING && la->changes == 1 && last->ct == GLCT_SETTING &&
+				last->setting.newval == oldval && strcmp(last->setting.name, name) == 0) {
+			last->setting.newval = newval;
+			_current_action = la;
+			return;
+		}
+	}
+
 	LoggedChange *lc = GamelogChange(GLCT_SETTING);
 	if (lc == NULL) return;
 
@@ -500,11 +518,15 @@ void GamelogTestRevision()
 {
 	const LoggedChange *rev = NULL;
 
-	const LoggedAction *laend = &_gamelog_action[_gamelog_actions];
-	for (const LoggedAction *la = _gamelog_action; la != laend; la++) {
-		const LoggedChange *lcend = &la->change[la->changes];
-		for (const LoggedChange *lc = la->change; lc != lcend; lc++) {
-			if (lc->ct == GLCT_REVISION) rev = lc;
+	/* Only the last one matters, so search from the end. */
+	for (const LoggedAction *la = &_gamelog_action[_gamelog_actions]; rev == NULL && la != _gamelog_action;) {
+		la--;
+		for (const LoggedChange *lc = &la->change[la->changes]; lc != la->change;) {
+			lc--;
+			if (lc->ct == GLCT_REVISION) {
+				rev = lc;
+				break;
+			}
 		}
 	}
 
@@ -523,11 +545,15 @@ void GamelogTestMode()
 {
 	const LoggedChange *mode = NULL;
 
-	const LoggedAction *laend = &_gamelog_action[_gamelog_actions];
-	for (const LoggedAction *la = _gamelog_action; la != laend; la++) {
-		const LoggedChange *lcend = &la->change[la->changes];
-		for (const LoggedChange *lc = la->change; lc != lcend; lc++) {
-			if (lc->ct == GLCT_MODE) mode = lc;
+	/* Only the last one matters, so search from the end. */
+	for (const LoggedAction *la = &_gamelog_action[_gamelog_actions]; mode == NULL && la != _gamelog_action;) {
+		la--;
+		for (const LoggedChange *lc = &la->change[la->changes]; lc != la->change;) {
+			lc--;
+			if (lc->ct == GLCT_MODE) {
+				mode = lc;
+				break;
+			}
 		}
 	}
 
@@ -60,6 +60,9 @@ GenWorldInfo _gw;
 /** Whether we are generating the map or not. */
 bool _generating_world;
 
+static const uint GENWORLD_TILE_LOOP_TICKS = 0x500;        ///< Number of ticks the tile loop runs to let a new landscape settle.
+static const uint GENWORLD_TILE_LOOP_TICKS_PER_STEP = 16; ///< Number of tile loop ticks between progress updates.
+
 /**
  * Tells if the world generation is done in a thread or not.
  * @return the 'threaded' status
@@ -159,10 +162,10 @@ static void _GenerateWorld(void *)
 		if (_gw.mode != GWM_EMPTY) {
 			uint i;
 
-			SetGeneratingWorldProgress(GWP_RUNTILELOOP, 0x500);
-			for (i = 0; i < 0x500; i++) {
-				RunTileLoop();
-				_tick_counter++;
+			assert_compile(GENWORLD_TILE_LOOP_TICKS % GENWORLD_TILE_LOOP_TICKS_PER_STEP == 0);
+			SetGeneratingWorldProgress(GWP_RUNTILELOOP, GENWORLD_TILE_LOOP_TICKS / GENWORLD_TILE_LOOP_TICKS_PER_STEP);
+			for (i = 0; i < GENWORLD_TILE_LOOP_TICKS; i += GENWORLD_TILE_LOOP_TICKS_PER_STEP) {
+				RunTileLoopTicks(GENWORLD_TILE_LOOP_TICKS_PER_STEP);
 				IncreaseGeneratingWorldProgress(GWP_RUNTILELOOP);
 			}
 
@@ -194,6 +197,7 @@ static void _GenerateWorld(void *)
 		IncreaseGeneratingWorldProgress(GWP_GAME_START);
 
 		CleanupGeneration();
+		CompactMapMemory();
 		_modal_progress_work_mutex->EndCritical();
 
 		ShowNewGRFError();
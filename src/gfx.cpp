@@ -21,6 +21,7 @@
 #include "network/network_func.h"
 #include "window_func.h"
 #include "newgrf_debug.h"
+#include "viewport_func.h"
 
 #include "table/palettes.h"
 #include "table/string_colours.h"
@@ -699,8 +700,7 @@ int DrawStringMultiLine(int left, int right, int top, int bottom, StringID str,
  */
 Dimension GetStringBoundingBox(const char *str, FontSize start_fontsize)
 {
-	Layouter layout(str, INT32_MAX, TC_FROMSTRING, start_fontsize);
-	return layout.GetBounds();
+	return Layouter::GetUnwrappedBounds(str, start_fontsize);
 }
 
 /**
@@ -1462,6 +1462,7 @@ void SetDirtyBlocks(int left, int top, int right, int bottom)
  */
 void MarkWholeScreenDirty()
 {
+	InvalidateTileDrawCache();
 	SetDirtyBlocks(0, 0, _screen.width, _screen.height);
 }
 
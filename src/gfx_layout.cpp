@@ -17,6 +17,9 @@
 
 #include "table/control_codes.h"
 
+#include <algorithm>
+#include <vector>
+
 #ifdef WITH_ICU_LAYOUT
 #include <unicode/ustring.h>
 #endif /* WITH_ICU_LAYOUT */
@@ -34,6 +37,12 @@
 
 /** Cache of ParagraphLayout lines. */
 Layouter::LineCache *Layouter::linecache;
+uint64 Layouter::linecache_clock;
+uint64 Layouter::linecache_hits;
+uint64 Layouter::linecache_misses;
+
+/** Number of lines the linecache may hold before the least recently used ones are removed. */
+static const size_t MAX_LINECACHE_SIZE = 4096;
 
 /** Cache of Font instances. */
 Layouter::FontColourMap Layouter::fonts[FS_END];
@@ -645,85 +654,138 @@ static inline void GetLayouter(Layouter::LineCacheItem &line, const char *&str,
 }
 
 /**
- * Create a new layouter.
- * @param str      The string to create the layout for.
- * @param maxw     The maximum width.
- * @param colour   The colour of the font.
- * @param fontsize The size of font to use.
+ * Get the layout of the first paragraph of a string, from the linecache if it is there.
+ * @param[in,out] str   The string; it is moved past the end of the paragraph.
+ * @param[in,out] state The state of the font and colour; it is changed to the state after the paragraph.
+ * @param[out]    last  Whether this was the last paragraph of the string.
+ * @return The cache item with the layout, ready to get its lines from.
  */
-Layouter::Layouter(const char *str, int maxw, TextColour colour, FontSize fontsize) : string(str)
+Layouter::LineCacheItem &Layouter::GetParagraphLayout(const char *&str, FontState &state, bool &last)
 {
-	FontState state(colour, fontsize);
+	/* Scan string for end of line */
 	WChar c = 0;
+	const char *lineend = str;
+	for (;;) {
+		size_t len = Utf8Decode(&c, lineend);
+		if (c == '\0' || c == '\n') break;
+		lineend += len;
+	}
+	last = (c == '\0');
+
+	LineCacheItem &line = GetCachedParagraphLayout(str, lineend - str, state);
+	line.last_used = ++linecache_clock;
+	if (line.layout != NULL) {
+		/* Line is in cache */
+		linecache_hits++;
+		str = lineend + 1;
+		state = line.state_after;
+		line.layout->Reflow();
+		return line;
+	}
 
-	do {
-		/* Scan string for end of line */
-		const char *lineend = str;
-		for (;;) {
-			size_t len = Utf8Decode(&c, lineend);
-			if (c == '\0' || c == '\n') break;
-			lineend += len;
-		}
-
-		LineCacheItem& line = GetCachedParagraphLayout(str, lineend - str, state);
-		if (line.layout != NULL) {
-			/* Line is in cache */
-			str = lineend + 1;
-			state = line.state_after;
-			line.layout->Reflow();
-		} else {
-			/* Line is new, layout it */
-			FontState old_state = state;
+	/* Line is new, layout it */
+	linecache_misses++;
+	FontState old_state = state;
 #if defined(WITH_ICU_LAYOUT) || defined(WITH_UNISCRIBE) || defined(WITH_COCOA)
-			const char *old_str = str;
+	const char *old_str = str;
 #endif
 
 #ifdef WITH_ICU_LAYOUT
-			GetLayouter<ICUParagraphLayoutFactory>(line, str, state);
-			if (line.layout == NULL) {
-				static bool warned = false;
-				if (!warned) {
-					DEBUG(misc, 0, "ICU layouter bailed on the font. Falling back to the fallback layouter");
-					warned = true;
-				}
+	GetLayouter<ICUParagraphLayoutFactory>(line, str, state);
+	if (line.layout == NULL) {
+		static bool warned = false;
+		if (!warned) {
+			DEBUG(misc, 0, "ICU layouter bailed on the font. Falling back to the fallback layouter");
+			warned = true;
+		}
 
-				state = old_state;
-				str = old_str;
-			}
+		state = old_state;
+		str = old_str;
+	}
 #endif
 
 #ifdef WITH_UNISCRIBE
-			if (line.layout == NULL) {
-				GetLayouter<UniscribeParagraphLayoutFactory>(line, str, state);
-				if (line.layout == NULL) {
-					state = old_state;
-					str = old_str;
-				}
-			}
+	if (line.layout == NULL) {
+		GetLayouter<UniscribeParagraphLayoutFactory>(line, str, state);
+		if (line.layout == NULL) {
+			state = old_state;
+			str = old_str;
+		}
+	}
 #endif
 
 #ifdef WITH_COCOA
-			if (line.layout == NULL) {
-				GetLayouter<CoreTextParagraphLayoutFactory>(line, str, state);
-				if (line.layout == NULL) {
-					state = old_state;
-					str = old_str;
-				}
-			}
+	if (line.layout == NULL) {
+		GetLayouter<CoreTextParagraphLayoutFactory>(line, str, state);
+		if (line.layout == NULL) {
+			state = old_state;
+			str = old_str;
+		}
+	}
 #endif
 
-			if (line.layout == NULL) {
-				GetLayouter<FallbackParagraphLayoutFactory>(line, str, state);
-			}
-		}
+	if (line.layout == NULL) {
+		GetLayouter<FallbackParagraphLayoutFactory>(line, str, state);
+	}
+
+	return line;
+}
+
+/**
+ * Create a new layouter.
+ * @param str      The string to create the layout for.
+ * @param maxw     The maximum width.
+ * @param colour   The colour of the font.
+ * @param fontsize The size of font to use.
+ */
+Layouter::Layouter(const char *str, int maxw, TextColour colour, FontSize fontsize) : string(str)
+{
+	FontState state(colour, fontsize);
+	bool last;
+
+	do {
+		LineCacheItem &line = GetParagraphLayout(str, state, last);
 
 		/* Copy all lines into a local cache so we can reuse them later on more easily. */
 		const ParagraphLayouter::Line *l;
 		while ((l = line.layout->NextLine(maxw)) != NULL) {
 			*this->Append() = l;
 		}
+	} while (!last);
+}
+
+/**
+ * Get the boundaries of a string when it is not wrapped, like #GetBounds of a
+ * layouter without maximum width. The size of each paragraph is kept in the
+ * linecache, so this does not need to make the lines of the paragraphs again.
+ * @param str      The string to get the boundaries of.
+ * @param fontsize The size of font to start with.
+ * @return The boundaries.
+ */
+/* static */ Dimension Layouter::GetUnwrappedBounds(const char *str, FontSize fontsize)
+{
+	FontState state(TC_FROMSTRING, fontsize);
+	Dimension d = { 0, 0 };
+	bool last;
+
+	do {
+		LineCacheItem &line = GetParagraphLayout(str, state, last);
+		if (!line.has_bounds) {
+			line.bounds.width = 0;
+			line.bounds.height = 0;
+			const ParagraphLayouter::Line *l;
+			while ((l = line.layout->NextLine(INT32_MAX)) != NULL) {
+				line.bounds.width = max<uint>(line.bounds.width, l->GetWidth());
+				line.bounds.height += l->GetLeading();
+				delete l;
+			}
+			line.has_bounds = true;
+		}
+		d.width = max(d.width, line.bounds.width);
+		d.height += line.bounds.height;
+	} while (!last);
 
-	} while (c != '\0');
+	return d;
 }
 
 /**
@@ -891,11 +953,38 @@ void Layouter::ResetLineCache()
 
 /**
  * Reduce the size of linecache if necessary to prevent infinite growth.
+ * The least recently used lines are removed, so the lines drawn all the
+ * time, like the signs in the viewports, stay in the cache.
  */
 void Layouter::ReduceLineCache()
 {
-	if (linecache != NULL) {
-		/* TODO LRU cache would be fancy, but not exactly necessary */
-		if (linecache->size() > 4096) ResetLineCache();
+	if (linecache == NULL || linecache->size() <= MAX_LINECACHE_SIZE) return;
+
+	/* Find the age of the oldest line to keep, so three quarters of the maximum size remain. */
+	std::vector<uint64> last_used;
+	last_used.reserve(linecache->size());
+	for (LineCache::const_iterator it = linecache->begin(); it != linecache->end(); ++it) last_used.push_back(it->second.last_used);
+	std::vector<uint64>::iterator limit = last_used.begin() + (last_used.size() - MAX_LINECACHE_SIZE * 3 / 4);
+	std::nth_element(last_used.begin(), limit, last_used.end());
+
+	for (LineCache::iterator it = linecache->begin(); it != linecache->end(); /* nothing */) {
+		if (it->second.last_used < *limit) {
+			linecache->erase(it++);
+		} else {
+			++it;
+		}
 	}
 }
+
+/**
+ * Get the statistics of the linecache.
+ * @param[out] hits   Number of lines found in the cache.
+ * @param[out] misses Number of lines that had to be laid out.
+ * @param[out] size   Number of lines in the cache.
+ */
+void Layouter::GetLineCacheStats(uint64 *hits, uint64 *misses, uint *size)
+{
+	*hits = linecache_hits;
+	*misses = linecache_misses;
+	*size = linecache == NULL ? 0 : (uint)linecache->size();
+}
@@ -177,14 +177,23 @@ public:
 		FontState state_after;     ///< Font state after the line.
 		ParagraphLayouter *layout; ///< Layout of the line.
 
-		LineCacheItem() : buffer(NULL), layout(NULL) {}
+		Dimension bounds;          ///< Size of the line when it is not wrapped; only valid when #has_bounds is set.
+		bool has_bounds;           ///< Whether #bounds is known.
+		uint64 last_used;          ///< Value of #Layouter::linecache_clock when the line was used last.
+
+		LineCacheItem() : buffer(NULL), layout(NULL), has_bounds(false), last_used(0) {}
 		~LineCacheItem() { delete layout; free(buffer); }
 	};
 private:
 	typedef std::map<LineCacheKey, LineCacheItem> LineCache;
 	static LineCache *linecache;
 
+	static uint64 linecache_clock;  ///< Number of times a line has been got from the linecache, to find the least recently used ones.
+	static uint64 linecache_hits;   ///< Number of lines that were found in the linecache.
+	static uint64 linecache_misses; ///< Number of lines that had to be laid out.
+
 	static LineCacheItem &GetCachedParagraphLayout(const char *str, size_t len, const FontState &state);
+	static LineCacheItem &GetParagraphLayout(const char *&str, FontState &state, bool &last);
 
 	typedef SmallMap<TextColour, Font *> FontColourMap;
 	static FontColourMap fonts[FS_END];
@@ -193,12 +202,14 @@ public:
 
 	Layouter(const char *str, int maxw = INT32_MAX, TextColour colour = TC_FROMSTRING, FontSize fontsize = FS_NORMAL);
 	Dimension GetBounds();
+	static Dimension GetUnwrappedBounds(const char *str, FontSize fontsize);
 	Point GetCharPosition(const char *ch) const;
 	const char *GetCharAtPosition(int x) const;
 
 	static void ResetFontCache(FontSize size);
 	static void ResetLineCache();
 	static void ReduceLineCache();
+	static void GetLineCacheStats(uint64 *hits, uint64 *misses, uint *size);
 };
 
 #endif /* GFX_LAYOUT_H */
@@ -277,9 +277,11 @@ static bool SwitchNewGRFBlitter()
 		uint min_base_depth, max_base_depth, min_grf_depth, max_grf_depth;
 	} replacement_blitters[] = {
 #ifdef WITH_SSE
+		{ "32bpp-avx2",      0, 32, 32,  8, 32 },
 		{ "32bpp-sse4",      0, 32, 32,  8, 32 },
 		{ "32bpp-ssse3",     0, 32, 32,  8, 32 },
 		{ "32bpp-sse2",      0, 32, 32,  8, 32 },
+		{ "32bpp-avx2-anim", 1, 32, 32,  8, 32 },
 		{ "32bpp-sse4-anim", 1, 32, 32,  8, 32 },
 #endif
 		{ "8bpp-optimized",  2,  8,  8,  8,  8 },
@@ -94,6 +94,7 @@ void GroundVehicle<T, Type>::CargoChanged()
 	this->gcache.cached_weight = max<uint32>(1, weight);
 	/* Friction in bearings and other mechanical parts is 0.1% of the weight (result in N). */
 	this->gcache.cached_axle_resistance = 10 * weight;
+	this->InvalidatePreparedSlopeResistance();
 
 	/* Now update vehicle power (tractive effort is dependent on weight). */
 	this->PowerChanged();
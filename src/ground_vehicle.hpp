@@ -13,6 +13,7 @@
 #define GROUND_VEHICLE_HPP
 
 #include "vehicle_base.h"
+#include "vehicle_func.h"
 #include "vehicle_gui.h"
 #include "landscape.h"
 #include "window_func.h"
@@ -81,6 +82,8 @@ template <class T, VehicleType Type>
 struct GroundVehicle : public SpecializedVehicle<T, Type> {
 	GroundVehicleCache gcache; ///< Cache of often calculated values.
 	uint16 gv_flags;           ///< @see GroundVehicleFlags.
+	int64 tick_slope_resistance; ///< Slope resistance of the consist as prepared by #PrepareVehicleTicks.
+	uint32 tick_slope_stamp;     ///< Vehicle tick stamp #tick_slope_resistance is valid for, 0 if invalid.
 
 	typedef GroundVehicle<T, Type> GroundVehicleBase; ///< Our type
 
@@ -106,23 +109,74 @@ struct GroundVehicle : public SpecializedVehicle<T, Type> {
 			ClrBit(v->gv_flags, GVF_GOINGUP_BIT);
 			ClrBit(v->gv_flags, GVF_GOINGDOWN_BIT);
 		}
+		this->InvalidatePreparedSlopeResistance();
 		return this->Vehicle::Crash(flooded);
 	}
 
 	/**
-	 * Calculates the total slope resistance for this vehicle.
+	 * Forget the slope resistance prepared for this tick.
+	 * Must be called whenever the inclination or weight of any part of the consist changes,
+	 * unless the change is passed to #AdjustPreparedSlopeResistance.
+	 */
+	inline void InvalidatePreparedSlopeResistance()
+	{
+		T::From(this)->First()->tick_slope_stamp = 0;
+	}
+
+	/**
+	 * Account for a change of the slope resistance of one part in the value prepared for this tick,
+	 * so it does not have to be calculated again for the whole consist.
+	 * @param delta Change of the slope resistance.
+	 */
+	inline void AdjustPreparedSlopeResistance(int64 delta)
+	{
+		T *front = T::From(this)->First();
+		if (front->tick_slope_stamp != 0) front->tick_slope_resistance += delta;
+	}
+
+	/**
+	 * Get the slope resistance caused by this part of the consist alone.
+	 * @return Slope resistance of this part.
+	 */
+	inline int64 GetPartSlopeResistance() const
+	{
+		if (HasBit(this->gv_flags, GVF_GOINGUP_BIT)) return this->gcache.cached_slope_resistance;
+		if (HasBit(this->gv_flags, GVF_GOINGDOWN_BIT)) return -(int64)this->gcache.cached_slope_resistance;
+		return 0;
+	}
+
+	/**
+	 * Store the slope resistance of this consist for use during the current vehicle tick.
+	 * @pre This is the front of the consist.
+	 * @note Only reads the consist, so it can be called from worker threads.
+	 */
+	inline void PrepareSlopeResistance()
+	{
+		this->tick_slope_resistance = this->CalcSlopeResistance();
+		this->tick_slope_stamp = _vehicle_tick_stamp;
+	}
+
+	/**
+	 * Gets the total slope resistance for this vehicle, using the value
+	 * prepared for this tick when it is still valid.
 	 * @return Slope resistance.
 	 */
 	inline int64 GetSlopeResistance() const
+	{
+		if (this->tick_slope_stamp != 0 && this->tick_slope_stamp == _vehicle_tick_stamp) return this->tick_slope_resistance;
+		return this->CalcSlopeResistance();
+	}
+
+	/**
+	 * Calculates the total slope resistance for this vehicle.
+	 * @return Slope resistance.
+	 */
+	inline int64 CalcSlopeResistance() const
 	{
 		int64 incl = 0;
 
 		for (const T *u = T::From(this); u != NULL; u = u->Next()) {
-			if (HasBit(u->gv_flags, GVF_GOINGUP_BIT)) {
-				incl += u->gcache.cached_slope_resistance;
-			} else if (HasBit(u->gv_flags, GVF_GOINGDOWN_BIT)) {
-				incl -= u->gcache.cached_slope_resistance;
-			}
+			incl += u->GetPartSlopeResistance();
 		}
 
 		return incl;
@@ -136,6 +190,8 @@ struct GroundVehicle : public SpecializedVehicle<T, Type> {
 	 */
 	inline void UpdateZPositionAndInclination()
 	{
+		int64 old_resistance = this->GetPartSlopeResistance();
+
 		this->z_pos = GetSlopePixelZ(this->x_pos, this->y_pos);
 		ClrBit(this->gv_flags, GVF_GOINGUP_BIT);
 		ClrBit(this->gv_flags, GVF_GOINGDOWN_BIT);
@@ -151,6 +207,9 @@ struct GroundVehicle : public SpecializedVehicle<T, Type> {
 				SetBit(this->gv_flags, (middle_z > this->z_pos) ? GVF_GOINGUP_BIT : GVF_GOINGDOWN_BIT);
 			}
 		}
+
+		/* Only this part changed, so update the consist's value instead of recalculating it. */
+		this->AdjustPreparedSlopeResistance(this->GetPartSlopeResistance() - old_resistance);
 	}
 
 	/**
@@ -26,6 +26,7 @@ extern GroupPool _group_pool; ///< Pool of groups.
 struct GroupStatistics {
 	uint16 num_vehicle;                     ///< Number of vehicles.
 	uint16 *num_engines;                    ///< Caches the number of engines of each type the company owns.
+	uint16 *num_engines_tree;               ///< Caches the number of engines of each type in the group and its sub-groups; only used by real groups.
 
 	bool autoreplace_defined;               ///< Are any autoreplace rules set?
 	bool autoreplace_finished;              ///< Have all autoreplacement finished?
@@ -56,6 +57,8 @@ struct GroupStatistics {
 
 	static void CountVehicle(const Vehicle *v, int delta);
 	static void CountEngine(const Vehicle *v, int delta);
+	static void CountEngineInTree(GroupID id_g, EngineID engine, int delta);
+	static void MoveGroupInTree(const Group *g, GroupID new_parent);
 	static void VehicleReachedProfitAge(const Vehicle *v);
 
 	static void UpdateProfits();
@@ -34,11 +34,13 @@ INSTANTIATE_POOL_METHODS(Group)
 GroupStatistics::GroupStatistics()
 {
 	this->num_engines = CallocT<uint16>(Engine::GetPoolSize());
+	this->num_engines_tree = CallocT<uint16>(Engine::GetPoolSize());
 }
 
 GroupStatistics::~GroupStatistics()
 {
 	free(this->num_engines);
+	free(this->num_engines_tree);
 }
 
 /**
@@ -53,6 +55,8 @@ void GroupStatistics::Clear()
 	/* This is also called when NewGRF change. So the number of engines might have changed. Reallocate. */
 	free(this->num_engines);
 	this->num_engines = CallocT<uint16>(Engine::GetPoolSize());
+	free(this->num_engines_tree);
+	this->num_engines_tree = CallocT<uint16>(Engine::GetPoolSize());
 }
 
 /**
@@ -163,6 +167,37 @@ void GroupStatistics::Clear()
 	assert(delta == 1 || delta == -1);
 	GroupStatistics::GetAllGroup(v).num_engines[v->engine_type] += delta;
 	GroupStatistics::Get(v).num_engines[v->engine_type] += delta;
+	GroupStatistics::CountEngineInTree(v->group_id, v->engine_type, delta);
+}
+
+/**
+ * Update num_engines_tree of a group and all its parents when adding/removing an engine.
+ * @param id_g The group the engine is in; nothing happens for the default and all groups.
+ * @param engine The engine type.
+ * @param delta The number of engines added or removed.
+ */
+/* static */ void GroupStatistics::CountEngineInTree(GroupID id_g, EngineID engine, int delta)
+{
+	while (Group::IsValidID(id_g)) {
+		Group *g = Group::Get(id_g);
+		g->statistics.num_engines_tree[engine] += delta;
+		id_g = g->parent;
+	}
+}
+
+/**
+ * Move the engine counts of a group and its sub-groups from its current parents to new ones.
+ * @param g The group that is getting a new parent.
+ * @param new_parent The new parent of the group.
+ */
+/* static */ void GroupStatistics::MoveGroupInTree(const Group *g, GroupID new_parent)
+{
+	const uint16 *tree = g->statistics.num_engines_tree;
+	for (EngineID engine = 0; engine < Engine::GetPoolSize(); engine++) {
+		if (tree[engine] == 0) continue;
+		GroupStatistics::CountEngineInTree(g->parent, engine, -tree[engine]);
+		GroupStatistics::CountEngineInTree(new_parent, engine, tree[engine]);
+	}
 }
 
 /**
@@ -248,9 +283,11 @@ static inline void UpdateNumEngineGroup(const Vehicle *v, GroupID old_g, GroupID
 	if (old_g != new_g) {
 		/* Decrease the num engines in the old group */
 		GroupStatistics::Get(v->owner, old_g, v->type).num_engines[v->engine_type]--;
+		GroupStatistics::CountEngineInTree(old_g, v->engine_type, -1);
 
 		/* Increase the num engines in the new group */
 		GroupStatistics::Get(v->owner, new_g, v->type).num_engines[v->engine_type]++;
+		GroupStatistics::CountEngineInTree(new_g, v->engine_type, 1);
 	}
 }
 
@@ -298,11 +335,13 @@ void PropagateChildLivery(const Group *g)
 Group::Group(Owner owner)
 {
 	this->owner = owner;
+	InvalidateEngineReplacementCache();
 }
 
 Group::~Group()
 {
 	free(this->name);
+	InvalidateEngineReplacementCache();
 }
 
 
@@ -453,7 +492,10 @@ CommandCost CmdAlterGroup(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 		}
 
 		if (flags & DC_EXEC) {
-			g->parent = (pg == NULL) ? INVALID_GROUP : pg->index;
+			GroupID new_parent = (pg == NULL) ? INVALID_GROUP : pg->index;
+			GroupStatistics::MoveGroupInTree(g, new_parent);
+			g->parent = new_parent;
+			InvalidateEngineReplacementCache();
 			GroupStatistics::UpdateAutoreplace(g->owner);
 
 			if (g->livery.in_use == 0) {
@@ -716,6 +758,7 @@ CommandCost CmdSetGroupReplaceProtection(TileIndex tile, DoCommandFlag flags, ui
 		} else {
 			g->replace_protection = HasBit(p2, 0);
 		}
+		InvalidateEngineReplacementCache();
 
 		SetWindowDirty(GetWindowClassForVehicleType(g->vehicle_type), VehicleListIdentifier(VL_GROUP_LIST, g->vehicle_type, _current_company).Pack());
 		InvalidateWindowData(WC_REPLACE_VEHICLE, g->vehicle_type);
@@ -799,13 +842,11 @@ void UpdateTrainGroupID(Train *v)
  */
 uint GetGroupNumEngines(CompanyID company, GroupID id_g, EngineID id_e)
 {
-	uint count = 0;
+	if (Group::IsValidID(id_g)) return Group::Get(id_g)->statistics.num_engines_tree[id_e];
+
+	/* The default and all groups have no sub-groups. */
 	const Engine *e = Engine::Get(id_e);
-	const Group *g;
-	FOR_ALL_GROUPS(g) {
-		if (g->parent == id_g) count += GetGroupNumEngines(company, g->index, id_e);
-	}
-	return count + GroupStatistics::Get(company, id_g, e->type).num_engines[id_e];
+	return GroupStatistics::Get(company, id_g, e->type).num_engines[id_e];
 }
 
 void RemoveAllGroupsForCompany(const CompanyID company)
@@ -19,6 +19,8 @@
 #include "gfx_func.h"
 #include "fios.h"
 #include "fileio_func.h"
+#include <algorithm>
+#include <vector>
 
 #include "table/strings.h"
 
@@ -35,6 +37,151 @@ static inline byte RGBToGrayscale(byte red, byte green, byte blue)
 	return ((red * 19595) + (green * 38470) + (blue * 7471)) / 65536;
 }
 
+/**
+ * Nearest neighbour mapping of the pixels of a heightmap image onto the map.
+ * The image rows are fed in one by one while the image is decoded, and only
+ * the pixels that end up on a tile are kept, so the memory needed depends
+ * on the size of the map and not on the size of the image.
+ * Rows and columns are in the orientation of the image, i.e. before rotating.
+ */
+struct HeightmapSampler {
+	/* Defines the detail of the aspect ratio (to avoid doubles) */
+	static const uint NUM_DIV = 16384;
+
+	uint img_width;             ///< Width of the image in pixels.
+	uint img_height;            ///< Height of the image in pixels.
+	uint width;                 ///< Number of map columns.
+	uint height;                ///< Number of map rows.
+	uint row_pad;               ///< Number of map rows above and below the image.
+	uint col_pad;               ///< Number of map columns left and right of the image.
+	uint first_row;             ///< First map row showing the image.
+	uint last_row;              ///< One past the last map row showing the image.
+	uint first_col;             ///< First map column showing the image.
+	uint last_col;              ///< One past the last map column showing the image.
+	std::vector<uint> img_rows; ///< Image row shown by every map row between #first_row and #last_row.
+	std::vector<uint> img_cols; ///< Image column shown by every map column between #first_col and #last_col.
+	byte *samples;              ///< Grayscale value of every map row and column, #width values per row.
+	byte *line;                 ///< Buffer for converting one image row to grayscale.
+
+	HeightmapSampler() : samples(NULL), line(NULL) {}
+
+	~HeightmapSampler()
+	{
+		free(this->samples);
+		free(this->line);
+	}
+
+	void Init(uint img_width, uint img_height);
+
+	/**
+	 * Check whether any tile shows a row of the image.
+	 * @param img_row The image row.
+	 * @return True iff the row has to be passed to #AddImageRow.
+	 */
+	inline bool NeedsImageRow(uint img_row) const
+	{
+		return std::binary_search(this->img_rows.begin(), this->img_rows.end(), img_row);
+	}
+
+	void AddImageRow(uint img_row);
+};
+
+/**
+ * Calculate which pixel of the image every tile shows, and allocate the buffers.
+ * @param img_width  The width of the image in pixels.
+ * @param img_height The height of the image in pixels.
+ */
+void HeightmapSampler::Init(uint img_width, uint img_height)
+{
+	this->img_width = img_width;
+	this->img_height = img_height;
+
+	uint img_scale;
+	this->row_pad = 0;
+	this->col_pad = 0;
+
+	/* Get map size and calculate scale and padding values */
+	switch (_settings_game.game_creation.heightmap_rotation) {
+		default: NOT_REACHED();
+		case HM_COUNTER_CLOCKWISE:
+			this->width   = MapSizeX();
+			this->height  = MapSizeY();
+			break;
+		case HM_CLOCKWISE:
+			this->width   = MapSizeY();
+			this->height  = MapSizeX();
+			break;
+	}
+
+	if ((img_width * NUM_DIV) / img_height > ((this->width * NUM_DIV) / this->height)) {
+		/* Image is wider than map - center vertically */
+		img_scale = (this->width * NUM_DIV) / img_width;
+		this->row_pad = (1 + this->height - ((img_height * img_scale) / NUM_DIV)) / 2;
+	} else {
+		/* Image is taller than map - center horizontally */
+		img_scale = (this->height * NUM_DIV) / img_height;
+		this->col_pad = (1 + this->width - ((img_width * img_scale) / NUM_DIV)) / 2;
+	}
+
+	const uint edge = _settings_game.construction.freeform_edges ? 0 : 1;
+	this->first_row = this->row_pad;
+	this->last_row = max<int>(this->first_row, (int)(this->height - this->row_pad - edge));
+	this->first_col = this->col_pad;
+	this->last_col = max<int>(this->first_col, (int)(this->width - this->col_pad - edge));
+
+	/* Use nearest neighbour resizing to scale map data.
+	 *  We rotate the map 45 degrees (counter)clockwise */
+	this->img_rows.resize(this->last_row - this->first_row);
+	for (uint row = this->first_row; row < this->last_row; row++) {
+		uint img_row = (((row - this->row_pad) * NUM_DIV) / img_scale);
+		assert(img_row < img_height);
+		this->img_rows[row - this->first_row] = img_row;
+	}
+
+	this->img_cols.resize(this->last_col - this->first_col);
+	for (uint col = this->first_col; col < this->last_col; col++) {
+		uint img_col;
+		switch (_settings_game.game_creation.heightmap_rotation) {
+			default: NOT_REACHED();
+			case HM_COUNTER_CLOCKWISE:
+				img_col = (((this->width - 1 - col - this->col_pad) * NUM_DIV) / img_scale);
+				break;
+			case HM_CLOCKWISE:
+				img_col = (((col - this->col_pad) * NUM_DIV) / img_scale);
+				break;
+		}
+		assert(img_col < img_width);
+		this->img_cols[col - this->first_col] = img_col;
+	}
+
+	this->samples = CallocT<byte>(this->width * this->height);
+	this->line = MallocT<byte>(img_width);
+}
+
+/**
+ * Copy the pixels of the image row in #line to all tiles showing them.
+ * @param img_row The image row that is in #line.
+ */
+void HeightmapSampler::AddImageRow(uint img_row)
+{
+	/* The image rows only increase with the map rows, so all map rows showing this image row are next to each other. */
+	const std::vector<uint> &img_rows = this->img_rows;
+	std::vector<uint>::const_iterator first = std::lower_bound(img_rows.begin(), img_rows.end(), img_row);
+	std::vector<uint>::const_iterator last = std::upper_bound(first, img_rows.end(), img_row);
+	if (first == last) return;
+
+	uint row = this->first_row + (uint)(first - img_rows.begin());
+	byte *dst = &this->samples[row * this->width + this->first_col];
+	const uint *img_col = this->img_cols.data();
+	const uint cols = (uint)this->img_cols.size();
+	for (uint col = 0; col < cols; col++) dst[col] = this->line[img_col[col]];
+
+	/* Further map rows showing the same image row get the same values. */
+	for (row++; row < this->first_row + (uint)(last - img_rows.begin()); row++) {
+		MemCpyT(&this->samples[row * this->width + this->first_col], dst, cols);
+	}
+}
+
 
 #ifdef WITH_PNG
 
@@ -42,14 +189,18 @@ static inline byte RGBToGrayscale(byte red, byte green, byte blue)
 
 /**
  * The PNG Heightmap loader.
+ * Decodes the image row by row, so the image never completely lives in memory.
+ * Only interlaced images need to be kept whole until their last pass.
  */
-static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop info_ptr)
+static void ReadHeightmapPNGImageData(HeightmapSampler *sampler, png_structp png_ptr, png_infop info_ptr, png_bytep rows, int passes)
 {
 	uint x, y;
 	byte gray_palette[256];
-	png_bytep *row_pointers = NULL;
 	bool has_palette = png_get_color_type(png_ptr, info_ptr) == PNG_COLOR_TYPE_PALETTE;
 	uint channels = png_get_channels(png_ptr, info_ptr);
+	uint width = png_get_image_width(png_ptr, info_ptr);
+	uint height = png_get_image_height(png_ptr, info_ptr);
+	size_t row_bytes = png_get_rowbytes(png_ptr, info_ptr);
 
 	/* Get palette and convert it to grayscale */
 	if (has_palette) {
@@ -77,32 +228,50 @@ static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop
 		}
 	}
 
-	row_pointers = png_get_rows(png_ptr, info_ptr);
-
-	/* Read the raw image data and convert in 8-bit grayscale */
-	for (x = 0; x < png_get_image_width(png_ptr, info_ptr); x++) {
-		for (y = 0; y < png_get_image_height(png_ptr, info_ptr); y++) {
-			byte *pixel = &map[y * png_get_image_width(png_ptr, info_ptr) + x];
-			uint x_offset = x * channels;
-
-			if (has_palette) {
-				*pixel = gray_palette[row_pointers[y][x_offset]];
-			} else if (channels == 3) {
-				*pixel = RGBToGrayscale(row_pointers[y][x_offset + 0],
-						row_pointers[y][x_offset + 1], row_pointers[y][x_offset + 2]);
-			} else {
-				*pixel = row_pointers[y][x_offset];
+	for (int pass = 0; pass < passes; pass++) {
+		for (y = 0; y < height; y++) {
+			png_bytep row = passes > 1 ? &rows[y * row_bytes] : rows;
+			png_read_row(png_ptr, row, NULL);
+
+			/* Only complete rows that are shown on the map are of interest. */
+			if (pass != passes - 1 || !sampler->NeedsImageRow(y)) continue;
+
+			/* Convert the raw image data to 8-bit grayscale */
+			byte *pixel = sampler->line;
+			for (x = 0; x < width; x++) {
+				uint x_offset = x * channels;
+
+				if (has_palette) {
+					*pixel++ = gray_palette[row[x_offset]];
+				} else if (channels == 3) {
+					*pixel++ = RGBToGrayscale(row[x_offset + 0], row[x_offset + 1], row[x_offset + 2]);
+				} else {
+					*pixel++ = row[x_offset];
+				}
 			}
+			sampler->AddImageRow(y);
 		}
 	}
 }
 
+/**
+ * Decode the rows of a PNG heightmap, catching the errors libpng reports while decoding.
+ * @return False iff the image data could not be decoded.
+ */
+static bool ReadHeightmapPNGRows(HeightmapSampler *sampler, png_structp png_ptr, png_infop info_ptr, png_bytep rows, int passes)
+{
+	if (setjmp(png_jmpbuf(png_ptr))) return false;
+
+	ReadHeightmapPNGImageData(sampler, png_ptr, info_ptr, rows, passes);
+	return true;
+}
+
 /**
  * Reads the heightmap and/or size of the heightmap from a PNG file.
- * If map == NULL only the size of the PNG is read, otherwise a map
- * with grayscale pixels is allocated and assigned to *map.
+ * If sampler == NULL only the size of the PNG is read, otherwise the
+ * image is sampled onto the map by the sampler.
  */
-static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
+static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, HeightmapSampler *sampler)
 {
 	FILE *fp;
 	png_structp png_ptr = NULL;
@@ -131,10 +300,14 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 
 	png_init_io(png_ptr, fp);
 
-	/* Allocate memory and read image, without alpha or 16-bit samples
+	/* Read the image header and set up reading without alpha or 16-bit samples
 	 * (result is either 8-bit indexed/grayscale or 24-bit RGB) */
+	png_read_info(png_ptr, info_ptr);
 	png_set_packing(png_ptr);
-	png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_PACKING | PNG_TRANSFORM_STRIP_ALPHA | PNG_TRANSFORM_STRIP_16, NULL);
+	png_set_strip_alpha(png_ptr);
+	png_set_strip_16(png_ptr);
+	int passes = png_set_interlace_handling(png_ptr);
+	png_read_update_info(png_ptr, info_ptr);
 
 	/* Maps of wrong colour-depth are not used.
 	 * (this should have been taken care of by stripping alpha and 16-bit samples on load) */
@@ -156,9 +329,20 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 		return false;
 	}
 
-	if (map != NULL) {
-		*map = MallocT<byte>(width * height);
-		ReadHeightmapPNGImageData(*map, png_ptr, info_ptr);
+	if (sampler != NULL) {
+		sampler->Init(width, height);
+
+		/* Interlaced images are only complete after the last pass, so they need all rows. */
+		png_bytep rows = MallocT<png_byte>(png_get_rowbytes(png_ptr, info_ptr) * (passes > 1 ? height : 1));
+		bool success = ReadHeightmapPNGRows(sampler, png_ptr, info_ptr, rows, passes);
+		free(rows);
+
+		if (!success) {
+			ShowErrorMessage(STR_ERROR_PNGMAP, STR_ERROR_PNGMAP_MISC, WL_ERROR);
+			fclose(fp);
+			png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+			return false;
+		}
 	}
 
 	*x = width;
@@ -175,7 +359,7 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 /**
  * The BMP Heightmap loader.
  */
-static void ReadHeightmapBMPImageData(byte *map, BmpInfo *info, BmpData *data)
+static void ReadHeightmapBMPImageData(HeightmapSampler *sampler, BmpInfo *info, BmpData *data)
 {
 	uint x, y;
 	byte gray_palette[256];
@@ -211,9 +395,11 @@ static void ReadHeightmapBMPImageData(byte *map, BmpInfo *info, BmpData *data)
 		}
 	}
 
-	/* Read the raw image data and convert in 8-bit grayscale */
+	/* Convert the raw image data of the rows shown on the map in 8-bit grayscale */
 	for (y = 0; y < info->height; y++) {
-		byte *pixel = &map[y * info->width];
+		if (!sampler->NeedsImageRow(y)) continue;
+
+		byte *pixel = sampler->line;
 		byte *bitmap = &data->bitmap[y * info->width * (info->bpp == 24 ? 3 : 1)];
 
 		for (x = 0; x < info->width; x++) {
@@ -224,15 +410,16 @@ static void ReadHeightmapBMPImageData(byte *map, BmpInfo *info, BmpData *data)
 				bitmap += 3;
 			}
 		}
+		sampler->AddImageRow(y);
 	}
 }
 
 /**
  * Reads the heightmap and/or size of the heightmap from a BMP file.
- * If map == NULL only the size of the BMP is read, otherwise a map
- * with grayscale pixels is allocated and assigned to *map.
+ * If sampler == NULL only the size of the BMP is read, otherwise the
+ * image is sampled onto the map by the sampler.
  */
-static bool ReadHeightmapBMP(const char *filename, uint *x, uint *y, byte **map)
+static bool ReadHeightmapBMP(const char *filename, uint *x, uint *y, HeightmapSampler *sampler)
 {
 	FILE *f;
 	BmpInfo info;
@@ -265,7 +452,7 @@ static bool ReadHeightmapBMP(const char *filename, uint *x, uint *y, byte **map)
 		return false;
 	}
 
-	if (map != NULL) {
+	if (sampler != NULL) {
 		if (!BmpReadBitmap(&buffer, &info, &data)) {
 			ShowErrorMessage(STR_ERROR_BMPMAP, STR_ERROR_BMPMAP_IMAGE_TYPE, WL_ERROR);
 			fclose(f);
@@ -273,8 +460,8 @@ static bool ReadHeightmapBMP(const char *filename, uint *x, uint *y, byte **map)
 			return false;
 		}
 
-		*map = MallocT<byte>(info.width * info.height);
-		ReadHeightmapBMPImageData(*map, &info, &data);
+		sampler->Init(info.width, info.height);
+		ReadHeightmapBMPImageData(sampler, &info, &data);
 	}
 
 	BmpDestroyData(&data);
@@ -289,45 +476,15 @@ static bool ReadHeightmapBMP(const char *filename, uint *x, uint *y, byte **map)
 /**
  * Converts a given grayscale map to something that fits in OTTD map system
  * and create a map of that data.
- * @param img_width  the with of the image in pixels/tiles
- * @param img_height the height of the image in pixels/tiles
- * @param map        the input map
+ * @param sampler The heightmap image sampled onto the map.
  */
-static void GrayscaleToMapHeights(uint img_width, uint img_height, byte *map)
+static void GrayscaleToMapHeights(const HeightmapSampler &sampler)
 {
-	/* Defines the detail of the aspect ratio (to avoid doubles) */
-	const uint num_div = 16384;
-
-	uint width, height;
+	uint width = sampler.width;
+	uint height = sampler.height;
 	uint row, col;
-	uint row_pad = 0, col_pad = 0;
-	uint img_scale;
-	uint img_row, img_col;
 	TileIndex tile;
 
-	/* Get map size and calculate scale and padding values */
-	switch (_settings_game.game_creation.heightmap_rotation) {
-		default: NOT_REACHED();
-		case HM_COUNTER_CLOCKWISE:
-			width   = MapSizeX();
-			height  = MapSizeY();
-			break;
-		case HM_CLOCKWISE:
-			width   = MapSizeY();
-			height  = MapSizeX();
-			break;
-	}
-
-	if ((img_width * num_div) / img_height > ((width * num_div) / height)) {
-		/* Image is wider than map - center vertically */
-		img_scale = (width * num_div) / img_width;
-		row_pad = (1 + height - ((img_height * img_scale) / num_div)) / 2;
-	} else {
-		/* Image is taller than map - center horizontally */
-		img_scale = (height * num_div) / img_height;
-		col_pad = (1 + width - ((img_width * img_scale) / num_div)) / 2;
-	}
-
 	if (_settings_game.construction.freeform_edges) {
 		for (uint x = 0; x < MapSizeX(); x++) MakeVoid(TileXY(x, 0));
 		for (uint y = 0; y < MapSizeY(); y++) MakeVoid(TileXY(0, y));
@@ -344,27 +501,11 @@ static void GrayscaleToMapHeights(uint img_width, uint img_height, byte *map)
 
 			/* Check if current tile is within the 1-pixel map edge or padding regions */
 			if ((!_settings_game.construction.freeform_edges && DistanceFromEdge(tile) <= 1) ||
-					(row < row_pad) || (row >= (height - row_pad - (_settings_game.construction.freeform_edges ? 0 : 1))) ||
-					(col < col_pad) || (col >= (width  - col_pad - (_settings_game.construction.freeform_edges ? 0 : 1)))) {
+					(row < sampler.first_row) || (row >= sampler.last_row) ||
+					(col < sampler.first_col) || (col >= sampler.last_col)) {
 				SetTileHeight(tile, 0);
 			} else {
-				/* Use nearest neighbour resizing to scale map data.
-				 *  We rotate the map 45 degrees (counter)clockwise */
-				img_row = (((row - row_pad) * num_div) / img_scale);
-				switch (_settings_game.game_creation.heightmap_rotation) {
-					default: NOT_REACHED();
-					case HM_COUNTER_CLOCKWISE:
-						img_col = (((width - 1 - col - col_pad) * num_div) / img_scale);
-						break;
-					case HM_CLOCKWISE:
-						img_col = (((col - col_pad) * num_div) / img_scale);
-						break;
-				}
-
-				assert(img_row < img_height);
-				assert(img_col < img_width);
-
-				uint heightmap_height = map[img_row * img_width + img_col];
+				uint heightmap_height = sampler.samples[row * width + col];
 
 				if (heightmap_height > 0) {
 					/* 0 is sea level.
@@ -449,10 +590,10 @@ void FixSlopes()
  * @param filename Name of the file to load.
  * @param[out] x Length of the image.
  * @param[out] y Height of the image.
- * @param[in,out] map If not \c NULL, destination to store the loaded block of image data.
+ * @param[in,out] sampler If not \c NULL, sampler to feed the image data to.
  * @return Whether loading was successful.
  */
-static bool ReadHeightMap(DetailedFileType dft, const char *filename, uint *x, uint *y, byte **map)
+static bool ReadHeightMap(DetailedFileType dft, const char *filename, uint *x, uint *y, HeightmapSampler *sampler)
 {
 	switch (dft) {
 		default:
@@ -460,11 +601,11 @@ static bool ReadHeightMap(DetailedFileType dft, const char *filename, uint *x, u
 
 #ifdef WITH_PNG
 		case DFT_HEIGHTMAP_PNG:
-			return ReadHeightmapPNG(filename, x, y, map);
+			return ReadHeightmapPNG(filename, x, y, sampler);
 #endif /* WITH_PNG */
 
 		case DFT_HEIGHTMAP_BMP:
-			return ReadHeightmapBMP(filename, x, y, map);
+			return ReadHeightmapBMP(filename, x, y, sampler);
 	}
 }
 
@@ -491,15 +632,11 @@ bool GetHeightmapDimensions(DetailedFileType dft, const char *filename, uint *x,
 void LoadHeightmap(DetailedFileType dft, const char *filename)
 {
 	uint x, y;
-	byte *map = NULL;
+	HeightmapSampler sampler;
 
-	if (!ReadHeightMap(dft, filename, &x, &y, &map)) {
-		free(map);
-		return;
-	}
+	if (!ReadHeightMap(dft, filename, &x, &y, &sampler)) return;
 
-	GrayscaleToMapHeights(x, y, map);
-	free(map);
+	GrayscaleToMapHeights(sampler);
 
 	FixSlopes();
 	MarkWholeScreenDirty();
@@ -64,6 +64,7 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 
 	PartOfSubsidyByte part_of_subsidy;  ///< NOSAVE: is this industry a source/destination of a subsidy?
 	StationList stations_near;          ///< NOSAVE: List of nearby stations.
+	uint16 tile_anim_triggers;          ///< NOSAVE: Animation triggers of the tiles of the industry; may contain triggers no tile has any more.
 
 	OwnerByte founder;                  ///< Founder of the industry
 	Date construction_date;             ///< Date of the construction of the industry
@@ -75,10 +76,11 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 
 	PersistentStorage *psa;             ///< Persistent storage for NewGRF industries.
 
-	Industry(TileIndex tile = INVALID_TILE) : location(tile, 0, 0) {}
+	Industry(TileIndex tile = INVALID_TILE) : location(tile, 0, 0), tile_anim_triggers(0) {}
 	~Industry();
 
 	void RecomputeProductionMultipliers();
+	void UpdateTileAnimationTriggers();
 
 	/**
 	 * Check if a given tile belongs to this industry.
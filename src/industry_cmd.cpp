@@ -13,6 +13,7 @@
 #include "clear_map.h"
 #include "industry.h"
 #include "station_base.h"
+#include "station_func.h"
 #include "landscape.h"
 #include "viewport_func.h"
 #include "command_func.h"
@@ -133,6 +134,18 @@ const IndustryTileSpec *GetIndustryTileSpec(IndustryGfx gfx)
 	return &_industry_tile_specs[gfx];
 }
 
+/**
+ * Change the graphics of a tile of an existing industry.
+ * @param tile The industry tile.
+ * @param gfx  The new graphics.
+ */
+static void ChangeIndustryTileGfx(TileIndex tile, IndustryGfx gfx)
+{
+	SetIndustryGfx(tile, gfx);
+	/* The new graphics may react to other animation triggers. */
+	Industry::GetByTile(tile)->tile_anim_triggers |= GetIndustryTileSpec(gfx)->animation.triggers;
+}
+
 Industry::~Industry()
 {
 	if (CleaningPool()) return;
@@ -650,7 +663,7 @@ static void AnimateTile_Industry(TileIndex tile)
 			IndustryGfx gfx = GetIndustryGfx(tile);
 
 			gfx = (gfx < 155) ? gfx + 1 : 148;
-			SetIndustryGfx(tile, gfx);
+			ChangeIndustryTileGfx(tile, gfx);
 			MarkTileDirtyByTile(tile);
 		}
 		break;
@@ -664,12 +677,12 @@ static void AnimateTile_Industry(TileIndex tile)
 
 			byte m = GetAnimationFrame(tile) + 1;
 			if (m == 4 && (m = 0, ++gfx) == GFX_OILWELL_ANIMATED_3 + 1 && (gfx = GFX_OILWELL_ANIMATED_1, b)) {
-				SetIndustryGfx(tile, GFX_OILWELL_NOT_ANIMATED);
+				ChangeIndustryTileGfx(tile, GFX_OILWELL_NOT_ANIMATED);
 				SetIndustryConstructionStage(tile, 3);
 				DeleteAnimatedTile(tile);
 			} else {
 				SetAnimationFrame(tile, m);
-				SetIndustryGfx(tile, gfx);
+				ChangeIndustryTileGfx(tile, gfx);
 				MarkTileDirtyByTile(tile);
 			}
 		}
@@ -827,7 +840,7 @@ static void TileLoop_Industry(TileIndex tile)
 		if (newgfx != INDUSTRYTILE_NOANIM) {
 			ResetIndustryConstructionStage(tile);
 			SetIndustryCompleted(tile);
-			SetIndustryGfx(tile, newgfx);
+			ChangeIndustryTileGfx(tile, newgfx);
 			MarkTileDirtyByTile(tile);
 			return;
 		}
@@ -838,7 +851,7 @@ static void TileLoop_Industry(TileIndex tile)
 	IndustryGfx newgfx = GetIndustryTileSpec(GetIndustryGfx(tile))->anim_next;
 	if (newgfx != INDUSTRYTILE_NOANIM) {
 		ResetIndustryConstructionStage(tile);
-		SetIndustryGfx(tile, newgfx);
+		ChangeIndustryTileGfx(tile, newgfx);
 		MarkTileDirtyByTile(tile);
 		return;
 	}
@@ -854,7 +867,7 @@ static void TileLoop_Industry(TileIndex tile)
 				case GFX_COPPER_MINE_TOWER_NOT_ANIMATED: gfx = GFX_COPPER_MINE_TOWER_ANIMATED; break;
 				case GFX_GOLD_MINE_TOWER_NOT_ANIMATED:   gfx = GFX_GOLD_MINE_TOWER_ANIMATED;   break;
 			}
-			SetIndustryGfx(tile, gfx);
+			ChangeIndustryTileGfx(tile, gfx);
 			SetAnimationFrame(tile, 0x80);
 			AddAnimatedTile(tile);
 		}
@@ -862,7 +875,7 @@ static void TileLoop_Industry(TileIndex tile)
 
 	case GFX_OILWELL_NOT_ANIMATED:
 		if (Chance16(1, 6)) {
-			SetIndustryGfx(tile, GFX_OILWELL_ANIMATED_1);
+			ChangeIndustryTileGfx(tile, GFX_OILWELL_ANIMATED_1);
 			SetAnimationFrame(tile, 0);
 			AddAnimatedTile(tile);
 		}
@@ -877,7 +890,7 @@ static void TileLoop_Industry(TileIndex tile)
 				case GFX_COPPER_MINE_TOWER_ANIMATED: gfx = GFX_COPPER_MINE_TOWER_NOT_ANIMATED; break;
 				case GFX_GOLD_MINE_TOWER_ANIMATED:   gfx = GFX_GOLD_MINE_TOWER_NOT_ANIMATED;   break;
 			}
-			SetIndustryGfx(tile, gfx);
+			ChangeIndustryTileGfx(tile, gfx);
 			SetIndustryCompleted(tile);
 			SetIndustryConstructionStage(tile, 3);
 			DeleteAnimatedTile(tile);
@@ -1113,6 +1126,12 @@ static void ChopLumberMillTrees(Industry *i)
 
 static void ProduceIndustryGoods(Industry *i)
 {
+	/* On most ticks there is neither a sound to play nor cargo to produce; just count down. */
+	if ((i->counter & 0x3F) != 0 && ((uint16)(i->counter - 1) % INDUSTRY_PRODUCE_TICKS) != 0) {
+		i->counter--;
+		return;
+	}
+
 	const IndustrySpec *indsp = GetIndustrySpec(i->type);
 
 	/* play a sound? */
@@ -1844,11 +1863,14 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 		}
 	} while ((++it)->ti.x != -0x80);
 
+	i->UpdateTileAnimationTriggers();
+
 	if (GetIndustrySpec(i->type)->behaviour & INDUSTRYBEH_PLANT_ON_BUILT) {
 		for (uint j = 0; j != 50; j++) PlantRandomFarmField(i);
 	}
 	InvalidateWindowData(WC_INDUSTRY_DIRECTORY, 0, 0);
 
+	InvalidateStationAcceptanceCache(i->location);
 	if (!_generating_world) PopulateStationsNearby(i);
 }
 
@@ -2250,6 +2272,19 @@ static void UpdateIndustryStatistics(Industry *i)
 	}
 }
 
+/**
+ * Collect the animation triggers of the tiles of the industry, so the
+ * industry wide animation triggers can skip looking at the tiles when
+ * none of them reacts.
+ */
+void Industry::UpdateTileAnimationTriggers()
+{
+	this->tile_anim_triggers = 0;
+	TILE_AREA_LOOP(tile, this->location) {
+		if (this->TileBelongsToIndustry(tile)) this->tile_anim_triggers |= GetIndustryTileSpec(GetIndustryGfx(tile))->animation.triggers;
+	}
+}
+
 /**
  * Recompute #production_rate for current #prod_level.
  * This function is only valid when not using smooth economy.
@@ -30,6 +30,7 @@ IniItem::IniItem(IniGroup *parent, const char *name, const char *last) : next(NU
 
 	*parent->last_item = this;
 	parent->last_item = &this->next;
+	parent->item_index.emplace(this->name, this);
 }
 
 /** Free everything we loaded. */
@@ -66,6 +67,7 @@ IniGroup::IniGroup(IniLoadFile *parent, const char *name, const char *last) : ne
 	this->last_item = &this->item;
 	*parent->last_group = this;
 	parent->last_group = &this->next;
+	parent->group_index.emplace(this->name, this);
 
 	if (parent->list_group_names != NULL) {
 		for (uint i = 0; parent->list_group_names[i] != NULL; i++) {
@@ -104,9 +106,8 @@ IniGroup::~IniGroup()
  */
 IniItem *IniGroup::GetItem(const char *name, bool create)
 {
-	for (IniItem *item = this->item; item != NULL; item = item->next) {
-		if (strcmp(item->name, name) == 0) return item;
-	}
+	std::unordered_map<std::string, IniItem *>::const_iterator it = this->item_index.find(name);
+	if (it != this->item_index.end()) return it->second;
 
 	if (!create) return NULL;
 
@@ -122,6 +123,7 @@ void IniGroup::Clear()
 	delete this->item;
 	this->item = NULL;
 	this->last_item = &this->item;
+	this->item_index.clear();
 }
 
 /**
@@ -158,11 +160,8 @@ IniGroup *IniLoadFile::GetGroup(const char *name, size_t len, bool create_new)
 	if (len == 0) len = strlen(name);
 
 	/* does it exist already? */
-	for (IniGroup *group = this->group; group != NULL; group = group->next) {
-		if (!strncmp(group->name, name, len) && group->name[len] == 0) {
-			return group;
-		}
-	}
+	std::unordered_map<std::string, IniGroup *>::const_iterator it = this->group_index.find(std::string(name, len));
+	if (it != this->group_index.end()) return it->second;
 
 	if (!create_new) return NULL;
 
@@ -199,6 +198,18 @@ void IniLoadFile::RemoveGroup(const char *name)
 		if (this->last_group == &group->next) this->last_group = &this->group;
 	}
 
+	/* Let a later group with the same name take the place of this one in the index. */
+	std::unordered_map<std::string, IniGroup *>::iterator it = this->group_index.find(group->name);
+	if (it != this->group_index.end() && it->second == group) {
+		this->group_index.erase(it);
+		for (IniGroup *other = group->next; other != NULL; other = other->next) {
+			if (strcmp(other->name, group->name) == 0) {
+				this->group_index.emplace(other->name, other);
+				break;
+			}
+		}
+	}
+
 	group->next = NULL;
 	delete group;
 }
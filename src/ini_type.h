@@ -13,6 +13,8 @@
 #define INI_TYPE_H
 
 #include "fileio_type.h"
+#include <string>
+#include <unordered_map>
 
 /** Types of groups */
 enum IniGroupType {
@@ -42,6 +44,7 @@ struct IniGroup {
 	IniItem **last_item; ///< the last item in the group
 	char *name;          ///< name of group
 	char *comment;       ///< comment for group
+	std::unordered_map<std::string, IniItem *> item_index; ///< The first item with each name, for #GetItem.
 
 	IniGroup(struct IniLoadFile *parent, const char *name, const char *last = NULL);
 	~IniGroup();
@@ -57,6 +60,7 @@ struct IniLoadFile {
 	char *comment;                        ///< last comment in file
 	const char * const *list_group_names; ///< NULL terminated list with group names that are lists
 	const char * const *seq_group_names;  ///< NULL terminated list with group names that are sequences.
+	std::unordered_map<std::string, IniGroup *> group_index; ///< The first group with each name, for #GetGroup.
 
 	IniLoadFile(const char * const *list_group_names = NULL, const char * const *seq_group_names = NULL);
 	virtual ~IniLoadFile();
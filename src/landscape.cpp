@@ -33,8 +33,9 @@
 #include "pathfinder/npf/aystar.h"
 #include "saveload/saveload.h"
 #include "framerate_type.h"
-#include <list>
-#include <set>
+#include "newgrf.h"
+#include <algorithm>
+#include <vector>
 
 #include "table/strings.h"
 #include "table/sprites.h"
@@ -798,44 +799,148 @@ CommandCost CmdClearArea(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 TileIndex _cur_tileloop_tile;
 
 /**
- * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
+ * Call the TileLoopProc of a tile, unless it is known to do nothing.
+ * Void tiles never do anything. Water tiles are skipped while their bit in
+ * #_tile_loop_idle is set, unless their tile loop may play an ambient sound:
+ * that uses the game's random generator and has to happen for every tile.
+ * @param tile The tile to run the tile loop for.
+ * @param ambient_sound Whether the ambient sound callback is enabled.
  */
-void RunTileLoop()
+static inline void RunTileLoopProc(TileIndex tile, bool ambient_sound)
 {
-	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
+	switch (GetTileType(tile)) {
+		case MP_VOID:
+			return;
+
+		case MP_WATER:
+			if (!ambient_sound && IsTileLoopIdle(tile)) return;
+			TileLoop_Water(tile);
+			/* Remember that flooding can't happen here till something changes around. */
+			if (IsTileType(tile, MP_WATER) && !IsTileLoopIdle(tile) && IsWaterTileLoopIdle(tile)) SetTileLoopIdle(tile);
+			return;
+
+		default:
+			_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+			return;
+	}
+}
 
-	/* The pseudorandom sequence of tiles is generated using a Galois linear feedback
-	 * shift register (LFSR). This allows a deterministic pseudorandom ordering, but
-	 * still with minimal state and fast iteration. */
+/** Number of tiles whose tile loops are run as one batch. */
+static const uint TILE_LOOP_BATCH_SIZE = 64;
+
+/**
+ * Run the tile loops of a batch of tiles, in the given order.
+ * The tiles visited by the tile loop are scattered over the whole map, so
+ * nearly every visit misses the cache. Requesting the tile data of the whole
+ * batch up front lets these misses overlap instead of being waited for one
+ * after another, while the tile loops are still run in the original order.
+ * @param tiles The tiles to run the tile loop for.
+ * @param count The number of tiles.
+ * @param ambient_sound Whether the ambient sound callback is enabled.
+ */
+static void RunTileLoopBatch(const TileIndex *tiles, uint count, bool ambient_sound)
+{
+	for (uint i = 0; i < count; i++) {
+#ifdef WITH_SOA_MAP
+		PREFETCH(&_m.type[tiles[i]]);
+		PREFETCH(&_m.m5[tiles[i]]);
+#else
+		PREFETCH(&_m[tiles[i]]);
+#endif
+		PREFETCH(&_tile_loop_idle[tiles[i] >> 3]);
+	}
+
+	for (uint i = 0; i < count; i++) {
+		RunTileLoopProc(tiles[i], ambient_sound);
+	}
+}
 
+/**
+ * Get the feedback terms of the linear feedback shift register walking over all tiles of the current map.
+ * @return The feedback terms.
+ */
+static uint32 GetTileLoopFeedback()
+{
 	/* Maximal length LFSR feedback terms, from 12-bit (for 64x64 maps) to 24-bit (for 4096x4096 maps).
 	 * Extracted from http://www.ece.cmu.edu/~koopman/lfsr/ */
 	static const uint32 feedbacks[] = {
 		0xD8F, 0x1296, 0x2496, 0x4357, 0x8679, 0x1030E, 0x206CD, 0x403FE, 0x807B8, 0x1004B2, 0x2006A8, 0x4004B2, 0x800B87
 	};
 	assert_compile(lengthof(feedbacks) == 2 * MAX_MAP_SIZE_BITS - 2 * MIN_MAP_SIZE_BITS + 1);
-	const uint32 feedback = feedbacks[MapLogX() + MapLogY() - 2 * MIN_MAP_SIZE_BITS];
+	return feedbacks[MapLogX() + MapLogY() - 2 * MIN_MAP_SIZE_BITS];
+}
 
+/**
+ * Run the tile loops of the tiles that are to be updated in the current tick.
+ * @param tile          The next tile in the pseudorandom sequence.
+ * @param feedback      The feedback terms of the sequence, see #GetTileLoopFeedback.
+ * @param ambient_sound Whether the ambient sound callback is enabled.
+ * @return The next tile in the sequence for the next tick.
+ */
+static TileIndex RunTileLoopTick(TileIndex tile, uint32 feedback, bool ambient_sound)
+{
 	/* We update every tile every 256 ticks, so divide the map size by 2^8 = 256 */
 	uint count = 1 << (MapLogX() + MapLogY() - 8);
 
-	TileIndex tile = _cur_tileloop_tile;
 	/* The LFSR cannot have a zeroed state. */
 	assert(tile != 0);
 
 	/* Manually update tile 0 every 256 ticks - the LFSR never iterates over it itself.  */
 	if (_tick_counter % 256 == 0) {
-		_tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
+		RunTileLoopProc(0, ambient_sound);
 		count--;
 	}
 
-	while (count--) {
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+	TileIndex batch[TILE_LOOP_BATCH_SIZE];
+	while (count > 0) {
+		uint batch_count = min(count, TILE_LOOP_BATCH_SIZE);
+		for (uint i = 0; i < batch_count; i++) {
+			batch[i] = tile;
 
-		/* Get the next tile in sequence using a Galois LFSR. */
-		tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
+			/* Get the next tile in sequence using a Galois LFSR. */
+			tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
+		}
+		RunTileLoopBatch(batch, batch_count, ambient_sound);
+		count -= batch_count;
 	}
 
+	return tile;
+}
+
+/**
+ * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
+ */
+void RunTileLoop()
+{
+	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
+
+	/* The pseudorandom sequence of tiles is generated using a Galois linear feedback
+	 * shift register (LFSR). This allows a deterministic pseudorandom ordering, but
+	 * still with minimal state and fast iteration. */
+
+	/* Idle tiles can't be skipped while their ambient sound callback may draw random numbers. */
+	const bool ambient_sound = HasGrfMiscBit(GMB_AMBIENT_SOUND_CALLBACK);
+
+	_cur_tileloop_tile = RunTileLoopTick(_cur_tileloop_tile, GetTileLoopFeedback(), ambient_sound);
+}
+
+/**
+ * Run the tile loop for a number of ticks in a row, like the world generator does
+ * to let the landscape settle. This does exactly what calling #RunTileLoop and
+ * increasing #_tick_counter for every tick does, but without looking up the
+ * constant parts of the tile loop and measuring its performance every tick.
+ * @param ticks The number of ticks to run the tile loop for.
+ */
+void RunTileLoopTicks(uint ticks)
+{
+	const uint32 feedback = GetTileLoopFeedback();
+	const bool ambient_sound = HasGrfMiscBit(GMB_AMBIENT_SOUND_CALLBACK);
+
+	TileIndex tile = _cur_tileloop_tile;
+	for (uint i = 0; i < ticks; i++) {
+		tile = RunTileLoopTick(tile, feedback, ambient_sound);
+		_tick_counter++;
+	}
 	_cur_tileloop_tile = tile;
 }
 
@@ -1142,17 +1247,34 @@ static void River_FoundEndNode(AyStar *aystar, OpenListNode *current)
 	}
 }
 
-static const uint RIVER_HASH_SIZE = 8; ///< The number of bits the hash for river finding should have.
+static const uint RIVER_HASH_SIZE = 1 << 8; ///< The number of nodes the hashes for river finding initially have space for.
 
-/**
- * Simple hash function for river tiles to be used by AyStar.
- * @param tile The tile to hash.
- * @param dir The unused direction.
- * @return The hash for the tile.
- */
-static uint River_Hash(uint tile, uint dir)
+static AyStar _river_finder;                   ///< Path finder used for all rivers of a map, so its hashes and heap are only allocated once.
+static uint8 *_river_marks = NULL;             ///< One bit per tile, set for the tiles #FlowRiver already considered.
+static std::vector<TileIndex> _river_searched; ///< The tiles #FlowRiver considered, in the order they were found.
+
+/** Allocate the path finder and search state shared by all rivers. */
+static void InitRiverGeneration()
+{
+	_river_finder = AyStar();
+	_river_finder.CalculateG = River_CalculateG;
+	_river_finder.CalculateH = River_CalculateH;
+	_river_finder.GetNeighbours = River_GetNeighbours;
+	_river_finder.EndNodeCheck = River_EndNodeCheck;
+	_river_finder.FoundEndNode = River_FoundEndNode;
+	_river_finder.Init(RIVER_HASH_SIZE);
+
+	_river_marks = CallocT<uint8>(MapSize() / 8);
+}
+
+/** Free the path finder and search state shared by all rivers. */
+static void FreeRiverGeneration()
 {
-	return GB(TileHash(TileX(tile), TileY(tile)), 0, RIVER_HASH_SIZE);
+	_river_finder.Free();
+	free(_river_marks);
+	_river_marks = NULL;
+	_river_searched.clear();
+	_river_searched.shrink_to_fit();
 }
 
 /**
@@ -1162,22 +1284,14 @@ static uint River_Hash(uint tile, uint dir)
  */
 static void BuildRiver(TileIndex begin, TileIndex end)
 {
-	AyStar finder = {};
-	finder.CalculateG = River_CalculateG;
-	finder.CalculateH = River_CalculateH;
-	finder.GetNeighbours = River_GetNeighbours;
-	finder.EndNodeCheck = River_EndNodeCheck;
-	finder.FoundEndNode = River_FoundEndNode;
-	finder.user_target = &end;
-
-	finder.Init(River_Hash, 1 << RIVER_HASH_SIZE);
+	_river_finder.user_target = &end;
 
 	AyStarNode start;
 	start.tile = begin;
 	start.direction = INVALID_TRACKDIR;
-	finder.AddStartNode(&start, 0);
-	finder.Main();
-	finder.Free();
+	_river_finder.AddStartNode(&start, 0);
+	/* Main clears the finder once it is done, ready for the next river. */
+	_river_finder.Main();
 }
 
 /**
@@ -1188,25 +1302,23 @@ static void BuildRiver(TileIndex begin, TileIndex end)
  */
 static bool FlowRiver(TileIndex spring, TileIndex begin)
 {
-	#define SET_MARK(x) marks.insert(x)
-	#define IS_MARKED(x) (marks.find(x) != marks.end())
+	#define SET_MARK(x) { SetBit(_river_marks[(x) >> 3], (x) & 7); _river_searched.push_back(x); }
+	#define IS_MARKED(x) HasBit(_river_marks[(x) >> 3], (x) & 7)
 
 	uint height = TileHeight(begin);
 	if (IsWaterTile(begin)) return DistanceManhattan(spring, begin) > _settings_game.game_creation.min_river_length;
 
-	std::set<TileIndex> marks;
+	/* Breadth first search for the closest tile we can flow down to.
+	 * The searched tiles double as the queue; all tiles after 'next' are yet to be visited. */
+	assert(_river_searched.empty());
 	SET_MARK(begin);
-
-	/* Breadth first search for the closest tile we can flow down to. */
-	std::list<TileIndex> queue;
-	queue.push_back(begin);
+	size_t next = 0;
 
 	bool found = false;
 	uint count = 0; // Number of tiles considered; to be used for lake location guessing.
 	TileIndex end;
 	do {
-		end = queue.front();
-		queue.pop_front();
+		end = _river_searched[next++];
 
 		uint height2 = TileHeight(end);
 		if (IsTileFlat(end) && (height2 < height || (height2 == height && IsWaterTile(end)))) {
@@ -1219,22 +1331,31 @@ static bool FlowRiver(TileIndex spring, TileIndex begin)
 			if (IsValidTile(t2) && !IS_MARKED(t2) && FlowsDown(end, t2)) {
 				SET_MARK(t2);
 				count++;
-				queue.push_back(t2);
 			}
 		}
-	} while (!queue.empty());
+	} while (next < _river_searched.size());
+
+	TileIndex lakeCenter = 0;
+	if (!found && count > 32) {
+		/* Maybe we can make a lake. Find the Nth of the considered tiles, in order of their index. */
+		int i = RandomRange(count - 1);
+		std::nth_element(_river_searched.begin(), _river_searched.begin() + i, _river_searched.end());
+		lakeCenter = _river_searched[i];
+	}
+
+	/* Forget the searched tiles, so the search further down hill starts afresh. */
+	for (std::vector<TileIndex>::const_iterator it = _river_searched.begin(); it != _river_searched.end(); it++) {
+		ClrBit(_river_marks[*it >> 3], *it & 7);
+	}
+	_river_searched.clear();
+
+	#undef SET_MARK
+	#undef IS_MARKED
 
 	if (found) {
 		/* Flow further down hill. */
 		found = FlowRiver(spring, end);
 	} else if (count > 32) {
-		/* Maybe we can make a lake. Find the Nth of the considered tiles. */
-		TileIndex lakeCenter = 0;
-		int i = RandomRange(count - 1) + 1;
-		std::set<TileIndex>::const_iterator cit = marks.begin();
-		while (--i) cit++;
-		lakeCenter = *cit;
-
 		if (IsValidTile(lakeCenter) &&
 				/* A river, or lake, can only be built on flat slopes. */
 				IsTileFlat(lakeCenter) &&
@@ -1260,7 +1381,6 @@ static bool FlowRiver(TileIndex spring, TileIndex begin)
 		}
 	}
 
-	marks.clear();
 	if (found) BuildRiver(begin, end);
 	return found;
 }
@@ -1276,6 +1396,9 @@ static void CreateRivers()
 	uint wells = ScaleByMapSize(4 << _settings_game.game_creation.amount_of_rivers);
 	SetGeneratingWorldProgress(GWP_RIVER, wells + 256 / 64); // Include the tile loop calls below.
 
+	InitRiverGeneration();
+	GenerateWorldSetAbortCallback(FreeRiverGeneration);
+
 	for (; wells != 0; wells--) {
 		IncreaseGeneratingWorldProgress(GWP_RIVER);
 		for (int tries = 0; tries < 128; tries++) {
@@ -1285,6 +1408,9 @@ static void CreateRivers()
 		}
 	}
 
+	FreeRiverGeneration();
+	GenerateWorldSetAbortCallback(NULL);
+
 	/* Run tile loop to update the ground density. */
 	for (uint i = 0; i != 256; i++) {
 		if (i % 64 == 0) IncreaseGeneratingWorldProgress(GWP_RIVER);
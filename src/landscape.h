@@ -139,6 +139,7 @@ bool HasFoundationNE(TileIndex tile, Slope slope_here, uint z_here);
 
 void DoClearSquare(TileIndex tile);
 void RunTileLoop();
+void RunTileLoopTicks(uint ticks);
 
 void InitializeLandscape();
 void GenerateLandscape(byte mode);
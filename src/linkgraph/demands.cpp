@@ -3,6 +3,7 @@
 #include "../stdafx.h"
 #include "demands.h"
 #include <queue>
+#include <vector>
 
 #include "../safeguards.h"
 
@@ -168,7 +169,14 @@ void DemandCalculator::CalcDemand(LinkGraphJob &job, Tscaler scaler)
 	uint num_supplies = 0;
 	uint num_demands = 0;
 
+	/* The distance of every pair is needed in every round; keep the
+	 * coordinates of the nodes next to each other. */
+	std::vector<uint> node_x(job.Size());
+	std::vector<uint> node_y(job.Size());
+
 	for (NodeID node = 0; node < job.Size(); node++) {
+		node_x[node] = TileX(job[node].XY());
+		node_y[node] = TileY(job[node].XY());
 		scaler.AddNode(job[node]);
 		if (job[node].Supply() > 0) {
 			supplies.push(node);
@@ -188,6 +196,9 @@ void DemandCalculator::CalcDemand(LinkGraphJob &job, Tscaler scaler)
 	scaler.SetDemandPerNode(num_demands);
 	uint chance = 0;
 
+	/* Part of the accuracy divisor that does not depend on the distance. */
+	const int32 divisor_base = this->accuracy * (this->mod_dist - 50) / 100 + 1;
+
 	while (!supplies.empty() && !demands.empty()) {
 		NodeID from_id = supplies.front();
 		supplies.pop();
@@ -207,14 +218,17 @@ void DemandCalculator::CalcDemand(LinkGraphJob &job, Tscaler scaler)
 			int32 supply = scaler.EffectiveSupply(job[from_id], job[to_id]);
 			assert(supply > 0);
 
+			/* Same as DistanceMaxPlusManhattan, but on the cached coordinates. */
+			const uint dx = Delta(node_x[from_id], node_x[to_id]);
+			const uint dy = Delta(node_y[from_id], node_y[to_id]);
+			const int32 node_distance = dx > dy ? 2 * dx + dy : 2 * dy + dx;
+
 			/* Scale the distance by mod_dist around max_distance */
 			int32 distance = this->max_distance - (this->max_distance -
-					(int32)DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY())) *
-					this->mod_dist / 100;
+					node_distance) * this->mod_dist / 100;
 
 			/* Scale the accuracy by distance around accuracy / 2 */
-			int32 divisor = this->accuracy * (this->mod_dist - 50) / 100 +
-					this->accuracy * distance / this->max_distance + 1;
+			int32 divisor = divisor_base + this->accuracy * distance / this->max_distance;
 
 			assert(divisor > 0);
 
@@ -19,6 +19,9 @@
 LinkGraphPool _link_graph_pool("LinkGraph");
 INSTANTIATE_POOL_METHODS(LinkGraph)
 
+/** Edge returned when looking up a pair of nodes that isn't connected. */
+/* static */ const LinkGraph::BaseEdge LinkGraph::empty_edge = { 0, 0, INVALID_DATE, INVALID_DATE, 0 };
+
 /**
  * Create a node or clear it.
  * @param xy Location of the associated station.
@@ -32,18 +35,20 @@ inline void LinkGraph::BaseNode::Init(TileIndex xy, StationID st, uint demand)
 	this->demand = demand;
 	this->station = st;
 	this->last_update = INVALID_DATE;
+	this->last_job_supply = 0;
+	this->last_job_demand = 0;
 }
 
 /**
  * Create an edge.
  */
-inline void LinkGraph::BaseEdge::Init()
+void LinkGraph::BaseEdge::Init()
 {
 	this->capacity = 0;
 	this->usage = 0;
 	this->last_unrestricted_update = INVALID_DATE;
 	this->last_restricted_update = INVALID_DATE;
-	this->next_edge = INVALID_NODE;
+	this->last_job_capacity = 0;
 }
 
 /**
@@ -57,8 +62,8 @@ void LinkGraph::ShiftDates(int interval)
 	for (NodeID node1 = 0; node1 < this->Size(); ++node1) {
 		BaseNode &source = this->nodes[node1];
 		if (source.last_update != INVALID_DATE) source.last_update += interval;
-		for (NodeID node2 = 0; node2 < this->Size(); ++node2) {
-			BaseEdge &edge = this->edges[node1][node2];
+		for (EdgeMap::iterator it = this->edges[node1].begin(); it != this->edges[node1].end(); ++it) {
+			BaseEdge &edge = it->second;
 			if (edge.last_unrestricted_update != INVALID_DATE) edge.last_unrestricted_update += interval;
 			if (edge.last_restricted_update != INVALID_DATE) edge.last_restricted_update += interval;
 		}
@@ -70,12 +75,10 @@ void LinkGraph::Compress()
 	this->last_compression = (_date + this->last_compression) / 2;
 	for (NodeID node1 = 0; node1 < this->Size(); ++node1) {
 		this->nodes[node1].supply /= 2;
-		for (NodeID node2 = 0; node2 < this->Size(); ++node2) {
-			BaseEdge &edge = this->edges[node1][node2];
-			if (edge.capacity > 0) {
-				edge.capacity = max(1U, edge.capacity / 2);
-				edge.usage /= 2;
-			}
+		for (EdgeMap::iterator it = this->edges[node1].begin(); it != this->edges[node1].end(); ++it) {
+			BaseEdge &edge = it->second;
+			edge.capacity = max(1U, edge.capacity / 2);
+			edge.usage /= 2;
 		}
 	}
 }
@@ -95,22 +98,16 @@ void LinkGraph::Merge(LinkGraph *other)
 		this->nodes[new_node].supply = LinkGraph::Scale(other->nodes[node1].supply, age, other_age);
 		st->goods[this->cargo].link_graph = this->index;
 		st->goods[this->cargo].node = new_node;
-		for (NodeID node2 = 0; node2 < node1; ++node2) {
-			BaseEdge &forward = this->edges[new_node][first + node2];
-			BaseEdge &backward = this->edges[first + node2][new_node];
-			forward = other->edges[node1][node2];
-			backward = other->edges[node2][node1];
-			forward.capacity = LinkGraph::Scale(forward.capacity, age, other_age);
-			forward.usage = LinkGraph::Scale(forward.usage, age, other_age);
-			if (forward.next_edge != INVALID_NODE) forward.next_edge += first;
-			backward.capacity = LinkGraph::Scale(backward.capacity, age, other_age);
-			backward.usage = LinkGraph::Scale(backward.usage, age, other_age);
-			if (backward.next_edge != INVALID_NODE) backward.next_edge += first;
+		const EdgeMap &other_edges = other->edges[node1];
+		EdgeMap &new_edges = this->edges[new_node];
+		for (EdgeMap::const_iterator it = other_edges.begin(); it != other_edges.end(); ++it) {
+			BaseEdge &edge = new_edges[first + it->first];
+			edge = it->second;
+			edge.capacity = LinkGraph::Scale(edge.capacity, age, other_age);
+			edge.usage = LinkGraph::Scale(edge.usage, age, other_age);
 		}
-		BaseEdge &new_start = this->edges[new_node][new_node];
-		new_start = other->edges[node1][node1];
-		if (new_start.next_edge != INVALID_NODE) new_start.next_edge += first;
 	}
+	this->nodes_changed = true;
 	delete other;
 }
 
@@ -125,32 +122,25 @@ void LinkGraph::RemoveNode(NodeID id)
 	NodeID last_node = this->Size() - 1;
 	for (NodeID i = 0; i <= last_node; ++i) {
 		(*this)[i].RemoveEdge(id);
-		BaseEdge *node_edges = this->edges[i];
-		NodeID prev = i;
-		NodeID next = node_edges[i].next_edge;
-		while (next != INVALID_NODE) {
-			if (next == last_node) {
-				node_edges[prev].next_edge = id;
-				break;
-			}
-			prev = next;
-			next = node_edges[prev].next_edge;
+		if (id == last_node) continue;
+		EdgeMap &node_edges = this->edges[i];
+		EdgeMap::iterator it = node_edges.find(last_node);
+		if (it != node_edges.end()) {
+			node_edges[id] = it->second;
+			node_edges.erase(it);
 		}
-		node_edges[id] = node_edges[last_node];
 	}
 	Station::Get(this->nodes[last_node].station)->goods[this->cargo].node = id;
 	this->nodes.Erase(this->nodes.Get(id));
-	this->edges.EraseColumn(id);
-	/* Not doing EraseRow here, as having the extra invalid row doesn't hurt
-	 * and removing it would trigger a lot of memmove. The data has already
-	 * been copied around in the loop above. */
+	this->edges[id].swap(this->edges[last_node]);
+	this->edges.pop_back();
+	this->nodes_changed = true;
 }
 
 /**
  * Add a node to the component and create empty edges associated with it. Set
- * the station's last_component to this component. Calculate the distances to all
- * other nodes. The distances to _all_ nodes are important as the demand
- * calculator relies on their availability.
+ * the station's last_component to this component. The distances between the
+ * nodes are taken from their locations, so none have to be calculated here.
  * @param st New node's station.
  * @return New node's ID.
  */
@@ -160,24 +150,74 @@ NodeID LinkGraph::AddNode(const Station *st)
 
 	NodeID new_node = this->Size();
 	this->nodes.Append();
-	/* Avoid reducing the height of the matrix as that is expensive and we
-	 * most likely will increase it again later which is again expensive. */
-	this->edges.Resize(new_node + 1U,
-			max(new_node + 1U, this->edges.Height()));
+	this->edges.resize(new_node + 1U);
 
 	this->nodes[new_node].Init(st->xy, st->index,
 			HasBit(good.status, GoodsEntry::GES_ACCEPTANCE));
 
-	BaseEdge *new_edges = this->edges[new_node];
+	this->nodes_changed = true;
+	return new_node;
+}
+
+/**
+ * Check if the component has changed enough since the last job was spawned
+ * to justify a new one. Adding or removing nodes or edges, or changing the
+ * acceptance of a station, always requires a new job. Otherwise the monthly
+ * supplies and capacities are compared to those the last job has been run
+ * with; the flows found by that job are kept as long as the differences add
+ * up to less than the given percentage.
+ * @param min_change Minimum change in percent; 0 to always recalculate.
+ * @return If a new job should be spawned.
+ */
+bool LinkGraph::NeedsRecalculation(uint min_change) const
+{
+	if (min_change == 0 || this->nodes_changed) return true;
 
-	/* Reset the first edge starting at the new node */
-	new_edges[new_node].next_edge = INVALID_NODE;
+	uint64 total = 0;
+	uint64 change = 0;
+	uint num_edges = 0;
+	for (NodeID from = 0; from < this->Size(); ++from) {
+		const BaseNode &node = this->nodes[from];
+		if (node.demand != node.last_job_demand) return true;
+		uint supply = this->Monthly(node.supply);
+		total += node.last_job_supply;
+		change += Delta(supply, node.last_job_supply);
 
-	for (NodeID i = 0; i <= new_node; ++i) {
-		new_edges[i].Init();
-		this->edges[i][new_node].Init();
+		const EdgeMap &node_edges = this->edges[from];
+		for (EdgeMap::const_iterator it = node_edges.begin(); it != node_edges.end(); ++it) {
+			const BaseEdge &edge = it->second;
+			/* New edges have not been seen by any job yet. */
+			if (edge.last_job_capacity == 0) return true;
+			num_edges++;
+			uint capacity = this->Monthly(edge.capacity);
+			total += edge.last_job_capacity;
+			change += Delta(capacity, edge.last_job_capacity);
+		}
 	}
-	return new_node;
+	/* Fewer edges than before means some have been removed. */
+	if (num_edges != this->last_job_edges) return true;
+	return change * 100 >= total * min_change;
+}
+
+/**
+ * Remember the current supplies, acceptances and capacities as the ones a
+ * job has been spawned for.
+ */
+void LinkGraph::MarkRecalculated()
+{
+	this->last_job_edges = 0;
+	for (NodeID from = 0; from < this->Size(); ++from) {
+		BaseNode &node = this->nodes[from];
+		node.last_job_supply = this->Monthly(node.supply);
+		node.last_job_demand = node.demand;
+
+		EdgeMap &node_edges = this->edges[from];
+		for (EdgeMap::iterator it = node_edges.begin(); it != node_edges.end(); ++it) {
+			it->second.last_job_capacity = max(1U, this->Monthly(it->second.capacity));
+			this->last_job_edges++;
+		}
+	}
+	this->nodes_changed = false;
 }
 
 /**
@@ -191,12 +231,11 @@ NodeID LinkGraph::AddNode(const Station *st)
 void LinkGraph::Node::AddEdge(NodeID to, uint capacity, uint usage, EdgeUpdateMode mode)
 {
 	assert(this->index != to);
+	assert(this->edges.find(to) == this->edges.end());
 	BaseEdge &edge = this->edges[to];
-	BaseEdge &first = this->edges[this->index];
+	edge.Init();
 	edge.capacity = capacity;
 	edge.usage = usage;
-	edge.next_edge = first.next_edge;
-	first.next_edge = to;
 	if (mode & EUM_UNRESTRICTED)  edge.last_unrestricted_update = _date;
 	if (mode & EUM_RESTRICTED) edge.last_restricted_update = _date;
 }
@@ -212,10 +251,11 @@ void LinkGraph::Node::UpdateEdge(NodeID to, uint capacity, uint usage, EdgeUpdat
 {
 	assert(capacity > 0);
 	assert(usage <= capacity);
-	if (this->edges[to].capacity == 0) {
+	EdgeMap::iterator it = this->edges.find(to);
+	if (it == this->edges.end()) {
 		this->AddEdge(to, capacity, usage, mode);
 	} else {
-		(*this)[to].Update(capacity, usage, mode);
+		Edge(it->second).Update(capacity, usage, mode);
 	}
 }
 
@@ -225,28 +265,8 @@ void LinkGraph::Node::UpdateEdge(NodeID to, uint capacity, uint usage, EdgeUpdat
  */
 void LinkGraph::Node::RemoveEdge(NodeID to)
 {
-	if (this->index == to) return;
-	BaseEdge &edge = this->edges[to];
-	edge.capacity = 0;
-	edge.last_unrestricted_update = INVALID_DATE;
-	edge.last_restricted_update = INVALID_DATE;
-	edge.usage = 0;
-
-	NodeID prev = this->index;
-	NodeID next = this->edges[this->index].next_edge;
-	while (next != INVALID_NODE) {
-		if (next == to) {
-			/* Will be removed, skip it. */
-			this->edges[prev].next_edge = edge.next_edge;
-			edge.next_edge = INVALID_NODE;
-			break;
-		} else {
-			prev = next;
-			next = this->edges[next].next_edge;
-		}
-	}
+	this->edges.erase(to);
 }
-
 /**
  * Update an edge. If mode contains UM_REFRESH refresh the edge to have at
  * least the given capacity and usage, otherwise add the capacity and usage.
@@ -272,6 +292,22 @@ void LinkGraph::Edge::Update(uint capacity, uint usage, EdgeUpdateMode mode)
 	if (mode & EUM_RESTRICTED) this->edge.last_restricted_update = _date;
 }
 
+/**
+ * Estimate the memory used by the nodes and edges of the component.
+ * @return Approximate number of bytes, counting each edge with the size of a map node.
+ */
+size_t LinkGraph::GetMemoryUsage() const
+{
+	/* Red-black tree nodes carry a colour and three pointers besides the value. */
+	static const size_t EDGE_SIZE = sizeof(EdgeMap::value_type) + 4 * sizeof(void *);
+
+	size_t bytes = this->nodes.Capacity() * sizeof(BaseNode) + this->edges.capacity() * sizeof(EdgeMap);
+	for (EdgeMapVector::const_iterator it = this->edges.begin(); it != this->edges.end(); ++it) {
+		bytes += it->size() * EDGE_SIZE;
+	}
+	return bytes;
+}
+
 /**
  * Resize the component and fill it with empty nodes and edges. Used when
  * loading from save games. The component is expected to be empty before.
@@ -280,12 +316,10 @@ void LinkGraph::Edge::Update(uint capacity, uint usage, EdgeUpdateMode mode)
 void LinkGraph::Init(uint size)
 {
 	assert(this->Size() == 0);
-	this->edges.Resize(size, size);
+	this->edges.resize(size);
 	this->nodes.Resize(size);
 
 	for (uint i = 0; i < size; ++i) {
 		this->nodes[i].Init();
-		BaseEdge *column = this->edges[i];
-		for (uint j = 0; j < size; ++j) column[j].Init();
 	}
 }
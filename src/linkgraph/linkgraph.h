@@ -14,11 +14,12 @@
 
 #include "../core/pool_type.hpp"
 #include "../core/smallmap_type.hpp"
-#include "../core/smallmatrix_type.hpp"
 #include "../station_base.h"
 #include "../cargotype.h"
 #include "../date_func.h"
 #include "linkgraph_type.h"
+#include <map>
+#include <vector>
 
 struct SaveLoad;
 class LinkGraph;
@@ -51,24 +52,30 @@ public:
 		StationID station;       ///< Station ID.
 		TileIndex xy;            ///< Location of the station referred to by the node.
 		Date last_update;        ///< When the supply was last updated.
+		uint last_job_supply;    ///< Monthly supply when the last job for the component was spawned.
+		uint last_job_demand;    ///< Acceptance when the last job for the component was spawned.
 		void Init(TileIndex xy = INVALID_TILE, StationID st = INVALID_STATION, uint demand = 0);
 	};
 
 	/**
-	 * An edge in the link graph. Corresponds to a link between two stations or at
-	 * least the distance between them. Edges from one node to itself contain the
-	 * ID of the opposite Node of the first active edge (i.e. not just distance) in
-	 * the column as next_edge.
+	 * An edge in the link graph. Corresponds to a link between two stations.
+	 * Only edges with capacity are stored; looking up any other pair of nodes
+	 * yields #empty_edge.
 	 */
 	struct BaseEdge {
 		uint capacity;                 ///< Capacity of the link.
 		uint usage;                    ///< Usage of the link.
 		Date last_unrestricted_update; ///< When the unrestricted part of the link was last updated.
 		Date last_restricted_update;   ///< When the restricted part of the link was last updated.
-		NodeID next_edge;              ///< Destination of next valid edge starting at the same source node.
+		uint last_job_capacity;        ///< Monthly capacity when the last job for the component was spawned.
 		void Init();
 	};
 
+	/** Outgoing edges of a node, sorted by the ID of the destination node. */
+	typedef std::map<NodeID, BaseEdge> EdgeMap;
+
+	static const BaseEdge empty_edge;
+
 	/**
 	 * Wrapper for an edge (const or not) allowing retrieval, but no modification.
 	 * @tparam Tedge Actual edge class, may be "const BaseEdge" or just "BaseEdge".
@@ -119,15 +126,15 @@ public:
 
 	/**
 	 * Wrapper for a node (const or not) allowing retrieval, but no modification.
-	 * @tparam Tedge Actual node class, may be "const BaseNode" or just "BaseNode".
-	 * @tparam Tedge Actual edge class, may be "const BaseEdge" or just "BaseEdge".
+	 * @tparam Tnode Actual node class, may be "const BaseNode" or just "BaseNode".
+	 * @tparam Tedges Actual edge map class, may be "const EdgeMap" or just "EdgeMap".
 	 */
-	template<typename Tnode, typename Tedge>
+	template<typename Tnode, typename Tedges>
 	class NodeWrapper {
 	protected:
-		Tnode &node;  ///< Node being wrapped.
-		Tedge *edges; ///< Outgoing edges for wrapped node.
-		NodeID index; ///< ID of wrapped node.
+		Tnode &node;   ///< Node being wrapped.
+		Tedges &edges; ///< Outgoing edges for wrapped node.
+		NodeID index;  ///< ID of wrapped node.
 
 	public:
 
@@ -137,9 +144,15 @@ public:
 		 * @param edges Outgoing edges for node to be wrapped.
 		 * @param index ID of node to be wrapped.
 		 */
-		NodeWrapper(Tnode &node, Tedge *edges, NodeID index) : node(node),
+		NodeWrapper(Tnode &node, Tedges &edges, NodeID index) : node(node),
 			edges(edges), index(index) {}
 
+		/**
+		 * Get the number of outgoing edges of the wrapped node.
+		 * @return Number of edges.
+		 */
+		uint NumEdges() const { return (uint)this->edges.size(); }
+
 		/**
 		 * Get supply of wrapped node.
 		 * @return Supply.
@@ -173,16 +186,16 @@ public:
 
 	/**
 	 * Base class for iterating across outgoing edges of a node. Only the real
-	 * edges (those with capacity) are iterated. The ones with only distance
-	 * information are skipped.
-	 * @tparam Tedge Actual edge class. May be "BaseEdge" or "const BaseEdge".
+	 * edges (those with capacity) are stored, so only those are iterated. They
+	 * are iterated in the order of their destinations' IDs.
+	 * @tparam Tmap_iter Iterator of the edge map. May be "EdgeMap::iterator" or "EdgeMap::const_iterator".
+	 * @tparam Tedge_wrapper Edge class returned when dereferencing.
 	 * @tparam Titer Actual iterator class.
 	 */
-	template <class Tedge, class Tedge_wrapper, class Titer>
+	template <class Tmap_iter, class Tedge_wrapper, class Titer>
 	class BaseEdgeIterator {
 	protected:
-		Tedge *base;    ///< Array of edges being iterated.
-		NodeID current; ///< Current offset in edges array.
+		Tmap_iter current; ///< Current position in the edge map.
 
 		/**
 		 * A "fake" pointer to enable operator-> on temporaries. As the objects
@@ -207,15 +220,14 @@ public:
 		};
 
 	public:
+		/** Create an iterator that doesn't point anywhere yet. */
+		BaseEdgeIterator() {}
+
 		/**
 		 * Constructor.
-		 * @param base Array of edges to be iterated.
-		 * @param current ID of current node (to locate the first edge).
+		 * @param current Position in the edge map to start at.
 		 */
-		BaseEdgeIterator (Tedge *base, NodeID current) :
-			base(base),
-			current(current == INVALID_NODE ? current : base[current].next_edge)
-		{}
+		BaseEdgeIterator(Tmap_iter current) : current(current) {}
 
 		/**
 		 * Prefix-increment.
@@ -223,7 +235,7 @@ public:
 		 */
 		Titer &operator++()
 		{
-			this->current = this->base[this->current].next_edge;
+			++this->current;
 			return static_cast<Titer &>(*this);
 		}
 
@@ -234,7 +246,7 @@ public:
 		Titer operator++(int)
 		{
 			Titer ret(static_cast<Titer &>(*this));
-			this->current = this->base[this->current].next_edge;
+			++this->current;
 			return ret;
 		}
 
@@ -243,12 +255,12 @@ public:
 		 * child class.
 		 * @tparam Tother Class of other iterator.
 		 * @param other Instance of other iterator.
-		 * @return If the iterators have the same edge array and current node.
+		 * @return If the iterators point to the same edge.
 		 */
 		template<class Tother>
 		bool operator==(const Tother &other)
 		{
-			return this->base == other.base && this->current == other.current;
+			return this->current == other.current;
 		}
 
 		/**
@@ -256,12 +268,12 @@ public:
 		 * may be of a child class.
 		 * @tparam Tother Class of other iterator.
 		 * @param other Instance of other iterator.
-		 * @return If either the edge arrays or the current nodes differ.
+		 * @return If the iterators point to different edges.
 		 */
 		template<class Tother>
 		bool operator!=(const Tother &other)
 		{
-			return this->base != other.base || this->current != other.current;
+			return this->current != other.current;
 		}
 
 		/**
@@ -270,7 +282,7 @@ public:
 		 */
 		SmallPair<NodeID, Tedge_wrapper> operator*() const
 		{
-			return SmallPair<NodeID, Tedge_wrapper>(this->current, Tedge_wrapper(this->base[this->current]));
+			return SmallPair<NodeID, Tedge_wrapper>(this->current->first, Tedge_wrapper(this->current->second));
 		}
 
 		/**
@@ -298,45 +310,55 @@ public:
 		 */
 		Edge(BaseEdge &edge) : EdgeWrapper<BaseEdge>(edge) {}
 		void Update(uint capacity, uint usage, EdgeUpdateMode mode);
-		void Restrict() { this->edge.last_unrestricted_update = INVALID_DATE; }
-		void Release() { this->edge.last_restricted_update = INVALID_DATE; }
+
+		/** Mark the unrestricted part of the edge as timed out. */
+		void Restrict()
+		{
+			assert(this->edge.capacity > 0);
+			this->edge.last_unrestricted_update = INVALID_DATE;
+		}
+
+		/** Mark the restricted part of the edge as timed out. */
+		void Release()
+		{
+			assert(this->edge.capacity > 0);
+			this->edge.last_restricted_update = INVALID_DATE;
+		}
 	};
 
 	/**
 	 * An iterator for const edges. Cannot be typedef'ed because of
 	 * template-reference to ConstEdgeIterator itself.
 	 */
-	class ConstEdgeIterator : public BaseEdgeIterator<const BaseEdge, ConstEdge, ConstEdgeIterator> {
+	class ConstEdgeIterator : public BaseEdgeIterator<EdgeMap::const_iterator, ConstEdge, ConstEdgeIterator> {
 	public:
 		/**
 		 * Constructor.
-		 * @param edges Array of edges to be iterated over.
-		 * @param current ID of current edge's end node.
+		 * @param current Position in the edge map to start at.
 		 */
-		ConstEdgeIterator(const BaseEdge *edges, NodeID current) :
-			BaseEdgeIterator<const BaseEdge, ConstEdge, ConstEdgeIterator>(edges, current) {}
+		ConstEdgeIterator(EdgeMap::const_iterator current) :
+			BaseEdgeIterator<EdgeMap::const_iterator, ConstEdge, ConstEdgeIterator>(current) {}
 	};
 
 	/**
 	 * An iterator for non-const edges. Cannot be typedef'ed because of
 	 * template-reference to EdgeIterator itself.
 	 */
-	class EdgeIterator : public BaseEdgeIterator<BaseEdge, Edge, EdgeIterator> {
+	class EdgeIterator : public BaseEdgeIterator<EdgeMap::iterator, Edge, EdgeIterator> {
 	public:
 		/**
 		 * Constructor.
-		 * @param edges Array of edges to be iterated over.
-		 * @param current ID of current edge's end node.
+		 * @param current Position in the edge map to start at.
 		 */
-		EdgeIterator(BaseEdge *edges, NodeID current) :
-			BaseEdgeIterator<BaseEdge, Edge, EdgeIterator>(edges, current) {}
+		EdgeIterator(EdgeMap::iterator current) :
+			BaseEdgeIterator<EdgeMap::iterator, Edge, EdgeIterator>(current) {}
 	};
 
 	/**
 	 * Constant node class. Only retrieval operations are allowed on both the
 	 * node itself and its edges.
 	 */
-	class ConstNode : public NodeWrapper<const BaseNode, const BaseEdge> {
+	class ConstNode : public NodeWrapper<const BaseNode, const EdgeMap> {
 	public:
 		/**
 		 * Constructor.
@@ -344,34 +366,46 @@ public:
 		 * @param node ID of the node.
 		 */
 		ConstNode(const LinkGraph *lg, NodeID node) :
-			NodeWrapper<const BaseNode, const BaseEdge>(lg->nodes[node], lg->edges[node], node)
+			NodeWrapper<const BaseNode, const EdgeMap>(lg->nodes[node], lg->edges[node], node)
 		{}
 
+		/**
+		 * Get the base edge to some node. If there is no such edge #empty_edge
+		 * is returned.
+		 * @param to ID of end node of edge.
+		 * @return Base edge.
+		 */
+		const BaseEdge &GetEdge(NodeID to) const
+		{
+			EdgeMap::const_iterator it = this->edges.find(to);
+			return it != this->edges.end() ? it->second : empty_edge;
+		}
+
 		/**
 		 * Get a ConstEdge. This is not a reference as the wrapper objects are
 		 * not actually persistent.
 		 * @param to ID of end node of edge.
 		 * @return Constant edge wrapper.
 		 */
-		ConstEdge operator[](NodeID to) const { return ConstEdge(this->edges[to]); }
+		ConstEdge operator[](NodeID to) const { return ConstEdge(this->GetEdge(to)); }
 
 		/**
-		 * Get an iterator pointing to the start of the edges array.
+		 * Get an iterator pointing to the first edge.
 		 * @return Constant edge iterator.
 		 */
-		ConstEdgeIterator Begin() const { return ConstEdgeIterator(this->edges, this->index); }
+		ConstEdgeIterator Begin() const { return ConstEdgeIterator(this->edges.begin()); }
 
 		/**
-		 * Get an iterator pointing beyond the end of the edges array.
+		 * Get an iterator pointing beyond the last edge.
 		 * @return Constant edge iterator.
 		 */
-		ConstEdgeIterator End() const { return ConstEdgeIterator(this->edges, INVALID_NODE); }
+		ConstEdgeIterator End() const { return ConstEdgeIterator(this->edges.end()); }
 	};
 
 	/**
 	 * Updatable node class. The node itself as well as its edges can be modified.
 	 */
-	class Node : public NodeWrapper<BaseNode, BaseEdge> {
+	class Node : public NodeWrapper<BaseNode, EdgeMap> {
 	public:
 		/**
 		 * Constructor.
@@ -379,28 +413,34 @@ public:
 		 * @param node ID of the node.
 		 */
 		Node(LinkGraph *lg, NodeID node) :
-			NodeWrapper<BaseNode, BaseEdge>(lg->nodes[node], lg->edges[node], node)
+			NodeWrapper<BaseNode, EdgeMap>(lg->nodes[node], lg->edges[node], node)
 		{}
 
 		/**
-		 * Get an Edge. This is not a reference as the wrapper objects are not
-		 * actually persistent.
+		 * Get a ConstEdge. This is not a reference as the wrapper objects are
+		 * not actually persistent. If there is no edge to the given node, the
+		 * returned wrapper refers to #empty_edge, which is why edges can only
+		 * be modified through the iterators, #AddEdge and #UpdateEdge.
 		 * @param to ID of end node of edge.
-		 * @return Edge wrapper.
+		 * @return Constant edge wrapper.
 		 */
-		Edge operator[](NodeID to) { return Edge(this->edges[to]); }
+		ConstEdge operator[](NodeID to) const
+		{
+			EdgeMap::const_iterator it = this->edges.find(to);
+			return ConstEdge(it != this->edges.end() ? it->second : empty_edge);
+		}
 
 		/**
-		 * Get an iterator pointing to the start of the edges array.
+		 * Get an iterator pointing to the first edge.
 		 * @return Edge iterator.
 		 */
-		EdgeIterator Begin() { return EdgeIterator(this->edges, this->index); }
+		EdgeIterator Begin() { return EdgeIterator(this->edges.begin()); }
 
 		/**
-		 * Get an iterator pointing beyond the end of the edges array.
-		 * @return Constant edge iterator.
+		 * Get an iterator pointing beyond the last edge.
+		 * @return Edge iterator.
 		 */
-		EdgeIterator End() { return EdgeIterator(this->edges, INVALID_NODE); }
+		EdgeIterator End() { return EdgeIterator(this->edges.end()); }
 
 		/**
 		 * Update the node's supply and set last_update to the current date.
@@ -436,7 +476,7 @@ public:
 	};
 
 	typedef SmallVector<BaseNode, 16> NodeVector;
-	typedef SmallMatrix<BaseEdge> EdgeMatrix;
+	typedef std::vector<EdgeMap> EdgeMapVector;
 
 	/** Minimum effective distance for timeout calculation. */
 	static const uint MIN_TIMEOUT_DISTANCE = 32;
@@ -458,12 +498,12 @@ public:
 	}
 
 	/** Bare constructor, only for save/load. */
-	LinkGraph() : cargo(INVALID_CARGO), last_compression(0) {}
+	LinkGraph() : cargo(INVALID_CARGO), last_compression(0), nodes_changed(true), last_job_edges(0) {}
 	/**
 	 * Real constructor.
 	 * @param cargo Cargo the link graph is about.
 	 */
-	LinkGraph(CargoID cargo) : cargo(cargo), last_compression(_date) {}
+	LinkGraph(CargoID cargo) : cargo(cargo), last_compression(_date), nodes_changed(true), last_job_edges(0) {}
 
 	void Init(uint size);
 	void ShiftDates(int interval);
@@ -498,6 +538,8 @@ public:
 	 */
 	inline uint Size() const { return this->nodes.Length(); }
 
+	size_t GetMemoryUsage() const;
+
 	/**
 	 * Get date of last compression.
 	 * @return Date of last compression.
@@ -523,17 +565,23 @@ public:
 	NodeID AddNode(const Station *st);
 	void RemoveNode(NodeID id);
 
+	bool NeedsRecalculation(uint min_change) const;
+	void MarkRecalculated();
+
 protected:
 	friend class LinkGraph::ConstNode;
 	friend class LinkGraph::Node;
 	friend const SaveLoad *GetLinkGraphDesc();
 	friend const SaveLoad *GetLinkGraphJobDesc();
-	friend void SaveLoad_LinkGraph(LinkGraph &lg);
+	friend void Save_LinkGraph(LinkGraph &lg);
+	friend void Load_LinkGraph(LinkGraph &lg);
 
 	CargoID cargo;         ///< Cargo of this component's link graph.
 	Date last_compression; ///< Last time the capacities and supplies were compressed.
 	NodeVector nodes;      ///< Nodes in the component.
-	EdgeMatrix edges;      ///< Edges in the component.
+	EdgeMapVector edges;   ///< Outgoing edges of each node in the component.
+	bool nodes_changed;    ///< Whether nodes have been added or removed since the last job was spawned.
+	uint last_job_edges;   ///< Number of edges when the last job was spawned.
 };
 
 #define FOR_ALL_LINK_GRAPHS(var) FOR_ALL_ITEMS_FROM(LinkGraph, link_graph_index, var, 0)
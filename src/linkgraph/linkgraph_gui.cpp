@@ -52,7 +52,9 @@ void LinkGraphOverlay::GetWidgetDpi(DrawPixelInfo *dpi) const
 void LinkGraphOverlay::RebuildCache()
 {
 	this->cached_links.clear();
+	this->cached_link_list.clear();
 	this->cached_stations.clear();
+	this->cached_station_anchors.clear();
 	if (this->company_mask == 0) return;
 
 	DrawPixelInfo dpi;
@@ -97,6 +99,22 @@ void LinkGraphOverlay::RebuildCache()
 		}
 		if (this->IsPointVisible(pta, &dpi)) {
 			this->cached_stations.push_back(std::make_pair(from, supply));
+			this->cached_station_anchors.push_back(this->GetStationAnchor(sta));
+		}
+	}
+
+	/* Determine the anchors of the links once, instead of at every redraw. */
+	for (LinkMap::const_iterator i(this->cached_links.begin()); i != this->cached_links.end(); ++i) {
+		if (i->second.empty()) continue;
+		Point pta = this->GetStationAnchor(Station::Get(i->first));
+		for (StationLinkMap::const_iterator j(i->second.begin()); j != i->second.end(); ++j) {
+			CachedLink link;
+			link.from = i->first;
+			link.to = j->first;
+			link.pta = pta;
+			link.ptb = this->GetStationAnchor(Station::Get(j->first));
+			link.cargo = &j->second;
+			this->cached_link_list.push_back(link);
 		}
 	}
 }
@@ -255,15 +273,12 @@ void LinkGraphOverlay::Draw(const DrawPixelInfo *dpi)
  */
 void LinkGraphOverlay::DrawLinks(const DrawPixelInfo *dpi) const
 {
-	for (LinkMap::const_iterator i(this->cached_links.begin()); i != this->cached_links.end(); ++i) {
-		if (!Station::IsValidID(i->first)) continue;
-		Point pta = this->GetStationMiddle(Station::Get(i->first));
-		for (StationLinkMap::const_iterator j(i->second.begin()); j != i->second.end(); ++j) {
-			if (!Station::IsValidID(j->first)) continue;
-			Point ptb = this->GetStationMiddle(Station::Get(j->first));
-			if (!this->IsLinkVisible(pta, ptb, dpi, this->scale + 2)) continue;
-			this->DrawContent(pta, ptb, j->second);
-		}
+	for (CachedLinkList::const_iterator i(this->cached_link_list.begin()); i != this->cached_link_list.end(); ++i) {
+		if (!Station::IsValidID(i->from) || !Station::IsValidID(i->to)) continue;
+		Point pta = this->AnchorToScreen(i->pta);
+		Point ptb = this->AnchorToScreen(i->ptb);
+		if (!this->IsLinkVisible(pta, ptb, dpi, this->scale + 2)) continue;
+		this->DrawContent(pta, ptb, *i->cargo);
 	}
 }
 
@@ -299,13 +314,13 @@ void LinkGraphOverlay::DrawContent(Point pta, Point ptb, const LinkProperties &c
  */
 void LinkGraphOverlay::DrawStationDots(const DrawPixelInfo *dpi) const
 {
-	for (StationSupplyList::const_iterator i(this->cached_stations.begin()); i != this->cached_stations.end(); ++i) {
-		const Station *st = Station::GetIfValid(i->first);
+	for (uint i = 0; i < this->cached_stations.size(); i++) {
+		const Station *st = Station::GetIfValid(this->cached_stations[i].first);
 		if (st == NULL) continue;
-		Point pt = this->GetStationMiddle(st);
+		Point pt = this->AnchorToScreen(this->cached_station_anchors[i]);
 		if (!this->IsPointVisible(pt, dpi, 3 * this->scale)) continue;
 
-		uint r = this->scale * 2 + this->scale * 2 * min(200, i->second) / 200;
+		uint r = this->scale * 2 + this->scale * 2 * min(200, this->cached_stations[i].second) / 200;
 
 		LinkGraphOverlay::DrawVertex(pt.x, pt.y, r,
 				_colour_gradient[st->owner != OWNER_NONE ?
@@ -353,6 +368,30 @@ Point LinkGraphOverlay::GetStationMiddle(const Station *st) const
 	}
 }
 
+/**
+ * Get a position of a station that stays valid until the cache is rebuilt.
+ * For viewports these are virtual coordinates, which also stay valid while
+ * the viewport scrolls; the smallmap rebuilds the cache when it scrolls.
+ * @param st The station.
+ * @return The anchor of the station, to be converted by #AnchorToScreen.
+ */
+Point LinkGraphOverlay::GetStationAnchor(const Station *st) const
+{
+	if (this->window->viewport != NULL) return GetStationVirtualMiddle(st);
+	return this->GetStationMiddle(st);
+}
+
+/**
+ * Convert an anchor from #GetStationAnchor to the current screen position.
+ * @param anchor The anchor.
+ * @return The screen position, like #GetStationMiddle would give.
+ */
+Point LinkGraphOverlay::AnchorToScreen(Point anchor) const
+{
+	if (this->window->viewport != NULL) return VirtualToViewportCoords(this->window->viewport, anchor);
+	return anchor;
+}
+
 /**
  * Set a new cargo mask and rebuild the cache.
  * @param cargo_mask New cargo mask.
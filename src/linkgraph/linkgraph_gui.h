@@ -42,6 +42,17 @@ public:
 	typedef std::map<StationID, StationLinkMap> LinkMap;
 	typedef std::vector<std::pair<StationID, uint> > StationSupplyList;
 
+	/** A link of #cached_links together with the anchors of its ends, see #GetStationAnchor. */
+	struct CachedLink {
+		StationID from;              ///< Source station of the link.
+		StationID to;                ///< Destination station of the link.
+		Point pta;                   ///< Anchor of the source station.
+		Point ptb;                   ///< Anchor of the destination station.
+		const LinkProperties *cargo; ///< Properties of the link, owned by #cached_links.
+	};
+	typedef std::vector<CachedLink> CachedLinkList;
+	typedef std::vector<Point> StationAnchorList;
+
 	static const uint8 LINK_COLOURS[];
 
 	/**
@@ -75,11 +86,15 @@ protected:
 	CargoTypes cargo_mask;             ///< Bitmask of cargos to be displayed.
 	uint32 company_mask;               ///< Bitmask of companies to be displayed.
 	LinkMap cached_links;              ///< Cache for links to reduce recalculation.
+	CachedLinkList cached_link_list;   ///< The links in #cached_links with their anchors, in drawing order.
 	StationSupplyList cached_stations; ///< Cache for stations to be drawn.
+	StationAnchorList cached_station_anchors; ///< Anchors of the stations in #cached_stations.
 	uint scale;                        ///< Width of link lines.
 	bool dirty;                        ///< Set if overlay should be rebuilt.
 
 	Point GetStationMiddle(const Station *st) const;
+	Point GetStationAnchor(const Station *st) const;
+	Point AnchorToScreen(Point anchor) const;
 
 	void AddLinks(const Station *sta, const Station *stb);
 	void DrawLinks(const DrawPixelInfo *dpi) const;
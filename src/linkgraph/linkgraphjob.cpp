@@ -39,8 +39,9 @@ LinkGraphJob::LinkGraphJob(const LinkGraph &orig) :
 		 * This is on purpose. */
 		link_graph(orig),
 		settings(_settings_game.linkgraph),
-		thread(NULL),
-		join_date(_date + _settings_game.linkgraph.recalc_time)
+		task(NULL),
+		join_date(_date + _settings_game.linkgraph.recalc_time),
+		run_time_us(0)
 {
 }
 
@@ -56,13 +57,13 @@ void LinkGraphJob::EraseFlows(NodeID from)
 }
 
 /**
- * Spawn a thread if possible and run the link graph job in the thread. If
- * that's not possible run the job right now in the current thread.
+ * Run the link graph job on the thread pool if possible. If that's not
+ * possible run the job right now in the current thread.
  */
 void LinkGraphJob::SpawnThread()
 {
-	if (!ThreadObject::New(&(LinkGraphSchedule::Run), this, &this->thread, "ottd:linkgraph")) {
-		this->thread = NULL;
+	this->task = ThreadPoolSubmit(&(LinkGraphSchedule::Run), this);
+	if (this->task == NULL) {
 		/* Of course this will hang a bit.
 		 * On the other hand, if you want to play games which make this hang noticably
 		 * on a platform without threads then you'll probably get other problems first.
@@ -75,15 +76,16 @@ void LinkGraphJob::SpawnThread()
 }
 
 /**
- * Join the calling thread with this job's thread if threading is enabled.
+ * Wait for this job's task on the thread pool if threading is enabled.
+ * @return True if the task was not finished yet and had to be waited for.
  */
-void LinkGraphJob::JoinThread()
+bool LinkGraphJob::JoinThread()
 {
-	if (this->thread != NULL) {
-		this->thread->Join();
-		delete this->thread;
-		this->thread = NULL;
-	}
+	if (this->task == NULL) return false;
+	bool waited = !ThreadPoolIsTaskDone(this->task);
+	ThreadPoolWaitTask(this->task);
+	this->task = NULL;
+	return waited;
 }
 
 /**
@@ -154,7 +156,7 @@ LinkGraphJob::~LinkGraphJob()
 				} else {
 					FlowStat shares(INVALID_STATION, 1);
 					it->second.SwapShares(shares);
-					ge.flows.erase(it++);
+					it = ge.flows.erase(it);
 					for (FlowStat::SharesMap::const_iterator shares_it(shares.GetShares()->begin());
 							shares_it != shares.GetShares()->end(); ++shares_it) {
 						RerouteCargo(st, this->Cargo(), shares_it->second, st->index);
@@ -169,6 +171,20 @@ LinkGraphJob::~LinkGraphJob()
 		ge.flows.insert(flows.begin(), flows.end());
 		InvalidateWindowData(WC_STATION_VIEW, st->index, this->Cargo());
 	}
+	FlushCargoReroutes();
+}
+
+/**
+ * Estimate the memory used by the job: its copy of the link graph and the
+ * annotations; the paths and flows found are not counted. The annotations
+ * are estimated from the size of the link graph, as they are set up by the
+ * thread running the job.
+ * @return Approximate number of bytes.
+ */
+size_t LinkGraphJob::GetMemoryUsage() const
+{
+	size_t size = this->Size();
+	return this->link_graph.GetMemoryUsage() + size * sizeof(NodeAnnotation) + size * size * sizeof(EdgeAnnotation);
 }
 
 /**
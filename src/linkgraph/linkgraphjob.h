@@ -12,7 +12,8 @@
 #ifndef LINKGRAPHJOB_H
 #define LINKGRAPHJOB_H
 
-#include "../thread/thread.h"
+#include "../core/smallmatrix_type.hpp"
+#include "../thread/thread_pool.h"
 #include "linkgraph.h"
 #include <list>
 
@@ -59,13 +60,14 @@ private:
 protected:
 	const LinkGraph link_graph;       ///< Link graph to by analyzed. Is copied when job is started and mustn't be modified later.
 	const LinkGraphSettings settings; ///< Copy of _settings_game.linkgraph at spawn time.
-	ThreadObject *thread;             ///< Thread the job is running in or NULL if it's running in the main thread.
+	ThreadPoolTask *task;             ///< Task running the job on the thread pool or NULL if it's running in the main thread.
 	Date join_date;                   ///< Date when the job is to be joined.
+	uint32 run_time_us;               ///< Wall time the handlers took to run, in microseconds. Only valid once the thread is joined.
 	NodeAnnotationVector nodes;       ///< Extra node data necessary for link graph calculation.
 	EdgeAnnotationMatrix edges;       ///< Extra edge data necessary for link graph calculation.
 
 	void EraseFlows(NodeID from);
-	void JoinThread();
+	bool JoinThread();
 	void SpawnThread();
 
 public:
@@ -144,17 +146,19 @@ public:
 	/**
 	 * Iterator for job edges.
 	 */
-	class EdgeIterator : public LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator> {
+	class EdgeIterator : public LinkGraph::BaseEdgeIterator<LinkGraph::EdgeMap::const_iterator, Edge, EdgeIterator> {
 		EdgeAnnotation *base_anno; ///< Array of annotations to be (indirectly) iterated.
 	public:
+		/** Create an iterator that doesn't point anywhere yet. */
+		EdgeIterator() : base_anno(NULL) {}
+
 		/**
 		 * Constructor.
-		 * @param base Array of edges to be iterated.
+		 * @param current Position in the edge map to start at.
 		 * @param base_anno Array of annotations to be iterated.
-		 * @param current Start offset of iteration.
 		 */
-		EdgeIterator(const LinkGraph::BaseEdge *base, EdgeAnnotation *base_anno, NodeID current) :
-				LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator>(base, current),
+		EdgeIterator(LinkGraph::EdgeMap::const_iterator current, EdgeAnnotation *base_anno) :
+				LinkGraph::BaseEdgeIterator<LinkGraph::EdgeMap::const_iterator, Edge, EdgeIterator>(current),
 				base_anno(base_anno) {}
 
 		/**
@@ -164,7 +168,7 @@ public:
 		 */
 		SmallPair<NodeID, Edge> operator*() const
 		{
-			return SmallPair<NodeID, Edge>(this->current, Edge(this->base[this->current], this->base_anno[this->current]));
+			return SmallPair<NodeID, Edge>(this->current->first, Edge(this->current->second, this->base_anno[this->current->first]));
 		}
 
 		/**
@@ -203,21 +207,21 @@ public:
 		 * @param to Remote end of the edge.
 		 * @return Edge between this node and "to".
 		 */
-		Edge operator[](NodeID to) const { return Edge(this->edges[to], this->edge_annos[to]); }
+		Edge operator[](NodeID to) const { return Edge(this->GetEdge(to), this->edge_annos[to]); }
 
 		/**
-		 * Iterator for the "begin" of the edge array. Only edges with capacity
-		 * are iterated. The others are skipped.
+		 * Iterator for the "begin" of the edges. Only edges with capacity
+		 * are stored, so only those are iterated.
 		 * @return Iterator pointing to the first edge.
 		 */
-		EdgeIterator Begin() const { return EdgeIterator(this->edges, this->edge_annos, index); }
+		EdgeIterator Begin() const { return EdgeIterator(this->edges.begin(), this->edge_annos); }
 
 		/**
-		 * Iterator for the "end" of the edge array. Only edges with capacity
-		 * are iterated. The others are skipped.
+		 * Iterator for the "end" of the edges. Only edges with capacity
+		 * are stored, so only those are iterated.
 		 * @return Iterator pointing beyond the last edge.
 		 */
-		EdgeIterator End() const { return EdgeIterator(this->edges, this->edge_annos, INVALID_NODE); }
+		EdgeIterator End() const { return EdgeIterator(this->edges.end(), this->edge_annos); }
 
 		/**
 		 * Get amount of supply that hasn't been delivered, yet.
@@ -266,8 +270,8 @@ public:
 	 * Bare constructor, only for save/load. link_graph, join_date and actually
 	 * settings have to be brutally const-casted in order to populate them.
 	 */
-	LinkGraphJob() : settings(_settings_game.linkgraph), thread(NULL),
-			join_date(INVALID_DATE) {}
+	LinkGraphJob() : settings(_settings_game.linkgraph), task(NULL),
+			join_date(INVALID_DATE), run_time_us(0) {}
 
 	LinkGraphJob(const LinkGraph &orig);
 	~LinkGraphJob();
@@ -311,6 +315,8 @@ public:
 	 */
 	inline uint Size() const { return this->link_graph.Size(); }
 
+	size_t GetMemoryUsage() const;
+
 	/**
 	 * Get the cargo of the underlying link graph.
 	 * @return Cargo.
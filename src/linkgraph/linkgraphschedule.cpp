@@ -16,6 +16,9 @@
 #include "mcf.h"
 #include "flowmapper.h"
 #include "../framerate_type.h"
+#include "../debug.h"
+#include "../core/mem_func.hpp"
+#include <chrono>
 
 #include "../safeguards.h"
 
@@ -34,7 +37,7 @@ void LinkGraphSchedule::SpawnNext()
 	if (this->schedule.empty()) return;
 	LinkGraph *next = this->schedule.front();
 	LinkGraph *first = next;
-	while (next->Size() < 2) {
+	while (next->Size() < 2 || !next->NeedsRecalculation(_settings_game.linkgraph.recalc_min_change)) {
 		this->schedule.splice(this->schedule.end(), this->schedule, this->schedule.begin());
 		next = this->schedule.front();
 		if (next == first) return;
@@ -42,6 +45,7 @@ void LinkGraphSchedule::SpawnNext()
 	assert(next == LinkGraph::Get(next->index));
 	this->schedule.pop_front();
 	if (LinkGraphJob::CanAllocateItem()) {
+		next->MarkRecalculated();
 		LinkGraphJob *job = new LinkGraphJob(*next);
 		job->SpawnThread();
 		this->running.push_back(job);
@@ -60,7 +64,21 @@ void LinkGraphSchedule::JoinNext()
 	if (!next->IsFinished()) return;
 	this->running.pop_front();
 	LinkGraphID id = next->LinkGraphIndex();
-	delete next; // implicitly joins the thread
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool late = next->JoinThread();
+	if (late) {
+		uint32 wait_us = (uint32)min<int64>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(), UINT32_MAX);
+		this->stats.late_jobs++;
+		this->stats.wait_us += wait_us;
+		this->stats.max_wait_us = max(this->stats.max_wait_us, wait_us);
+		DEBUG(misc, 1, "Link graph job for link graph %u with %u nodes was not finished in time; the game waited %u us for it", id, next->Size(), wait_us);
+	}
+	this->stats.jobs++;
+	this->stats.nodes += next->Size();
+	this->stats.time_us += next->run_time_us;
+	this->stats.max_time_us = max(this->stats.max_time_us, next->run_time_us);
+	delete next;
 	if (LinkGraph::IsValidID(id)) {
 		LinkGraph *lg = LinkGraph::Get(id);
 		this->Unqueue(lg); // Unqueue to avoid double-queueing recycled IDs.
@@ -70,15 +88,18 @@ void LinkGraphSchedule::JoinNext()
 
 /**
  * Run all handlers for the given Job. This method is tailored to
- * ThreadObject::New.
+ * ThreadPoolSubmit.
  * @param j Pointer to a link graph job.
  */
 /* static */ void LinkGraphSchedule::Run(void *j)
 {
 	LinkGraphJob *job = (LinkGraphJob *)j;
+	PerformanceTraceScope trace("linkgraph_job");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 	for (uint i = 0; i < lengthof(instance.handlers); ++i) {
 		instance.handlers[i]->Run(*job);
 	}
+	job->run_time_us = (uint32)min<int64>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(), UINT32_MAX);
 }
 
 /**
@@ -102,6 +123,7 @@ void LinkGraphSchedule::SpawnAll()
 	}
 	instance.running.clear();
 	instance.schedule.clear();
+	MemSetT(&instance.stats, 0);
 }
 
 /**
@@ -128,6 +150,7 @@ LinkGraphSchedule::LinkGraphSchedule()
 	this->handlers[3] = new FlowMapper(false);
 	this->handlers[4] = new MCFHandler<MCF2ndPass>;
 	this->handlers[5] = new FlowMapper(true);
+	MemSetT(&this->stats, 0);
 }
 
 /**
@@ -35,6 +35,17 @@ public:
 	virtual void Run(LinkGraphJob &job) const = 0;
 };
 
+/** Statistics about the link graph jobs that have been joined; not part of the game state. */
+struct LinkGraphJobStats {
+	uint32 jobs;        ///< Number of jobs joined.
+	uint64 nodes;       ///< Total number of nodes of the joined jobs.
+	uint64 time_us;     ///< Total wall time of running the joined jobs, in microseconds.
+	uint32 max_time_us; ///< Longest wall time of running one job, in microseconds.
+	uint32 late_jobs;   ///< Number of jobs that were not finished when they were joined, so the game had to wait for them.
+	uint64 wait_us;     ///< Total time the game waited for unfinished jobs, in microseconds.
+	uint32 max_wait_us; ///< Longest time the game waited for one job, in microseconds.
+};
+
 class LinkGraphSchedule {
 private:
 	LinkGraphSchedule();
@@ -47,6 +58,7 @@ protected:
 	ComponentHandler *handlers[6]; ///< Handlers to be run for each job.
 	GraphList schedule;            ///< Queue for new jobs.
 	JobList running;               ///< Currently running jobs.
+	LinkGraphJobStats stats;       ///< Statistics about the jobs joined since the game started.
 
 public:
 	/* This is a tick where not much else is happening, so a small lag might go unnoticed. */
@@ -61,6 +73,18 @@ public:
 	void SpawnAll();
 	void ShiftDates(int interval);
 
+	/**
+	 * Get the statistics about the jobs joined since the game started.
+	 * @return The statistics.
+	 */
+	const LinkGraphJobStats &GetStats() const { return this->stats; }
+
+	/**
+	 * Get the number of jobs currently running.
+	 * @return The number of jobs.
+	 */
+	uint GetRunningCount() const { return (uint)this->running.size(); }
+
 	/**
 	 * Queue a link graph for execution.
 	 * @param lg Link graph to be queued.
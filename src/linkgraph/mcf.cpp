@@ -2,6 +2,7 @@
 
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
+#include "../thread/thread_pool.h"
 #include "mcf.h"
 #include <set>
 
@@ -9,6 +10,21 @@
 
 typedef std::map<NodeID, Path *> PathViaMap;
 
+/**
+ * Number of sources whose paths are searched at the same time. The searches
+ * of one batch all see the flows as they were before the batch, so this must
+ * not depend on the number of threads or the results would differ between
+ * clients.
+ */
+static const uint MCF_SOURCE_BATCH = 16;
+
+/** Sources of which the paths are searched by #MultiCommodityFlow::DijkstraRange. */
+struct DijkstraBatchData {
+	MultiCommodityFlow *mcf;        ///< Solver doing the searches.
+	NodeID first_source;            ///< Source belonging to the first path vector.
+	std::vector<PathVector> *paths; ///< Path vectors to be filled, one for each source.
+};
+
 /**
  * Distance-based annotation for use in the Dijkstra algorithm. This is close
  * to the original meaning of "annotation" in this context. Paths are rated
@@ -88,8 +104,7 @@ public:
 };
 
 /**
- * Iterator class for getting the edges in the order of their next_edge
- * members.
+ * Iterator class for getting the edges in the order of their destinations.
  */
 class GraphEdgeIterator {
 private:
@@ -103,9 +118,7 @@ public:
 	 * Construct a GraphEdgeIterator.
 	 * @param job Job to iterate on.
 	 */
-	GraphEdgeIterator(LinkGraphJob &job) : job(job),
-		i(NULL, NULL, INVALID_NODE), end(NULL, NULL, INVALID_NODE)
-	{}
+	GraphEdgeIterator(LinkGraphJob &job) : job(job) {}
 
 	/**
 	 * Setup the node to start iterating at.
@@ -297,6 +310,41 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 	}
 }
 
+/**
+ * Run #Dijkstra for a range of the sources of a batch.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * @param data The #DijkstraBatchData of the batch.
+ * @param first First source in the batch to search paths for.
+ * @param last One past the last source in the batch to search paths for.
+ */
+template<class Tannotation, class Tedge_iterator>
+/* static */ void MultiCommodityFlow::DijkstraRange(void *data, uint first, uint last)
+{
+	DijkstraBatchData *batch = static_cast<DijkstraBatchData *>(data);
+	for (uint i = first; i < last; ++i) {
+		batch->mcf->Dijkstra<Tannotation, Tedge_iterator>(batch->first_source + i, (*batch->paths)[i]);
+	}
+}
+
+/**
+ * Search the paths for a batch of consecutive sources at once, spread over
+ * the worker threads. The searches only read the job, so the flows have to be
+ * pushed along the paths afterwards, source by source.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * @param first_source First source to search paths for.
+ * @param count Number of sources to search paths for.
+ * @param paths Container for the paths of each source.
+ */
+template<class Tannotation, class Tedge_iterator>
+void MultiCommodityFlow::DijkstraBatch(NodeID first_source, uint count, std::vector<PathVector> &paths)
+{
+	paths.resize(count);
+	DijkstraBatchData batch = { this, first_source, &paths };
+	ThreadPoolParallelFor(&MultiCommodityFlow::DijkstraRange<Tannotation, Tedge_iterator>, &batch, count, 1);
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
@@ -490,37 +538,42 @@ bool MCF1stPass::EliminateCycles()
  */
 MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
-	PathVector paths;
+	std::vector<PathVector> batch_paths;
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool more_loops;
 
 	do {
 		more_loops = false;
-		for (NodeID source = 0; source < size; ++source) {
+		for (NodeID first = 0; first < size; first += MCF_SOURCE_BATCH) {
 			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
-
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = job[source][dest];
-				if (edge.UnsatisfiedDemand() > 0) {
-					Path *path = paths[dest];
-					assert(path != NULL);
-					/* Generally only allow paths that don't exceed the
-					 * available capacity. But if no demand has been assigned
-					 * yet, make an exception and allow any valid path *once*. */
-					if (path->GetFreeCapacity() > 0 && this->PushFlow(edge, path,
-							accuracy, this->max_saturation) > 0) {
-						/* If a path has been found there is a chance we can
-						 * find more. */
-						more_loops = more_loops || (edge.UnsatisfiedDemand() > 0);
-					} else if (edge.UnsatisfiedDemand() == edge.Demand() &&
-							path->GetFreeCapacity() > INT_MIN) {
-						this->PushFlow(edge, path, accuracy, UINT_MAX);
+			uint count = min(size - first, MCF_SOURCE_BATCH);
+			this->DijkstraBatch<DistanceAnnotation, GraphEdgeIterator>(first, count, batch_paths);
+
+			for (uint i = 0; i < count; ++i) {
+				NodeID source = first + i;
+				PathVector &paths = batch_paths[i];
+				for (NodeID dest = 0; dest < size; ++dest) {
+					Edge edge = job[source][dest];
+					if (edge.UnsatisfiedDemand() > 0) {
+						Path *path = paths[dest];
+						assert(path != NULL);
+						/* Generally only allow paths that don't exceed the
+						 * available capacity. But if no demand has been assigned
+						 * yet, make an exception and allow any valid path *once*. */
+						if (path->GetFreeCapacity() > 0 && this->PushFlow(edge, path,
+								accuracy, this->max_saturation) > 0) {
+							/* If a path has been found there is a chance we can
+							 * find more. */
+							more_loops = more_loops || (edge.UnsatisfiedDemand() > 0);
+						} else if (edge.UnsatisfiedDemand() == edge.Demand() &&
+								path->GetFreeCapacity() > INT_MIN) {
+							this->PushFlow(edge, path, accuracy, UINT_MAX);
+						}
 					}
 				}
+				this->CleanupPaths(source, paths);
 			}
-			this->CleanupPaths(source, paths);
 		}
 	} while (more_loops || this->EliminateCycles());
 }
@@ -533,23 +586,29 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
 	this->max_saturation = UINT_MAX; // disable artificial cap on saturation
-	PathVector paths;
+	std::vector<PathVector> batch_paths;
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool demand_left = true;
 	while (demand_left) {
 		demand_left = false;
-		for (NodeID source = 0; source < size; ++source) {
-			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = this->job[source][dest];
-				Path *path = paths[dest];
-				if (edge.UnsatisfiedDemand() > 0 && path->GetFreeCapacity() > INT_MIN) {
-					this->PushFlow(edge, path, accuracy, UINT_MAX);
-					if (edge.UnsatisfiedDemand() > 0) demand_left = true;
+		for (NodeID first = 0; first < size; first += MCF_SOURCE_BATCH) {
+			uint count = min(size - first, MCF_SOURCE_BATCH);
+			this->DijkstraBatch<CapacityAnnotation, FlowEdgeIterator>(first, count, batch_paths);
+
+			for (uint i = 0; i < count; ++i) {
+				NodeID source = first + i;
+				PathVector &paths = batch_paths[i];
+				for (NodeID dest = 0; dest < size; ++dest) {
+					Edge edge = this->job[source][dest];
+					Path *path = paths[dest];
+					if (edge.UnsatisfiedDemand() > 0 && path->GetFreeCapacity() > INT_MIN) {
+						this->PushFlow(edge, path, accuracy, UINT_MAX);
+						if (edge.UnsatisfiedDemand() > 0) demand_left = true;
+					}
 				}
+				this->CleanupPaths(source, paths);
 			}
-			this->CleanupPaths(source, paths);
 		}
 	}
 }
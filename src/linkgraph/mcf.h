@@ -24,6 +24,12 @@ protected:
 	template<class Tannotation, class Tedge_iterator>
 	void Dijkstra(NodeID from, PathVector &paths);
 
+	template<class Tannotation, class Tedge_iterator>
+	static void DijkstraRange(void *data, uint first, uint last);
+
+	template<class Tannotation, class Tedge_iterator>
+	void DijkstraBatch(NodeID first_source, uint count, std::vector<PathVector> &paths);
+
 	uint PushFlow(Edge &edge, Path *path, uint accuracy, uint max_saturation);
 
 	void CleanupPaths(NodeID source, PathVector &paths);
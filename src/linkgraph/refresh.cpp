@@ -24,8 +24,11 @@
  * @param v Vehicle to refresh links for.
  * @param allow_merge If the refresher is allowed to merge or extend link graphs.
  * @param is_full_loading If the vehicle is full loading.
+ * @param done_runs If not NULL, skip the run if one with the same signature is
+ *                  in this set already, otherwise add the run to it. Used when
+ *                  refreshing many vehicles sharing their orders in one go.
  */
-/* static */ void LinkRefresher::Run(Vehicle *v, bool allow_merge, bool is_full_loading)
+/* static */ void LinkRefresher::Run(Vehicle *v, bool allow_merge, bool is_full_loading, RunSet *done_runs)
 {
 	/* If there are no orders we can't predict anything.*/
 	if (v->orders.list == NULL) return;
@@ -34,10 +37,25 @@
 	const Order *first = v->orders.list->GetNextDecisionNode(v->GetOrder(v->cur_implicit_order_index), 0);
 	if (first == NULL) return;
 
+	uint8 flags = v->last_loading_station != INVALID_STATION ? 1 << HAS_CARGO : 0;
+
+	/* Full loading vehicles refresh by chance, so their runs are never the same. */
+	if (done_runs != NULL && !is_full_loading) {
+		RunSignature signature;
+		signature.push_back(first->index);
+		signature.push_back(flags | allow_merge << 8);
+		for (const Vehicle *u = v; u != NULL; u = u->Next()) {
+			signature.push_back(u->engine_type);
+			signature.push_back(u->cargo_type);
+			signature.push_back(u->cargo_cap << 16 | u->refit_cap);
+		}
+		if (!done_runs->insert(signature).second) return;
+	}
+
 	HopSet seen_hops;
 	LinkRefresher refresher(v, &seen_hops, allow_merge, is_full_loading);
 
-	refresher.RefreshLinks(first, first, v->last_loading_station != INVALID_STATION ? 1 << HAS_CARGO : 0);
+	refresher.RefreshLinks(first, first, flags);
 }
 
 /**
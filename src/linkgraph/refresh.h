@@ -14,6 +14,7 @@
 
 #include "../cargo_type.h"
 #include "../vehicle_base.h"
+#include "../core/scratch_alloc_type.hpp"
 #include <vector>
 #include <map>
 #include <set>
@@ -23,7 +24,17 @@
  */
 class LinkRefresher {
 public:
-	static void Run(Vehicle *v, bool allow_merge = true, bool is_full_loading = false);
+	/**
+	 * Signatures of the refresh runs done in one go: the first order, the
+	 * initial flags and the engines, cargoes and capacities of the consist.
+	 * Runs with the same signature walk the same orders with the same
+	 * capacities, so they refresh exactly the same links.
+	 */
+	typedef std::vector<uint32, ScratchAllocator<uint32> > RunSignature;
+	/** Signatures of the runs done so far; kept in scratch memory, so it can't outlive the game loop phase. */
+	typedef std::set<RunSignature, std::less<RunSignature>, ScratchAllocator<RunSignature> > RunSet;
+
+	static void Run(Vehicle *v, bool allow_merge = true, bool is_full_loading = false, RunSet *done_runs = NULL);
 
 protected:
 	/**
@@ -79,8 +90,8 @@ protected:
 		bool operator<(const Hop &other) const;
 	};
 
-	typedef std::vector<RefitDesc> RefitList;
-	typedef std::set<Hop> HopSet;
+	typedef std::vector<RefitDesc, ScratchAllocator<RefitDesc> > RefitList;
+	typedef std::set<Hop, std::less<Hop>, ScratchAllocator<Hop> > HopSet;
 
 	Vehicle *vehicle;           ///< Vehicle for which the links should be refreshed.
 	uint capacities[NUM_CARGO]; ///< Current added capacities per cargo ID in the consist.
@@ -12,9 +12,15 @@
 #include "stdafx.h"
 #include "debug.h"
 #include "core/alloc_func.hpp"
+#include "core/mem_func.hpp"
 #include "water_map.h"
 #include "string_func.h"
 
+#ifdef WITH_COMPACT_MAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif /* WITH_COMPACT_MAP */
+
 #include "safeguards.h"
 
 #if defined(_MSC_VER)
@@ -28,10 +34,180 @@ uint _map_size_x;    ///< Size of the map along the X
 uint _map_size_y;    ///< Size of the map along the Y
 uint _map_size;      ///< The number of tiles on the map
 uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
+uint8 *_tile_loop_idle = NULL; ///< One bit per tile whose tile loop does nothing, see #RunTileLoop.
+#ifdef WITH_SLOPE_CACHE
+uint8 *_tile_slope_cache = NULL; ///< Slope of every tile, derived from the heights of its corners; see #UpdateTileSlopeCache.
+#endif /* WITH_SLOPE_CACHE */
+
+#ifdef WITH_SOA_MAP
+TileArray _m;             ///< Tiles of the map
+TileExtendedArray _me;    ///< Extended Tiles of the map
+
+/** Free the arrays of the map. */
+static void FreeMapArrays()
+{
+	free(_m.type);
+	free(_m.height);
+	free(_m.m2);
+	free(_m.m1);
+	free(_m.m3);
+	free(_m.m4);
+	free(_m.m5);
+	free(_me.m6);
+	free(_me.m7);
+	free(_me.m8);
+}
+
+/** Allocate the (zeroed) arrays for a map of #_map_size tiles. */
+static void AllocateMapArrays()
+{
+	_m.type   = CallocT<byte>(_map_size);
+	_m.height = CallocT<byte>(_map_size);
+	_m.m2     = CallocT<uint16>(_map_size);
+	_m.m1     = CallocT<byte>(_map_size);
+	_m.m3     = CallocT<byte>(_map_size);
+	_m.m4     = CallocT<byte>(_map_size);
+	_m.m5     = CallocT<byte>(_map_size);
+	_me.m6    = CallocT<byte>(_map_size);
+	_me.m7    = CallocT<byte>(_map_size);
+	_me.m8    = CallocT<uint16>(_map_size);
+}
 
+/**
+ * Check whether the map has been allocated.
+ * @return True once #AllocateMap has been called.
+ */
+bool IsMapAllocated()
+{
+	return _m.type != NULL;
+}
+
+/**
+ * Set all data of a range of tiles to 0.
+ * @param first    The first tile to reset.
+ * @param count    The number of tiles to reset.
+ * @param extended Whether to reset the extended tile data too.
+ */
+void ResetMapTiles(TileIndex first, uint count, bool extended)
+{
+	MemSetT(_m.type + first, 0, count);
+	MemSetT(_m.height + first, 0, count);
+	MemSetT(_m.m2 + first, 0, count);
+	MemSetT(_m.m1 + first, 0, count);
+	MemSetT(_m.m3 + first, 0, count);
+	MemSetT(_m.m4 + first, 0, count);
+	MemSetT(_m.m5 + first, 0, count);
+	if (!extended) return;
+	MemSetT(_me.m6 + first, 0, count);
+	MemSetT(_me.m7 + first, 0, count);
+	MemSetT(_me.m8 + first, 0, count);
+}
+#else
 Tile *_m = NULL;          ///< Tiles of the map
 TileExtended *_me = NULL; ///< Extended Tiles of the map
 
+/** Free the arrays of the map. */
+static void FreeMapArrays()
+{
+	free(_m);
+	free(_me);
+}
+
+/** Allocate the (zeroed) arrays for a map of #_map_size tiles. */
+static void AllocateMapArrays()
+{
+	_m = CallocT<Tile>(_map_size);
+	_me = CallocT<TileExtended>(_map_size);
+}
+
+/**
+ * Check whether the map has been allocated.
+ * @return True once #AllocateMap has been called.
+ */
+bool IsMapAllocated()
+{
+	return _m != NULL;
+}
+
+/**
+ * Set all data of a range of tiles to 0.
+ * @param first    The first tile to reset.
+ * @param count    The number of tiles to reset.
+ * @param extended Whether to reset the extended tile data too.
+ */
+void ResetMapTiles(TileIndex first, uint count, bool extended)
+{
+	MemSetT(_m + first, 0, count);
+	if (extended) MemSetT(_me + first, 0, count);
+}
+#endif /* WITH_SOA_MAP */
+
+
+#ifdef WITH_COMPACT_MAP
+/**
+ * Give the pages of a block of memory that only contain zeroes back to the operating system.
+ * They keep reading as zeroes, and get memory again on the first write to them.
+ * @param mem  The memory.
+ * @param size The size of the memory in bytes.
+ * @return The number of bytes given back.
+ */
+static size_t ReleaseZeroPages(void *mem, size_t size)
+{
+	static const size_t page_size = sysconf(_SC_PAGESIZE);
+
+	/* Only whole pages within the block can be given back. */
+	uintptr_t first = Align((uintptr_t)mem, (uint)page_size);
+	uintptr_t last = ((uintptr_t)mem + size) & ~(page_size - 1);
+
+	size_t released = 0;
+	uintptr_t run = 0; // Start of the zero pages in front of the current page, or 0.
+	for (uintptr_t page = first; page <= last; page += page_size) {
+		bool zero = page < last;
+		for (const size_t *p = (const size_t *)page; zero && p < (const size_t *)(page + page_size); p++) {
+			if (*p != 0) zero = false;
+		}
+
+		if (zero) {
+			if (run == 0) run = page;
+		} else if (run != 0) {
+			if (madvise((void *)run, page - run, MADV_DONTNEED) == 0) released += page - run;
+			run = 0;
+		}
+	}
+	return released;
+}
+#endif /* WITH_COMPACT_MAP */
+
+/**
+ * Give the memory of the parts of the map that only contain zeroes back to the
+ * operating system. Large areas of clear land and sea leave whole pages of the
+ * members they do not use at zero, in particular with the map stored as one
+ * array per member. Meant to be called once the map has been generated or loaded;
+ * the pages get memory again when they are written to.
+ * Does nothing unless compiled with WITH_COMPACT_MAP.
+ */
+void CompactMapMemory()
+{
+#ifdef WITH_COMPACT_MAP
+	size_t released = 0;
+#ifdef WITH_SOA_MAP
+	released += ReleaseZeroPages(_m.type,   _map_size * sizeof(*_m.type));
+	released += ReleaseZeroPages(_m.height, _map_size * sizeof(*_m.height));
+	released += ReleaseZeroPages(_m.m2,     _map_size * sizeof(*_m.m2));
+	released += ReleaseZeroPages(_m.m1,     _map_size * sizeof(*_m.m1));
+	released += ReleaseZeroPages(_m.m3,     _map_size * sizeof(*_m.m3));
+	released += ReleaseZeroPages(_m.m4,     _map_size * sizeof(*_m.m4));
+	released += ReleaseZeroPages(_m.m5,     _map_size * sizeof(*_m.m5));
+	released += ReleaseZeroPages(_me.m6,    _map_size * sizeof(*_me.m6));
+	released += ReleaseZeroPages(_me.m7,    _map_size * sizeof(*_me.m7));
+	released += ReleaseZeroPages(_me.m8,    _map_size * sizeof(*_me.m8));
+#else
+	released += ReleaseZeroPages(_m,  _map_size * sizeof(Tile));
+	released += ReleaseZeroPages(_me, _map_size * sizeof(TileExtended));
+#endif /* WITH_SOA_MAP */
+	DEBUG(map, 1, "Gave " PRINTF_SIZE " kB of map memory without data back", released / 1024);
+#endif /* WITH_COMPACT_MAP */
+}
 
 /**
  * (Re)allocates a map with the given dimension
@@ -58,11 +234,17 @@ void AllocateMap(uint size_x, uint size_y)
 	_map_size = size_x * size_y;
 	_map_tile_mask = _map_size - 1;
 
-	free(_m);
-	free(_me);
+	FreeMapArrays();
+	AllocateMapArrays();
 
-	_m = CallocT<Tile>(_map_size);
-	_me = CallocT<TileExtended>(_map_size);
+	free(_tile_loop_idle);
+	_tile_loop_idle = CallocT<uint8>(_map_size / 8);
+
+#ifdef WITH_SLOPE_CACHE
+	/* All heights are zero, so all tiles are flat. */
+	free(_tile_slope_cache);
+	_tile_slope_cache = CallocT<uint8>(_map_size);
+#endif /* WITH_SLOPE_CACHE */
 }
 
 
@@ -13,6 +13,7 @@
 #define MAP_FUNC_H
 
 #include "core/math_func.hpp"
+#include "core/bitmath_func.hpp"
 #include "tile_type.h"
 #include "map_type.h"
 #include "direction_func.h"
@@ -27,6 +28,21 @@ extern uint _map_tile_mask;
 
 #define TILE_MASK(x) ((x) & _map_tile_mask)
 
+#ifdef WITH_SOA_MAP
+/**
+ * The tile-array, stored as one array per member.
+ *
+ * This variable contains the tiles of the map.
+ */
+extern TileArray _m;
+
+/**
+ * The extended tile-array, stored as one array per member.
+ *
+ * This variable contains the extended tiles of the map.
+ */
+extern TileExtendedArray _me;
+#else
 /**
  * Pointer to the tile-array.
  *
@@ -42,8 +58,22 @@ extern Tile *_m;
  * of the map.
  */
 extern TileExtended *_me;
+#endif /* WITH_SOA_MAP */
+
+/**
+ * Bitmap with one bit per tile, set for tiles whose periodic tile loop is
+ * known to do nothing until the tile or one of its neighbours changes type.
+ * @see RunTileLoop
+ */
+extern uint8 *_tile_loop_idle;
+#ifdef WITH_SLOPE_CACHE
+extern uint8 *_tile_slope_cache;
+#endif /* WITH_SLOPE_CACHE */
 
 void AllocateMap(uint size_x, uint size_y);
+bool IsMapAllocated();
+void ResetMapTiles(TileIndex first, uint count, bool extended);
+void CompactMapMemory();
 
 /**
  * Logarithm of the map size along the X side.
@@ -438,4 +468,39 @@ static inline TileIndex RandomTileSeed(uint32 r)
 
 uint GetClosestWaterDistance(TileIndex tile, bool water);
 
+/**
+ * Check whether the tile loop of a tile is known to do nothing.
+ * @param tile The tile to check.
+ * @return True if the tile loop can be skipped.
+ */
+static inline bool IsTileLoopIdle(TileIndex tile)
+{
+	return HasBit(_tile_loop_idle[tile >> 3], tile & 7);
+}
+
+/**
+ * Mark the tile loop of a tile as doing nothing.
+ * @param tile The tile to mark.
+ */
+static inline void SetTileLoopIdle(TileIndex tile)
+{
+	SetBit(_tile_loop_idle[tile >> 3], tile & 7);
+}
+
+/**
+ * Forget the idle state of a tile and its eight neighbours, as their
+ * tile loops may depend on the tile.
+ * @param tile The tile that changed.
+ */
+static inline void ClearTileLoopIdleAround(TileIndex tile)
+{
+	for (int dy = -1; dy <= 1; dy++) {
+		for (int dx = -1; dx <= 1; dx++) {
+			/* Wrapping at the map edges clears some unrelated bits, which is harmless. */
+			TileIndex t = tile + dy * (int)MapSizeX() + dx;
+			if (t < MapSize()) ClrBit(_tile_loop_idle[t >> 3], t & 7);
+		}
+	}
+}
+
 #endif /* MAP_FUNC_H */
@@ -38,6 +38,73 @@ struct TileExtended {
 	uint16 m8; ///< General purpose
 };
 
+#ifdef WITH_SOA_MAP
+/**
+ * References to the members of one tile, when the map is stored as a
+ * structure of arrays. This way the tile is accessed just like a #Tile.
+ */
+struct TileRef {
+	byte   &type;   ///< The type (bits 4..7), bridges (2..3), rainforest/desert (0..1)
+	byte   &height; ///< The height of the northern corner.
+	uint16 &m2;     ///< Primarily used for indices to towns, industries and stations
+	byte   &m1;     ///< Primarily used for ownership information
+	byte   &m3;     ///< General purpose
+	byte   &m4;     ///< General purpose
+	byte   &m5;     ///< General purpose
+};
+
+/** References to the members of one #TileExtended, when the map is stored as a structure of arrays. */
+struct TileExtendedRef {
+	byte   &m6; ///< General purpose
+	byte   &m7; ///< Primarily used for newgrf support
+	uint16 &m8; ///< General purpose
+};
+
+/**
+ * The tiles of the map, with a separate array per member of #Tile.
+ * Passes over the map that only need a few members, like the type and the
+ * height, then do not have to pull the other members into the cache.
+ */
+struct TileArray {
+	byte   *type;   ///< The types of the tiles.
+	byte   *height; ///< The heights of the tiles.
+	uint16 *m2;     ///< The m2 members of the tiles.
+	byte   *m1;     ///< The m1 members of the tiles.
+	byte   *m3;     ///< The m3 members of the tiles.
+	byte   *m4;     ///< The m4 members of the tiles.
+	byte   *m5;     ///< The m5 members of the tiles.
+
+	/**
+	 * Get the members of a tile.
+	 * @param tile The index of the tile.
+	 * @return References to the members of the tile.
+	 */
+	inline TileRef operator[](size_t tile) const
+	{
+		TileRef ref = { this->type[tile], this->height[tile], this->m2[tile], this->m1[tile], this->m3[tile], this->m4[tile], this->m5[tile] };
+		return ref;
+	}
+};
+
+/** The extended tiles of the map, with a separate array per member of #TileExtended. */
+struct TileExtendedArray {
+	byte   *m6; ///< The m6 members of the tiles.
+	byte   *m7; ///< The m7 members of the tiles.
+	uint16 *m8; ///< The m8 members of the tiles.
+
+	/**
+	 * Get the members of an extended tile.
+	 * @param tile The index of the tile.
+	 * @return References to the members of the extended tile.
+	 */
+	inline TileExtendedRef operator[](size_t tile) const
+	{
+		TileExtendedRef ref = { this->m6[tile], this->m7[tile], this->m8[tile] };
+		return ref;
+	}
+};
+#endif /* WITH_SOA_MAP */
+
 /**
  * An offset value between to tiles.
  *
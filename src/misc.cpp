@@ -28,9 +28,17 @@
 #include "core/pool_type.hpp"
 #include "game/game.hpp"
 #include "linkgraph/linkgraphschedule.h"
+#include "depot_kdtree.h"
 #include "station_kdtree.h"
 #include "town_kdtree.h"
 #include "viewport_kdtree.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/road_regions.h"
+#include "pathfinder/water_regions.h"
+#include "pathfinder/pathfinder_stats.h"
+#include "vehicle_func.h"
+#include "bridge_map.h"
+#include "tunnel_map.h"
 
 #include "safeguards.h"
 
@@ -80,6 +88,7 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 
 	RebuildStationKdtree();
 	RebuildTownKdtree();
+	RebuildDepotKdtree();
 	RebuildViewportKdtree();
 
 	ResetPersistentNewGRFData();
@@ -91,6 +100,8 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 
 	InitNewsItemStructs();
 	InitializeLandscape();
+	ResetBridgeIndex();
+	ResetTunnelIndex();
 	InitializeRailGui();
 	InitializeRoadGui();
 	InitializeAirportGui();
@@ -104,6 +115,12 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	InitializeBuildingCounts();
 
 	InitializeNPF();
+	/* Segments of the previous game must not be found by the pathfinder. */
+	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	InvalidateAllRoadRegions();
+	InvalidateAllWaterRegions();
+	ResetPathfinderStats();
+	ResetVehicleTickStats();
 
 	InitializeCompanies();
 	AI::Initialize();
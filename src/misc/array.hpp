@@ -52,6 +52,19 @@ public:
 		data.Clear();
 	}
 
+	/**
+	 * Destroy all items, but keep the memory of the first sub-array so
+	 * filling the array again does not have to allocate it.
+	 */
+	inline void Reset()
+	{
+		if (data.IsEmpty()) return;
+		data[0].Clear();
+		SubArray first(data[0]); // shares the block, so it survives the clear
+		data.Clear();
+		new (data.Append()) SubArray(first);
+	}
+
 	/** Return actual number of items */
 	inline uint Length() const
 	{
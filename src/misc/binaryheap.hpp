@@ -7,12 +7,13 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file binaryheap.hpp Binary heap implementation. */
+/** @file binaryheap.hpp Binary heap and 4-ary heap implementations. */
 
 #ifndef BINARYHEAP_HPP
 #define BINARYHEAP_HPP
 
 #include "../core/alloc_func.hpp"
+#include "../core/math_func.hpp"
 
 /** Enable it if you suspect binary heap doesn't work well */
 #define BINARYHEAP_CHECK 0
@@ -302,4 +303,225 @@ public:
 	}
 };
 
+/**
+ * 4-ary heap as C++ template, for use as the open list of a path finder.
+ *  Like CBinaryHeapT it holds pointers to items allocated elsewhere with
+ *  the smallest item first, but it keeps the sort key of every item next
+ *  to the pointer, so sifting never needs to look at the items themselves.
+ *  With four children per node the tree is half as deep and the children
+ *  that are compared share a cache line.
+ *
+ * @par Usage information:
+ * Items must support:
+ *   - int GetCostEstimate() const; // the sort key, smallest first
+ *   - uint GetHeapIndex() const;   // the position stored by SetHeapIndex
+ *   - void SetHeapIndex(uint index);
+ * The heap keeps the position of each item up to date, so an item can be
+ * removed or moved up after lowering its key without searching for it.
+ *
+ * @tparam T Type of the items stored in the heap
+ */
+template <class T>
+class CQuaternaryHeapT {
+private:
+	static const uint ARITY = 4; ///< Number of children of each node.
+
+	/** An item in the heap together with its sort key. */
+	struct Entry {
+		int key;    ///< Cached GetCostEstimate() of the item.
+		T *item;    ///< The item.
+	};
+
+	uint items;    ///< Number of items in the heap
+	uint capacity; ///< Maximum number of items the heap can hold without growing
+	Entry *data;   ///< The heap entries, the smallest first
+
+public:
+	/**
+	 * Create a heap.
+	 * @param initial_capacity Number of items to allocate space for at first.
+	 */
+	explicit CQuaternaryHeapT(uint initial_capacity)
+		: items(0)
+		, capacity(max(initial_capacity, 1U))
+	{
+		this->data = MallocT<Entry>(this->capacity);
+	}
+
+	~CQuaternaryHeapT()
+	{
+		free(this->data);
+		this->data = NULL;
+	}
+
+protected:
+	/**
+	 * Put an entry at a position and tell the item about it.
+	 * @param pos The position.
+	 * @param entry The entry to store.
+	 */
+	inline void Place(uint pos, const Entry &entry)
+	{
+		this->data[pos] = entry;
+		entry.item->SetHeapIndex(pos);
+	}
+
+	/**
+	 * Move an entry from a gap towards the top until its parent is not bigger.
+	 * @param gap The position of the gap.
+	 * @param entry The entry to put in the gap.
+	 */
+	inline void SiftUp(uint gap, const Entry &entry)
+	{
+		while (gap > 0) {
+			uint parent = (gap - 1) / ARITY;
+			if (!(entry.key < this->data[parent].key)) break;
+			this->Place(gap, this->data[parent]);
+			gap = parent;
+		}
+		this->Place(gap, entry);
+	}
+
+	/**
+	 * Move an entry from a gap towards the bottom until no child is smaller.
+	 * @param gap The position of the gap.
+	 * @param entry The entry to put in the gap.
+	 */
+	inline void SiftDown(uint gap, const Entry &entry)
+	{
+		for (;;) {
+			uint first = gap * ARITY + 1;
+			if (first >= this->items) break;
+
+			uint last = min(first + ARITY, this->items);
+			uint best = first;
+			for (uint child = first + 1; child < last; child++) {
+				if (this->data[child].key < this->data[best].key) best = child;
+			}
+			if (!(this->data[best].key < entry.key)) break;
+			this->Place(gap, this->data[best]);
+			gap = best;
+		}
+		this->Place(gap, entry);
+	}
+
+#if BINARYHEAP_CHECK
+	/** Verify the heap consistency */
+	inline void CheckConsistency()
+	{
+		for (uint child = 1; child < this->items; child++) {
+			assert(!(this->data[child].key < this->data[(child - 1) / ARITY].key));
+			assert(this->data[child].item->GetHeapIndex() == child);
+		}
+	}
+#endif
+
+public:
+	/**
+	 * Get the number of items stored in the priority queue.
+	 * @return The number of items in the queue
+	 */
+	inline uint Length() const
+	{
+		return this->items;
+	}
+
+	/**
+	 * Test if the priority queue is empty.
+	 * @return True if empty
+	 */
+	inline bool IsEmpty() const
+	{
+		return this->items == 0;
+	}
+
+	/**
+	 * Get the smallest item in the heap.
+	 * @return The smallest item, or throw assert if empty.
+	 */
+	inline T *Begin()
+	{
+		assert(!this->IsEmpty());
+		return this->data[0].item;
+	}
+
+	/**
+	 * Insert new item into the priority queue, maintaining heap order.
+	 * @param new_item The pointer to the new item
+	 */
+	inline void Include(T *new_item)
+	{
+		if (this->items == this->capacity) {
+			assert(this->capacity < UINT_MAX / 2);
+			this->capacity *= 2;
+			this->data = ReallocT<Entry>(this->data, this->capacity);
+		}
+
+		Entry entry = { new_item->GetCostEstimate(), new_item };
+		this->SiftUp(this->items++, entry);
+		CHECK_CONSISTY();
+	}
+
+	/**
+	 * Remove and return the smallest (and also first) item
+	 *  from the priority queue.
+	 * @return The pointer to the removed item
+	 */
+	inline T *Shift()
+	{
+		assert(!this->IsEmpty());
+		T *first = this->data[0].item;
+		this->items--;
+		if (this->items > 0) this->SiftDown(0, this->data[this->items]);
+		CHECK_CONSISTY();
+		return first;
+	}
+
+	/**
+	 * Remove an item from the priority queue.
+	 * @param item The item, which has to be in the queue.
+	 */
+	inline void Remove(T &item)
+	{
+		uint index = item.GetHeapIndex();
+		assert(index < this->items && this->data[index].item == &item);
+
+		this->items--;
+		if (index < this->items) {
+			/* Fill the gap with the last entry, which may have to go either way. */
+			Entry last = this->data[this->items];
+			if (last.key < this->data[index].key) {
+				this->SiftUp(index, last);
+			} else {
+				this->SiftDown(index, last);
+			}
+		}
+		CHECK_CONSISTY();
+	}
+
+	/**
+	 * Restore the heap order after the key of an item was lowered.
+	 * @param item The item, which has to be in the queue.
+	 */
+	inline void DecreaseKey(T &item)
+	{
+		uint index = item.GetHeapIndex();
+		assert(index < this->items && this->data[index].item == &item);
+		assert(item.GetCostEstimate() <= this->data[index].key);
+
+		Entry entry = { item.GetCostEstimate(), &item };
+		this->SiftUp(index, entry);
+		CHECK_CONSISTY();
+	}
+
+	/**
+	 * Make the priority queue empty.
+	 * All remaining items will remain untouched.
+	 */
+	inline void Clear()
+	{
+		this->items = 0;
+	}
+};
+
 #endif /* BINARYHEAP_HPP */
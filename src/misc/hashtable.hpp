@@ -13,6 +13,8 @@
 #define HASHTABLE_HPP
 
 #include "../core/math_func.hpp"
+#include <algorithm>
+#include <vector>
 
 template <class Titem_>
 struct CHashTableSlotT
@@ -185,6 +187,7 @@ public:
 	inline void Clear()
 	{
 		for (int i = 0; i < Tcapacity; i++) m_slots[i].Clear();
+		m_num_items = 0;
 	}
 
 	/** const item search */
@@ -256,4 +259,158 @@ public:
 	}
 };
 
+/**
+ * class COpenHashTableT<Titem, Tinitial_bits> - hash table of pointers
+ *  to items allocated elsewhere, using open addressing.
+ *
+ *  Has the same interface and the same requirements on Titem and
+ *  Titem::Key as CHashTableT, except that the items do not need the
+ *  GetHashNext()/SetHashNext() link. The pointers are stored directly
+ *  in the slot array and collisions are resolved by linear probing, so
+ *  a lookup usually touches a single cache line. The table doubles its
+ *  capacity when it becomes half full, so it does not degrade when far
+ *  more items than 2^Tinitial_bits are stored.
+ */
+template <class Titem_, int Tinitial_bits_>
+class COpenHashTableT {
+public:
+	typedef Titem_ Titem;                         // make Titem_ visible from outside of class
+	typedef typename Titem_::Key Tkey;            // make Titem_::Key a property of HashTable
+
+protected:
+	std::vector<Titem_ *> m_slots; // the items, NULL for empty slots
+	int   m_hash_bits;             // log2 of the number of slots
+	int   m_num_items;             // item counter
+
+	/** return the slot an item with the given key would like to be in */
+	inline uint HomeSlot(const Tkey &key) const
+	{
+		/* Fibonacci hashing spreads consecutive hash values over the whole table. */
+		return (uint32)(key.CalcHash() * 0x9E3779B1U) >> (32 - m_hash_bits);
+	}
+
+	/** return the mask to wrap slot numbers around */
+	inline uint Mask() const
+	{
+		return (uint)m_slots.size() - 1;
+	}
+
+	/** return the slot holding the item with the given key, or the empty slot where it would be inserted */
+	inline uint FindSlot(const Tkey &key) const
+	{
+		uint mask = Mask();
+		uint i = HomeSlot(key);
+		while (m_slots[i] != NULL && !(m_slots[i]->GetKey() == key)) i = (i + 1) & mask;
+		return i;
+	}
+
+	/** double the number of slots and reinsert all items */
+	void Grow()
+	{
+		std::vector<Titem_ *> old_slots(m_slots.size() * 2, (Titem_ *)NULL);
+		old_slots.swap(m_slots);
+		m_hash_bits++;
+
+		uint mask = Mask();
+		for (typename std::vector<Titem_ *>::const_iterator it = old_slots.begin(); it != old_slots.end(); ++it) {
+			if (*it == NULL) continue;
+			uint i = HomeSlot((*it)->GetKey());
+			while (m_slots[i] != NULL) i = (i + 1) & mask;
+			m_slots[i] = *it;
+		}
+	}
+
+	/** empty the given slot and move following items of the same probe sequence back, so no search stops early */
+	void RemoveSlot(uint i)
+	{
+		uint mask = Mask();
+		for (uint j = (i + 1) & mask; m_slots[j] != NULL; j = (j + 1) & mask) {
+			uint home = HomeSlot(m_slots[j]->GetKey());
+			/* The item at j can fill the hole at i if its home slot is not within (i, j]. */
+			if (((j - home) & mask) >= ((j - i) & mask)) {
+				m_slots[i] = m_slots[j];
+				i = j;
+			}
+		}
+		m_slots[i] = NULL;
+		m_num_items--;
+	}
+
+public:
+	/* default constructor */
+	inline COpenHashTableT() : m_slots((size_t)1 << Tinitial_bits_, (Titem_ *)NULL), m_hash_bits(Tinitial_bits_), m_num_items(0)
+	{
+		assert_compile(Tinitial_bits_ > 0 && Tinitial_bits_ < 32);
+	}
+
+	/** item count */
+	inline int Count() const
+	{
+		return m_num_items;
+	}
+
+	/** simple clear - forget all items, but keep the capacity */
+	inline void Clear()
+	{
+		if (m_num_items == 0) return;
+		std::fill(m_slots.begin(), m_slots.end(), (Titem_ *)NULL);
+		m_num_items = 0;
+	}
+
+	/** const item search */
+	const Titem_ *Find(const Tkey &key) const
+	{
+		return m_slots[FindSlot(key)];
+	}
+
+	/** non-const item search */
+	Titem_ *Find(const Tkey &key)
+	{
+		return m_slots[FindSlot(key)];
+	}
+
+	/** non-const item search & optional removal (if found) */
+	Titem_ *TryPop(const Tkey &key)
+	{
+		uint i = FindSlot(key);
+		Titem_ *item = m_slots[i];
+		if (item != NULL) RemoveSlot(i);
+		return item;
+	}
+
+	/** non-const item search & removal */
+	Titem_& Pop(const Tkey &key)
+	{
+		Titem_ *item = TryPop(key);
+		assert(item != NULL);
+		return *item;
+	}
+
+	/** non-const item search & optional removal (if found) */
+	bool TryPop(Titem_ &item)
+	{
+		uint i = FindSlot(item.GetKey());
+		if (m_slots[i] != &item) return false;
+		RemoveSlot(i);
+		return true;
+	}
+
+	/** non-const item search & removal */
+	void Pop(Titem_ &item)
+	{
+		bool ret = TryPop(item);
+		assert(ret);
+	}
+
+	/** add one item - copy it from the given item */
+	void Push(Titem_ &new_item)
+	{
+		if ((uint)(m_num_items + 1) * 2 > m_slots.size()) Grow();
+		uint i = FindSlot(new_item.GetKey());
+		assert(m_slots[i] == NULL);
+		m_slots[i] = &new_item;
+		m_num_items++;
+	}
+};
+
 #endif /* HASHTABLE_HPP */
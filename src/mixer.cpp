@@ -11,15 +11,15 @@
 
 #include "stdafx.h"
 #include <math.h>
+#include <atomic>
 #include "core/math_func.hpp"
+#include "core/bitmath_func.hpp"
 #include "framerate_type.h"
 
 #include "safeguards.h"
 #include "mixer.h"
 
 struct MixerChannel {
-	bool active;
-
 	/* pointer to allocated buffer memory */
 	int8 *memory;
 
@@ -37,6 +37,13 @@ struct MixerChannel {
 };
 
 static MixerChannel _channels[8];
+/**
+ * Bit set of the channels in #_channels that are being mixed. The game thread
+ * sets a bit once the channel is set up; the audio callback clears it when the
+ * sound has ended. Neither thread has to wait for the other this way.
+ */
+static std::atomic<uint8> _active_channels(0);
+assert_compile(lengthof(_channels) <= 8);
 static uint32 _play_rate = 11025;
 static uint32 _max_size = UINT_MAX;
 static MxStreamCallback _music_stream = NULL;
@@ -74,7 +81,12 @@ static void mix_int16(MixerChannel *sc, int16 *buffer, uint samples)
 	int volume_left = sc->volume_left;
 	int volume_right = sc->volume_right;
 
-	if (frac_speed == 0x10000) {
+	if (volume_left == 0 && volume_right == 0) {
+		/* Nothing to hear, only advance the position. */
+		uint64 end_pos = frac_pos + (uint64)frac_speed * samples;
+		b += end_pos >> 16;
+		frac_pos = end_pos & 0xffff;
+	} else if (frac_speed == 0x10000) {
 		/* Special case when frac_speed is 0x10000 */
 		do {
 			buffer[0] = Clamp(buffer[0] + (*b * volume_left  >> 16), -MAX_VOLUME, MAX_VOLUME);
@@ -110,7 +122,12 @@ static void mix_int8_to_int16(MixerChannel *sc, int16 *buffer, uint samples)
 	int volume_left = sc->volume_left;
 	int volume_right = sc->volume_right;
 
-	if (frac_speed == 0x10000) {
+	if (volume_left == 0 && volume_right == 0) {
+		/* Nothing to hear, only advance the position. */
+		uint64 end_pos = frac_pos + (uint64)frac_speed * samples;
+		b += end_pos >> 16;
+		frac_pos = end_pos & 0xffff;
+	} else if (frac_speed == 0x10000) {
 		/* Special case when frac_speed is 0x10000 */
 		do {
 			buffer[0] = Clamp(buffer[0] + (*b * volume_left  >> 8), -MAX_VOLUME, MAX_VOLUME);
@@ -134,9 +151,9 @@ static void mix_int8_to_int16(MixerChannel *sc, int16 *buffer, uint samples)
 	sc->pos = b - sc->memory;
 }
 
-static void MxCloseChannel(MixerChannel *mc)
+static void MxCloseChannel(uint8 idx)
 {
-	mc->active = false;
+	_active_channels.fetch_and(~(1 << idx), std::memory_order_release);
 }
 
 void MxMixSamples(void *buffer, uint samples)
@@ -148,8 +165,6 @@ void MxMixSamples(void *buffer, uint samples)
 		last_samples = samples;
 	}
 
-	MixerChannel *mc;
-
 	/* Clear the buffer */
 	memset(buffer, 0, sizeof(int16) * 2 * samples);
 
@@ -157,29 +172,28 @@ void MxMixSamples(void *buffer, uint samples)
 	if (_music_stream) _music_stream((int16*)buffer, samples);
 
 	/* Mix each channel */
-	for (mc = _channels; mc != endof(_channels); mc++) {
-		if (mc->active) {
-			if (mc->is16bit) {
-				mix_int16(mc, (int16*)buffer, samples);
-			} else {
-				mix_int8_to_int16(mc, (int16*)buffer, samples);
-			}
-			if (mc->samples_left == 0) MxCloseChannel(mc);
+	uint8 active = _active_channels.load(std::memory_order_acquire);
+	uint idx;
+	FOR_EACH_SET_BIT(idx, active) {
+		MixerChannel *mc = &_channels[idx];
+		if (mc->is16bit) {
+			mix_int16(mc, (int16*)buffer, samples);
+		} else {
+			mix_int8_to_int16(mc, (int16*)buffer, samples);
 		}
+		if (mc->samples_left == 0) MxCloseChannel(idx);
 	}
 }
 
 MixerChannel *MxAllocateChannel()
 {
-	MixerChannel *mc;
-	for (mc = _channels; mc != endof(_channels); mc++) {
-		if (!mc->active) {
-			free(mc->memory);
-			mc->memory = NULL;
-			return mc;
-		}
-	}
-	return NULL;
+	uint8 available = ~_active_channels.load(std::memory_order_acquire) & (uint8)((1 << lengthof(_channels)) - 1);
+	if (available == 0) return NULL;
+
+	MixerChannel *mc = &_channels[FindFirstBit(available)];
+	free(mc->memory);
+	mc->memory = NULL;
+	return mc;
 }
 
 void MxSetChannelRawSrc(MixerChannel *mc, int8 *mem, size_t size, uint rate, bool is16bit)
@@ -219,7 +233,7 @@ void MxSetChannelVolume(MixerChannel *mc, uint volume, float pan)
 
 void MxActivateChannel(MixerChannel *mc)
 {
-	mc->active = true;
+	_active_channels.fetch_or(1 << (mc - _channels), std::memory_order_release);
 }
 
 /**
@@ -14,7 +14,11 @@
 #ifdef ENABLE_NETWORK
 
 #include "address.h"
+#include "poll.h"
 #include "../../debug.h"
+#include "../../core/math_func.hpp"
+#include <vector>
+#include <chrono>
 
 #include "../../safeguards.h"
 
@@ -213,15 +217,14 @@ bool NetworkAddress::IsInNetmask(char *netmask)
 }
 
 /**
- * Resolve this address into a socket
+ * Look up the address information of this address.
  * @param family the type of 'protocol' (IPv4, IPv6)
  * @param socktype the type of socket (TCP, UDP, etc)
  * @param flags the flags to send to getaddrinfo
- * @param sockets the list of sockets to add the sockets to
- * @param func the inner working while looping over the address info
- * @return the resolved socket or INVALID_SOCKET.
+ * @param log_failure whether to log when the lookup fails
+ * @return the list of address information, to be freed with freeaddrinfo(), or NULL.
  */
-SOCKET NetworkAddress::Resolve(int family, int socktype, int flags, SocketList *sockets, LoopProc func)
+addrinfo *NetworkAddress::GetAddressInfo(int family, int socktype, int flags, bool log_failure)
 {
 	struct addrinfo *ai;
 	struct addrinfo hints;
@@ -250,13 +253,30 @@ SOCKET NetworkAddress::Resolve(int family, int socktype, int flags, SocketList *
 	if (reset_hostname) strecpy(this->hostname, "", lastof(this->hostname));
 
 	if (e != 0) {
-		if (func != ResolveLoopProc) {
+		if (log_failure) {
 			DEBUG(net, 0, "getaddrinfo for hostname \"%s\", port %s, address family %s and socket type %s failed: %s",
 				this->hostname, port_name, AddressFamilyAsString(family), SocketTypeAsString(socktype), FS2OTTD(gai_strerror(e)));
 		}
-		return INVALID_SOCKET;
+		return NULL;
 	}
 
+	return ai;
+}
+
+/**
+ * Resolve this address into a socket
+ * @param family the type of 'protocol' (IPv4, IPv6)
+ * @param socktype the type of socket (TCP, UDP, etc)
+ * @param flags the flags to send to getaddrinfo
+ * @param sockets the list of sockets to add the sockets to
+ * @param func the inner working while looping over the address info
+ * @return the resolved socket or INVALID_SOCKET.
+ */
+SOCKET NetworkAddress::Resolve(int family, int socktype, int flags, SocketList *sockets, LoopProc func)
+{
+	struct addrinfo *ai = this->GetAddressInfo(family, socktype, flags, func != ResolveLoopProc);
+	if (ai == NULL) return INVALID_SOCKET;
+
 	SOCKET sock = INVALID_SOCKET;
 	for (struct addrinfo *runp = ai; runp != NULL; runp = runp->ai_next) {
 		/* When we are binding to multiple sockets, make sure we do not
@@ -285,16 +305,23 @@ SOCKET NetworkAddress::Resolve(int family, int socktype, int flags, SocketList *
 	return sock;
 }
 
+/** Milliseconds to wait for a connection attempt before also trying the next address. */
+static const int CONNECTION_ATTEMPT_DELAY = 250;
+/** Milliseconds to wait for any of the connection attempts to succeed. */
+static const int CONNECT_TIMEOUT = 30000;
+
 /**
- * Helper function to resolve a connected socket.
- * @param runp information about the socket to try not
- * @return the opened socket or INVALID_SOCKET
+ * Start connecting a non-blocking socket to an address.
+ * @param runp information about the address to connect to
+ * @param[out] connected whether the connection was made right away
+ * @return the connecting socket or INVALID_SOCKET
  */
-static SOCKET ConnectLoopProc(addrinfo *runp)
+static SOCKET StartConnect(addrinfo *runp, bool *connected)
 {
 	const char *type = NetworkAddress::SocketTypeAsString(runp->ai_socktype);
 	const char *family = NetworkAddress::AddressFamilyAsString(runp->ai_family);
-	const char *address = NetworkAddress(runp->ai_addr, (int)runp->ai_addrlen).GetAddressAsString();
+
+	*connected = false;
 
 	SOCKET sock = socket(runp->ai_family, runp->ai_socktype, runp->ai_protocol);
 	if (sock == INVALID_SOCKET) {
@@ -303,18 +330,96 @@ static SOCKET ConnectLoopProc(addrinfo *runp)
 	}
 
 	if (!SetNoDelay(sock)) DEBUG(net, 1, "[%s] setting TCP_NODELAY failed", type);
+	if (!SetNonBlocking(sock)) DEBUG(net, 0, "[%s] setting non-blocking mode failed", type);
 
-	if (connect(sock, runp->ai_addr, (int)runp->ai_addrlen) != 0) {
-		DEBUG(net, 1, "[%s] could not connect %s socket: %s", type, family, strerror(errno));
-		closesocket(sock);
-		return INVALID_SOCKET;
+	*connected = connect(sock, runp->ai_addr, (int)runp->ai_addrlen) == 0;
+	if (!*connected) {
+		int err = GET_LAST_ERROR();
+		if (err != EINPROGRESS && err != EWOULDBLOCK) {
+			DEBUG(net, 1, "[%s] could not connect %s socket: %s", type, family, strerror(err));
+			closesocket(sock);
+			return INVALID_SOCKET;
+		}
 	}
 
-	/* Connection succeeded */
-	if (!SetNonBlocking(sock)) DEBUG(net, 0, "[%s] setting non-blocking mode failed", type);
+	return sock;
+}
 
-	DEBUG(net, 1, "[%s] connected to %s", type, address);
+/**
+ * Connect to one of the addresses the "happy eyeballs" way (RFC 8305):
+ * the address families take turns, and when an attempt does not succeed
+ * quickly the next address is tried while waiting for the earlier ones.
+ * So a broken IPv6 route does not hold up connecting over IPv4.
+ * @param ai the addresses to connect to
+ * @param[out] winner the address the connection was made to
+ * @return the connected socket or INVALID_SOCKET
+ */
+static SOCKET ConnectHappyEyeballs(addrinfo *ai, addrinfo **winner)
+{
+	/* Order the addresses so the families alternate, starting with the preferred first one. */
+	std::vector<addrinfo *> first, other;
+	for (addrinfo *runp = ai; runp != NULL; runp = runp->ai_next) {
+		(runp->ai_family == ai->ai_family ? first : other).push_back(runp);
+	}
+	std::vector<addrinfo *> order;
+	for (size_t i = 0; i < max(first.size(), other.size()); i++) {
+		if (i < first.size()) order.push_back(first[i]);
+		if (i < other.size()) order.push_back(other[i]);
+	}
 
+	std::vector<std::pair<SOCKET, addrinfo *> > attempts;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	SOCKET sock = INVALID_SOCKET;
+	size_t next = 0;
+
+	while (sock == INVALID_SOCKET) {
+		if (next < order.size()) {
+			bool connected;
+			SOCKET s = StartConnect(order[next], &connected);
+			if (connected) {
+				sock = s;
+				*winner = order[next];
+				break;
+			}
+			if (s != INVALID_SOCKET) attempts.push_back(std::make_pair(s, order[next]));
+			next++;
+		}
+
+		if (attempts.empty()) {
+			if (next == order.size()) break;
+			continue;
+		}
+
+		int elapsed = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		if (elapsed >= CONNECT_TIMEOUT) break;
+
+		SocketPoller poller;
+		for (size_t i = 0; i < attempts.size(); i++) poller.Add(attempts[i].first, false, true);
+		int timeout = CONNECT_TIMEOUT - elapsed;
+		if (next < order.size()) timeout = min(timeout, CONNECTION_ATTEMPT_DELAY);
+		if (poller.Poll(timeout) < 0) break;
+
+		/* Go backwards, so erasing an attempt does not change the index of the ones still to check. */
+		for (size_t i = attempts.size(); i-- > 0; ) {
+			if (!poller.IsWritable((uint)i)) continue;
+
+			int err = 0;
+			socklen_t len = sizeof(err);
+			if (getsockopt(attempts[i].first, SOL_SOCKET, SO_ERROR, (char *)&err, &len) != 0) err = GET_LAST_ERROR();
+			if (err == 0) {
+				sock = attempts[i].first;
+				*winner = attempts[i].second;
+			} else {
+				DEBUG(net, 1, "[%s] could not connect %s socket: %s", NetworkAddress::SocketTypeAsString(attempts[i].second->ai_socktype),
+						NetworkAddress::AddressFamilyAsString(attempts[i].second->ai_family), strerror(err));
+				closesocket(attempts[i].first);
+			}
+			attempts.erase(attempts.begin() + i);
+			if (sock != INVALID_SOCKET) break;
+		}
+	}
+
+	for (size_t i = 0; i < attempts.size(); i++) closesocket(attempts[i].first);
 	return sock;
 }
 
@@ -326,7 +431,21 @@ SOCKET NetworkAddress::Connect()
 {
 	DEBUG(net, 1, "Connecting to %s", this->GetAddressAsString());
 
-	return this->Resolve(AF_UNSPEC, SOCK_STREAM, AI_ADDRCONFIG, NULL, ConnectLoopProc);
+	addrinfo *ai = this->GetAddressInfo(AF_UNSPEC, SOCK_STREAM, AI_ADDRCONFIG, true);
+	if (ai == NULL) return INVALID_SOCKET;
+
+	addrinfo *winner = NULL;
+	SOCKET sock = ConnectHappyEyeballs(ai, &winner);
+	if (sock != INVALID_SOCKET) {
+		this->address_length = (int)winner->ai_addrlen;
+		assert(sizeof(this->address) >= winner->ai_addrlen);
+		memcpy(&this->address, winner->ai_addr, winner->ai_addrlen);
+
+		DEBUG(net, 1, "[%s] connected to %s", SocketTypeAsString(winner->ai_socktype), NetworkAddress(winner->ai_addr, (int)winner->ai_addrlen).GetAddressAsString());
+	}
+	freeaddrinfo(ai);
+
+	return sock;
 }
 
 /**
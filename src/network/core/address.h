@@ -42,6 +42,7 @@ private:
 	 */
 	typedef SOCKET (*LoopProc)(addrinfo *runp);
 
+	addrinfo *GetAddressInfo(int family, int socktype, int flags, bool log_failure);
 	SOCKET Resolve(int family, int socktype, int flags, SocketList *sockets, LoopProc func);
 public:
 	/**
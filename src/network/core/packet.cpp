@@ -15,11 +15,67 @@
 
 #include "../../stdafx.h"
 #include "../../string_func.h"
+#include "../../debug.h"
+#include "../../thread/thread.h"
 
 #include "packet.h"
 
 #include "../../safeguards.h"
 
+/** Maximum number of freed packet buffers kept for reuse. */
+static const uint PACKET_BUFFER_POOL_SIZE = 1024;
+
+/** Freed packet buffers; the first bytes of each buffer point to the next one. */
+static byte *_packet_buffer_pool = NULL;
+static uint _packet_buffer_pool_count = 0;     ///< Number of buffers in #_packet_buffer_pool.
+static uint _packet_buffers_allocated = 0;     ///< Number of buffers allocated since the last stats.
+static uint _packet_buffers_reused = 0;        ///< Number of buffers taken from the pool since the last stats.
+/** Packets are also made by the thread saving the map for clients joining. */
+static ThreadMutex *_packet_buffer_mutex = ThreadMutex::New();
+
+/**
+ * Get a buffer for a packet, from the pool of freed buffers when possible.
+ * @return Buffer of SEND_MTU bytes.
+ */
+static byte *AllocatePacketBuffer()
+{
+	ThreadMutexLocker lock(_packet_buffer_mutex);
+	byte *buffer = _packet_buffer_pool;
+	if (buffer == NULL) {
+		_packet_buffers_allocated++;
+		return MallocT<byte>(SEND_MTU);
+	}
+	_packet_buffer_pool = *(byte **)buffer;
+	_packet_buffer_pool_count--;
+	_packet_buffers_reused++;
+	return buffer;
+}
+
+/**
+ * Return the buffer of a packet to the pool, or free it when the pool is full.
+ * @param buffer The buffer of SEND_MTU bytes.
+ */
+static void FreePacketBuffer(byte *buffer)
+{
+	ThreadMutexLocker lock(_packet_buffer_mutex);
+	if (_packet_buffer_pool_count >= PACKET_BUFFER_POOL_SIZE) {
+		free(buffer);
+		return;
+	}
+	*(byte **)buffer = _packet_buffer_pool;
+	_packet_buffer_pool = buffer;
+	_packet_buffer_pool_count++;
+}
+
+/** Show how well the packet buffer pool works, and start counting anew. */
+void DebugPacketBufferPoolStats()
+{
+	ThreadMutexLocker lock(_packet_buffer_mutex);
+	DEBUG(net, 3, "Packet buffers: %u allocated, %u reused, %u pooled", _packet_buffers_allocated, _packet_buffers_reused, _packet_buffer_pool_count);
+	_packet_buffers_allocated = 0;
+	_packet_buffers_reused = 0;
+}
+
 /**
  * Create a packet that is used to read from a network socket
  * @param cs the socket handler associated with the socket we are reading from
@@ -32,7 +88,7 @@ Packet::Packet(NetworkSocketHandler *cs)
 	this->next   = NULL;
 	this->pos    = 0; // We start reading from here
 	this->size   = 0;
-	this->buffer = MallocT<byte>(SEND_MTU);
+	this->buffer = AllocatePacketBuffer();
 }
 
 /**
@@ -47,7 +103,7 @@ Packet::Packet(PacketType type)
 	/* Skip the size so we can write that in before sending the packet */
 	this->pos                  = 0;
 	this->size                 = sizeof(PacketSize);
-	this->buffer               = MallocT<byte>(SEND_MTU);
+	this->buffer               = AllocatePacketBuffer();
 	this->buffer[this->size++] = type;
 }
 
@@ -56,7 +112,7 @@ Packet::Packet(PacketType type)
  */
 Packet::~Packet()
 {
-	free(this->buffer);
+	FreePacketBuffer(this->buffer);
 }
 
 /**
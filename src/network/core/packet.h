@@ -87,6 +87,8 @@ public:
 	void   Recv_string(char *buffer, size_t size, StringValidationSettings settings = SVS_REPLACE_WITH_QUESTION_MARK);
 };
 
+void DebugPacketBufferPoolStats();
+
 #endif /* ENABLE_NETWORK */
 
 #endif /* NETWORK_CORE_PACKET_H */
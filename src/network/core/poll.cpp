@@ -0,0 +1,127 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file poll.cpp Checking many sockets at once for being readable or writable.
+ */
+
+#ifdef ENABLE_NETWORK
+
+#include "../../stdafx.h"
+#include "../../core/math_func.hpp"
+
+#include "poll.h"
+
+#include "../../safeguards.h"
+
+/** Remove all sockets from the set. */
+void SocketPoller::Clear()
+{
+#ifdef NETWORK_HAVE_POLL
+	this->fds.clear();
+#else
+	this->sockets.clear();
+	FD_ZERO(&this->read_fd);
+	FD_ZERO(&this->write_fd);
+	FD_ZERO(&this->error_fd);
+	this->max_sock = 0;
+#endif
+}
+
+/**
+ * Add a socket to the set.
+ * @param s     The socket to add.
+ * @param read  Whether to check the socket for being readable.
+ * @param write Whether to check the socket for being writable.
+ * @return The index to query the state of the socket with.
+ */
+uint SocketPoller::Add(SOCKET s, bool read, bool write)
+{
+#ifdef NETWORK_HAVE_POLL
+	pollfd pfd;
+	pfd.fd = s;
+	pfd.events = (read ? POLLIN : 0) | (write ? POLLOUT : 0);
+	pfd.revents = 0;
+	this->fds.push_back(pfd);
+	return (uint)this->fds.size() - 1;
+#else
+	if (read) FD_SET(s, &this->read_fd);
+	if (write) {
+		FD_SET(s, &this->write_fd);
+		/* Windows reports failed connection attempts only as exception. */
+		FD_SET(s, &this->error_fd);
+	}
+	this->max_sock = max(this->max_sock, s);
+	this->sockets.push_back(s);
+	return (uint)this->sockets.size() - 1;
+#endif
+}
+
+/**
+ * Check the sockets in the set for their state.
+ * @param timeout_ms Number of milliseconds to wait at most for any socket to become ready; 0 to not block at all.
+ * @return The number of ready sockets, or -1 on error. On error no socket is reported as ready.
+ */
+int SocketPoller::Poll(int timeout_ms)
+{
+#ifdef NETWORK_HAVE_POLL
+	if (this->fds.empty()) return 0;
+
+	int n = poll(&this->fds[0], this->fds.size(), timeout_ms);
+	if (n < 0) {
+		for (std::vector<pollfd>::iterator it = this->fds.begin(); it != this->fds.end(); it++) it->revents = 0;
+	}
+	return n;
+#else
+	struct timeval tv;
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+	int n = select(this->max_sock + 1, &this->read_fd, &this->write_fd, &this->error_fd, &tv);
+	if (n < 0) {
+		FD_ZERO(&this->read_fd);
+		FD_ZERO(&this->write_fd);
+		FD_ZERO(&this->error_fd);
+	}
+	return n;
+#endif
+}
+
+/**
+ * Check whether a socket was found to be readable by the last #Poll.
+ * Errors and hang-ups count as readable, so the receiving code notices them.
+ * @param index The index the socket got when it was added.
+ * @return True if something can be received.
+ */
+bool SocketPoller::IsReadable(uint index) const
+{
+#ifdef NETWORK_HAVE_POLL
+	return (this->fds[index].revents & (POLLIN | POLLERR | POLLHUP)) != 0;
+#else
+	return FD_ISSET(this->sockets[index], &this->read_fd) != 0;
+#endif
+}
+
+/**
+ * Check whether a socket was found to be writable by the last #Poll.
+ * Errors count as writable, so the sending code or the code waiting for
+ * connection attempts notices them.
+ * @param index The index the socket got when it was added.
+ * @return True if something can be sent.
+ */
+bool SocketPoller::IsWritable(uint index) const
+{
+#ifdef NETWORK_HAVE_POLL
+	return (this->fds[index].revents & (POLLOUT | POLLERR | POLLHUP)) != 0;
+#else
+	return FD_ISSET(this->sockets[index], &this->write_fd) != 0 || FD_ISSET(this->sockets[index], &this->error_fd) != 0;
+#endif
+}
+
+#endif /* ENABLE_NETWORK */
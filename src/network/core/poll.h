@@ -0,0 +1,67 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file poll.h Checking many sockets at once for being readable or writable.
+ */
+
+#ifndef NETWORK_CORE_POLL_H
+#define NETWORK_CORE_POLL_H
+
+#include "os_abstraction.h"
+
+#ifdef ENABLE_NETWORK
+
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__OS2__)
+/** poll() is available; it has no limit on the number or value of the sockets. */
+#	define NETWORK_HAVE_POLL
+#	include <poll.h>
+#endif
+
+/**
+ * A set of sockets that is checked for being readable and/or writable with
+ * one system call. Where available poll() is used, otherwise select(). The
+ * sockets are referred to by the index they got when they were added.
+ */
+class SocketPoller {
+#ifdef NETWORK_HAVE_POLL
+	std::vector<pollfd> fds;     ///< The sockets and the events we wait for/got.
+#else
+	std::vector<SOCKET> sockets; ///< The sockets in the set.
+	fd_set read_fd;              ///< Sockets checked for/found being readable.
+	fd_set write_fd;             ///< Sockets checked for/found being writable.
+	fd_set error_fd;             ///< Sockets checked for writing, that were found to have an error.
+	SOCKET max_sock;             ///< Highest socket in the set.
+#endif
+
+public:
+	SocketPoller() { this->Clear(); }
+
+	void Clear();
+	uint Add(SOCKET s, bool read, bool write);
+	int Poll(int timeout_ms);
+	bool IsReadable(uint index) const;
+	bool IsWritable(uint index) const;
+
+	/**
+	 * Get the number of sockets in the set.
+	 * @return The number of sockets.
+	 */
+#ifdef NETWORK_HAVE_POLL
+	inline uint Length() const { return (uint)this->fds.size(); }
+#else
+	inline uint Length() const { return (uint)this->sockets.size(); }
+#endif
+};
+
+#endif /* ENABLE_NETWORK */
+
+#endif /* NETWORK_CORE_POLL_H */
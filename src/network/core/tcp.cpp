@@ -15,8 +15,14 @@
 
 #include "../../stdafx.h"
 #include "../../debug.h"
+#include "../../core/mem_func.hpp"
 
 #include "tcp.h"
+#include "poll.h"
+
+#if !defined(_WIN32) && !defined(__OS2__)
+#	include <sys/uio.h>
+#endif
 
 #include "../../safeguards.h"
 
@@ -26,8 +32,8 @@
  */
 NetworkTCPSocketHandler::NetworkTCPSocketHandler(SOCKET s) :
 		NetworkSocketHandler(),
-		packet_queue(NULL), packet_recv(NULL),
-		sock(s), writable(false)
+		packet_queue(NULL), packet_queue_end(NULL), packet_recv(NULL),
+		sock(s), writable(false), readable(false)
 {
 }
 
@@ -42,6 +48,7 @@ NetworkTCPSocketHandler::~NetworkTCPSocketHandler()
 NetworkRecvStatus NetworkTCPSocketHandler::CloseConnection(bool error)
 {
 	this->writable = false;
+	this->readable = false;
 	NetworkSocketHandler::CloseConnection(error);
 
 	/* Free all pending and partially received packets */
@@ -50,6 +57,7 @@ NetworkRecvStatus NetworkTCPSocketHandler::CloseConnection(bool error)
 		delete this->packet_queue;
 		this->packet_queue = p;
 	}
+	this->packet_queue_end = NULL;
 	delete this->packet_recv;
 	this->packet_recv = NULL;
 
@@ -64,26 +72,72 @@ NetworkRecvStatus NetworkTCPSocketHandler::CloseConnection(bool error)
  */
 void NetworkTCPSocketHandler::SendPacket(Packet *packet)
 {
-	Packet *p;
 	assert(packet != NULL);
 
 	packet->PrepareToSend();
 
-	/* Reallocate the packet as in 99+% of the times we send at most 25 bytes and
-	 * keeping the other 1400+ bytes wastes memory, especially when someone tries
-	 * to do a denial of service attack! */
-	packet->buffer = ReallocT(packet->buffer, packet->size);
+	/* The buffer is not shrunk to the size of the packet; it goes back to the
+	 * pool of packet buffers, which hands out SEND_MTU bytes, once it is sent. */
 
-	/* Locate last packet buffered for the client */
-	p = this->packet_queue;
-	if (p == NULL) {
+	if (this->packet_queue == NULL) {
 		/* No packets yet */
 		this->packet_queue = packet;
 	} else {
-		/* Skip to the last packet */
-		while (p->next != NULL) p = p->next;
-		p->next = packet;
+		this->packet_queue_end->next = packet;
 	}
+	this->packet_queue_end = packet;
+}
+
+/**
+ * Hand the first #SEND_BATCH_PACKETS packets of a queue to the OS with a
+ * single system call, without copying them into one buffer first.
+ * @param sock The socket to send the packets with.
+ * @param p The first packet to send.
+ * @param[out] length The number of bytes offered to the OS.
+ * @return The number of bytes sent, or -1 on error.
+ */
+static ssize_t SendQueue(SOCKET sock, const Packet *p, size_t &length)
+{
+	length = 0;
+	uint count = 0;
+
+#if defined(_WIN32)
+	WSABUF bufs[SEND_BATCH_PACKETS];
+	for (; p != NULL && count < SEND_BATCH_PACKETS; p = p->next, count++) {
+		bufs[count].buf = (char *)p->buffer + p->pos;
+		bufs[count].len = p->size - p->pos;
+		length += bufs[count].len;
+	}
+	assert(length > 0);
+
+	DWORD sent;
+	if (WSASend(sock, bufs, count, &sent, 0, NULL, NULL) != 0) return -1;
+	return sent;
+#elif !defined(__OS2__)
+	struct iovec iov[SEND_BATCH_PACKETS];
+	for (; p != NULL && count < SEND_BATCH_PACKETS; p = p->next, count++) {
+		iov[count].iov_base = p->buffer + p->pos;
+		iov[count].iov_len = p->size - p->pos;
+		length += iov[count].iov_len;
+	}
+	assert(length > 0);
+
+	struct msghdr msg;
+	MemSetT(&msg, 0);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = count;
+	return sendmsg(sock, &msg, 0);
+#else
+	/* No scatter/gather sending; copy the packets into one buffer instead. */
+	static byte buffer[SEND_BATCH_PACKETS * SEND_MTU];
+	for (; p != NULL && count < SEND_BATCH_PACKETS; p = p->next, count++) {
+		MemCpyT(buffer + length, p->buffer + p->pos, p->size - p->pos);
+		length += p->size - p->pos;
+	}
+	assert(length > 0);
+
+	return send(sock, (const char*)buffer, length, 0);
+#endif
 }
 
 /**
@@ -107,7 +161,8 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 
 	p = this->packet_queue;
 	while (p != NULL) {
-		res = send(this->sock, (const char*)p->buffer + p->pos, p->size - p->pos, 0);
+		size_t length;
+		res = SendQueue(this->sock, p, length);
 		if (res == -1) {
 			int err = GET_LAST_ERROR();
 			if (err != EWOULDBLOCK) {
@@ -126,17 +181,20 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 			return SPS_CLOSED;
 		}
 
-		p->pos += res;
-
-		/* Is this packet sent? */
-		if (p->pos == p->size) {
-			/* Go to the next packet */
+		/* Go past the packets that were sent. */
+		for (size_t sent = res; sent > 0;) {
+			if (sent < (size_t)(p->size - p->pos)) {
+				p->pos += sent;
+				break;
+			}
+			sent -= p->size - p->pos;
 			this->packet_queue = p->next;
 			delete p;
 			p = this->packet_queue;
-		} else {
-			return SPS_PARTLY_SENT;
 		}
+		if (p == NULL) this->packet_queue_end = NULL;
+
+		if ((size_t)res < length) return SPS_PARTLY_SENT;
 	}
 
 	return SPS_ALL_SENT;
@@ -228,20 +286,13 @@ Packet *NetworkTCPSocketHandler::ReceivePacket()
  */
 bool NetworkTCPSocketHandler::CanSendReceive()
 {
-	fd_set read_fd, write_fd;
-	struct timeval tv;
-
-	FD_ZERO(&read_fd);
-	FD_ZERO(&write_fd);
-
-	FD_SET(this->sock, &read_fd);
-	FD_SET(this->sock, &write_fd);
+	SocketPoller poller;
+	poller.Add(this->sock, true, true);
 
-	tv.tv_sec = tv.tv_usec = 0; // don't block at all.
-	if (select(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv) < 0) return false;
+	if (poller.Poll(0) < 0) return false; // don't block at all.
 
-	this->writable = !!FD_ISSET(this->sock, &write_fd);
-	return FD_ISSET(this->sock, &read_fd) != 0;
+	this->writable = poller.IsWritable(0);
+	return poller.IsReadable(0);
 }
 
 #endif /* ENABLE_NETWORK */
@@ -27,14 +27,19 @@ enum SendPacketsState {
 	SPS_ALL_SENT,    ///< All packets in the queue are sent.
 };
 
+/** Maximum number of queued packets handed to the OS at once. */
+static const uint SEND_BATCH_PACKETS = 64;
+
 /** Base socket handler for all TCP sockets */
 class NetworkTCPSocketHandler : public NetworkSocketHandler {
 private:
 	Packet *packet_queue;     ///< Packets that are awaiting delivery
+	Packet *packet_queue_end; ///< Last packet awaiting delivery, to append to
 	Packet *packet_recv;      ///< Partially received packet
 public:
 	SOCKET sock;              ///< The socket currently connected to
 	bool writable;            ///< Can we write to this socket?
+	bool readable;            ///< Is there something to receive, according to the last check of the listen handler?
 
 	/**
 	 * Whether this socket is currently bound to a socket.
@@ -65,7 +70,6 @@ public:
  */
 class TCPConnecter {
 private:
-	class ThreadObject *thread; ///< Thread used to create the TCP connection
 	bool connected;             ///< Whether we succeeded in making the connection
 	bool aborted;               ///< Whether we bailed out (i.e. connection making failed)
 	bool killed;                ///< Whether we got killed
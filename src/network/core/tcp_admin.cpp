@@ -94,6 +94,9 @@ NetworkRecvStatus NetworkAdminSocketHandler::HandlePacket(Packet *p)
 		case ADMIN_PACKET_SERVER_CMD_LOGGING:     return this->Receive_SERVER_CMD_LOGGING(p);
 		case ADMIN_PACKET_SERVER_RCON_END:        return this->Receive_SERVER_RCON_END(p);
 		case ADMIN_PACKET_SERVER_PONG:            return this->Receive_SERVER_PONG(p);
+		case ADMIN_PACKET_SERVER_PATHFINDER_STATS: return this->Receive_SERVER_PATHFINDER_STATS(p);
+		case ADMIN_PACKET_SERVER_PERFORMANCE:     return this->Receive_SERVER_PERFORMANCE(p);
+		case ADMIN_PACKET_SERVER_VEHICLE_TICK_STATS: return this->Receive_SERVER_VEHICLE_TICK_STATS(p);
 
 		default:
 			if (this->HasClientQuit()) {
@@ -172,5 +175,8 @@ NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_CMD_NAMES(Packet *p)
 NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_CMD_LOGGING(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_CMD_LOGGING); }
 NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_RCON_END(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_RCON_END); }
 NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_PONG(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_PONG); }
+NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_PATHFINDER_STATS(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_PATHFINDER_STATS); }
+NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_PERFORMANCE(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_PERFORMANCE); }
+NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_VEHICLE_TICK_STATS(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_VEHICLE_TICK_STATS); }
 
 #endif /* ENABLE_NETWORK */
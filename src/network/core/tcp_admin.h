@@ -63,6 +63,9 @@ enum PacketAdminType {
 	ADMIN_PACKET_SERVER_GAMESCRIPT,      ///< The server gives the admin information from the GameScript in JSON.
 	ADMIN_PACKET_SERVER_RCON_END,        ///< The server indicates that the remote console command has completed.
 	ADMIN_PACKET_SERVER_PONG,            ///< The server replies to a ping request from the admin.
+	ADMIN_PACKET_SERVER_PATHFINDER_STATS, ///< The server gives the admin statistics about the pathfinder calls of a company.
+	ADMIN_PACKET_SERVER_PERFORMANCE,     ///< The server gives the admin a snapshot of its performance.
+	ADMIN_PACKET_SERVER_VEHICLE_TICK_STATS, ///< The server gives the admin the time spent ticking the vehicles of a company.
 
 	INVALID_ADMIN_PACKET = 0xFF,         ///< An invalid marker for admin packets.
 };
@@ -86,6 +89,9 @@ enum AdminUpdateType {
 	ADMIN_UPDATE_CMD_NAMES,       ///< The admin would like a list of all DoCommand names.
 	ADMIN_UPDATE_CMD_LOGGING,     ///< The admin would like to have DoCommand information.
 	ADMIN_UPDATE_GAMESCRIPT,      ///< The admin would like to have gamescript messages.
+	ADMIN_UPDATE_PATHFINDER_STATS, ///< Updates about the pathfinder calls of companies.
+	ADMIN_UPDATE_PERFORMANCE,     ///< Updates about the performance of the server.
+	ADMIN_UPDATE_VEHICLE_TICK_STATS, ///< Updates about the time spent ticking the vehicles of companies.
 	ADMIN_UPDATE_END,             ///< Must ALWAYS be on the end of this list!! (period)
 };
 
@@ -473,6 +479,61 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_PONG(Packet *p);
 
+	/**
+	 * Statistics about the pathfinder calls for one company and vehicle type,
+	 * since the start of the game or the last 'pf_stats reset':
+	 * uint8   ID of the company, or #OWNER_NONE for calls not made for a company.
+	 * uint8   Vehicle type (see #VehicleType).
+	 * uint32  Number of calls.
+	 * uint32  Number of calls that found a path.
+	 * uint64  Total number of nodes expanded.
+	 * uint64  Total number of segment costs taken from the cache.
+	 * uint64  Total number of segment costs calculated.
+	 * uint64  Total wall time in microseconds.
+	 * uint8   Number of histogram buckets (N).
+	 * N * uint32  Calls by nodes expanded: 0, below 2, below 4, ..., the last bucket counting everything above.
+	 * N * uint32  Calls by wall time in microseconds, using the same buckets.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_PATHFINDER_STATS(Packet *p);
+
+	/**
+	 * A snapshot of the performance of the server, all in one packet:
+	 * uint8   Number of performance elements (N), in the order of #PerformanceElement.
+	 * N * (
+	 *   uint32  Current rate, in cycles per thousand seconds.
+	 *   uint32  Average processing time of the last 8 cycles, in microseconds.
+	 *   uint32  Average processing time of all recorded cycles, in microseconds.
+	 * )           Elements without measurements have all values 0.
+	 * uint8   Number of vehicle types (M), in the order of #VehicleType.
+	 * M * uint32  Number of primary vehicles of the type.
+	 * uint32  Number of link graph jobs running.
+	 * uint32  Number of link graph jobs joined since the game started.
+	 * uint64  Total number of nodes of those jobs.
+	 * uint64  Total wall time of running those jobs, in microseconds.
+	 * uint32  Longest wall time of running one of those jobs, in microseconds.
+	 * uint32  Number of those jobs that were not finished when they were joined.
+	 * uint64  Total time the game waited for those unfinished jobs, in microseconds.
+	 * uint32  Longest time the game waited for one job, in microseconds.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_PERFORMANCE(Packet *p);
+
+	/**
+	 * The time spent ticking the primary vehicles of one company and vehicle type,
+	 * since the start of the game or the last 'tick_stats reset':
+	 * uint8   ID of the company, or #OWNER_NONE for vehicles not owned by a company.
+	 * uint8   Vehicle type (see #VehicleType).
+	 * uint64  Number of vehicle ticks.
+	 * uint64  Total wall time of those ticks in microseconds, including the pathfinder calls.
+	 * uint64  Total wall time of the pathfinder calls in microseconds, as in #ADMIN_PACKET_SERVER_PATHFINDER_STATS.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_VEHICLE_TICK_STATS(Packet *p);
+
 	/**
 	 * Notify the admin connection that the rcon command has finished.
 	 * string The command as requested by the admin connection.
@@ -20,9 +20,19 @@
 
 #include "../../safeguards.h"
 
+/** Maximum number of threads resolving and connecting at the same time. */
+static const uint MAX_CONNECT_THREADS = 8;
+
 /** List of connections that are currently being created */
 static SmallVector<TCPConnecter *,  1> _tcp_connecters;
 
+/** Connecters waiting for a thread to connect them, in order of creation. */
+static SmallVector<TCPConnecter *, 8> _tcp_connect_queue;
+/** Number of threads working through #_tcp_connect_queue. */
+static uint _tcp_connect_threads = 0;
+/** Mutex guarding #_tcp_connect_queue and #_tcp_connect_threads. */
+static ThreadMutex *_tcp_connect_mutex = ThreadMutex::New();
+
 /**
  * Create a new connecter for the given address
  * @param address the (un)resolved address to connect to
@@ -35,14 +45,29 @@ TCPConnecter::TCPConnecter(const NetworkAddress &address) :
 	address(address)
 {
 	*_tcp_connecters.Append() = this;
-	if (!ThreadObject::New(TCPConnecter::ThreadEntry, this, &this->thread, "ottd:tcp")) {
-		this->Connect();
+
+	/* Refreshing a big server list makes many connecters at once; only a few threads work on them. */
+	_tcp_connect_mutex->BeginCritical();
+	*_tcp_connect_queue.Append() = this;
+	bool start_thread = _tcp_connect_threads < MAX_CONNECT_THREADS;
+	if (start_thread) _tcp_connect_threads++;
+	_tcp_connect_mutex->EndCritical();
+
+	if (start_thread && !ThreadObject::New(TCPConnecter::ThreadEntry, NULL, NULL, "ottd:tcp")) {
+		/* No threads; do the connecting right now. */
+		TCPConnecter::ThreadEntry(NULL);
 	}
 }
 
 /** The actual connection function */
 void TCPConnecter::Connect()
 {
+	/* Don't bother connecting when nobody waits for the connection any more. */
+	if (this->killed) {
+		this->aborted = true;
+		return;
+	}
+
 	this->sock = this->address.Connect();
 	if (this->sock == INVALID_SOCKET) {
 		this->aborted = true;
@@ -52,12 +77,24 @@ void TCPConnecter::Connect()
 }
 
 /**
- * Entry point for the new threads.
- * @param param the TCPConnecter instance to call Connect on.
+ * Entry point for the connect threads; connects the queued connecters until there are none left.
+ * @param param unused.
  */
 /* static */ void TCPConnecter::ThreadEntry(void *param)
 {
-	static_cast<TCPConnecter*>(param)->Connect();
+	for (;;) {
+		_tcp_connect_mutex->BeginCritical();
+		if (_tcp_connect_queue.Length() == 0) {
+			_tcp_connect_threads--;
+			_tcp_connect_mutex->EndCritical();
+			return;
+		}
+		TCPConnecter *cur = _tcp_connect_queue[0];
+		_tcp_connect_queue.ErasePreservingOrder(0U);
+		_tcp_connect_mutex->EndCritical();
+
+		cur->Connect();
+	}
 }
 
 /**
@@ -93,8 +93,10 @@ NetworkRecvStatus NetworkGameSocketHandler::HandlePacket(Packet *p)
 		case PACKET_SERVER_FRAME:                 return this->Receive_SERVER_FRAME(p);
 		case PACKET_SERVER_SYNC:                  return this->Receive_SERVER_SYNC(p);
 		case PACKET_CLIENT_ACK:                   return this->Receive_CLIENT_ACK(p);
+		case PACKET_CLIENT_SYNC_CHECK:            return this->Receive_CLIENT_SYNC_CHECK(p);
 		case PACKET_CLIENT_COMMAND:               return this->Receive_CLIENT_COMMAND(p);
 		case PACKET_SERVER_COMMAND:               return this->Receive_SERVER_COMMAND(p);
+		case PACKET_SERVER_COMMANDS:              return this->Receive_SERVER_COMMANDS(p);
 		case PACKET_CLIENT_CHAT:                  return this->Receive_CLIENT_CHAT(p);
 		case PACKET_SERVER_CHAT:                  return this->Receive_SERVER_CHAT(p);
 		case PACKET_CLIENT_SET_PASSWORD:          return this->Receive_CLIENT_SET_PASSWORD(p);
@@ -179,8 +181,10 @@ NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_JOIN(Packet *p) { ret
 NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_FRAME(Packet *p) { return this->ReceiveInvalidPacket(PACKET_SERVER_FRAME); }
 NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_SYNC(Packet *p) { return this->ReceiveInvalidPacket(PACKET_SERVER_SYNC); }
 NetworkRecvStatus NetworkGameSocketHandler::Receive_CLIENT_ACK(Packet *p) { return this->ReceiveInvalidPacket(PACKET_CLIENT_ACK); }
+NetworkRecvStatus NetworkGameSocketHandler::Receive_CLIENT_SYNC_CHECK(Packet *p) { return this->ReceiveInvalidPacket(PACKET_CLIENT_SYNC_CHECK); }
 NetworkRecvStatus NetworkGameSocketHandler::Receive_CLIENT_COMMAND(Packet *p) { return this->ReceiveInvalidPacket(PACKET_CLIENT_COMMAND); }
 NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_COMMAND(Packet *p) { return this->ReceiveInvalidPacket(PACKET_SERVER_COMMAND); }
+NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_COMMANDS(Packet *p) { return this->ReceiveInvalidPacket(PACKET_SERVER_COMMANDS); }
 NetworkRecvStatus NetworkGameSocketHandler::Receive_CLIENT_CHAT(Packet *p) { return this->ReceiveInvalidPacket(PACKET_CLIENT_CHAT); }
 NetworkRecvStatus NetworkGameSocketHandler::Receive_SERVER_CHAT(Packet *p) { return this->ReceiveInvalidPacket(PACKET_SERVER_CHAT); }
 NetworkRecvStatus NetworkGameSocketHandler::Receive_CLIENT_SET_PASSWORD(Packet *p) { return this->ReceiveInvalidPacket(PACKET_CLIENT_SET_PASSWORD); }
@@ -90,10 +90,12 @@ enum PacketGameType {
 	PACKET_SERVER_FRAME,                 ///< Server tells the client what frame it is in, and thus to where the client may progress.
 	PACKET_CLIENT_ACK,                   ///< The client tells the server which frame it has executed.
 	PACKET_SERVER_SYNC,                  ///< Server tells the client what the random state should be.
+	PACKET_CLIENT_SYNC_CHECK,            ///< The client tells the server the checksums of its game state.
 
 	/* Sending commands around. */
 	PACKET_CLIENT_COMMAND,               ///< Client executed a command and sends it to the server.
 	PACKET_SERVER_COMMAND,               ///< Server distributes a command to (all) the clients.
+	PACKET_SERVER_COMMANDS,              ///< Server distributes several commands of the same frame to (all) the clients.
 
 	/* Human communication! */
 	PACKET_CLIENT_CHAT,                  ///< Client said something that should be distributed.
@@ -350,6 +352,14 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_CLIENT_ACK(Packet *p);
 
+	/**
+	 * Tell the server the checksums of the game state after a frame:
+	 * uint32  The frame after which the checksums were made.
+	 * uint32  For every #SyncCheckPart the checksum of that part.
+	 * @param p The packet that was just received.
+	 */
+	virtual NetworkRecvStatus Receive_CLIENT_SYNC_CHECK(Packet *p);
+
 	/**
 	 * Send a DoCommand to the Server:
 	 * uint8   ID of the company (0..MAX_COMPANIES-1).
@@ -377,6 +387,22 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_COMMAND(Packet *p);
 
+	/**
+	 * Sends several DoCommands of the same frame to the client:
+	 * uint32  Frame of execution.
+	 * Then, till the end of the packet, for every command:
+	 * uint8   ID of the company (0..MAX_COMPANIES-1).
+	 * uint32  ID of the command (see command.h).
+	 * uint32  P1 (free variable used in DoCommand).
+	 * uint32  P2.
+	 * uint32  Tile where this is taking place.
+	 * string  Text.
+	 * uint8   ID of the callback.
+	 * bool    Whether the command was sent by the receiving client.
+	 * @param p The packet that was just received.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_COMMANDS(Packet *p);
+
 	/**
 	 * Sends a chat-packet to the server:
 	 * uint8   ID of the action (see NetworkAction).
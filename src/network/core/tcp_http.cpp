@@ -19,6 +19,7 @@
 #include "../network_func.h"
 
 #include "tcp_http.h"
+#include "poll.h"
 
 #include "../../safeguards.h"
 
@@ -33,16 +34,18 @@ static SmallVector<NetworkHTTPSocketHandler *, 1> _http_connections;
  * @param url      the url at the server
  * @param data     the data to send
  * @param depth    the depth (redirect recursion) of the queries
+ * @param offset   the offset in the document to start downloading at; only for GET requests
  */
 NetworkHTTPSocketHandler::NetworkHTTPSocketHandler(SOCKET s,
 		HTTPCallback *callback, const char *host, const char *url,
-		const char *data, int depth) :
+		const char *data, int depth, size_t offset) :
 	NetworkSocketHandler(),
 	recv_pos(0),
 	recv_length(0),
 	callback(callback),
 	data(data),
 	redirect_depth(depth),
+	offset(offset),
 	sock(s)
 {
 	size_t bufferSize = strlen(url) + strlen(host) + strlen(GetNetworkRevisionString()) + (data == NULL ? 0 : strlen(data)) + 128;
@@ -51,6 +54,8 @@ NetworkHTTPSocketHandler::NetworkHTTPSocketHandler(SOCKET s,
 	DEBUG(net, 7, "[tcp/http] requesting %s%s", host, url);
 	if (data != NULL) {
 		seprintf(buffer, buffer + bufferSize - 1, "POST %s HTTP/1.0\r\nHost: %s\r\nUser-Agent: OpenTTD/%s\r\nContent-Type: text/plain\r\nContent-Length: %d\r\n\r\n%s\r\n", url, host, GetNetworkRevisionString(), (int)strlen(data), data);
+	} else if (offset != 0) {
+		seprintf(buffer, buffer + bufferSize - 1, "GET %s HTTP/1.0\r\nHost: %s\r\nUser-Agent: OpenTTD/%s\r\nRange: bytes=" PRINTF_SIZE "-\r\n\r\n", url, host, GetNetworkRevisionString(), offset);
 	} else {
 		seprintf(buffer, buffer + bufferSize - 1, "GET %s HTTP/1.0\r\nHost: %s\r\nUser-Agent: OpenTTD/%s\r\n\r\n", url, host, GetNetworkRevisionString());
 	}
@@ -119,7 +124,9 @@ int NetworkHTTPSocketHandler::HandleHeader()
 	}
 
 	char *status = this->recv_buffer + strlen(HTTP_1_0);
-	if (strncmp(status, "200", 3) == 0) {
+	/* When resuming a download only the rest of the document will do. */
+	if (this->offset != 0 && strncmp(status, "200", 3) == 0) return_error("[tcp/http] server does not support resuming the download");
+	if (strncmp(status, this->offset != 0 ? "206" : "200", 3) == 0) {
 		/* We are going to receive a document. */
 
 		/* Get the length of the document to receive */
@@ -176,7 +183,7 @@ int NetworkHTTPSocketHandler::HandleHeader()
 
 	DEBUG(net, 6, "[tcp/http] redirecting to %s", uri);
 
-	int ret = NetworkHTTPSocketHandler::Connect(uri, this->callback, this->data, this->redirect_depth + 1);
+	int ret = NetworkHTTPSocketHandler::Connect(uri, this->callback, this->data, this->redirect_depth + 1, this->offset);
 	if (ret != 0) return ret;
 
 	/* We've relinquished control of data now. */
@@ -193,8 +200,9 @@ int NetworkHTTPSocketHandler::HandleHeader()
  * @param callback the callback to send data back on.
  * @param data     the data we want to send (as POST).
  * @param depth    the recursion/redirect depth.
+ * @param offset   the offset in the document to start downloading at.
  */
-/* static */ int NetworkHTTPSocketHandler::Connect(char *uri, HTTPCallback *callback, const char *data, int depth)
+/* static */ int NetworkHTTPSocketHandler::Connect(char *uri, HTTPCallback *callback, const char *data, int depth, size_t offset)
 {
 	char *hname = strstr(uri, "://");
 	if (hname == NULL) return_error("[tcp/http] invalid location");
@@ -216,7 +224,7 @@ int NetworkHTTPSocketHandler::HandleHeader()
 
 	/* Restore the URL. */
 	*url = '/';
-	new NetworkHTTPContentConnecter(address, callback, url, data, depth);
+	new NetworkHTTPContentConnecter(address, callback, url, data, depth, offset);
 	return 0;
 }
 
@@ -301,34 +309,28 @@ int NetworkHTTPSocketHandler::Receive()
 	/* No connections, just bail out. */
 	if (_http_connections.Length() == 0) return;
 
-	fd_set read_fd;
-	struct timeval tv;
-
-	FD_ZERO(&read_fd);
+	SocketPoller poller;
 	for (NetworkHTTPSocketHandler **iter = _http_connections.Begin(); iter < _http_connections.End(); iter++) {
-		FD_SET((*iter)->sock, &read_fd);
+		poller.Add((*iter)->sock, true, false);
 	}
 
-	tv.tv_sec = tv.tv_usec = 0; // don't block at all.
-	int n = select(FD_SETSIZE, &read_fd, NULL, NULL, &tv);
-	if (n == -1) return;
+	if (poller.Poll(0) < 0) return; // don't block at all.
 
-	for (NetworkHTTPSocketHandler **iter = _http_connections.Begin(); iter < _http_connections.End(); /* nothing */) {
-		NetworkHTTPSocketHandler *cur = *iter;
+	/* Go backwards, so erasing a connection only moves one that has been handled already. */
+	for (uint index = _http_connections.Length(); index-- > 0; ) {
+		NetworkHTTPSocketHandler *cur = _http_connections[index];
 
-		if (FD_ISSET(cur->sock, &read_fd)) {
+		if (poller.IsReadable(index)) {
 			int ret = cur->Receive();
 			/* First send the failure. */
 			if (ret < 0) cur->callback->OnFailure();
 			if (ret <= 0) {
 				/* Then... the connection can be closed */
 				cur->CloseConnection();
-				_http_connections.Erase(iter);
+				_http_connections.Erase(_http_connections.Get(index));
 				delete cur;
-				continue;
 			}
 		}
-		iter++;
 	}
 }
 
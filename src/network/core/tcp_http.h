@@ -47,6 +47,7 @@ private:
 	HTTPCallback *callback;   ///< The callback to call for the incoming data.
 	const char *data;         ///< The (POST) data we might want to forward (to a redirect).
 	int redirect_depth;       ///< The depth of the redirection.
+	size_t offset;            ///< The offset in the document to start downloading at, for resuming a download.
 
 	int HandleHeader();
 	int Receive();
@@ -65,12 +66,12 @@ public:
 	virtual NetworkRecvStatus CloseConnection(bool error = true);
 
 	NetworkHTTPSocketHandler(SOCKET sock, HTTPCallback *callback,
-			const char *host, const char *url, const char *data, int depth);
+			const char *host, const char *url, const char *data, int depth, size_t offset);
 
 	~NetworkHTTPSocketHandler();
 
 	static int Connect(char *uri, HTTPCallback *callback,
-			const char *data = NULL, int depth = 0);
+			const char *data = NULL, int depth = 0, size_t offset = 0);
 
 	static void HTTPReceive();
 };
@@ -81,6 +82,7 @@ class NetworkHTTPContentConnecter : TCPConnecter {
 	const char *url;        ///< The URL we want to get at the server.
 	const char *data;       ///< The data to send
 	int depth;              ///< How far we have recursed
+	size_t offset;          ///< The offset in the document to start downloading at
 
 public:
 	/**
@@ -90,15 +92,17 @@ public:
 	 * @param url      the url at the server
 	 * @param data     the data to send
 	 * @param depth    the depth (redirect recursion) of the queries
+	 * @param offset   the offset in the document to start downloading at
 	 */
 	NetworkHTTPContentConnecter(const NetworkAddress &address,
 			HTTPCallback *callback, const char *url,
-			const char *data = NULL, int depth = 0) :
+			const char *data = NULL, int depth = 0, size_t offset = 0) :
 		TCPConnecter(address),
 		callback(callback),
 		url(stredup(url)),
 		data(data),
-		depth(depth)
+		depth(depth),
+		offset(offset)
 	{
 	}
 
@@ -116,7 +120,7 @@ public:
 
 	virtual void OnConnect(SOCKET s)
 	{
-		new NetworkHTTPSocketHandler(s, this->callback, this->address.GetHostname(), this->url, this->data, this->depth);
+		new NetworkHTTPSocketHandler(s, this->callback, this->address.GetHostname(), this->url, this->data, this->depth, this->offset);
 		/* We've relinquished control of data now. */
 		this->data = NULL;
 	}
@@ -15,6 +15,7 @@
 #define NETWORK_CORE_TCP_LISTEN_H
 
 #include "tcp.h"
+#include "poll.h"
 #include "../network.h"
 #include "../../core/pool_type.hpp"
 #include "../../debug.h"
@@ -99,36 +100,42 @@ public:
 	 */
 	static bool Receive()
 	{
-		fd_set read_fd, write_fd;
-		struct timeval tv;
-
-		FD_ZERO(&read_fd);
-		FD_ZERO(&write_fd);
-
+		/* Kept between calls so the memory for the set is not allocated every time. */
+		static SocketPoller poller;
+		poller.Clear();
 
 		Tsocket *cs;
 		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
-			FD_SET(cs->sock, &read_fd);
-			FD_SET(cs->sock, &write_fd);
+			poller.Add(cs->sock, true, true);
 		}
 
 		/* take care of listener port */
+		uint first_listener = poller.Length();
 		for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) {
-			FD_SET(s->second, &read_fd);
+			poller.Add(s->second, true, false);
 		}
 
-		tv.tv_sec = tv.tv_usec = 0; // don't block at all.
-		if (select(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv) < 0) return false;
+		if (poller.Poll(0) < 0) return false; // don't block at all.
+
+		/* Accepting clients adds them to the pool, so first get the state of
+		 * the current clients, in the order in which they were added. */
+		uint index = 0;
+		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
+			cs->writable = poller.IsWritable(index);
+			cs->readable = poller.IsReadable(index);
+			index++;
+		}
 
 		/* accept clients.. */
-		for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) {
-			if (FD_ISSET(s->second, &read_fd)) AcceptClient(s->second);
+		index = first_listener;
+		for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++, index++) {
+			if (poller.IsReadable(index)) AcceptClient(s->second);
 		}
 
 		/* read stuff from clients */
 		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
-			cs->writable = !!FD_ISSET(cs->sock, &write_fd);
-			if (FD_ISSET(cs->sock, &read_fd)) {
+			if (cs->readable) {
+				cs->readable = false;
 				cs->ReceivePackets();
 			}
 		}
@@ -23,6 +23,7 @@
 #include "network_udp.h"
 #include "network_gamelist.h"
 #include "network_base.h"
+#include "network_desync.h"
 #include "core/udp.h"
 #include "core/host.h"
 #include "network_gui.h"
@@ -37,13 +38,41 @@
 #include "../core/pool_func.hpp"
 #include "../gfx_func.h"
 #include "../error.h"
+#include "../fileio_func.h"
+#include "../vehicle_func.h"
+#include <chrono>
 
 #include "../safeguards.h"
 
 #ifdef DEBUG_DUMP_COMMANDS
-#include "../fileio_func.h"
 /** When running the server till the wait point, run as fast as we can! */
 bool _ddc_fastforward = true;
+
+/** Statistics of a replay of commands.log, so the replay can be used as benchmark. */
+struct ReplayStats {
+	std::chrono::steady_clock::time_point start; ///< When the replay started.
+	uint32 first_frame;                         ///< Frame counter when the replay started.
+	uint commands;                              ///< Number of injected commands.
+	uint sync_checks;                           ///< Number of passed sync checks.
+};
+
+/**
+ * Print the outcome of a replay: the wall time it took, the number of replayed
+ * frames and commands and the timings of the game loop and the vehicles.
+ * @param stats The statistics gathered during the replay.
+ */
+static void PrintReplayStats(const ReplayStats &stats)
+{
+	extern void ConPrintFramerate(); // framerate_gui.cpp
+	extern void ConPrintVehicleTickStats(); // vehicle.cpp
+
+	uint64 ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - stats.start).count();
+	uint32 frames = _frame_counter - stats.first_frame;
+	DEBUG(net, 0, "replay: %u frames, %u commands, %u sync checks in " OTTD_PRINTF64 " ms (%.1f frames/s)",
+			frames, stats.commands, stats.sync_checks, ms, ms == 0 ? 0.0 : frames * 1000.0 / ms);
+	ConPrintFramerate();
+	ConPrintVehicleTickStats();
+}
 #endif /* DEBUG_DUMP_COMMANDS */
 
 /** Make sure both pools have the same size. */
@@ -561,6 +590,25 @@ void NetworkClose(bool close_admins)
 	InitializeNetworkPools(close_admins);
 }
 
+static uint32 _catch_up_start = 0; ///< frame the client started catching up with the server at; 0 when not catching up
+
+static const uint CATCH_UP_BUDGET      = MILLISECONDS_PER_TICK * 2 / 3; ///< milliseconds of every real tick a client may spend on running frames to catch up with the server
+static const uint CATCH_UP_MIN_FRAMES  =  2; ///< number of frames a client catching up runs at least every real tick, so it keeps catching up with slow frames
+static const uint CATCH_UP_SHOW_FRAMES = 74; ///< number of frames a client must be behind the server before the progress of catching up is shown
+
+/**
+ * Get how far the client is with catching up with the server.
+ * @param[out] progress Percentage of the frames the client was behind that it has run.
+ * @return True if the client is catching up with the server.
+ */
+bool NetworkGetCatchUpProgress(uint *progress)
+{
+	if (!_networking || _network_server || _catch_up_start == 0 || _frame_counter_server <= _catch_up_start) return false;
+
+	*progress = min<uint>((uint64)(_frame_counter - _catch_up_start) * 100 / (_frame_counter_server - _catch_up_start), 99);
+	return true;
+}
+
 /* Initializes the network (cleans sockets and stuff) */
 static void NetworkInitialize(bool close_admins = true)
 {
@@ -569,6 +617,7 @@ static void NetworkInitialize(bool close_admins = true)
 
 	_sync_frame = 0;
 	_network_first_time = true;
+	_catch_up_start = 0;
 
 	_network_reconnect = 0;
 }
@@ -751,6 +800,7 @@ bool NetworkServerStart()
 	_network_company_passworded = 0;
 
 	NetworkInitGameInfo();
+	NetworkUDPInvalidateServerInfo();
 
 	/* execute server initialization script */
 	IConsoleCmdExec("exec scripts/on_server.scr 0");
@@ -889,6 +939,8 @@ void NetworkGameLoop()
 		static CommandPacket *cp = NULL;
 		static bool check_sync_state = false;
 		static uint32 sync_state[2];
+		static ReplayStats replay_stats = { std::chrono::steady_clock::now(), _frame_counter, 0, 0 };
+		StartVehicleTickStats();
 		if (f == NULL && next_date == 0) {
 			DEBUG(net, 0, "Cannot open commands.log");
 			next_date = 1;
@@ -901,10 +953,12 @@ void NetworkGameLoop()
 					DEBUG(net, 0, "injecting: %08x; %02x; %02x; %06x; %08x; %08x; %08x; \"%s\" (%s)", _date, _date_fract, (int)_current_company, cp->tile, cp->p1, cp->p2, cp->cmd, cp->text, GetCommandName(cp->cmd));
 					free(cp);
 					cp = NULL;
+					replay_stats.commands++;
 				}
 				if (check_sync_state) {
 					if (sync_state[0] == _random.state[0] && sync_state[1] == _random.state[1]) {
 						DEBUG(net, 0, "sync check: %08x; %02x; match", _date, _date_fract);
+						replay_stats.sync_checks++;
 					} else {
 						DEBUG(net, 0, "sync check: %08x; %02x; mismatch expected {%08x, %08x}, got {%08x, %08x}",
 									_date, _date_fract, sync_state[0], sync_state[1], _random.state[0], _random.state[1]);
@@ -972,6 +1026,7 @@ void NetworkGameLoop()
 		}
 		if (f != NULL && feof(f)) {
 			DEBUG(net, 0, "End of commands.log");
+			PrintReplayStats(replay_stats);
 			fclose(f);
 			f = NULL;
 		}
@@ -1004,6 +1059,7 @@ void NetworkGameLoop()
 #ifdef NETWORK_SEND_DOUBLE_SEED
 		_sync_seed_2 = _random.state[1];
 #endif
+		if (IsSyncCheckFrame(_frame_counter)) NetworkServerRecordSyncChecksums();
 
 		NetworkServer_Tick(send_frame);
 	} else {
@@ -1011,11 +1067,27 @@ void NetworkGameLoop()
 
 		/* Make sure we are at the frame were the server is (quick-frames) */
 		if (_frame_counter_server > _frame_counter) {
-			/* Run a number of frames; when things go bad, get out. */
-			while (_frame_counter_server > _frame_counter) {
+			if (_catch_up_start == 0 && _frame_counter_server - _frame_counter >= CATCH_UP_SHOW_FRAMES) _catch_up_start = max<uint32>(_frame_counter, 1);
+
+			/* Run a number of frames; when things go bad, get out. Stop when the
+			 * time for this tick is used up, so the screen is still drawn and the
+			 * network is still handled while catching up after a lag spike. */
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (uint frames = 1; _frame_counter_server > _frame_counter; frames++) {
 				if (!ClientNetworkGameSocketHandler::GameLoop()) return;
+				if (frames >= CATCH_UP_MIN_FRAMES && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(CATCH_UP_BUDGET)) break;
+			}
+
+			if (_catch_up_start != 0) {
+				if (_frame_counter_server <= _frame_counter) _catch_up_start = 0;
+				SetWindowDirty(WC_STATUS_BAR, 0);
 			}
 		} else {
+			if (_catch_up_start != 0) {
+				_catch_up_start = 0;
+				SetWindowDirty(WC_STATUS_BAR, 0);
+			}
+
 			/* Else, keep on going till _frame_counter_max */
 			if (_frame_counter_max > _frame_counter) {
 				/* Run one frame; if things went bad, get out. */
@@ -24,6 +24,11 @@
 #include "../map_func.h"
 #include "../rev.h"
 #include "../game/game.hpp"
+#include "../pathfinder/pathfinder_stats.h"
+#include "../vehicle_func.h"
+#include "../framerate_type.h"
+#include "../vehicle_base.h"
+#include "../linkgraph/linkgraphschedule.h"
 
 #include "../safeguards.h"
 
@@ -56,6 +61,9 @@ static const AdminUpdateFrequency _admin_update_type_frequencies[] = {
 	ADMIN_FREQUENCY_POLL,                                                                                                                                  ///< ADMIN_UPDATE_CMD_NAMES
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_CMD_LOGGING
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_GAMESCRIPT
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_PATHFINDER_STATS
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_PERFORMANCE
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_VEHICLE_TICK_STATS
 };
 /** Sanity check. */
 assert_compile(lengthof(_admin_update_type_frequencies) == ADMIN_UPDATE_END);
@@ -465,6 +473,101 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::SendCompanyStats()
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/** Send the time spent ticking vehicles, for every company and vehicle type with vehicle ticks. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendVehicleTickStats()
+{
+	for (uint c = 0; c < lengthof(_vehicle_tick_stats); c++) {
+		for (VehicleType type = VEH_BEGIN; type < VEH_COMPANY_END; type++) {
+			const VehicleTickStats &stats = _vehicle_tick_stats[c][type];
+			if (stats.ticks == 0) continue;
+
+			Packet *p = new Packet(ADMIN_PACKET_SERVER_VEHICLE_TICK_STATS);
+
+			p->Send_uint8 (c == PF_STATS_NO_COMPANY ? (uint8)OWNER_NONE : c);
+			p->Send_uint8 (type);
+			p->Send_uint64(stats.ticks);
+			p->Send_uint64(stats.time_ns / 1000);
+			p->Send_uint64(_pathfinder_stats[c][type].time_us);
+
+			this->SendPacket(p);
+		}
+	}
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/** Send statistics about the pathfinder calls, for every company and vehicle type with calls. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendPathfinderStats()
+{
+	for (uint c = 0; c < lengthof(_pathfinder_stats); c++) {
+		for (VehicleType type = VEH_BEGIN; type < VEH_COMPANY_END; type++) {
+			const PathfinderStats &stats = _pathfinder_stats[c][type];
+			if (stats.calls == 0) continue;
+
+			Packet *p = new Packet(ADMIN_PACKET_SERVER_PATHFINDER_STATS);
+
+			p->Send_uint8 (c == PF_STATS_NO_COMPANY ? (uint8)OWNER_NONE : c);
+			p->Send_uint8 (type);
+			p->Send_uint32(stats.calls);
+			p->Send_uint32(stats.found);
+			p->Send_uint64(stats.nodes);
+			p->Send_uint64(stats.cache_hits);
+			p->Send_uint64(stats.cost_calcs);
+			p->Send_uint64(stats.time_us);
+
+			p->Send_uint8 (PF_HISTOGRAM_BUCKETS);
+			for (uint i = 0; i < PF_HISTOGRAM_BUCKETS; i++) p->Send_uint32(stats.nodes_hist.count[i]);
+			for (uint i = 0; i < PF_HISTOGRAM_BUCKETS; i++) p->Send_uint32(stats.time_hist.count[i]);
+
+			this->SendPacket(p);
+		}
+	}
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/** Send a snapshot of the performance of the server in one packet. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendPerformance()
+{
+	Packet *p = new Packet(ADMIN_PACKET_SERVER_PERFORMANCE);
+
+	p->Send_uint8(PFE_MAX);
+	for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) {
+		double rate, short_ms, long_ms;
+		if (GetPerformanceSummary(e, &rate, &short_ms, &long_ms)) {
+			p->Send_uint32((uint32)(rate * 1000));
+			p->Send_uint32((uint32)(short_ms * 1000));
+			p->Send_uint32((uint32)(long_ms * 1000));
+		} else {
+			p->Send_uint32(0);
+			p->Send_uint32(0);
+			p->Send_uint32(0);
+		}
+	}
+
+	uint32 vehicles[VEH_COMPANY_END] = {};
+	const Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		if (v->type < VEH_COMPANY_END && v->IsPrimaryVehicle()) vehicles[v->type]++;
+	}
+	p->Send_uint8(VEH_COMPANY_END);
+	for (VehicleType type = VEH_BEGIN; type < VEH_COMPANY_END; type++) p->Send_uint32(vehicles[type]);
+
+	const LinkGraphJobStats &stats = LinkGraphSchedule::instance.GetStats();
+	p->Send_uint32(LinkGraphSchedule::instance.GetRunningCount());
+	p->Send_uint32(stats.jobs);
+	p->Send_uint64(stats.nodes);
+	p->Send_uint64(stats.time_us);
+	p->Send_uint32(stats.max_time_us);
+	p->Send_uint32(stats.late_jobs);
+	p->Send_uint64(stats.wait_us);
+	p->Send_uint32(stats.max_wait_us);
+
+	this->SendPacket(p);
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /**
  * Send a chat message.
  * @param action The action associated with the message.
@@ -715,6 +818,7 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::Receive_ADMIN_UPDATE_FREQUENC
 	}
 
 	this->update_frequency[type] = freq;
+	if (type == ADMIN_UPDATE_VEHICLE_TICK_STATS) StartVehicleTickStats();
 
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -773,6 +877,22 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::Receive_ADMIN_POLL(Packet *p)
 			this->SendCompanyStats();
 			break;
 
+		case ADMIN_UPDATE_PATHFINDER_STATS:
+			/* The admin is requesting pathfinder stats. */
+			this->SendPathfinderStats();
+			break;
+
+		case ADMIN_UPDATE_PERFORMANCE:
+			/* The admin is requesting a performance snapshot. */
+			this->SendPerformance();
+			break;
+
+		case ADMIN_UPDATE_VEHICLE_TICK_STATS:
+			/* The admin is requesting vehicle tick stats. */
+			StartVehicleTickStats();
+			this->SendVehicleTickStats();
+			break;
+
 		case ADMIN_UPDATE_CMD_NAMES:
 			/* The admin is requesting the names of DoCommands. */
 			this->SendCmdNames();
@@ -1039,6 +1159,18 @@ void NetworkAdminUpdate(AdminUpdateFrequency freq)
 						as->SendCompanyStats();
 						break;
 
+					case ADMIN_UPDATE_PATHFINDER_STATS:
+						as->SendPathfinderStats();
+						break;
+
+					case ADMIN_UPDATE_PERFORMANCE:
+						as->SendPerformance();
+						break;
+
+					case ADMIN_UPDATE_VEHICLE_TICK_STATS:
+						as->SendVehicleTickStats();
+						break;
+
 					default: NOT_REACHED();
 				}
 			}
@@ -64,6 +64,9 @@ public:
 	NetworkRecvStatus SendCompanyRemove(CompanyID company_id, AdminCompanyRemoveReason bcrr);
 	NetworkRecvStatus SendCompanyEconomy();
 	NetworkRecvStatus SendCompanyStats();
+	NetworkRecvStatus SendPathfinderStats();
+	NetworkRecvStatus SendVehicleTickStats();
+	NetworkRecvStatus SendPerformance();
 
 	NetworkRecvStatus SendChat(NetworkAction action, DestType desttype, ClientID client_id, const char *msg, int64 data);
 	NetworkRecvStatus SendRcon(uint16 colour, const char *command);
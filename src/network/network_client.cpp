@@ -30,6 +30,8 @@
 #include "network.h"
 #include "network_base.h"
 #include "network_client.h"
+#include "network_desync.h"
+#include "core/poll.h"
 #include "../core/backup_type.hpp"
 
 #include "table/strings.h"
@@ -39,20 +41,31 @@
 /* This file handles all the client-commands */
 
 
-/** Read some packets, and when do use that data as initial load filter. */
+/**
+ * Read some packets, and when do use that data as initial load filter.
+ * When the map is loaded while it is still being received, reading waits
+ * for the server to send the data that is not there yet.
+ * Blocks that have been read are freed right away, so the compressed map
+ * and the loaded map are not both completely in memory.
+ */
 struct PacketReader : LoadFilter {
 	static const size_t CHUNK = 32 * 1024;  ///< 32 KiB chunks of memory.
 
 	AutoFreeSmallVector<byte *, 16> blocks; ///< Buffer with blocks of allocated memory.
-	byte *buf;                              ///< Buffer we're going to write to/read from.
-	byte *bufe;                             ///< End of the buffer we write to/read from.
-	byte **block;                           ///< The block we're reading from/writing to.
 	size_t written_bytes;                   ///< The total number of bytes we've written.
 	size_t read_bytes;                      ///< The total number of read bytes.
+	bool freed_blocks;                      ///< Whether blocks that have been read have been freed, so the reader can't be reset.
+	ClientNetworkGameSocketHandler *cs;     ///< The socket to receive the rest of the map from while reading, or \c NULL when all data is there.
 
 	/** Initialise everything. */
-	PacketReader() : LoadFilter(NULL), buf(NULL), bufe(NULL), block(NULL), written_bytes(0), read_bytes(0)
+	PacketReader() : LoadFilter(NULL), written_bytes(0), read_bytes(0), freed_blocks(false), cs(NULL)
+	{
+	}
+
+	/** Make sure the socket does not refer to us anymore. */
+	~PacketReader()
 	{
+		if (this->cs != NULL && this->cs->savegame == this) this->cs->savegame = NULL;
 	}
 
 	/**
@@ -61,48 +74,51 @@ struct PacketReader : LoadFilter {
 	 */
 	void AddPacket(const Packet *p)
 	{
-		assert(this->read_bytes == 0);
+		assert(this->read_bytes == 0 || this->cs != NULL);
 
-		size_t in_packet = p->size - p->pos;
-		size_t to_write  = min((size_t)(this->bufe - this->buf), in_packet);
 		const byte *pbuf = p->buffer + p->pos;
+		size_t in_packet = p->size - p->pos;
 
-		this->written_bytes += in_packet;
-		if (to_write != 0) {
-			memcpy(this->buf, pbuf, to_write);
-			this->buf += to_write;
-		}
-
-		/* Did everything fit in the current chunk, then we're done. */
-		if (to_write == in_packet) return;
-
-		/* Allocate a new chunk and add the remaining data. */
-		pbuf += to_write;
-		to_write   = in_packet - to_write;
-		this->buf  = *this->blocks.Append() = CallocT<byte>(CHUNK);
-		this->bufe = this->buf + CHUNK;
+		while (in_packet != 0) {
+			/* Allocate a new chunk when the last one is full. */
+			size_t offset = this->written_bytes % CHUNK;
+			if (offset == 0) *this->blocks.Append() = CallocT<byte>(CHUNK);
 
-		memcpy(this->buf, pbuf, to_write);
-		this->buf += to_write;
+			size_t to_write = min(CHUNK - offset, in_packet);
+			memcpy(this->blocks[this->written_bytes / CHUNK] + offset, pbuf, to_write);
+			pbuf += to_write;
+			in_packet -= to_write;
+			this->written_bytes += to_write;
+		}
 	}
 
 	/* virtual */ size_t Read(byte *rbuf, size_t size)
 	{
+		/* Wait for the data that has not been received yet. */
+		while (this->cs != NULL && !this->cs->map_done && this->written_bytes - this->read_bytes < size) {
+			DEBUG(net, 5, "Loading map: waiting for data, %u of %u bytes received, %u loaded", (uint)this->written_bytes, _network_join_bytes_total, (uint)this->read_bytes);
+			if (!this->cs->ReceiveMapWhileLoading()) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		}
+
 		/* Limit the amount to read to whatever we still have. */
 		size_t ret_size = size = min(this->written_bytes - this->read_bytes, size);
-		this->read_bytes += ret_size;
-		const byte *rbufe = rbuf + ret_size;
 
-		while (rbuf != rbufe) {
-			if (this->buf == this->bufe) {
-				this->buf = *this->block++;
-				this->bufe = this->buf + CHUNK;
+		while (size != 0) {
+			size_t offset = this->read_bytes % CHUNK;
+			size_t to_read = min(CHUNK - offset, size);
+			memcpy(rbuf, this->blocks[this->read_bytes / CHUNK] + offset, to_read);
+			rbuf += to_read;
+			size -= to_read;
+			this->read_bytes += to_read;
+
+			/* Free a block once it has been read. The first block is kept, as
+			 * the loader may start over after checking the savegame header. */
+			if (this->read_bytes % CHUNK == 0 && this->read_bytes > CHUNK) {
+				byte *&block = this->blocks[this->read_bytes / CHUNK - 1];
+				free(block);
+				block = NULL;
+				this->freed_blocks = true;
 			}
-
-			size_t to_write = min(this->bufe - this->buf, rbufe - rbuf);
-			memcpy(rbuf, this->buf, to_write);
-			rbuf += to_write;
-			this->buf += to_write;
 		}
 
 		return ret_size;
@@ -110,15 +126,15 @@ struct PacketReader : LoadFilter {
 
 	/* virtual */ void Reset()
 	{
+		assert(!this->freed_blocks);
 		this->read_bytes = 0;
-
-		this->block = this->blocks.Begin();
-		this->buf   = *this->block++;
-		this->bufe  = this->buf + CHUNK;
 	}
 };
 
 
+/** Whether the map is being loaded while it is being received. */
+static bool _network_loading_map = false;
+
 /**
  * Create an emergency savegame when the network connection is lost.
  */
@@ -126,6 +142,8 @@ void ClientNetworkEmergencySave()
 {
 	if (!_settings_client.gui.autosave_on_network_disconnect) return;
 	if (!_networking) return;
+	/* There is nothing sensible to save halfway loading the map. */
+	if (_network_loading_map) return;
 
 	const char *filename = "netsave.sav";
 	DEBUG(net, 0, "Client: Performing emergency save (%s)", filename);
@@ -290,6 +308,8 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 		}
 	}
 
+	if (IsSyncCheckFrame(_frame_counter)) SendSyncCheck();
+
 	return true;
 }
 
@@ -418,6 +438,19 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::SendAck()
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/** Send the checksums of our game state after the current frame, so the server can tell whether and where we desynced. */
+NetworkRecvStatus ClientNetworkGameSocketHandler::SendSyncCheck()
+{
+	SyncChecksums checksums;
+	CalculateSyncChecksums(&checksums);
+
+	Packet *p = new Packet(PACKET_CLIENT_SYNC_CHECK);
+	p->Send_uint32(checksums.frame);
+	for (SyncCheckPart part = SCP_BEGIN; part < SCP_END; part++) p->Send_uint32(checksums.checksum[part]);
+	my_client->SendPacket(p);
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /**
  * Send a command to the server.
  * @param cp The command to send.
@@ -797,6 +830,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_MAP_BEGIN(Packe
 	if (this->savegame != NULL) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
 
 	this->savegame = new PacketReader();
+	this->map_done = false;
 
 	_frame_counter = _frame_counter_server = _frame_counter_max = p->Recv_uint32();
 
@@ -831,14 +865,73 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_MAP_DATA(Packet
 	_network_join_bytes = (uint32)this->savegame->written_bytes;
 	SetWindowDirty(WC_NETWORK_STATUS_WINDOW, WN_NETWORK_STATUS_WINDOW_JOIN);
 
+	/* Start loading right away; the rest of the map is received while loading. */
+	if (_settings_client.network.load_map_while_downloading) return this->LoadMap();
+
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/**
+ * Receive more of the map while it is being loaded, waiting for the server
+ * when nothing has arrived yet. Only the map packets are handled right away;
+ * the other packets are handled once the map has been loaded.
+ * @return False when the connection has been lost.
+ */
+bool ClientNetworkGameSocketHandler::ReceiveMapWhileLoading()
+{
+	/* The lag check does not run while loading, so give up once the server would have given up on us. */
+	uint timeout = max(_settings_client.network.max_download_time * MILLISECONDS_PER_TICK / 1000, 1U);
+	uint waited = 0;
+
+	for (;;) {
+		Packet *p = this->ReceivePacket();
+		if (p == NULL) {
+			if (this->HasClientQuit() || !_networking || waited > timeout) return false;
+
+			SocketPoller poller;
+			poller.Add(this->sock, true, false);
+			if (poller.Poll(1000) <= 0) waited++;
+			continue;
+		}
+
+		PacketGameType type = (PacketGameType)p->Recv_uint8();
+		if (type == PACKET_SERVER_MAP_DATA) {
+			/* The reader is gone once loading is done; the server may still send the end of the stream. */
+			if (this->savegame != NULL) {
+				this->savegame->AddPacket(p);
+				_network_join_bytes = (uint32)this->savegame->written_bytes;
+			}
+			delete p;
+			return true;
+		}
+		if (type == PACKET_SERVER_MAP_DONE) {
+			this->map_done = true;
+			delete p;
+			return true;
+		}
+
+		/* Something else; handle it just like it was received before the map. */
+		p->PrepareToRead();
+		*this->deferred_packets.Append() = p;
+	}
+}
+
 NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_MAP_DONE(Packet *p)
 {
 	if (this->status != STATUS_MAP) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
 	if (this->savegame == NULL) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
 
+	this->map_done = true;
+	return this->LoadMap();
+}
+
+/**
+ * Load the map we received from the server. When not all of it has been
+ * received yet, the rest is received while loading.
+ * @return The state the network should have.
+ */
+NetworkRecvStatus ClientNetworkGameSocketHandler::LoadMap()
+{
 	_network_join_status = NETWORK_JOIN_STATUS_PROCESSING;
 	SetWindowDirty(WC_NETWORK_STATUS_WINDOW, WN_NETWORK_STATUS_WINDOW_JOIN);
 
@@ -848,14 +941,22 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_MAP_DONE(Packet
 	 * We need the local copy and reset this->savegame because when
 	 * loading fails the network gets reset upon loading the intro
 	 * game, which would cause us to free this->savegame twice.
+	 * When the map is still being received, the reader resets
+	 * this->savegame itself once the loading is done.
 	 */
 	LoadFilter *lf = this->savegame;
-	this->savegame = NULL;
+	if (this->map_done) {
+		this->savegame = NULL;
+	} else {
+		this->savegame->cs = this;
+	}
 	lf->Reset();
 
 	/* The map is done downloading, load it */
 	ClearErrorMessages();
+	_network_loading_map = !this->map_done;
 	bool load_success = SafeLoad(NULL, SLO_LOAD, DFT_GAME_FILE, GM_NORMAL, NO_DIRECTORY, lf);
+	_network_loading_map = false;
 
 	/* Long savegame loads shouldn't affect the lag calculation! */
 	this->last_packet = _realtime_tick;
@@ -868,6 +969,21 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_MAP_DONE(Packet
 	/* If the savegame has successfully loaded, ALL windows have been removed,
 	 * only toolbar/statusbar and gamefield are visible */
 
+	/* The loading might have been done before the server finished sending. */
+	while (!this->map_done) {
+		if (!this->ReceiveMapWhileLoading()) return NETWORK_RECV_STATUS_CONN_LOST;
+	}
+
+	/* Handle whatever else the server sent while we were loading. */
+	for (uint i = 0; i < this->deferred_packets.Length(); i++) {
+		NetworkRecvStatus res = this->HandlePacket(this->deferred_packets[i]);
+		if (res != NETWORK_RECV_STATUS_OKAY) {
+			this->deferred_packets.Clear();
+			return res;
+		}
+	}
+	this->deferred_packets.Clear();
+
 	/* Say we received the map and loaded it correctly! */
 	SendMapOk();
 
@@ -956,6 +1072,28 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_COMMAND(Packet
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_COMMANDS(Packet *p)
+{
+	if (this->status != STATUS_ACTIVE) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+
+	uint32 frame = p->Recv_uint32();
+	while (p->pos < p->size) {
+		CommandPacket cp;
+		const char *err = this->ReceiveCommand(p, &cp);
+		cp.frame    = frame;
+		cp.my_cmd   = p->Recv_bool();
+
+		if (err != NULL) {
+			IConsolePrintF(CC_ERROR, "WARNING: %s from server, dropping...", err);
+			return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+		}
+
+		this->incoming_queue.Append(&cp);
+	}
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_CHAT(Packet *p)
 {
 	if (this->status != STATUS_ACTIVE) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
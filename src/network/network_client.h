@@ -21,6 +21,8 @@ class ClientNetworkGameSocketHandler : public ZeroedMemoryAllocator, public Netw
 private:
 	struct PacketReader *savegame; ///< Packet reader for reading the savegame.
 	byte token;                    ///< The token we need to send back to the server to prove we're the right client.
+	bool map_done;                 ///< Whether the server has sent all of the map.
+	AutoDeleteSmallVector<Packet *, 4> deferred_packets; ///< Packets received while loading the map, handled once it is loaded.
 
 	/** Status of the connection with the server. */
 	enum ServerStatus {
@@ -42,6 +44,7 @@ private:
 protected:
 	friend void NetworkExecuteLocalCommandQueue();
 	friend void NetworkClose(bool close_admins);
+	friend struct PacketReader;
 	static ClientNetworkGameSocketHandler *my_client; ///< This is us!
 
 	virtual NetworkRecvStatus Receive_SERVER_FULL(Packet *p);
@@ -61,6 +64,7 @@ protected:
 	virtual NetworkRecvStatus Receive_SERVER_FRAME(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_SYNC(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_COMMAND(Packet *p);
+	virtual NetworkRecvStatus Receive_SERVER_COMMANDS(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_CHAT(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_QUIT(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_ERROR_QUIT(Packet *p);
@@ -76,6 +80,8 @@ protected:
 	static NetworkRecvStatus SendGetMap();
 	static NetworkRecvStatus SendMapOk();
 	void CheckConnection();
+	bool ReceiveMapWhileLoading();
+	NetworkRecvStatus LoadMap();
 public:
 	ClientNetworkGameSocketHandler(SOCKET s);
 	~ClientNetworkGameSocketHandler();
@@ -90,6 +96,7 @@ public:
 	static NetworkRecvStatus SendError(NetworkErrorCode errorno);
 	static NetworkRecvStatus SendQuit();
 	static NetworkRecvStatus SendAck();
+	static NetworkRecvStatus SendSyncCheck();
 
 	static NetworkRecvStatus SendGamePassword(const char *password);
 	static NetworkRecvStatus SendCompanyPassword(const char *password);
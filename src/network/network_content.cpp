@@ -19,6 +19,7 @@
 #include "../error.h"
 #include "../base_media_base.h"
 #include "../settings_type.h"
+#include "../core/mem_func.hpp"
 #include "network_content.h"
 
 #include "table/strings.h"
@@ -378,85 +379,235 @@ void ClientNetworkContentSocketHandler::DownloadSelectedContentFallback(const Co
 
 /**
  * Determine the full filename of a piece of content information
- * @param ci         the information to get the filename from
- * @param compressed should the filename end with .gz?
- * @return a statically allocated buffer with the filename or
+ * @param ci the information to get the filename from
+ * @return a statically allocated buffer with the filename of the tar or
  *         NULL when no filename could be made.
  */
-static char *GetFullFilename(const ContentInfo *ci, bool compressed)
+static char *GetFullFilename(const ContentInfo *ci)
 {
 	Subdirectory dir = GetContentInfoSubDir(ci->type);
 	if (dir == NO_DIRECTORY) return NULL;
 
 	static char buf[MAX_PATH];
 	FioGetFullPath(buf, lastof(buf), SP_AUTODOWNLOAD_DIR, dir, ci->filename);
-	strecat(buf, compressed ? ".tar.gz" : ".tar", lastof(buf));
+	strecat(buf, ".tar", lastof(buf));
 
 	return buf;
 }
 
 /**
- * Gunzip a given file and remove the .gz if successful.
- * @param ci container with filename
- * @return true if the gunzip completed
+ * Writer of downloaded content to its tar file. The content is sent as
+ * .tar.gz, so it is decompressed while it is being received instead of
+ * decompressing the whole file again after it has been downloaded.
  */
-static bool GunzipFile(const ContentInfo *ci)
+class ContentFileWriter {
+	FILE *file;              ///< The tar file being written.
+	char filename[MAX_PATH]; ///< The name of the tar file.
+#if defined(WITH_ZLIB)
+	z_stream z;              ///< The state of the decompression.
+	bool stream_end;         ///< Whether the end of the compressed stream has been reached.
+#endif /* defined(WITH_ZLIB) */
+
+public:
+	/** Create a writer without a file. */
+	ContentFileWriter() : file(NULL) {}
+
+	/** Remove the file if it has not been completed. */
+	~ContentFileWriter()
+	{
+		this->Abort();
+	}
+
+	bool Open(const ContentInfo *ci);
+	bool Write(const byte *data, size_t length);
+	bool Close();
+	void Abort();
+};
+
+/**
+ * Open the tar file for a piece of content. Shows an error when that fails.
+ * @param ci The content that is going to be downloaded.
+ * @return false on any error.
+ */
+bool ContentFileWriter::Open(const ContentInfo *ci)
 {
 #if defined(WITH_ZLIB)
-	bool ret = true;
+	assert(this->file == NULL);
+
+	const char *filename = GetFullFilename(ci);
+	if (filename != NULL) {
+		strecpy(this->filename, filename, lastof(this->filename));
+		this->file = fopen(this->filename, "wb");
+	}
+	if (this->file == NULL) {
+		DeleteWindowById(WC_NETWORK_STATUS_WINDOW, WN_NETWORK_STATUS_WINDOW_CONTENT_DOWNLOAD);
+		ShowErrorMessage(STR_CONTENT_ERROR_COULD_NOT_DOWNLOAD, STR_CONTENT_ERROR_COULD_NOT_DOWNLOAD_FILE_NOT_WRITABLE, WL_ERROR);
+		return false;
+	}
+
+	MemSetT(&this->z, 0);
+	/* Only accept a gzip header, like the .tar.gz the content is sent as. */
+	if (inflateInit2(&this->z, MAX_WBITS + 16) != Z_OK) {
+		this->Abort();
+		return false;
+	}
+	this->stream_end = false;
+	return true;
+#else
+	NOT_REACHED();
+#endif /* defined(WITH_ZLIB) */
+}
 
-	/* Need to open the file with fopen() to support non-ASCII on Windows. */
-	FILE *ftmp = fopen(GetFullFilename(ci, true), "rb");
-	if (ftmp == NULL) return false;
-	/* Duplicate the handle, and close the FILE*, to avoid double-closing the handle later. */
-	gzFile fin = gzdopen(dup(fileno(ftmp)), "rb");
-	fclose(ftmp);
+/**
+ * Decompress a part of the downloaded content into the tar file.
+ * @param data The received compressed data.
+ * @param length The number of received bytes.
+ * @return false if the data is broken or could not be written.
+ */
+bool ContentFileWriter::Write(const byte *data, size_t length)
+{
+#if defined(WITH_ZLIB)
+	assert(this->file != NULL);
 
-	FILE *fout = fopen(GetFullFilename(ci, false), "wb");
+	byte buffer[8192];
+	this->z.next_in = const_cast<byte *>(data);
+	this->z.avail_in = (uInt)length;
 
-	if (fin == NULL || fout == NULL) {
-		ret = false;
-	} else {
-		byte buff[8192];
-		for (;;) {
-			int read = gzread(fin, buff, sizeof(buff));
-			if (read == 0) {
-				/* If gzread() returns 0, either the end-of-file has been
-				 * reached or an underlying read error has occurred.
-				 *
-				 * gzeof() can't be used, because:
-				 * 1.2.5 - it is safe, 1 means 'everything was OK'
-				 * 1.2.3.5, 1.2.4 - 0 or 1 is returned 'randomly'
-				 * 1.2.3.3 - 1 is returned for truncated archive
-				 *
-				 * So we use gzerror(). When proper end of archive
-				 * has been reached, then:
-				 * errnum == Z_STREAM_END in 1.2.3.3,
-				 * errnum == 0 in 1.2.4 and 1.2.5 */
-				int errnum;
-				gzerror(fin, &errnum);
-				if (errnum != 0 && errnum != Z_STREAM_END) ret = false;
-				break;
-			}
-			if (read < 0 || (size_t)read != fwrite(buff, 1, read, fout)) {
-				/* If gzread() returns -1, there was an error in archive */
-				ret = false;
-				break;
-			}
-			/* DO NOT DO THIS! It will fail to detect broken archive with 1.2.3.3!
-			 * if (read < sizeof(buff)) break; */
+	do {
+		if (this->stream_end) {
+			/* More data behind the end of the stream is another gzip member; gzread() reads those as well. */
+			if (inflateReset(&this->z) != Z_OK) return false;
+			this->stream_end = false;
 		}
-	}
 
-	if (fin != NULL) gzclose(fin);
-	if (fout != NULL) fclose(fout);
+		this->z.next_out = buffer;
+		this->z.avail_out = sizeof(buffer);
+		int res = inflate(&this->z, Z_NO_FLUSH);
+		/* Z_BUF_ERROR means no progress could be made; more input is needed. */
+		if (res == Z_BUF_ERROR) break;
+		if (res != Z_OK && res != Z_STREAM_END) return false;
+
+		size_t written = sizeof(buffer) - this->z.avail_out;
+		if (fwrite(buffer, 1, written, this->file) != written) return false;
 
+		if (res == Z_STREAM_END) this->stream_end = true;
+		/* When the output buffer got full there might be more output pending. */
+	} while (this->z.avail_in != 0 || this->z.avail_out == 0);
+
+	return true;
+#else
+	NOT_REACHED();
+#endif /* defined(WITH_ZLIB) */
+}
+
+/**
+ * Finish writing the tar file after all data has been received.
+ * @return true if the whole compressed stream was received and written.
+ */
+bool ContentFileWriter::Close()
+{
+#if defined(WITH_ZLIB)
+	assert(this->file != NULL);
+
+	bool ret = this->stream_end;
+	inflateEnd(&this->z);
+	if (fclose(this->file) != 0) ret = false;
+	this->file = NULL;
+
+	if (!ret) unlink(this->filename);
 	return ret;
 #else
 	NOT_REACHED();
 #endif /* defined(WITH_ZLIB) */
 }
 
+/** Stop writing the tar file and remove what has been written. */
+void ContentFileWriter::Abort()
+{
+#if defined(WITH_ZLIB)
+	if (this->file == NULL) return;
+
+	inflateEnd(&this->z);
+	fclose(this->file);
+	this->file = NULL;
+	unlink(this->filename);
+#endif /* defined(WITH_ZLIB) */
+}
+
+/**
+ * Download of a single piece of content over HTTP. Several of them run at
+ * the same time. When the connection breaks the download is resumed where
+ * it stopped a few times, before falling back to the content server.
+ */
+class ContentHTTPDownload : public HTTPCallback {
+public:
+	ClientNetworkContentSocketHandler *handler; ///< The handler that started the download.
+	ContentInfo info;         ///< The content being downloaded.
+	char *url;                ///< The URL to download the content from.
+	ContentFileWriter writer; ///< The writer of the tar file.
+	size_t received;          ///< The number of (compressed) bytes received.
+	uint retries;             ///< The number of times the download has been resumed.
+	bool failed;              ///< Whether the download failed and can't be resumed.
+
+	/** The number of times to resume a broken download. */
+	static const uint MAX_RETRIES = 3;
+
+	/**
+	 * Create the download.
+	 * @param handler The handler starting the download.
+	 */
+	ContentHTTPDownload(ClientNetworkContentSocketHandler *handler) :
+		handler(handler), url(NULL), received(0), retries(0), failed(false)
+	{
+	}
+
+	/** Free the URL. */
+	~ContentHTTPDownload()
+	{
+		free(this->url);
+	}
+
+	/**
+	 * Start downloading, or continue after the connection broke.
+	 * @return false when the request could not be made at all.
+	 */
+	bool Connect()
+	{
+		return NetworkHTTPSocketHandler::Connect(this->url, this, NULL, 0, this->received) == 0;
+	}
+
+	virtual void OnFailure()
+	{
+		if (!this->failed && this->retries < MAX_RETRIES) {
+			this->retries++;
+			DEBUG(net, 1, "[content] resuming download of %s at " PRINTF_SIZE " bytes", this->info.filename, this->received);
+			if (this->Connect()) return;
+		}
+		this->handler->OnHTTPDownloadDone(this, false);
+	}
+
+	virtual void OnReceiveData(const char *data, size_t length)
+	{
+		assert(data == NULL || length != 0);
+
+		if (data == NULL) {
+			this->handler->OnHTTPDownloadDone(this, !this->failed && this->writer.Close());
+			return;
+		}
+
+		/* Wait for the connection to end. */
+		if (this->failed) return;
+
+		if (!this->writer.Write((const byte *)data, length)) {
+			this->failed = true;
+			return;
+		}
+
+		this->received += length;
+		this->handler->OnDownloadProgress(&this->info, (int)length);
+	}
+};
+
 bool ClientNetworkContentSocketHandler::Receive_SERVER_CONTENT(Packet *p)
 {
 	if (this->curFile == NULL) {
@@ -475,11 +626,11 @@ bool ClientNetworkContentSocketHandler::Receive_SERVER_CONTENT(Packet *p)
 	} else {
 		/* We have a file opened, thus are downloading internal content */
 		size_t toRead = (size_t)(p->size - p->pos);
-		if (fwrite(p->buffer + p->pos, 1, toRead, this->curFile) != toRead) {
+		if (toRead != 0 && !this->curFile->Write(p->buffer + p->pos, toRead)) {
 			DeleteWindowById(WC_NETWORK_STATUS_WINDOW, WN_NETWORK_STATUS_WINDOW_CONTENT_DOWNLOAD);
 			ShowErrorMessage(STR_CONTENT_ERROR_COULD_NOT_DOWNLOAD, STR_CONTENT_ERROR_COULD_NOT_DOWNLOAD_FILE_NOT_WRITABLE, WL_ERROR);
 			this->Close();
-			fclose(this->curFile);
+			delete this->curFile;
 			this->curFile = NULL;
 
 			return false;
@@ -487,7 +638,18 @@ bool ClientNetworkContentSocketHandler::Receive_SERVER_CONTENT(Packet *p)
 
 		this->OnDownloadProgress(this->curInfo, (int)toRead);
 
-		if (toRead == 0) this->AfterDownload();
+		if (toRead == 0) {
+			/* We read nothing; that's our marker for end-of-stream. */
+			bool complete = this->curFile->Close();
+			delete this->curFile;
+			this->curFile = NULL;
+
+			if (complete) {
+				this->AfterDownload(this->curInfo);
+			} else {
+				ShowErrorMessage(STR_CONTENT_ERROR_COULD_NOT_EXTRACT, INVALID_STRING_ID, WL_ERROR);
+			}
+		}
 	}
 
 	return true;
@@ -507,11 +669,11 @@ bool ClientNetworkContentSocketHandler::BeforeDownload()
 
 	if (this->curInfo->filesize != 0) {
 		/* The filesize is > 0, so we are going to download it */
-		const char *filename = GetFullFilename(this->curInfo, true);
-		if (filename == NULL || (this->curFile = fopen(filename, "wb")) == NULL) {
+		this->curFile = new ContentFileWriter();
+		if (!this->curFile->Open(this->curInfo)) {
 			/* Unless that fails of course... */
-			DeleteWindowById(WC_NETWORK_STATUS_WINDOW, WN_NETWORK_STATUS_WINDOW_CONTENT_DOWNLOAD);
-			ShowErrorMessage(STR_CONTENT_ERROR_COULD_NOT_DOWNLOAD, STR_CONTENT_ERROR_COULD_NOT_DOWNLOAD_FILE_NOT_WRITABLE, WL_ERROR);
+			delete this->curFile;
+			this->curFile = NULL;
 			return false;
 		}
 	}
@@ -519,35 +681,24 @@ bool ClientNetworkContentSocketHandler::BeforeDownload()
 }
 
 /**
- * Handle the closing and extracting of a file after
- * downloading it has been done.
+ * Make a downloaded and extracted piece of content known.
+ * @param ci The content that has been downloaded.
  */
-void ClientNetworkContentSocketHandler::AfterDownload()
+void ClientNetworkContentSocketHandler::AfterDownload(const ContentInfo *ci)
 {
-	/* We read nothing; that's our marker for end-of-stream.
-	 * Now gunzip the tar and make it known. */
-	fclose(this->curFile);
-	this->curFile = NULL;
-
-	if (GunzipFile(this->curInfo)) {
-		unlink(GetFullFilename(this->curInfo, true));
-
-		Subdirectory sd = GetContentInfoSubDir(this->curInfo->type);
-		if (sd == NO_DIRECTORY) NOT_REACHED();
+	Subdirectory sd = GetContentInfoSubDir(ci->type);
+	if (sd == NO_DIRECTORY) NOT_REACHED();
 
-		TarScanner ts;
-		ts.AddFile(sd, GetFullFilename(this->curInfo, false));
+	TarScanner ts;
+	ts.AddFile(sd, GetFullFilename(ci));
 
-		if (this->curInfo->type == CONTENT_TYPE_BASE_MUSIC) {
-			/* Music can't be in a tar. So extract the tar! */
-			ExtractTar(GetFullFilename(this->curInfo, false), BASESET_DIR);
-			unlink(GetFullFilename(this->curInfo, false));
-		}
-
-		this->OnDownloadComplete(this->curInfo->id);
-	} else {
-		ShowErrorMessage(STR_CONTENT_ERROR_COULD_NOT_EXTRACT, INVALID_STRING_ID, WL_ERROR);
+	if (ci->type == CONTENT_TYPE_BASE_MUSIC) {
+		/* Music can't be in a tar. So extract the tar! */
+		ExtractTar(GetFullFilename(ci), BASESET_DIR);
+		unlink(GetFullFilename(ci));
 	}
+
+	this->OnDownloadComplete(ci->id);
 }
 
 /* Also called to just clean up the mess. */
@@ -559,15 +710,7 @@ void ClientNetworkContentSocketHandler::OnFailure()
 
 	this->http_response.Reset();
 	this->http_response_index = -2;
-
-	if (this->curFile != NULL) {
-		/* Revert the download progress when we are going for the old system. */
-		long size = ftell(this->curFile);
-		if (size > 0) this->OnDownloadProgress(this->curInfo, (int)-size);
-
-		fclose(this->curFile);
-		this->curFile = NULL;
-	}
+	this->http_fallback = false;
 }
 
 void ClientNetworkContentSocketHandler::OnReceiveData(const char *data, size_t length)
@@ -575,58 +718,37 @@ void ClientNetworkContentSocketHandler::OnReceiveData(const char *data, size_t l
 	assert(data == NULL || length != 0);
 
 	/* Ignore any latent data coming from a connection we closed. */
-	if (this->http_response_index == -2) return;
-
-	if (this->http_response_index == -1) {
-		if (data != NULL) {
-			/* Append the rest of the response. */
-			memcpy(this->http_response.Append((uint)length), data, length);
-			return;
-		} else {
-			/* Make sure the response is properly terminated. */
-			*this->http_response.Append() = '\0';
-
-			/* And prepare for receiving the rest of the data. */
-			this->http_response_index = 0;
-		}
-	}
+	if (this->http_response_index != -1) return;
 
 	if (data != NULL) {
-		/* We have data, so write it to the file. */
-		if (fwrite(data, 1, length, this->curFile) != length) {
-			/* Writing failed somehow, let try via the old method. */
-			this->OnFailure();
-		} else {
-			/* Just received the data. */
-			this->OnDownloadProgress(this->curInfo, (int)length);
-		}
-		/* Nothing more to do now. */
+		/* Append the rest of the response. */
+		memcpy(this->http_response.Append((uint)length), data, length);
 		return;
 	}
 
-	if (this->curFile != NULL) {
-		/* We've finished downloading a file. */
-		this->AfterDownload();
-	}
-
-	if ((uint)this->http_response_index >= this->http_response.Length()) {
-		/* It's not a real failure, but if there's
-		 * nothing more to download it helps with
-		 * cleaning up the stuff we allocated. */
-		this->OnFailure();
-		return;
-	}
+	/* Make sure the response is properly terminated. */
+	*this->http_response.Append() = '\0';
 
-	delete this->curInfo;
-	/* When we haven't opened a file this must be our first packet with metadata. */
-	this->curInfo = new ContentInfo;
+	/* And start downloading the files listed in it. */
+	this->http_response_index = 0;
+	this->StartHTTPDownloads();
+}
 
-/** Check p for not being null and return calling OnFailure if that's not the case. */
-#define check_not_null(p) { if ((p) == NULL) { this->OnFailure(); return; } }
-/** Check p for not being null and then terminate, or return calling OnFailure. */
+/**
+ * Start downloads of the files listed in the HTTP response, until the
+ * maximum number of downloads is running. When the last download is done,
+ * anything that could not be downloaded over HTTP is downloaded from the
+ * content server.
+ */
+void ClientNetworkContentSocketHandler::StartHTTPDownloads()
+{
+/** Check p for not being null and stop downloading via HTTP if that's not the case. */
+#define check_not_null(p) { if ((p) == NULL) { this->http_fallback = true; break; } }
+/** Check p for not being null and then terminate, or stop downloading via HTTP. */
 #define check_and_terminate(p) { check_not_null(p); *(p) = '\0'; }
 
-	for (;;) {
+	while (!this->http_fallback && this->http_downloads.Length() < MAX_HTTP_DOWNLOADS &&
+			(uint)this->http_response_index < this->http_response.Length()) {
 		char *str = this->http_response.Begin() + this->http_response_index;
 		char *p = strchr(str, '\n');
 		check_and_terminate(p);
@@ -637,31 +759,24 @@ void ClientNetworkContentSocketHandler::OnReceiveData(const char *data, size_t l
 		/* Read the ID */
 		p = strchr(str, ',');
 		check_and_terminate(p);
-		this->curInfo->id = (ContentID)atoi(str);
+		ContentID id = (ContentID)atoi(str);
 
 		/* Read the type */
 		str = p + 1;
 		p = strchr(str, ',');
 		check_and_terminate(p);
-		this->curInfo->type = (ContentType)atoi(str);
+		ContentType type = (ContentType)atoi(str);
 
 		/* Read the file size */
 		str = p + 1;
 		p = strchr(str, ',');
 		check_and_terminate(p);
-		this->curInfo->filesize = atoi(str);
+		uint32 filesize = atoi(str);
 
 		/* Read the URL */
 		str = p + 1;
 		/* Is it a fallback URL? If so, just continue with the next one. */
-		if (strncmp(str, "ottd", 4) == 0) {
-			if ((uint)this->http_response_index >= this->http_response.Length()) {
-				/* Have we gone through all lines? */
-				this->OnFailure();
-				return;
-			}
-			continue;
-		}
+		if (strncmp(str, "ottd", 4) == 0) continue;
 
 		p = strrchr(str, '/');
 		check_not_null(p);
@@ -669,30 +784,62 @@ void ClientNetworkContentSocketHandler::OnReceiveData(const char *data, size_t l
 
 		char tmp[MAX_PATH];
 		if (strecpy(tmp, p, lastof(tmp)) == lastof(tmp)) {
-			this->OnFailure();
-			return;
+			this->http_fallback = true;
+			break;
 		}
 		/* Remove the extension from the string. */
-		for (uint i = 0; i < 2; i++) {
+		p = strrchr(tmp, '.');
+		if (p != NULL) {
+			*p = '\0';
 			p = strrchr(tmp, '.');
-			check_and_terminate(p);
 		}
+		check_and_terminate(p);
 
+		ContentHTTPDownload *download = new ContentHTTPDownload(this);
+		ContentInfo *ci = &download->info;
+		ci->id = id;
+		ci->type = type;
+		ci->filesize = filesize;
 		/* Copy the string, without extension, to the filename. */
-		strecpy(this->curInfo->filename, tmp, lastof(this->curInfo->filename));
+		strecpy(ci->filename, tmp, lastof(ci->filename));
+		download->url = stredup(str);
 
-		/* Request the next file. */
-		if (!this->BeforeDownload()) {
-			this->OnFailure();
-			return;
+		/* Request the file. */
+		if (!ci->IsValid() || !download->writer.Open(ci) || !download->Connect()) {
+			delete download;
+			this->http_fallback = true;
+			break;
 		}
-
-		NetworkHTTPSocketHandler::Connect(str, this);
-		return;
+		*this->http_downloads.Append() = download;
 	}
 
-#undef check
+#undef check_not_null
 #undef check_and_terminate
+
+	/* It's not a real failure when everything has been downloaded, but it
+	 * helps with cleaning up the stuff we allocated. */
+	if (this->http_downloads.Length() == 0) this->OnFailure();
+}
+
+/**
+ * Handle the end of a HTTP download.
+ * @param download The download that is done; it is deleted.
+ * @param success Whether the content was completely downloaded and extracted.
+ */
+void ClientNetworkContentSocketHandler::OnHTTPDownloadDone(ContentHTTPDownload *download, bool success)
+{
+	this->http_downloads.Erase(this->http_downloads.Find(download));
+
+	if (success) {
+		this->AfterDownload(&download->info);
+	} else {
+		/* Revert the download progress, the content server will send everything again. */
+		if (download->received > 0) this->OnDownloadProgress(&download->info, -(int)download->received);
+		this->http_fallback = true;
+	}
+	delete download;
+
+	this->StartHTTPDownloads();
 }
 
 /**
@@ -701,6 +848,7 @@ void ClientNetworkContentSocketHandler::OnReceiveData(const char *data, size_t l
 ClientNetworkContentSocketHandler::ClientNetworkContentSocketHandler() :
 	NetworkContentSocketHandler(),
 	http_response_index(-2),
+	http_fallback(false),
 	curFile(NULL),
 	curInfo(NULL),
 	isConnecting(false),
@@ -712,7 +860,7 @@ ClientNetworkContentSocketHandler::ClientNetworkContentSocketHandler() :
 ClientNetworkContentSocketHandler::~ClientNetworkContentSocketHandler()
 {
 	delete this->curInfo;
-	if (this->curFile != NULL) fclose(this->curFile);
+	delete this->curFile;
 
 	for (ContentIterator iter = this->infos.Begin(); iter != this->infos.End(); iter++) delete *iter;
 }
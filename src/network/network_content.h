@@ -63,6 +63,9 @@ struct ContentCallback {
 	virtual ~ContentCallback() {}
 };
 
+class ContentFileWriter;
+class ContentHTTPDownload;
+
 /**
  * Socket handler for the content server connection
  */
@@ -74,13 +77,16 @@ protected:
 	ContentVector infos;                         ///< All content info we received
 	SmallVector<char, 1024> http_response;       ///< The HTTP response to the requests we've been doing
 	int http_response_index;                     ///< Where we are, in the response, with handling it
+	SmallVector<ContentHTTPDownload *, 4> http_downloads; ///< The HTTP downloads that are running
+	bool http_fallback;                          ///< Whether a HTTP download failed, so the rest has to go via the content server
 
-	FILE *curFile;        ///< Currently downloaded file
+	ContentFileWriter *curFile; ///< Currently downloaded file
 	ContentInfo *curInfo; ///< Information about the currently downloaded file
 	bool isConnecting;    ///< Whether we're connecting
 	uint32 lastActivity;  ///< The last time there was network activity
 
 	friend class NetworkContentConnecter;
+	friend class ContentHTTPDownload;
 
 	virtual bool Receive_SERVER_INFO(Packet *p);
 	virtual bool Receive_SERVER_CONTENT(Packet *p);
@@ -98,13 +104,18 @@ protected:
 	void OnReceiveData(const char *data, size_t length);
 
 	bool BeforeDownload();
-	void AfterDownload();
+	void AfterDownload(const ContentInfo *ci);
+
+	void StartHTTPDownloads();
+	void OnHTTPDownloadDone(ContentHTTPDownload *download, bool success);
 
 	void DownloadSelectedContentHTTP(const ContentIDList &content);
 	void DownloadSelectedContentFallback(const ContentIDList &content);
 public:
 	/** The idle timeout; when to close the connection because it's idle. */
 	static const int IDLE_TIMEOUT = 60 * 1000;
+	/** The number of HTTP downloads to run at the same time. */
+	static const uint MAX_HTTP_DOWNLOADS = 4;
 
 	ClientNetworkContentSocketHandler();
 	~ClientNetworkContentSocketHandler();
@@ -150,7 +150,7 @@ BaseNetworkContentDownloadStatusWindow::~BaseNetworkContentDownloadStatusWindow(
 	if (ci->id != this->cur_id) {
 		strecpy(this->name, ci->filename, lastof(this->name));
 		this->cur_id = ci->id;
-		this->downloaded_files++;
+		if (!this->received_ids.Include(ci->id)) this->downloaded_files++;
 	}
 
 	this->downloaded_bytes += bytes;
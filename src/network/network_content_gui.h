@@ -25,6 +25,7 @@ protected:
 	uint downloaded_files; ///< Number of files downloaded
 
 	uint32 cur_id; ///< The current ID of the downloaded file
+	SmallVector<ContentID, 16> received_ids; ///< IDs of the files we received data of; several are downloaded at the same time
 	char name[48]; ///< The current name of the downloaded file
 
 public:
@@ -0,0 +1,139 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file network_desync.cpp Detecting desyncs by comparing checksums of parts of the game state.
+ *
+ * The server and the clients make checksums of several parts of the game
+ * state after the same frames. The clients send theirs to the server, which
+ * compares them with its own. Unlike the check of the random seeds that only
+ * tells that the game state differs, this tells which part of the game state
+ * started to differ, and between which two checks it did.
+ *
+ * Only state that is part of the savegame may be checked, as everything
+ * else, like caches for the user interface, may differ between the server
+ * and the clients without being a desync.
+ */
+
+#ifdef ENABLE_NETWORK
+
+#include "../stdafx.h"
+#include "../date_func.h"
+#include "../map_func.h"
+#include "../vehicle_base.h"
+#include "../station_base.h"
+#include "../company_base.h"
+#include "network_internal.h"
+#include "network_desync.h"
+
+#include "../safeguards.h"
+
+static const uint SYNC_CHECK_HISTORY = 32; ///< Number of checks the server remembers the checksums of, for clients that are behind.
+
+static SyncChecksums _sync_check_history[SYNC_CHECK_HISTORY]; ///< The checksums the server made, indexed by check number modulo #SYNC_CHECK_HISTORY.
+
+/**
+ * Add a value to a checksum.
+ * @param checksum The checksum.
+ * @param value The value to add.
+ */
+static inline void AddToChecksum(uint32 &checksum, uint32 value)
+{
+	checksum = (ROL(checksum, 5) ^ value) * 0x01000193;
+}
+
+/**
+ * Make the checksums of the game state as it is now, after the current frame.
+ * @param[out] checksums The checksums.
+ */
+void CalculateSyncChecksums(SyncChecksums *checksums)
+{
+	checksums->frame = _frame_counter;
+	checksums->date = _date;
+	checksums->date_fract = _date_fract;
+	for (SyncCheckPart part = SCP_BEGIN; part < SCP_END; part++) checksums->checksum[part] = 0;
+
+	const Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		uint32 &checksum = checksums->checksum[SCP_VEHICLES];
+		AddToChecksum(checksum, v->index);
+		AddToChecksum(checksum, v->tile);
+		AddToChecksum(checksum, v->x_pos);
+		AddToChecksum(checksum, v->y_pos);
+		AddToChecksum(checksum, v->z_pos);
+		AddToChecksum(checksum, v->direction | v->progress << 8 | v->cur_speed << 16);
+		AddToChecksum(checksum, v->vehstatus);
+
+		AddToChecksum(checksums->checksum[SCP_CARGO], v->cargo.TotalCount());
+	}
+
+	const Station *st;
+	FOR_ALL_STATIONS(st) {
+		uint32 &checksum = checksums->checksum[SCP_STATIONS];
+		AddToChecksum(checksum, st->index);
+		AddToChecksum(checksum, st->xy);
+		AddToChecksum(checksum, st->facilities | st->owner << 8);
+		for (CargoID c = 0; c < NUM_CARGO; c++) {
+			AddToChecksum(checksum, st->goods[c].rating);
+			AddToChecksum(checksums->checksum[SCP_CARGO], st->goods[c].cargo.TotalCount());
+		}
+	}
+
+	const Company *c;
+	FOR_ALL_COMPANIES(c) {
+		uint32 &checksum = checksums->checksum[SCP_COMPANIES];
+		AddToChecksum(checksum, c->index);
+		AddToChecksum(checksum, (uint32)c->money);
+		AddToChecksum(checksum, (uint32)(c->money >> 32));
+		AddToChecksum(checksum, (uint32)c->current_loan);
+	}
+
+	/* Checking the whole map every time is too slow for large maps, so take the next slice of it every time. */
+	uint slice = (checksums->frame / SYNC_CHECK_INTERVAL) % SYNC_CHECK_MAP_SLICES;
+	TileIndex end = (TileIndex)((uint64)MapSize() * (slice + 1) / SYNC_CHECK_MAP_SLICES);
+	for (TileIndex t = (TileIndex)((uint64)MapSize() * slice / SYNC_CHECK_MAP_SLICES); t < end; t++) {
+		uint32 &checksum = checksums->checksum[SCP_MAP];
+		AddToChecksum(checksum, _m[t].type | _m[t].height << 8 | _m[t].m2 << 16);
+		AddToChecksum(checksum, _m[t].m1 | _m[t].m3 << 8 | _m[t].m4 << 16 | _m[t].m5 << 24);
+		AddToChecksum(checksum, _me[t].m6 | _me[t].m7 << 8 | _me[t].m8 << 16);
+	}
+}
+
+/**
+ * Get the name of a part of the game state, for the logs.
+ * @param part The part.
+ * @return The name.
+ */
+const char *GetSyncCheckPartName(SyncCheckPart part)
+{
+	static const char * const names[] = { "vehicles", "cargo", "stations", "companies", "map" };
+	assert_compile(lengthof(names) == SCP_END);
+
+	assert(part < SCP_END);
+	return names[part];
+}
+
+/** Make and remember the checksums of the game state after the current frame, for comparing with those of the clients. */
+void NetworkServerRecordSyncChecksums()
+{
+	CalculateSyncChecksums(&_sync_check_history[(_frame_counter / SYNC_CHECK_INTERVAL) % SYNC_CHECK_HISTORY]);
+}
+
+/**
+ * Get the checksums the server made after some frame.
+ * @param frame The frame.
+ * @return The checksums, or NULL when they were not made or are forgotten already.
+ */
+const SyncChecksums *NetworkServerGetSyncChecksums(uint32 frame)
+{
+	const SyncChecksums *checksums = &_sync_check_history[(frame / SYNC_CHECK_INTERVAL) % SYNC_CHECK_HISTORY];
+	return checksums->frame == frame ? checksums : NULL;
+}
+
+#endif /* ENABLE_NETWORK */
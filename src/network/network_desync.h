@@ -0,0 +1,61 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file network_desync.h Detecting desyncs by comparing checksums of parts of the game state. */
+
+#ifndef NETWORK_DESYNC_H
+#define NETWORK_DESYNC_H
+
+#ifdef ENABLE_NETWORK
+
+#include "../date_type.h"
+#include "../core/enum_type.hpp"
+
+/** The parts of the game state a checksum is made of. */
+enum SyncCheckPart {
+	SCP_BEGIN = 0,
+	SCP_VEHICLES = 0, ///< Position, speed and such of the vehicles.
+	SCP_CARGO,        ///< Cargo in vehicles and waiting at stations.
+	SCP_STATIONS,     ///< Layout and ratings of the stations.
+	SCP_COMPANIES,    ///< Finances of the companies.
+	SCP_MAP,          ///< A slice of the map; every check takes the next slice.
+	SCP_END,
+};
+DECLARE_POSTFIX_INCREMENT(SyncCheckPart)
+
+static const uint SYNC_CHECK_INTERVAL   = DAY_TICKS; ///< Number of frames between two checks of the game state.
+static const uint SYNC_CHECK_MAP_SLICES = 64;        ///< Number of slices the map is split in, of which one is checked every time.
+
+/** The checksums of the game state after some frame. */
+struct SyncChecksums {
+	uint32 frame;             ///< The frame after which the game state was checked.
+	Date date;                ///< The date of the frame.
+	DateFract date_fract;     ///< The fraction of the date of the frame.
+	uint32 checksum[SCP_END]; ///< The checksums of each part of the game state.
+};
+
+/**
+ * Check whether the game state should be checked after the current frame.
+ * @param frame The frame counter.
+ * @return True if it should.
+ */
+static inline bool IsSyncCheckFrame(uint32 frame)
+{
+	return frame % SYNC_CHECK_INTERVAL == 0;
+}
+
+void CalculateSyncChecksums(SyncChecksums *checksums);
+const char *GetSyncCheckPartName(SyncCheckPart part);
+
+void NetworkServerRecordSyncChecksums();
+const SyncChecksums *NetworkServerGetSyncChecksums(uint32 frame);
+
+#endif /* ENABLE_NETWORK */
+
+#endif /* NETWORK_DESYNC_H */
@@ -50,6 +50,8 @@ void NetworkBackgroundLoop();
 void ParseConnectionString(const char **company, const char **port, char *connection_string);
 void NetworkStartDebugLog(NetworkAddress address);
 void NetworkPopulateCompanyStats(NetworkCompanyStats *stats);
+void NetworkUDPInvalidateServerInfo();
+bool NetworkGetCatchUpProgress(uint *progress);
 
 void NetworkUpdateClientInfo(ClientID client_id);
 void NetworkClientsToSpectators(CompanyID cid);
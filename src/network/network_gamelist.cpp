@@ -204,6 +204,9 @@ void NetworkAfterNewGRFScan()
 		}
 	}
 
+	/* The NewGRFs we can tell querying clients the names of might have changed. */
+	NetworkUDPInvalidateServerInfo();
+
 	InvalidateWindowClassesData(WC_NETWORK_WINDOW);
 }
 
@@ -18,9 +18,11 @@
 #include "network_server.h"
 #include "network_udp.h"
 #include "network_base.h"
+#include "network_desync.h"
 #include "../console_func.h"
 #include "../company_base.h"
 #include "../command_func.h"
+#include "../tile_map.h"
 #include "../saveload/saveload.h"
 #include "../saveload/saveload_filter.h"
 #include "../station_base.h"
@@ -42,6 +44,9 @@ DECLARE_POSTFIX_INCREMENT(ClientID)
 /** The identifier counter for new clients (is never decreased) */
 static ClientID _network_client_id = CLIENT_ID_FIRST;
 
+/** The clients whose info changed since it was last sent to the clients and admins. */
+static SmallVector<ClientID, 8> _network_client_info_updates;
+
 /** Make very sure the preconditions given in network_type.h are actually followed */
 assert_compile(MAX_CLIENT_SLOTS > MAX_CLIENTS);
 /** Yes... */
@@ -225,6 +230,8 @@ ServerNetworkGameSocketHandler::ServerNetworkGameSocketHandler(SOCKET s) : Netwo
 	this->status = STATUS_INACTIVE;
 	this->client_id = _network_client_id++;
 	this->receive_limit = _settings_client.network.bytes_per_frame_burst;
+	this->command_limit = _settings_client.network.max_commands_in_queue;
+	this->dropping_commands = false;
 
 	/* The Socket and Info pools need to be the same in size. After all,
 	 * each Socket will be associated with at most one Info object. As
@@ -292,7 +299,10 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvSta
 	DEBUG(net, 1, "Closed client connection %d", this->client_id);
 
 	/* We just lost one client :( */
-	if (this->status >= STATUS_AUTHORIZED) _network_game_info.clients_on--;
+	if (this->status >= STATUS_AUTHORIZED) {
+		_network_game_info.clients_on--;
+		NetworkUDPInvalidateServerInfo();
+	}
 	extern byte _network_clients_connected;
 	_network_clients_connected--;
 
@@ -536,6 +546,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWelcome()
 	this->last_frame = this->last_frame_server = _frame_counter;
 
 	_network_game_info.clients_on++;
+	NetworkUDPInvalidateServerInfo();
 
 	p = new Packet(PACKET_SERVER_WELCOME);
 	p->Send_uint32(this->client_id);
@@ -740,6 +751,39 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommand(const CommandPacke
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/**
+ * Send all commands in the outgoing queue, packing the commands for the
+ * same frame into as few packets as possible.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommands()
+{
+	/* The largest a command can be in the packet: company, command, p1, p2, tile, text, callback and my_cmd. */
+	static const uint MAX_COMMAND_SIZE = 1 + 4 + 4 + 4 + 4 + lengthof(CommandPacket::text) + 1 + 1;
+
+	Packet *p = NULL;
+	uint32 frame = 0;
+
+	CommandPacket *cp;
+	while ((cp = this->outgoing_queue.Pop()) != NULL) {
+		if (p != NULL && (cp->frame != frame || p->size + MAX_COMMAND_SIZE >= SEND_MTU)) {
+			this->SendPacket(p);
+			p = NULL;
+		}
+		if (p == NULL) {
+			p = new Packet(PACKET_SERVER_COMMANDS);
+			frame = cp->frame;
+			p->Send_uint32(frame);
+		}
+
+		this->NetworkGameSocketHandler::SendCommand(p, cp);
+		p->Send_bool  (cp->my_cmd);
+		free(cp);
+	}
+
+	if (p != NULL) this->SendPacket(p);
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /**
  * Send a chat message.
  * @param action The action associated with the message.
@@ -1096,6 +1140,18 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_COMMAND(Packet
 		return this->SendError(NETWORK_ERROR_TOO_MANY_COMMANDS);
 	}
 
+	/* Commands beyond the rate a client may send them at are dropped before
+	 * they are even decoded, so they do not reach the other clients either. */
+	if (this->command_limit <= 0) {
+		if (!this->dropping_commands) {
+			IConsolePrintF(CC_WARNING, "WARNING: client %d (IP: %s) sends commands too fast, ignoring some of them.", this->client_id, this->GetClientIP());
+			this->dropping_commands = true;
+		}
+		return NETWORK_RECV_STATUS_OKAY;
+	}
+	this->command_limit--;
+	this->dropping_commands = false;
+
 	CommandPacket cp;
 	const char *err = this->ReceiveCommand(p, &cp);
 
@@ -1103,6 +1159,12 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_COMMAND(Packet
 
 	NetworkClientInfo *ci = this->GetInfo();
 
+	/* Clients test their commands before sending them, so a tile no command may
+	 * be executed on means a modified client; don't let it cost everyone a command test. */
+	if (err == NULL && cp.tile != 0 && (cp.tile >= MapSize() || (!IsValidTile(cp.tile) && (GetCommandFlags(cp.cmd) & CMD_ALL_TILES) == 0))) {
+		err = "invalid tile";
+	}
+
 	if (err != NULL) {
 		IConsolePrintF(CC_ERROR, "WARNING: %s from client %d (IP: %s).", err, ci->client_id, this->GetClientIP());
 		return this->SendError(NETWORK_ERROR_NOT_EXPECTED);
@@ -1254,6 +1316,35 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_ACK(Packet *p)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_SYNC_CHECK(Packet *p)
+{
+	if (this->status < STATUS_AUTHORIZED) {
+		/* Illegal call, return error and ignore the packet */
+		return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
+	}
+
+	uint32 frame = p->Recv_uint32();
+	uint32 checksum[SCP_END];
+	for (SyncCheckPart part = SCP_BEGIN; part < SCP_END; part++) checksum[part] = p->Recv_uint32();
+
+	/* We can only compare with checksums we still know. */
+	const SyncChecksums *checksums = NetworkServerGetSyncChecksums(frame);
+	if (checksums == NULL) return NETWORK_RECV_STATUS_OKAY;
+
+	bool in_sync = true;
+	for (SyncCheckPart part = SCP_BEGIN; part < SCP_END; part++) {
+		if (checksum[part] == checksums->checksum[part]) continue;
+
+		DEBUG(desync, 0, "sync check: client %d; %08x; %02x; %s differ; last match at frame %d, now frame %d", this->client_id, checksums->date, checksums->date_fract, GetSyncCheckPartName(part), this->last_sync_check, frame);
+		in_sync = false;
+	}
+
+	if (!in_sync) return this->SendError(NETWORK_ERROR_DESYNC);
+
+	this->last_sync_check = frame;
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 
 /**
  * Send an actual chat message.
@@ -1602,18 +1693,36 @@ void NetworkPopulateCompanyStats(NetworkCompanyStats *stats)
  */
 void NetworkUpdateClientInfo(ClientID client_id)
 {
-	NetworkClientSocket *cs;
 	NetworkClientInfo *ci = NetworkClientInfo::GetByClientID(client_id);
 
 	if (ci == NULL) return;
 
 	DEBUG(desync, 1, "client: %08x; %02x; %02x; %04x", _date, _date_fract, (int)ci->client_playas, client_id);
 
-	FOR_ALL_CLIENT_SOCKETS(cs) {
-		cs->SendClientInfo(ci);
-	}
+	/* The info is sent with the next frame, once however often it changed until then. */
+	_network_client_info_updates.Include(client_id);
+	NetworkUDPInvalidateServerInfo();
+}
+
+/**
+ * Send the info of the clients that changed since the last frame to all clients and admins.
+ * Coalescing the updates keeps e.g. a client joining and being moved to its company from
+ * costing two broadcasts, which adds up when many clients join at once.
+ */
+static void NetworkSendClientInfoUpdates()
+{
+	for (const ClientID *id = _network_client_info_updates.Begin(); id != _network_client_info_updates.End(); id++) {
+		NetworkClientInfo *ci = NetworkClientInfo::GetByClientID(*id);
+		if (ci == NULL) continue;
 
-	NetworkAdminClientUpdate(ci);
+		NetworkClientSocket *cs;
+		FOR_ALL_CLIENT_SOCKETS(cs) {
+			cs->SendClientInfo(ci);
+		}
+
+		NetworkAdminClientUpdate(ci);
+	}
+	_network_client_info_updates.Clear();
 }
 
 /** Check if we want to restart the map */
@@ -1791,6 +1900,11 @@ void NetworkServerSetCompanyPassword(CompanyID company_id, const char *password,
  */
 static void NetworkHandleCommandQueue(NetworkClientSocket *cs)
 {
+	if (_settings_client.network.command_batching) {
+		cs->SendCommands();
+		return;
+	}
+
 	CommandPacket *cp;
 	while ((cp = cs->outgoing_queue.Pop()) != NULL) {
 		cs->SendCommand(cp);
@@ -1809,6 +1923,8 @@ void NetworkServer_Tick(bool send_frame)
 	bool send_sync = false;
 #endif
 
+	NetworkSendClientInfoUpdates();
+
 #ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
 	if (_frame_counter >= _last_sync_frame + _settings_client.network.sync_freq) {
 		_last_sync_frame = _frame_counter;
@@ -1824,6 +1940,10 @@ void NetworkServer_Tick(bool send_frame)
 		cs->receive_limit = min(cs->receive_limit + _settings_client.network.bytes_per_frame,
 				_settings_client.network.bytes_per_frame_burst);
 
+		/* Commands are accepted at the rate they are distributed, with bursts up to the size of the queue. */
+		cs->command_limit = min(cs->command_limit + _settings_client.network.commands_per_frame,
+				(int)_settings_client.network.max_commands_in_queue);
+
 		/* Check if the speed of the client is what we can expect from a client */
 		uint lag = NetworkCalculateLag(cs);
 		switch (cs->status) {
@@ -1939,6 +2059,7 @@ void NetworkServerMonthlyLoop()
 {
 	NetworkAutoCleanCompanies();
 	NetworkAdminUpdate(ADMIN_FREQUENCY_MONTHLY);
+	DebugPacketBufferPoolStats();
 	if ((_cur_month % 3) == 0) NetworkAdminUpdate(ADMIN_FREQUENCY_QUARTERLY);
 }
 
@@ -2020,6 +2141,7 @@ void NetworkServerUpdateCompanyPassworded(CompanyID company_id, bool passworded)
 	}
 
 	NetworkAdminCompanyUpdate(Company::GetIfValid(company_id));
+	NetworkUDPInvalidateServerInfo();
 }
 
 /**
@@ -2198,6 +2320,7 @@ void NetworkServerNewCompany(const Company *c, NetworkClientInfo *ci)
 
 	/* Announce new company on network. */
 	NetworkAdminCompanyInfo(c, true);
+	NetworkUDPInvalidateServerInfo();
 
 	if (ci != NULL) {
 		/* ci is NULL when replaying, or for AIs. In neither case there is a client.
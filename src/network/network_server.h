@@ -35,6 +35,7 @@ protected:
 	virtual NetworkRecvStatus Receive_CLIENT_GETMAP(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_MAP_OK(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_ACK(Packet *p);
+	virtual NetworkRecvStatus Receive_CLIENT_SYNC_CHECK(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_COMMAND(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_CHAT(Packet *p);
 	virtual NetworkRecvStatus Receive_CLIENT_SET_PASSWORD(Packet *p);
@@ -71,9 +72,12 @@ public:
 	byte lag_test;               ///< Byte used for lag-testing the client
 	byte last_token;             ///< The last random token we did send to verify the client is listening
 	uint32 last_token_frame;     ///< The last frame we received the right token
+	uint32 last_sync_check;      ///< The last frame after which the game state of the client matched ours
 	ClientStatus status;         ///< Status of this client
 	CommandQueue outgoing_queue; ///< The command-queue awaiting delivery
 	int receive_limit;           ///< Amount of bytes that we can receive at this moment
+	int command_limit;           ///< Amount of commands that we accept at this moment
+	bool dropping_commands;      ///< Whether the last command was dropped for exceeding #command_limit
 
 	struct PacketWriter *savegame; ///< Writer used to write the savegame.
 	NetworkAddress client_address; ///< IP-address of the client (so he can be banned)
@@ -100,6 +104,7 @@ public:
 	NetworkRecvStatus SendFrame();
 	NetworkRecvStatus SendSync();
 	NetworkRecvStatus SendCommand(const CommandPacket *cp);
+	NetworkRecvStatus SendCommands();
 	NetworkRecvStatus SendCompanyUpdate();
 	NetworkRecvStatus SendConfigUpdate();
 
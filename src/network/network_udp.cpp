@@ -31,6 +31,7 @@
 #include "../newgrf_text.h"
 #include "../strings_func.h"
 #include "table/strings.h"
+#include "../core/flatmap_type.hpp"
 
 #include "core/udp.h"
 
@@ -147,8 +148,94 @@ void MasterNetworkUDPSocketHandler::Receive_MASTER_SESSION_KEY(Packet *p, Networ
 
 ///*** Communication with clients (we are server) ***/
 
+static const uint32 QUERY_RATE_INTERVAL = 1000; ///< length of the interval in ms in which the queries of one source are counted
+static const uint QUERY_RATE_LIMIT      =   10; ///< number of queries one source may do per interval; the rest is ignored
+static const uint QUERY_MAX_SOURCES     = 1024; ///< number of sources the query rates are remembered of
+
+/** Version of the information sent to querying clients; changed whenever that information changes. */
+static uint32 _server_info_version = 0;
+
+/**
+ * Mark the information sent as reply to server queries as changed, so the
+ * cached replies are made again from the game state on the next query.
+ */
+void NetworkUDPInvalidateServerInfo()
+{
+	_server_info_version++;
+}
+
+/** A reply to a query that is sent again to other clients until the information in it changes. */
+struct CachedReply {
+	Packet *packet; ///< The reply, or NULL when there is none yet.
+	uint32 version; ///< The #_server_info_version when the reply was made.
+	Date date;      ///< The game date when the reply was made.
+
+	CachedReply() : packet(NULL), version(0), date(0) {}
+	~CachedReply() { delete this->packet; }
+
+	/**
+	 * Check whether the reply still contains the current information.
+	 * @return True if the reply can be sent.
+	 */
+	inline bool IsValid() const
+	{
+		return this->packet != NULL && this->version == _server_info_version && this->date == _date;
+	}
+
+	/**
+	 * Replace the reply by a newly made one.
+	 * @param p The new reply.
+	 */
+	void Update(Packet *p)
+	{
+		delete this->packet;
+		this->packet = p;
+		this->version = _server_info_version;
+		this->date = _date;
+	}
+};
+
+/** The address of a source of queries, without the port so changing the port doesn't evade the rate limit. */
+struct QuerySource {
+	byte family;   ///< The address family.
+	byte addr[16]; ///< The address itself; the part not used by the family is zero.
+
+	QuerySource(NetworkAddress *address)
+	{
+		const sockaddr_storage *sa = address->GetAddress();
+		MemSetT(this->addr, 0, lengthof(this->addr));
+		this->family = (byte)sa->ss_family;
+		if (sa->ss_family == AF_INET) {
+			MemCpyT(this->addr, (const byte *)&((const sockaddr_in *)sa)->sin_addr, sizeof(in_addr));
+		} else if (sa->ss_family == AF_INET6) {
+			MemCpyT(this->addr, (const byte *)&((const sockaddr_in6 *)sa)->sin6_addr, sizeof(in6_addr));
+		}
+	}
+
+	inline bool operator<(const QuerySource &other) const
+	{
+		if (this->family != other.family) return this->family < other.family;
+		return memcmp(this->addr, other.addr, sizeof(this->addr)) < 0;
+	}
+};
+
+/** The queries done by one source in the current interval. */
+struct QueryRate {
+	uint32 start; ///< Real time tick the interval started at.
+	uint count;   ///< Number of queries in the interval.
+};
+
 /** Helper class for handling all server side communication. */
 class ServerNetworkUDPSocketHandler : public NetworkUDPSocketHandler {
+	FlatMap<QuerySource, QueryRate> query_rates; ///< The query rates of the recent sources of queries.
+	CachedReply server_response;                 ///< Cached #PACKET_UDP_SERVER_RESPONSE.
+	CachedReply detail_info;                     ///< Cached #PACKET_UDP_SERVER_DETAIL_INFO.
+	CachedReply newgrfs;                         ///< Cached #PACKET_UDP_SERVER_NEWGRFS for #newgrfs_request.
+	byte newgrfs_request[SEND_MTU];              ///< The contents of the request #newgrfs is the reply to.
+	size_t newgrfs_request_length;               ///< The length of #newgrfs_request.
+
+	bool AllowQuery(NetworkAddress *client_addr);
+
 protected:
 	virtual void Receive_CLIENT_FIND_SERVER(Packet *p, NetworkAddress *client_addr);
 	virtual void Receive_CLIENT_DETAIL_INFO(Packet *p, NetworkAddress *client_addr);
@@ -158,10 +245,42 @@ public:
 	 * Create the socket.
 	 * @param addresses The addresses to bind on.
 	 */
-	ServerNetworkUDPSocketHandler(NetworkAddressList *addresses) : NetworkUDPSocketHandler(addresses) {}
+	ServerNetworkUDPSocketHandler(NetworkAddressList *addresses) : NetworkUDPSocketHandler(addresses), newgrfs_request_length(0) {}
 	virtual ~ServerNetworkUDPSocketHandler() {}
 };
 
+/**
+ * Count a query of a client and check whether it may be answered. Every source
+ * may do a limited number of queries per interval, so flooding the server with
+ * queries does not take time away from the game loop.
+ * @param client_addr The address the query came from.
+ * @return True if the query should be answered.
+ */
+bool ServerNetworkUDPSocketHandler::AllowQuery(NetworkAddress *client_addr)
+{
+	if (this->query_rates.size() >= QUERY_MAX_SOURCES) {
+		/* Forget the sources whose interval has passed. */
+		FlatMap<QuerySource, QueryRate> recent;
+		for (FlatMap<QuerySource, QueryRate>::iterator it = this->query_rates.begin(); it != this->query_rates.end(); it++) {
+			if (_realtime_tick - it->second.start < QUERY_RATE_INTERVAL) recent.insert(*it);
+		}
+		/* Too many sources at once to keep track of; start over. */
+		if (recent.size() >= QUERY_MAX_SOURCES) recent.clear();
+		this->query_rates.swap(recent);
+	}
+
+	QueryRate &rate = this->query_rates[QuerySource(client_addr)];
+	if (rate.count == 0 || _realtime_tick - rate.start >= QUERY_RATE_INTERVAL) {
+		rate.start = _realtime_tick;
+		rate.count = 0;
+	}
+
+	if (++rate.count <= QUERY_RATE_LIMIT) return true;
+
+	if (rate.count == QUERY_RATE_LIMIT + 1) DEBUG(net, 3, "[udp] ignoring queries from %s; too many queries", client_addr->GetHostname());
+	return false;
+}
+
 void ServerNetworkUDPSocketHandler::Receive_CLIENT_FIND_SERVER(Packet *p, NetworkAddress *client_addr)
 {
 	/* Just a fail-safe.. should never happen */
@@ -169,6 +288,14 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_FIND_SERVER(Packet *p, Networ
 		return;
 	}
 
+	if (!this->AllowQuery(client_addr)) return;
+
+	if (this->server_response.IsValid()) {
+		this->SendPacket(this->server_response.packet, client_addr);
+		DEBUG(net, 2, "[udp] queried from %s", client_addr->GetHostname());
+		return;
+	}
+
 	NetworkGameInfo ngi;
 
 	/* Update some game_info */
@@ -193,11 +320,12 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_FIND_SERVER(Packet *p, Networ
 	strecpy(ngi.server_name, _settings_client.network.server_name, lastof(ngi.server_name));
 	strecpy(ngi.server_revision, GetNetworkRevisionString(), lastof(ngi.server_revision));
 
-	Packet packet(PACKET_UDP_SERVER_RESPONSE);
-	this->SendNetworkGameInfo(&packet, &ngi);
+	Packet *packet = new Packet(PACKET_UDP_SERVER_RESPONSE);
+	this->SendNetworkGameInfo(packet, &ngi);
+	this->server_response.Update(packet);
 
 	/* Let the client know that we are here */
-	this->SendPacket(&packet, client_addr);
+	this->SendPacket(packet, client_addr);
 
 	DEBUG(net, 2, "[udp] queried from %s", client_addr->GetHostname());
 }
@@ -207,11 +335,19 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_DETAIL_INFO(Packet *p, Networ
 	/* Just a fail-safe.. should never happen */
 	if (!_network_udp_server) return;
 
-	Packet packet(PACKET_UDP_SERVER_DETAIL_INFO);
+	if (!this->AllowQuery(client_addr)) return;
+
+	/* The statistics of the companies are refreshed daily. */
+	if (this->detail_info.IsValid()) {
+		this->SendPacket(this->detail_info.packet, client_addr);
+		return;
+	}
+
+	Packet *packet = new Packet(PACKET_UDP_SERVER_DETAIL_INFO);
 
 	/* Send the amount of active companies */
-	packet.Send_uint8 (NETWORK_COMPANY_INFO_VERSION);
-	packet.Send_uint8 ((uint8)Company::GetNumItems());
+	packet->Send_uint8 (NETWORK_COMPANY_INFO_VERSION);
+	packet->Send_uint8 ((uint8)Company::GetNumItems());
 
 	/* Fetch the latest version of the stats */
 	NetworkCompanyStats company_stats[MAX_COMPANIES];
@@ -221,15 +357,15 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_DETAIL_INFO(Packet *p, Networ
 	static const uint MIN_CI_SIZE = 54;
 	uint max_cname_length = NETWORK_COMPANY_NAME_LENGTH;
 
-	if (Company::GetNumItems() * (MIN_CI_SIZE + NETWORK_COMPANY_NAME_LENGTH) >= (uint)SEND_MTU - packet.size) {
+	if (Company::GetNumItems() * (MIN_CI_SIZE + NETWORK_COMPANY_NAME_LENGTH) >= (uint)SEND_MTU - packet->size) {
 		/* Assume we can at least put the company information in the packets. */
-		assert(Company::GetNumItems() * MIN_CI_SIZE < (uint)SEND_MTU - packet.size);
+		assert(Company::GetNumItems() * MIN_CI_SIZE < (uint)SEND_MTU - packet->size);
 
 		/* At this moment the company names might not fit in the
 		 * packet. Check whether that is really the case. */
 
 		for (;;) {
-			int free = SEND_MTU - packet.size;
+			int free = SEND_MTU - packet->size;
 			Company *company;
 			FOR_ALL_COMPANIES(company) {
 				char company_name[NETWORK_COMPANY_NAME_LENGTH];
@@ -250,10 +386,11 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_DETAIL_INFO(Packet *p, Networ
 	/* Go through all the companies */
 	FOR_ALL_COMPANIES(company) {
 		/* Send the information */
-		this->SendCompanyInformation(&packet, company, &company_stats[company->index], max_cname_length);
+		this->SendCompanyInformation(packet, company, &company_stats[company->index], max_cname_length);
 	}
 
-	this->SendPacket(&packet, client_addr);
+	this->detail_info.Update(packet);
+	this->SendPacket(packet, client_addr);
 }
 
 /**
@@ -280,6 +417,17 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_GET_NEWGRFS(Packet *p, Networ
 
 	DEBUG(net, 6, "[udp] newgrf data request from %s", client_addr->GetAddressAsString());
 
+	if (!this->AllowQuery(client_addr)) return;
+
+	/* Clients mostly ask for the NewGRFs of this server, so the request is often the same as the previous one. */
+	const byte *request = p->buffer + p->pos;
+	size_t request_length = p->size - p->pos;
+	if (this->newgrfs.version == _server_info_version && request_length == this->newgrfs_request_length &&
+			memcmp(request, this->newgrfs_request, request_length) == 0) {
+		if (this->newgrfs.packet != NULL) this->SendPacket(this->newgrfs.packet, client_addr);
+		return;
+	}
+
 	num_grfs = p->Recv_uint8 ();
 	if (num_grfs > NETWORK_MAX_GRF_COUNT) return;
 
@@ -305,20 +453,26 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_GET_NEWGRFS(Packet *p, Networ
 		in_reply_count++;
 	}
 
-	if (in_reply_count == 0) return;
+	MemCpyT(this->newgrfs_request, request, request_length);
+	this->newgrfs_request_length = request_length;
+	if (in_reply_count == 0) {
+		this->newgrfs.Update(NULL);
+		return;
+	}
 
-	Packet packet(PACKET_UDP_SERVER_NEWGRFS);
-	packet.Send_uint8(in_reply_count);
+	Packet *packet = new Packet(PACKET_UDP_SERVER_NEWGRFS);
+	packet->Send_uint8(in_reply_count);
 	for (i = 0; i < in_reply_count; i++) {
 		char name[NETWORK_GRF_NAME_LENGTH];
 
 		/* The name could be an empty string, if so take the filename */
 		strecpy(name, in_reply[i]->GetName(), lastof(name));
-		this->SendGRFIdentifier(&packet, &in_reply[i]->ident);
-		packet.Send_string(name);
+		this->SendGRFIdentifier(packet, &in_reply[i]->ident);
+		packet->Send_string(name);
 	}
 
-	this->SendPacket(&packet, client_addr);
+	this->newgrfs.Update(packet);
+	this->SendPacket(packet, client_addr);
 }
 
 ///*** Communication with servers (we are client) ***/
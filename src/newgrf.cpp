@@ -49,6 +49,8 @@
 #include "vehicle_func.h"
 #include "language.h"
 #include "vehicle_base.h"
+#include "thread/thread_pool.h"
+#include <vector>
 
 #include "table/strings.h"
 #include "table/build_industry.h"
@@ -4869,6 +4871,8 @@ static void NewSpriteGroup(ByteReader *buf)
 				group->ranges = MallocT<DeterministicSpriteGroupRange>(group->num_ranges);
 				MemCpyT(group->ranges, &optimised.front(), group->num_ranges);
 			}
+
+			group->Optimise();
 			break;
 		}
 
@@ -8318,6 +8322,7 @@ void ResetNewGRFData()
 
 	InitializeSoundPool();
 	_spritegroup_pool.CleanPool();
+	ClearCallbackMemo();
 }
 
 /**
@@ -8909,8 +8914,10 @@ static void FinaliseAirportsArray()
  * partial implementation yet).
  * XXX: We consider GRF files trusted. It would be trivial to exploit OTTD by
  * a crafted invalid GRF file. We should tell that to the user somehow, or
- * better make this more robust in the future. */
-static void DecodeSpecialSprite(byte *buf, uint num, GrfLoadingStage stage)
+ * better make this more robust in the future.
+ * When \a content is given, the sprite was read ahead by PrepareNewGRFFiles
+ * and the file is positioned behind it already. */
+static void DecodeSpecialSprite(byte *buf, uint num, GrfLoadingStage stage, byte *content = NULL)
 {
 	/* XXX: There is a difference between staged loading in TTDPatch and
 	 * here.  In TTDPatch, for some reason actions 1 and 2 are carried out
@@ -8952,16 +8959,21 @@ static void DecodeSpecialSprite(byte *buf, uint num, GrfLoadingStage stage)
 
 	GRFLineToSpriteOverride::iterator it = _grf_line_to_action6_sprite_override.find(location);
 	if (it == _grf_line_to_action6_sprite_override.end()) {
-		/* No preloaded sprite to work with; read the
-		 * pseudo sprite content. */
-		FioReadBlock(buf, num);
+		if (content != NULL) {
+			/* The content was read ahead by PrepareNewGRFFiles. */
+			buf = content;
+		} else {
+			/* No preloaded sprite to work with; read the
+			 * pseudo sprite content. */
+			FioReadBlock(buf, num);
+		}
 	} else {
 		/* Use the preloaded sprite data. */
 		buf = _grf_line_to_action6_sprite_override[location];
 		grfmsg(7, "DecodeSpecialSprite: Using preloaded pseudo sprite data");
 
 		/* Skip the real (original) content of this action. */
-		FioSeekTo(num, SEEK_CUR);
+		if (content == NULL) FioSeekTo(num, SEEK_CUR);
 	}
 
 	ByteReader br(buf, buf + num);
@@ -9015,6 +9027,306 @@ byte GetGRFContainerVersion()
 	return 1;
 }
 
+/** A sprite of a NewGRF file, as found by #PrepareNewGRFFiles. */
+struct GRFPreparedSprite {
+	size_t pos;     ///< Position in the file of the header of the sprite.
+	size_t next;    ///< Position in the file of the header of the next sprite.
+	uint32 num;     ///< Size of the sprite, as in its header; 0 for the end marker.
+	byte type;      ///< Type of the sprite, as in its header; 0xFF for pseudo sprites.
+	size_t content; ///< For pseudo sprites, the offset of their content in #GRFPreparedFile::content.
+};
+
+/**
+ * The layout of the sprites of a NewGRF file and the content of its pseudo
+ * sprites, read ahead of the loading stages. Every stage processes the
+ * pseudo sprites again, but the file does not have to be read again.
+ */
+struct GRFPreparedFile {
+	const GRFConfig *config;                ///< The NewGRF.
+	Subdirectory subdir;                    ///< The sub directory the file was found in.
+	FILE *handle;                           ///< The file while it is being prepared.
+	size_t end;                             ///< End position of the file.
+	std::vector<GRFPreparedSprite> sprites; ///< The sprites after the sprite count, ordered by their position.
+	std::vector<byte> content;              ///< The content of all pseudo sprites.
+	size_t next_sprite;                     ///< Index of the sprite that likely comes next when loading the file.
+
+	/**
+	 * Find the sprite at a position of the file.
+	 * @param pos Position of the header of the sprite.
+	 * @return The sprite, or \c NULL if there is none, e.g. when a broken file ended early.
+	 */
+	const GRFPreparedSprite *Find(size_t pos)
+	{
+		if (this->next_sprite >= this->sprites.size() || this->sprites[this->next_sprite].pos != pos) {
+			/* Something skipped or jumped to other sprites. */
+			GRFPreparedSprite key;
+			key.pos = pos;
+			std::vector<GRFPreparedSprite>::const_iterator it = std::lower_bound(this->sprites.begin(), this->sprites.end(), key,
+					[](const GRFPreparedSprite &a, const GRFPreparedSprite &b) { return a.pos < b.pos; });
+			if (it == this->sprites.end() || it->pos != pos) return NULL;
+			this->next_sprite = it - this->sprites.begin();
+		}
+		return &this->sprites[this->next_sprite++];
+	}
+};
+
+static std::vector<GRFPreparedFile *> _grf_prepared_files; ///< The NewGRFs read ahead by #PrepareNewGRFFiles.
+
+/** Buffered reader of a file on a worker thread, as the Fio functions may only be used by the main thread. */
+class GRFPrepareReader {
+	FILE *f;          ///< The file.
+	size_t pos;       ///< Position in the file of the end of the buffer.
+	size_t end;       ///< End of the data that may be read.
+	byte buffer[4096]; ///< Data read from the file.
+	byte *buffer_pos; ///< Next byte of the buffer to read.
+	byte *buffer_end; ///< End of the valid data of the buffer.
+
+public:
+	bool eof; ///< Whether more was read than there is.
+
+	GRFPrepareReader(FILE *f, size_t pos, size_t end) : f(f), pos(pos), end(end), buffer_pos(buffer), buffer_end(buffer), eof(false) {}
+
+	/**
+	 * Get the position in the file.
+	 * @return The position of the next byte to read.
+	 */
+	size_t GetPos() const
+	{
+		return this->pos - (this->buffer_end - this->buffer_pos);
+	}
+
+	byte ReadByte()
+	{
+		if (this->buffer_pos == this->buffer_end) {
+			size_t len = fread(this->buffer, 1, min<size_t>(sizeof(this->buffer), this->end - this->pos), this->f);
+			this->pos += len;
+			this->buffer_pos = this->buffer;
+			this->buffer_end = this->buffer + len;
+			if (len == 0) {
+				this->eof = true;
+				return 0;
+			}
+		}
+		return *this->buffer_pos++;
+	}
+
+	uint16 ReadWord()
+	{
+		uint16 b = this->ReadByte();
+		return (this->ReadByte() << 8) | b;
+	}
+
+	uint32 ReadDword()
+	{
+		uint32 b = this->ReadWord();
+		return (this->ReadWord() << 16) | b;
+	}
+
+	/**
+	 * Copy data from the file.
+	 * @param ptr Destination of the data.
+	 * @param size Number of bytes.
+	 */
+	void ReadBlock(byte *ptr, size_t size)
+	{
+		size_t buffered = min<size_t>(size, this->buffer_end - this->buffer_pos);
+		memcpy(ptr, this->buffer_pos, buffered);
+		this->buffer_pos += buffered;
+		size -= buffered;
+		if (size == 0) return;
+
+		size_t len = fread(ptr + buffered, 1, min(size, this->end - this->pos), this->f);
+		this->pos += len;
+		if (len != size) this->eof = true;
+	}
+
+	/**
+	 * Continue reading at another position of the file.
+	 * @param pos The new position.
+	 * @return True if seeking succeeded.
+	 */
+	bool SeekTo(size_t pos)
+	{
+		if (fseek(this->f, (long)pos, SEEK_SET) < 0) return false;
+		this->pos = pos;
+		this->buffer_pos = this->buffer_end = this->buffer;
+		return true;
+	}
+
+	/**
+	 * Skip data of the file.
+	 * @param size Number of bytes.
+	 */
+	void Skip(size_t size)
+	{
+		size_t buffered = min<size_t>(size, this->buffer_end - this->buffer_pos);
+		this->buffer_pos += buffered;
+		size -= buffered;
+		if (size == 0) return;
+
+		if (size > this->end - this->pos || fseek(this->f, (long)(this->pos + size), SEEK_SET) < 0) {
+			this->eof = true;
+			return;
+		}
+		this->pos += size;
+	}
+
+	/**
+	 * Skip the data of a real sprite of a container version 1 file, like #SkipSpriteData.
+	 * @param type The type of the sprite.
+	 * @param num Size of the data of the sprite.
+	 */
+	void SkipSpriteData(byte type, uint16 num)
+	{
+		if (type & 2) {
+			this->Skip(num);
+			return;
+		}
+		while (num > 0 && !this->eof) {
+			int8 i = this->ReadByte();
+			if (i >= 0) {
+				int size = (i == 0) ? 0x80 : i;
+				if (size > num) return;
+				num -= size;
+				this->Skip(size);
+			} else {
+				i = -(i >> 3);
+				num -= i;
+				this->ReadByte();
+			}
+		}
+	}
+};
+
+/**
+ * Find the sprites of a NewGRF file and read its pseudo sprites, like
+ * #LoadNewGRFFile walks through it. Files it cannot make sense of are left
+ * for #LoadNewGRFFile to report.
+ * @param file The file to prepare.
+ */
+static void PrepareNewGRFFile(GRFPreparedFile *file)
+{
+	long start = ftell(file->handle);
+	if (start < 0) return;
+	GRFPrepareReader reader(file->handle, start, file->end);
+
+	byte container_ver = 1;
+	if (reader.ReadWord() == 0) {
+		for (uint i = 0; i < lengthof(_grf_cont_v2_sig); i++) {
+			if (reader.ReadByte() != _grf_cont_v2_sig[i]) return;
+		}
+		container_ver = 2;
+
+		/* Sprite section offset and compression. */
+		reader.ReadDword();
+		if (reader.ReadByte() != 0) return;
+	} else {
+		/* Container version 1 has no header, rewind to start. */
+		if (!reader.SeekTo(start)) return;
+	}
+
+	/* The sprite with the number of sprites. */
+	uint32 num = container_ver >= 2 ? reader.ReadDword() : reader.ReadWord();
+	if (num != 4 || reader.ReadByte() != 0xFF) return;
+	reader.ReadDword();
+
+	while (!reader.eof) {
+		GRFPreparedSprite sprite;
+		sprite.pos = reader.GetPos();
+		sprite.num = container_ver >= 2 ? reader.ReadDword() : reader.ReadWord();
+		sprite.type = 0;
+		sprite.content = 0;
+		if (sprite.num != 0) {
+			sprite.type = reader.ReadByte();
+			if (sprite.type == 0xFF) {
+				sprite.content = file->content.size();
+				file->content.resize(file->content.size() + sprite.num);
+				reader.ReadBlock(&file->content[sprite.content], sprite.num);
+			} else if (container_ver >= 2 && sprite.type == 0xFD) {
+				reader.Skip(sprite.num);
+			} else {
+				reader.Skip(7);
+				reader.SkipSpriteData(sprite.type, sprite.num - 8);
+			}
+		}
+		if (reader.eof) break;
+
+		sprite.next = reader.GetPos();
+		file->sprites.push_back(sprite);
+		if (sprite.num == 0) break;
+	}
+}
+
+/**
+ * Prepare a range of NewGRF files on a worker thread.
+ * @param data The files.
+ * @param first First file to prepare.
+ * @param last One past the last file to prepare.
+ */
+static void PrepareNewGRFFilesProc(void *data, uint first, uint last)
+{
+	GRFPreparedFile **files = (GRFPreparedFile **)data;
+	for (uint i = first; i < last; i++) PrepareNewGRFFile(files[i]);
+}
+
+/**
+ * Read the sprite layout and pseudo sprites of all NewGRFs to load ahead of
+ * the loading stages, in parallel on the worker threads. The actions of the
+ * pseudo sprites are then processed in order by #LoadNewGRFFile.
+ * @param num_baseset Number of NewGRFs of the base set at the start of the configuration.
+ */
+static void PrepareNewGRFFiles(uint num_baseset)
+{
+	uint index = 0;
+	for (const GRFConfig *c = _grfconfig; c != NULL; c = c->next) {
+		if (c->status == GCS_DISABLED || c->status == GCS_NOT_FOUND) continue;
+
+		GRFPreparedFile *file = new GRFPreparedFile();
+		file->config = c;
+		file->subdir = index++ < num_baseset ? BASESET_DIR : NEWGRF_DIR;
+		file->next_sprite = 0;
+		size_t size;
+		file->handle = FioFOpenFile(c->filename, "rb", file->subdir, &size);
+		if (file->handle == NULL) {
+			delete file;
+			continue;
+		}
+		long start = ftell(file->handle);
+		file->end = start < 0 ? 0 : start + size;
+		_grf_prepared_files.push_back(file);
+	}
+	if (_grf_prepared_files.empty()) return;
+
+	InitThreadPool();
+	ThreadPoolParallelFor(&PrepareNewGRFFilesProc, &_grf_prepared_files[0], (uint)_grf_prepared_files.size(), 1);
+
+	for (std::vector<GRFPreparedFile *>::iterator it = _grf_prepared_files.begin(); it != _grf_prepared_files.end(); it++) {
+		FioFCloseFile((*it)->handle);
+		(*it)->handle = NULL;
+	}
+}
+
+/** Free the NewGRFs read ahead by #PrepareNewGRFFiles. */
+static void ClearPreparedNewGRFFiles()
+{
+	for (std::vector<GRFPreparedFile *>::iterator it = _grf_prepared_files.begin(); it != _grf_prepared_files.end(); it++) delete *it;
+	_grf_prepared_files.clear();
+}
+
+/**
+ * Get the NewGRF file read ahead by #PrepareNewGRFFiles.
+ * @param config The NewGRF.
+ * @param subdir The sub directory it is loaded from.
+ * @return The prepared file, or \c NULL if it was not prepared.
+ */
+static GRFPreparedFile *GetPreparedNewGRFFile(const GRFConfig *config, Subdirectory subdir)
+{
+	for (std::vector<GRFPreparedFile *>::iterator it = _grf_prepared_files.begin(); it != _grf_prepared_files.end(); it++) {
+		if ((*it)->config == config && (*it)->subdir == subdir) return *it;
+	}
+	return NULL;
+}
+
 /**
  * Load a particular NewGRF.
  * @param config     The configuration of the to be loaded NewGRF.
@@ -9095,14 +9407,50 @@ void LoadNewGRFFile(GRFConfig *config, uint file_index, GrfLoadingStage stage, S
 	_cur.ClearDataForNextFile();
 
 	ReusableBuffer<byte> buf;
+	GRFPreparedFile *prepared = GetPreparedNewGRFFile(config, subdir);
+	if (prepared != NULL) prepared->next_sprite = 0;
+	/* Position of the next sprite; the file is only kept there when it is actually read. */
+	size_t pos = FioGetPos();
 
-	while ((num = (_cur.grf_container_ver >= 2 ? FioReadDword() : FioReadWord())) != 0) {
-		byte type = FioReadByte();
+	for (;;) {
+		/* Take the sprite from the file read ahead if possible, and only
+		 * touch the file when an action needs it. */
+		const GRFPreparedSprite *sprite = prepared != NULL ? prepared->Find(pos) : NULL;
+		byte type;
+		if (sprite != NULL) {
+			num = sprite->num;
+			if (num == 0) break;
+			type = sprite->type;
+			pos = sprite->next;
+		} else {
+			if (FioGetPos() != pos) FioSeekTo(pos, SEEK_SET);
+			num = _cur.grf_container_ver >= 2 ? FioReadDword() : FioReadWord();
+			if (num == 0) break;
+			type = FioReadByte();
+		}
 		_cur.nfo_line++;
 
-		if (type == 0xFF) {
+		if (sprite != NULL) {
+			if (type == 0xFF && _cur.skip_sprites == 0) {
+				/* Actions may read the following sprites, or jump elsewhere. */
+				if (FioGetPos() != pos) FioSeekTo(pos, SEEK_SET);
+				DecodeSpecialSprite(NULL, num, stage, &prepared->content[sprite->content]);
+				pos = FioGetPos();
+
+				/* Stop all processing if we are to skip the remaining sprites */
+				if (_cur.skip_sprites == -1) break;
+
+				continue;
+			}
+			if (type != 0xFF && _cur.skip_sprites == 0) {
+				grfmsg(0, "LoadNewGRFFile: Unexpected sprite, disabling");
+				DisableGrf(STR_NEWGRF_ERROR_UNEXPECTED_SPRITE);
+				break;
+			}
+		} else if (type == 0xFF) {
 			if (_cur.skip_sprites == 0) {
 				DecodeSpecialSprite(buf.Allocate(num), num, stage);
+				pos = FioGetPos();
 
 				/* Stop all processing if we are to skip the remaining sprites */
 				if (_cur.skip_sprites == -1) break;
@@ -9127,6 +9475,7 @@ void LoadNewGRFFile(GRFConfig *config, uint file_index, GrfLoadingStage stage, S
 			}
 		}
 
+		if (sprite == NULL) pos = FioGetPos();
 		if (_cur.skip_sprites > 0) _cur.skip_sprites--;
 	}
 }
@@ -9424,6 +9773,8 @@ void LoadNewGRF(uint load_index, uint file_index, uint num_baseset)
 
 	_cur.spriteid = load_index;
 
+	PrepareNewGRFFiles(num_baseset);
+
 	/* Load newgrf sprites
 	 * in each loading stage, (try to) open each file specified in the config
 	 * and load information from it. */
@@ -9487,6 +9838,8 @@ void LoadNewGRF(uint load_index, uint file_index, uint num_baseset)
 		}
 	}
 
+	ClearPreparedNewGRFFiles();
+
 	/* Pseudo sprite processing is finished; free temporary stuff */
 	_cur.ClearDataForNextFile();
 
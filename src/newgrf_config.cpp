@@ -24,6 +24,12 @@
 
 #include "fileio_func.h"
 #include "fios.h"
+#include "rev.h"
+#include <sys/stat.h>
+
+#include <map>
+#include <string>
+#include <vector>
 
 #include "safeguards.h"
 
@@ -623,13 +629,381 @@ compatible_grf:
 	return res;
 }
 
+char *_newgrf_scan_cache_file; ///< The file to store the results of scanning for NewGRFs in.
+
+/** Magic at the start of the NewGRF scan cache. */
+static const char GRF_SCAN_CACHE_MAGIC[8] = { 'O', 'T', 'T', 'D', 'G', 'R', 'F', 'C' };
+/** Version of the format of the NewGRF scan cache; increase it when the stored data changes. */
+static const uint32 GRF_SCAN_CACHE_VERSION = 1;
+
+/** The result of scanning one NewGRF file, as stored in the NewGRF scan cache. */
+struct GRFScanCacheItem {
+	uint64 size;            ///< Size of the file when it was scanned.
+	int64 mtime;            ///< Modification time of the file when it was scanned.
+	std::vector<byte> data; ///< The scanned details of the NewGRF, see #WriteGRFScanCacheConfig; empty if the file is not a (usable) NewGRF.
+
+	/**
+	 * Exchange the contents with another item, without copying the data.
+	 * @param other The other item.
+	 */
+	void swap(GRFScanCacheItem &other)
+	{
+		std::swap(this->size, other.size);
+		std::swap(this->mtime, other.mtime);
+		this->data.swap(other.data);
+	}
+};
+
+/** Results of scanning NewGRF files, by the full path of the file. */
+typedef std::map<std::string, GRFScanCacheItem> GRFScanCache;
+
+/** Writer of the little endian data of the NewGRF scan cache. */
+struct GRFScanCacheWriter {
+	std::vector<byte> &buffer; ///< Buffer to append the data to.
+
+	GRFScanCacheWriter(std::vector<byte> &buffer) : buffer(buffer) {}
+
+	void WriteByte(byte value)
+	{
+		this->buffer.push_back(value);
+	}
+
+	void WriteWord(uint16 value)
+	{
+		this->WriteByte(GB(value, 0, 8));
+		this->WriteByte(GB(value, 8, 8));
+	}
+
+	void WriteDword(uint32 value)
+	{
+		this->WriteWord(GB(value, 0, 16));
+		this->WriteWord(GB(value, 16, 16));
+	}
+
+	void WriteQword(uint64 value)
+	{
+		this->WriteDword(GB(value, 0, 32));
+		this->WriteDword(GB(value, 32, 32));
+	}
+
+	void WriteBytes(const void *data, size_t length)
+	{
+		const byte *b = (const byte *)data;
+		this->buffer.insert(this->buffer.end(), b, b + length);
+	}
+
+	/**
+	 * Write a list of translations of a text.
+	 * @param text The first translation.
+	 */
+	void WriteText(const GRFText *text)
+	{
+		uint16 count = 0;
+		for (const GRFText *t = text; t != NULL; t = t->next) count++;
+		this->WriteWord(count);
+		for (const GRFText *t = text; t != NULL; t = t->next) {
+			this->WriteByte(t->langid);
+			this->WriteDword((uint32)t->len);
+			this->WriteBytes(t->text, t->len);
+		}
+	}
+};
+
+/** Reader of the data written by #GRFScanCacheWriter; reading beyond the end marks the data as broken. */
+struct GRFScanCacheReader {
+	const byte *pos; ///< Next byte to read.
+	const byte *end; ///< End of the data.
+	bool broken;     ///< Whether more was read than there is.
+
+	GRFScanCacheReader(const byte *begin, const byte *end) : pos(begin), end(end), broken(false) {}
+
+	byte ReadByte()
+	{
+		if (this->pos == this->end) {
+			this->broken = true;
+			return 0;
+		}
+		return *this->pos++;
+	}
+
+	uint16 ReadWord()
+	{
+		uint16 value = this->ReadByte();
+		return value | this->ReadByte() << 8;
+	}
+
+	uint32 ReadDword()
+	{
+		uint32 value = this->ReadWord();
+		return value | this->ReadWord() << 16;
+	}
+
+	uint64 ReadQword()
+	{
+		uint64 value = this->ReadDword();
+		return value | (uint64)this->ReadDword() << 32;
+	}
+
+	/**
+	 * Read a number of bytes.
+	 * @param length Number of bytes.
+	 * @return The bytes, or \c NULL if there are not that many.
+	 */
+	const byte *ReadBytes(size_t length)
+	{
+		if ((size_t)(this->end - this->pos) < length) {
+			this->broken = true;
+			this->pos = this->end;
+			return NULL;
+		}
+		const byte *data = this->pos;
+		this->pos += length;
+		return data;
+	}
+
+	/**
+	 * Read a list of translations of a text.
+	 * @return The first translation.
+	 */
+	GRFText *ReadText()
+	{
+		GRFText *text = NULL;
+		GRFText **last = &text;
+		for (uint16 count = this->ReadWord(); count > 0 && !this->broken; count--) {
+			byte langid = this->ReadByte();
+			uint32 len = this->ReadDword();
+			const byte *data = this->ReadBytes(len);
+			if (data == NULL) break;
+			*last = GRFText::New(langid, (const char *)data, len);
+			last = &(*last)->next;
+		}
+		return text;
+	}
+};
+
+/**
+ * Write the details of a scanned NewGRF.
+ * @param w Writer to write with.
+ * @param c The NewGRF, filled by #FillGRFDetails.
+ */
+static void WriteGRFScanCacheConfig(GRFScanCacheWriter &w, const GRFConfig *c)
+{
+	w.WriteDword(c->ident.grfid);
+	w.WriteBytes(c->ident.md5sum, sizeof(c->ident.md5sum));
+	w.WriteDword(c->version);
+	w.WriteDword(c->min_loadable_version);
+	w.WriteByte(c->flags);
+	w.WriteByte(c->status);
+	w.WriteByte(c->palette);
+	w.WriteByte(c->num_valid_params);
+	w.WriteByte(c->has_param_defaults);
+	w.WriteByte(c->num_params);
+	for (uint i = 0; i < c->num_params; i++) w.WriteDword(c->param[i]);
+
+	w.WriteText(c->name->text);
+	w.WriteText(c->info->text);
+	w.WriteText(c->url->text);
+
+	w.WriteWord(c->param_info.Length());
+	for (const GRFParameterInfo * const *it = c->param_info.Begin(); it != c->param_info.End(); it++) {
+		const GRFParameterInfo *info = *it;
+		w.WriteByte(info != NULL);
+		if (info == NULL) continue;
+
+		w.WriteText(info->name);
+		w.WriteText(info->desc);
+		w.WriteByte(info->type);
+		w.WriteDword(info->min_value);
+		w.WriteDword(info->max_value);
+		w.WriteDword(info->def_value);
+		w.WriteByte(info->param_nr);
+		w.WriteByte(info->first_bit);
+		w.WriteByte(info->num_bit);
+		w.WriteByte(info->complete_labels);
+		w.WriteWord(info->value_names.Length());
+		for (const SmallPair<uint32, GRFText *> *v = info->value_names.Begin(); v != info->value_names.End(); v++) {
+			w.WriteDword(v->first);
+			w.WriteText(v->second);
+		}
+	}
+}
+
+/**
+ * Read the details of a scanned NewGRF, as written by #WriteGRFScanCacheConfig.
+ * @param r Reader to read with.
+ * @param c The NewGRF to fill; it must be freshly constructed.
+ * @return Whether the data was complete.
+ */
+static bool ReadGRFScanCacheConfig(GRFScanCacheReader &r, GRFConfig *c)
+{
+	c->ident.grfid = r.ReadDword();
+	const byte *md5sum = r.ReadBytes(sizeof(c->ident.md5sum));
+	if (md5sum != NULL) memcpy(c->ident.md5sum, md5sum, sizeof(c->ident.md5sum));
+	c->version = r.ReadDword();
+	c->min_loadable_version = r.ReadDword();
+	c->flags = r.ReadByte();
+	c->status = (GRFStatus)r.ReadByte();
+	c->palette = r.ReadByte();
+	c->num_valid_params = r.ReadByte();
+	c->has_param_defaults = r.ReadByte() != 0;
+	c->num_params = min<uint>(r.ReadByte(), lengthof(c->param));
+	for (uint i = 0; i < c->num_params; i++) c->param[i] = r.ReadDword();
+
+	c->name->text = r.ReadText();
+	c->info->text = r.ReadText();
+	c->url->text = r.ReadText();
+
+	for (uint16 count = r.ReadWord(); count > 0 && !r.broken; count--) {
+		if (r.ReadByte() == 0) {
+			*c->param_info.Append() = NULL;
+			continue;
+		}
+
+		GRFParameterInfo *info = new GRFParameterInfo(0);
+		*c->param_info.Append() = info;
+		info->name = r.ReadText();
+		info->desc = r.ReadText();
+		info->type = (GRFParameterType)min<uint>(r.ReadByte(), PTYPE_END);
+		info->min_value = r.ReadDword();
+		info->max_value = r.ReadDword();
+		info->def_value = r.ReadDword();
+		info->param_nr = r.ReadByte();
+		info->first_bit = r.ReadByte();
+		info->num_bit = r.ReadByte();
+		info->complete_labels = r.ReadByte() != 0;
+		for (uint16 values = r.ReadWord(); values > 0 && !r.broken; values--) {
+			uint32 value = r.ReadDword();
+			GRFText *text = r.ReadText();
+			if (info->value_names.Contains(value)) {
+				CleanUpGRFText(text);
+			} else {
+				info->value_names.Insert(value, text);
+			}
+		}
+	}
+
+	/* The palette to use depends on a setting, which may have changed since the scan. */
+	c->SetSuitablePalette();
+	return !r.broken;
+}
+
+/**
+ * Load the NewGRF scan cache from #_newgrf_scan_cache_file. A cache that is
+ * broken, or that was written by another version of OpenTTD, is ignored as
+ * scanning may have changed.
+ * @param[out] cache The loaded cache.
+ */
+static void LoadGRFScanCache(GRFScanCache &cache)
+{
+	cache.clear();
+	if (_newgrf_scan_cache_file == NULL) return;
+
+	FILE *f = fopen(_newgrf_scan_cache_file, "rb");
+	if (f == NULL) return;
+
+	std::vector<byte> buffer;
+	byte block[4096];
+	size_t len;
+	while ((len = fread(block, 1, sizeof(block), f)) != 0) buffer.insert(buffer.end(), block, block + len);
+	fclose(f);
+
+	GRFScanCacheReader r(buffer.data(), buffer.data() + buffer.size());
+	const byte *magic = r.ReadBytes(sizeof(GRF_SCAN_CACHE_MAGIC));
+	if (magic == NULL || memcmp(magic, GRF_SCAN_CACHE_MAGIC, sizeof(GRF_SCAN_CACHE_MAGIC)) != 0 || r.ReadDword() != GRF_SCAN_CACHE_VERSION) return;
+
+	uint16 revision_len = r.ReadWord();
+	const byte *revision = r.ReadBytes(revision_len);
+	if (revision == NULL || revision_len != strlen(_openttd_revision) || memcmp(revision, _openttd_revision, revision_len) != 0) {
+		DEBUG(grf, 1, "Ignoring NewGRF scan cache of another version");
+		return;
+	}
+
+	while (r.pos != r.end) {
+		uint16 path_len = r.ReadWord();
+		const byte *path = r.ReadBytes(path_len);
+		GRFScanCacheItem item;
+		item.size = r.ReadQword();
+		item.mtime = (int64)r.ReadQword();
+		uint32 data_len = r.ReadDword();
+		const byte *data = r.ReadBytes(data_len);
+		if (r.broken) {
+			DEBUG(grf, 0, "NewGRF scan cache is broken; rescanning all NewGRFs");
+			cache.clear();
+			return;
+		}
+		item.data.assign(data, data + data_len);
+		cache[std::string((const char *)path, path_len)].swap(item);
+	}
+
+	DEBUG(grf, 2, "Loaded NewGRF scan cache with " PRINTF_SIZE " files", cache.size());
+}
+
+/**
+ * Save the NewGRF scan cache to #_newgrf_scan_cache_file.
+ * @param cache The cache to save.
+ */
+static void SaveGRFScanCache(const GRFScanCache &cache)
+{
+	if (_newgrf_scan_cache_file == NULL) return;
+
+	std::vector<byte> buffer;
+	GRFScanCacheWriter w(buffer);
+	w.WriteBytes(GRF_SCAN_CACHE_MAGIC, sizeof(GRF_SCAN_CACHE_MAGIC));
+	w.WriteDword(GRF_SCAN_CACHE_VERSION);
+	size_t revision_len = strlen(_openttd_revision);
+	w.WriteWord((uint16)revision_len);
+	w.WriteBytes(_openttd_revision, revision_len);
+
+	for (GRFScanCache::const_iterator it = cache.begin(); it != cache.end(); it++) {
+		w.WriteWord((uint16)it->first.size());
+		w.WriteBytes(it->first.data(), it->first.size());
+		w.WriteQword(it->second.size);
+		w.WriteQword((uint64)it->second.mtime);
+		w.WriteDword((uint32)it->second.data.size());
+		w.WriteBytes(it->second.data.data(), it->second.data.size());
+	}
+
+	FILE *f = fopen(_newgrf_scan_cache_file, "wb");
+	if (f == NULL || fwrite(buffer.data(), 1, buffer.size(), f) != buffer.size()) {
+		DEBUG(grf, 0, "Could not save the NewGRF scan cache to %s", _newgrf_scan_cache_file);
+	}
+	if (f != NULL) fclose(f);
+}
+
+/**
+ * Get the size and modification time of a file.
+ * @param filename Full path of the file.
+ * @param[out] size Size of the file.
+ * @param[out] mtime Modification time of the file.
+ * @return Whether the file could be queried.
+ */
+static bool GetGRFFileStat(const char *filename, uint64 *size, int64 *mtime)
+{
+#ifdef _WIN32
+	struct _stat sb;
+	if (_tstat(OTTD2FS(filename), &sb) != 0) return false;
+#else
+	struct stat sb;
+	if (stat(filename, &sb) != 0) return false;
+#endif
+	*size = sb.st_size;
+	*mtime = sb.st_mtime;
+	return true;
+}
+
 /** Helper for scanning for files with GRF as extension */
 class GRFFileScanner : FileScanner {
 	uint next_update; ///< The next (realtime tick) we do update the screen.
 	uint num_scanned; ///< The number of GRFs we have scanned.
+	uint num_cached;  ///< The number of GRFs of which the details came from the scan cache.
+	bool cache_changed;     ///< Whether a file was added to the scan cache by this scan.
+	GRFScanCache old_cache; ///< The scan cache as it was before this scan.
+	GRFScanCache new_cache; ///< The scan cache of the files found by this scan.
+
+	bool FillGRFDetailsCached(GRFConfig *&c, const char *filename, const char *tar_filename);
 
 public:
-	GRFFileScanner() : next_update(_realtime_tick), num_scanned(0)
+	GRFFileScanner() : next_update(_realtime_tick), num_scanned(0), num_cached(0), cache_changed(false)
 	{
 	}
 
@@ -639,7 +1013,11 @@ public:
 	static uint DoScan()
 	{
 		GRFFileScanner fs;
+		LoadGRFScanCache(fs.old_cache);
 		int ret = fs.Scan(".grf", NEWGRF_DIR);
+		/* Only write the cache when files were added, changed or removed. */
+		if (fs.cache_changed || fs.new_cache.size() != fs.old_cache.size()) SaveGRFScanCache(fs.new_cache);
+		DEBUG(grf, 1, "Took the details of %u of %u NewGRFs from the scan cache", fs.num_cached, fs.num_scanned);
 		/* The number scanned and the number returned may not be the same;
 		 * duplicate NewGRFs and base sets are ignored in the return value. */
 		_settings_client.gui.last_newgrf_count = fs.num_scanned;
@@ -647,12 +1025,61 @@ public:
 	}
 };
 
+/**
+ * Fill the details of a NewGRF like #FillGRFDetails, but take them from the
+ * scan cache when the file did not change since it was last scanned.
+ * @param[in,out] c The NewGRF to fill; it may be replaced by a new one.
+ * @param filename Full path of the file.
+ * @param tar_filename The tar the file is in, or \c NULL.
+ * @return Whether the file is a usable NewGRF.
+ */
+bool GRFFileScanner::FillGRFDetailsCached(GRFConfig *&c, const char *filename, const char *tar_filename)
+{
+	/* Files in tars have no size and time of their own to check. */
+	uint64 size;
+	int64 mtime;
+	if (tar_filename != NULL || !GetGRFFileStat(filename, &size, &mtime)) return FillGRFDetails(c, false);
+
+	GRFScanCache::iterator it = this->old_cache.find(filename);
+	if (it != this->old_cache.end() && it->second.size == size && it->second.mtime == mtime) {
+		const std::vector<byte> &data = it->second.data;
+		GRFScanCacheReader r(data.data(), data.data() + data.size());
+		if (data.empty() || ReadGRFScanCacheConfig(r, c)) {
+			bool is_grf = !data.empty();
+			this->num_cached++;
+			this->new_cache[it->first].swap(it->second);
+			return is_grf;
+		}
+		DEBUG(grf, 1, "Broken NewGRF scan cache entry for %s; rescanning it", filename);
+		/* Start from scratch, without what was read partially. */
+		GRFConfig *fresh = new GRFConfig(c->filename);
+		delete c;
+		c = fresh;
+	}
+
+	bool result = FillGRFDetails(c, false);
+
+	/* Errors and files that could not be read are not cached, so they are reported again next time. */
+	if (c->error == NULL && (result || c->ident.grfid == 0 || HasBit(c->flags, GCF_SYSTEM))) {
+		this->cache_changed = true;
+		GRFScanCacheItem &item = this->new_cache[filename];
+		item.size = size;
+		item.mtime = mtime;
+		item.data.clear();
+		if (result) {
+			GRFScanCacheWriter w(item.data);
+			WriteGRFScanCacheConfig(w, c);
+		}
+	}
+	return result;
+}
+
 bool GRFFileScanner::AddFile(const char *filename, size_t basepath_length, const char *tar_filename)
 {
 	GRFConfig *c = new GRFConfig(filename + basepath_length);
 
 	bool added = true;
-	if (FillGRFDetails(c, false)) {
+	if (this->FillGRFDetailsCached(c, filename, tar_filename)) {
 		if (_all_grfs == NULL) {
 			_all_grfs = c;
 		} else {
@@ -728,6 +1155,7 @@ void DoScanNewGRFFiles(void *callback)
 	_modal_progress_work_mutex->BeginCritical();
 
 	ClearGRFConfigList(&_all_grfs);
+	FileScanCache scan_cache;
 	TarScanner::DoScan(TarScanner::NEWGRF);
 
 	DEBUG(grf, 1, "Scanning for NewGRFs");
@@ -34,7 +34,7 @@ struct VehicleScopeResolver : public ScopeResolver {
 	 * @param info_view Indicates if the item is being drawn in an info window.
 	 */
 	VehicleScopeResolver(ResolverObject &ro, EngineID engine_type, const Vehicle *v, bool info_view)
-		: ScopeResolver(ro), v(v), self_type(engine_type), info_view(info_view)
+		: ScopeResolver(ro, SRT_VEHICLE), v(v), self_type(engine_type), info_view(info_view)
 	{
 	}
 
@@ -500,7 +500,7 @@ TownScopeResolver *IndustriesResolverObject::GetTown()
 uint16 GetIndustryCallback(CallbackID callback, uint32 param1, uint32 param2, Industry *industry, IndustryType type, TileIndex tile)
 {
 	IndustriesResolverObject object(tile, industry, type, 0, callback, param1, param2);
-	return object.ResolveCallback();
+	return object.ResolveCallback(true);
 }
 
 /**
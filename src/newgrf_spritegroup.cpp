@@ -13,6 +13,9 @@
 #include <algorithm>
 #include "debug.h"
 #include "newgrf_spritegroup.h"
+#include "newgrf_engine.h"
+#include "newgrf_house.h"
+#include "newgrf_station.h"
 #include "core/pool_func.hpp"
 
 #include "safeguards.h"
@@ -22,6 +25,68 @@ INSTANTIATE_POOL_METHODS(SpriteGroup)
 
 TemporaryStorageArray<int32, 0x110> _temp_store;
 
+/** A callback result remembered by ResolverObject::ResolveCallback. */
+struct CallbackMemoEntry {
+	const SpriteGroup *group; ///< The root sprite group, or \c NULL if the entry is unused.
+	CallbackID callback;      ///< The callback.
+	uint32 param1;            ///< First parameter of the callback.
+	uint32 param2;            ///< Second parameter of the callback.
+	uint16 result;            ///< Result of the callback.
+};
+
+static const uint CALLBACK_MEMO_SIZE = 4096; ///< Number of entries of the callback memo, must be a power of 2.
+static CallbackMemoEntry _callback_memo[CALLBACK_MEMO_SIZE]; ///< Callback results that only depend on the callback and its parameters.
+CallbackMemoStats _callback_memo_stats; ///< Statistics about the use of the callback memo.
+
+/** Forget all memoised callback results, e.g. because the sprite groups are freed. */
+void ClearCallbackMemo()
+{
+	memset(_callback_memo, 0, sizeof(_callback_memo));
+	memset(&_callback_memo_stats, 0, sizeof(_callback_memo_stats));
+}
+
+/**
+ * Resolve callback.
+ * @param memoise Whether to look the result up in, and store it into, the
+ *                callback memo. It is only stored when resolving did not
+ *                read anything but the callback, its parameters and
+ *                constants, so the result can never change.
+ * @return Callback result.
+ */
+uint16 ResolverObject::ResolveCallback(bool memoise)
+{
+	CallbackMemoEntry *entry = NULL;
+	if (memoise && this->root_spritegroup != NULL) {
+		size_t hash = ((size_t)this->root_spritegroup >> 4) ^ (this->callback * 0x9E3779B1U) ^ this->callback_param1 ^ (this->callback_param2 * 31);
+		entry = &_callback_memo[hash & (CALLBACK_MEMO_SIZE - 1)];
+		if (entry->group == this->root_spritegroup && entry->callback == this->callback &&
+				entry->param1 == this->callback_param1 && entry->param2 == this->callback_param2) {
+			/* Resolving would have cleared the registers. */
+			_temp_store.ClearChanges();
+			_callback_memo_stats.hits++;
+			return entry->result;
+		}
+		this->reads_state = false;
+	}
+
+	const SpriteGroup *group = this->Resolve();
+	uint16 result = group != NULL ? group->GetCallbackResult() : CALLBACK_FAILED;
+
+	if (entry != NULL) {
+		if (this->reads_state) {
+			_callback_memo_stats.uncacheable++;
+		} else {
+			entry->group = this->root_spritegroup;
+			entry->callback = this->callback;
+			entry->param1 = this->callback_param1;
+			entry->param2 = this->callback_param2;
+			entry->result = result;
+			_callback_memo_stats.stored++;
+		}
+	}
+	return result;
+}
+
 
 /**
  * ResolverObject (re)entry point.
@@ -52,6 +117,7 @@ DeterministicSpriteGroup::~DeterministicSpriteGroup()
 {
 	free(this->adjusts);
 	free(this->ranges);
+	free(this->jump_table);
 }
 
 RandomizedSpriteGroup::~RandomizedSpriteGroup()
@@ -59,13 +125,36 @@ RandomizedSpriteGroup::~RandomizedSpriteGroup()
 	free(this->groups);
 }
 
-static inline uint32 GetVariable(const ResolverObject &object, ScopeResolver *scope, byte variable, uint32 parameter, bool *available)
+/**
+ * Get a feature specific variable of a scope.
+ * @tparam TScope The type of the scope, called without virtual dispatch unless it is #ScopeResolver itself.
+ * @param scope The scope.
+ * @param variable The variable.
+ * @param parameter The parameter of the variable.
+ * @param[out] available Set to false if the variable is not available.
+ * @return The value of the variable.
+ */
+template <class TScope>
+static inline uint32 GetScopeVariable(TScope *scope, byte variable, uint32 parameter, bool *available)
+{
+	return scope->TScope::GetVariable(variable, parameter, available);
+}
+
+template <>
+inline uint32 GetScopeVariable<ScopeResolver>(ScopeResolver *scope, byte variable, uint32 parameter, bool *available)
+{
+	return scope->GetVariable(variable, parameter, available);
+}
+
+template <class TScope>
+static inline uint32 GetVariable(const ResolverObject &object, TScope *scope, byte variable, uint32 parameter, bool *available)
 {
 	uint32 value;
 	switch (variable) {
 		case 0x0C: return object.callback;
 		case 0x10: return object.callback_param1;
 		case 0x18: return object.callback_param2;
+		case 0x1A: return UINT_MAX;
 		case 0x1C: return object.last_value;
 
 		case 0x5F: return (scope->GetRandomBits() << 8) | scope->GetTriggers();
@@ -80,7 +169,7 @@ static inline uint32 GetVariable(const ResolverObject &object, ScopeResolver *sc
 			/* First handle variables common with Action7/9/D */
 			if (variable < 0x40 && GetGlobalVariable(variable, &value, object.grffile)) return value;
 			/* Not a common variable, so evaluate the feature specific variables */
-			return scope->GetVariable(variable, parameter, available);
+			return GetScopeVariable(scope, variable, parameter, available);
 	}
 }
 
@@ -144,10 +233,10 @@ static inline uint32 GetVariable(const ResolverObject &object, ScopeResolver *sc
 	return &this->default_scope;
 }
 
-/* Evaluate an adjustment for a variable of the given size.
- * U is the unsigned type and S is the signed type to use. */
-template <typename U, typename S>
-static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver *scope, U last_value, uint32 value)
+/* Evaluate the shift, mask and division of an adjustment for a variable of the given size.
+ * S is the signed type to use. */
+template <typename S>
+static uint32 EvalAdjustValueT(const DeterministicSpriteGroupAdjust *adjust, uint32 value)
 {
 	value >>= adjust->shift_num;
 	value  &= adjust->and_mask;
@@ -158,6 +247,16 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver
 		case DSGA_TYPE_NONE: break;
 	}
 
+	return value;
+}
+
+/* Evaluate an adjustment for a variable of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ScopeResolver *scope, U last_value, uint32 value)
+{
+	value = EvalAdjustValueT<S>(adjust, value);
+
 	switch (adjust->operation) {
 		case DSGA_OP_ADD:  return last_value + value;
 		case DSGA_OP_SUB:  return last_value - value;
@@ -192,16 +291,133 @@ static bool RangeHighComparator(const DeterministicSpriteGroupRange& range, uint
 	return range.high < value;
 }
 
-const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) const
+/**
+ * Evaluate an adjustment that does not depend on the resolved object.
+ * @param size The size of the variables of the sprite group.
+ * @param adjust The adjustment.
+ * @param last_value The result of the previous adjustments.
+ * @param value The value of the variable.
+ * @return The result of the adjustment.
+ */
+static uint32 EvalConstantAdjust(DeterministicSpriteGroupSize size, const DeterministicSpriteGroupAdjust *adjust, uint32 last_value, uint32 value)
 {
-	uint32 last_value = 0;
-	uint32 value = 0;
-	uint i;
+	switch (size) {
+		case DSG_SIZE_BYTE:  return EvalAdjustT<uint8,  int8> (adjust, NULL, last_value, value);
+		case DSG_SIZE_WORD:  return EvalAdjustT<uint16, int16>(adjust, NULL, last_value, value);
+		case DSG_SIZE_DWORD: return EvalAdjustT<uint32, int32>(adjust, NULL, last_value, value);
+		default: NOT_REACHED();
+	}
+}
 
-	ScopeResolver *scope = object.GetScope(this->var_scope);
+/**
+ * Check whether a variable only depends on the callback being resolved.
+ * @param variable The variable.
+ * @return True if the variable is the callback, one of its parameters or a constant.
+ */
+static bool IsPureVariable(byte variable)
+{
+	switch (variable) {
+		case 0x0C: // callback
+		case 0x10: // callback parameter 1
+		case 0x18: // callback parameter 2
+		case 0x1A: // always -1
+		case 0x1C: // result of the last procedure
+		case 0x7E: // procedure call, checked when resolving the procedure
+		case 0x7F: // NewGRF parameter
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Prepare the sprite group for quick resolving, after it has been loaded.
+ * Constant variables are folded into their adjustments, a chain of
+ * constant adjustments at the start is merged into one and small range
+ * tables are turned into a jump table. Also determine whether the group
+ * only depends on the callback, so its results can be memoised.
+ */
+void DeterministicSpriteGroup::Optimise()
+{
+	this->pure = true;
+	for (uint i = 0; i < this->num_adjusts; i++) {
+		const DeterministicSpriteGroupAdjust *adjust = &this->adjusts[i];
+		bool pure_variable = adjust->variable == 0x7B ? (adjust->parameter != 0x7B && adjust->parameter != 0x7E && IsPureVariable(adjust->parameter)) : IsPureVariable(adjust->variable);
+		if (!pure_variable || adjust->operation == DSGA_OP_STO || adjust->operation == DSGA_OP_STOP) this->pure = false;
+	}
 
-	for (i = 0; i < this->num_adjusts; i++) {
+	/* Variable 0x1A is always -1; precalculate its shift, mask and division.
+	 * A division by zero is left for resolving to deal with. */
+	for (uint i = 0; i < this->num_adjusts; i++) {
 		DeterministicSpriteGroupAdjust *adjust = &this->adjusts[i];
+		if (adjust->variable != 0x1A || (adjust->type != DSGA_TYPE_NONE && adjust->divmod_val == 0)) continue;
+
+		switch (this->size) {
+			case DSG_SIZE_BYTE:  adjust->and_mask = EvalAdjustValueT<int8> (adjust, UINT_MAX); break;
+			case DSG_SIZE_WORD:  adjust->and_mask = EvalAdjustValueT<int16>(adjust, UINT_MAX); break;
+			case DSG_SIZE_DWORD: adjust->and_mask = EvalAdjustValueT<int32>(adjust, UINT_MAX); break;
+			default: NOT_REACHED();
+		}
+		adjust->shift_num = 0;
+		adjust->type = DSGA_TYPE_NONE;
+		adjust->add_val = 0;
+		adjust->divmod_val = 0;
+	}
+
+	/* Merge the constant adjustments at the start, as long as they do not store anything. */
+	uint num_constant = 0;
+	uint32 value = 0;
+	while (num_constant < this->num_adjusts) {
+		const DeterministicSpriteGroupAdjust *adjust = &this->adjusts[num_constant];
+		if (adjust->variable != 0x1A || adjust->type != DSGA_TYPE_NONE) break;
+		if (adjust->operation == DSGA_OP_STO || adjust->operation == DSGA_OP_STOP) break;
+		value = EvalConstantAdjust(this->size, adjust, value, UINT_MAX);
+		num_constant++;
+	}
+	if (num_constant > 0) {
+		DeterministicSpriteGroupAdjust *adjust = &this->adjusts[0];
+		adjust->operation = DSGA_OP_ADD;
+		adjust->and_mask = value;
+		MemMoveT(this->adjusts + 1, this->adjusts + num_constant, this->num_adjusts - num_constant);
+		this->num_adjusts -= num_constant - 1;
+	}
+	this->constant_result = num_constant > 0 && this->num_adjusts == 1;
+
+	/* Small tables with several ranges are quicker to look up directly. */
+	if (this->num_ranges > 1) {
+		uint32 low = this->ranges[0].low;
+		uint32 high = this->ranges[this->num_ranges - 1].high;
+		if (high - low < DSG_JUMP_TABLE_MAX_SIZE) {
+			this->jump_table_low = low;
+			this->jump_table_size = high - low + 1;
+			this->jump_table = MallocT<const SpriteGroup *>(this->jump_table_size);
+			for (uint i = 0; i < this->jump_table_size; i++) this->jump_table[i] = this->default_group;
+			for (uint i = 0; i < this->num_ranges; i++) {
+				for (uint j = this->ranges[i].low - low; j <= this->ranges[i].high - low; j++) {
+					this->jump_table[j] = this->ranges[i].group;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Evaluate the adjustments of a deterministic sprite group.
+ * @tparam TScope The type of the scope to get the variables of.
+ * @param group The sprite group.
+ * @param object The resolver object.
+ * @param scope The scope of the sprite group.
+ * @param first The first adjustment to evaluate.
+ * @param[in,out] last_value The result of the last adjustment.
+ * @param[in,out] value The value of the last adjustment.
+ * @return False if a variable was not available.
+ */
+template <class TScope>
+static bool EvalAdjustsT(const DeterministicSpriteGroup *group, ResolverObject &object, TScope *scope, uint first, uint32 &last_value, uint32 &value)
+{
+	for (uint i = first; i < group->num_adjusts; i++) {
+		DeterministicSpriteGroupAdjust *adjust = &group->adjusts[i];
 
 		/* Try to get the variable. We shall assume it is available, unless told otherwise. */
 		bool available = true;
@@ -220,13 +436,9 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 			value = GetVariable(object, scope, adjust->variable, adjust->parameter, &available);
 		}
 
-		if (!available) {
-			/* Unsupported variable: skip further processing and return either
-			 * the group from the first range or the default group. */
-			return SpriteGroup::Resolve(this->error_group, object, false);
-		}
+		if (!available) return false;
 
-		switch (this->size) {
+		switch (group->size) {
 			case DSG_SIZE_BYTE:  value = EvalAdjustT<uint8,  int8> (adjust, scope, last_value, value); break;
 			case DSG_SIZE_WORD:  value = EvalAdjustT<uint16, int16>(adjust, scope, last_value, value); break;
 			case DSG_SIZE_DWORD: value = EvalAdjustT<uint32, int32>(adjust, scope, last_value, value); break;
@@ -234,6 +446,40 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 		}
 		last_value = value;
 	}
+	return true;
+}
+
+const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) const
+{
+	uint32 last_value = 0;
+	uint32 value = 0;
+	uint i;
+
+	ScopeResolver *scope = object.GetScope(this->var_scope);
+	if (!this->pure) object.reads_state = true;
+
+	if (this->constant_result) {
+		/* Nothing to evaluate, see Optimise(). */
+		value = last_value = this->adjusts[0].and_mask;
+		i = this->num_adjusts;
+	} else {
+		i = 0;
+	}
+
+	/* The hottest scopes get their variables without virtual dispatch. */
+	bool available;
+	switch (scope->type) {
+		case SRT_VEHICLE: available = EvalAdjustsT(this, object, static_cast<VehicleScopeResolver *>(scope), i, last_value, value); break;
+		case SRT_STATION: available = EvalAdjustsT(this, object, static_cast<StationScopeResolver *>(scope), i, last_value, value); break;
+		case SRT_HOUSE:   available = EvalAdjustsT(this, object, static_cast<HouseScopeResolver *>(scope), i, last_value, value); break;
+		default:          available = EvalAdjustsT(this, object, scope, i, last_value, value); break;
+	}
+
+	if (!available) {
+		/* Unsupported variable: skip further processing and return either
+		 * the group from the first range or the default group. */
+		return SpriteGroup::Resolve(this->error_group, object, false);
+	}
 
 	object.last_value = last_value;
 
@@ -245,6 +491,11 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 		return &nvarzero;
 	}
 
+	if (this->jump_table != NULL) {
+		uint32 index = value - this->jump_table_low;
+		return SpriteGroup::Resolve(index < this->jump_table_size ? this->jump_table[index] : this->default_group, object, false);
+	}
+
 	if (this->num_ranges > 4) {
 		DeterministicSpriteGroupRange *lower = std::lower_bound(this->ranges + 0, this->ranges + this->num_ranges, value, RangeHighComparator);
 		if (lower != this->ranges + this->num_ranges && lower->low <= value) {
@@ -265,6 +516,7 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 
 const SpriteGroup *RandomizedSpriteGroup::Resolve(ResolverObject &object) const
 {
+	object.reads_state = true;
 	ScopeResolver *scope = object.GetScope(this->var_scope, this->count);
 	if (object.callback == CBID_RANDOM_TRIGGER) {
 		/* Handle triggers */
@@ -286,6 +538,7 @@ const SpriteGroup *RandomizedSpriteGroup::Resolve(ResolverObject &object) const
 
 const SpriteGroup *RealSpriteGroup::Resolve(ResolverObject &object) const
 {
+	object.reads_state = true;
 	return object.ResolveReal(this);
 }
 
@@ -168,6 +168,9 @@ struct DeterministicSpriteGroupRange {
 };
 
 
+/** Maximum number of values covered by the jump table of a deterministic sprite group. */
+static const uint DSG_JUMP_TABLE_MAX_SIZE = 64;
+
 struct DeterministicSpriteGroup : SpriteGroup {
 	DeterministicSpriteGroup() : SpriteGroup(SGT_DETERMINISTIC) {}
 	~DeterministicSpriteGroup();
@@ -177,6 +180,8 @@ struct DeterministicSpriteGroup : SpriteGroup {
 	uint num_adjusts;
 	uint num_ranges;
 	bool calculated_result;
+	bool constant_result;                ///< The adjusts are folded into a constant, which is the \c and_mask of the only adjust.
+	bool pure;                           ///< The adjusts only read the callback, its parameters and constants, and store nothing. See ResolverObject::ResolveCallback.
 	DeterministicSpriteGroupAdjust *adjusts;
 	DeterministicSpriteGroupRange *ranges; // Dynamically allocated
 
@@ -185,6 +190,12 @@ struct DeterministicSpriteGroup : SpriteGroup {
 
 	const SpriteGroup *error_group; // was first range, before sorting ranges
 
+	const SpriteGroup **jump_table;      ///< Groups for the values starting at \c jump_table_low, including the default group, or \c NULL if the ranges are searched.
+	uint32 jump_table_low;               ///< First value of the jump table.
+	uint jump_table_size;                ///< Number of values in the jump table.
+
+	void Optimise();
+
 protected:
 	const SpriteGroup *Resolve(ResolverObject &object) const;
 };
@@ -288,6 +299,17 @@ struct IndustryProductionSpriteGroup : SpriteGroup {
 
 };
 
+/**
+ * Types of scope resolvers that DeterministicSpriteGroup::Resolve knows,
+ * so it can get their variables without virtual dispatch.
+ */
+enum ScopeResolverType {
+	SRT_GENERIC, ///< Any scope resolver; its variables are got through virtual dispatch.
+	SRT_VEHICLE, ///< #VehicleScopeResolver.
+	SRT_STATION, ///< #StationScopeResolver.
+	SRT_HOUSE,   ///< #HouseScopeResolver.
+};
+
 /**
  * Interface to query and set values specific to a single #VarSpriteGroupScope (action 2 scope).
  *
@@ -296,8 +318,9 @@ struct IndustryProductionSpriteGroup : SpriteGroup {
  */
 struct ScopeResolver {
 	ResolverObject &ro; ///< Surrounding resolver object.
+	ScopeResolverType type; ///< The type of the scope resolver; it must not be derived from when it is not #SRT_GENERIC.
 
-	ScopeResolver(ResolverObject &ro) : ro(ro) {}
+	ScopeResolver(ResolverObject &ro, ScopeResolverType type = SRT_GENERIC) : ro(ro), type(type) {}
 	virtual ~ScopeResolver() {}
 
 	virtual uint32 GetRandomBits() const;
@@ -341,6 +364,8 @@ struct ResolverObject {
 	uint32 used_triggers;       ///< Subset of cur_triggers, which actually triggered some rerandomisation. (scope independent)
 	uint32 reseed[VSG_END];     ///< Collects bits to rerandomise while triggering triggers.
 
+	bool reads_state;           ///< Whether the resolving so far depended on more than the callback and its parameters.
+
 	const GRFFile *grffile;     ///< GRFFile the resolved SpriteGroup belongs to
 	const SpriteGroup *root_spritegroup; ///< Root SpriteGroup to use for resolving
 
@@ -353,15 +378,7 @@ struct ResolverObject {
 		return SpriteGroup::Resolve(this->root_spritegroup, *this);
 	}
 
-	/**
-	 * Resolve callback.
-	 * @return Callback result.
-	 */
-	uint16 ResolveCallback()
-	{
-		const SpriteGroup *result = Resolve();
-		return result != NULL ? result->GetCallbackResult() : CALLBACK_FAILED;
-	}
+	uint16 ResolveCallback(bool memoise = false);
 
 	virtual const SpriteGroup *ResolveReal(const RealSpriteGroup *group) const;
 
@@ -396,10 +413,22 @@ struct ResolverObject {
 	void ResetState()
 	{
 		this->last_value = 0;
+		this->reads_state = false;
 		this->waiting_triggers = 0;
 		this->used_triggers = 0;
 		memset(this->reseed, 0, sizeof(this->reseed));
 	}
 };
 
+/** Statistics about memoised callback results. */
+struct CallbackMemoStats {
+	uint64 hits;        ///< Number of callbacks answered from the memo.
+	uint64 stored;      ///< Number of callback results stored in the memo.
+	uint64 uncacheable; ///< Number of callbacks whose result depended on the state of the game.
+};
+
+extern CallbackMemoStats _callback_memo_stats;
+
+void ClearCallbackMemo();
+
 #endif /* NEWGRF_SPRITEGROUP_H */
@@ -14,15 +14,22 @@
 #include "core/pool_func.hpp"
 #include "core/endian_func.hpp"
 #include "debug.h"
-#include <set>
+#include <vector>
 
 #include "safeguards.h"
 
 PersistentStoragePool _persistent_storage_pool("PersistentStorage");
 INSTANTIATE_POOL_METHODS(PersistentStorage)
 
-/** The changed storage arrays */
-static std::set<BasePersistentStorageArray*> *_changed_storage_arrays = new std::set<BasePersistentStorageArray*>;
+/** A temporary change of a value of a storage array. */
+struct PersistentStorageChange {
+	BasePersistentStorageArray *storage; ///< The changed storage array.
+	uint pos;                            ///< The position of the changed value.
+	int32 old_value;                     ///< The value before the change.
+};
+
+/** The temporary changes of the storage arrays, in the order they were made. */
+static std::vector<PersistentStorageChange> *_persistent_storage_changes = new std::vector<PersistentStorageChange>;
 
 bool BasePersistentStorageArray::gameloop;
 bool BasePersistentStorageArray::command;
@@ -33,18 +40,48 @@ bool BasePersistentStorageArray::testmode;
  */
 BasePersistentStorageArray::~BasePersistentStorageArray()
 {
-	_changed_storage_arrays->erase(this);
+	if (_persistent_storage_changes->empty()) return;
+
+	std::vector<PersistentStorageChange>::iterator new_end = _persistent_storage_changes->begin();
+	for (std::vector<PersistentStorageChange>::iterator it = _persistent_storage_changes->begin(); it != _persistent_storage_changes->end(); it++) {
+		if (it->storage != this) *new_end++ = *it;
+	}
+	_persistent_storage_changes->erase(new_end, _persistent_storage_changes->end());
+}
+
+/**
+ * Discard the temporary changes of this storage array.
+ */
+void BasePersistentStorageArray::ClearChanges()
+{
+	if (_persistent_storage_changes->empty()) return;
+
+	/* Undo the changes last to first, so every value ends up as before the first change. */
+	std::vector<PersistentStorageChange>::iterator new_end = _persistent_storage_changes->begin();
+	for (std::vector<PersistentStorageChange>::reverse_iterator it = _persistent_storage_changes->rbegin(); it != _persistent_storage_changes->rend(); it++) {
+		if (it->storage == this) this->RestoreValue(it->pos, it->old_value);
+	}
+	for (std::vector<PersistentStorageChange>::iterator it = _persistent_storage_changes->begin(); it != _persistent_storage_changes->end(); it++) {
+		if (it->storage != this) *new_end++ = *it;
+	}
+	_persistent_storage_changes->erase(new_end, _persistent_storage_changes->end());
 }
 
 /**
- * Add the changed storage array to the list of changed arrays.
- * This is done so we only have to revert/save the changed
- * arrays, which saves quite a few clears, etc. after callbacks.
- * @param storage the array that has changed
+ * Record the old value of a storage array before it is changed temporarily.
+ * Only the values that change are recorded, so the storage arrays do not
+ * have to be copied for every command test run.
+ * @param storage the array that is changed
+ * @param pos the position of the changed value
+ * @param old_value the value before the change
  */
-void AddChangedPersistentStorage(BasePersistentStorageArray *storage)
+void AddPersistentStorageChange(BasePersistentStorageArray *storage, uint pos, int32 old_value)
 {
-	_changed_storage_arrays->insert(storage);
+	PersistentStorageChange change;
+	change.storage = storage;
+	change.pos = pos;
+	change.old_value = old_value;
+	_persistent_storage_changes->push_back(change);
 }
 
 /**
@@ -92,10 +129,11 @@ void AddChangedPersistentStorage(BasePersistentStorageArray *storage)
 		default: NOT_REACHED();
 	}
 
-	/* Discard all temporary changes */
-	for (std::set<BasePersistentStorageArray*>::iterator it = _changed_storage_arrays->begin(); it != _changed_storage_arrays->end(); it++) {
-		DEBUG(desync, 1, "Discarding persistent storage changes: Feature %d, GrfID %08X, Tile %d", (*it)->feature, BSWAP32((*it)->grfid), (*it)->tile);
-		(*it)->ClearChanges();
+	/* Discard all temporary changes, last to first */
+	for (std::vector<PersistentStorageChange>::reverse_iterator it = _persistent_storage_changes->rbegin(); it != _persistent_storage_changes->rend(); it++) {
+		BasePersistentStorageArray *storage = it->storage;
+		DEBUG(desync, 1, "Discarding persistent storage change: Feature %d, GrfID %08X, Tile %d, Position %u", storage->feature, BSWAP32(storage->grfid), storage->tile, it->pos);
+		storage->RestoreValue(it->pos, it->old_value);
 	}
-	_changed_storage_arrays->clear();
+	_persistent_storage_changes->clear();
 }
@@ -40,12 +40,16 @@ struct BasePersistentStorageArray {
 
 	static void SwitchMode(PersistentStorageMode mode, bool ignore_prev_mode = false);
 
-protected:
+	void ClearChanges();
+
 	/**
-	 * Discard temporary changes.
+	 * Put back a value that was changed temporarily.
+	 * @param pos   the position to write at
+	 * @param value the old value
 	 */
-	virtual void ClearChanges() = 0;
+	virtual void RestoreValue(uint pos, int32 value) = 0;
 
+protected:
 	/**
 	 * Check whether currently changes to the storage shall be persistent or
 	 * temporary till the next call to ClearChanges().
@@ -58,6 +62,8 @@ private:
 	static bool testmode;
 };
 
+void AddPersistentStorageChange(BasePersistentStorageArray *storage, uint pos, int32 old_value);
+
 /**
  * Class for persistent storage of data.
  * On #ClearChanges that data is either reverted or saved.
@@ -67,20 +73,13 @@ private:
 template <typename TYPE, uint SIZE>
 struct PersistentStorageArray : BasePersistentStorageArray {
 	TYPE storage[SIZE]; ///< Memory to for the storage array
-	TYPE *prev_storage; ///< Memory to store "old" states so we can revert them on the performance of test cases for commands etc.
 
 	/** Simply construct the array */
-	PersistentStorageArray() : prev_storage(NULL)
+	PersistentStorageArray()
 	{
 		memset(this->storage, 0, sizeof(this->storage));
 	}
 
-	/** And free all data related to it */
-	~PersistentStorageArray()
-	{
-		free(this->prev_storage);
-	}
-
 	/** Resets all values to zero. */
 	void ResetToZero()
 	{
@@ -89,8 +88,8 @@ struct PersistentStorageArray : BasePersistentStorageArray {
 
 	/**
 	 * Stores some value at a given position.
-	 * If there is no backup of the data that backup is made and then
-	 * we write the data.
+	 * If the change is temporary the old value is recorded first, so
+	 * only the values that actually change are backed up.
 	 * @param pos   the position to write at
 	 * @param value the value to write
 	 */
@@ -103,18 +102,13 @@ struct PersistentStorageArray : BasePersistentStorageArray {
 		 * Saves a few cycles and such and it's pretty easy to check. */
 		if (this->storage[pos] == value) return;
 
-		/* We do not have made a backup; lets do so */
-		if (AreChangesPersistent()) {
-			assert(this->prev_storage == NULL);
-		} else if (this->prev_storage == NULL) {
-			this->prev_storage = MallocT<TYPE>(SIZE);
-			memcpy(this->prev_storage, this->storage, sizeof(this->storage));
+		if (!AreChangesPersistent()) AddPersistentStorageChange(this, pos, this->storage[pos]);
 
-			/* We only need to register ourselves when we made the backup
-			 * as that is the only time something will have changed */
-			AddChangedPersistentStorage(this);
-		}
+		this->storage[pos] = value;
+	}
 
+	void RestoreValue(uint pos, int32 value)
+	{
 		this->storage[pos] = value;
 	}
 
@@ -130,15 +124,6 @@ struct PersistentStorageArray : BasePersistentStorageArray {
 
 		return this->storage[pos];
 	}
-
-	void ClearChanges()
-	{
-		if (this->prev_storage != NULL) {
-			memcpy(this->storage, this->prev_storage, sizeof(this->storage));
-			free(this->prev_storage);
-			this->prev_storage = NULL;
-		}
-	}
 };
 
 
@@ -206,8 +191,6 @@ struct TemporaryStorageArray {
 	}
 };
 
-void AddChangedPersistentStorage(BasePersistentStorageArray *storage);
-
 typedef PersistentStorageArray<int32, 16> OldPersistentStorage;
 
 typedef uint32 PersistentStorageID;
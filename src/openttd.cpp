@@ -66,6 +66,8 @@
 #include "framerate_type.h"
 
 #include "linkgraph/linkgraphschedule.h"
+#include "thread/thread_pool.h"
+#include "core/scratch_alloc_type.hpp"
 
 #include <stdarg.h>
 
@@ -169,6 +171,8 @@ static void ShowHelp()
 		"  -p password         = Password to join server\n"
 		"  -P password         = Password to join company\n"
 		"  -D [ip][:port]      = Start dedicated server\n"
+		"  -B ticks            = Run the game for 'ticks' ticks as fast as possible as\n"
+		"                        dedicated server, print the timings as JSON and quit\n"
 		"  -l ip[:port]        = Redirect DEBUG()\n"
 #if !defined(_WIN32)
 		"  -f                  = Fork into the background (dedicated only)\n"
@@ -305,6 +309,7 @@ static void ShutdownGame()
 #endif
 
 	LinkGraphSchedule::Clear();
+	UninitThreadPool();
 	PoolBase::Clean(PT_ALL);
 
 	/* No NewGRFs were loaded when it was still bootstrapping. */
@@ -419,10 +424,13 @@ struct AfterNewGRFScan : NewGRFScanCallback {
 	{
 		ResetGRFConfig(false);
 
-		TarScanner::DoScan(TarScanner::SCENARIO);
+		{
+			FileScanCache scan_cache;
+			TarScanner::DoScan(TarScanner::SCENARIO);
 
-		AI::Initialize();
-		Game::Initialize();
+			AI::Initialize();
+			Game::Initialize();
+		}
 
 		/* We want the new (correct) NewGRF count to survive the loading. */
 		uint last_newgrf_count = _settings_client.gui.last_newgrf_count;
@@ -512,6 +520,7 @@ static const OptionData _options[] = {
 	 GETOPT_SHORT_VALUE('b'),
 #if defined(ENABLE_NETWORK)
 	GETOPT_SHORT_OPTVAL('D'),
+	 GETOPT_SHORT_VALUE('B'),
 	GETOPT_SHORT_OPTVAL('n'),
 	 GETOPT_SHORT_VALUE('l'),
 	 GETOPT_SHORT_VALUE('p'),
@@ -578,6 +587,7 @@ int openttd_main(int argc, char *argv[])
 		case 'v': free(videodriver); videodriver = stredup(mgo.opt); break;
 		case 'b': free(blitter); blitter = stredup(mgo.opt); break;
 #if defined(ENABLE_NETWORK)
+		case 'B':
 		case 'D':
 			free(musicdriver);
 			free(sounddriver);
@@ -585,11 +595,12 @@ int openttd_main(int argc, char *argv[])
 			free(blitter);
 			musicdriver = stredup("null");
 			sounddriver = stredup("null");
-			videodriver = stredup("dedicated");
+			/* The benchmark is a mode of the dedicated video driver, see VideoDriver_Dedicated::RunBenchmark. */
+			videodriver = i == 'B' ? str_fmt("dedicated:benchmark=%d", atoi(mgo.opt)) : stredup("dedicated");
 			blitter = stredup("null");
 			dedicated = true;
 			SetDebugString("net=6");
-			if (mgo.opt != NULL) {
+			if (i == 'D' && mgo.opt != NULL) {
 				/* Use the existing method for parsing (openttd -n).
 				 * However, we do ignore the #company part. */
 				const char *temp = NULL;
@@ -1198,6 +1209,9 @@ void SwitchToMode(SwitchMode new_mode)
  * Especially in the sense of desyncs between
  * the cached value and what the value would
  * be when calculated from the 'base' data.
+ * With the sampled_cache_checks setting every call only checks a slice of the
+ * objects, so all of them are checked once a day; the caches that can only be
+ * rebuilt as a whole are checked in the first slice.
  */
 static void CheckCaches()
 {
@@ -1205,44 +1219,58 @@ static void CheckCaches()
 	 * always to aid testing of caches. */
 	if (_debug_desync_level <= 1) return;
 
+	static uint slice = 0;
+	uint sweep = _settings_client.gui.sampled_cache_checks ? DAY_TICKS : 1;
+	slice = (slice + 1) % sweep;
+	bool global_checks = slice == 0;
+
 	/* Check the town caches. */
-	SmallVector<TownCache, 4> old_town_caches;
-	Town *t;
-	FOR_ALL_TOWNS(t) {
-		MemCpyT(old_town_caches.Append(), &t->cache);
-	}
+	uint i = 0;
+	if (global_checks) {
+		SmallVector<TownCache, 4> old_town_caches;
+		Town *t;
+		FOR_ALL_TOWNS(t) {
+			MemCpyT(old_town_caches.Append(), &t->cache);
+		}
 
-	extern void RebuildTownCaches();
-	RebuildTownCaches();
-	RebuildSubsidisedSourceAndDestinationCache();
+		extern void RebuildTownCaches();
+		RebuildTownCaches();
+		RebuildSubsidisedSourceAndDestinationCache();
 
-	uint i = 0;
-	FOR_ALL_TOWNS(t) {
-		if (MemCmpT(old_town_caches.Get(i), &t->cache) != 0) {
-			DEBUG(desync, 2, "town cache mismatch: town %i", (int)t->index);
+		FOR_ALL_TOWNS(t) {
+			if (MemCmpT(old_town_caches.Get(i), &t->cache) != 0) {
+				DEBUG(desync, 2, "town cache mismatch: town %i", (int)t->index);
+			}
+			i++;
 		}
-		i++;
 	}
 
-	/* Check company infrastructure cache. */
-	SmallVector<CompanyInfrastructure, 4> old_infrastructure;
+	/* Check company infrastructure cache. Recounting it scans the whole map,
+	 * so only do that when a command or ownership change might have changed
+	 * it, and once a day to catch changes made in other ways. */
 	Company *c;
-	FOR_ALL_COMPANIES(c) MemCpyT(old_infrastructure.Append(), &c->infrastructure);
+	if (global_checks && (sweep > 1 || _company_infrastructure_touched || _date_fract == 0)) {
+		_company_infrastructure_touched = false;
 
-	extern void AfterLoadCompanyStats();
-	AfterLoadCompanyStats();
+		SmallVector<CompanyInfrastructure, 4> old_infrastructure;
+		FOR_ALL_COMPANIES(c) MemCpyT(old_infrastructure.Append(), &c->infrastructure);
 
-	i = 0;
-	FOR_ALL_COMPANIES(c) {
-		if (MemCmpT(old_infrastructure.Get(i), &c->infrastructure) != 0) {
-			DEBUG(desync, 2, "infrastructure cache mismatch: company %i", (int)c->index);
+		extern void AfterLoadCompanyStats();
+		AfterLoadCompanyStats();
+
+		i = 0;
+		FOR_ALL_COMPANIES(c) {
+			if (MemCmpT(old_infrastructure.Get(i), &c->infrastructure) != 0) {
+				DEBUG(desync, 2, "infrastructure cache mismatch: company %i", (int)c->index);
+			}
+			i++;
 		}
-		i++;
 	}
 
 	/* Strict checking of the road stop cache entries */
 	const RoadStop *rs;
 	FOR_ALL_ROADSTOPS(rs) {
+		if (rs->index % sweep != slice) continue;
 		if (IsStandardRoadStopTile(rs->xy)) continue;
 
 		assert(rs->GetEntry(DIAGDIR_NE) != rs->GetEntry(DIAGDIR_NW));
@@ -1253,6 +1281,7 @@ static void CheckCaches()
 	Vehicle *v;
 	FOR_ALL_VEHICLES(v) {
 		extern void FillNewGRFVehicleCache(const Vehicle *v);
+		if (v->index % sweep != slice) continue;
 		if (v != v->First() || v->vehstatus & VS_CRASHED || !v->IsPrimaryVehicle()) continue;
 
 		uint length = 0;
@@ -1327,6 +1356,7 @@ static void CheckCaches()
 
 	/* Check whether the caches are still valid */
 	FOR_ALL_VEHICLES(v) {
+		if (v->index % sweep != slice) continue;
 		byte buff[sizeof(VehicleCargoList)];
 		memcpy(buff, &v->cargo, sizeof(VehicleCargoList));
 		v->cargo.InvalidateCache();
@@ -1335,6 +1365,7 @@ static void CheckCaches()
 
 	Station *st;
 	FOR_ALL_STATIONS(st) {
+		if (st->index % sweep != slice) continue;
 		for (CargoID c = 0; c < NUM_CARGO; c++) {
 			byte buff[sizeof(StationCargoList)];
 			memcpy(buff, &st->goods[c].cargo, sizeof(StationCargoList));
@@ -1365,6 +1396,7 @@ void StateGameLoop()
 #ifndef DEBUG_DUMP_COMMANDS
 		Game::GameLoop();
 #endif
+		ScratchArena::Get().Reset();
 		return;
 	}
 
@@ -1378,6 +1410,7 @@ void StateGameLoop()
 		BasePersistentStorageArray::SwitchMode(PSM_ENTER_GAMELOOP);
 		RunTileLoop();
 		CallVehicleTicks();
+		ScratchArena::Get().Reset();
 		CallLandscapeTick();
 		BasePersistentStorageArray::SwitchMode(PSM_LEAVE_GAMELOOP);
 		UpdateLandscapingLimits();
@@ -1403,6 +1436,9 @@ void StateGameLoop()
 		IncreaseDate();
 		RunTileLoop();
 		CallVehicleTicks();
+		/* Nothing from the scratch arena lives past a phase of the tick;
+		 * the vehicle ticks use the most, so hand it back right after them. */
+		ScratchArena::Get().Reset();
 		CallLandscapeTick();
 		BasePersistentStorageArray::SwitchMode(PSM_LEAVE_GAMELOOP);
 
@@ -1420,6 +1456,7 @@ void StateGameLoop()
 		cur_company.Restore();
 	}
 
+	ScratchArena::Get().Reset();
 	assert(IsLocalCompany());
 }
 
@@ -1461,6 +1498,7 @@ void GameLoop()
 	}
 
 	ProcessAsyncSaveFinish();
+	FinishSmallMapScreenshot(false);
 
 	/* autosave game? */
 	if (_do_autosave) {
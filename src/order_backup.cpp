@@ -18,6 +18,8 @@
 #include "vehicle_base.h"
 #include "window_func.h"
 #include "station_map.h"
+#include "vehicle_func.h"
+#include "core/name_registry_type.hpp"
 
 #include "safeguards.h"
 
@@ -84,7 +86,9 @@ void OrderBackup::DoRestore(Vehicle *v)
 		InvalidateWindowClassesData(WC_STATION_LIST, 0);
 	}
 
+	_vehicle_names.Remove(v->name);
 	v->CopyConsistPropertiesFrom(this);
+	_vehicle_names.Add(v->name);
 
 	/* Make sure orders are in range */
 	v->UpdateRealOrderIndex();
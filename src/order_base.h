@@ -20,8 +20,9 @@
 #include "station_type.h"
 #include "vehicle_type.h"
 #include "date_type.h"
+#include <vector>
 
-typedef Pool<Order, OrderID, 256, 0xFF0000> OrderPool;
+typedef Pool<Order, OrderID, 256, 0xFF0000, PT_NORMAL, false, true, true> OrderPool;
 typedef Pool<OrderList, OrderListID, 128, 64000> OrderListPool;
 extern OrderPool _order_pool;
 extern OrderListPool _orderlist_pool;
@@ -257,6 +258,7 @@ private:
 	StationID GetBestLoadableNext(const Vehicle *v, const Order *o1, const Order *o2) const;
 
 	Order *first;                     ///< First order of the order list.
+	std::vector<Order *> order_index; ///< NOSAVE: The orders of the chain by position, for constant time access to an order.
 	VehicleOrderID num_orders;        ///< NOSAVE: How many orders there are in the list.
 	VehicleOrderID num_manual_orders; ///< NOSAVE: How many manually added orders are there in the list.
 	uint num_vehicles;                ///< NOSAVE: Number of vehicles that share this order list.
@@ -265,11 +267,14 @@ private:
 	Ticks timetable_duration;         ///< NOSAVE: Total timetabled duration of the order list.
 	Ticks total_duration;             ///< NOSAVE: Total (timetabled or not) duration of the order list.
 
+	mutable bool complete_timetable;       ///< NOSAVE: Cached result of #IsCompleteTimetable.
+	mutable bool complete_timetable_valid; ///< NOSAVE: Whether #complete_timetable is up to date.
+
 public:
 	/** Default constructor producing an invalid order list. */
 	OrderList(VehicleOrderID num_orders = INVALID_VEH_ORDER_ID)
 		: first(NULL), num_orders(num_orders), num_manual_orders(0), num_vehicles(0), first_shared(NULL),
-		  timetable_duration(0), total_duration(0) { }
+		  timetable_duration(0), total_duration(0), complete_timetable(true), complete_timetable_valid(false) { }
 
 	/**
 	 * Create an order list with the given order chain for the given vehicle.
@@ -357,6 +362,12 @@ public:
 
 	bool IsCompleteTimetable() const;
 
+	/**
+	 * Must be called if the timetable of an order or anything deciding whether
+	 * the order needs a timetable is changed, so #IsCompleteTimetable looks again.
+	 */
+	inline void InvalidateCompleteTimetable() { this->complete_timetable_valid = false; }
+
 	/**
 	 * Gets the total duration of the vehicles timetable or INVALID_TICKS is the timetable is not complete.
 	 * @return total timetable duration or INVALID_TICKS for incomplete timetables
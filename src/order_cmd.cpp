@@ -300,8 +300,11 @@ void OrderList::Initialize(Order *chain, Vehicle *v)
 	this->num_vehicles = 1;
 	this->timetable_duration = 0;
 	this->total_duration = 0;
+	this->complete_timetable_valid = false;
+	this->order_index.clear();
 
 	for (Order *o = this->first; o != NULL; o = o->next) {
+		this->order_index.push_back(o);
 		++this->num_orders;
 		if (!o->IsType(OT_IMPLICIT)) ++this->num_manual_orders;
 		this->timetable_duration += o->GetTimetabledWait() + o->GetTimetabledTravel();
@@ -331,9 +334,11 @@ void OrderList::FreeChain(bool keep_orderlist)
 
 	if (keep_orderlist) {
 		this->first = NULL;
+		this->order_index.clear();
 		this->num_orders = 0;
 		this->num_manual_orders = 0;
 		this->timetable_duration = 0;
+		this->complete_timetable_valid = false;
 	} else {
 		delete this;
 	}
@@ -346,14 +351,9 @@ void OrderList::FreeChain(bool keep_orderlist)
  */
 Order *OrderList::GetOrderAt(int index) const
 {
-	if (index < 0) return NULL;
+	if (index < 0 || (uint)index >= this->order_index.size()) return NULL;
 
-	Order *order = this->first;
-
-	while (order != NULL && index-- > 0) {
-		order = order->next;
-	}
-	return order;
+	return this->order_index[index];
 }
 
 /**
@@ -478,10 +478,12 @@ void OrderList::InsertOrderAt(Order *new_order, int index)
 			order->next = new_order;
 		}
 	}
+	this->order_index.insert(this->order_index.begin() + min<int>(index, this->num_orders), new_order);
 	++this->num_orders;
 	if (!new_order->IsType(OT_IMPLICIT)) ++this->num_manual_orders;
 	this->timetable_duration += new_order->GetTimetabledWait() + new_order->GetTimetabledTravel();
 	this->total_duration += new_order->GetWaitTime() + new_order->GetTravelTime();
+	this->complete_timetable_valid = false;
 
 	/* We can visit oil rigs and buoys that are not our own. They will be shown in
 	 * the list of stations. So, we need to invalidate that window if needed. */
@@ -511,10 +513,12 @@ void OrderList::DeleteOrderAt(int index)
 		to_remove = prev->next;
 		prev->next = to_remove->next;
 	}
+	this->order_index.erase(this->order_index.begin() + index);
 	--this->num_orders;
 	if (!to_remove->IsType(OT_IMPLICIT)) --this->num_manual_orders;
 	this->timetable_duration -= (to_remove->GetTimetabledWait() + to_remove->GetTimetabledTravel());
 	this->total_duration -= (to_remove->GetWaitTime() + to_remove->GetTravelTime());
+	this->complete_timetable_valid = false;
 	delete to_remove;
 }
 
@@ -539,6 +543,11 @@ void OrderList::MoveOrder(int from, int to)
 		one_before->next = moving_one->next;
 	}
 
+	/* Update the index before looking up the new neighbour of the moving order;
+	 * otherwise moving it down would use the position it had before unlinking. */
+	this->order_index.erase(this->order_index.begin() + from);
+	this->order_index.insert(this->order_index.begin() + to, moving_one);
+
 	/* Insert the moving_order again in the pointer-chain */
 	if (to == 0) {
 		moving_one->next = this->first;
@@ -588,16 +597,25 @@ int OrderList::GetPositionInSharedOrderList(const Vehicle *v) const
 
 /**
  * Checks whether all orders of the list have a filled timetable.
+ * The answer is cached until #InvalidateCompleteTimetable is called, as
+ * vehicles ask this on every timetabled order they finish.
  * @return whether all orders have a filled timetable.
  */
 bool OrderList::IsCompleteTimetable() const
 {
+	if (this->complete_timetable_valid) return this->complete_timetable;
+
+	this->complete_timetable = true;
+	this->complete_timetable_valid = true;
 	for (Order *o = this->first; o != NULL; o = o->next) {
 		/* Implicit orders are, by definition, not timetabled. */
 		if (o->IsType(OT_IMPLICIT)) continue;
-		if (!o->IsCompletelyTimetabled()) return false;
+		if (!o->IsCompletelyTimetabled()) {
+			this->complete_timetable = false;
+			break;
+		}
 	}
-	return true;
+	return this->complete_timetable;
 }
 
 /**
@@ -614,15 +632,24 @@ void OrderList::DebugCheckSanity() const
 	DEBUG(misc, 6, "Checking OrderList %hu for sanity...", this->index);
 
 	for (const Order *o = this->first; o != NULL; o = o->next) {
+		/* The chain and the index must agree on every position; this also
+		 * catches orders moved to a wrong place or linked to themselves. */
+		assert(check_num_orders < this->order_index.size());
+		assert(this->order_index[check_num_orders] == o);
 		++check_num_orders;
 		if (!o->IsType(OT_IMPLICIT)) ++check_num_manual_orders;
 		check_timetable_duration += o->GetTimetabledWait() + o->GetTimetabledTravel();
 		check_total_duration += o->GetWaitTime() + o->GetTravelTime();
 	}
 	assert(this->num_orders == check_num_orders);
+	assert(this->order_index.size() == check_num_orders);
 	assert(this->num_manual_orders == check_num_manual_orders);
 	assert(this->timetable_duration == check_timetable_duration);
 	assert(this->total_duration == check_total_duration);
+	if (this->complete_timetable_valid) {
+		this->complete_timetable_valid = false;
+		assert(this->complete_timetable == this->IsCompleteTimetable());
+	}
 
 	for (const Vehicle *v = this->first_shared; v != NULL; v = v->NextShared()) {
 		++check_num_vehicles;
@@ -1493,6 +1520,9 @@ CommandCost CmdModifyOrder(TileIndex tile, DoCommandFlag flags, uint32 p1, uint3
 			default: NOT_REACHED();
 		}
 
+		/* Whether the vehicle stops at the destination decides whether the order needs a wait time. */
+		v->orders.list->InvalidateCompleteTimetable();
+
 		/* Update the windows and full load flags, also for vehicles that share the same order list */
 		Vehicle *u = v->FirstShared();
 		DeleteOrderWarnings(u);
@@ -1888,6 +1918,7 @@ restart:
 				bool travel_timetabled = order->IsTravelTimetabled();
 				order->MakeDummy();
 				order->SetTravelTimetabled(travel_timetabled);
+				v->orders.list->InvalidateCompleteTimetable();
 
 				for (const Vehicle *w = v->FirstShared(); w != NULL; w = w->NextShared()) {
 					/* In GUI, simulate by removing the order and adding it back */
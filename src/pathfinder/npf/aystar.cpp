@@ -260,6 +260,7 @@ int AyStar::Main()
 #endif
 	if (r != AYSTAR_STILL_BUSY) {
 		/* We're done, clean up */
+		this->num_expanded = this->closedlist_hash.GetSize();
 		this->Clear();
 	}
 
@@ -292,15 +293,15 @@ void AyStar::AddStartNode(AyStarNode *start_node, uint g)
  * Initialize an #AyStar. You should fill all appropriate fields before
  * calling #Init (see the declaration of #AyStar for which fields are internal).
  */
-void AyStar::Init(Hash_HashProc hash, uint num_buckets)
+void AyStar::Init(uint num_buckets)
 {
 	/* Allocated the Hash for the OpenList and ClosedList */
-	this->openlist_hash.Init(hash, num_buckets);
-	this->closedlist_hash.Init(hash, num_buckets);
+	this->openlist_hash.Init(num_buckets);
+	this->closedlist_hash.Init(num_buckets);
 
 	/* Set up our sorting queue
 	 *  BinaryHeap allocates a block of 1024 nodes
-	 *  When that one gets full it reserves another one, till this number
+	 *  When that one gets full it doubles its space, till this number
 	 *  That is why it can stay this high */
 	this->openlist_queue.Init(102400);
 }
@@ -140,13 +140,14 @@ struct AyStar {
 	byte loops_per_tick;   ///< How many loops are there called before Main() gives control back to the caller. 0 = until done.
 	uint max_path_cost;    ///< If the g-value goes over this number, it stops searching, 0 = infinite.
 	uint max_search_nodes; ///< The maximum number of nodes that will be expanded, 0 = infinite.
+	uint num_expanded;     ///< The number of nodes expanded by the last search, set when it ends.
 
 	/* These should be filled with the neighbours of a tile by
 	 * GetNeighbours */
 	AyStarNode neighbours[12];
 	byte num_neighbours;
 
-	void Init(Hash_HashProc hash, uint num_buckets);
+	void Init(uint num_buckets);
 
 	/* These will contain the methods for manipulating the AyStar. Only
 	 * Main() should be called externally */
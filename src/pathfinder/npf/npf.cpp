@@ -17,15 +17,13 @@
 #include "../pathfinder_func.h"
 #include "../pathfinder_type.h"
 #include "../follow_track.hpp"
+#include "../pf_performance_timer.hpp"
+#include "../pathfinder_stats.h"
 #include "aystar.h"
 
 #include "../../safeguards.h"
 
-static const uint NPF_HASH_BITS = 12; ///< The size of the hash used in pathfinding. Just changing this value should be sufficient to change the hash size. Should be an even value.
-/* Do no change below values */
-static const uint NPF_HASH_SIZE = 1 << NPF_HASH_BITS;
-static const uint NPF_HASH_HALFBITS = NPF_HASH_BITS / 2;
-static const uint NPF_HASH_HALFMASK = (1 << NPF_HASH_HALFBITS) - 1;
+static const uint NPF_HASH_SIZE = 1 << 12; ///< The number of nodes the hashes used in pathfinding initially have space for.
 
 /** Meant to be stored in AyStar.targetdata */
 struct NPFFindStationOrTileData {
@@ -129,24 +127,6 @@ static uint NPFDistanceTrack(TileIndex t0, TileIndex t1)
 	return diagTracks * NPF_TILE_LENGTH + straightTracks * NPF_TILE_LENGTH * STRAIGHT_TRACK_LENGTH;
 }
 
-/**
- * Calculates a hash value for use in the NPF.
- * @param key1 The TileIndex of the tile to hash
- * @param key2 The Trackdir of the track on the tile.
- *
- * @todo Think of a better hash.
- */
-static uint NPFHash(uint key1, uint key2)
-{
-	/* TODO: think of a better hash? */
-	uint part1 = TileX(key1) & NPF_HASH_HALFMASK;
-	uint part2 = TileY(key1) & NPF_HASH_HALFMASK;
-
-	assert(IsValidTrackdir((Trackdir)key2));
-	assert(IsValidTile(key1));
-	return ((part1 << NPF_HASH_HALFBITS | part2) + (NPF_HASH_SIZE * key2 / TRACKDIR_END)) % NPF_HASH_SIZE;
-}
-
 static int32 NPFCalcZero(AyStar *as, AyStarNode *current, OpenListNode *parent)
 {
 	return 0;
@@ -1013,8 +993,14 @@ static NPFFoundTargetData NPFRouteInternal(AyStarNode *start1, bool ignore_start
 	_npf_aystar.user_data = user;
 
 	/* GO! */
+	CPerformanceTimer perf;
+	perf.Start();
 	r = _npf_aystar.Main();
 	assert(r != AYSTAR_STILL_BUSY);
+	perf.Stop();
+
+	static const VehicleType TRANSPORT_VEHICLE_TYPE[] = { VEH_TRAIN, VEH_ROAD, VEH_SHIP };
+	RecordPathfinderCall(user->owner, TRANSPORT_VEHICLE_TYPE[user->type], _npf_aystar.num_expanded, 0, 0, max(perf.Get(1000000), 0), result.best_bird_dist == 0);
 
 	if (result.best_bird_dist != 0) {
 		if (target != NULL) {
@@ -1079,7 +1065,7 @@ void InitializeNPF()
 	static bool first_init = true;
 	if (first_init) {
 		first_init = false;
-		_npf_aystar.Init(NPFHash, NPF_HASH_SIZE);
+		_npf_aystar.Init(NPF_HASH_SIZE);
 	} else {
 		_npf_aystar.Clear();
 	}
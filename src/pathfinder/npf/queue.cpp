@@ -11,6 +11,8 @@
 
 #include "../../stdafx.h"
 #include "../../core/alloc_func.hpp"
+#include "../../core/mem_func.hpp"
+#include "../../core/math_func.hpp"
 #include "queue.h"
 
 #include "../../safeguards.h"
@@ -21,45 +23,21 @@
  * For information, see: http://www.policyalmanac.org/games/binaryHeaps.htm
  */
 
-const int BinaryHeap::BINARY_HEAP_BLOCKSIZE_BITS = 10; ///< The number of elements that will be malloc'd at a time.
-const int BinaryHeap::BINARY_HEAP_BLOCKSIZE      = 1 << BinaryHeap::BINARY_HEAP_BLOCKSIZE_BITS;
-const int BinaryHeap::BINARY_HEAP_BLOCKSIZE_MASK = BinaryHeap::BINARY_HEAP_BLOCKSIZE - 1;
+const uint BinaryHeap::BINARY_HEAP_ARITY     = 4;    ///< The number of children of each element.
+const uint BinaryHeap::BINARY_HEAP_BLOCKSIZE = 1024; ///< The number of elements that will be malloc'd at first.
 
 /**
  * Clears the queue, by removing all values from it. Its state is
  * effectively reset. If free_items is true, each of the items cleared
- * in this way are free()'d.
+ * in this way are free()'d. The memory of the queue itself is kept,
+ * so it can be filled again without allocating.
  */
 void BinaryHeap::Clear(bool free_values)
 {
-	/* Free all items if needed and free all but the first blocks of memory */
-	uint i;
-	uint j;
-
-	for (i = 0; i < this->blocks; i++) {
-		if (this->elements[i] == NULL) {
-			/* No more allocated blocks */
-			break;
-		}
-		/* For every allocated block */
-		if (free_values) {
-			for (j = 0; j < (1 << BINARY_HEAP_BLOCKSIZE_BITS); j++) {
-				/* For every element in the block */
-				if ((this->size >> BINARY_HEAP_BLOCKSIZE_BITS) == i &&
-						(this->size & BINARY_HEAP_BLOCKSIZE_MASK) == j) {
-					break; // We're past the last element
-				}
-				free(this->elements[i][j].item);
-			}
-		}
-		if (i != 0) {
-			/* Leave the first block of memory alone */
-			free(this->elements[i]);
-			this->elements[i] = NULL;
-		}
+	if (free_values) {
+		for (uint i = 0; i < this->size; i++) free(this->elements[i].item);
 	}
 	this->size = 0;
-	this->blocks = 1;
 }
 
 /**
@@ -69,14 +47,55 @@ void BinaryHeap::Clear(bool free_values)
  */
 void BinaryHeap::Free(bool free_values)
 {
-	uint i;
-
 	this->Clear(free_values);
-	for (i = 0; i < this->blocks; i++) {
-		if (this->elements[i] == NULL) break;
-		free(this->elements[i]);
-	}
 	free(this->elements);
+	this->elements = NULL;
+	this->capacity = 0;
+}
+
+/**
+ * Moves an element towards the top of the heap until its parent is better.
+ * @param i Index of the element.
+ */
+void BinaryHeap::SiftUp(uint i)
+{
+	BinaryHeapNode node = this->elements[i];
+
+	while (i > 0) {
+		uint parent = (i - 1) / BINARY_HEAP_ARITY;
+		/* Is the parent bigger than the current, move it down */
+		if (node.priority > this->elements[parent].priority) break;
+		this->elements[i] = this->elements[parent];
+		i = parent;
+	}
+	this->elements[i] = node;
+}
+
+/**
+ * Moves an element towards the bottom of the heap until none of its children is better.
+ * @param i Index of the element.
+ */
+void BinaryHeap::SiftDown(uint i)
+{
+	BinaryHeapNode node = this->elements[i];
+
+	for (;;) {
+		uint first = i * BINARY_HEAP_ARITY + 1;
+		if (first >= this->size) break;
+
+		/* Find the smallest child; on ties the last one wins, like it always did */
+		uint last = min(first + BINARY_HEAP_ARITY, this->size);
+		uint best = first;
+		for (uint child = first + 1; child < last; child++) {
+			if (this->elements[child].priority <= this->elements[best].priority) best = child;
+		}
+
+		/* None of our children is smaller, so we stay here */
+		if (node.priority < this->elements[best].priority) break;
+		this->elements[i] = this->elements[best];
+		i = best;
+	}
+	this->elements[i] = node;
 }
 
 /**
@@ -88,41 +107,17 @@ bool BinaryHeap::Push(void *item, int priority)
 	if (this->size == this->max_size) return false;
 	assert(this->size < this->max_size);
 
-	if (this->elements[this->size >> BINARY_HEAP_BLOCKSIZE_BITS] == NULL) {
-		/* The currently allocated blocks are full, allocate a new one */
-		assert((this->size & BINARY_HEAP_BLOCKSIZE_MASK) == 0);
-		this->elements[this->size >> BINARY_HEAP_BLOCKSIZE_BITS] = MallocT<BinaryHeapNode>(BINARY_HEAP_BLOCKSIZE);
-		this->blocks++;
+	if (this->size == this->capacity) {
+		/* The allocated space is full, double it */
+		this->capacity = min(max(this->capacity * 2, BINARY_HEAP_BLOCKSIZE), this->max_size);
+		this->elements = ReallocT(this->elements, this->capacity);
 	}
 
-	/* Add the item at the end of the array */
-	this->GetElement(this->size + 1).priority = priority;
-	this->GetElement(this->size + 1).item = item;
+	/* Add the item at the end of the array and let it rise to where it belongs */
+	this->elements[this->size].priority = priority;
+	this->elements[this->size].item = item;
 	this->size++;
-
-	/* Now we are going to check where it belongs. As long as the parent is
-	 * bigger, we switch with the parent */
-	{
-		BinaryHeapNode temp;
-		int i;
-		int j;
-
-		i = this->size;
-		while (i > 1) {
-			/* Get the parent of this object (divide by 2) */
-			j = i / 2;
-			/* Is the parent bigger than the current, switch them */
-			if (this->GetElement(i).priority <= this->GetElement(j).priority) {
-				temp = this->GetElement(j);
-				this->GetElement(j) = this->GetElement(i);
-				this->GetElement(i) = temp;
-				i = j;
-			} else {
-				/* It is not, we're done! */
-				break;
-			}
-		}
-	}
+	this->SiftUp(this->size - 1);
 
 	return true;
 }
@@ -134,54 +129,25 @@ bool BinaryHeap::Push(void *item, int priority)
  */
 bool BinaryHeap::Delete(void *item, int priority)
 {
-	uint i = 0;
+	uint i;
 
 	/* First, we try to find the item.. */
-	do {
-		if (this->GetElement(i + 1).item == item) break;
-		i++;
-	} while (i < this->size);
+	for (i = 0; i < this->size; i++) {
+		if (this->elements[i].item == item) break;
+	}
 	/* We did not find the item, so we return false */
 	if (i == this->size) return false;
 
 	/* Now we put the last item over the current item while decreasing the size of the elements */
 	this->size--;
-	this->GetElement(i + 1) = this->GetElement(this->size + 1);
-
-	/* Now the only thing we have to do, is resort it..
-	 * On place i there is the item to be sorted.. let's start there */
-	{
-		uint j;
-		BinaryHeapNode temp;
-		/* Because of the fact that Binary Heap uses array from 1 to n, we need to
-		 * increase i by 1
-		 */
-		i++;
-
-		for (;;) {
-			j = i;
-			/* Check if we have 2 children */
-			if (2 * j + 1 <= this->size) {
-				/* Is this child smaller than the parent? */
-				if (this->GetElement(j).priority >= this->GetElement(2 * j).priority) i = 2 * j;
-				/* Yes, we _need_ to use i here, not j, because we want to have the smallest child
-				 *  This way we get that straight away! */
-				if (this->GetElement(i).priority >= this->GetElement(2 * j + 1).priority) i = 2 * j + 1;
-			/* Do we have one child? */
-			} else if (2 * j <= this->size) {
-				if (this->GetElement(j).priority >= this->GetElement(2 * j).priority) i = 2 * j;
-			}
-
-			/* One of our children is smaller than we are, switch */
-			if (i != j) {
-				temp = this->GetElement(j);
-				this->GetElement(j) = this->GetElement(i);
-				this->GetElement(i) = temp;
-			} else {
-				/* None of our children is smaller, so we stay here.. stop :) */
-				break;
-			}
-		}
+	if (i == this->size) return true;
+	this->elements[i] = this->elements[this->size];
+
+	/* The moved item may belong either higher or lower in the heap */
+	if (i > 0 && this->elements[i].priority <= this->elements[(i - 1) / BINARY_HEAP_ARITY].priority) {
+		this->SiftUp(i);
+	} else {
+		this->SiftDown(i);
 	}
 
 	return true;
@@ -193,58 +159,51 @@ bool BinaryHeap::Delete(void *item, int priority)
  */
 void *BinaryHeap::Pop()
 {
-	void *result;
-
 	if (this->size == 0) return NULL;
 
 	/* The best item is always on top, so give that as result */
-	result = this->GetElement(1).item;
+	void *result = this->elements[0].item;
+
 	/* And now we should get rid of this item... */
-	this->Delete(this->GetElement(1).item, this->GetElement(1).priority);
+	this->size--;
+	if (this->size > 0) {
+		this->elements[0] = this->elements[this->size];
+		this->SiftDown(0);
+	}
 
 	return result;
 }
 
 /**
- * Initializes a binary heap and allocates internal memory for maximum of
- * max_size elements
+ * Initializes a binary heap for a maximum of max_size elements.
+ * Memory is allocated when the first element is pushed.
  */
 void BinaryHeap::Init(uint max_size)
 {
 	this->max_size = max_size;
 	this->size = 0;
-	/* We malloc memory in block of BINARY_HEAP_BLOCKSIZE
-	 *   It autosizes when it runs out of memory */
-	this->elements = CallocT<BinaryHeapNode*>((max_size - 1) / BINARY_HEAP_BLOCKSIZE + 1);
-	this->elements[0] = MallocT<BinaryHeapNode>(BINARY_HEAP_BLOCKSIZE);
-	this->blocks = 1;
+	this->capacity = 0;
+	this->elements = NULL;
 }
 
-/* Because we don't want anyone else to bother with our defines */
-#undef BIN_HEAP_ARR
-
 /*
  * Hash
  */
 
 /**
- * Builds a new hash in an existing struct. Make sure that hash() always
- * returns a hash less than num_buckets! Call delete_hash after use
+ * Builds a new hash in an existing struct. Space is reserved for
+ * num_buckets items; the hash grows when more are added.
+ * Call Delete after use.
  */
-void Hash::Init(Hash_HashProc *hash, uint num_buckets)
+void Hash::Init(uint num_buckets)
 {
-	/* Allocate space for the Hash, the buckets and the bucket flags */
-	uint i;
+	uint slots = 16;
+	/* Keep the table at most half full */
+	while (slots < num_buckets * 2) slots *= 2;
 
-	/* Ensure the size won't overflow. */
-	CheckAllocationConstraints(sizeof(*this->buckets) + sizeof(*this->buckets_in_use), num_buckets);
-
-	this->hash = hash;
 	this->size = 0;
-	this->num_buckets = num_buckets;
-	this->buckets = (HashNode*)MallocT<byte>(num_buckets * (sizeof(*this->buckets) + sizeof(*this->buckets_in_use)));
-	this->buckets_in_use = (bool*)(this->buckets + num_buckets);
-	for (i = 0; i < num_buckets; i++) this->buckets_in_use[i] = false;
+	this->mask = slots - 1;
+	this->nodes = CallocT<HashNode>(slots);
 }
 
 /**
@@ -254,80 +213,35 @@ void Hash::Init(Hash_HashProc *hash, uint num_buckets)
  */
 void Hash::Delete(bool free_values)
 {
-	uint i;
-
-	/* Iterate all buckets */
-	for (i = 0; i < this->num_buckets; i++) {
-		if (this->buckets_in_use[i]) {
-			HashNode *node;
-
-			/* Free the first value */
-			if (free_values) free(this->buckets[i].value);
-			node = this->buckets[i].next;
-			while (node != NULL) {
-				HashNode *prev = node;
-
-				node = node->next;
-				/* Free the value */
-				if (free_values) free(prev->value);
-				/* Free the node */
-				free(prev);
-			}
-		}
+	if (free_values) {
+		for (uint i = 0; i <= this->mask; i++) free(this->nodes[i].value);
 	}
-	free(this->buckets);
-	/* No need to free buckets_in_use, it is always allocated in one
-	 * malloc with buckets */
+	free(this->nodes);
+	this->nodes = NULL;
 }
 
 #ifdef HASH_STATS
 void Hash::PrintStatistics() const
 {
-	uint used_buckets = 0;
-	uint max_collision = 0;
-	uint max_usage = 0;
-	uint usage[200];
-	uint i;
+	uint max_distance = 0;
+	uint total_distance = 0;
 
-	for (i = 0; i < lengthof(usage); i++) usage[i] = 0;
-	for (i = 0; i < this->num_buckets; i++) {
-		uint collision = 0;
-		if (this->buckets_in_use[i]) {
-			const HashNode *node;
+	for (uint i = 0; i <= this->mask; i++) {
+		const HashNode *node = &this->nodes[i];
+		if (node->value == NULL) continue;
 
-			used_buckets++;
-			for (node = &this->buckets[i]; node != NULL; node = node->next) collision++;
-			if (collision > max_collision) max_collision = collision;
-		}
-		if (collision >= lengthof(usage)) collision = lengthof(usage) - 1;
-		usage[collision]++;
-		if (collision > 0 && usage[collision] >= max_usage) {
-			max_usage = usage[collision];
-		}
+		uint distance = (i - this->GetHomeSlot(node->key1, node->key2)) & this->mask;
+		total_distance += distance;
+		if (distance > max_distance) max_distance = distance;
 	}
 	printf(
 		"---\n"
 		"Hash size: %d\n"
 		"Nodes used: %d\n"
-		"Non empty buckets: %d\n"
-		"Max collision: %d\n",
-		this->num_buckets, this->size, used_buckets, max_collision
+		"Max probe distance: %d\n"
+		"Average probe distance: %.2f\n",
+		this->mask + 1, this->size, max_distance, this->size == 0 ? 0.0 : (double)total_distance / this->size
 	);
-	printf("{ ");
-	for (i = 0; i <= max_collision; i++) {
-		if (usage[i] > 0) {
-			printf("%d:%d ", i, usage[i]);
-#if 0
-			if (i > 0) {
-				uint j;
-
-				for (j = 0; j < usage[i] * 160 / 800; j++) putchar('#');
-			}
-			printf("\n");
-#endif
-		}
-	}
-	printf ("}\n");
 }
 #endif
 
@@ -336,71 +250,52 @@ void Hash::PrintStatistics() const
  */
 void Hash::Clear(bool free_values)
 {
-	uint i;
-
 #ifdef HASH_STATS
 	if (this->size > 2000) this->PrintStatistics();
 #endif
 
-	/* Iterate all buckets */
-	for (i = 0; i < this->num_buckets; i++) {
-		if (this->buckets_in_use[i]) {
-			HashNode *node;
-
-			this->buckets_in_use[i] = false;
-			/* Free the first value */
-			if (free_values) free(this->buckets[i].value);
-			node = this->buckets[i].next;
-			while (node != NULL) {
-				HashNode *prev = node;
-
-				node = node->next;
-				if (free_values) free(prev->value);
-				free(prev);
-			}
-		}
+	if (this->size == 0) return;
+
+	if (free_values) {
+		for (uint i = 0; i <= this->mask; i++) free(this->nodes[i].value);
 	}
+	MemSetT(this->nodes, 0, this->mask + 1);
 	this->size = 0;
 }
 
 /**
- * Finds the node that that saves this key pair. If it is not
- * found, returns NULL. If it is found, *prev is set to the
- * node before the one found, or if the node found was the first in the bucket
- * to NULL. If it is not found, *prev is set to the last HashNode in the
- * bucket, or NULL if it is empty. prev can also be NULL, in which case it is
- * not used for output.
+ * Finds the slot that saves this key pair, or the empty slot where it
+ * would be saved if it is not present.
+ * @param key1 First key.
+ * @param key2 Second key.
+ * @return Index of the slot.
  */
-HashNode *Hash::FindNode(uint key1, uint key2, HashNode** prev_out) const
+uint Hash::FindSlot(uint key1, uint key2) const
 {
-	uint hash = this->hash(key1, key2);
-	HashNode *result = NULL;
-
-	/* Check if the bucket is empty */
-	if (!this->buckets_in_use[hash]) {
-		if (prev_out != NULL) *prev_out = NULL;
-		result = NULL;
-	/* Check the first node specially */
-	} else if (this->buckets[hash].key1 == key1 && this->buckets[hash].key2 == key2) {
-		/* Save the value */
-		result = this->buckets + hash;
-		if (prev_out != NULL) *prev_out = NULL;
-	/* Check all other nodes */
-	} else {
-		HashNode *prev = this->buckets + hash;
-		HashNode *node;
-
-		for (node = prev->next; node != NULL; node = node->next) {
-			if (node->key1 == key1 && node->key2 == key2) {
-				/* Found it */
-				result = node;
-				break;
-			}
-			prev = node;
-		}
-		if (prev_out != NULL) *prev_out = prev;
+	uint i = this->GetHomeSlot(key1, key2);
+	for (;;) {
+		const HashNode *node = &this->nodes[i];
+		if (node->value == NULL || (node->key1 == key1 && node->key2 == key2)) return i;
+		i = (i + 1) & this->mask;
 	}
-	return result;
+}
+
+/**
+ * Doubles the number of slots, and moves all items to their new place.
+ */
+void Hash::Grow()
+{
+	HashNode *old_nodes = this->nodes;
+	uint old_mask = this->mask;
+
+	this->mask = old_mask * 2 + 1;
+	this->nodes = CallocT<HashNode>(this->mask + 1);
+
+	for (uint i = 0; i <= old_mask; i++) {
+		if (old_nodes[i].value == NULL) continue;
+		this->nodes[this->FindSlot(old_nodes[i].key1, old_nodes[i].key2)] = old_nodes[i];
+	}
+	free(old_nodes);
 }
 
 /**
@@ -410,40 +305,22 @@ HashNode *Hash::FindNode(uint key1, uint key2, HashNode** prev_out) const
  */
 void *Hash::DeleteValue(uint key1, uint key2)
 {
-	void *result;
-	HashNode *prev; // Used as output var for below function call
-	HashNode *node = this->FindNode(key1, key2, &prev);
-
-	if (node == NULL) {
-		/* not found */
-		result = NULL;
-	} else if (prev == NULL) {
-		/* It is in the first node, we can't free that one, so we free
-		 * the next one instead (if there is any)*/
-		/* Save the value */
-		result = node->value;
-		if (node->next != NULL) {
-			HashNode *next = node->next;
-			/* Copy the second to the first */
-			*node = *next;
-			/* Free the second */
-			free(next);
-		} else {
-			/* This was the last in this bucket
-			 * Mark it as empty */
-			uint hash = this->hash(key1, key2);
-			this->buckets_in_use[hash] = false;
+	uint i = this->FindSlot(key1, key2);
+	void *result = this->nodes[i].value;
+	if (result == NULL) return NULL;
+
+	/* Move later items of the same run back into the hole, so no
+	 * lookup ends at an empty slot before reaching its item */
+	for (uint j = (i + 1) & this->mask; this->nodes[j].value != NULL; j = (j + 1) & this->mask) {
+		uint home = this->GetHomeSlot(this->nodes[j].key1, this->nodes[j].key2);
+		if (((j - home) & this->mask) >= ((j - i) & this->mask)) {
+			this->nodes[i] = this->nodes[j];
+			i = j;
 		}
-	} else {
-		/* It is in another node
-		 * Save the value */
-		result = node->value;
-		/* Link previous and next nodes */
-		prev->next = node->next;
-		/* Free the node */
-		free(node);
 	}
-	if (result != NULL) this->size--;
+	this->nodes[i].value = NULL;
+
+	this->size--;
 	return result;
 }
 
@@ -453,28 +330,24 @@ void *Hash::DeleteValue(uint key1, uint key2)
  */
 void *Hash::Set(uint key1, uint key2, void *value)
 {
-	HashNode *prev;
-	HashNode *node = this->FindNode(key1, key2, &prev);
+	assert(value != NULL);
 
-	if (node != NULL) {
+	uint i = this->FindSlot(key1, key2);
+	HashNode *node = &this->nodes[i];
+
+	if (node->value != NULL) {
 		/* Found it */
 		void *result = node->value;
 
 		node->value = value;
 		return result;
 	}
-	/* It is not yet present, let's add it */
-	if (prev == NULL) {
-		/* The bucket is still empty */
-		uint hash = this->hash(key1, key2);
-		this->buckets_in_use[hash] = true;
-		node = this->buckets + hash;
-	} else {
-		/* Add it after prev */
-		node = MallocT<HashNode>(1);
-		prev->next = node;
+
+	/* It is not yet present, let's add it; keep the table at most half full */
+	if ((this->size + 1) * 2 > this->mask + 1) {
+		this->Grow();
+		node = &this->nodes[this->FindSlot(key1, key2)];
 	}
-	node->next = NULL;
 	node->key1 = key1;
 	node->key2 = key2;
 	node->value = value;
@@ -488,7 +361,5 @@ void *Hash::Set(uint key1, uint key2, void *value)
  */
 void *Hash::Get(uint key1, uint key2) const
 {
-	HashNode *node = this->FindNode(key1, key2, NULL);
-
-	return (node != NULL) ? node->value : NULL;
+	return this->nodes[this->FindSlot(key1, key2)].value;
 }
@@ -7,7 +7,7 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file queue.h Binary heap implementation, hash implementation. */
+/** @file queue.h Heap implementation, hash implementation. */
 
 #ifndef QUEUE_H
 #define QUEUE_H
@@ -22,13 +22,14 @@ struct BinaryHeapNode {
 
 
 /**
- * Binary Heap.
+ * Heap in which every node has #BINARY_HEAP_ARITY children, stored in one
+ * contiguous array. With four children per node the heap is half as deep as
+ * a binary heap and the children of a node share a cache line.
  * For information, see: http://www.policyalmanac.org/games/binaryHeaps.htm
  */
 struct BinaryHeap {
-	static const int BINARY_HEAP_BLOCKSIZE;
-	static const int BINARY_HEAP_BLOCKSIZE_BITS;
-	static const int BINARY_HEAP_BLOCKSIZE_MASK;
+	static const uint BINARY_HEAP_ARITY;
+	static const uint BINARY_HEAP_BLOCKSIZE;
 
 	void Init(uint max_size);
 
@@ -38,21 +39,14 @@ struct BinaryHeap {
 	void Clear(bool free_values);
 	void Free(bool free_values);
 
-	/**
-	 * Get an element from the #elements.
-	 * @param i Element to access (starts at offset \c 1).
-	 * @return Value of the element.
-	 */
-	inline BinaryHeapNode &GetElement(uint i)
-	{
-		assert(i > 0);
-		return this->elements[(i - 1) >> BINARY_HEAP_BLOCKSIZE_BITS][(i - 1) & BINARY_HEAP_BLOCKSIZE_MASK];
-	}
-
 	uint max_size;
 	uint size;
-	uint blocks; ///< The amount of blocks for which space is reserved in elements
-	BinaryHeapNode **elements;
+	uint capacity;            ///< The amount of elements for which space is reserved in elements
+	BinaryHeapNode *elements; ///< The elements of the heap, the best one first
+
+protected:
+	void SiftUp(uint i);
+	void SiftDown(uint i);
 };
 
 
@@ -62,28 +56,21 @@ struct BinaryHeap {
 struct HashNode {
 	uint key1;
 	uint key2;
-	void *value;
-	HashNode *next;
+	void *value; ///< The value, \c NULL when the slot is not used
 };
 /**
- * Generates a hash code from the given key pair. You should make sure that
- * the resulting range is clearly defined.
+ * Hash table with open addressing, mapping a key pair to a value that is not
+ * \c NULL. The table grows when it gets too full, so it never runs out of space.
  */
-typedef uint Hash_HashProc(uint key1, uint key2);
 struct Hash {
-	/* The hash function used */
-	Hash_HashProc *hash;
 	/* The amount of items in the hash */
 	uint size;
-	/* The number of buckets allocated */
-	uint num_buckets;
-	/* A pointer to an array of num_buckets buckets. */
-	HashNode *buckets;
-	/* A pointer to an array of numbuckets booleans, which will be true if
-	 * there are any Nodes in the bucket */
-	bool *buckets_in_use;
+	/* The number of slots allocated, minus one */
+	uint mask;
+	/* A pointer to an array of mask + 1 slots */
+	HashNode *nodes;
 
-	void Init(Hash_HashProc *hash, uint num_buckets);
+	void Init(uint num_buckets);
 
 	void *Get(uint key1, uint key2) const;
 	void *Set(uint key1, uint key2, void *value);
@@ -105,7 +92,20 @@ protected:
 #ifdef HASH_STATS
 	void PrintStatistics() const;
 #endif
-	HashNode *FindNode(uint key1, uint key2, HashNode** prev_out) const;
+	/**
+	 * Gets the slot at which the search for a key pair starts.
+	 * @param key1 First key.
+	 * @param key2 Second key.
+	 * @return Index of the slot.
+	 */
+	inline uint GetHomeSlot(uint key1, uint key2) const
+	{
+		uint32 hash = key1 * 0x9E3779B1U ^ key2 * 0x85EBCA77U;
+		return (hash ^ (hash >> 16)) & this->mask;
+	}
+
+	uint FindSlot(uint key1, uint key2) const;
+	void Grow();
 };
 
 #endif /* QUEUE_H */
@@ -0,0 +1,138 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pathfinder_stats.cpp Statistics about the calls of the pathfinders. */
+
+#include "../stdafx.h"
+#include "../core/bitmath_func.hpp"
+#include "../core/math_func.hpp"
+#include "../core/mem_func.hpp"
+#include "../console_func.h"
+#include "../company_base.h"
+#include "../strings_func.h"
+#include "../string_func.h"
+#include "../framerate_type.h"
+#include "pathfinder_stats.h"
+
+#include "table/strings.h"
+
+#include "../safeguards.h"
+
+/** The statistics, by company and vehicle type. They are not part of the game state. */
+PathfinderStats _pathfinder_stats[PF_STATS_NO_COMPANY + 1][VEH_COMPANY_END];
+
+/**
+ * Count a value in the histogram.
+ * @param value The value.
+ */
+void PathfinderHistogram::Add(uint value)
+{
+	uint bucket = (value == 0) ? 0 : FindLastBit(value) + 1;
+	this->count[min(bucket, PF_HISTOGRAM_BUCKETS - 1)]++;
+}
+
+/**
+ * Record one call of a pathfinder.
+ * @param owner The owner of the vehicle the path was searched for, or #INVALID_OWNER.
+ * @param type The type of the vehicle.
+ * @param nodes The number of nodes expanded.
+ * @param cache_hits The number of segment costs taken from the cache.
+ * @param cost_calcs The number of segment costs calculated.
+ * @param time_us The wall time of the call in microseconds.
+ * @param found Whether a path was found.
+ */
+void RecordPathfinderCall(Owner owner, VehicleType type, uint nodes, uint cache_hits, uint cost_calcs, uint time_us, bool found)
+{
+	assert(type < VEH_COMPANY_END);
+
+	PathfinderStats &stats = _pathfinder_stats[owner < MAX_COMPANIES ? (uint)owner : PF_STATS_NO_COMPANY][type];
+	stats.calls++;
+	if (found) stats.found++;
+	stats.nodes += nodes;
+	stats.cache_hits += cache_hits;
+	stats.cost_calcs += cost_calcs;
+	stats.time_us += time_us;
+	stats.nodes_hist.Add(nodes);
+	stats.time_hist.Add(time_us);
+
+	static const char * const trace_names[] = { "pf_train", "pf_roadveh", "pf_ship", "pf_aircraft" };
+	assert_compile(lengthof(trace_names) == VEH_COMPANY_END);
+	AddPerformanceTraceEvent(trace_names[type], time_us);
+}
+
+/** Forget all statistics. */
+void ResetPathfinderStats()
+{
+	MemSetT(&_pathfinder_stats[0][0], 0, lengthof(_pathfinder_stats) * VEH_COMPANY_END);
+}
+
+/**
+ * Print a histogram to the console.
+ * @param name Name of the histogram.
+ * @param hist The histogram.
+ */
+static void ConPrintPathfinderHistogram(const char *name, const PathfinderHistogram &hist)
+{
+	char buf[512];
+	char *p = buf;
+	buf[0] = '\0';
+	for (uint i = 0; i < PF_HISTOGRAM_BUCKETS; i++) {
+		if (hist.count[i] == 0) continue;
+		if (i + 1 == PF_HISTOGRAM_BUCKETS) {
+			p += seprintf(p, lastof(buf), " >=%u:%u", 1U << (i - 1), hist.count[i]);
+		} else {
+			p += seprintf(p, lastof(buf), " <%u:%u", 1U << i, hist.count[i]);
+		}
+	}
+	IConsolePrintF(CC_DEFAULT, "    %s:%s", name, buf);
+}
+
+/**
+ * Print the pathfinder statistics to the console.
+ * @param histograms Whether to print the histograms too.
+ */
+void ConPrintPathfinderStats(bool histograms)
+{
+	static const char * const TYPE_NAMES[VEH_COMPANY_END] = { "trains", "road vehicles", "ships", "aircraft" };
+
+	bool printed_anything = false;
+	for (uint c = 0; c < lengthof(_pathfinder_stats); c++) {
+		for (VehicleType type = VEH_BEGIN; type < VEH_COMPANY_END; type++) {
+			const PathfinderStats &stats = _pathfinder_stats[c][type];
+			if (stats.calls == 0) continue;
+
+			if (c == PF_STATS_NO_COMPANY) {
+				IConsolePrintF(CC_INFO, "No company, %s:", TYPE_NAMES[type]);
+			} else {
+				if (Company::IsValidID(c)) {
+					SetDParam(0, c);
+					char name[512];
+					GetString(name, STR_COMPANY_NAME, lastof(name));
+					IConsolePrintF(CC_INFO, "Company %u (%s), %s:", c + 1, name, TYPE_NAMES[type]);
+				} else {
+					IConsolePrintF(CC_INFO, "Company %u, %s:", c + 1, TYPE_NAMES[type]);
+				}
+			}
+
+			uint64 lookups = stats.cache_hits + stats.cost_calcs;
+			IConsolePrintF(CC_DEFAULT, "    %u calls, %u found (%.1f%%), " OTTD_PRINTF64 " nodes (%.1f per call), " OTTD_PRINTF64 " us (%.1f per call), cache hits %.1f%%",
+					stats.calls, stats.found, 100.0 * stats.found / stats.calls,
+					stats.nodes, (double)stats.nodes / stats.calls,
+					stats.time_us, (double)stats.time_us / stats.calls,
+					lookups == 0 ? 0.0 : 100.0 * stats.cache_hits / lookups);
+			if (histograms) {
+				ConPrintPathfinderHistogram("nodes", stats.nodes_hist);
+				ConPrintPathfinderHistogram("us", stats.time_hist);
+			}
+			printed_anything = true;
+		}
+	}
+
+	if (!printed_anything) IConsolePrint(CC_DEFAULT, "No pathfinder calls recorded.");
+}
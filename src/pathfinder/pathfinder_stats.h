@@ -0,0 +1,52 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pathfinder_stats.h Statistics about the calls of the pathfinders. */
+
+#ifndef PATHFINDER_STATS_H
+#define PATHFINDER_STATS_H
+
+#include "../company_type.h"
+#include "../vehicle_type.h"
+
+static const uint PF_HISTOGRAM_BUCKETS = 16; ///< Number of buckets of a #PathfinderHistogram.
+
+/**
+ * Histogram with buckets of exponentially growing size. Bucket 0 counts
+ * the value 0, bucket i the values from 2^(i-1) up to 2^i and the last
+ * bucket everything above that.
+ */
+struct PathfinderHistogram {
+	uint32 count[PF_HISTOGRAM_BUCKETS]; ///< Number of values in each bucket.
+
+	void Add(uint value);
+};
+
+/** Statistics about the pathfinder calls for one company and vehicle type. */
+struct PathfinderStats {
+	uint32 calls;                   ///< Number of calls.
+	uint32 found;                   ///< Number of calls that found a path.
+	uint64 nodes;                   ///< Total number of nodes expanded.
+	uint64 cache_hits;              ///< Total number of segment costs taken from the cache.
+	uint64 cost_calcs;              ///< Total number of segment costs calculated.
+	uint64 time_us;                 ///< Total wall time in microseconds.
+	PathfinderHistogram nodes_hist; ///< Histogram of the number of nodes expanded per call.
+	PathfinderHistogram time_hist;  ///< Histogram of the wall time in microseconds per call.
+};
+
+/** Index in #_pathfinder_stats, for calls that are not made for a company. */
+static const uint PF_STATS_NO_COMPANY = MAX_COMPANIES;
+
+extern PathfinderStats _pathfinder_stats[PF_STATS_NO_COMPANY + 1][VEH_COMPANY_END];
+
+void RecordPathfinderCall(Owner owner, VehicleType type, uint nodes, uint cache_hits, uint cost_calcs, uint time_us, bool found);
+void ResetPathfinderStats();
+void ConPrintPathfinderStats(bool histograms);
+
+#endif /* PATHFINDER_STATS_H */
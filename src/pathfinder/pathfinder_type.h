@@ -46,6 +46,9 @@ static const int YAPF_SHIP_PATH_CACHE_LENGTH = 32;
 /** Maximum segments of road vehicle path cache */
 static const int YAPF_ROADVEH_PATH_CACHE_SEGMENTS = 8;
 
+/** Maximum number of track choices in the train path cache */
+static const uint YAPF_TRAIN_PATH_CACHE_CHOICES = 8;
+
 /**
  * Helper container to find a depot
  */
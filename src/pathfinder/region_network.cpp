@@ -0,0 +1,237 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file region_network.cpp Coarse networks of map regions, to guide long distance pathfinding. */
+
+#include "../stdafx.h"
+#include "region_network.h"
+#include "../tile_map.h"
+#include "../tunnelbridge_map.h"
+#include "../debug.h"
+#include <algorithm>
+#include <queue>
+#include <map>
+
+#include "../safeguards.h"
+
+/** Number of tiles along the side of a region. */
+static const uint REGION_SIZE = 1 << REGION_BITS;
+
+/** Maximum number of patches the coarse search visits before giving up. */
+static const uint MAX_REGION_SEARCH_NODES = 1 << 16;
+
+/**
+ * Get the region data for a region index, (re)building it when needed.
+ * @param index The index of the region.
+ * @return The up to date region.
+ */
+RegionNetwork::Region &RegionNetwork::GetRegion(uint index)
+{
+	uint num_regions = MapSize() >> (2 * REGION_BITS);
+	if (this->regions.size() != num_regions) {
+		this->regions.clear();
+		this->regions.resize(num_regions);
+	}
+
+	Region &region = this->regions[index];
+	if (region.valid) return region;
+
+	region.valid = true;
+	region.labels.clear();
+	region.patches.clear();
+
+	uint region_x = (index & ((MapSizeX() >> REGION_BITS) - 1)) << REGION_BITS;
+	uint region_y = (index >> (MapLogX() - REGION_BITS)) << REGION_BITS;
+	TileIndex base = TileXY(region_x, region_y);
+
+	std::vector<TileIndex> stack;
+	for (uint i = 0; i < REGION_SIZE * REGION_SIZE; i++) {
+		TileIndex start = TILE_ADDXY(base, i % REGION_SIZE, i / REGION_SIZE);
+		if ((!region.labels.empty() && region.labels[i] != 0) || this->GetSides(start) == 0) continue;
+
+		/* Labels are bytes; the remaining tiles are left out of the coarse network. */
+		if (region.patches.size() == UINT8_MAX) break;
+
+		if (region.labels.empty()) region.labels.resize(REGION_SIZE * REGION_SIZE, 0);
+		region.patches.emplace_back();
+		byte label = (byte)region.patches.size();
+		Patch &patch = region.patches.back();
+
+		/* Flood fill the patch; connections leaving the region become links. */
+		region.labels[i] = label;
+		stack.push_back(start);
+		while (!stack.empty()) {
+			TileIndex tile = stack.back();
+			stack.pop_back();
+
+			TileIndex next[DIAGDIR_END + 1];
+			uint num_next = 0;
+			uint sides = this->GetSides(tile);
+			for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+				if (!HasBit(sides, dir)) continue;
+				TileIndex t = TileAddByDiagDir(tile, dir);
+				if (IsValidTile(t) && HasBit(this->GetSides(t), ReverseDiagDir(dir))) next[num_next++] = t;
+			}
+			if (IsTileType(tile, MP_TUNNELBRIDGE)) next[num_next++] = GetOtherTunnelBridgeEnd(tile);
+
+			for (uint j = 0; j < num_next; j++) {
+				TileIndex t = next[j];
+				uint x = TileX(t) - region_x;
+				uint y = TileY(t) - region_y;
+				if (x >= REGION_SIZE || y >= REGION_SIZE) {
+					patch.links.push_back(t);
+					continue;
+				}
+				byte &l = region.labels[y * REGION_SIZE + x];
+				if (l != 0) continue;
+				l = label;
+				stack.push_back(t);
+			}
+		}
+
+		std::sort(patch.links.begin(), patch.links.end());
+		patch.links.erase(std::unique(patch.links.begin(), patch.links.end()), patch.links.end());
+	}
+
+	return region;
+}
+
+/**
+ * Get the patch a tile belongs to.
+ * @param tile The tile.
+ * @return Key of the patch; the region index times 256 plus its label, or 0 when the tile is not part of the network.
+ */
+uint RegionNetwork::GetPatchKey(TileIndex tile)
+{
+	uint index = GetRegionIndex(tile);
+	const Region &region = this->GetRegion(index);
+	if (region.labels.empty()) return 0;
+	byte label = region.labels[(TileY(tile) % REGION_SIZE) * REGION_SIZE + TileX(tile) % REGION_SIZE];
+	if (label == 0) return 0;
+	return (index << 8) | label;
+}
+
+/**
+ * Mark the regions that might change when a tile changes. The neighbouring
+ * regions are affected when the tile lies at their border. Tunnels and
+ * bridges have to be invalidated at both ends.
+ * @param tile The changed tile.
+ */
+void RegionNetwork::Invalidate(TileIndex tile)
+{
+	if (this->regions.empty()) return;
+	this->regions[GetRegionIndex(tile)].valid = false;
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+		TileIndex t = TileAddByDiagDir(tile, dir);
+		if (IsValidTile(t)) this->regions[GetRegionIndex(t)].valid = false;
+	}
+}
+
+/** Forget about all regions, e.g. when a new map has been loaded. */
+void RegionNetwork::Clear()
+{
+	this->regions.clear();
+}
+
+/**
+ * Get the distance between two regions, in regions.
+ * @param a Index of one region.
+ * @param b Index of the other region.
+ * @return The Manhattan distance.
+ */
+static uint GetRegionDistance(uint a, uint b)
+{
+	uint shift = MapLogX() - REGION_BITS;
+	uint mask = (1 << shift) - 1;
+	return Delta(a & mask, b & mask) + Delta(a >> shift, b >> shift);
+}
+
+/**
+ * Search the network for a route between a tile and one of the
+ * destination tiles, and mark the regions around the route.
+ * @param from       The tile to start at.
+ * @param dest_tiles The tiles of the destination.
+ * @param[out] corridor The regions along the route and their direct neighbours.
+ * @return Whether a route has been found.
+ */
+bool RegionNetwork::FindCorridor(TileIndex from, const std::vector<TileIndex> &dest_tiles, RegionCorridor &corridor)
+{
+	uint start = this->GetPatchKey(from);
+	if (start == 0) return false;
+
+	std::vector<uint> dest_keys;
+	std::vector<uint> dest_regions;
+	for (TileIndex tile : dest_tiles) {
+		uint key = this->GetPatchKey(tile);
+		if (key == 0) continue;
+		dest_keys.push_back(key);
+		dest_regions.push_back(key >> 8);
+	}
+	if (dest_keys.empty()) return false;
+	std::sort(dest_keys.begin(), dest_keys.end());
+
+	/* A* over the patches; cost and estimate are in regions. */
+	typedef std::pair<uint, uint> QueueItem; ///< Estimate and key of a patch.
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > queue;
+	std::map<uint, std::pair<uint, uint> > visited; ///< Cost and parent of each patch found so far.
+
+	visited[start] = std::make_pair(0U, 0U);
+	queue.push(QueueItem(0, start));
+	uint found = 0;
+	while (!queue.empty() && visited.size() < MAX_REGION_SEARCH_NODES) {
+		uint key = queue.top().second;
+		uint estimate = queue.top().first;
+		queue.pop();
+
+		uint cost = visited[key].first;
+		if (std::binary_search(dest_keys.begin(), dest_keys.end(), key)) {
+			found = key;
+			break;
+		}
+
+		/* A shorter route to this patch has been queued after this item. */
+		uint min_dist = UINT_MAX;
+		for (uint r : dest_regions) min_dist = min(min_dist, GetRegionDistance(key >> 8, r));
+		if (estimate > cost + min_dist) continue;
+
+		const Patch &patch = this->GetRegion(key >> 8).patches[(key & 0xFF) - 1];
+		for (TileIndex link : patch.links) {
+			uint next = this->GetPatchKey(link);
+			if (next == 0) continue;
+			uint next_cost = cost + max(1U, GetRegionDistance(key >> 8, next >> 8));
+			std::map<uint, std::pair<uint, uint> >::iterator it = visited.find(next);
+			if (it != visited.end() && it->second.first <= next_cost) continue;
+			visited[next] = std::make_pair(next_cost, key);
+
+			uint dist = UINT_MAX;
+			for (uint r : dest_regions) dist = min(dist, GetRegionDistance(next >> 8, r));
+			queue.push(QueueItem(next_cost + dist, next));
+		}
+	}
+
+	if (found == 0) {
+		DEBUG(yapf, 3, "No region route from 0x%X (%u patches visited)", from, (uint)visited.size());
+		return false;
+	}
+
+	corridor.assign(MapSize() >> (2 * REGION_BITS), false);
+	uint shift = MapLogX() - REGION_BITS;
+	int regions_x = MapSizeX() >> REGION_BITS;
+	int regions_y = MapSizeY() >> REGION_BITS;
+	for (uint key = found; key != 0; key = visited[key].second) {
+		int x = (key >> 8) & ((1 << shift) - 1);
+		int y = (key >> 8) >> shift;
+		for (int dy = max(y - 1, 0); dy <= min(y + 1, regions_y - 1); dy++) {
+			for (int dx = max(x - 1, 0); dx <= min(x + 1, regions_x - 1); dx++) {
+				corridor[(dy << shift) + dx] = true;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,81 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file region_network.h Coarse networks of map regions, to guide long distance pathfinding. */
+
+#ifndef REGION_NETWORK_H
+#define REGION_NETWORK_H
+
+#include "../map_func.h"
+#include <vector>
+
+/** Regions of the networks are (1 << REGION_BITS) tiles wide and high. */
+static const uint REGION_BITS = 4;
+
+/**
+ * Regions of the map a vehicle may search through.
+ * Indexed by #GetRegionIndex; empty when not restricted.
+ */
+typedef std::vector<bool> RegionCorridor;
+
+/**
+ * Get the index of the region a tile is in.
+ * @param tile The tile.
+ * @return The index of its region.
+ */
+static inline uint GetRegionIndex(TileIndex tile)
+{
+	return ((TileY(tile) >> REGION_BITS) << (MapLogX() - REGION_BITS)) + (TileX(tile) >> REGION_BITS);
+}
+
+/**
+ * Network of the patches of connected tiles within each region of the map,
+ * and the connections between them. Regions are built when they are needed
+ * and have to be invalidated when the tiles in them change.
+ */
+class RegionNetwork {
+public:
+	/**
+	 * Get the sides of a tile a vehicle can leave or enter it through.
+	 * The other end of a tunnel or bridge is connected as well.
+	 * @param tile  The tile.
+	 * @param param The parameter of the network.
+	 * @return Bit mask of the #DiagDirection sides.
+	 */
+	typedef uint (*SidesProc)(TileIndex tile, uint param);
+
+	RegionNetwork(SidesProc sides_proc, uint param) : sides_proc(sides_proc), param(param) {}
+
+	void Invalidate(TileIndex tile);
+	void Clear();
+	bool FindCorridor(TileIndex from, const std::vector<TileIndex> &dest_tiles, RegionCorridor &corridor);
+
+private:
+	/** Tiles with connected tiles within one region. */
+	struct Patch {
+		std::vector<TileIndex> links; ///< Tiles in other regions the patch connects to.
+	};
+
+	/** The network of one region of the map. */
+	struct Region {
+		bool valid;                  ///< Whether the data below reflects the current map.
+		std::vector<byte> labels;    ///< Patch number plus one of each tile, 0 for tiles outside the network; empty without any patch.
+		std::vector<Patch> patches;  ///< The patches of the region.
+	};
+
+	SidesProc sides_proc;         ///< Gets the sides of a tile.
+	uint param;                   ///< Parameter for #sides_proc.
+	std::vector<Region> regions;  ///< All regions of the map.
+
+	Region &GetRegion(uint index);
+	uint GetPatchKey(TileIndex tile);
+	uint GetSides(TileIndex tile) const { return this->sides_proc(tile, this->param); }
+};
+
+#endif /* REGION_NETWORK_H */
@@ -0,0 +1,93 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file road_regions.cpp Coarse road network of map regions, to guide long distance road vehicle pathfinding. */
+
+#include "../stdafx.h"
+#include "road_regions.h"
+#include "../road_map.h"
+#include "../station_map.h"
+#include "../tunnelbridge_map.h"
+
+#include "../safeguards.h"
+
+/**
+ * Get the sides of a tile that road of the given type connects to.
+ * @param tile  The tile.
+ * @param param The road type.
+ * @return Bit mask of the #DiagDirection sides.
+ */
+static uint GetRoadSides(TileIndex tile, uint param)
+{
+	RoadType rt = (RoadType)param;
+	RoadBits bits;
+	switch (GetTileType(tile)) {
+		case MP_ROAD:
+			if (!HasTileRoadType(tile, rt)) return 0;
+			switch (GetRoadTileType(tile)) {
+				case ROAD_TILE_NORMAL:   bits = GetRoadBits(tile, rt); break;
+				case ROAD_TILE_CROSSING: bits = GetCrossingRoadBits(tile); break;
+				default:                 return 1 << GetRoadDepotDirection(tile);
+			}
+			break;
+
+		case MP_STATION:
+			if (!IsRoadStop(tile) || !HasTileRoadType(tile, rt)) return 0;
+			if (!IsDriveThroughStopTile(tile)) return 1 << GetRoadStopDir(tile);
+			return (1 << GetRoadStopDir(tile)) | (1 << ReverseDiagDir(GetRoadStopDir(tile)));
+
+		case MP_TUNNELBRIDGE:
+			if (GetTunnelBridgeTransportType(tile) != TRANSPORT_ROAD || !HasTileRoadType(tile, rt)) return 0;
+			return 1 << ReverseDiagDir(GetTunnelBridgeDirection(tile));
+
+		default:
+			return 0;
+	}
+
+	uint sides = 0;
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+		if (bits & DiagDirToRoadBits(dir)) SetBit(sides, dir);
+	}
+	return sides;
+}
+
+/** The road networks of each road type. */
+static RegionNetwork _road_networks[ROADTYPE_END] = {
+	RegionNetwork(&GetRoadSides, ROADTYPE_ROAD),
+	RegionNetwork(&GetRoadSides, ROADTYPE_TRAM),
+};
+
+/**
+ * Mark the regions whose road network might change when the road on a tile changes.
+ * @param tile The changed tile; tunnels and bridges have to be notified at both ends.
+ */
+void InvalidateRoadRegion(TileIndex tile)
+{
+	for (RoadType rt = ROADTYPE_BEGIN; rt < ROADTYPE_END; rt++) _road_networks[rt].Invalidate(tile);
+}
+
+/** Forget about the road network of all regions, e.g. when a new map has been loaded. */
+void InvalidateAllRoadRegions()
+{
+	for (RoadType rt = ROADTYPE_BEGIN; rt < ROADTYPE_END; rt++) _road_networks[rt].Clear();
+}
+
+/**
+ * Search the coarse road network for a route between a tile and one of the
+ * destination tiles, and mark the regions around the route.
+ * @param rt         The road type to search on.
+ * @param from       The tile to start at.
+ * @param dest_tiles The tiles of the destination.
+ * @param[out] corridor The regions along the route and their direct neighbours.
+ * @return Whether a route has been found.
+ */
+bool FindRoadRegionCorridor(RoadType rt, TileIndex from, const std::vector<TileIndex> &dest_tiles, RegionCorridor &corridor)
+{
+	return _road_networks[rt].FindCorridor(from, dest_tiles, corridor);
+}
@@ -0,0 +1,22 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file road_regions.h Coarse road network of map regions, to guide long distance road vehicle pathfinding. */
+
+#ifndef ROAD_REGIONS_H
+#define ROAD_REGIONS_H
+
+#include "region_network.h"
+#include "../road_type.h"
+
+void InvalidateRoadRegion(TileIndex tile);
+void InvalidateAllRoadRegions();
+bool FindRoadRegionCorridor(RoadType rt, TileIndex from, const std::vector<TileIndex> &dest_tiles, RegionCorridor &corridor);
+
+#endif /* ROAD_REGIONS_H */
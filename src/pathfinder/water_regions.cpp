@@ -0,0 +1,72 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.cpp Coarse water network of map regions, to guide long distance ship pathfinding. */
+
+#include "../stdafx.h"
+#include "water_regions.h"
+#include "../landscape.h"
+#include "../tunnelbridge_map.h"
+
+#include "../safeguards.h"
+
+/**
+ * Get the sides of a tile ships can leave or enter it through.
+ * @param tile  The tile.
+ * @param param Unused.
+ * @return Bit mask of the #DiagDirection sides.
+ */
+static uint GetWaterSides(TileIndex tile, uint param)
+{
+	/* Aqueducts connect to the other end instead of the side under the bridge. */
+	if (IsTileType(tile, MP_TUNNELBRIDGE)) {
+		if (GetTunnelBridgeTransportType(tile) != TRANSPORT_WATER) return 0;
+		return 1 << ReverseDiagDir(GetTunnelBridgeDirection(tile));
+	}
+
+	TrackBits tracks = TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_WATER, 0));
+	uint sides = 0;
+	Track track;
+	FOR_EACH_SET_TRACK(track, tracks) {
+		Trackdir td = TrackToTrackdir(track);
+		SetBit(sides, TrackdirToExitdir(td));
+		SetBit(sides, TrackdirToExitdir(ReverseTrackdir(td)));
+	}
+	return sides;
+}
+
+static RegionNetwork _water_network(&GetWaterSides, 0); ///< The network of connected water.
+
+/**
+ * Mark the regions whose water network might change when a tile changes.
+ * @param tile The changed tile; aqueducts have to be notified at both ends.
+ */
+void InvalidateWaterRegion(TileIndex tile)
+{
+	_water_network.Invalidate(tile);
+}
+
+/** Forget about the water network of all regions, e.g. when a new map has been loaded. */
+void InvalidateAllWaterRegions()
+{
+	_water_network.Clear();
+}
+
+/**
+ * Search the coarse water network for a route between two tiles, and mark the regions around the route.
+ * @param from      The tile to start at.
+ * @param dest_tile The destination tile.
+ * @param[out] corridor The regions along the route and their direct neighbours.
+ * @return Whether a route has been found.
+ */
+bool FindWaterRegionCorridor(TileIndex from, TileIndex dest_tile, RegionCorridor &corridor)
+{
+	std::vector<TileIndex> dest_tiles(1, dest_tile);
+	return _water_network.FindCorridor(from, dest_tiles, corridor);
+}
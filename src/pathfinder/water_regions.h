@@ -0,0 +1,21 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.h Coarse water network of map regions, to guide long distance ship pathfinding. */
+
+#ifndef WATER_REGIONS_H
+#define WATER_REGIONS_H
+
+#include "region_network.h"
+
+void InvalidateWaterRegion(TileIndex tile);
+void InvalidateAllWaterRegions();
+bool FindWaterRegionCorridor(TileIndex from, TileIndex dest_tile, RegionCorridor &corridor);
+
+#endif /* WATER_REGIONS_H */
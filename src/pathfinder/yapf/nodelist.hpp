@@ -15,6 +15,7 @@
 #include "../../misc/array.hpp"
 #include "../../misc/hashtable.hpp"
 #include "../../misc/binaryheap.hpp"
+#include <vector>
 
 /**
  * Hash table based node list multi-container class.
@@ -27,9 +28,9 @@ public:
 	typedef Titem_ Titem;                                        ///< Make #Titem_ visible from outside of class.
 	typedef typename Titem_::Key Key;                            ///< Make Titem_::Key a property of this class.
 	typedef SmallArray<Titem_, 65536, 256> CItemArray;           ///< Type that we will use as item container.
-	typedef CHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
-	typedef CHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
-	typedef CBinaryHeapT<Titem_> CPriorityQueue;                 ///< How the priority queue will be managed.
+	typedef COpenHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
+	typedef COpenHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
+	typedef CQuaternaryHeapT<Titem_> CPriorityQueue;             ///< How the priority queue will be managed.
 
 protected:
 	CItemArray      m_arr;        ///< Here we store full item data (Titem_).
@@ -38,6 +39,16 @@ protected:
 	CPriorityQueue  m_open_queue; ///< Priority queue of pointers to open item data.
 	Titem          *m_new_node;   ///< New open node under construction.
 
+	/** Number of unused node lists kept around; more than that only exist while pathfinders are nested. */
+	static const uint MAX_POOLED_LISTS = 4;
+
+	/** Unused node lists, whose memory can be reused by the next search. */
+	static std::vector<CNodeList_HashTableT *> &GetPool()
+	{
+		static std::vector<CNodeList_HashTableT *> pool;
+		return pool;
+	}
+
 public:
 	/** default constructor */
 	CNodeList_HashTableT() : m_open_queue(2048)
@@ -50,6 +61,45 @@ public:
 	{
 	}
 
+	/** Forget all nodes, but keep the allocated memory for the next search. */
+	inline void Reset()
+	{
+		m_arr.Reset();
+		m_open.Clear();
+		m_closed.Clear();
+		m_open_queue.Clear();
+		m_new_node = NULL;
+	}
+
+	/**
+	 * Get an empty node list, reusing one of an earlier search when possible.
+	 * Pathfinders only run in the game loop, so the pool needs no locking.
+	 * @return The node list; give it back with #Release.
+	 */
+	static CNodeList_HashTableT &Acquire()
+	{
+		std::vector<CNodeList_HashTableT *> &pool = GetPool();
+		if (pool.empty()) return *new CNodeList_HashTableT();
+		CNodeList_HashTableT *list = pool.back();
+		pool.pop_back();
+		return *list;
+	}
+
+	/**
+	 * Give a node list back to the pool once the search is done.
+	 * @param list The node list that was obtained from #Acquire.
+	 */
+	static void Release(CNodeList_HashTableT &list)
+	{
+		std::vector<CNodeList_HashTableT *> &pool = GetPool();
+		if (pool.size() >= MAX_POOLED_LISTS) {
+			delete &list;
+			return;
+		}
+		list.Reset();
+		pool.push_back(&list);
+	}
+
 	/** return number of open nodes */
 	inline int OpenCount()
 	{
@@ -121,11 +171,23 @@ public:
 	inline Titem_& PopOpenNode(const Key &key)
 	{
 		Titem_ &item = m_open.Pop(key);
-		uint idxPop = m_open_queue.FindIndex(item);
-		m_open_queue.Remove(idxPop);
+		m_open_queue.Remove(item);
 		return item;
 	}
 
+	/**
+	 * Replace an open node by a better node with the same key, keeping it in the open list.
+	 * @param open_node The node in the open list.
+	 * @param better    The new node, whose cost estimate is not higher.
+	 */
+	inline void ImproveOpenNode(Titem_ &open_node, const Titem_ &better)
+	{
+		uint heap_index = open_node.GetHeapIndex();
+		open_node = better;
+		open_node.SetHeapIndex(heap_index);
+		m_open_queue.DecreaseKey(open_node);
+	}
+
 	/** close node */
 	inline void InsertClosedNode(Titem_ &item)
 	{
@@ -14,6 +14,7 @@
 
 #include "../../debug.h"
 #include "../../settings_type.h"
+#include "../pathfinder_stats.h"
 
 extern int _total_pf_time_us;
 
@@ -58,7 +59,7 @@ public:
 	typedef typename Node::Key Key;            ///< key to hash tables
 
 
-	NodeList             m_nodes;              ///< node list multi-container
+	NodeList            &m_nodes;              ///< node list multi-container, taken from the pool of node lists
 protected:
 	Node                *m_pBestDestNode;      ///< pointer to the destination node found at last round
 	Node                *m_pBestIntermediateNode; ///< here should be node closest to the destination if path not found
@@ -81,7 +82,8 @@ public:
 public:
 	/** default constructor */
 	inline CYapfBaseT()
-		: m_pBestDestNode(NULL)
+		: m_nodes(NodeList::Acquire())
+		, m_pBestDestNode(NULL)
 		, m_pBestIntermediateNode(NULL)
 		, m_settings(&_settings_game.pf.yapf)
 		, m_max_search_nodes(PfGetSettings().max_search_nodes)
@@ -93,7 +95,10 @@ public:
 	}
 
 	/** default destructor */
-	~CYapfBaseT() {}
+	~CYapfBaseT()
+	{
+		NodeList::Release(m_nodes);
+	}
 
 protected:
 	/** to access inherited path finder */
@@ -153,8 +158,9 @@ public:
 		bDestFound &= (m_pBestDestNode != NULL);
 
 		perf.Stop();
+		int t = perf.Get(1000000);
+		RecordPathfinderCall(m_veh != NULL ? m_veh->owner : INVALID_OWNER, VehicleType::EXPECTED_TYPE, m_nodes.ClosedCount(), m_stats_cache_hits, m_stats_cost_calcs, max(t, 0), bDestFound);
 		if (_debug_yapf_level >= 2) {
-			int t = perf.Get(1000000);
 			_total_pf_time_us += t;
 
 			if (_debug_yapf_level >= 3) {
@@ -250,9 +256,7 @@ public:
 
 		bool bValid = Yapf().PfCalcCost(n, &tf);
 
-		if (bCached) {
-			Yapf().PfNodeCacheFlush(n);
-		}
+		Yapf().PfNodeCacheFlush(n);
 
 		if (bValid) bValid = Yapf().PfCalcEstimate(n);
 
@@ -279,11 +283,8 @@ public:
 			/* another node exists with the same key in the open list
 			 * is it better than new one? */
 			if (n.GetCostEstimate() < openNode->GetCostEstimate()) {
-				/* update the old node by value from new one */
-				m_nodes.PopOpenNode(n.GetKey());
-				*openNode = n;
-				/* add the updated old node back to open list */
-				m_nodes.InsertOpenNode(*openNode);
+				/* update the old node by value from new one, which moves it up in the open list */
+				m_nodes.ImproveOpenNode(*openNode, n);
 			}
 			return;
 		}
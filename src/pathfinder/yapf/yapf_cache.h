@@ -21,4 +21,6 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+void YapfGetRailSegmentCacheStats(uint64 *hits, uint64 *misses);
+
 #endif /* YAPF_CACHE_H */
@@ -13,6 +13,9 @@
 #define YAPF_COSTCACHE_HPP
 
 #include "../../date_func.h"
+#include "../../map_func.h"
+#include "../../core/smallvec_type.hpp"
+#include <vector>
 
 /**
  * CYapfSegmentCostCacheNoneT - the formal only yapf cost cache provider that implements
@@ -98,14 +101,53 @@ public:
  *  the track layout changes. It is implemented as base class because it needs
  *  to be shared between all rail YAPF types (one shared counter, one notification
  *  function.
+ * Changes of single tiles are collected in a log instead, so each cache only
+ *  has to drop the segments passing near the changed tiles.
  */
 struct CSegmentCostCacheBase
 {
-	static int   s_rail_change_counter;
+	/** Rectangle of tiles in which the track layout has changed. */
+	struct ChangedArea {
+		uint16 min_x; ///< Smallest x coordinate of the area.
+		uint16 min_y; ///< Smallest y coordinate of the area.
+		uint16 max_x; ///< Largest x coordinate of the area.
+		uint16 max_y; ///< Largest y coordinate of the area.
+	};
+
+	/** Number of changed areas after which flushing everything is cheaper than keeping track of them. */
+	static const uint MAX_CHANGED_AREAS = 1024;
+
+	static int   s_rail_change_counter;                   ///< Incremented whenever all caches have to be flushed.
+	static SmallVector<ChangedArea, 16> s_changed_areas; ///< Areas changed since all caches were flushed.
+	static uint64 s_cache_hits;                          ///< Number of segments found in the global cache.
+	static uint64 s_cache_misses;                        ///< Number of segments not found in the global cache.
 
 	static void NotifyTrackLayoutChange(TileIndex tile, Track track)
+	{
+		if (tile == INVALID_TILE) {
+			FlushAll();
+			return;
+		}
+		NotifyAreaChange(TileX(tile), TileY(tile), TileX(tile), TileY(tile));
+	}
+
+	static void NotifyAreaChange(uint min_x, uint min_y, uint max_x, uint max_y)
+	{
+		if (s_changed_areas.Length() >= MAX_CHANGED_AREAS) {
+			FlushAll();
+			return;
+		}
+		ChangedArea *area = s_changed_areas.Append();
+		area->min_x = min_x;
+		area->min_y = min_y;
+		area->max_x = max_x;
+		area->max_y = max_y;
+	}
+
+	static void FlushAll()
 	{
 		s_rail_change_counter++;
+		s_changed_areas.Clear();
 	}
 };
 
@@ -119,25 +161,35 @@ struct CSegmentCostCacheBase
  *  of the segment (origin tile and exit-dir from this tile).
  *  Different CYapfCachedCostT types can share the same type of CSegmentCostCacheT.
  *  Look at CYapfRailSegment (yapf_node_rail.hpp) for the segment example
+ * Complete segments are also registered in a grid of map regions by their
+ *  bounding box, so they can be dropped when the track near them changes.
  */
 template <class Tsegment>
 struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 	static const int C_HASH_BITS = 14;
+	static const uint REGION_BITS = 5; ///< Regions of the area index are (1 << REGION_BITS) tiles wide and high.
+	static const uint MIN_GARBAGE = 4096; ///< Number of dropped segments before it is worth to rebuild the cache.
 
-	typedef CHashTableT<Tsegment, C_HASH_BITS> HashTable;
+	typedef COpenHashTableT<Tsegment, C_HASH_BITS> HashTable;
 	typedef SmallArray<Tsegment> Heap;
 	typedef typename Tsegment::Key Key;    ///< key to hash table
+	typedef std::vector<Tsegment *> SegmentList;
 
 	HashTable    m_map;
 	Heap         m_heap;
+	std::vector<SegmentList> m_regions; ///< Segments touching each region of the map.
+	uint         m_num_dropped;         ///< Number of segments in #m_heap that are no longer in #m_map.
+	uint         m_changes_seen;        ///< Number of entries of #s_changed_areas already applied.
 
-	inline CSegmentCostCacheT() {}
+	inline CSegmentCostCacheT() : m_num_dropped(0), m_changes_seen(0) {}
 
 	/** flush (clear) the cache */
 	inline void Flush()
 	{
 		m_map.Clear();
 		m_heap.Clear();
+		m_regions.clear();
+		m_num_dropped = 0;
 	}
 
 	inline Tsegment& Get(Key &key, bool *found)
@@ -152,6 +204,74 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 		}
 		return *item;
 	}
+
+	/**
+	 * Register a segment whose cost has been calculated in the regions it touches.
+	 * @param seg The segment.
+	 */
+	void Index(Tsegment &seg)
+	{
+		if (m_regions.empty()) m_regions.resize((MapSizeX() >> REGION_BITS) * (MapSizeY() >> REGION_BITS));
+
+		for (uint y = seg.m_min_y >> REGION_BITS; y <= (uint)seg.m_max_y >> REGION_BITS; y++) {
+			for (uint x = seg.m_min_x >> REGION_BITS; x <= (uint)seg.m_max_x >> REGION_BITS; x++) {
+				m_regions[(y << (MapLogX() - REGION_BITS)) + x].push_back(&seg);
+			}
+		}
+		seg.m_indexed = true;
+	}
+
+	/**
+	 * Drop all segments passing within one tile of the given area.
+	 * The neighbouring tiles are included, as the end of a segment
+	 * depends on the tiles it could continue to.
+	 * @param area The changed area.
+	 */
+	void InvalidateArea(const ChangedArea &area)
+	{
+		if (m_regions.empty()) return;
+
+		uint min_x = area.min_x > 0 ? area.min_x - 1 : 0;
+		uint min_y = area.min_y > 0 ? area.min_y - 1 : 0;
+		uint max_x = min<uint>(area.max_x + 1, MapMaxX());
+		uint max_y = min<uint>(area.max_y + 1, MapMaxY());
+
+		for (uint y = min_y >> REGION_BITS; y <= max_y >> REGION_BITS; y++) {
+			for (uint x = min_x >> REGION_BITS; x <= max_x >> REGION_BITS; x++) {
+				SegmentList &list = m_regions[(y << (MapLogX() - REGION_BITS)) + x];
+				typename SegmentList::iterator keep = list.begin();
+				for (typename SegmentList::iterator it = list.begin(); it != list.end(); ++it) {
+					Tsegment *seg = *it;
+					/* Already dropped through another region. */
+					if (!seg->m_indexed) continue;
+					if (seg->m_min_x <= max_x && seg->m_max_x >= min_x && seg->m_min_y <= max_y && seg->m_max_y >= min_y) {
+						m_map.TryPop(*seg);
+						seg->m_indexed = false;
+						m_num_dropped++;
+						continue;
+					}
+					*keep++ = seg;
+				}
+				list.erase(keep, list.end());
+			}
+		}
+	}
+
+	/**
+	 * Apply the track layout changes that happened since the last call.
+	 * @param flush Whether the whole cache has to be flushed.
+	 */
+	void Update(bool flush)
+	{
+		if (flush) {
+			Flush();
+		} else {
+			for (uint i = m_changes_seen; i < s_changed_areas.Length(); i++) InvalidateArea(s_changed_areas[i]);
+			/* Too much garbage in the heap; start over instead. */
+			if (m_num_dropped >= MIN_GARBAGE && m_num_dropped > m_heap.Length() / 2) Flush();
+		}
+		m_changes_seen = s_changed_areas.Length();
+	}
 };
 
 /**
@@ -194,11 +314,10 @@ protected:
 			_total_pf_time_us = 0;
 		}
 
-		/* delete the cache sometimes... */
-		if (last_rail_change_counter != Cache::s_rail_change_counter) {
-			last_rail_change_counter = Cache::s_rail_change_counter;
-			C.Flush();
-		}
+		/* delete the cache sometimes, or the parts of it that are affected by track changes */
+		bool flush = last_rail_change_counter != Cache::s_rail_change_counter;
+		last_rail_change_counter = Cache::s_rail_change_counter;
+		C.Update(flush);
 		return C;
 	}
 
@@ -216,15 +335,23 @@ public:
 		bool found;
 		CachedData &item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
+		if (found) {
+			Cache::s_cache_hits++;
+		} else {
+			Cache::s_cache_misses++;
+		}
 		return found;
 	}
 
 	/**
-	 * Called by YAPF to flush the cached segment cost data back into cache storage.
-	 *  Current cache implementation doesn't use that.
+	 * Called by YAPF after the cost of the node has been calculated.
+	 *  Registers newly completed segments in the area index of the cache.
 	 */
 	inline void PfNodeCacheFlush(Node &n)
 	{
+		if (!Yapf().CanUseGlobalCache(n)) return;
+		CachedData &segment = *n.m_segment;
+		if (segment.m_cost >= 0 && !segment.m_indexed) m_global_cache.Index(segment);
 	}
 };
 
@@ -387,6 +387,14 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 			/* If we skipped some tunnel/bridge/station tiles, add their base cost */
 			segment_cost += YAPF_TILE_LENGTH * tf->m_tiles_skipped;
 
+			/* Remember the area the segment covers, so track changes only invalidate the segments they touch. */
+			if (!is_cached_segment) {
+				segment.IncludeTile(cur.tile);
+				if (tf->m_tiles_skipped > 0) {
+					segment.IncludeTile(TILE_ADD(cur.tile, TileOffsByDiagDir(ReverseDiagDir(TrackdirToExitdir(cur.td))) * tf->m_tiles_skipped));
+				}
+			}
+
 			/* Slope cost. */
 			segment_cost += Yapf().SlopeCost(cur.tile, cur.td);
 
@@ -73,6 +73,11 @@ struct CYapfRailSegment
 	TileIndex              m_last_signal_tile;
 	Trackdir               m_last_signal_td;
 	EndSegmentReasonBits   m_end_segment_reason;
+	uint16                 m_min_x;   ///< Smallest x coordinate of the tiles of the segment.
+	uint16                 m_min_y;   ///< Smallest y coordinate of the tiles of the segment.
+	uint16                 m_max_x;   ///< Largest x coordinate of the tiles of the segment.
+	uint16                 m_max_y;   ///< Largest y coordinate of the tiles of the segment.
+	bool                   m_indexed; ///< Whether the segment can be found through the area index of the global cache.
 	CYapfRailSegment      *m_hash_next;
 
 	inline CYapfRailSegment(const CYapfRailSegmentKey &key)
@@ -83,9 +88,26 @@ struct CYapfRailSegment
 		, m_last_signal_tile(INVALID_TILE)
 		, m_last_signal_td(INVALID_TRACKDIR)
 		, m_end_segment_reason(ESRB_NONE)
+		, m_min_x(TileX(key.GetTile()))
+		, m_min_y(TileY(key.GetTile()))
+		, m_max_x(TileX(key.GetTile()))
+		, m_max_y(TileY(key.GetTile()))
+		, m_indexed(false)
 		, m_hash_next(NULL)
 	{}
 
+	/**
+	 * Grow the bounding box of the segment so it contains the given tile.
+	 * @param tile The tile the segment passes.
+	 */
+	inline void IncludeTile(TileIndex tile)
+	{
+		m_min_x = min<uint>(m_min_x, TileX(tile));
+		m_min_y = min<uint>(m_min_y, TileY(tile));
+		m_max_x = max<uint>(m_max_x, TileX(tile));
+		m_max_y = max<uint>(m_max_y, TileY(tile));
+	}
+
 	inline const Key& GetKey() const
 	{
 		return m_key;
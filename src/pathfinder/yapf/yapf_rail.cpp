@@ -18,6 +18,7 @@
 #include "yapf_destrail.hpp"
 #include "../../viewport_func.h"
 #include "../../newgrf_station.h"
+#include "../../signal_func.h"
 
 #include "../../safeguards.h"
 
@@ -182,7 +183,11 @@ public:
 		if (target != NULL) target->okay = true;
 
 		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+			/* Only the segments along the reserved path are affected. */
+			for (Node *node = m_res_node; node->m_parent != NULL; node = node->m_parent) {
+				const CYapfRailSegment &seg = *node->m_segment;
+				CSegmentCostCacheBase::NotifyAreaChange(seg.m_min_x, seg.m_min_y, seg.m_max_x, seg.m_max_y);
+			}
 		}
 
 		return true;
@@ -399,19 +404,20 @@ public:
 		return 't';
 	}
 
-	static Trackdir stChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
+	static Trackdir stChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TrainPathCache &path_cache)
 	{
 		/* create pathfinder instance */
 		Tpf pf1;
 		Trackdir result1;
 
 		if (_debug_desync_level < 2) {
-			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target);
+			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, path_cache);
 		} else {
-			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, false, NULL);
+			TrainPathCache path_cache1;
+			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, false, NULL, path_cache1);
 			Tpf pf2;
 			pf2.DisableCache(true);
-			Trackdir result2 = pf2.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target);
+			Trackdir result2 = pf2.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, path_cache);
 			if (result1 != result2) {
 				DEBUG(desync, 2, "CACHE ERROR: ChooseRailTrack() = [%d, %d]", result1, result2);
 				DumpState(pf1, pf2);
@@ -421,9 +427,10 @@ public:
 		return result1;
 	}
 
-	inline Trackdir ChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
+	inline Trackdir ChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TrainPathCache &path_cache)
 	{
 		if (target != NULL) target->tile = INVALID_TILE;
+		path_cache.clear();
 
 		/* set origin and destination nodes */
 		PBSTileInfo origin = FollowTrainReservation(v);
@@ -444,6 +451,13 @@ public:
 			 * walk through the path back to the origin */
 			Node *pPrev = NULL;
 			while (pNode->m_parent != NULL) {
+				/* Remember the choices after the next one, which is made right now. */
+				if (!reserve_track && path_found && pNode->GetIsChoice() && pNode->m_parent->m_parent != NULL) {
+					TrackdirByte td;
+					td = pNode->GetTrackdir();
+					path_cache.td.push_front(td);
+					path_cache.tile.push_front(pNode->GetTile());
+				}
 				pPrev = pNode;
 				pNode = pNode->m_parent;
 
@@ -453,6 +467,12 @@ public:
 			Node &best_next_node = *pPrev;
 			next_trackdir = best_next_node.GetTrackdir();
 
+			/* Only keep the nearest choices, the state of the signals further away may change a lot. */
+			while (path_cache.size() > YAPF_TRAIN_PATH_CACHE_CHOICES) {
+				path_cache.td.pop_back();
+				path_cache.tile.pop_back();
+			}
+
 			if (reserve_track && path_found) this->TryReservePath(target, pNode->GetLastTile());
 		}
 
@@ -532,10 +552,10 @@ struct CYapfAnySafeTileRail1 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail1, CF
 struct CYapfAnySafeTileRail2 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail2, CFollowTrackFreeRailNo90, CRailNodeListTrackDir, CYapfDestinationAnySafeTileRailT , CYapfFollowAnySafeTileRailT> > {};
 
 
-Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
+Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TrainPathCache &path_cache)
 {
 	/* default is YAPF type 2 */
-	typedef Trackdir (*PfnChooseRailTrack)(const Train*, TileIndex, DiagDirection, TrackBits, bool&, bool, PBSTileInfo*);
+	typedef Trackdir (*PfnChooseRailTrack)(const Train*, TileIndex, DiagDirection, TrackBits, bool&, bool, PBSTileInfo*, TrainPathCache&);
 	PfnChooseRailTrack pfnChooseRailTrack = &CYapfRail1::stChooseRailTrack;
 
 	/* check if non-default YAPF type needed */
@@ -543,7 +563,7 @@ Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdi
 		pfnChooseRailTrack = &CYapfRail2::stChooseRailTrack; // Trackdir, forbid 90-deg
 	}
 
-	Trackdir td_ret = pfnChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target);
+	Trackdir td_ret = pfnChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, path_cache);
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : FindFirstTrack(tracks);
 }
 
@@ -640,8 +660,32 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 
 /** if any track changes, this counter is incremented - that will invalidate segment cost cache */
 int CSegmentCostCacheBase::s_rail_change_counter = 0;
+SmallVector<CSegmentCostCacheBase::ChangedArea, 16> CSegmentCostCacheBase::s_changed_areas;
+uint64 CSegmentCostCacheBase::s_cache_hits = 0;
+uint64 CSegmentCostCacheBase::s_cache_misses = 0;
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
+	NotifyTrackReservationChange();
+	InvalidateSignalSegmentCache();
+
+	/* The cached paths of trains are part of the game state, so only
+	 * forget them for actual changes and not when (re)loading a game. */
+	if (tile == INVALID_TILE) return;
+	Train *t;
+	FOR_ALL_TRAINS(t) {
+		if (!t->path.empty()) t->path.clear();
+	}
+}
+
+/**
+ * Get the statistics of the rail segment cost cache.
+ * @param[out] hits   Number of segments found in the cache.
+ * @param[out] misses Number of segments that had to be calculated.
+ */
+void YapfGetRailSegmentCacheStats(uint64 *hits, uint64 *misses)
+{
+	*hits = CSegmentCostCacheBase::s_cache_hits;
+	*misses = CSegmentCostCacheBase::s_cache_misses;
 }
@@ -13,6 +13,8 @@
 #include "yapf.hpp"
 #include "yapf_node_road.hpp"
 #include "../../roadstop_base.h"
+#include "../../station_base.h"
+#include "../road_regions.h"
 
 #include "../../safeguards.h"
 
@@ -321,6 +323,8 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
+	RegionCorridor m_corridor; ///< Regions the search is restricted to; empty when not restricted.
+
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
 	{
@@ -338,10 +342,31 @@ public:
 	{
 		TrackFollower F(Yapf().GetVehicle());
 		if (F.Follow(old_node.m_segment_last_tile, old_node.m_segment_last_td)) {
+			/* Do not leave the corridor of regions towards the destination. */
+			if (!m_corridor.empty() && !m_corridor[GetRegionIndex(F.m_new_tile)]) return;
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
 
+	/**
+	 * Restrict the search to the regions along a coarse route to the destination of the vehicle.
+	 * @param v    The vehicle.
+	 * @param tile The tile the search starts at.
+	 * @return Whether a coarse route has been found.
+	 */
+	inline bool SetCorridor(const RoadVehicle *v, TileIndex tile)
+	{
+		std::vector<TileIndex> dest_tiles;
+		if (v->current_order.IsType(OT_GOTO_STATION)) {
+			const Station *st = Station::GetIfValid(v->current_order.GetDestination());
+			if (st == NULL) return false;
+			for (const RoadStop *rs = st->GetPrimaryRoadStop(v); rs != NULL; rs = rs->next) dest_tiles.push_back(rs->xy);
+		} else {
+			dest_tiles.push_back(v->dest_tile);
+		}
+		return FindRoadRegionCorridor(v->roadtype, tile, dest_tiles, m_corridor);
+	}
+
 	/** return debug report character to identify the transportation type */
 	inline char TransportTypeChar() const
 	{
@@ -350,8 +375,24 @@ public:
 
 	static Trackdir stChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, RoadVehPathCache &path_cache)
 	{
+		Trackdir td;
+		{
+			Tpf pf;
+			td = pf.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
+		}
+		if (path_found || td == INVALID_TRACKDIR) return td;
+
+		/* The search ran out of nodes before reaching the destination. On large
+		 * maps that happens long before the destination is out of reach, so try
+		 * again in the regions along a coarse route to the destination. The
+		 * vehicle is not lost as long as such a route exists. */
 		Tpf pf;
-		return pf.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
+		if (!pf.SetCorridor(v, tile)) return td;
+		path_cache.clear();
+		Trackdir corridor_td = pf.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
+		if (corridor_td == INVALID_TRACKDIR) return td;
+		path_found = true;
+		return corridor_td;
 	}
 
 	inline Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, RoadVehPathCache &path_cache)
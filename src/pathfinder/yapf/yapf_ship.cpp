@@ -14,6 +14,7 @@
 
 #include "yapf.hpp"
 #include "yapf_node_ship.hpp"
+#include "../water_regions.h"
 
 #include "../../safeguards.h"
 
@@ -28,6 +29,8 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
+	RegionCorridor m_corridor; ///< Regions the search is restricted to; empty when not restricted.
+
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
 	{
@@ -44,6 +47,8 @@ public:
 	{
 		TrackFollower F(Yapf().GetVehicle());
 		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td)) {
+			/* Do not leave the corridor of regions towards the destination. */
+			if (!m_corridor.empty() && !m_corridor[GetRegionIndex(F.m_new_tile)]) return;
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
@@ -68,6 +73,37 @@ public:
 			return (HasTrackdir(trackdirs, veh_dir)) ? veh_dir : (Trackdir)FindFirstBit2x64(trackdirs);
 		}
 
+		Trackdir td;
+		{
+			Tpf pf;
+			td = pf.FindShipTrack(v, tile, enterdir, path_found, path_cache);
+		}
+		if (path_found || td == INVALID_TRACKDIR) return td;
+
+		/* The search ran out of nodes before reaching the destination, which
+		 * happens easily on open sea. Try again in the regions along a coarse
+		 * route to the destination. The ship is not lost as long as such a
+		 * route exists. */
+		Tpf pf;
+		if (!FindWaterRegionCorridor(tile, v->dest_tile, pf.m_corridor)) return td;
+		path_cache.clear();
+		Trackdir corridor_td = pf.FindShipTrack(v, tile, enterdir, path_found, path_cache);
+		if (corridor_td == INVALID_TRACKDIR) return td;
+		path_found = true;
+		return corridor_td;
+	}
+
+	/**
+	 * Search the path towards the destination of a ship.
+	 * @param v          The ship.
+	 * @param tile       The tile the ship enters.
+	 * @param enterdir   The direction the ship enters the tile in.
+	 * @param path_found [out] Whether the destination has been reached.
+	 * @param path_cache [out] The upcoming trackdirs of the found path.
+	 * @return The trackdir to take on \a tile, or #INVALID_TRACKDIR.
+	 */
+	inline Trackdir FindShipTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, bool &path_found, ShipPathCache &path_cache)
+	{
 		/* move back to the old tile/trackdir (where ship is coming from) */
 		TileIndex src_tile = TileAddByDiagDir(tile, ReverseDiagDir(enterdir));
 		Trackdir trackdir = v->GetVehicleTrackdir();
@@ -78,17 +114,15 @@ public:
 		/* get available trackdirs on the destination tile */
 		TrackdirBits dest_trackdirs = TrackStatusToTrackdirBits(GetTileTrackStatus(v->dest_tile, TRANSPORT_WATER, 0));
 
-		/* create pathfinder instance */
-		Tpf pf;
 		/* set origin and destination nodes */
-		pf.SetOrigin(src_tile, trackdirs);
-		pf.SetDestination(v->dest_tile, dest_trackdirs);
+		Yapf().SetOrigin(src_tile, trackdirs);
+		Yapf().SetDestination(v->dest_tile, dest_trackdirs);
 		/* find best path */
-		path_found = pf.FindPath(v);
+		path_found = Yapf().FindPath(v);
 
 		Trackdir next_trackdir = INVALID_TRACKDIR; // this would mean "path not found"
 
-		Node *pNode = pf.GetBestNode();
+		Node *pNode = Yapf().GetBestNode();
 		if (pNode != NULL) {
 			uint steps = 0;
 			for (Node *n = pNode; n->m_parent != NULL; n = n->m_parent) steps++;
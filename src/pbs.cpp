@@ -14,9 +14,12 @@
 #include "vehicle_func.h"
 #include "newgrf_station.h"
 #include "pathfinder/follow_track.hpp"
+#include "debug.h"
 
 #include "safeguards.h"
 
+uint32 _track_reservation_version = 1; ///< Changes whenever a reservation or the track it lies on changes.
+
 /**
  * Get the reserved trackbits for any tile, regardless of type.
  * @param t the tile
@@ -298,7 +301,25 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res)
 	if (IsRailDepotTile(tile) && !GetDepotReservationTrackBits(tile)) return PBSTileInfo(tile, trackdir, false);
 
 	FindTrainOnTrackInfo ftoti;
-	ftoti.res = FollowReservation(v->owner, GetRailTypeInfo(v->railtype)->compatible_railtypes, tile, trackdir);
+	TrainReservationCache &cache = v->rcache;
+	if (cache.version == _track_reservation_version && cache.start_tile == tile && cache.start_td == trackdir && cache.railtype == v->railtype) {
+		/* Nothing changed since the reservation has been followed the last time. */
+		ftoti.res = PBSTileInfo(cache.end_tile, cache.end_td, false);
+		if (_debug_desync_level >= 2) {
+			PBSTileInfo check = FollowReservation(v->owner, GetRailTypeInfo(v->railtype)->compatible_railtypes, tile, trackdir);
+			if (check.tile != ftoti.res.tile || check.trackdir != ftoti.res.trackdir) {
+				DEBUG(desync, 2, "CACHE ERROR: FollowTrainReservation() = [0x%X %d, 0x%X %d]", ftoti.res.tile, ftoti.res.trackdir, check.tile, check.trackdir);
+			}
+		}
+	} else {
+		ftoti.res = FollowReservation(v->owner, GetRailTypeInfo(v->railtype)->compatible_railtypes, tile, trackdir);
+		cache.version = _track_reservation_version;
+		cache.start_tile = tile;
+		cache.start_td = trackdir;
+		cache.railtype = v->railtype;
+		cache.end_tile = ftoti.res.tile;
+		cache.end_td = ftoti.res.trackdir;
+	}
 	ftoti.res.okay = IsSafeWaitingPosition(v, ftoti.res.tile, ftoti.res.trackdir, true, _settings_game.pf.forbid_90_deg);
 	if (train_on_res != NULL) {
 		FindVehicleOnPos(ftoti.res.tile, &ftoti, FindTrainOnTrackEnum);
@@ -14,6 +14,7 @@
 #include "viewport_func.h"
 #include "command_func.h"
 #include "depot_base.h"
+#include "depot_kdtree.h"
 #include "pathfinder/yapf/yapf_cache.h"
 #include "newgrf_debug.h"
 #include "newgrf_railtype.h"
@@ -882,21 +883,28 @@ static CommandCost CmdRailTrackHelper(TileIndex tile, DoCommandFlag flags, uint3
 
 	bool had_success = false;
 	CommandCost last_error = CMD_ERROR;
-	for (;;) {
-		CommandCost ret = DoCommand(tile, remove ? 0 : railtype, TrackdirToTrack(trackdir), flags, remove ? CMD_REMOVE_SINGLE_RAIL : CMD_BUILD_SINGLE_RAIL);
+	/* When executing, skip the tiles the test run already found to fail. */
+	bool has_plan = HasCommandPlan(flags);
+	for (uint step = 0;; step++) {
+		if (has_plan && step == GetCommandPlanLength()) break;
+
+		if (!has_plan || IsCommandPlanStepDone(step)) {
+			CommandCost ret = DoCommand(tile, remove ? 0 : railtype, TrackdirToTrack(trackdir), flags, remove ? CMD_REMOVE_SINGLE_RAIL : CMD_BUILD_SINGLE_RAIL);
+			RecordCommandPlanStep(flags, ret.Succeeded());
+
+			if (ret.Failed()) {
+				last_error = ret;
+				if (last_error.GetErrorMessage() != STR_ERROR_ALREADY_BUILT && !remove) {
+					if (HasBit(p2, 10)) return last_error;
+					break;
+				}
 
-		if (ret.Failed()) {
-			last_error = ret;
-			if (last_error.GetErrorMessage() != STR_ERROR_ALREADY_BUILT && !remove) {
-				if (HasBit(p2, 10)) return last_error;
-				break;
+				/* Ownership errors are more important. */
+				if (last_error.GetErrorMessage() == STR_ERROR_OWNED_BY && remove) break;
+			} else {
+				had_success = true;
+				total_cost.AddCost(ret);
 			}
-
-			/* Ownership errors are more important. */
-			if (last_error.GetErrorMessage() == STR_ERROR_OWNED_BY && remove) break;
-		} else {
-			had_success = true;
-			total_cost.AddCost(ret);
 		}
 
 		if (tile == end_tile) break;
@@ -996,6 +1004,7 @@ CommandCost CmdBuildTrainDepot(TileIndex tile, DoCommandFlag flags, uint32 p1, u
 
 	if (flags & DC_EXEC) {
 		Depot *d = new Depot(tile);
+		_depot_kdtree.Insert(d->index);
 		d->build_date = _date;
 
 		MakeRailDepot(tile, _current_company, d->index, dir, railtype);
@@ -15,7 +15,9 @@
 #include "viewport_func.h"
 #include "command_func.h"
 #include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/road_regions.h"
 #include "depot_base.h"
+#include "depot_kdtree.h"
 #include "newgrf.h"
 #include "autoslope.h"
 #include "tunnelbridge_map.h"
@@ -235,6 +237,8 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 
 				SetRoadTypes(other_end, GetRoadTypes(other_end) & ~RoadTypeToRoadTypes(rt));
 				SetRoadTypes(tile, GetRoadTypes(tile) & ~RoadTypeToRoadTypes(rt));
+				InvalidateRoadRegion(other_end);
+				InvalidateRoadRegion(tile);
 
 				/* If the owner of the bridge sells all its road, also move the ownership
 				 * to the owner of the other roadtype, unless the bridge owner is a town. */
@@ -264,6 +268,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 					DirtyCompanyInfrastructureWindows(c->index);
 				}
 				SetRoadTypes(tile, GetRoadTypes(tile) & ~RoadTypeToRoadTypes(rt));
+				InvalidateRoadRegion(tile);
 				MarkTileDirtyByTile(tile);
 			}
 		}
@@ -323,6 +328,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 					c->infrastructure.road[rt] -= CountBits(pieces);
 					DirtyCompanyInfrastructureWindows(c->index);
 				}
+				InvalidateRoadRegion(tile);
 
 				if (present == ROAD_NONE) {
 					RoadTypes rts = GetRoadTypes(tile) & ComplementRoadTypes(RoadTypeToRoadTypes(rt));
@@ -393,6 +399,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 				}
 				MarkTileDirtyByTile(tile);
 				YapfNotifyTrackLayoutChange(tile, railtrack);
+				InvalidateRoadRegion(tile);
 			}
 			return CommandCost(EXPENSES_CONSTRUCTION, _price[PR_CLEAR_ROAD] * 2);
 		}
@@ -631,6 +638,7 @@ CommandCost CmdBuildRoad(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 			if (flags & DC_EXEC) {
 				Track railtrack = AxisToTrack(OtherAxis(roaddir));
 				YapfNotifyTrackLayoutChange(tile, railtrack);
+				InvalidateRoadRegion(tile);
 				/* Update company infrastructure counts. A level crossing has two road bits. */
 				Company *c = Company::GetIfValid(company);
 				if (c != NULL) {
@@ -759,6 +767,7 @@ do_clear:;
 				SetRoadTypes(tile, GetRoadTypes(tile) | RoadTypeToRoadTypes(rt));
 				SetRoadOwner(other_end, rt, company);
 				SetRoadOwner(tile, rt, company);
+				InvalidateRoadRegion(other_end);
 
 				/* Mark tiles dirty that have been repaved */
 				if (IsBridge(tile)) {
@@ -795,6 +804,7 @@ do_clear:;
 					GetDisallowedRoadDirections(tile) ^ toggle_drd : DRD_NONE);
 		}
 
+		InvalidateRoadRegion(tile);
 		MarkTileDirtyByTile(tile);
 	}
 	return cost;
@@ -871,48 +881,55 @@ CommandCost CmdBuildLongRoad(TileIndex start_tile, DoCommandFlag flags, uint32 p
 	bool had_success = false;
 	bool is_ai = HasBit(p2, 6);
 
-	/* Start tile is the first tile clicked by the user. */
-	for (;;) {
-		RoadBits bits = AxisToRoadBits(axis);
-
-		/* Determine which road parts should be built. */
-		if (!is_ai && start_tile != end_tile) {
-			/* Only build the first and last roadbit if they can connect to something. */
-			if (tile == end_tile && !CanConnectToRoad(tile, rt, dir)) {
-				bits = DiagDirToRoadBits(ReverseDiagDir(dir));
-			} else if (tile == start_tile && !CanConnectToRoad(tile, rt, ReverseDiagDir(dir))) {
-				bits = DiagDirToRoadBits(dir);
+	/* Start tile is the first tile clicked by the user.
+	 * When executing, skip the tiles the test run already found to fail. */
+	bool has_plan = HasCommandPlan(flags);
+	for (uint step = 0;; step++) {
+		if (has_plan && step == GetCommandPlanLength()) break;
+
+		if (!has_plan || IsCommandPlanStepDone(step)) {
+			RoadBits bits = AxisToRoadBits(axis);
+
+			/* Determine which road parts should be built. */
+			if (!is_ai && start_tile != end_tile) {
+				/* Only build the first and last roadbit if they can connect to something. */
+				if (tile == end_tile && !CanConnectToRoad(tile, rt, dir)) {
+					bits = DiagDirToRoadBits(ReverseDiagDir(dir));
+				} else if (tile == start_tile && !CanConnectToRoad(tile, rt, ReverseDiagDir(dir))) {
+					bits = DiagDirToRoadBits(dir);
+				}
+			} else {
+				/* Road parts only have to be built at the start tile or at the end tile. */
+				if (tile == end_tile && !HasBit(p2, 1)) bits &= DiagDirToRoadBits(ReverseDiagDir(dir));
+				if (tile == start_tile && HasBit(p2, 0)) bits &= DiagDirToRoadBits(dir);
 			}
-		} else {
-			/* Road parts only have to be built at the start tile or at the end tile. */
-			if (tile == end_tile && !HasBit(p2, 1)) bits &= DiagDirToRoadBits(ReverseDiagDir(dir));
-			if (tile == start_tile && HasBit(p2, 0)) bits &= DiagDirToRoadBits(dir);
-		}
 
-		CommandCost ret = DoCommand(tile, drd << 6 | rt << 4 | bits, 0, flags, CMD_BUILD_ROAD);
-		if (ret.Failed()) {
-			last_error = ret;
-			if (last_error.GetErrorMessage() != STR_ERROR_ALREADY_BUILT) {
-				if (is_ai) return last_error;
-				break;
-			}
-		} else {
-			had_success = true;
-			/* Only pay for the upgrade on one side of the bridges and tunnels */
-			if (IsTileType(tile, MP_TUNNELBRIDGE)) {
-				if (IsBridge(tile)) {
-					if (!had_bridge || GetTunnelBridgeDirection(tile) == dir) {
-						cost.AddCost(ret);
-					}
-					had_bridge = true;
-				} else { // IsTunnel(tile)
-					if (!had_tunnel || GetTunnelBridgeDirection(tile) == dir) {
-						cost.AddCost(ret);
-					}
-					had_tunnel = true;
+			CommandCost ret = DoCommand(tile, drd << 6 | rt << 4 | bits, 0, flags, CMD_BUILD_ROAD);
+			RecordCommandPlanStep(flags, ret.Succeeded());
+			if (ret.Failed()) {
+				last_error = ret;
+				if (last_error.GetErrorMessage() != STR_ERROR_ALREADY_BUILT) {
+					if (is_ai) return last_error;
+					break;
 				}
 			} else {
-				cost.AddCost(ret);
+				had_success = true;
+				/* Only pay for the upgrade on one side of the bridges and tunnels */
+				if (IsTileType(tile, MP_TUNNELBRIDGE)) {
+					if (IsBridge(tile)) {
+						if (!had_bridge || GetTunnelBridgeDirection(tile) == dir) {
+							cost.AddCost(ret);
+						}
+						had_bridge = true;
+					} else { // IsTunnel(tile)
+						if (!had_tunnel || GetTunnelBridgeDirection(tile) == dir) {
+							cost.AddCost(ret);
+						}
+						had_tunnel = true;
+					}
+				} else {
+					cost.AddCost(ret);
+				}
 			}
 		}
 
@@ -1038,6 +1055,7 @@ CommandCost CmdBuildRoadDepot(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 
 	if (flags & DC_EXEC) {
 		Depot *dep = new Depot(tile);
+		_depot_kdtree.Insert(dep->index);
 		dep->build_date = _date;
 
 		/* A road depot has two road bits. */
@@ -1045,6 +1063,7 @@ CommandCost CmdBuildRoadDepot(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 		DirtyCompanyInfrastructureWindows(_current_company);
 
 		MakeRoadDepot(tile, _current_company, dep->index, dir, rt);
+		InvalidateRoadRegion(tile);
 		MarkTileDirtyByTile(tile);
 		MakeDefaultName(dep);
 	}
@@ -1072,6 +1091,7 @@ static CommandCost RemoveRoadDepot(TileIndex tile, DoCommandFlag flags)
 
 		delete Depot::GetByTile(tile);
 		DoClearSquare(tile);
+		InvalidateRoadRegion(tile);
 	}
 
 	return CommandCost(EXPENSES_CONSTRUCTION, _price[PR_CLEAR_DEPOT_ROAD]);
@@ -269,12 +269,60 @@ bool RoadStop::Enter(RoadVehicle *rv)
 {
 	const Station *st = Station::GetByTile(tile);
 
-	for (RoadStop *rs = st->GetPrimaryRoadStop(type);; rs = rs->next) {
+	/* The index is not invalidated when road stops are built or removed, so
+	 * verify the entry: only one road stop can be at the tile. On a miss the
+	 * index is rebuilt from the current road stop list. */
+	RoadStop *rs = LookupRoadStopIndex(st, tile, type);
+	if (rs != NULL) return rs;
+
+	RebuildRoadStopIndex(st, type);
+	rs = LookupRoadStopIndex(st, tile, type);
+	if (rs != NULL) return rs;
+
+	for (rs = st->GetPrimaryRoadStop(type);; rs = rs->next) {
 		if (rs->xy == tile) return rs;
 		assert(rs->next != NULL);
 	}
 }
 
+/**
+ * Look up the road stop at a tile in the road stop index of a station.
+ * @param st The station to look in.
+ * @param tile The tile of the road stop.
+ * @param type The type of the road stop.
+ * @return The road stop, or NULL when the index does not know about it.
+ */
+/* static */ RoadStop *RoadStop::LookupRoadStopIndex(const Station *st, TileIndex tile, RoadStopType type)
+{
+	const TileArea &area = st->road_stop_index_area[type];
+	if (!area.Contains(tile)) return NULL;
+
+	RoadStopID id = st->road_stop_index[type][(TileY(tile) - TileY(area.tile)) * area.w + TileX(tile) - TileX(area.tile)];
+	if (!RoadStop::IsValidID(id)) return NULL;
+
+	RoadStop *rs = RoadStop::Get(id);
+	return rs->xy == tile ? rs : NULL;
+}
+
+/**
+ * Rebuild the road stop index of a station from its list of road stops.
+ * @param st The station to rebuild the index of.
+ * @param type The type of road stops to rebuild the index for.
+ */
+/* static */ void RoadStop::RebuildRoadStopIndex(const Station *st, RoadStopType type)
+{
+	TileArea &area = st->road_stop_index_area[type];
+	std::vector<RoadStopID> &index = st->road_stop_index[type];
+
+	area = type == ROADSTOP_BUS ? st->bus_station : st->truck_station;
+	index.assign(area.w * area.h, INVALID_ROADSTOP);
+
+	for (const RoadStop *rs = st->GetPrimaryRoadStop(type); rs != NULL; rs = rs->next) {
+		if (!area.Contains(rs->xy)) continue;
+		index[(TileY(rs->xy) - TileY(area.tile)) * area.w + TileX(rs->xy) - TileX(area.tile)] = rs->index;
+	}
+}
+
 /**
  * Leave the road stop
  * @param rv the vehicle that leaves the stop
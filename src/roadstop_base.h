@@ -149,6 +149,9 @@ struct RoadStop : RoadStopPool::PoolItem<&_roadstop_pool> {
 	static bool IsDriveThroughRoadStopContinuation(TileIndex rs, TileIndex next);
 
 private:
+	static RoadStop *LookupRoadStopIndex(const struct Station *st, TileIndex tile, RoadStopType type);
+	static void RebuildRoadStopIndex(const struct Station *st, RoadStopType type);
+
 	Entry *east; ///< The vehicles that entered from the east
 	Entry *west; ///< The vehicles that entered from the west
 
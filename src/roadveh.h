@@ -118,6 +118,9 @@ struct RoadVehicle FINAL : public GroundVehicle<RoadVehicle, VEH_ROAD> {
 	RoadType roadtype;
 	RoadTypes compatible_roadtypes;
 
+	VehicleTileHashBucket *hash_road_current; ///< NOSAVE: Bucket of the road vehicle tile location hash the vehicle is in.
+	uint hash_road_pos;                       ///< NOSAVE: Position of the vehicle within #hash_road_current.
+
 	/** We don't want GCC to zero our struct! It already is zeroed and has an index! */
 	RoadVehicle() : GroundVehicleBase() {}
 	/** We want to 'destruct' the right class. */
@@ -137,6 +140,7 @@ struct RoadVehicle FINAL : public GroundVehicle<RoadVehicle, VEH_ROAD> {
 	bool IsInDepot() const { return this->state == RVSB_IN_DEPOT; }
 	bool Tick();
 	void OnNewDay();
+	void OnServiceDepotSearch();
 	uint Crash(bool flooded = false);
 	Trackdir GetVehicleTrackdir() const;
 	TileIndex GetOrderStationLocation(StationID station);
@@ -658,10 +658,10 @@ static RoadVehicle *RoadVehFindCloseTo(RoadVehicle *v, int x, int y, Direction d
 	rvf.best_diff = UINT_MAX;
 
 	if (front->state == RVSB_WORMHOLE) {
-		FindVehicleOnPos(v->tile, &rvf, EnumCheckRoadVehClose);
-		FindVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), &rvf, EnumCheckRoadVehClose);
+		FindRoadVehicleOnPos(v->tile, &rvf, EnumCheckRoadVehClose);
+		FindRoadVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), &rvf, EnumCheckRoadVehClose);
 	} else {
-		FindVehicleOnPosXY(x, y, &rvf, EnumCheckRoadVehClose);
+		FindRoadVehicleOnPosXY(x, y, &rvf, EnumCheckRoadVehClose);
 	}
 
 	/* This code protects a roadvehicle from being blocked for ever
@@ -1675,6 +1675,12 @@ static void CheckIfRoadVehNeedsService(RoadVehicle *v)
 	SetWindowWidgetDirty(WC_VEHICLE_VIEW, v->index, WID_VV_START_STOP);
 }
 
+/** Look for a depot to service at, as queued by the daily check. */
+void RoadVehicle::OnServiceDepotSearch()
+{
+	if (this->IsFrontEngine()) CheckIfRoadVehNeedsService(this);
+}
+
 void RoadVehicle::OnNewDay()
 {
 	AgeVehicle(this);
@@ -1684,7 +1690,7 @@ void RoadVehicle::OnNewDay()
 	if ((++this->day_counter & 7) == 0) DecreaseVehicleValue(this);
 	if (this->blocked_ctr == 0) CheckVehicleBreakdown(this);
 
-	CheckIfRoadVehNeedsService(this);
+	if (this->NeedsAutomaticServicing()) QueueServiceDepotSearch(this);
 
 	CheckOrders(this);
 
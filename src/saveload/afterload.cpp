@@ -24,6 +24,7 @@
 #include "../clear_map.h"
 #include "../vehicle_func.h"
 #include "../string_func.h"
+#include "../strings_func.h"
 #include "../date_func.h"
 #include "../roadveh.h"
 #include "../train.h"
@@ -32,6 +33,8 @@
 #include "../roadstop_base.h"
 #include "../tunnelbridge_map.h"
 #include "../pathfinder/yapf/yapf_cache.h"
+#include "../pathfinder/road_regions.h"
+#include "../pathfinder/water_regions.h"
 #include "../elrail_func.h"
 #include "../signs_func.h"
 #include "../aircraft.h"
@@ -49,6 +52,7 @@
 #include "../subsidy_func.h"
 #include "../newgrf.h"
 #include "../engine_func.h"
+#include "../engine_gui.h"
 #include "../rail_gui.h"
 #include "../core/backup_type.hpp"
 #include "../smallmap_gui.h"
@@ -57,11 +61,14 @@
 #include "../error.h"
 #include "../disaster_vehicle.h"
 #include "../ship.h"
+#include "../thread/thread_pool.h"
+#include "../core/name_registry_type.hpp"
 
 
 #include "saveload_internal.h"
 
 #include <signal.h>
+#include <chrono>
 
 #include "../safeguards.h"
 
@@ -219,12 +226,31 @@ static inline RailType UpdateRailType(RailType rt, RailType min)
  */
 void UpdateAllVirtCoords()
 {
+	ClearStringCache();
 	UpdateAllStationVirtCoords();
 	UpdateAllSignVirtCoords();
 	UpdateAllTownVirtCoords();
 	RebuildViewportKdtree();
 }
 
+static std::chrono::steady_clock::time_point _load_profile_step; ///< Start of the current step of loading, for the load profile.
+
+/**
+ * Record the time spent in a step of loading a savegame and start timing
+ * the next step. The load profile is shown at debug level sl=2.
+ * @param step Name of the step that just finished, or \c NULL to only start timing.
+ */
+static void LoadProfileStep(const char *step)
+{
+	if (_debug_sl_level < 2) return;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (step != NULL) {
+		DEBUG(sl, 2, "Load profile: %-20s %8.2f ms", step, std::chrono::duration<double, std::milli>(now - _load_profile_step).count());
+	}
+	_load_profile_step = now;
+}
+
 /**
  * Initialization of the windows and several kinds of caches.
  * This is not done directly in AfterLoadGame because these
@@ -238,11 +264,20 @@ static void InitializeWindowsAndCaches()
 {
 	/* Initialize windows */
 	ResetWindowSystem();
+	InvalidateEngineSortValues();
 	SetupColoursAndInitialWindow();
+	LoadProfileStep("windows");
 
-	/* Update coordinates of the signs. */
-	UpdateAllVirtCoords();
+	/* Update coordinates of the signs. A dedicated server never shows them, so
+	 * it does not format their strings; it still needs the k-d tree of the
+	 * signs, as removing a station, waypoint or sign takes it out of it. */
+	if (_network_dedicated) {
+		RebuildViewportKdtree();
+	} else {
+		UpdateAllVirtCoords();
+	}
 	ResetViewportAfterLoadGame();
+	LoadProfileStep("signs");
 
 	Company *c;
 	FOR_ALL_COMPANIES(c) {
@@ -300,6 +335,7 @@ static void InitializeWindowsAndCaches()
 
 	/* Rebuild the smallmap list of owners. */
 	BuildOwnerLegend();
+	LoadProfileStep("window caches");
 }
 
 typedef void (CDECL *SignalHandlerPointer)(int);
@@ -518,6 +554,31 @@ static inline bool MayHaveBridgeAbove(TileIndex t)
 			IsTileType(t, MP_WATER) || IsTileType(t, MP_TUNNELBRIDGE) || IsTileType(t, MP_OBJECT);
 }
 
+/**
+ * Rebuild some of the spatial indices of the game.
+ * Every index only reads the pools and writes its own tree, so they can be built in parallel.
+ * @param first First index to rebuild.
+ * @param last  One past the last index to rebuild.
+ */
+static void RebuildKdtreeRange(void *, uint first, uint last)
+{
+	for (uint i = first; i < last; i++) {
+		switch (i) {
+			case 0: RebuildTownKdtree(); break;
+			case 1: RebuildStationKdtree(); break;
+			case 2: RebuildViewportKdtree(); break;
+			case 3: RebuildDepotKdtree(); break;
+			default: NOT_REACHED();
+		}
+	}
+}
+
+/** Rebuild the town, station, viewport sign and depot k-d trees, spread over the worker threads. */
+static void RebuildKdtrees()
+{
+	ThreadPoolParallelFor(&RebuildKdtreeRange, NULL, 4, 1);
+}
+
 /**
  * Perform a (large) amount of savegame conversion *magic* in order to
  * load older savegames and to fill the caches for various purposes.
@@ -526,9 +587,18 @@ static inline bool MayHaveBridgeAbove(TileIndex t)
 bool AfterLoadGame()
 {
 	SetSignalHandlers();
+	LoadProfileStep(NULL);
 
 	TileIndex map_size = MapSize();
 
+#ifdef WITH_SLOPE_CACHE
+	/* The heights were loaded without SetTileHeight, so the slopes must be determined before anything asks for them. */
+	RebuildTileSlopeCache();
+#endif /* WITH_SLOPE_CACHE */
+
+	/* The names were loaded without telling the name registries. */
+	NameRegistry::InvalidateAll();
+
 	extern TileIndex _cur_tileloop_tile; // From landscape.cpp.
 	/* The LFSR used in RunTileLoop iteration cannot have a zeroed state, make it non-zeroed. */
 	if (_cur_tileloop_tile == 0) _cur_tileloop_tile = 1;
@@ -538,11 +608,14 @@ bool AfterLoadGame()
 	GamelogTestRevision();
 	GamelogTestMode();
 
-	RebuildTownKdtree();
-	RebuildStationKdtree();
-	/* This needs to be done even before conversion, because some conversions will destroy objects
-	 * that otherwise won't exist in the tree. */
-	RebuildViewportKdtree();
+	/* The bridges and tunnels are converted and possibly removed below, without keeping the indices up to date. */
+	InvalidateBridgeIndex();
+	InvalidateTunnelIndex();
+
+	/* The viewport tree needs to be built even before conversion, because some conversions will
+	 * destroy objects that otherwise won't exist in the tree. */
+	RebuildKdtrees();
+	LoadProfileStep("k-d trees");
 
 	if (IsSavegameVersionBefore(SLV_98)) GamelogGRFAddList(_grfconfig);
 
@@ -604,6 +677,9 @@ bool AfterLoadGame()
 				SB(_m[t].type, 2, 2, 0);
 			}
 		}
+#ifdef WITH_SLOPE_CACHE
+		RebuildTileSlopeCache();
+#endif /* WITH_SLOPE_CACHE */
 	}
 
 	/* in version 2.1 of the savegame, town owner was unified. */
@@ -749,6 +825,7 @@ bool AfterLoadGame()
 	/* Load the sprites */
 	GfxLoadSprites();
 	LoadStringWidthTable();
+	LoadProfileStep("sprites");
 
 	/* Copy temporary data to Engine pool */
 	CopyTempEngineData();
@@ -782,6 +859,7 @@ bool AfterLoadGame()
 
 	/* Update all vehicles */
 	AfterLoadVehicles(true);
+	LoadProfileStep("vehicles");
 
 	/* Make sure there is an AI attached to an AI company */
 	{
@@ -1366,6 +1444,8 @@ bool AfterLoadGame()
 	}
 
 	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	InvalidateAllRoadRegions();
+	InvalidateAllWaterRegions();
 
 	if (IsSavegameVersionBefore(SLV_34)) {
 		Company *c;
@@ -2193,23 +2273,15 @@ bool AfterLoadGame()
 
 	if (IsSavegameVersionBefore(SLV_122)) {
 		/* Animated tiles would sometimes not be actually animated or
-		 * in case of old savegames duplicate. */
+		 * in case of old savegames duplicate. The duplicates have
+		 * already been dropped when loading the table. */
 
 		extern SmallVector<TileIndex, 256> _animated_tiles;
 
-		for (TileIndex *tile = _animated_tiles.Begin(); tile < _animated_tiles.End(); /* Nothing */) {
-			/* Remove if tile is not animated */
-			bool remove = _tile_type_procs[GetTileType(*tile)]->animate_tile_proc == NULL;
-
-			/* and remove if duplicate */
-			for (TileIndex *j = _animated_tiles.Begin(); !remove && j < tile; j++) {
-				remove = *tile == *j;
-			}
-
-			if (remove) {
+		for (TileIndex *tile = _animated_tiles.Begin(); tile < _animated_tiles.End(); tile++) {
+			/* Remove if tile is not animated; this leaves a hole in its place. */
+			if (*tile != INVALID_TILE && _tile_type_procs[GetTileType(*tile)]->animate_tile_proc == NULL) {
 				DeleteAnimatedTile(*tile);
-			} else {
-				tile++;
 			}
 		}
 	}
@@ -3111,6 +3183,18 @@ bool AfterLoadGame()
 		FOR_ALL_INDUSTRIES(ind) if (ind->neutral_station != NULL) ind->neutral_station->industry = ind;
 	}
 
+	{
+		/* The animation triggers of the industry tiles are not saved. */
+		Industry *ind;
+		FOR_ALL_INDUSTRIES(ind) ind->UpdateTileAnimationTriggers();
+	}
+
+	LoadProfileStep("conversions");
+
+	RebuildBridgeIndex();
+	RebuildTunnelIndex();
+	LoadProfileStep("bridge and tunnel index");
+
 	/* Compute station catchment areas. This is needed here in case UpdateStationAcceptance is called below. */
 	Station::RecomputeCatchmentForAll();
 
@@ -3125,6 +3209,7 @@ bool AfterLoadGame()
 	AfterLoadLabelMaps();
 	AfterLoadCompanyStats();
 	AfterLoadStoryBook();
+	LoadProfileStep("station and company");
 
 	GamelogPrintDebug(1);
 
@@ -3133,6 +3218,9 @@ bool AfterLoadGame()
 	ResetSignalHandlers();
 
 	AfterLoadLinkGraphs();
+	LoadProfileStep("link graphs");
+
+	CompactMapMemory();
 	return true;
 }
 
@@ -3150,6 +3238,8 @@ void ReloadNewGRFData()
 	GfxLoadSprites();
 	LoadStringWidthTable();
 	RecomputePrices();
+	/* The NewGRF town names may have changed. */
+	NameRegistry::InvalidateAll();
 	/* reload vehicles */
 	ResetVehicleHash();
 	AfterLoadVehicles(false);
@@ -3157,6 +3247,15 @@ void ReloadNewGRFData()
 	GroupStatistics::UpdateAfterLoad();
 	/* update station graphics */
 	AfterLoadStations();
+	/* The animation triggers of the industry tiles may have changed. */
+	Industry *ind;
+	FOR_ALL_INDUSTRIES(ind) ind->UpdateTileAnimationTriggers();
+	/* The rating and acceptance callbacks may have changed; compute all ratings and acceptances again. */
+	Station *st;
+	FOR_ALL_STATIONS(st) {
+		for (CargoID c = 0; c < NUM_CARGO; c++) st->goods[c].rating_cache_key = 0;
+		st->acceptance_cache_valid = false;
+	}
 	/* Update company statistics. */
 	AfterLoadCompanyStats();
 	/* Check and update house and town values */
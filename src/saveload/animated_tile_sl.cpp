@@ -13,6 +13,7 @@
 #include "../tile_type.h"
 #include "../core/alloc_func.hpp"
 #include "../core/smallvec_type.hpp"
+#include "../animated_tile_func.h"
 
 #include "saveload.h"
 
@@ -25,8 +26,16 @@ extern SmallVector<TileIndex, 256> _animated_tiles;
  */
 static void Save_ANIT()
 {
-	SlSetLength(_animated_tiles.Length() * sizeof(*_animated_tiles.Begin()));
-	SlArray(_animated_tiles.Begin(), _animated_tiles.Length(), SLE_UINT32);
+	/* Skip the holes left by deleted tiles. */
+	uint count = 0;
+	for (const TileIndex *tile = _animated_tiles.Begin(); tile != _animated_tiles.End(); tile++) {
+		if (*tile != INVALID_TILE) count++;
+	}
+
+	SlSetLength(count * sizeof(*_animated_tiles.Begin()));
+	for (TileIndex *tile = _animated_tiles.Begin(); tile != _animated_tiles.End(); tile++) {
+		if (*tile != INVALID_TILE) SlArray(tile, 1, SLE_UINT32);
+	}
 }
 
 /**
@@ -44,6 +53,7 @@ static void Load_ANIT()
 			if (anim_list[i] == 0) break;
 			*_animated_tiles.Append() = anim_list[i];
 		}
+		RebuildAnimatedTileIndex();
 		return;
 	}
 
@@ -51,6 +61,7 @@ static void Load_ANIT()
 	_animated_tiles.Clear();
 	_animated_tiles.Append(count);
 	SlArray(_animated_tiles.Begin(), count, SLE_UINT32);
+	RebuildAnimatedTileIndex();
 }
 
 /**
@@ -14,6 +14,9 @@
 
 #include "saveload.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "../safeguards.h"
 
 /** Temporary storage of cargo monitoring data for loading or saving it. */
@@ -44,25 +47,40 @@ static CargoMonitorID FixupCargoMonitor(CargoMonitorID number)
 	return number;
 }
 
-/** Save the #_cargo_deliveries monitoring map. */
-static void SaveDelivery()
+/**
+ * Save a cargo monitoring map.
+ * The map is unordered, so the monitors are written sorted by their number
+ * to keep the saved game independent of the hash table layout.
+ * @param cargo_monitor_map The map to save.
+ */
+static void SaveCargoMonitorMap(const CargoMonitorMap &cargo_monitor_map)
 {
+	typedef std::pair<CargoMonitorID, int32> Monitor;
+	std::vector<Monitor> monitors(cargo_monitor_map.begin(), cargo_monitor_map.end());
+	std::sort(monitors.begin(), monitors.end(), [](const Monitor &a, const Monitor &b) {
+		return a.first < b.first;
+	});
+
 	TempStorage storage;
 
 	int i = 0;
-	CargoMonitorMap::const_iterator iter = _cargo_deliveries.begin();
-	while (iter != _cargo_deliveries.end()) {
-		storage.number = iter->first;
-		storage.amount = iter->second;
+	for (const Monitor &monitor : monitors) {
+		storage.number = monitor.first;
+		storage.amount = monitor.second;
 
 		SlSetArrayIndex(i);
 		SlObject(&storage, _cargomonitor_pair_desc);
 
 		i++;
-		iter++;
 	}
 }
 
+/** Save the #_cargo_deliveries monitoring map. */
+static void SaveDelivery()
+{
+	SaveCargoMonitorMap(_cargo_deliveries);
+}
+
 /** Load the #_cargo_deliveries monitoring map. */
 static void LoadDelivery()
 {
@@ -85,20 +103,7 @@ static void LoadDelivery()
 /** Save the #_cargo_pickups monitoring map. */
 static void SavePickup()
 {
-	TempStorage storage;
-
-	int i = 0;
-	CargoMonitorMap::const_iterator iter = _cargo_pickups.begin();
-	while (iter != _cargo_pickups.end()) {
-		storage.number = iter->first;
-		storage.amount = iter->second;
-
-		SlSetArrayIndex(i);
-		SlObject(&storage, _cargomonitor_pair_desc);
-
-		i++;
-		iter++;
-	}
+	SaveCargoMonitorMap(_cargo_pickups);
 }
 
 /** Load the #_cargo_pickups monitoring map. */
@@ -17,6 +17,7 @@
 #include "../tunnelbridge.h"
 #include "../station_base.h"
 #include "../strings_func.h"
+#include "../thread/thread_pool.h"
 
 #include "saveload.h"
 
@@ -92,25 +93,30 @@ CompanyManagerFace ConvertFromOldCompanyManagerFace(uint32 face)
 	return cmf;
 }
 
-/** Rebuilding of company statistics after loading a savegame. */
-void AfterLoadCompanyStats()
+/**
+ * Get the infrastructure counts of a company.
+ * @param infra The infrastructure counts of all companies.
+ * @param owner The owner to get the counts for.
+ * @return The counts, or \c NULL if the owner is no company.
+ */
+static inline CompanyInfrastructure *GetInfrastructureOf(CompanyInfrastructure *infra, Owner owner)
 {
-	/* Reset infrastructure statistics to zero. */
-	Company *c;
-	FOR_ALL_COMPANIES(c) MemSetT(&c->infrastructure, 0);
-
-	/* Collect airport count. */
-	Station *st;
-	FOR_ALL_STATIONS(st) {
-		if ((st->facilities & FACIL_AIRPORT) && Company::IsValidID(st->owner)) {
-			Company::Get(st->owner)->infrastructure.airport++;
-		}
-	}
+	return Company::IsValidID(owner) ? &infra[owner] : NULL;
+}
 
-	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+/**
+ * Count the infrastructure of the companies on a range of tiles.
+ * @param infra The infrastructure counts per company to add to.
+ * @param begin The first tile to count.
+ * @param end   One past the last tile to count.
+ */
+static void CountCompanyInfrastructure(CompanyInfrastructure *infra, TileIndex begin, TileIndex end)
+{
+	CompanyInfrastructure *c;
+	for (TileIndex tile = begin; tile < end; tile++) {
 		switch (GetTileType(tile)) {
 			case MP_RAILWAY:
-				c = Company::GetIfValid(GetTileOwner(tile));
+				c = GetInfrastructureOf(infra, GetTileOwner(tile));
 				if (c != NULL) {
 					uint pieces = 1;
 					if (IsPlainRail(tile)) {
@@ -118,36 +124,36 @@ void AfterLoadCompanyStats()
 						pieces = CountBits(bits);
 						if (TracksOverlap(bits)) pieces *= pieces;
 					}
-					c->infrastructure.rail[GetRailType(tile)] += pieces;
+					c->rail[GetRailType(tile)] += pieces;
 
-					if (HasSignals(tile)) c->infrastructure.signal += CountBits(GetPresentSignals(tile));
+					if (HasSignals(tile)) c->signal += CountBits(GetPresentSignals(tile));
 				}
 				break;
 
 			case MP_ROAD: {
 				if (IsLevelCrossing(tile)) {
-					c = Company::GetIfValid(GetTileOwner(tile));
-					if (c != NULL) c->infrastructure.rail[GetRailType(tile)] += LEVELCROSSING_TRACKBIT_FACTOR;
+					c = GetInfrastructureOf(infra, GetTileOwner(tile));
+					if (c != NULL) c->rail[GetRailType(tile)] += LEVELCROSSING_TRACKBIT_FACTOR;
 				}
 
 				/* Iterate all present road types as each can have a different owner. */
 				RoadType rt;
 				FOR_EACH_SET_ROADTYPE(rt, GetRoadTypes(tile)) {
-					c = Company::GetIfValid(IsRoadDepot(tile) ? GetTileOwner(tile) : GetRoadOwner(tile, rt));
+					c = GetInfrastructureOf(infra, IsRoadDepot(tile) ? GetTileOwner(tile) : GetRoadOwner(tile, rt));
 					/* A level crossings and depots have two road bits. */
-					if (c != NULL) c->infrastructure.road[rt] += IsNormalRoad(tile) ? CountBits(GetRoadBits(tile, rt)) : 2;
+					if (c != NULL) c->road[rt] += IsNormalRoad(tile) ? CountBits(GetRoadBits(tile, rt)) : 2;
 				}
 				break;
 			}
 
 			case MP_STATION:
-				c = Company::GetIfValid(GetTileOwner(tile));
-				if (c != NULL && GetStationType(tile) != STATION_AIRPORT && !IsBuoy(tile)) c->infrastructure.station++;
+				c = GetInfrastructureOf(infra, GetTileOwner(tile));
+				if (c != NULL && GetStationType(tile) != STATION_AIRPORT && !IsBuoy(tile)) c->station++;
 
 				switch (GetStationType(tile)) {
 					case STATION_RAIL:
 					case STATION_WAYPOINT:
-						if (c != NULL && !IsStationTileBlocked(tile)) c->infrastructure.rail[GetRailType(tile)]++;
+						if (c != NULL && !IsStationTileBlocked(tile)) c->rail[GetRailType(tile)]++;
 						break;
 
 					case STATION_BUS:
@@ -155,8 +161,8 @@ void AfterLoadCompanyStats()
 						/* Iterate all present road types as each can have a different owner. */
 						RoadType rt;
 						FOR_EACH_SET_ROADTYPE(rt, GetRoadTypes(tile)) {
-							c = Company::GetIfValid(GetRoadOwner(tile, rt));
-							if (c != NULL) c->infrastructure.road[rt] += 2; // A road stop has two road bits.
+							c = GetInfrastructureOf(infra, GetRoadOwner(tile, rt));
+							if (c != NULL) c->road[rt] += 2; // A road stop has two road bits.
 						}
 						break;
 					}
@@ -164,7 +170,7 @@ void AfterLoadCompanyStats()
 					case STATION_DOCK:
 					case STATION_BUOY:
 						if (GetWaterClass(tile) == WATER_CLASS_CANAL) {
-							if (c != NULL) c->infrastructure.water++;
+							if (c != NULL) c->water++;
 						}
 						break;
 
@@ -175,12 +181,12 @@ void AfterLoadCompanyStats()
 
 			case MP_WATER:
 				if (IsShipDepot(tile) || IsLock(tile)) {
-					c = Company::GetIfValid(GetTileOwner(tile));
+					c = GetInfrastructureOf(infra, GetTileOwner(tile));
 					if (c != NULL) {
-						if (IsShipDepot(tile)) c->infrastructure.water += LOCK_DEPOT_TILE_FACTOR;
+						if (IsShipDepot(tile)) c->water += LOCK_DEPOT_TILE_FACTOR;
 						if (IsLock(tile) && GetLockPart(tile) == LOCK_PART_MIDDLE) {
 							/* The middle tile specifies the owner of the lock. */
-							c->infrastructure.water += 3 * LOCK_DEPOT_TILE_FACTOR; // the middle tile specifies the owner of the
+							c->water += 3 * LOCK_DEPOT_TILE_FACTOR; // the middle tile specifies the owner of the
 							break; // do not count the middle tile as canal
 						}
 					}
@@ -189,8 +195,8 @@ void AfterLoadCompanyStats()
 
 			case MP_OBJECT:
 				if (GetWaterClass(tile) == WATER_CLASS_CANAL) {
-					c = Company::GetIfValid(GetTileOwner(tile));
-					if (c != NULL) c->infrastructure.water++;
+					c = GetInfrastructureOf(infra, GetTileOwner(tile));
+					if (c != NULL) c->water++;
 				}
 				break;
 
@@ -204,23 +210,23 @@ void AfterLoadCompanyStats()
 
 					switch (GetTunnelBridgeTransportType(tile)) {
 						case TRANSPORT_RAIL:
-							c = Company::GetIfValid(GetTileOwner(tile));
-							if (c != NULL) c->infrastructure.rail[GetRailType(tile)] += len;
+							c = GetInfrastructureOf(infra, GetTileOwner(tile));
+							if (c != NULL) c->rail[GetRailType(tile)] += len;
 							break;
 
 						case TRANSPORT_ROAD: {
 							/* Iterate all present road types as each can have a different owner. */
 							RoadType rt;
 							FOR_EACH_SET_ROADTYPE(rt, GetRoadTypes(tile)) {
-								c = Company::GetIfValid(GetRoadOwner(tile, rt));
-								if (c != NULL) c->infrastructure.road[rt] += len * 2; // A full diagonal road has two road bits.
+								c = GetInfrastructureOf(infra, GetRoadOwner(tile, rt));
+								if (c != NULL) c->road[rt] += len * 2; // A full diagonal road has two road bits.
 							}
 							break;
 						}
 
 						case TRANSPORT_WATER:
-							c = Company::GetIfValid(GetTileOwner(tile));
-							if (c != NULL) c->infrastructure.water += len;
+							c = GetInfrastructureOf(infra, GetTileOwner(tile));
+							if (c != NULL) c->water += len;
 							break;
 
 						default:
@@ -236,6 +242,56 @@ void AfterLoadCompanyStats()
 	}
 }
 
+static const uint INFRASTRUCTURE_COUNT_ROWS = 64; ///< Number of map rows counted at once by a worker thread.
+
+/**
+ * Count the infrastructure of a range of pieces of the map, each into its own counts.
+ * @param data  The counts of all pieces, #MAX_COMPANIES per piece.
+ * @param first The first piece to count.
+ * @param last  One past the last piece to count.
+ */
+static void CountCompanyInfrastructureProc(void *data, uint first, uint last)
+{
+	CompanyInfrastructure *counts = (CompanyInfrastructure *)data;
+	for (uint i = first; i < last; i++) {
+		TileIndex begin = min<TileIndex>(i * INFRASTRUCTURE_COUNT_ROWS * MapSizeX(), MapSize());
+		TileIndex end = min<TileIndex>((i + 1) * INFRASTRUCTURE_COUNT_ROWS * MapSizeX(), MapSize());
+		CountCompanyInfrastructure(counts + i * MAX_COMPANIES, begin, end);
+	}
+}
+
+/** Rebuilding of company statistics after loading a savegame. */
+void AfterLoadCompanyStats()
+{
+	/* Reset infrastructure statistics to zero. */
+	Company *c;
+	FOR_ALL_COMPANIES(c) MemSetT(&c->infrastructure, 0);
+
+	/* Collect airport count. */
+	Station *st;
+	FOR_ALL_STATIONS(st) {
+		if ((st->facilities & FACIL_AIRPORT) && Company::IsValidID(st->owner)) {
+			Company::Get(st->owner)->infrastructure.airport++;
+		}
+	}
+
+	/* Count the map in pieces on the worker threads, then add up the counts of the pieces. */
+	uint pieces = CeilDiv(MapSizeY(), INFRASTRUCTURE_COUNT_ROWS);
+	std::vector<CompanyInfrastructure> counts(pieces * MAX_COMPANIES);
+	ThreadPoolParallelFor(&CountCompanyInfrastructureProc, &counts[0], pieces, 1);
+
+	FOR_ALL_COMPANIES(c) {
+		for (uint i = 0; i < pieces; i++) {
+			const CompanyInfrastructure &piece = counts[i * MAX_COMPANIES + c->index];
+			for (RoadType rt = ROADTYPE_BEGIN; rt < ROADTYPE_END; rt++) c->infrastructure.road[rt] += piece.road[rt];
+			for (RailType rt = RAILTYPE_BEGIN; rt < RAILTYPE_END; rt++) c->infrastructure.rail[rt] += piece.rail[rt];
+			c->infrastructure.signal  += piece.signal;
+			c->infrastructure.water   += piece.water;
+			c->infrastructure.station += piece.station;
+		}
+	}
+}
+
 
 
 /* Save/load of companies */
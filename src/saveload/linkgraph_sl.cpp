@@ -24,6 +24,7 @@ typedef LinkGraph::BaseEdge Edge;
 const SettingDesc *GetSettingDescription(uint index);
 
 static uint16 _num_nodes;
+static uint16 _next_edge; ///< Destination of the next saved edge of the same node, or INVALID_NODE after the last one.
 
 /**
  * Get a SaveLoad array for a link graph.
@@ -35,6 +36,8 @@ const SaveLoad *GetLinkGraphDesc()
 		 SLE_VAR(LinkGraph, last_compression, SLE_INT32),
 		SLEG_VAR(_num_nodes,                  SLE_UINT16),
 		 SLE_VAR(LinkGraph, cargo,            SLE_UINT8),
+		 SLE_CONDVAR(LinkGraph, nodes_changed,  SLE_BOOL,   SLV_LINKGRAPH_RECALC_CHANGE, SL_MAX_VERSION),
+		 SLE_CONDVAR(LinkGraph, last_job_edges, SLE_UINT32, SLV_LINKGRAPH_RECALC_CHANGE, SL_MAX_VERSION),
 		 SLE_END()
 	};
 	return link_graph_desc;
@@ -114,6 +117,8 @@ static const SaveLoad _node_desc[] = {
 	    SLE_VAR(Node, demand,      SLE_UINT32),
 	    SLE_VAR(Node, station,     SLE_UINT16),
 	    SLE_VAR(Node, last_update, SLE_INT32),
+	SLE_CONDVAR(Node, last_job_supply, SLE_UINT32, SLV_LINKGRAPH_RECALC_CHANGE, SL_MAX_VERSION),
+	SLE_CONDVAR(Node, last_job_demand, SLE_UINT32, SLV_LINKGRAPH_RECALC_CHANGE, SL_MAX_VERSION),
 	    SLE_END()
 };
 
@@ -126,29 +131,62 @@ static const SaveLoad _edge_desc[] = {
 	     SLE_VAR(Edge, usage,                    SLE_UINT32),
 	     SLE_VAR(Edge, last_unrestricted_update, SLE_INT32),
 	 SLE_CONDVAR(Edge, last_restricted_update,   SLE_INT32, SLV_187, SL_MAX_VERSION),
-	     SLE_VAR(Edge, next_edge,                SLE_UINT16),
+	    SLEG_VAR(_next_edge,                     SLE_UINT16),
+	 SLE_CONDVAR(Edge, last_job_capacity,        SLE_UINT32, SLV_LINKGRAPH_RECALC_CHANGE, SL_MAX_VERSION),
 	     SLE_END()
 };
 
 /**
- * Save/load a link graph.
- * @param lg Link graph to be saved or loaded.
+ * Save the nodes and edges of a link graph. The edges of each node are saved
+ * as a list, starting with an empty edge from the node to itself. Each entry
+ * holds the destination of the next one.
+ * @param lg Link graph to be saved.
  */
-void SaveLoad_LinkGraph(LinkGraph &lg)
+void Save_LinkGraph(LinkGraph &lg)
 {
 	uint size = lg.Size();
 	for (NodeID from = 0; from < size; ++from) {
-		Node *node = &lg.nodes[from];
-		SlObject(node, _node_desc);
+		SlObject(&lg.nodes[from], _node_desc);
+
+		const LinkGraph::EdgeMap &edges = lg.edges[from];
+		LinkGraph::EdgeMap::const_iterator it = edges.begin();
+		_next_edge = (it != edges.end()) ? it->first : INVALID_NODE;
+		SlObject(const_cast<Edge *>(&LinkGraph::empty_edge), _edge_desc);
+		while (it != edges.end()) {
+			const Edge *edge = &it->second;
+			++it;
+			_next_edge = (it != edges.end()) ? it->first : INVALID_NODE;
+			SlObject(const_cast<Edge *>(edge), _edge_desc);
+		}
+	}
+}
+
+/**
+ * Load the nodes and edges of a link graph.
+ * @param lg Link graph to be loaded. It has to be initialized to the right size already.
+ */
+void Load_LinkGraph(LinkGraph &lg)
+{
+	uint size = lg.Size();
+	for (NodeID from = 0; from < size; ++from) {
+		SlObject(&lg.nodes[from], _node_desc);
+		LinkGraph::EdgeMap &edges = lg.edges[from];
+		Edge edge;
 		if (IsSavegameVersionBefore(SLV_191)) {
 			/* We used to save the full matrix ... */
 			for (NodeID to = 0; to < size; ++to) {
-				SlObject(&lg.edges[from][to], _edge_desc);
+				edge.Init();
+				SlObject(&edge, _edge_desc);
+				if (to != from && edge.capacity > 0) edges[to] = edge;
 			}
 		} else {
-			/* ... but as that wasted a lot of space we save a sparse matrix now. */
-			for (NodeID to = from; to != INVALID_NODE; to = lg.edges[from][to].next_edge) {
-				SlObject(&lg.edges[from][to], _edge_desc);
+			/* ... but as that wasted a lot of space we save a sparse list now. */
+			edge.Init();
+			SlObject(&edge, _edge_desc);
+			for (NodeID to = _next_edge; to != INVALID_NODE; to = _next_edge) {
+				edge.Init();
+				SlObject(&edge, _edge_desc);
+				edges[to] = edge;
 			}
 		}
 	}
@@ -163,7 +201,7 @@ static void DoSave_LGRJ(LinkGraphJob *lgj)
 	SlObject(lgj, GetLinkGraphJobDesc());
 	_num_nodes = lgj->Size();
 	SlObject(const_cast<LinkGraph *>(&lgj->Graph()), GetLinkGraphDesc());
-	SaveLoad_LinkGraph(const_cast<LinkGraph &>(lgj->Graph()));
+	Save_LinkGraph(const_cast<LinkGraph &>(lgj->Graph()));
 }
 
 /**
@@ -174,7 +212,7 @@ static void DoSave_LGRP(LinkGraph *lg)
 {
 	_num_nodes = lg->Size();
 	SlObject(lg, GetLinkGraphDesc());
-	SaveLoad_LinkGraph(*lg);
+	Save_LinkGraph(*lg);
 }
 
 /**
@@ -191,7 +229,7 @@ static void Load_LGRP()
 		LinkGraph *lg = new (index) LinkGraph();
 		SlObject(lg, GetLinkGraphDesc());
 		lg->Init(_num_nodes);
-		SaveLoad_LinkGraph(*lg);
+		Load_LinkGraph(*lg);
 	}
 }
 
@@ -211,7 +249,7 @@ static void Load_LGRJ()
 		LinkGraph &lg = const_cast<LinkGraph &>(lgj->Graph());
 		SlObject(&lg, GetLinkGraphDesc());
 		lg.Init(_num_nodes);
-		SaveLoad_LinkGraph(lg);
+		Load_LinkGraph(lg);
 	}
 }
 
@@ -28,6 +28,7 @@
 #include "../engine_func.h"
 #include "../company_base.h"
 #include "../disaster_vehicle.h"
+#include "../animated_tile_func.h"
 #include "../core/smallvec_type.hpp"
 #include "saveload_internal.h"
 #include "oldloader.h"
@@ -48,7 +49,7 @@ void FixOldMapArray()
 {
 	/* TTO/TTD/TTDP savegames could have buoys at tile 0
 	 * (without assigned station struct) */
-	MemSetT(&_m[0], 0);
+	ResetMapTiles(0, 1, false);
 	SetTileType(0, MP_WATER);
 	SetTileOwner(0, OWNER_WATER);
 }
@@ -653,6 +654,7 @@ static bool LoadOldAnimTileList(LoadgameState *ls, int num)
 		if (anim_list[i] == 0) break;
 		*_animated_tiles.Append() = anim_list[i];
 	}
+	RebuildAnimatedTileIndex();
 
 	return true;
 }
@@ -1473,8 +1475,7 @@ static bool LoadOldGameDifficulty(LoadgameState *ls, int num)
 static bool LoadOldMapPart1(LoadgameState *ls, int num)
 {
 	if (_savegame_type == SGT_TTO) {
-		MemSetT(_m, 0, OLD_MAP_SIZE);
-		MemSetT(_me, 0, OLD_MAP_SIZE);
+		ResetMapTiles(0, OLD_MAP_SIZE, true);
 	}
 
 	for (uint i = 0; i < OLD_MAP_SIZE; i++) {
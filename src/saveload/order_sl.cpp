@@ -107,7 +107,7 @@ const SaveLoad *GetOrderDescription()
 		     SLE_VAR(Order, type,           SLE_UINT8),
 		     SLE_VAR(Order, flags,          SLE_UINT8),
 		     SLE_VAR(Order, dest,           SLE_UINT16),
-		     SLE_REF(Order, next,           REF_ORDER),
+		 SLE_CONDREF(Order, next,           REF_ORDER,   SL_MIN_VERSION, SLV_PACKED_ORDERS),
 		 SLE_CONDVAR(Order, refit_cargo,    SLE_UINT8,   SLV_36, SL_MAX_VERSION),
 		SLE_CONDNULL(1,                                  SLV_36, SLV_182), // refit_subtype
 		 SLE_CONDVAR(Order, wait_time,      SLE_UINT16,  SLV_67, SL_MAX_VERSION),
@@ -123,14 +123,42 @@ const SaveLoad *GetOrderDescription()
 	return _order_desc;
 }
 
-static void Save_ORDR()
+/**
+ * Save all order chains, i.e. the orders of the order lists and order backups.
+ * Every chain is saved as its number of orders followed by the index and data
+ * of each of its orders, in the order they are linked. A chain length of 0
+ * terminates the chunk.
+ */
+static void SaveReal_ORDR(void *)
 {
+	/* Chains start at the orders that are not the next order of any other order. */
+	std::vector<bool> is_next(Order::GetPoolSize(), false);
 	Order *order;
+	FOR_ALL_ORDERS(order) {
+		if (order->next != NULL) is_next[order->next->index] = true;
+	}
 
 	FOR_ALL_ORDERS(order) {
-		SlSetArrayIndex(order->index);
-		SlObject(order, GetOrderDescription());
+		if (is_next[order->index]) continue;
+
+		uint32 count = 0;
+		for (const Order *o = order; o != NULL; o = o->next) count++;
+		SlArray(&count, 1, SLE_UINT32);
+
+		for (Order *o = order; o != NULL; o = o->next) {
+			uint32 index = o->index;
+			SlArray(&index, 1, SLE_UINT32);
+			SlObject(o, GetOrderDescription());
+		}
 	}
+
+	uint32 end = 0;
+	SlArray(&end, 1, SLE_UINT32);
+}
+
+static void Save_ORDR()
+{
+	SlAutolength(SaveReal_ORDR, NULL);
 }
 
 static void Load_ORDR()
@@ -180,6 +208,24 @@ static void Load_ORDR()
 			Order *prev = Order::GetIfValid(order_index - 1);
 			if (prev != NULL) prev->next = o;
 		}
+	} else if (!IsSavegameVersionBefore(SLV_PACKED_ORDERS)) {
+		for (;;) {
+			uint32 count;
+			SlArray(&count, 1, SLE_UINT32);
+			if (count == 0) break;
+
+			Order *prev = NULL;
+			for (uint32 i = 0; i < count; i++) {
+				uint32 index;
+				SlArray(&index, 1, SLE_UINT32);
+				if (index >= OrderPool::MAX_SIZE || Order::IsValidID(index)) SlErrorCorrupt("Invalid order index");
+
+				Order *order = new (index) Order();
+				SlObject(order, GetOrderDescription());
+				if (prev != NULL) prev->next = order;
+				prev = order;
+			}
+		}
 	} else {
 		int index;
 
@@ -198,6 +244,8 @@ static void Ptrs_ORDR()
 {
 	/* Orders from old savegames have pointers corrected in Load_ORDR */
 	if (IsSavegameVersionBefore(SLV_5, 2)) return;
+	/* Packed order chains are linked in Load_ORDR as well */
+	if (!IsSavegameVersionBefore(SLV_PACKED_ORDERS)) return;
 
 	Order *o;
 
@@ -307,6 +355,6 @@ static void Ptrs_BKOR()
 
 extern const ChunkHandler _order_chunk_handlers[] = {
 	{ 'BKOR', Save_BKOR, Load_BKOR, Ptrs_BKOR, NULL, CH_ARRAY},
-	{ 'ORDR', Save_ORDR, Load_ORDR, Ptrs_ORDR, NULL, CH_ARRAY},
+	{ 'ORDR', Save_ORDR, Load_ORDR, Ptrs_ORDR, NULL, CH_RIFF},
 	{ 'ORDL', Save_ORDL, Load_ORDL, Ptrs_ORDL, NULL, CH_ARRAY | CH_LAST},
 };
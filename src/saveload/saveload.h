@@ -296,6 +296,10 @@ enum SaveLoadVersion : uint16 {
 
 	SLV_SERVE_NEUTRAL_INDUSTRIES,           ///< 210  PR#7234 Company stations can serve industries with attached neutral stations.
 	SLV_ROADVEH_PATH_CACHE,                 ///< 211  PR#7261 Add path cache for road vehicles.
+	SLV_LINKGRAPH_RECALC_CHANGE,            ///< 212  Skip link graph jobs for components that barely changed.
+	SLV_TRAIN_PATH_CACHE,                   ///< 213  Add path cache for trains.
+	SLV_STATION_RATING_CACHE,               ///< 214  Cache the inputs and result of the station rating calculation.
+	SLV_PACKED_ORDERS,                      ///< 215  Save the orders of an order chain one after another instead of linking them by a reference.
 
 	SL_MAX_VERSION,                         ///< Highest possible saveload version
 };
@@ -340,6 +344,7 @@ SaveOrLoadResult SaveOrLoad(const char *filename, SaveLoadOperation fop, Detaile
 void WaitTillSaved();
 void ProcessAsyncSaveFinish();
 void DoExitSave();
+size_t CompressWithSavegameFormat(const char *name, byte *buf, size_t len);
 
 SaveOrLoadResult SaveWithFilter(struct SaveFilter *writer, bool threaded);
 SaveOrLoadResult LoadWithFilter(struct LoadFilter *reader);
@@ -385,6 +390,7 @@ enum ChunkType {
 	CH_TYPE_MASK    =  3,
 	CH_LAST         =  8, ///< Last chunk in this array.
 	CH_AUTO_LENGTH  = 16,
+	CH_PARALLEL_SAVE = 32, ///< The save proc only reads the game state, so the chunk can be saved on a worker thread.
 };
 
 /**
@@ -287,13 +287,19 @@ const SaveLoad *GetGoodsDesc()
 		 SLE_CONDVAR(GoodsEntry, node,                 SLE_UINT16,                SLV_183, SL_MAX_VERSION),
 		SLEG_CONDVAR(            _num_flows,           SLE_UINT32,                SLV_183, SL_MAX_VERSION),
 		 SLE_CONDVAR(GoodsEntry, max_waiting_cargo,    SLE_UINT32,                SLV_183, SL_MAX_VERSION),
+		 SLE_CONDVAR(GoodsEntry, rating_cache_key,     SLE_UINT64,                SLV_STATION_RATING_CACHE, SL_MAX_VERSION),
+		 SLE_CONDVAR(GoodsEntry, rating_cache_value,   SLE_INT16,                 SLV_STATION_RATING_CACHE, SL_MAX_VERSION),
 		SLE_END()
 	};
 
 	return goods_desc;
 }
 
-typedef std::pair<const StationID, std::list<CargoPacket *> > StationCargoPair;
+/**
+ * Packets for one next hop as they are saved. Stations keep them in another
+ * container, so they are copied from and to this one.
+ */
+typedef std::pair<StationID, std::list<CargoPacket *> > StationCargoPair;
 
 static const SaveLoad _cargo_list_desc[] = {
 	SLE_VAR(StationCargoPair, first,  SLE_UINT16),
@@ -311,15 +317,17 @@ static void SwapPackets(GoodsEntry *ge)
 	StationCargoPacketMap &ge_packets = const_cast<StationCargoPacketMap &>(*ge->cargo.Packets());
 
 	if (_packets.empty()) {
-		std::map<StationID, std::list<CargoPacket *> >::iterator it(ge_packets.find(INVALID_STATION));
+		StationCargoPacketMap::MapIterator it(ge_packets.find(INVALID_STATION));
 		if (it == ge_packets.end()) {
 			return;
 		} else {
-			it->second.swap(_packets);
+			_packets.assign(it->second.begin(), it->second.end());
+			it->second.clear();
 		}
 	} else {
 		assert(ge_packets[INVALID_STATION].empty());
-		ge_packets[INVALID_STATION].swap(_packets);
+		ge_packets[INVALID_STATION].assign(_packets.begin(), _packets.end());
+		_packets.clear();
 	}
 }
 
@@ -498,7 +506,8 @@ static void RealSave_STNN(BaseStation *bst)
 				}
 			}
 			for (StationCargoPacketMap::ConstMapIterator it(st->goods[i].cargo.Packets()->begin()); it != st->goods[i].cargo.Packets()->end(); ++it) {
-				SlObject(const_cast<StationCargoPacketMap::value_type *>(&(*it)), _cargo_list_desc);
+				StationCargoPair pair(it->first, std::list<CargoPacket *>(it->second.begin(), it->second.end()));
+				SlObject(&pair, _cargo_list_desc);
 			}
 		}
 	}
@@ -561,8 +570,8 @@ static void Load_STNN()
 					StationCargoPair pair;
 					for (uint j = 0; j < _num_dests; ++j) {
 						SlObject(&pair, _cargo_list_desc);
-						const_cast<StationCargoPacketMap &>(*(st->goods[i].cargo.Packets()))[pair.first].swap(pair.second);
-						assert(pair.second.empty());
+						const_cast<StationCargoPacketMap &>(*(st->goods[i].cargo.Packets()))[pair.first].assign(pair.second.begin(), pair.second.end());
+						pair.second.clear();
 					}
 				}
 			}
@@ -594,8 +603,11 @@ static void Ptrs_STNN()
 				SwapPackets(ge);
 			} else {
 				SlObject(ge, GetGoodsDesc());
-				for (StationCargoPacketMap::ConstMapIterator it = ge->cargo.Packets()->begin(); it != ge->cargo.Packets()->end(); ++it) {
-					SlObject(const_cast<StationCargoPair *>(&(*it)), _cargo_list_desc);
+				StationCargoPacketMap &ge_packets = const_cast<StationCargoPacketMap &>(*ge->cargo.Packets());
+				for (StationCargoPacketMap::MapIterator it = ge_packets.begin(); it != ge_packets.end(); ++it) {
+					StationCargoPair pair(it->first, std::list<CargoPacket *>(it->second.begin(), it->second.end()));
+					SlObject(&pair, _cargo_list_desc);
+					it->second.assign(pair.second.begin(), pair.second.end());
 				}
 			}
 		}
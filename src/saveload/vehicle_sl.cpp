@@ -255,7 +255,10 @@ void AfterLoadVehicles(bool part_of_load)
 		if (v->Next() != NULL) v->Next()->previous = v;
 		if (v->NextShared() != NULL) v->NextShared()->previous_shared = v;
 
-		if (part_of_load) v->fill_percent_te_id = INVALID_TE_ID;
+		if (part_of_load) {
+			v->fill_percent_te_id = INVALID_TE_ID;
+			if (HasBit(v->vehicle_flags, VF_SERVICE_SEARCH_QUEUED)) QueueServiceDepotSearch(v);
+		}
 		v->first = NULL;
 		if (v->IsGroundVehicle()) v->GetGroundVehicleCache()->first_engine = INVALID_ENGINE;
 	}
@@ -745,6 +748,8 @@ const SaveLoad *GetVehicleDescription(VehicleType vt)
 		SLE_CONDNULL(2, SLV_2, SLV_20),
 		 SLE_CONDVAR(Train, gv_flags,            SLE_UINT16,                 SLV_139, SL_MAX_VERSION),
 		SLE_CONDNULL(11, SLV_2, SLV_144), // old reserved space
+		SLE_CONDDEQUE(Train, path.td,            SLE_UINT8,                  SLV_TRAIN_PATH_CACHE, SL_MAX_VERSION),
+		SLE_CONDDEQUE(Train, path.tile,          SLE_UINT32,                 SLV_TRAIN_PATH_CACHE, SL_MAX_VERSION),
 
 		     SLE_END()
 	};
@@ -25,6 +25,8 @@
 #include "window_func.h"
 #include "tile_map.h"
 #include "landscape.h"
+#include "smallmap_gui.h"
+#include "thread/thread_pool.h"
 
 #include "table/strings.h"
 
@@ -32,11 +34,15 @@
 
 static const char * const SCREENSHOT_NAME = "screenshot"; ///< Default filename of a saved screenshot.
 static const char * const HEIGHTMAP_NAME  = "heightmap";  ///< Default filename of a saved heightmap.
+static const char * const WORLD_TILES_NAME = "world_tiles"; ///< Default directory name of a saved tile pyramid.
+static const char * const SMALLMAP_NAME    = "minimap";     ///< Default filename of a saved small map image.
+static const uint WORLD_TILE_SIZE = 256;                    ///< Width and height in pixels of the tiles of a tile pyramid.
 
 char _screenshot_format_name[8];      ///< Extension of the current screenshot format (corresponds with #_cur_screenshot_format).
 uint _num_screenshot_formats;         ///< Number of available screenshot formats.
 uint _cur_screenshot_format;          ///< Index of the currently selected screenshot format in #_screenshot_formats.
 static char _screenshot_name[128];    ///< Filename of the screenshot file.
+static thread_local bool _screenshot_in_background = false; ///< Whether this thread writes a screenshot while the game goes on, so the game state must not be looked at.
 char _full_screenshot_name[MAX_PATH]; ///< Pathname of the screenshot file.
 
 /**
@@ -307,29 +313,32 @@ static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *user
 	text[0].text_length = strlen(_openttd_revision);
 	text[0].compression = PNG_TEXT_COMPRESSION_NONE;
 
+	/* A screenshot written in the background cannot safely look at the game state to describe it. */
 	char buf[8192];
-	char *p = buf;
-	p += seprintf(p, lastof(buf), "Graphics set: %s (%u)\n", BaseGraphics::GetUsedSet()->name, BaseGraphics::GetUsedSet()->version);
-	p = strecpy(p, "NewGRFs:\n", lastof(buf));
-	for (const GRFConfig *c = _game_mode == GM_MENU ? NULL : _grfconfig; c != NULL; c = c->next) {
-		p += seprintf(p, lastof(buf), "%08X ", BSWAP32(c->ident.grfid));
-		p = md5sumToString(p, lastof(buf), c->ident.md5sum);
-		p += seprintf(p, lastof(buf), " %s\n", c->filename);
-	}
-	p = strecpy(p, "\nCompanies:\n", lastof(buf));
-	const Company *c;
-	FOR_ALL_COMPANIES(c) {
-		if (c->ai_info == NULL) {
-			p += seprintf(p, lastof(buf), "%2i: Human\n", (int)c->index);
-		} else {
-			p += seprintf(p, lastof(buf), "%2i: %s (v%d)\n", (int)c->index, c->ai_info->GetName(), c->ai_info->GetVersion());
+	if (!_screenshot_in_background) {
+		char *p = buf;
+		p += seprintf(p, lastof(buf), "Graphics set: %s (%u)\n", BaseGraphics::GetUsedSet()->name, BaseGraphics::GetUsedSet()->version);
+		p = strecpy(p, "NewGRFs:\n", lastof(buf));
+		for (const GRFConfig *c = _game_mode == GM_MENU ? NULL : _grfconfig; c != NULL; c = c->next) {
+			p += seprintf(p, lastof(buf), "%08X ", BSWAP32(c->ident.grfid));
+			p = md5sumToString(p, lastof(buf), c->ident.md5sum);
+			p += seprintf(p, lastof(buf), " %s\n", c->filename);
+		}
+		p = strecpy(p, "\nCompanies:\n", lastof(buf));
+		const Company *c;
+		FOR_ALL_COMPANIES(c) {
+			if (c->ai_info == NULL) {
+				p += seprintf(p, lastof(buf), "%2i: Human\n", (int)c->index);
+			} else {
+				p += seprintf(p, lastof(buf), "%2i: %s (v%d)\n", (int)c->index, c->ai_info->GetName(), c->ai_info->GetVersion());
+			}
 		}
+		text[1].key = const_cast<char *>("Description");
+		text[1].text = buf;
+		text[1].text_length = p - buf;
+		text[1].compression = PNG_TEXT_COMPRESSION_zTXt;
 	}
-	text[1].key = const_cast<char *>("Description");
-	text[1].text = buf;
-	text[1].text_length = p - buf;
-	text[1].compression = PNG_TEXT_COMPRESSION_zTXt;
-	png_set_text(png_ptr, info_ptr, text, 2);
+	png_set_text(png_ptr, info_ptr, text, _screenshot_in_background ? 1 : 2);
 #endif /* PNG_TEXT_SUPPORTED */
 
 	if (pixelformat == 8) {
@@ -761,6 +770,65 @@ static bool MakeLargeWorldScreenshot(ScreenshotType t)
 			BlitterFactory::GetCurrentBlitter()->GetScreenDepth(), _cur_palette.palette);
 }
 
+/**
+ * Make a screenshot of the whole map as a pyramid of square tiles, like web
+ * maps use. Every zoom level from #ZOOM_LVL_MAX to #ZOOM_LVL_WORLD_SCREENSHOT
+ * gets its own level of the pyramid, with the most zoomed out level as level 0.
+ * The tiles are written to "<name>/<level>/<column>/<row>.<extension>" in the
+ * screenshot directory. Every tile is rendered and written on its own, so only
+ * a single tile is ever in memory.
+ * @return true on success
+ */
+static bool MakeWorldTilesScreenshot()
+{
+	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
+	if (StrEmpty(_screenshot_name)) strecpy(_screenshot_name, WORLD_TILES_NAME, lastof(_screenshot_name));
+
+	char path[MAX_PATH];
+	seprintf(path, lastof(path), "%s%s", FiosGetScreenshotDir(), _screenshot_name);
+	FioCreateDirectory(path);
+
+	ViewPort world;
+	SetupScreenshotViewport(SC_WORLD, &world);
+
+	for (int z = ZOOM_LVL_MAX; z >= ZOOM_LVL_WORLD_SCREENSHOT; z--) {
+		ZoomLevel zoom = (ZoomLevel)z;
+		uint level = ZOOM_LVL_MAX - zoom;
+		uint width = UnScaleByZoom(world.virtual_width, zoom);
+		uint height = UnScaleByZoom(world.virtual_height, zoom);
+
+		seprintf(path, lastof(path), "%s%s" PATHSEP "%u", FiosGetScreenshotDir(), _screenshot_name, level);
+		FioCreateDirectory(path);
+
+		for (uint col = 0; col * WORLD_TILE_SIZE < width; col++) {
+			seprintf(path, lastof(path), "%s%s" PATHSEP "%u" PATHSEP "%u", FiosGetScreenshotDir(), _screenshot_name, level, col);
+			FioCreateDirectory(path);
+
+			for (uint row = 0; row * WORLD_TILE_SIZE < height; row++) {
+				ViewPort vp;
+				vp.zoom = zoom;
+				vp.left = 0;
+				vp.top = 0;
+				vp.width = WORLD_TILE_SIZE;
+				vp.height = WORLD_TILE_SIZE;
+				vp.virtual_left = world.virtual_left + ScaleByZoom(col * WORLD_TILE_SIZE, zoom);
+				vp.virtual_top = world.virtual_top + ScaleByZoom(row * WORLD_TILE_SIZE, zoom);
+				vp.virtual_width = ScaleByZoom(WORLD_TILE_SIZE, zoom);
+				vp.virtual_height = ScaleByZoom(WORLD_TILE_SIZE, zoom);
+				vp.overlay = NULL;
+
+				seprintf(path, lastof(path), "%s%s" PATHSEP "%u" PATHSEP "%u" PATHSEP "%u.%s", FiosGetScreenshotDir(), _screenshot_name, level, col, row, sf->extension);
+				if (!sf->proc(path, LargeWorldCallback, &vp, vp.width, vp.height,
+						BlitterFactory::GetCurrentBlitter()->GetScreenDepth(), _cur_palette.palette)) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
 /**
  * Callback for generating a heightmap. Supports 8bpp grayscale only.
  * @param userdata Pointer to user data.
@@ -803,6 +871,114 @@ bool MakeHeightmapScreenshot(const char *filename)
 	return sf->proc(filename, HeightmapCallback, NULL, MapSizeX(), MapSizeY(), 8, palette);
 }
 
+/** A small map screenshot that is written to disk in the background. */
+struct SmallMapScreenshot {
+	char filename[MAX_PATH];  ///< Full path of the file to write.
+	char name[128];           ///< Name of the file for the messages.
+	uint8 *pixels;            ///< Palette index of every pixel.
+	uint width;               ///< Width of the image.
+	uint height;              ///< Height of the image.
+	Colour palette[256];      ///< Palette of the image.
+	bool success;             ///< Whether the file got written.
+	volatile bool finished;   ///< Whether writing has finished.
+};
+
+static SmallMapScreenshot *_smallmap_screenshot = NULL;     ///< Small map screenshot that is being written, if any.
+static ThreadPoolTask *_smallmap_screenshot_task = NULL; ///< Task writing #_smallmap_screenshot, if it runs in the background.
+
+/**
+ * Callback for writing the lines of a small map screenshot.
+ * @see ScreenshotCallback
+ */
+static void SmallMapScreenshotCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+{
+	const SmallMapScreenshot *s = (const SmallMapScreenshot *)userdata;
+	for (uint i = 0; i < n; i++) {
+		MemCpyT((uint8 *)buf + i * pitch, s->pixels + (y + i) * s->width, s->width);
+	}
+}
+
+/**
+ * Write the small map screenshot to disk.
+ * @param data The #SmallMapScreenshot.
+ */
+static void WriteSmallMapScreenshot(void *data)
+{
+	SmallMapScreenshot *s = (SmallMapScreenshot *)data;
+	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
+
+	_screenshot_in_background = true;
+	s->success = sf->proc(s->filename, SmallMapScreenshotCallback, s, s->width, s->height, 8, s->palette);
+	_screenshot_in_background = false;
+	s->finished = true;
+}
+
+/**
+ * Report the outcome of the small map screenshot and clean up after it.
+ * @param wait Whether to wait for the screenshot to be written, or only finish it when it already has been.
+ */
+void FinishSmallMapScreenshot(bool wait)
+{
+	SmallMapScreenshot *s = _smallmap_screenshot;
+	if (s == NULL || (!wait && !s->finished)) return;
+
+	if (_smallmap_screenshot_task != NULL) ThreadPoolWaitTask(_smallmap_screenshot_task);
+	_smallmap_screenshot_task = NULL;
+	_smallmap_screenshot = NULL;
+
+	if (s->success) {
+		SetDParamStr(0, s->name);
+		ShowErrorMessage(STR_MESSAGE_SCREENSHOT_SUCCESSFULLY, INVALID_STRING_ID, WL_WARNING);
+	} else {
+		ShowErrorMessage(STR_ERROR_SCREENSHOT_FAILED, INVALID_STRING_ID, WL_ERROR);
+	}
+
+	free(s->pixels);
+	delete s;
+}
+
+/**
+ * Make a screenshot of the whole map as the small map shows it, one pixel per tile.
+ * The colours are taken from the map right away, but the image is compressed and
+ * written on a worker thread while the game goes on. This needs no video driver,
+ * so dedicated servers can use it too.
+ * @param mode Small map mode to show, see #SmallMapWindow::GetMapImage.
+ * @param name Name of the file, or \c NULL for a generated name.
+ * @return False iff the small map mode is unknown.
+ */
+bool MakeSmallMapScreenshot(const char *mode, const char *name)
+{
+	/* Only one image at a time. */
+	FinishSmallMapScreenshot(true);
+
+	SmallMapScreenshot *s = new SmallMapScreenshot();
+	s->width = MapSizeX();
+	s->height = MapSizeY();
+	s->pixels = MallocT<uint8>(s->width * s->height);
+	if (!SmallMapWindow::GetMapImage(mode, s->pixels)) {
+		free(s->pixels);
+		delete s;
+		return false;
+	}
+
+	_screenshot_name[0] = '\0';
+	if (name != NULL) strecpy(_screenshot_name, name, lastof(_screenshot_name));
+	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
+	strecpy(s->filename, MakeScreenshotName(SMALLMAP_NAME, sf->extension), lastof(s->filename));
+	strecpy(s->name, _screenshot_name, lastof(s->name));
+	MemCpyT(s->palette, _cur_palette.palette, lengthof(s->palette));
+	s->success = false;
+	s->finished = false;
+
+	_smallmap_screenshot = s;
+	_smallmap_screenshot_task = ThreadPoolSubmit(&WriteSmallMapScreenshot, s);
+	if (_smallmap_screenshot_task == NULL) {
+		WriteSmallMapScreenshot(s);
+		FinishSmallMapScreenshot(true);
+	}
+	return true;
+}
+
 /**
  * Make an actual screenshot.
  * @param t    the type of screenshot to make.
@@ -845,6 +1021,10 @@ bool MakeScreenshot(ScreenshotType t, const char *name)
 			break;
 		}
 
+		case SC_WORLD_TILES:
+			ret = MakeWorldTilesScreenshot();
+			break;
+
 		default:
 			NOT_REACHED();
 	}
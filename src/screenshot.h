@@ -24,11 +24,14 @@ enum ScreenshotType {
 	SC_DEFAULTZOOM, ///< Zoomed to default zoom level screenshot of the visible area.
 	SC_WORLD,       ///< World screenshot.
 	SC_HEIGHTMAP,   ///< Heightmap of the world.
+	SC_WORLD_TILES, ///< World screenshot split into a pyramid of tiles for every zoom level.
 };
 
 void SetupScreenshotViewport(ScreenshotType t, struct ViewPort *vp);
 bool MakeHeightmapScreenshot(const char *filename);
 bool MakeScreenshot(ScreenshotType t, const char *name);
+bool MakeSmallMapScreenshot(const char *mode, const char *name);
+void FinishSmallMapScreenshot(bool wait);
 
 extern char _screenshot_format_name[8];
 extern uint _num_screenshot_formats;
@@ -20,10 +20,16 @@
  * This version is not yet released. The following changes are not set in stone yet.
  *
  * API additions:
+ * \li AIAsyncMode
+ * \li AIEventController::IsEventTypeEnabled
+ * \li AIEventController::SetEventTypeEnabled
  * \li AIGroup::SetPrimaryColour
  * \li AIGroup::SetSecondaryColour
  * \li AIGroup::GetPrimaryColour
  * \li AIGroup::GetSecondaryColour
+ * \li AITileList::ValuateBuildable
+ * \li AITileList::ValuateDistanceManhattanToTile
+ * \li AITileList::ValuateOwner
  *
  * \b 1.9.0
  *
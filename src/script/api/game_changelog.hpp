@@ -19,6 +19,14 @@
  *
  * This version is not yet released. The following changes are not set in stone yet.
  *
+ * API additions:
+ * \li GSAsyncMode
+ * \li GSEventController::IsEventTypeEnabled
+ * \li GSEventController::SetEventTypeEnabled
+ * \li GSTileList::ValuateBuildable
+ * \li GSTileList::ValuateDistanceManhattanToTile
+ * \li GSTileList::ValuateOwner
+ *
  * \b 1.9.0
  *
  * API additions:
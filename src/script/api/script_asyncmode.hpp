@@ -0,0 +1,68 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file script_asyncmode.hpp Switch the script instance to Asynchronous Mode. */
+
+#ifndef SCRIPT_ASYNCMODE_HPP
+#define SCRIPT_ASYNCMODE_HPP
+
+#include "script_object.hpp"
+
+/**
+ * Class to switch current mode to Asynchronous Mode.
+ * If you create an instance of this class, the mode will be switched to
+ *   Asynchronous. The original mode is stored and recovered from when ever
+ *   the instance is destroyed.
+ * In Asynchronous mode all the commands you execute are really executed,
+ *   like in Execute mode, but your script does not wait for each command to
+ *   be executed before it continues. This way many commands, like the pieces
+ *   of a long track, can be sent in one go.
+ * The commands are checked before they are sent, so the return value tells
+ *   whether the command can be executed. In multiplayer the command is
+ *   executed later, in the order the commands were sent; a command that
+ *   fails after all because the map changed in the meantime is not reported.
+ *   Any command executed outside of Asynchronous mode only returns after all
+ *   commands sent before it have been executed.
+ * Commands that return something else than success, like the ID of a built
+ *   vehicle, still wait for their result.
+ * @api ai game
+ */
+class ScriptAsyncMode : public ScriptObject {
+friend class ScriptObject;
+private:
+	ScriptModeProc *last_mode;   ///< The previous mode we were in.
+	ScriptObject *last_instance; ///< The previous instance of the mode.
+
+protected:
+	/**
+	 * The callback proc for Asynchronous mode.
+	 */
+	static bool ModeProc();
+
+public:
+	/**
+	 * Creating instance of this class switches the build mode to Asynchronous.
+	 * @note When the instance is destroyed, he restores the mode that was
+	 *   current when the instance was created!
+	 */
+	ScriptAsyncMode();
+
+	/**
+	 * Destroying this instance reset the building mode to the mode it was
+	 *   in when the instance was created.
+	 */
+	~ScriptAsyncMode();
+
+	/**
+	 * @api -all
+	 */
+	virtual void FinalRelease();
+};
+
+#endif /* SCRIPT_ASYNCMODE_HPP */
@@ -10,17 +10,59 @@
 /** @file script_event.cpp Implementation of ScriptEvent. */
 
 #include "../../stdafx.h"
+#include "../../core/bitmath_func.hpp"
 #include "script_event_types.hpp"
 
-#include <queue>
+#include <vector>
 
 #include "../../safeguards.h"
 
-/** The queue of events for a script. */
+/**
+ * The queue of events for a script. The events are kept in a ring buffer
+ * that only grows, so once it is large enough queueing doesn't allocate.
+ */
 struct ScriptEventData {
-	std::queue<ScriptEvent *> stack; ///< The actual queue.
+	std::vector<ScriptEvent *> events; ///< The ring buffer with the queued events.
+	size_t first;                       ///< Position of the oldest event in the buffer.
+	size_t count;                       ///< Number of queued events.
+	uint64 disabled_types;              ///< Bit mask of the ScriptEventTypes that are not queued.
+
+	ScriptEventData() : events(16), first(0), count(0), disabled_types(0) {}
+
+	/**
+	 * Add an event at the end of the queue.
+	 * @param event The event to add.
+	 */
+	void Push(ScriptEvent *event)
+	{
+		if (this->count == this->events.size()) {
+			/* Unwrap the events while doubling the buffer. */
+			std::vector<ScriptEvent *> events(this->events.size() * 2);
+			for (size_t i = 0; i < this->count; i++) events[i] = this->events[(this->first + i) % this->events.size()];
+			this->events.swap(events);
+			this->first = 0;
+		}
+		this->events[(this->first + this->count) % this->events.size()] = event;
+		this->count++;
+	}
+
+	/**
+	 * Take the oldest event from the queue.
+	 * @pre count > 0
+	 * @return The event.
+	 */
+	ScriptEvent *Pop()
+	{
+		assert(this->count > 0);
+		ScriptEvent *event = this->events[this->first];
+		this->first = (this->first + 1) % this->events.size();
+		this->count--;
+		return event;
+	}
 };
 
+assert_compile(ScriptEvent::ET_ROAD_RECONSTRUCTION < 64);
+
 /* static */ void ScriptEventController::CreateEventPointer()
 {
 	assert(ScriptObject::GetEventPointer() == NULL);
@@ -33,11 +75,7 @@ struct ScriptEventData {
 	ScriptEventData *data = (ScriptEventData *)ScriptObject::GetEventPointer();
 
 	/* Free all waiting events (if any) */
-	while (!data->stack.empty()) {
-		ScriptEvent *e = data->stack.front();
-		data->stack.pop();
-		e->Release();
-	}
+	while (data->count > 0) data->Pop()->Release();
 
 	/* Now kill our data pointer */
 	delete data;
@@ -48,7 +86,7 @@ struct ScriptEventData {
 	if (ScriptObject::GetEventPointer() == NULL) ScriptEventController::CreateEventPointer();
 	ScriptEventData *data = (ScriptEventData *)ScriptObject::GetEventPointer();
 
-	return !data->stack.empty();
+	return data->count > 0;
 }
 
 /* static */ ScriptEvent *ScriptEventController::GetNextEvent()
@@ -56,11 +94,28 @@ struct ScriptEventData {
 	if (ScriptObject::GetEventPointer() == NULL) ScriptEventController::CreateEventPointer();
 	ScriptEventData *data = (ScriptEventData *)ScriptObject::GetEventPointer();
 
-	if (data->stack.empty()) return NULL;
+	if (data->count == 0) return NULL;
 
-	ScriptEvent *e = data->stack.front();
-	data->stack.pop();
-	return e;
+	return data->Pop();
+}
+
+/* static */ void ScriptEventController::SetEventTypeEnabled(ScriptEvent::ScriptEventType type, bool enabled)
+{
+	if (type <= ScriptEvent::ET_INVALID || type >= 64) return;
+
+	if (ScriptObject::GetEventPointer() == NULL) ScriptEventController::CreateEventPointer();
+	ScriptEventData *data = (ScriptEventData *)ScriptObject::GetEventPointer();
+
+	SB(data->disabled_types, type, 1, enabled ? 0 : 1);
+}
+
+/* static */ bool ScriptEventController::IsEventTypeEnabled(ScriptEvent::ScriptEventType type)
+{
+	if (type <= ScriptEvent::ET_INVALID || type >= 64) return false;
+	if (ScriptObject::GetEventPointer() == NULL) return true;
+	ScriptEventData *data = (ScriptEventData *)ScriptObject::GetEventPointer();
+
+	return !HasBit(data->disabled_types, type);
 }
 
 /* static */ void ScriptEventController::InsertEvent(ScriptEvent *event)
@@ -68,7 +123,9 @@ struct ScriptEventData {
 	if (ScriptObject::GetEventPointer() == NULL) ScriptEventController::CreateEventPointer();
 	ScriptEventData *data = (ScriptEventData *)ScriptObject::GetEventPointer();
 
+	if (HasBit(data->disabled_types, event->GetEventType())) return;
+
 	event->AddRef();
-	data->stack.push(event);
+	data->Push(event);
 }
 
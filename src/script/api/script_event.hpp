@@ -97,6 +97,27 @@ public:
 	 */
 	static ScriptEvent *GetNextEvent();
 
+	/**
+	 * Choose whether events of a type are put in the queue. Events of disabled
+	 *  types are dropped as they happen, so scripts that don't care about e.g.
+	 *  vehicle crashes don't have to read and throw them away. Events that are
+	 *  already waiting are not affected.
+	 * @param type The type of the events.
+	 * @param enabled Whether to queue events of this type.
+	 * @pre type != ScriptEvent::ET_INVALID.
+	 * @note All event types are enabled by default. The setting is not saved, so
+	 *  a script that disables event types has to do so again after loading.
+	 */
+	static void SetEventTypeEnabled(ScriptEvent::ScriptEventType type, bool enabled);
+
+	/**
+	 * Check whether events of a type are put in the queue.
+	 * @param type The type of the events.
+	 * @return True if events of this type are queued.
+	 * @see SetEventTypeEnabled
+	 */
+	static bool IsEventTypeEnabled(ScriptEvent::ScriptEventType type);
+
 	/**
 	 * Insert an event to the queue for the company.
 	 * @param event The event to insert.
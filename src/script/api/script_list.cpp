@@ -439,10 +439,14 @@ void ScriptList::AddItem(int64 item, int64 value)
 {
 	this->modifications++;
 
-	if (this->HasItem(item)) return;
+	/* Lists are mostly filled in ascending order, for which the hints make
+	 * inserting take constant time. */
+	size_t count = this->items.size();
+	this->items.insert(this->items.end(), ScriptListMap::value_type(item, value));
+	if (this->items.size() == count) return;
 
-	this->items[item] = value;
-	this->buckets[value].insert(item);
+	ScriptItemList &bucket = this->buckets[value];
+	bucket.insert(bucket.end(), item);
 }
 
 void ScriptList::RemoveItem(int64 item)
@@ -462,6 +466,27 @@ void ScriptList::RemoveItem(int64 item)
 	this->items.erase(item_iter);
 }
 
+void ScriptList::SetAllValues(int64 (*valuator)(int64 item, void *data), void *data)
+{
+	if (this->initialized) {
+		/* The sorter may be in the middle of an iteration; let it know of every change. */
+		for (ScriptListMap::iterator iter = this->items.begin(); iter != this->items.end(); iter++) {
+			this->SetValue(iter->first, valuator(iter->first, data));
+		}
+		return;
+	}
+
+	this->modifications++;
+
+	/* Rebuild the buckets instead of moving the items between them one by one. */
+	this->buckets.clear();
+	for (ScriptListMap::iterator iter = this->items.begin(); iter != this->items.end(); iter++) {
+		iter->second = valuator(iter->first, data);
+		ScriptItemList &bucket = this->buckets[iter->second];
+		bucket.insert(bucket.end(), iter->first);
+	}
+}
+
 int64 ScriptList::Begin()
 {
 	this->initialized = true;
@@ -23,6 +23,7 @@
 #include "../script_instance.hpp"
 #include "../script_fatalerror.hpp"
 #include "script_error.hpp"
+#include "script_asyncmode.hpp"
 
 #include "../../safeguards.h"
 
@@ -67,6 +68,18 @@ ScriptObject::ActiveInstance::~ActiveInstance()
 	return GetStorage()->delay;
 }
 
+/* static */ bool ScriptObject::IsAsyncMode()
+{
+	return GetDoCommandMode() == &ScriptAsyncMode::ModeProc;
+}
+
+/* static */ bool ScriptObject::TakePendingAsyncCommand()
+{
+	if (GetStorage()->pending_async_commands == 0) return false;
+	GetStorage()->pending_async_commands--;
+	return true;
+}
+
 /* static */ void ScriptObject::SetDoCommandMode(ScriptModeProc *proc, ScriptObject *instance)
 {
 	GetStorage()->mode = proc;
@@ -295,6 +308,10 @@ ScriptObject::ActiveInstance::~ActiveInstance()
 		::str_validate(const_cast<char *>(text), text + strlen(text), SVS_NONE);
 	}
 
+	/* Only commands that merely report success can be pipelined; the others
+	 * need their callback to return e.g. the ID of the built object. */
+	bool async = callback == NULL && IsAsyncMode() && !_generating_world;
+
 	/* Set the default callback to return a true/false result of the DoCommand */
 	if (callback == NULL) callback = &ScriptInstance::DoCommandReturn;
 
@@ -338,11 +355,21 @@ ScriptObject::ActiveInstance::~ActiveInstance()
 		}
 		return true;
 	} else if (_networking) {
+		if (async) {
+			/* Carry on; the result of the test is all the script gets. The
+			 * callback of this command only accounts for its costs. */
+			GetStorage()->pending_async_commands++;
+			return true;
+		}
+
 		/* Suspend the script till the command is really executed. */
 		throw Script_Suspend(-(int)GetDoCommandDelay(), callback);
 	} else {
 		IncreaseDoCommandCosts(res.GetCost());
 
+		/* The command has been executed already, so there is nothing to wait for. */
+		if (async) return true;
+
 		/* Suspend the script player for 1+ ticks, so it simulates multiplayer. This
 		 *  both avoids confusion when a developer launched his script in a
 		 *  multiplayer game, but also gives time for the GUI and human player
@@ -146,6 +146,18 @@ protected:
 	 */
 	static bool GetLastCommandRes();
 
+	/**
+	 * Check whether the current mode is the asynchronous mode.
+	 */
+	static bool IsAsyncMode();
+
+	/**
+	 * Account for the arrival of a result of a command.
+	 * @return True if the result belongs to a command sent in asynchronous mode,
+	 *   i.e. the script is not waiting for it.
+	 */
+	static bool TakePendingAsyncCommand();
+
 	/**
 	 * Get the latest stored new_vehicle_id.
 	 */
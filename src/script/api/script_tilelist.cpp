@@ -12,6 +12,7 @@
 #include "../../stdafx.h"
 #include "script_tilelist.hpp"
 #include "script_industry.hpp"
+#include "script_tile.hpp"
 #include "../../industry.h"
 #include "../../station_base.h"
 
@@ -49,6 +50,41 @@ void ScriptTileList::RemoveTile(TileIndex tile)
 	this->RemoveItem(tile);
 }
 
+/** Valuator for ScriptTileList::ValuateBuildable. */
+static int64 TileBuildableValuator(int64 item, void *data)
+{
+	return ScriptTile::IsBuildable((TileIndex)item) ? 1 : 0;
+}
+
+void ScriptTileList::ValuateBuildable()
+{
+	this->SetAllValues(&TileBuildableValuator, NULL);
+}
+
+/** Valuator for ScriptTileList::ValuateDistanceManhattanToTile. */
+static int64 TileDistanceManhattanValuator(int64 item, void *data)
+{
+	return ScriptTile::GetDistanceManhattanToTile((TileIndex)item, *(TileIndex *)data);
+}
+
+void ScriptTileList::ValuateDistanceManhattanToTile(TileIndex tile)
+{
+	if (!::IsValidTile(tile)) return;
+
+	this->SetAllValues(&TileDistanceManhattanValuator, &tile);
+}
+
+/** Valuator for ScriptTileList::ValuateOwner. */
+static int64 TileOwnerValuator(int64 item, void *data)
+{
+	return ScriptTile::GetOwner((TileIndex)item);
+}
+
+void ScriptTileList::ValuateOwner()
+{
+	this->SetAllValues(&TileOwnerValuator, NULL);
+}
+
 ScriptTileList_IndustryAccepting::ScriptTileList_IndustryAccepting(IndustryID industry_id, int radius)
 {
 	if (!ScriptIndustry::IsValidIndustry(industry_id) || radius <= 0) return;
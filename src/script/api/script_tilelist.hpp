@@ -53,6 +53,29 @@ public:
 	 * @pre ScriptMap::IsValidTile(tile).
 	 */
 	void RemoveTile(TileIndex tile);
+
+	/**
+	 * Give all tiles the value 1 if they are buildable, and 0 otherwise.
+	 * This does the same as Valuate(ScriptTile.IsBuildable), but a lot quicker.
+	 * @note You may not use this while valuating.
+	 */
+	void ValuateBuildable();
+
+	/**
+	 * Give all tiles their Manhattan distance to a tile as value.
+	 * This does the same as Valuate(ScriptTile.GetDistanceManhattanToTile, tile), but a lot quicker.
+	 * @param tile The tile to get the distances to.
+	 * @pre ScriptMap::IsValidTile(tile).
+	 * @note You may not use this while valuating.
+	 */
+	void ValuateDistanceManhattanToTile(TileIndex tile);
+
+	/**
+	 * Give all tiles their owner as value.
+	 * This does the same as Valuate(ScriptTile.GetOwner), but a lot quicker.
+	 * @note You may not use this while valuating.
+	 */
+	void ValuateOwner();
 };
 
 /**
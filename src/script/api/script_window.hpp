@@ -1301,6 +1301,10 @@ public:
 		WID_FRW_RATE_GAMELOOP                        = ::WID_FRW_RATE_GAMELOOP,
 		WID_FRW_RATE_DRAWING                         = ::WID_FRW_RATE_DRAWING,
 		WID_FRW_RATE_FACTOR                          = ::WID_FRW_RATE_FACTOR,
+		WID_FRW_RATE_PF_CACHE                        = ::WID_FRW_RATE_PF_CACHE,
+		WID_FRW_INVALIDATIONS                        = ::WID_FRW_INVALIDATIONS,
+		WID_FRW_LINE_CACHE                           = ::WID_FRW_LINE_CACHE,
+		WID_FRW_VIEWPORT_SPRITES                     = ::WID_FRW_VIEWPORT_SPRITES,
 		WID_FRW_INFO_DATA_POINTS                     = ::WID_FRW_INFO_DATA_POINTS,
 		WID_FRW_TIMES_NAMES                          = ::WID_FRW_TIMES_NAMES,
 		WID_FRW_TIMES_CURRENT                        = ::WID_FRW_TIMES_CURRENT,
@@ -58,9 +58,11 @@ ScriptInstance::ScriptInstance(const char *APIName) :
 	is_started(false),
 	is_dead(false),
 	is_save_data_on_stack(false),
+	is_save_data_cached(false),
 	suspend(0),
 	is_paused(false),
-	callback(NULL)
+	callback(NULL),
+	backlog(0)
 {
 	this->storage = new ScriptStorage();
 	this->engine  = new Squirrel(APIName);
@@ -163,6 +165,7 @@ void ScriptInstance::GameLoop()
 {
 	ScriptObject::ActiveInstance active(this);
 
+	this->backlog = 0;
 	if (this->IsDead()) return;
 	if (this->engine->HasScriptCrashed()) {
 		/* The script crashed during saving, kill it here. */
@@ -177,6 +180,8 @@ void ScriptInstance::GameLoop()
 	if (--this->suspend > 0)  return;          // Singleplayer suspend, decrease to 0.
 
 	_current_company = ScriptObject::GetCompany();
+	/* Running the script may change its data, so it has to be saved anew. */
+	this->is_save_data_cached = false;
 
 	/* If there is a callback to call, call that first */
 	if (this->callback != NULL) {
@@ -234,6 +239,11 @@ void ScriptInstance::GameLoop()
 		this->is_save_data_on_stack = false;
 	}
 
+	this->ResumeVM();
+}
+
+void ScriptInstance::ResumeVM()
+{
 	/* Continue the VM */
 	try {
 		if (!this->engine->Resume(_settings_game.script.script_max_opcode_till_suspend)) this->Died();
@@ -246,6 +256,20 @@ void ScriptInstance::GameLoop()
 		this->engine->ResumeError();
 		this->Died();
 	}
+
+	/* Still suspended without waiting for anything means the opcodes ran out. */
+	bool out_of_opcodes = !this->is_dead && !this->is_paused && this->suspend == 0 && this->callback == NULL && this->engine->IsSuspended();
+	this->backlog = out_of_opcodes ? this->backlog + 1 : 0;
+}
+
+void ScriptInstance::RunExtraOpcodes()
+{
+	if (this->backlog == 0) return;
+
+	ScriptObject::ActiveInstance active(this);
+	_current_company = ScriptObject::GetCompany();
+	this->is_save_data_cached = false;
+	this->ResumeVM();
 }
 
 void ScriptInstance::CollectGarbage() const
@@ -340,7 +364,21 @@ static const SaveLoad _script_byte[] = {
 	SLE_END()
 };
 
-/* static */ bool ScriptInstance::SaveObject(HSQUIRRELVM vm, SQInteger index, int max_depth, bool test)
+/**
+ * Append an integer to encoded save data, in the same byte order SLE_INT32 uses.
+ * @param data The save data to append to.
+ * @param value The value to append.
+ */
+static void AppendSaveInt32(std::vector<byte> &data, int32 value)
+{
+	uint32 v = (uint32)value;
+	data.push_back(GB(v, 24, 8));
+	data.push_back(GB(v, 16, 8));
+	data.push_back(GB(v, 8, 8));
+	data.push_back(GB(v, 0, 8));
+}
+
+/* static */ bool ScriptInstance::SaveObject(HSQUIRRELVM vm, SQInteger index, int max_depth, std::vector<byte> &data)
 {
 	if (max_depth == 0) {
 		ScriptLog::Error("Savedata can only be nested to 25 deep. No data saved."); // SQUIRREL_MAX_DEPTH = 25
@@ -349,24 +387,14 @@ static const SaveLoad _script_byte[] = {
 
 	switch (sq_gettype(vm, index)) {
 		case OT_INTEGER: {
-			if (!test) {
-				_script_sl_byte = SQSL_INT;
-				SlObject(NULL, _script_byte);
-			}
+			data.push_back(SQSL_INT);
 			SQInteger res;
 			sq_getinteger(vm, index, &res);
-			if (!test) {
-				int value = (int)res;
-				SlArray(&value, 1, SLE_INT32);
-			}
+			AppendSaveInt32(data, (int32)res);
 			return true;
 		}
 
 		case OT_STRING: {
-			if (!test) {
-				_script_sl_byte = SQSL_STRING;
-				SlObject(NULL, _script_byte);
-			}
 			const SQChar *buf;
 			sq_getstring(vm, index, &buf);
 			size_t len = strlen(buf) + 1;
@@ -374,23 +402,18 @@ static const SaveLoad _script_byte[] = {
 				ScriptLog::Error("Maximum string length is 254 chars. No data saved.");
 				return false;
 			}
-			if (!test) {
-				_script_sl_byte = (byte)len;
-				SlObject(NULL, _script_byte);
-				SlArray(const_cast<char *>(buf), len, SLE_CHAR);
-			}
+			data.push_back(SQSL_STRING);
+			data.push_back((byte)len);
+			data.insert(data.end(), (const byte *)buf, (const byte *)buf + len);
 			return true;
 		}
 
 		case OT_ARRAY: {
-			if (!test) {
-				_script_sl_byte = SQSL_ARRAY;
-				SlObject(NULL, _script_byte);
-			}
+			data.push_back(SQSL_ARRAY);
 			sq_pushnull(vm);
 			while (SQ_SUCCEEDED(sq_next(vm, index - 1))) {
 				/* Store the value */
-				bool res = SaveObject(vm, -1, max_depth - 1, test);
+				bool res = SaveObject(vm, -1, max_depth - 1, data);
 				sq_pop(vm, 2);
 				if (!res) {
 					sq_pop(vm, 1);
@@ -398,22 +421,16 @@ static const SaveLoad _script_byte[] = {
 				}
 			}
 			sq_pop(vm, 1);
-			if (!test) {
-				_script_sl_byte = SQSL_ARRAY_TABLE_END;
-				SlObject(NULL, _script_byte);
-			}
+			data.push_back(SQSL_ARRAY_TABLE_END);
 			return true;
 		}
 
 		case OT_TABLE: {
-			if (!test) {
-				_script_sl_byte = SQSL_TABLE;
-				SlObject(NULL, _script_byte);
-			}
+			data.push_back(SQSL_TABLE);
 			sq_pushnull(vm);
 			while (SQ_SUCCEEDED(sq_next(vm, index - 1))) {
 				/* Store the key + value */
-				bool res = SaveObject(vm, -2, max_depth - 1, test) && SaveObject(vm, -1, max_depth - 1, test);
+				bool res = SaveObject(vm, -2, max_depth - 1, data) && SaveObject(vm, -1, max_depth - 1, data);
 				sq_pop(vm, 2);
 				if (!res) {
 					sq_pop(vm, 1);
@@ -421,32 +438,20 @@ static const SaveLoad _script_byte[] = {
 				}
 			}
 			sq_pop(vm, 1);
-			if (!test) {
-				_script_sl_byte = SQSL_ARRAY_TABLE_END;
-				SlObject(NULL, _script_byte);
-			}
+			data.push_back(SQSL_ARRAY_TABLE_END);
 			return true;
 		}
 
 		case OT_BOOL: {
-			if (!test) {
-				_script_sl_byte = SQSL_BOOL;
-				SlObject(NULL, _script_byte);
-			}
+			data.push_back(SQSL_BOOL);
 			SQBool res;
 			sq_getbool(vm, index, &res);
-			if (!test) {
-				_script_sl_byte = res ? 1 : 0;
-				SlObject(NULL, _script_byte);
-			}
+			data.push_back(res ? 1 : 0);
 			return true;
 		}
 
 		case OT_NULL: {
-			if (!test) {
-				_script_sl_byte = SQSL_NULL;
-				SlObject(NULL, _script_byte);
-			}
+			data.push_back(SQSL_NULL);
 			return true;
 		}
 
@@ -462,6 +467,23 @@ static const SaveLoad _script_byte[] = {
 	SlObject(NULL, _script_byte);
 }
 
+bool ScriptInstance::EncodeSaveData()
+{
+	this->save_data.clear();
+	this->is_save_data_cached = SaveObject(this->engine->GetVM(), -1, SQUIRREL_MAX_DEPTH, this->save_data);
+	if (!this->is_save_data_cached) this->save_data.clear();
+	return this->is_save_data_cached;
+}
+
+void ScriptInstance::SaveEncodedData()
+{
+	assert(this->is_save_data_cached && !this->save_data.empty());
+
+	_script_sl_byte = 1;
+	SlObject(NULL, _script_byte);
+	SlArray(this->save_data.data(), this->save_data.size(), SLE_UINT8);
+}
+
 void ScriptInstance::Save()
 {
 	ScriptObject::ActiveInstance active(this);
@@ -472,12 +494,20 @@ void ScriptInstance::Save()
 		return;
 	}
 
+	/* The script did not run since it was saved last, so its data did not change either. */
+	if (this->is_save_data_cached) {
+		this->SaveEncodedData();
+		return;
+	}
+
 	HSQUIRRELVM vm = this->engine->GetVM();
 	if (this->is_save_data_on_stack) {
-		_script_sl_byte = 1;
-		SlObject(NULL, _script_byte);
 		/* Save the data that was just loaded. */
-		SaveObject(vm, -1, SQUIRREL_MAX_DEPTH, false);
+		if (this->EncodeSaveData()) {
+			this->SaveEncodedData();
+		} else {
+			SaveEmpty();
+		}
 	} else if (!this->is_started) {
 		SaveEmpty();
 		return;
@@ -516,10 +546,8 @@ void ScriptInstance::Save()
 			return;
 		}
 		sq_pushobject(vm, savedata);
-		if (SaveObject(vm, -1, SQUIRREL_MAX_DEPTH, true)) {
-			_script_sl_byte = 1;
-			SlObject(NULL, _script_byte);
-			SaveObject(vm, -1, SQUIRREL_MAX_DEPTH, false);
+		if (this->EncodeSaveData()) {
+			this->SaveEncodedData();
 			this->is_save_data_on_stack = true;
 		} else {
 			SaveEmpty();
@@ -678,10 +706,18 @@ SQInteger ScriptInstance::GetOpsTillSuspend()
 	return this->engine->GetOpsTillSuspend();
 }
 
-void ScriptInstance::DoCommandCallback(const CommandCost &result, TileIndex tile, uint32 p1, uint32 p2)
+bool ScriptInstance::DoCommandCallback(const CommandCost &result, TileIndex tile, uint32 p1, uint32 p2)
 {
 	ScriptObject::ActiveInstance active(this);
 
+	/* Commands are executed in the order they were sent, so the results of
+	 * the commands sent in asynchronous mode arrive before the result of any
+	 * later command the script might be waiting for. */
+	if (ScriptObject::TakePendingAsyncCommand()) {
+		if (result.Succeeded()) ScriptObject::IncreaseDoCommandCosts(result.GetCost());
+		return false;
+	}
+
 	ScriptObject::SetLastCommandRes(result.Succeeded());
 
 	if (result.Failed()) {
@@ -690,6 +726,8 @@ void ScriptInstance::DoCommandCallback(const CommandCost &result, TileIndex tile
 		ScriptObject::IncreaseDoCommandCosts(result.GetCost());
 		ScriptObject::SetLastCost(result.GetCost());
 	}
+
+	return true;
 }
 
 void ScriptInstance::InsertEvent(class ScriptEvent *event)
@@ -12,6 +12,7 @@
 #ifndef SCRIPT_INSTANCE_HPP
 #define SCRIPT_INSTANCE_HPP
 
+#include <vector>
 #include <squirrel.h>
 #include "script_suspend.hpp"
 
@@ -67,6 +68,20 @@ public:
 	 */
 	void GameLoop();
 
+	/**
+	 * Let a script that ran out of opcodes in its last turn continue with
+	 * another turn's worth of opcodes, without it counting as a tick.
+	 * Does nothing when the script has no backlog.
+	 * @see GetBacklog
+	 */
+	void RunExtraOpcodes();
+
+	/**
+	 * Get the number of successive turns the script ran out of opcodes in.
+	 * @return The number of turns; 0 if the script is waiting for something, like its DoCommand or Sleep.
+	 */
+	inline uint GetBacklog() const { return this->backlog; }
+
 	/**
 	 * Let the VM collect any garbage.
 	 */
@@ -182,8 +197,9 @@ public:
 	 * @param tile The tile on which the command was executed.
 	 * @param p1 p1 as given to DoCommandPInternal.
 	 * @param p2 p2 as given to DoCommandPInternal.
+	 * @return True if the script was waiting for this result and has to be continued.
 	 */
-	void DoCommandCallback(const CommandCost &result, TileIndex tile, uint32 p1, uint32 p2);
+	bool DoCommandCallback(const CommandCost &result, TileIndex tile, uint32 p1, uint32 p2);
 
 	/**
 	 * Insert an event for this script.
@@ -238,9 +254,17 @@ private:
 	bool is_started;                      ///< Is the scripts constructor executed?
 	bool is_dead;                         ///< True if the script has been stopped.
 	bool is_save_data_on_stack;           ///< Is the save data still on the squirrel stack?
+	bool is_save_data_cached;             ///< Does #save_data still hold the data the script would save?
+	std::vector<byte> save_data;          ///< The encoded data of the last save of the script.
 	int suspend;                          ///< The amount of ticks to suspend this script before it's allowed to continue.
 	bool is_paused;                       ///< Is the script paused? (a paused script will not be executed until unpaused)
 	Script_SuspendCallbackProc *callback; ///< Callback that should be called in the next tick the script runs.
+	uint backlog;                         ///< Number of successive turns the script ran out of opcodes in.
+
+	/**
+	 * Continue running the VM of a started script for a turn's worth of opcodes.
+	 */
+	void ResumeVM();
 
 	/**
 	 * Call the script Load function if it exists and data was loaded
@@ -249,16 +273,26 @@ private:
 	bool CallLoad();
 
 	/**
-	 * Save one object (int / string / array / table) to the savegame.
+	 * Encode the object on top of the stack as the save data of the script.
+	 * @return True if the encoding was successful.
+	 */
+	bool EncodeSaveData();
+
+	/**
+	 * Write the encoded save data of the script to the savegame in one go.
+	 */
+	void SaveEncodedData();
+
+	/**
+	 * Encode one object (int / string / array / table) in the savegame format.
 	 * @param vm The virtual machine to get all the data from.
 	 * @param index The index on the squirrel stack of the element to save.
 	 * @param max_depth The maximum depth recursive arrays / tables will be stored
 	 *   with before an error is returned.
-	 * @param test If true, don't really store the data but only check if it is
-	 *   valid.
+	 * @param data The encoded data to append the object to.
 	 * @return True if the saving was successful.
 	 */
-	static bool SaveObject(HSQUIRRELVM vm, SQInteger index, int max_depth, bool test);
+	static bool SaveObject(HSQUIRRELVM vm, SQInteger index, int max_depth, std::vector<byte> &data);
 
 	/**
 	 * Load all objects from a savegame.
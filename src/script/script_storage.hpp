@@ -40,6 +40,7 @@ private:
 
 	uint delay;                      ///< The ticks of delay each DoCommand has.
 	bool allow_do_command;           ///< Is the usage of DoCommands restricted?
+	uint pending_async_commands;     ///< Commands sent in asynchronous mode whose result did not arrive yet.
 
 	CommandCost costs;               ///< The costs the script is tracking.
 	Money last_cost;                 ///< The last cost of the command.
@@ -69,6 +70,7 @@ public:
 		company           (INVALID_OWNER),
 		delay             (1),
 		allow_do_command  (true),
+		pending_async_commands(0),
 		/* costs (can't be set) */
 		last_cost         (0),
 		last_error        (STR_NULL),
@@ -578,6 +578,12 @@ void Squirrel::InsertResult(int result)
 	}
 }
 
+/* static */ size_t Squirrel::GetAllocatedMemory()
+{
+	extern size_t _sq_vm_allocated;
+	return _sq_vm_allocated;
+}
+
 /* static */ void Squirrel::DecreaseOps(HSQUIRRELVM vm, int ops)
 {
 	vm->DecreaseOps(ops);
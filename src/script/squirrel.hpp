@@ -242,6 +242,11 @@ public:
 	 */
 	static void DecreaseOps(HSQUIRRELVM vm, int amount);
 
+	/**
+	 * Get the number of bytes allocated by all Squirrel VMs together.
+	 */
+	static size_t GetAllocatedMemory();
+
 	/**
 	 * Did the squirrel code suspend or return normally.
 	 * @return True if the function suspended.
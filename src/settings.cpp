@@ -61,9 +61,11 @@
 #include "game/game.hpp"
 #include "ship.h"
 #include "smallmap_gui.h"
+#include "engine_gui.h"
 #include "roadveh.h"
 #include "fios.h"
 #include "strings_func.h"
+#include "thread/thread_pool.h"
 
 #include "void_map.h"
 #include "station_base.h"
@@ -811,6 +813,8 @@ static bool PopulationInLabelActive(int32 p1)
 
 static bool RedrawScreen(int32 p1)
 {
+	/* Units and currency may have changed. */
+	ClearStringCache();
 	MarkWholeScreenDirty();
 	return true;
 }
@@ -874,6 +878,7 @@ static bool UpdateConsists(int32 p1)
 		/* Update the consist of all trains so the maximum speed is set correctly. */
 		if (t->IsFrontEngine() || t->IsFreeWagon()) t->ConsistChanged(CCF_TRACK);
 	}
+	InvalidateEngineSortValues();
 	InvalidateWindowClassesData(WC_BUILD_VEHICLE, 0);
 	return true;
 }
@@ -1337,6 +1342,7 @@ static bool UpdateServerPassword(int32 p1)
 		_settings_client.network.server_password[0] = '\0';
 	}
 
+	NetworkUDPInvalidateServerInfo();
 	return true;
 }
 
@@ -1353,6 +1359,13 @@ static bool UpdateClientConfigValues(int32 p1)
 {
 	if (_network_server) NetworkServerSendConfigUpdate();
 
+	NetworkUDPInvalidateServerInfo();
+	return true;
+}
+
+static bool UpdateServerInfo(int32 p1)
+{
+	NetworkUDPInvalidateServerInfo();
 	return true;
 }
 
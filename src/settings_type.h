@@ -109,9 +109,13 @@ struct GUISettings {
 	uint8  window_soft_limit;                ///< soft limit of maximum number of non-stickied non-vital windows (0 = no limit)
 	ZoomLevelByte zoom_min;                  ///< minimum zoom out level
 	ZoomLevelByte zoom_max;                  ///< maximum zoom out level
+	uint16 refresh_rate;                     ///< how often do we redraw the screen per second, independent of the game tick rate
 	bool   disable_unsuitable_building;      ///< disable infrastructure building when no suitable vehicles are available
 	byte   autosave;                         ///< how often should we do autosaves?
 	bool   threaded_saves;                   ///< should we do threaded saves?
+	bool   forked_saves;                     ///< should we save games to file in a forked process, where supported?
+	bool   threaded_vehicle_ticks;           ///< should we prepare vehicle ticks on worker threads?
+	bool   sampled_cache_checks;             ///< should the desync cache checks be spread over a day instead of checking everything every tick?
 	bool   keep_all_autosave;                ///< name the autosave in a different way
 	bool   autosave_on_exit;                 ///< save an autosave when you quit the game, but do not ask "Do you really want to quit?"
 	bool   autosave_on_network_disconnect;   ///< save an autosave when you get disconnected from a network game with an error?
@@ -241,6 +245,7 @@ struct NetworkSettings {
 	uint16 sync_freq;                                     ///< how often do we check whether we are still in-sync
 	uint8  frame_freq;                                    ///< how often do we send commands to the clients
 	uint16 commands_per_frame;                            ///< how many commands may be sent each frame_freq frames?
+	bool   command_batching;                              ///< send the commands of a frame to the clients in as few packets as possible
 	uint16 max_commands_in_queue;                         ///< how many commands may there be in the incoming queue before dropping the connection?
 	uint16 bytes_per_frame;                               ///< how many bytes may, over a long period, be received per frame?
 	uint16 bytes_per_frame_burst;                         ///< how many bytes may, over a short period, be received?
@@ -277,6 +282,7 @@ struct NetworkSettings {
 	char   last_host[NETWORK_HOSTNAME_LENGTH];            ///< IP address of the last joined server
 	uint16 last_port;                                     ///< port of the last joined server
 	bool   no_http_content_downloads;                     ///< do not do content downloads over HTTP
+	bool   load_map_while_downloading;                    ///< start loading the map while it is still being downloaded
 #else /* ENABLE_NETWORK */
 #endif
 };
@@ -344,6 +350,7 @@ struct AISettings {
 struct ScriptSettings {
 	uint8  settings_profile;                 ///< difficulty profile to set initial settings of scripts, esp. random AIs
 	uint32 script_max_opcode_till_suspend;   ///< max opcode calls till scripts will suspend
+	uint16 script_extra_time_per_tick;       ///< milliseconds per tick that AIs which ran out of opcodes may continue for; 0 to disable
 };
 
 /** Settings related to the old pathfinder. */
@@ -515,6 +522,7 @@ struct LinkGraphSettings {
 	uint8 demand_size;                          ///< influence of supply ("station size") on the demand function
 	uint8 demand_distance;                      ///< influence of distance between stations on the demand function
 	uint8 short_path_saturation;                ///< percentage up to which short paths are saturated before saturating most capacious paths
+	uint8 recalc_min_change;                    ///< minimum change (in percent) of supplies and capacities of a component before it is recalculated; 0 to always recalculate
 
 	inline DistributionType GetDistributionType(CargoID cargo) const {
 		if (IsCargoInClass(cargo, CC_PASSENGERS)) return this->distribution_pax;
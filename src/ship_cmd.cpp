@@ -17,6 +17,7 @@
 #include "company_func.h"
 #include "pathfinder/npf/npf_func.h"
 #include "depot_base.h"
+#include "depot_kdtree.h"
 #include "station_base.h"
 #include "newgrf_engine.h"
 #include "pathfinder/yapf/yapf.h"
@@ -144,28 +145,21 @@ void Ship::GetImage(Direction direction, EngineImageType image_type, VehicleSpri
 
 static const Depot *FindClosestShipDepot(const Vehicle *v, uint max_distance)
 {
-	/* Find the closest depot */
-	const Depot *depot;
-	const Depot *best_depot = NULL;
 	/* If we don't have a maximum distance, i.e. distance = 0,
 	 * we want to find any depot so the best distance of no
 	 * depot must be more than any correct distance. On the
 	 * other hand if we have set a maximum distance, any depot
 	 * further away than max_distance can safely be ignored. */
-	uint best_dist = max_distance == 0 ? UINT_MAX : max_distance + 1;
-
-	FOR_ALL_DEPOTS(depot) {
-		TileIndex tile = depot->xy;
-		if (IsShipDepotTile(tile) && IsTileOwner(tile, v->owner)) {
-			uint dist = DistanceManhattan(tile, v->tile);
-			if (dist < best_dist) {
-				best_dist = dist;
-				best_depot = depot;
-			}
-		}
-	}
+	int limit = max_distance == 0 ? INT_MAX : max_distance + 1;
 
-	return best_depot;
+	/* Find the closest depot; equally near depots go to the lowest depot ID. */
+	DepotID best_depot;
+	bool found = _depot_kdtree.FindNearest(TileX(v->tile), TileY(v->tile), limit, [&](DepotID id) {
+		TileIndex tile = Depot::Get(id)->xy;
+		return IsShipDepotTile(tile) && IsTileOwner(tile, v->owner);
+	}, &best_depot);
+
+	return found ? Depot::Get(best_depot) : NULL;
 }
 
 static void CheckIfShipNeedsService(Vehicle *v)
@@ -224,6 +218,12 @@ Money Ship::GetRunningCost() const
 	return GetPrice(PR_RUNNING_SHIP, cost_factor, e->GetGRF());
 }
 
+/** Look for a depot to service at, as queued by the daily check. */
+void Ship::OnServiceDepotSearch()
+{
+	CheckIfShipNeedsService(this);
+}
+
 void Ship::OnNewDay()
 {
 	if ((++this->day_counter & 7) == 0) {
@@ -232,7 +232,7 @@ void Ship::OnNewDay()
 
 	CheckVehicleBreakdown(this);
 	AgeVehicle(this);
-	CheckIfShipNeedsService(this);
+	if (this->NeedsAutomaticServicing()) QueueServiceDepotSearch(this);
 
 	CheckOrders(this);
 
@@ -491,6 +491,12 @@ static Track ChooseShipTrack(Ship *v, TileIndex tile, DiagDirection enterdir, Tr
 			v->path.clear();
 		}
 
+		/* There is no choice on this tile, e.g. in a canal or along a coast, so
+		 * the pathfinder would give this track anyway. Leave the search to the
+		 * next tile where there is a choice. OPF is excluded as it might decide
+		 * to reverse instead. */
+		if (HasAtMostOneBit(tracks) && _settings_game.pf.pathfinder_for_ships != VPF_OPF) return FindFirstTrack(tracks);
+
 		switch (_settings_game.pf.pathfinder_for_ships) {
 			case VPF_OPF: track = OPFShipChooseTrack(v, tile, enterdir, tracks, path_found); break;
 			case VPF_NPF: track = NPFShipChooseTrack(v, path_found); break;
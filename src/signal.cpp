@@ -17,6 +17,8 @@
 #include "viewport_func.h"
 #include "train.h"
 #include "company_base.h"
+#include <vector>
+#include <map>
 
 #include "safeguards.h"
 
@@ -29,6 +31,8 @@ static const uint SIG_GLOB_UPDATE =  64; ///< how many items need to be in _glob
 
 assert_compile(SIG_GLOB_UPDATE <= SIG_GLOB_SIZE);
 
+static const uint MAX_CACHED_SIGNAL_SEGMENTS = 8192; ///< number of explored segments kept before the cache is flushed
+
 /** incidating trackbits with given enterdir */
 static const TrackBits _enterdir_to_trackbits[DIAGDIR_END] = {
 	TRACK_BIT_3WAY_NE,
@@ -188,6 +192,45 @@ static SmallSet<Trackdir, SIG_TBU_SIZE> _tbuset("_tbuset");         ///< set of
 static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset("_tbdset");    ///< set of open nodes in current signal block
 static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of places to be updated in following runs
 
+/** Tile and direction, as stored in the sets above. */
+template <typename Tdir>
+struct SignalSetItem {
+	TileIndex tile; ///< the tile
+	Tdir dir;       ///< the direction or trackdir
+
+	SignalSetItem(TileIndex tile, Tdir dir) : tile(tile), dir(dir) {}
+};
+
+/**
+ * Everything ExploreSegment found out about a signal segment that does not
+ * depend on the trains in it or the state of its signals. Replaying it gives
+ * the same result as exploring the segment again, as long as the track
+ * layout has not changed.
+ */
+struct SignalSegment {
+	/** A tile to look for trains on. */
+	struct TrainCheck {
+		TileIndex tile;   ///< the tile
+		TrackBits tracks; ///< the tracks to check, #INVALID_TRACK_BIT to check the whole tile
+	};
+
+	bool pbs;                                              ///< the segment has a pbs signal
+	std::vector<TrainCheck> train_checks;                  ///< tiles to look for trains on
+	std::vector<SignalSetItem<Trackdir> > exits;          ///< presignal exits leaving the segment
+	std::vector<SignalSetItem<Trackdir> > signals;        ///< signals to update, in the order they were added to _tbuset
+	std::vector<SignalSetItem<DiagDirection> > globremoved; ///< items removed from _globset while exploring, in order
+};
+
+/** Explored segments, by starting tile, side and owner. */
+static std::map<uint64, SignalSegment> _signal_segments;
+static SignalSegment *_sig_recording = NULL; ///< segment ExploreSegment is recording into, if any
+
+/** Forget all explored segments, because the track layout has changed. */
+void InvalidateSignalSegmentCache()
+{
+	_signal_segments.clear();
+}
+
 
 /** Check whether there is a train on rail, not in a depot */
 static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
@@ -213,6 +256,10 @@ static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
  */
 static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
 {
+	if (_sig_recording != NULL) {
+		_sig_recording->globremoved.push_back(SignalSetItem<DiagDirection>(t1, d1));
+		_sig_recording->globremoved.push_back(SignalSetItem<DiagDirection>(t2, d2));
+	}
 	_globset.Remove(t1, d1); // it can be in Global but not in Todo
 	_globset.Remove(t2, d2); // remove in all cases
 
@@ -260,6 +307,56 @@ enum SigFlags {
 DECLARE_ENUM_AS_BIT_SET(SigFlags)
 
 
+/**
+ * Look for a train on a tile of the segment, unless one has been found already.
+ * @param flags flags of the segment
+ * @param tile the tile
+ * @param tracks the tracks to check, #INVALID_TRACK_BIT to check the whole tile
+ */
+static inline void CheckTrainOnTile(SigFlags &flags, TileIndex tile, TrackBits tracks = INVALID_TRACK_BIT)
+{
+	if (_sig_recording != NULL) {
+		SignalSegment::TrainCheck check = { tile, tracks };
+		_sig_recording->train_checks.push_back(check);
+	}
+	if (flags & SF_TRAIN) return;
+
+	bool found = (tracks == INVALID_TRACK_BIT) ? HasVehicleOnPos(tile, NULL, &TrainOnTileEnum) : EnsureNoTrainOnTrackBits(tile, tracks).Failed();
+	if (found) flags |= SF_TRAIN;
+}
+
+/**
+ * Account for a presignal exit leaving the segment.
+ * @param flags flags of the segment
+ * @param tile tile of the signal
+ * @param trackdir trackdir of the signal
+ */
+static inline void CheckPresignalExit(SigFlags &flags, TileIndex tile, Trackdir trackdir)
+{
+	if (_sig_recording != NULL) _sig_recording->exits.push_back(SignalSetItem<Trackdir>(tile, trackdir));
+	if (flags & SF_GREEN2) return;
+
+	if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
+	flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
+	if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
+		if (flags & SF_GREEN) flags |= SF_GREEN2;
+		flags |= SF_GREEN;
+	}
+}
+
+/**
+ * Add a signal to the 'to-be-updated' set.
+ * @param tile tile of the signal
+ * @param trackdir trackdir of the signal
+ * @return false iff the set was full
+ */
+static inline bool AddSignalToUpdate(TileIndex tile, Trackdir trackdir)
+{
+	if (_sig_recording != NULL) _sig_recording->signals.push_back(SignalSetItem<Trackdir>(tile, trackdir));
+	return _tbuset.Add(tile, trackdir);
+}
+
+
 /**
  * Search signal block
  *
@@ -283,13 +380,13 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (IsRailDepot(tile)) {
 					if (enterdir == INVALID_DIAGDIR) { // from 'inside' - train just entered or left the depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						CheckTrainOnTile(flags, tile);
 						exitdir = GetRailDepotDirection(tile);
 						tile += TileOffsByDiagDir(exitdir);
 						enterdir = ReverseDiagDir(exitdir);
 						break;
 					} else if (enterdir == GetRailDepotDirection(tile)) { // entered a depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						CheckTrainOnTile(flags, tile);
 						continue;
 					} else {
 						continue;
@@ -303,10 +400,10 @@ static SigFlags ExploreSegment(Owner owner)
 				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) { // there is exactly one incidating track, no need to check
 					tracks = tracks_masked;
 					/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
-					if (!(flags & SF_TRAIN) && EnsureNoTrainOnTrackBits(tile, tracks).Failed()) flags |= SF_TRAIN;
+					CheckTrainOnTile(flags, tile, tracks);
 				} else {
 					if (tracks_masked == TRACK_BIT_NONE) continue; // no incidating track
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					CheckTrainOnTile(flags, tile);
 				}
 
 				if (HasSignals(tile)) { // there is exactly one track - not zero, because there is exit from this tile
@@ -321,21 +418,14 @@ static SigFlags ExploreSegment(Owner owner)
 						if (HasSignalOnTrackdir(tile, reversedir)) {
 							if (IsPbsSignal(sig)) {
 								flags |= SF_PBS;
-							} else if (!_tbuset.Add(tile, reversedir)) {
+							} else if (!AddSignalToUpdate(tile, reversedir)) {
 								return flags | SF_FULL;
 							}
 						}
 						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) flags |= SF_PBS;
 
-						/* if it is a presignal EXIT in OUR direction and we haven't found 2 green exits yes, do special check */
-						if (!(flags & SF_GREEN2) && IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
-							if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
-							flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
-							if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
-								if (flags & SF_GREEN) flags |= SF_GREEN2;
-								flags |= SF_GREEN;
-							}
-						}
+						/* if it is a presignal EXIT in OUR direction, do special check */
+						if (IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) CheckPresignalExit(flags, tile, trackdir); // found presignal exit
 
 						continue;
 					}
@@ -358,7 +448,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (DiagDirToAxis(enterdir) != GetRailStationAxis(tile)) continue; // different axis
 				if (IsStationTileBlocked(tile)) continue; // 'eye-candy' station tile
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				CheckTrainOnTile(flags, tile);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -367,7 +457,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (GetTileOwner(tile) != owner) continue;
 				if (DiagDirToAxis(enterdir) == GetCrossingRoadAxis(tile)) continue; // different axis
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				CheckTrainOnTile(flags, tile);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -377,13 +467,13 @@ static SigFlags ExploreSegment(Owner owner)
 				DiagDirection dir = GetTunnelBridgeDirection(tile);
 
 				if (enterdir == INVALID_DIAGDIR) { // incoming from the wormhole
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					CheckTrainOnTile(flags, tile);
 					enterdir = dir;
 					exitdir = ReverseDiagDir(dir);
 					tile += TileOffsByDiagDir(exitdir); // just skip to next tile
 				} else { // NOT incoming from the wormhole!
 					if (ReverseDiagDir(enterdir) != dir) continue;
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					CheckTrainOnTile(flags, tile);
 					tile = GetOtherTunnelBridgeEnd(tile); // just skip to exit tile
 					enterdir = INVALID_DIAGDIR;
 					exitdir = INVALID_DIAGDIR;
@@ -402,6 +492,42 @@ static SigFlags ExploreSegment(Owner owner)
 }
 
 
+/**
+ * Bring the sets into the state ExploreSegment would leave them in,
+ * using the structure of a segment explored before.
+ *
+ * @param seg the segment
+ * @return SigFlags
+ */
+static SigFlags ReplaySegment(const SignalSegment &seg)
+{
+	SigFlags flags = seg.pbs ? SF_PBS : SF_NONE;
+
+	for (std::vector<SignalSegment::TrainCheck>::const_iterator it = seg.train_checks.begin(); it != seg.train_checks.end() && !(flags & SF_TRAIN); ++it) {
+		CheckTrainOnTile(flags, it->tile, it->tracks);
+	}
+
+	/* exits do not matter when there is a train in the segment */
+	if (!(flags & SF_TRAIN)) {
+		for (std::vector<SignalSetItem<Trackdir> >::const_iterator it = seg.exits.begin(); it != seg.exits.end(); ++it) {
+			CheckPresignalExit(flags, it->tile, it->dir);
+		}
+	}
+
+	if (!_globset.IsEmpty()) {
+		for (std::vector<SignalSetItem<DiagDirection> >::const_iterator it = seg.globremoved.begin(); it != seg.globremoved.end(); ++it) {
+			_globset.Remove(it->tile, it->dir);
+		}
+	}
+
+	for (std::vector<SignalSetItem<Trackdir> >::const_iterator it = seg.signals.begin(); it != seg.signals.end(); ++it) {
+		_tbuset.Add(it->tile, it->dir);
+	}
+
+	return flags;
+}
+
+
 /**
  * Update signals around segment in _tbuset
  *
@@ -466,10 +592,11 @@ static inline void ResetSets()
  * Updates blocks in _globset buffer
  *
  * @param owner company whose signals we are updating
+ * @param use_cache whether segments may be taken from and stored in the segment cache
  * @return state of the first block from _globset
  * @pre Company::IsValidID(owner)
  */
-static SigSegState UpdateSignalsInBuffer(Owner owner)
+static SigSegState UpdateSignalsInBuffer(Owner owner, bool use_cache = false)
 {
 	assert(Company::IsValidID(owner));
 
@@ -483,6 +610,8 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 		assert(_tbuset.IsEmpty());
 		assert(_tbdset.IsEmpty());
 
+		const uint64 key = (uint64)tile << 16 | (uint)dir << 8 | (uint)owner;
+
 		/* After updating signal, data stored are always MP_RAILWAY with signals.
 		 * Other situations happen when data are from outside functions -
 		 * modification of railbits (including both rail building and removal),
@@ -531,7 +660,25 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 		assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
 		assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
 
-		SigFlags flags = ExploreSegment(owner);
+		SigFlags flags;
+		std::map<uint64, SignalSegment>::const_iterator cached = use_cache ? _signal_segments.find(key) : _signal_segments.end();
+		if (cached != _signal_segments.end()) {
+			_tbdset.Reset();
+			flags = ReplaySegment(cached->second);
+		} else if (use_cache) {
+			SignalSegment seg;
+			_sig_recording = &seg;
+			flags = ExploreSegment(owner);
+			_sig_recording = NULL;
+
+			if (!(flags & SF_FULL)) {
+				seg.pbs = (flags & SF_PBS) != 0;
+				if (_signal_segments.size() >= MAX_CACHED_SIGNAL_SEGMENTS) _signal_segments.clear();
+				_signal_segments[key] = seg;
+			}
+		} else {
+			flags = ExploreSegment(owner);
+		}
 
 		if (first) {
 			first = false;
@@ -558,6 +705,15 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 
 static Owner _last_owner = INVALID_OWNER; ///< last owner whose track was put into _globset
 
+/** Sides of the tile at the first end of each track. */
+static const DiagDirection _search_dir_1[] = {
+	DIAGDIR_NE, DIAGDIR_SE, DIAGDIR_NE, DIAGDIR_SE, DIAGDIR_SW, DIAGDIR_SE
+};
+/** Sides of the tile at the second end of each track. */
+static const DiagDirection _search_dir_2[] = {
+	DIAGDIR_SW, DIAGDIR_NW, DIAGDIR_NW, DIAGDIR_SW, DIAGDIR_NW, DIAGDIR_NE
+};
+
 
 /**
  * Update signals in buffer
@@ -581,18 +737,14 @@ void UpdateSignalsInBuffer()
  */
 void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
 {
-	static const DiagDirection _search_dir_1[] = {
-		DIAGDIR_NE, DIAGDIR_SE, DIAGDIR_NE, DIAGDIR_SE, DIAGDIR_SW, DIAGDIR_SE
-	};
-	static const DiagDirection _search_dir_2[] = {
-		DIAGDIR_SW, DIAGDIR_NW, DIAGDIR_NW, DIAGDIR_SW, DIAGDIR_NW, DIAGDIR_NE
-	};
-
 	/* do not allow signal updates for two companies in one run */
 	assert(_globset.IsEmpty() || owner == _last_owner);
 
 	_last_owner = owner;
 
+	/* buffered updates come from changes to the track layout */
+	InvalidateSignalSegmentCache();
+
 	_globset.Add(tile, _search_dir_1[track]);
 	_globset.Add(tile, _search_dir_2[track]);
 
@@ -618,6 +770,9 @@ void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 
 	_last_owner = owner;
 
+	/* buffered updates come from changes to the track layout */
+	InvalidateSignalSegmentCache();
+
 	_globset.Add(tile, side);
 
 	if (_globset.Items() >= SIG_GLOB_UPDATE) {
@@ -642,7 +797,7 @@ SigSegState UpdateSignalsOnSegment(TileIndex tile, DiagDirection side, Owner own
 	assert(_globset.IsEmpty());
 	_globset.Add(tile, side);
 
-	return UpdateSignalsInBuffer(owner);
+	return UpdateSignalsInBuffer(owner, true);
 }
 
 
@@ -659,6 +814,7 @@ void SetSignalsOnBothDir(TileIndex tile, Track track, Owner owner)
 {
 	assert(_globset.IsEmpty());
 
-	AddTrackToSignalBuffer(tile, track, owner);
-	UpdateSignalsInBuffer(owner);
+	_globset.Add(tile, _search_dir_1[track]);
+	_globset.Add(tile, _search_dir_2[track]);
+	UpdateSignalsInBuffer(owner, true);
 }
@@ -24,6 +24,8 @@
 #include "window_func.h"
 #include "company_base.h"
 #include "guitimer_func.h"
+#include "core/mem_func.hpp"
+#include "thread/thread_pool.h"
 
 #include "smallmap_gui.h"
 
@@ -708,6 +710,7 @@ void SmallMapWindow::SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt)
 
 	if (new_index != cur_index) {
 		this->zoom = zoomlevels[new_index];
+		this->InvalidateColourCache();
 		if (cur_index >= 0) {
 			Point new_tile = this->PixelToTile(zoom_pt->x, zoom_pt->y, &sub);
 			this->SetNewScroll(this->scroll_x + (tile.x - new_tile.x) * TILE_SIZE,
@@ -726,7 +729,7 @@ void SmallMapWindow::SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt)
  * @param ta Tile area to investigate.
  * @return Colours to display.
  */
-inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
+/* static */ inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta)
 {
 	int importance = 0;
 	TileIndex tile = INVALID_TILE; // Position of the most important tile.
@@ -749,7 +752,7 @@ inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
 
 			case MP_INDUSTRY:
 				/* Special handling of industries while in "Industries" smallmap view. */
-				if (this->map_type == SMT_INDUSTRY) {
+				if (SmallMapWindow::map_type == SMT_INDUSTRY) {
 					/* If industry is allowed to be seen, use its colour on the map.
 					 * This has the highest priority above any value in _tiletype_importance. */
 					IndustryType type = Industry::GetByTile(ti)->type;
@@ -776,7 +779,7 @@ inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
 		}
 	}
 
-	switch (this->map_type) {
+	switch (SmallMapWindow::map_type) {
 		case SMT_CONTOUR:
 			return GetSmallMapContoursPixels(tile, et);
 
@@ -802,52 +805,153 @@ inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
 	}
 }
 
+/**
+ * Get the tiles of a block of the small map.
+ * @param xc The X coordinate of the first tile of the block.
+ * @param yc The Y coordinate of the first tile of the block.
+ * @param[out] ta The tiles of the block, clamped to the map.
+ * @return False if there is nothing to draw for the block.
+ */
+bool SmallMapWindow::GetBlockArea(uint xc, uint yc, TileArea *ta) const
+{
+	/* Check if the tile (xc,yc) is within the map range */
+	if (xc >= MapMaxX() || yc >= MapMaxY()) return false;
+
+	/* Construct tilearea covered by (xc, yc, xc + this->zoom, yc + this->zoom) such that it is within min_xy limits. */
+	uint min_xy = _settings_game.construction.freeform_edges ? 1 : 0;
+	if (min_xy == 1 && (xc == 0 || yc == 0)) {
+		if (this->zoom == 1) return false; // The tile area is empty, don't draw anything.
+
+		*ta = TileArea(TileXY(max(min_xy, xc), max(min_xy, yc)), this->zoom - (xc == 0), this->zoom - (yc == 0));
+	} else {
+		*ta = TileArea(TileXY(xc, yc), this->zoom, this->zoom);
+	}
+	ta->ClampToMap(); // Clamp to map boundaries (may contain MP_VOID tiles!).
+	return true;
+}
+
+/**
+ * Get the colours of the blocks of a column of the small map, from the colour cache where possible.
+ * This only reads the map and the colour cache, so it can be done for several columns at once.
+ * @param column The column.
+ * @param[out] colours The colours of the blocks of the column; blocks with nothing to draw are skipped.
+ */
+void SmallMapWindow::GetColumnColours(const SmallMapColumn &column, uint32 *colours) const
+{
+	uint xc = column.xc;
+	uint yc = column.yc;
+	for (int i = 0; i < column.reps; i++, xc += this->zoom, yc += this->zoom) {
+		TileArea ta;
+		if (!this->GetBlockArea(xc, yc, &ta)) continue;
+
+		const ColourCacheItem &item = this->colour_cache[this->GetColourCacheIndex(xc, yc)];
+		colours[i] = (item.key == GetColourCacheKey(xc, yc)) ? item.colours : this->GetTileColours(ta);
+	}
+}
+
+/** Number of columns of the small map a thread looks up the colours of at once. */
+static const uint SMALLMAP_COLOUR_CHUNK_SIZE = 16;
+
+/**
+ * Thread pool procedure to get the colours of a range of columns.
+ * @param data  The #ColourJob.
+ * @param first The first column.
+ * @param last  One past the last column.
+ */
+/* static */ void SmallMapWindow::GetColumnColoursProc(void *data, uint first, uint last)
+{
+	const ColourJob *job = static_cast<const ColourJob *>(data);
+	for (uint i = first; i < last; i++) {
+		job->w->GetColumnColours(job->columns[i], job->colours + job->columns[i].first);
+	}
+}
+
+/**
+ * Thread pool procedure to get the colours of a range of rows of the map image.
+ * @param data  The palette indices of the map image, see #GetMapImage.
+ * @param first The first row.
+ * @param last  One past the last row.
+ */
+/* static */ void SmallMapWindow::GetMapImageRowsProc(void *data, uint first, uint last)
+{
+	uint8 *dst = static_cast<uint8 *>(data) + first * MapSizeX();
+	for (uint y = first; y < last; y++) {
+		for (uint x = MapMaxX(); true; x--) {
+			/* The middle pixels of a tile's colours show what is on it; the outer ones the ground. */
+			*dst++ = GB(GetTileColours(TileArea(TileXY(x, y), 1, 1)), 8, 8);
+			if (x == 0) break;
+		}
+	}
+}
+
+/** Names of the small map modes for #SmallMapWindow::GetMapImage, indexed by #SmallMapWindow::SmallMapType. */
+static const char * const _smallmap_type_names[] = {
+	"contour", "vehicles", "industries", "linkstats", "routes", "vegetation", "owner",
+};
+
+/**
+ * Get an image of the whole map with the colours the small map shows, one pixel per tile.
+ * The rows of the image follow the Y axis of the map, and the columns the X axis from
+ * east to west, like for the heightmap screenshot. This does not need a small map window,
+ * so it also works on a dedicated server.
+ * @param mode   Name of the small map mode to use, e.g. "contour" or "owner".
+ * @param pixels Destination for the MapSizeX() * MapSizeY() palette indices.
+ * @return False iff  mode is not a known small map mode.
+ */
+/* static */ bool SmallMapWindow::GetMapImage(const char *mode, uint8 *pixels)
+{
+	assert_compile(lengthof(_smallmap_type_names) == SMT_OWNER + 1);
+
+	uint type = 0;
+	while (type < lengthof(_smallmap_type_names) && strcmp(mode, _smallmap_type_names[type]) != 0) type++;
+	if (type == lengthof(_smallmap_type_names)) return false;
+
+	RebuildColourIndexIfNecessary();
+
+	SmallMapType old_type = SmallMapWindow::map_type;
+	SmallMapWindow::map_type = (SmallMapType)type;
+	ThreadPoolParallelFor(&SmallMapWindow::GetMapImageRowsProc, pixels, MapSizeY(), SMALLMAP_COLOUR_CHUNK_SIZE);
+	SmallMapWindow::map_type = old_type;
+	return true;
+}
+
 /**
  * Draws one column of tiles of the small map in a certain mode onto the screen buffer, skipping the shifted rows in between.
+ * The colours drawn are remembered in the colour cache.
  *
- * @param dst Pointer to a part of the screen buffer to write to.
- * @param xc The X coordinate of the first tile in the column.
- * @param yc The Y coordinate of the first tile in the column
+ * @param column The column to draw.
  * @param pitch Number of pixels to advance in the screen buffer each time a pixel is written.
- * @param reps Number of lines to draw
- * @param start_pos Position of first pixel to draw.
- * @param end_pos Position of last pixel to draw (exclusive).
+ * @param colours The colours of the blocks of the column, see #GetColumnColours.
  * @param blitter current blitter
  * @note If pixel position is below \c 0, skip drawing.
  */
-void SmallMapWindow::DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter) const
+void SmallMapWindow::DrawSmallMapColumn(const SmallMapColumn &column, int pitch, const uint32 *colours, Blitter *blitter) const
 {
 	void *dst_ptr_abs_end = blitter->MoveTo(_screen.dst_ptr, 0, _screen.height);
-	uint min_xy = _settings_game.construction.freeform_edges ? 1 : 0;
+	void *dst = column.dst;
+	uint xc = column.xc;
+	uint yc = column.yc;
 
-	do {
-		/* Check if the tile (xc,yc) is within the map range */
-		if (xc >= MapMaxX() || yc >= MapMaxY()) continue;
+	for (int i = 0; i < column.reps; i++, xc += this->zoom, yc += this->zoom, dst = blitter->MoveTo(dst, pitch, 0)) {
+		TileArea ta;
+		if (!this->GetBlockArea(xc, yc, &ta)) continue;
+
+		ColourCacheItem &item = this->colour_cache[this->GetColourCacheIndex(xc, yc)];
+		item.key = GetColourCacheKey(xc, yc);
+		item.colours = colours[i];
 
 		/* Check if the dst pointer points to a pixel inside the screen buffer */
 		if (dst < _screen.dst_ptr) continue;
 		if (dst >= dst_ptr_abs_end) continue;
 
-		/* Construct tilearea covered by (xc, yc, xc + this->zoom, yc + this->zoom) such that it is within min_xy limits. */
-		TileArea ta;
-		if (min_xy == 1 && (xc == 0 || yc == 0)) {
-			if (this->zoom == 1) continue; // The tile area is empty, don't draw anything.
-
-			ta = TileArea(TileXY(max(min_xy, xc), max(min_xy, yc)), this->zoom - (xc == 0), this->zoom - (yc == 0));
-		} else {
-			ta = TileArea(TileXY(xc, yc), this->zoom, this->zoom);
-		}
-		ta.ClampToMap(); // Clamp to map boundaries (may contain MP_VOID tiles!).
-
-		uint32 val = this->GetTileColours(ta);
+		uint32 val = colours[i];
 		uint8 *val8 = (uint8 *)&val;
-		int idx = max(0, -start_pos);
-		for (int pos = max(0, start_pos); pos < end_pos; pos++) {
+		int idx = max(0, -column.start_pos);
+		for (int pos = max(0, column.start_pos); pos < column.end_pos; pos++) {
 			blitter->SetPixel(dst, idx, 0, val8[idx]);
 			idx++;
 		}
-	/* Switch to next tile in the column */
-	} while (xc += this->zoom, yc += this->zoom, dst = blitter->MoveTo(dst, pitch, 0), --reps != 0);
+	}
 }
 
 /**
@@ -971,6 +1075,11 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi) const
 	int x = - dx - 4;
 	int y = 0;
 
+	static SmallVector<SmallMapColumn, 64> columns;
+	static SmallVector<uint32, 1024> colours;
+	columns.Clear();
+	uint num_blocks = 0;
+
 	for (;;) {
 		/* Distance from left edge */
 		if (x >= -3) {
@@ -979,7 +1088,15 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi) const
 			int end_pos = min(dpi->width, x + 4);
 			int reps = (dpi->height - y + 1) / 2; // Number of lines.
 			if (reps > 0) {
-				this->DrawSmallMapColumn(ptr, tile_x, tile_y, dpi->pitch * 2, reps, x, end_pos, blitter);
+				SmallMapColumn *column = columns.Append();
+				column->dst = ptr;
+				column->xc = tile_x;
+				column->yc = tile_y;
+				column->reps = reps;
+				column->start_pos = x;
+				column->end_pos = end_pos;
+				column->first = num_blocks;
+				num_blocks += reps;
 			}
 		}
 
@@ -996,6 +1113,23 @@ void SmallMapWindow::DrawSmallMap(DrawPixelInfo *dpi) const
 		x += 2;
 	}
 
+	if (this->colour_cache == NULL) this->colour_cache = MallocT<ColourCacheItem>(1 << (2 * COLOUR_CACHE_BITS));
+	if (!this->colour_cache_valid) {
+		MemSetT(this->colour_cache, 0xFF, 1 << (2 * COLOUR_CACHE_BITS));
+		this->colour_cache_valid = true;
+	}
+
+	/* Find the colours of all blocks first; the columns are independent and
+	 * the map is only read, so the work is spread over the worker threads. */
+	colours.Clear();
+	colours.Append(num_blocks);
+	ColourJob job = { this, columns.Begin(), colours.Begin() };
+	ThreadPoolParallelFor(&SmallMapWindow::GetColumnColoursProc, &job, columns.Length(), SMALLMAP_COLOUR_CHUNK_SIZE);
+
+	for (const SmallMapColumn *column = columns.Begin(); column != columns.End(); column++) {
+		this->DrawSmallMapColumn(*column, dpi->pitch * 2, colours.Begin() + column->first, blitter);
+	}
+
 	/* Draw vehicles */
 	if (this->map_type == SMT_CONTOUR || this->map_type == SMT_VEHICLES) this->DrawVehicles(dpi, blitter);
 
@@ -1056,7 +1190,7 @@ void SmallMapWindow::SetupWidgetData()
 	this->GetWidget<NWidgetStacked>(WID_SM_SELECT_BUTTONS)->SetDisplayedPlane(plane);
 }
 
-SmallMapWindow::SmallMapWindow(WindowDesc *desc, int window_number) : Window(desc), refresh(GUITimer(FORCE_REFRESH_PERIOD))
+SmallMapWindow::SmallMapWindow(WindowDesc *desc, int window_number) : Window(desc), refresh(GUITimer(FORCE_REFRESH_PERIOD)), colour_cache(NULL), colour_cache_valid(false)
 {
 	_smallmap_industry_highlight = INVALID_INDUSTRYTYPE;
 	this->overlay = new LinkGraphOverlay(this, WID_SM_MAP, 0, this->GetOverlayCompanyMask(), 1);
@@ -1079,13 +1213,14 @@ SmallMapWindow::SmallMapWindow(WindowDesc *desc, int window_number) : Window(des
 SmallMapWindow::~SmallMapWindow()
 {
 	delete this->overlay;
+	free(this->colour_cache);
 	this->BreakIndustryChainLink();
 }
 
 /**
  * Rebuilds the colour indices used for fast access to the smallmap contour colours based on the heightlevel.
  */
-void SmallMapWindow::RebuildColourIndexIfNecessary()
+/* static */ void SmallMapWindow::RebuildColourIndexIfNecessary()
 {
 	/* Rebuild colour indices if necessary. */
 	if (SmallMapWindow::max_heightlevel == _settings_game.construction.max_heightlevel) return;
@@ -1287,6 +1422,7 @@ void SmallMapWindow::SwitchMapType(SmallMapType map_type)
 	this->RaiseWidget(this->map_type + WID_SM_CONTOUR);
 	this->map_type = map_type;
 	this->LowerWidget(this->map_type + WID_SM_CONTOUR);
+	this->InvalidateColourCache();
 
 	this->SetupWidgetData();
 
@@ -1393,12 +1529,16 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 		_smallmap_industry_highlight = new_highlight;
 		this->refresh.SetInterval(_smallmap_industry_highlight != INVALID_INDUSTRYTYPE ? BLINK_PERIOD : FORCE_REFRESH_PERIOD);
 		_smallmap_industry_highlight_state = true;
+		this->InvalidateColourCache();
 		this->SetDirty();
 	}
 }
 
 /* virtual */ void SmallMapWindow::OnClick(Point pt, int widget, int click_count)
 {
+	/* Everything but the map itself changes what is shown on the map. */
+	if (widget != WID_SM_MAP) this->InvalidateColourCache();
+
 	switch (widget) {
 		case WID_SM_MAP: { // Map window
 			if (click_count > 0) this->mouse_capture_widget = widget;
@@ -1539,6 +1679,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 
 		default: NOT_REACHED();
 	}
+	this->InvalidateColourCache();
 	this->SetDirty();
 }
 
@@ -1578,6 +1719,8 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 	}
 	_smallmap_industry_highlight_state = !_smallmap_industry_highlight_state;
 
+	/* Show the changes to the map since the last refresh. */
+	this->InvalidateColourCache();
 	this->refresh.SetInterval(_smallmap_industry_highlight != INVALID_INDUSTRYTYPE ? BLINK_PERIOD : FORCE_REFRESH_PERIOD);
 	this->SetDirty();
 }
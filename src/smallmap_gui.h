@@ -83,6 +83,64 @@ protected:
 	GUITimer refresh; ///< Refresh timer.
 	LinkGraphOverlay *overlay;
 
+	/** Colours of a block of tiles remembered by the colour cache. */
+	struct ColourCacheItem {
+		uint32 key;     ///< Position of the first tile of the block, see #GetColourCacheKey; \c UINT32_MAX if unused.
+		uint32 colours; ///< Colours of the block.
+	};
+
+	/** A column of blocks of tiles to draw; see #DrawSmallMapColumn. */
+	struct SmallMapColumn {
+		void *dst;     ///< Pointer to the part of the screen buffer with the first block.
+		uint xc;       ///< X coordinate of the first tile of the column.
+		uint yc;       ///< Y coordinate of the first tile of the column.
+		int reps;      ///< Number of blocks in the column.
+		int start_pos; ///< Position of the first pixel to draw.
+		int end_pos;   ///< Position of the last pixel to draw (exclusive).
+		uint first;    ///< Index of the colours of the first block of the column.
+	};
+
+	/** Columns of which the colours are looked up at once; see #GetColumnColoursProc. */
+	struct ColourJob {
+		const SmallMapWindow *w;        ///< The small map window.
+		const SmallMapColumn *columns;  ///< The columns.
+		uint32 *colours;                ///< The colours of the blocks of all columns.
+	};
+
+	static const uint COLOUR_CACHE_BITS = 10; ///< Number of bits per axis of the block position used to find its place in the colour cache.
+
+	mutable ColourCacheItem *colour_cache; ///< Colours of recently drawn blocks of tiles, for the current map type and zoom level.
+	mutable bool colour_cache_valid;       ///< Whether the items in #colour_cache are still up to date.
+
+	/**
+	 * Get the key of a block of tiles in the colour cache.
+	 * @param xc The X coordinate of the first tile of the block.
+	 * @param yc The Y coordinate of the first tile of the block.
+	 * @return The key.
+	 */
+	static inline uint32 GetColourCacheKey(uint xc, uint yc)
+	{
+		return xc | (yc << 16);
+	}
+
+	/**
+	 * Get the place of a block of tiles in the colour cache.
+	 * @param xc The X coordinate of the first tile of the block.
+	 * @param yc The Y coordinate of the first tile of the block.
+	 * @return The index into #colour_cache.
+	 */
+	inline uint GetColourCacheIndex(uint xc, uint yc) const
+	{
+		const uint mask = (1 << COLOUR_CACHE_BITS) - 1;
+		return ((xc / this->zoom) & mask) | (((yc / this->zoom) & mask) << COLOUR_CACHE_BITS);
+	}
+
+	/** Forget all cached colours, after something changed about what the map shows. */
+	inline void InvalidateColourCache()
+	{
+		this->colour_cache_valid = false;
+	}
+
 	static void BreakIndustryChainLink();
 	Point SmallmapRemapCoords(int x, int y) const;
 
@@ -149,14 +207,18 @@ protected:
 		return Company::IsValidID(_local_company) ? 1U << _local_company : 0xffffffff;
 	}
 
-	void RebuildColourIndexIfNecessary();
+	static void RebuildColourIndexIfNecessary();
 	uint GetNumberRowsLegend(uint columns) const;
 	void SelectLegendItem(int click_pos, LegendAndColour *legend, int end_legend_item, int begin_legend_item = 0);
 	void SwitchMapType(SmallMapType map_type);
 	void SetNewScroll(int sx, int sy, int sub);
 
 	void DrawMapIndicators() const;
-	void DrawSmallMapColumn(void *dst, uint xc, uint yc, int pitch, int reps, int start_pos, int end_pos, Blitter *blitter) const;
+	bool GetBlockArea(uint xc, uint yc, TileArea *ta) const;
+	void GetColumnColours(const SmallMapColumn &column, uint32 *colours) const;
+	static void GetColumnColoursProc(void *data, uint first, uint last);
+	static void GetMapImageRowsProc(void *data, uint first, uint last);
+	void DrawSmallMapColumn(const SmallMapColumn &column, int pitch, const uint32 *colours, Blitter *blitter) const;
 	void DrawVehicles(const DrawPixelInfo *dpi, Blitter *blitter) const;
 	void DrawTowns(const DrawPixelInfo *dpi) const;
 	void DrawSmallMap(DrawPixelInfo *dpi) const;
@@ -167,7 +229,7 @@ protected:
 	void SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt);
 	void SetOverlayCargoMask();
 	void SetupWidgetData();
-	uint32 GetTileColours(const TileArea &ta) const;
+	static uint32 GetTileColours(const TileArea &ta);
 
 	int GetPositionOnLegend(Point pt);
 
@@ -177,6 +239,8 @@ public:
 	SmallMapWindow(WindowDesc *desc, int window_number);
 	virtual ~SmallMapWindow();
 
+	static bool GetMapImage(const char *mode, uint8 *pixels);
+
 	void SmallMapCenterOnCurrentPos();
 	Point GetStationMiddle(const Station *st) const;
 
@@ -19,6 +19,7 @@
 #include "blitter/factory.hpp"
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
+#include "core/smallvec_type.hpp"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -36,7 +37,9 @@ struct SpriteCache {
 	size_t file_pos;
 	uint32 id;
 	uint16 file_slot;
-	int16 lru;
+	uint32 last_used;    ///< Main loop iteration the sprite was last requested in, see #IncreaseSpriteLRU.
+	uint lru_prev;       ///< Sprite used more recently than this one, or #SPRITE_LRU_END.
+	uint lru_next;       ///< Sprite used less recently than this one, or #SPRITE_LRU_END.
 	SpriteTypeByte type; ///< In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
 	bool warned;         ///< True iff the user has been warned about incorrect use of this sprite
 	byte container_ver;  ///< Container version of the GRF the sprite is from.
@@ -76,17 +79,92 @@ static SpriteCache *AllocateSpriteCache(uint index)
 }
 
 
+/** End marker of the list of cached sprites ordered by their use. */
+static const uint SPRITE_LRU_END = UINT_MAX;
+
+/**
+ * Sprites in the cache, except recolour sprites which are never evicted,
+ * are kept in a doubly linked list ordered by when they were last used.
+ */
+static uint _sprite_lru_head = SPRITE_LRU_END; ///< Most recently used sprite.
+static uint _sprite_lru_tail = SPRITE_LRU_END; ///< Least recently used sprite; the first to be evicted.
+
+/**
+ * Remove a sprite from the list of cached sprites.
+ * @param index The sprite.
+ */
+static void UnlinkSpriteLRU(uint index)
+{
+	SpriteCache *sc = GetSpriteCache(index);
+	if (sc->lru_prev != SPRITE_LRU_END) {
+		GetSpriteCache(sc->lru_prev)->lru_next = sc->lru_next;
+	} else {
+		_sprite_lru_head = sc->lru_next;
+	}
+	if (sc->lru_next != SPRITE_LRU_END) {
+		GetSpriteCache(sc->lru_next)->lru_prev = sc->lru_prev;
+	} else {
+		_sprite_lru_tail = sc->lru_prev;
+	}
+}
+
+/**
+ * Add a sprite to the list of cached sprites as the most recently used one.
+ * @param index The sprite.
+ */
+static void LinkSpriteLRU(uint index)
+{
+	SpriteCache *sc = GetSpriteCache(index);
+	sc->lru_prev = SPRITE_LRU_END;
+	sc->lru_next = _sprite_lru_head;
+	if (_sprite_lru_head != SPRITE_LRU_END) {
+		GetSpriteCache(_sprite_lru_head)->lru_prev = index;
+	} else {
+		_sprite_lru_tail = index;
+	}
+	_sprite_lru_head = index;
+}
+
+/**
+ * A block of memory of the sprite cache. Free blocks additionally have
+ * #FreeBlockLinks at the start of their data, and a copy of their size
+ * at their end so the block behind them can merge with them.
+ */
 struct MemBlock {
-	size_t size;
+	size_t size; ///< Size of the block including this header, combined with #S_FREE and #S_PREV_FREE.
 	byte data[];
 };
 
-static uint _sprite_lru_counter;
-static MemBlock *_spritecache_ptr;
-static uint _allocated_sprite_cache_size = 0;
-static int _compact_cache_counter;
+/** Links of a free block in the list of free blocks of its size class. */
+struct FreeBlockLinks {
+	MemBlock *prev; ///< Previous free block of the size class, or \c NULL.
+	MemBlock *next; ///< Next free block of the size class, or \c NULL.
+};
+
+/** Number of size classes of free blocks; class \c i holds blocks of at least 2^i and less than 2^(i+1) bytes. */
+static const uint NUM_SIZE_CLASSES = sizeof(size_t) * 8;
+
+/** Number of main loop iterations within which the least recently used sprite must have been used to grow the cache instead of evicting it. */
+static const uint SPRITE_CACHE_GROW_AGE = 64;
+/** Maximum size of the sprite cache, including what it grew by, in multiples of the configured size. */
+static const uint SPRITE_CACHE_MAX_GROWTH = 4;
 
-static void CompactSpriteCache();
+static uint _sprite_cache_loop;                        ///< Number of main loop iterations, see #IncreaseSpriteLRU.
+static MemBlock *_spritecache_ptr;                     ///< Memory of the sprite cache of the configured size.
+static uint _allocated_sprite_cache_size = 0;          ///< Size of #_spritecache_ptr.
+static SmallVector<MemBlock *, 4> _spritecache_growth; ///< Memory the sprite cache grew by beyond the configured size.
+static size_t _sprite_cache_total = 0;                 ///< Size of all memory of the sprite cache.
+static size_t _sprite_cache_used = 0;                  ///< Size of all blocks in use.
+static size_t _sprite_cache_high_water = 0;            ///< Highest #_sprite_cache_used since the cache was set up.
+static MemBlock *_free_blocks[NUM_SIZE_CLASSES];       ///< First free block of every size class.
+
+/** Maximum number of sprites waiting to be prefetched. */
+static const uint SPRITE_PREFETCH_QUEUE_SIZE = 4096;
+
+static SmallVector<SpriteID, 256> _sprite_prefetch_queue; ///< Sprites to load into the cache before they are drawn.
+static uint _sprite_prefetch_next = 0;                    ///< Index of the next sprite in #_sprite_prefetch_queue to load.
+
+static void DeleteEntryFromSpriteCache(uint item);
 static void *AllocSprite(size_t mem_req);
 
 /**
@@ -181,6 +259,21 @@ uint GetMaxSpriteID()
 	return _spritecache_items;
 }
 
+/**
+ * Tell how much memory the sprite cache uses.
+ * @param[out] used Bytes of the cache holding sprites.
+ * @param[out] total Bytes allocated for the cache, used or not.
+ * @param[out] high_water Highest number of bytes holding sprites since the cache was set up.
+ * @param[out] index Bytes of the table with the cache entries of all sprite IDs.
+ */
+void GetSpriteCacheUsage(size_t *used, size_t *total, size_t *high_water, size_t *index)
+{
+	*used = _sprite_cache_used;
+	*total = _sprite_cache_total;
+	*high_water = _sprite_cache_high_water;
+	*index = _spritecache_items * sizeof(SpriteCache);
+}
+
 static bool ResizeSpriteIn(SpriteLoader::Sprite *sprite, ZoomLevel src, ZoomLevel tgt)
 {
 	uint8 scaled_1 = ScaleByZoom(1, (ZoomLevel)(src - tgt));
@@ -575,10 +668,12 @@ bool LoadNextSprite(int load_index, byte file_slot, uint file_sprite_id, byte co
 	}
 
 	SpriteCache *sc = AllocateSpriteCache(load_index);
+	/* A sprite that is replaced must not stay in the list of cached sprites. */
+	if (sc->ptr != NULL && sc->type != ST_RECOLOUR) DeleteEntryFromSpriteCache(load_index);
 	sc->file_slot = file_slot;
 	sc->file_pos = file_pos;
 	sc->ptr = data;
-	sc->lru = 0;
+	sc->last_used = 0;
 	sc->id = file_sprite_id;
 	sc->type = type;
 	sc->warned = false;
@@ -593,6 +688,8 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	SpriteCache *scnew = AllocateSpriteCache(new_spr); // may reallocate: so put it first
 	SpriteCache *scold = GetSpriteCache(old_spr);
 
+	if (scnew->ptr != NULL && scnew->type != ST_RECOLOUR) DeleteEntryFromSpriteCache(new_spr);
+
 	scnew->file_slot = scold->file_slot;
 	scnew->file_pos = scold->file_pos;
 	scnew->ptr = NULL;
@@ -602,107 +699,122 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	scnew->container_ver = scold->container_ver;
 }
 
+/** Flag in MemBlock::size of a free block. */
+static const size_t S_FREE = 1;
+/** Flag in MemBlock::size of a block directly behind a free block. */
+static const size_t S_PREV_FREE = 2;
 /**
- * S_FREE_MASK is used to mask-out lower bits of MemBlock::size
- * If they are non-zero, the block is free.
- * S_FREE_MASK has to ensure MemBlock is correctly aligned -
- * it means 8B (S_FREE_MASK == 7) on 64bit systems!
+ * Bits of MemBlock::size that are not part of the size. Blocks are
+ * aligned to sizeof(size_t), which means 8B on 64bit systems!
  */
-static const size_t S_FREE_MASK = sizeof(size_t) - 1;
+static const size_t S_FLAG_MASK = sizeof(size_t) - 1;
+
+/** Smallest block; a free block has to hold its header, its links and the copy of its size. */
+static const size_t MIN_BLOCK_SIZE = sizeof(MemBlock) + sizeof(FreeBlockLinks) + sizeof(size_t);
 
-/* to make sure nobody adds things to MemBlock without checking S_FREE_MASK first */
+/* to make sure nobody adds things to MemBlock without checking S_FLAG_MASK first */
 assert_compile(sizeof(MemBlock) == sizeof(size_t));
 /* make sure it's a power of two */
 assert_compile((sizeof(size_t) & (sizeof(size_t) - 1)) == 0);
+/* make sure the flags fit, even on 32bit systems */
+assert_compile(((S_FREE | S_PREV_FREE) & ~S_FLAG_MASK) == 0);
 
-static inline MemBlock *NextBlock(MemBlock *block)
+static inline size_t BlockSize(const MemBlock *block)
 {
-	return (MemBlock*)((byte*)block + (block->size & ~S_FREE_MASK));
+	return block->size & ~S_FLAG_MASK;
 }
 
-static size_t GetSpriteCacheUsage()
+static inline MemBlock *NextBlock(MemBlock *block)
 {
-	size_t tot_size = 0;
-	MemBlock *s;
-
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (!(s->size & S_FREE_MASK)) tot_size += s->size;
-	}
-
-	return tot_size;
+	return (MemBlock*)((byte*)block + BlockSize(block));
 }
 
-
-void IncreaseSpriteLRU()
+static inline FreeBlockLinks *GetFreeBlockLinks(MemBlock *block)
 {
-	/* Increase all LRU values */
-	if (_sprite_lru_counter > 16384) {
-		SpriteID i;
-
-		DEBUG(sprite, 3, "Fixing lru %u, inuse=" PRINTF_SIZE, _sprite_lru_counter, GetSpriteCacheUsage());
+	return (FreeBlockLinks *)block->data;
+}
 
-		for (i = 0; i != _spritecache_items; i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->ptr != NULL) {
-				if (sc->lru >= 0) {
-					sc->lru = -1;
-				} else if (sc->lru != -32768) {
-					sc->lru--;
-				}
-			}
-		}
-		_sprite_lru_counter = 0;
-	}
+/**
+ * Mark a block free and add it to the free blocks of its size class.
+ * @param block The block; the block in front of it must be in use.
+ * @param size  The size of the block.
+ */
+static void LinkFreeBlock(MemBlock *block, size_t size)
+{
+	block->size = size | S_FREE;
+	*(size_t *)((byte *)block + size - sizeof(size_t)) = size;
+	NextBlock(block)->size |= S_PREV_FREE;
+
+	uint size_class = FindLastBit(size);
+	FreeBlockLinks *links = GetFreeBlockLinks(block);
+	links->prev = NULL;
+	links->next = _free_blocks[size_class];
+	if (links->next != NULL) GetFreeBlockLinks(links->next)->prev = block;
+	_free_blocks[size_class] = block;
+}
 
-	/* Compact sprite cache every now and then. */
-	if (++_compact_cache_counter >= 740) {
-		CompactSpriteCache();
-		_compact_cache_counter = 0;
+/**
+ * Remove a block from the free blocks of its size class.
+ * @param block The free block.
+ */
+static void UnlinkFreeBlock(MemBlock *block)
+{
+	FreeBlockLinks *links = GetFreeBlockLinks(block);
+	if (links->prev != NULL) {
+		GetFreeBlockLinks(links->prev)->next = links->next;
+	} else {
+		_free_blocks[FindLastBit(BlockSize(block))] = links->next;
 	}
+	if (links->next != NULL) GetFreeBlockLinks(links->next)->prev = links->prev;
 }
 
 /**
- * Called when holes in the sprite cache should be removed.
- * That is accomplished by moving the cached data.
+ * Prepare memory of the sprite cache for use.
+ * @param mem  The memory.
+ * @param size The size of the memory; a multiple of the block alignment.
  */
-static void CompactSpriteCache()
+static void InitSpriteCacheMemory(MemBlock *mem, size_t size)
 {
-	MemBlock *s;
-
-	DEBUG(sprite, 3, "Compacting sprite cache, inuse=" PRINTF_SIZE, GetSpriteCacheUsage());
-
-	for (s = _spritecache_ptr; s->size != 0;) {
-		if (s->size & S_FREE_MASK) {
-			MemBlock *next = NextBlock(s);
-			MemBlock temp;
-			SpriteID i;
-
-			/* Since free blocks are automatically coalesced, this should hold true. */
-			assert(!(next->size & S_FREE_MASK));
-
-			/* If the next block is the sentinel block, we can safely return */
-			if (next->size == 0) break;
-
-			/* Locate the sprite belonging to the next pointer. */
-			for (i = 0; GetSpriteCache(i)->ptr != next->data; i++) {
-				assert(i != _spritecache_items);
-			}
+	/* Sentinel block (identified by size == 0) */
+	MemBlock *sentinel = (MemBlock *)((byte *)mem + size - sizeof(MemBlock));
+	sentinel->size = 0;
+	/* A big free block */
+	LinkFreeBlock(mem, size - sizeof(MemBlock));
+	_sprite_cache_total += size;
+}
 
-			GetSpriteCache(i)->ptr = s->data; // Adjust sprite array entry
-			/* Swap this and the next block */
-			temp = *s;
-			memmove(s, next, next->size);
-			s = NextBlock(s);
-			*s = temp;
+/**
+ * Advance the age of the sprites in the cache; called once per main loop iteration.
+ */
+void IncreaseSpriteLRU()
+{
+	_sprite_cache_loop++;
+}
 
-			/* Coalesce free blocks */
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		} else {
-			s = NextBlock(s);
-		}
+/**
+ * Return a block to the free memory, merging it with the free blocks around it.
+ * @param block The block, which must be in use.
+ */
+static void FreeSpriteBlock(MemBlock *block)
+{
+	assert(!(block->size & S_FREE));
+	size_t size = BlockSize(block);
+	_sprite_cache_used -= size;
+
+	MemBlock *next = NextBlock(block);
+	if (next->size & S_FREE) {
+		UnlinkFreeBlock(next);
+		size += BlockSize(next);
+	}
+	if (block->size & S_PREV_FREE) {
+		size_t prev_size = *((size_t *)block - 1);
+		block = (MemBlock *)((byte *)block - prev_size);
+		UnlinkFreeBlock(block);
+		size += prev_size;
 	}
+
+	/* Free blocks are always merged, so the block in front of this one is in use. */
+	LinkFreeBlock(block, size);
 }
 
 /**
@@ -711,79 +823,104 @@ static void CompactSpriteCache()
  */
 static void DeleteEntryFromSpriteCache(uint item)
 {
-	/* Mark the block as free (the block must be in use) */
-	MemBlock *s = (MemBlock*)GetSpriteCache(item)->ptr - 1;
-	assert(!(s->size & S_FREE_MASK));
-	s->size |= S_FREE_MASK;
-	GetSpriteCache(item)->ptr = NULL;
-
-	/* And coalesce adjacent free blocks */
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (s->size & S_FREE_MASK) {
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		}
-	}
+	SpriteCache *sc = GetSpriteCache(item);
+	FreeSpriteBlock((MemBlock*)sc->ptr - 1);
+	sc->ptr = NULL;
+	UnlinkSpriteLRU(item);
 }
 
+/** Evict the least recently used sprite from the sprite cache. */
 static void DeleteEntryFromSpriteCache()
 {
-	uint best = UINT_MAX;
-	int cur_lru;
+	DEBUG(sprite, 3, "DeleteEntryFromSpriteCache, inuse=" PRINTF_SIZE, _sprite_cache_used);
 
-	DEBUG(sprite, 3, "DeleteEntryFromSpriteCache, inuse=" PRINTF_SIZE, GetSpriteCacheUsage());
+	/* Display an error message and die, in case we found no sprite at all.
+	 * This shouldn't really happen, unless all sprites are locked. */
+	if (_sprite_lru_tail == SPRITE_LRU_END) error("Out of sprite memory");
 
-	cur_lru = 0xffff;
-	for (SpriteID i = 0; i != _spritecache_items; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->ptr != NULL && sc->lru < cur_lru) {
-			cur_lru = sc->lru;
-			best = i;
-		}
+	DeleteEntryFromSpriteCache(_sprite_lru_tail);
+}
+
+/**
+ * Try to add memory to the sprite cache instead of evicting sprites. That is
+ * only done on 64bit systems, up to #SPRITE_CACHE_MAX_GROWTH times the
+ * configured size, and when the sprite that would be evicted was used
+ * recently, i.e. when the sprites in use do not fit in the cache.
+ * @param mem_req Size of the block that has to fit.
+ * @return True if the cache grew.
+ */
+static bool GrowSpriteCache(size_t mem_req)
+{
+	if (sizeof(void *) < 8) return false;
+	if (_sprite_lru_tail != SPRITE_LRU_END && _sprite_cache_loop - GetSpriteCache(_sprite_lru_tail)->last_used > SPRITE_CACHE_GROW_AGE) return false;
+
+	size_t size = max<size_t>(_allocated_sprite_cache_size / 4, Align(mem_req + sizeof(MemBlock), S_FLAG_MASK + 1));
+	if (_sprite_cache_total + size > (size_t)_allocated_sprite_cache_size * SPRITE_CACHE_MAX_GROWTH) return false;
+
+	MemBlock *mem;
+	try {
+		mem = reinterpret_cast<MemBlock *>(new byte[size]);
+	} catch (std::bad_alloc &) {
+		return false;
 	}
+	*_spritecache_growth.Append() = mem;
+	InitSpriteCacheMemory(mem, size);
 
-	/* Display an error message and die, in case we found no sprite at all.
-	 * This shouldn't really happen, unless all sprites are locked. */
-	if (best == UINT_MAX) error("Out of sprite memory");
+	DEBUG(sprite, 1, "Sprite cache grew to " PRINTF_SIZE " KiB, high water mark " PRINTF_SIZE " KiB", _sprite_cache_total / 1024, _sprite_cache_high_water / 1024);
+	return true;
+}
 
-	DeleteEntryFromSpriteCache(best);
+/**
+ * Find a free block of at least the given size and remove it from the free blocks.
+ * @param mem_req The size of the block.
+ * @return The block, or \c NULL if there is none.
+ */
+static MemBlock *TakeFreeBlock(size_t mem_req)
+{
+	/* Blocks from the size class of the request may be too small; those of larger classes always fit. */
+	for (uint size_class = FindLastBit(mem_req); size_class < NUM_SIZE_CLASSES; size_class++) {
+		for (MemBlock *block = _free_blocks[size_class]; block != NULL; block = GetFreeBlockLinks(block)->next) {
+			if (BlockSize(block) >= mem_req) {
+				UnlinkFreeBlock(block);
+				return block;
+			}
+		}
+	}
+	return NULL;
 }
 
 static void *AllocSprite(size_t mem_req)
 {
 	mem_req += sizeof(MemBlock);
 
-	/* Align this to correct boundary. This also makes sure at least one
-	 * bit is not used, so we can use it for other things. */
-	mem_req = Align(mem_req, S_FREE_MASK + 1);
+	/* Align this to correct boundary. This also makes sure the flag
+	 * bits are not used by the size. */
+	mem_req = max(Align(mem_req, S_FLAG_MASK + 1), MIN_BLOCK_SIZE);
 
 	for (;;) {
-		MemBlock *s;
-
-		for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-			if (s->size & S_FREE_MASK) {
-				size_t cur_size = s->size & ~S_FREE_MASK;
-
-				/* Is the block exactly the size we need or
-				 * big enough for an additional free block? */
-				if (cur_size == mem_req ||
-						cur_size >= mem_req + sizeof(MemBlock)) {
-					/* Set size and in use */
-					s->size = mem_req;
-
-					/* Do we need to inject a free block too? */
-					if (cur_size != mem_req) {
-						NextBlock(s)->size = (cur_size - mem_req) | S_FREE_MASK;
-					}
-
-					return s->data;
-				}
+		MemBlock *s = TakeFreeBlock(mem_req);
+
+		if (s != NULL) {
+			size_t cur_size = BlockSize(s);
+
+			/* Is the block big enough for an additional free block? */
+			if (cur_size - mem_req >= MIN_BLOCK_SIZE) {
+				LinkFreeBlock((MemBlock *)((byte *)s + mem_req), cur_size - mem_req);
+				cur_size = mem_req;
+			} else {
+				NextBlock(s)->size &= ~S_PREV_FREE;
 			}
+
+			/* Set size and in use */
+			s->size = cur_size;
+
+			_sprite_cache_used += cur_size;
+			_sprite_cache_high_water = max(_sprite_cache_high_water, _sprite_cache_used);
+			return s->data;
 		}
 
-		/* Reached sentinel, but no block found yet. Delete some old entry. */
-		DeleteEntryFromSpriteCache();
+		/* No block found. Add memory or delete some old entry. */
+		if (!GrowSpriteCache(mem_req)) DeleteEntryFromSpriteCache();
 	}
 }
 
@@ -859,11 +996,17 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	if (allocator == NULL) {
 		/* Load sprite into/from spritecache */
 
-		/* Update LRU */
-		sc->lru = ++_sprite_lru_counter;
+		sc->last_used = _sprite_cache_loop;
 
-		/* Load the sprite, if it is not loaded, yet */
-		if (sc->ptr == NULL) sc->ptr = ReadSprite(sc, sprite, type, AllocSprite);
+		if (sc->ptr == NULL) {
+			/* Load the sprite, if it is not loaded, yet */
+			sc->ptr = ReadSprite(sc, sprite, type, AllocSprite);
+			if (sc->ptr != NULL) LinkSpriteLRU(sprite);
+		} else if (type != ST_RECOLOUR && _sprite_lru_head != sprite) {
+			/* Update LRU */
+			UnlinkSpriteLRU(sprite);
+			LinkSpriteLRU(sprite);
+		}
 
 		return sc->ptr;
 	} else {
@@ -872,6 +1015,51 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	}
 }
 
+/**
+ * Queue a sprite for being loaded into the sprite cache before it is drawn.
+ * Sprites that are cached already, or are not normal sprites, are ignored.
+ * @param sprite The sprite, without palette modifier bits.
+ * @see ProcessSpritePrefetchQueue
+ */
+void PrefetchSprite(SpriteID sprite)
+{
+	if (!SpriteExists(sprite) || _sprite_prefetch_queue.Length() >= SPRITE_PREFETCH_QUEUE_SIZE) return;
+
+	const SpriteCache *sc = GetSpriteCache(sprite);
+	if (sc->ptr != NULL || sc->type != ST_NORMAL) return;
+
+	*_sprite_prefetch_queue.Append() = sprite;
+}
+
+/**
+ * Load the next sprite queued by #PrefetchSprite into the sprite cache.
+ * Nothing is loaded when the cache is nearly full and its least recently
+ * used sprite is still in use, as prefetching would then only evict sprites
+ * that are needed sooner.
+ * @return True if a sprite was loaded, false if there is nothing (more) to load.
+ */
+bool ProcessSpritePrefetchQueue()
+{
+	if (_sprite_cache_used > _sprite_cache_total / 4 * 3 && _sprite_lru_tail != SPRITE_LRU_END &&
+			_sprite_cache_loop - GetSpriteCache(_sprite_lru_tail)->last_used <= SPRITE_CACHE_GROW_AGE) {
+		_sprite_prefetch_queue.Clear();
+		_sprite_prefetch_next = 0;
+		return false;
+	}
+
+	while (_sprite_prefetch_next < _sprite_prefetch_queue.Length()) {
+		SpriteID sprite = _sprite_prefetch_queue[_sprite_prefetch_next++];
+		if (GetSpriteCache(sprite)->ptr != NULL) continue;
+
+		GetRawSprite(sprite, ST_NORMAL);
+		return true;
+	}
+
+	_sprite_prefetch_queue.Clear();
+	_sprite_prefetch_next = 0;
+	return false;
+}
+
 
 static void GfxInitSpriteCache()
 {
@@ -882,6 +1070,16 @@ static void GfxInitSpriteCache()
 	/* Remember 'target_size' from the previous allocation attempt, so we do not try to reach the target_size multiple times in case of failure. */
 	static uint last_alloc_attempt = 0;
 
+	if (_sprite_cache_high_water != 0) {
+		DEBUG(sprite, 1, "Sprite cache of " PRINTF_SIZE " KiB reset, high water mark " PRINTF_SIZE " KiB", _sprite_cache_total / 1024, _sprite_cache_high_water / 1024);
+	}
+
+	/* Release the memory the cache grew by. */
+	for (MemBlock **mem = _spritecache_growth.Begin(); mem != _spritecache_growth.End(); mem++) {
+		delete[] reinterpret_cast<byte *>(*mem);
+	}
+	_spritecache_growth.Clear();
+
 	if (_spritecache_ptr == NULL || (_allocated_sprite_cache_size != target_size && target_size != last_alloc_attempt)) {
 		delete[] reinterpret_cast<byte *>(_spritecache_ptr);
 
@@ -918,10 +1116,11 @@ static void GfxInitSpriteCache()
 		}
 	}
 
-	/* A big free block */
-	_spritecache_ptr->size = (_allocated_sprite_cache_size - sizeof(MemBlock)) | S_FREE_MASK;
-	/* Sentinel block (identified by size == 0) */
-	NextBlock(_spritecache_ptr)->size = 0;
+	MemSetT(_free_blocks, 0, lengthof(_free_blocks));
+	_sprite_cache_total = 0;
+	_sprite_cache_used = 0;
+	_sprite_cache_high_water = 0;
+	InitSpriteCacheMemory(_spritecache_ptr, _allocated_sprite_cache_size);
 }
 
 void GfxInitSpriteMem()
@@ -932,8 +1131,10 @@ void GfxInitSpriteMem()
 	free(_spritecache);
 	_spritecache_items = 0;
 	_spritecache = NULL;
-
-	_compact_cache_counter = 0;
+	_sprite_lru_head = SPRITE_LRU_END;
+	_sprite_lru_tail = SPRITE_LRU_END;
+	_sprite_prefetch_queue.Clear();
+	_sprite_prefetch_next = 0;
 }
 
 /**
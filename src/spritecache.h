@@ -34,6 +34,7 @@ SpriteType GetSpriteType(SpriteID sprite);
 uint GetOriginFileSlot(SpriteID sprite);
 uint GetSpriteCountForSlot(uint file_slot, SpriteID begin, SpriteID end);
 uint GetMaxSpriteID();
+void GetSpriteCacheUsage(size_t *used, size_t *total, size_t *high_water, size_t *index);
 
 
 static inline const Sprite *GetSprite(SpriteID sprite, SpriteType type)
@@ -48,6 +49,9 @@ static inline const byte *GetNonSprite(SpriteID sprite, SpriteType type)
 	return (byte*)GetRawSprite(sprite, type);
 }
 
+void PrefetchSprite(SpriteID sprite);
+bool ProcessSpritePrefetchQueue();
+
 void GfxInitSpriteMem();
 void GfxClearSpriteCache();
 void IncreaseSpriteLRU();
@@ -40,7 +40,9 @@ INSTANTIATE_POOL_METHODS(Station)
 
 
 StationKdtree _station_kdtree(Kdtree_StationXYFunc);
+StationKdtree _airport_kdtree(Kdtree_AirportXYFunc);
 
+/** Rebuild the k-d trees of all stations and of the stations with an airport. */
 void RebuildStationKdtree()
 {
 	std::vector<StationID> stids;
@@ -49,6 +51,13 @@ void RebuildStationKdtree()
 		stids.push_back(st->index);
 	}
 	_station_kdtree.Build(stids.begin(), stids.end());
+
+	std::vector<StationID> airport_ids;
+	Station *airport_st;
+	FOR_ALL_STATIONS(airport_st) {
+		if (airport_st->facilities & FACIL_AIRPORT) airport_ids.push_back(airport_st->index);
+	}
+	_airport_kdtree.Build(airport_ids.begin(), airport_ids.end());
 }
 
 
@@ -73,6 +82,7 @@ Station::Station(TileIndex tile) :
 	truck_station(INVALID_TILE, 0, 0),
 	dock_tile(INVALID_TILE),
 	indtype(IT_INVALID),
+	acceptance_cache_valid(false),
 	time_since_load(255),
 	time_since_unload(255),
 	last_vehicle_type(VEH_INVALID)
@@ -118,6 +128,7 @@ Station::~Station()
 				RerouteCargo(st, c, this->index, st->index);
 			}
 		}
+		FlushCargoReroutes();
 		lg->RemoveNode(this->goods[c].node);
 		if (lg->Size() == 0) {
 			LinkGraphSchedule::instance.Unqueue(lg);
@@ -414,6 +425,7 @@ bool Station::CatchmentCoversTown(TownID t) const
  */
 void Station::RecomputeCatchment()
 {
+	this->acceptance_cache_valid = false;
 	this->industries_near.clear();
 	this->RemoveFromAllNearbyLists();
 
@@ -20,8 +20,10 @@
 #include "linkgraph/linkgraph_type.h"
 #include "newgrf_storage.h"
 #include "bitmap_type.h"
+#include "core/flatmap_type.hpp"
 #include <map>
 #include <set>
+#include <vector>
 
 typedef Pool<BaseStation, StationID, 32, 64000> StationPool;
 extern StationPool _station_pool;
@@ -30,24 +32,18 @@ static const byte INITIAL_STATION_RATING = 175;
 
 /**
  * Flow statistics telling how much flow should be sent along a link. This is
- * done by creating "flow shares" and using std::map's upper_bound() method to
+ * done by creating "flow shares" and using the shares map's upper_bound() method to
  * look them up with a random number. A flow share is the difference between a
  * key in a map and the previous key. So one key in the map doesn't actually
- * mean anything by itself.
+ * mean anything by itself. The keys are thus the prefix sums of the shares,
+ * kept in a flat sorted vector to make the lookups cheap.
  */
 class FlowStat {
 public:
-	typedef std::map<uint32, StationID> SharesMap;
+	typedef FlatMap<uint32, StationID> SharesMap;
 
 	static const SharesMap empty_sharesmap;
 
-	/**
-	 * Invalid constructor. This can't be called as a FlowStat must not be
-	 * empty. However, the constructor must be defined and reachable for
-	 * FlwoStat to be used in a std::map.
-	 */
-	inline FlowStat() {NOT_REACHED();}
-
 	/**
 	 * Create a FlowStat with an initial entry.
 	 * @param st Station the initial entry refers to.
@@ -57,7 +53,7 @@ public:
 	inline FlowStat(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[flow] = st;
+		this->shares.insert(SharesMap::value_type(flow, st));
 		this->unrestricted = restricted ? 0 : flow;
 	}
 
@@ -72,7 +68,7 @@ public:
 	inline void AppendShare(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[(--this->shares.end())->first + flow] = st;
+		this->shares.insert(SharesMap::value_type(this->shares.rbegin()->first + flow, st));
 		if (!restricted) this->unrestricted += flow;
 	}
 
@@ -150,8 +146,11 @@ private:
 	uint unrestricted; ///< Limit for unrestricted shares.
 };
 
-/** Flow descriptions by origin stations. */
-class FlowStatMap : public std::map<StationID, FlowStat> {
+/**
+ * Flow descriptions by origin stations, in a flat map sorted by origin.
+ * @note Changing the map invalidates iterators and pointers to its flows.
+ */
+class FlowStatMap : public FlatMap<StationID, FlowStat> {
 public:
 	uint GetFlow() const;
 	uint GetFlowVia(StationID via) const;
@@ -222,7 +221,9 @@ struct GoodsEntry {
 		amount_fract(0),
 		link_graph(INVALID_LINK_GRAPH),
 		node(INVALID_NODE),
-		max_waiting_cargo(0)
+		max_waiting_cargo(0),
+		rating_cache_key(0),
+		rating_cache_value(0)
 	{}
 
 	byte status; ///< Status of this cargo, see #GoodsEntryStatus.
@@ -261,6 +262,9 @@ struct GoodsEntry {
 	FlowStatMap flows;      ///< Planned flows through this station.
 	uint max_waiting_cargo; ///< Max cargo from this station waiting at any station.
 
+	uint64 rating_cache_key;  ///< Inputs of the last computed rating target, 0 if there is none.
+	int16 rating_cache_value; ///< Rating target computed for #rating_cache_key, including the result of the rating callback.
+
 	/**
 	 * Reports whether a vehicle has ever tried to load the cargo at this station.
 	 * This does not imply that there was cargo available for loading. Refer to GES_RATING for that.
@@ -463,6 +467,9 @@ public:
 	RoadStop *truck_stops;  ///< All the truck stops
 	TileArea truck_station; ///< Tile area the truck 'station' part covers
 
+	mutable TileArea road_stop_index_area[ROADSTOP_END];       ///< NOSAVE: Tile area covered by #road_stop_index, per road stop type
+	mutable std::vector<RoadStopID> road_stop_index[ROADSTOP_END]; ///< NOSAVE: Road stop of each tile of #road_stop_index_area, rebuilt on demand. @see RoadStop::GetByTile
+
 	Airport airport;        ///< Tile area the airport covers
 	TileIndex dock_tile;    ///< The location of the dock
 
@@ -470,6 +477,11 @@ public:
 
 	BitmapTileArea catchment_tiles; ///< NOSAVE: Set of individual tiles covered by catchment area
 
+	CargoArray cached_acceptance;            ///< NOSAVE: Acceptance of the houses without acceptance callbacks in the catchment area
+	CargoTypes cached_always_accepted;       ///< NOSAVE: Cargo types always accepted by those houses
+	std::vector<TileIndex> acceptance_tiles; ///< NOSAVE: All other tiles in the catchment area that may accept cargo
+	bool acceptance_cache_valid;             ///< NOSAVE: Whether the cached acceptance and #acceptance_tiles are up to date
+
 	StationHadVehicleOfTypeByte had_vehicle_of_type;
 
 	byte time_since_load;
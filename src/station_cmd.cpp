@@ -27,6 +27,8 @@
 #include "newgrf_station.h"
 #include "newgrf_canal.h" /* For the buoy */
 #include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/road_regions.h"
+#include "pathfinder/water_regions.h"
 #include "road_internal.h" /* For drawing catenary/checking road removal */
 #include "autoslope.h"
 #include "water.h"
@@ -55,6 +57,7 @@
 #include "linkgraph/linkgraph_base.h"
 #include "linkgraph/refresh.h"
 #include "widgets/station_widget.h"
+#include "core/scratch_alloc_type.hpp"
 
 #include "table/strings.h"
 
@@ -363,7 +366,10 @@ static Station *GetClosestDeletedStation(TileIndex tile)
 	uint threshold = 8;
 
 	Station *best_station = NULL;
-	ForAllStationsRadius(tile, threshold, [&](Station *st) {
+	ForAllStationsRadius(tile, threshold, [&](TileIndex sign_tile) {
+		/* Stations further away than the best one found so far cannot win. */
+		return DistanceManhattan(tile, sign_tile) <= threshold;
+	}, [&](Station *st) {
 		if (!st->IsInUse() && st->owner == _current_company) {
 			uint cur_dist = DistanceManhattan(tile, st->xy);
 
@@ -565,24 +571,74 @@ CargoArray GetAcceptanceAroundTiles(TileIndex tile, int w, int h, int rad, Cargo
 	return acceptance;
 }
 
+/**
+ * Scan the catchment area of a station for tiles that may accept cargo. The
+ * acceptance of houses without acceptance callbacks only changes when they are
+ * built or removed, so it is summed up once. All other tiles with an
+ * acceptance are remembered, as their acceptance may change any time.
+ * @param st Station to scan the catchment area of.
+ */
+static void RebuildAcceptanceCache(Station *st)
+{
+	st->cached_acceptance.Clear();
+	st->cached_always_accepted = 0;
+	st->acceptance_tiles.clear();
+
+	BitmapTileIterator it(st->catchment_tiles);
+	for (TileIndex tile = it; tile != INVALID_TILE; tile = ++it) {
+		if (IsTileType(tile, MP_HOUSE)) {
+			const HouseSpec *hs = HouseSpec::Get(GetHouseType(tile));
+			if (!HasBit(hs->callback_mask, CBM_HOUSE_ACCEPT_CARGO) && !HasBit(hs->callback_mask, CBM_HOUSE_CARGO_ACCEPTANCE)) {
+				AddAcceptedCargo(tile, st->cached_acceptance, &st->cached_always_accepted);
+				continue;
+			}
+		}
+		if (_tile_type_procs[GetTileType(tile)]->add_accepted_cargo_proc != NULL) st->acceptance_tiles.push_back(tile);
+	}
+
+	st->acceptance_cache_valid = true;
+}
+
 /**
  * Get the acceptance of cargoes around the station in.
  * @param st Station to get acceptance of.
  * @param always_accepted bitmask of cargo accepted by houses and headquarters; can be NULL
  */
-static CargoArray GetAcceptanceAroundStation(const Station *st, CargoTypes *always_accepted)
+static CargoArray GetAcceptanceAroundStation(Station *st, CargoTypes *always_accepted)
 {
-	CargoArray acceptance;
-	if (always_accepted != NULL) *always_accepted = 0;
+	if (!st->acceptance_cache_valid) RebuildAcceptanceCache(st);
 
-	BitmapTileIterator it(st->catchment_tiles);
-	for (TileIndex tile = it; tile != INVALID_TILE; tile = ++it) {
-		AddAcceptedCargo(tile, acceptance, always_accepted);
+	CargoArray acceptance = st->cached_acceptance;
+	if (always_accepted != NULL) *always_accepted = st->cached_always_accepted;
+
+	for (std::vector<TileIndex>::const_iterator it(st->acceptance_tiles.begin()); it != st->acceptance_tiles.end(); ++it) {
+		AddAcceptedCargo(*it, acceptance, always_accepted);
 	}
 
 	return acceptance;
 }
 
+/**
+ * Make all stations near some tiles scan their catchment area for the
+ * acceptance again. This has to be done when tiles that accept cargo are added
+ * or houses are removed there.
+ * @param area The changed tiles.
+ */
+void InvalidateStationAcceptanceCache(const TileArea &area)
+{
+	if (Station::GetNumItems() == 0) return;
+
+	uint x = TileX(area.tile);
+	uint y = TileY(area.tile);
+	uint max_c = _settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED;
+	TileArea ta(TileXY(max<int>(0, x - max_c), max<int>(0, y - max_c)), TileXY(min<int>(MapMaxX(), x + area.w + max_c), min<int>(MapMaxY(), y + area.h + max_c)));
+	TILE_AREA_LOOP(tile, ta) {
+		if (!IsTileType(tile, MP_STATION)) continue;
+		Station *st = Station::GetIfValid(GetStationIndex(tile));
+		if (st != NULL) st->acceptance_cache_valid = false;
+	}
+}
+
 /**
  * Update the acceptance for a station.
  * @param st Station to update
@@ -1929,6 +1985,7 @@ CommandCost CmdBuildRoadStop(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 			}
 			Company::Get(st->owner)->infrastructure.station++;
 
+			InvalidateRoadRegion(cur_tile);
 			MarkTileDirtyByTile(cur_tile);
 		}
 	}
@@ -2028,6 +2085,7 @@ static CommandCost RemoveRoadStop(TileIndex tile, DoCommandFlag flags)
 		} else {
 			DoClearSquare(tile);
 		}
+		InvalidateRoadRegion(tile);
 
 		delete cur_stop;
 
@@ -2351,6 +2409,7 @@ CommandCost CmdBuildAirport(TileIndex tile, DoCommandFlag flags, uint32 p1, uint
 			AirportTileAnimationTrigger(st, iter, AAT_BUILT);
 		}
 
+		_airport_kdtree.Insert(st->index);
 		UpdateAirplanesOnNewStation(st);
 
 		Company::Get(st->owner)->infrastructure.airport++;
@@ -2429,6 +2488,7 @@ static CommandCost RemoveAirport(TileIndex tile, DoCommandFlag flags)
 
 		st->rect.AfterRemoveRect(st, st->airport);
 
+		_airport_kdtree.Remove(st->index);
 		st->airport.Clear();
 		st->facilities &= ~FACIL_AIRPORT;
 
@@ -2587,6 +2647,8 @@ CommandCost CmdBuildDock(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 		Company::Get(st->owner)->infrastructure.station += 2;
 
 		MakeDock(tile, st->owner, st->index, direction, wc);
+		InvalidateWaterRegion(tile);
+		InvalidateWaterRegion(tile + TileOffsByDiagDir(direction));
 
 		st->AfterStationTileSetChange(true, STATION_DOCK);
 	}
@@ -2617,6 +2679,7 @@ static CommandCost RemoveDock(TileIndex tile, DoCommandFlag flags)
 
 	if (flags & DC_EXEC) {
 		DoClearSquare(tile1);
+		InvalidateWaterRegion(tile1);
 		MarkTileDirtyByTile(tile1);
 		MakeWaterKeepingClass(tile2, st->owner);
 
@@ -3304,6 +3367,26 @@ static void TruncateCargo(const CargoSpec *cs, GoodsEntry *ge, uint amount = UIN
 	}
 }
 
+/**
+ * Add the parts of the station rating that don't depend on the rating callback.
+ * @param rating Rating so far.
+ * @param ge Goods entry the rating is for.
+ * @param statue Whether the owner of the station has a statue in the town.
+ * @return The rating with the bonuses.
+ */
+static int AddStationRatingBonuses(int rating, const GoodsEntry *ge, bool statue)
+{
+	if (statue) rating += 26;
+
+	byte age = ge->last_age;
+	(age >= 3) ||
+	(rating += 10, age >= 2) ||
+	(rating += 10, age >= 1) ||
+	(rating += 13, true);
+
+	return rating;
+}
+
 static void UpdateStationRating(Station *st)
 {
 	bool waiting_changed = false;
@@ -3349,7 +3432,17 @@ static void UpdateStationRating(Station *st)
 			 */
 			uint waiting_avg = waiting / (num_dests + 1);
 
-			if (HasBit(cs->callback_mask, CBM_CARGO_STATION_RATING_CALC)) {
+			/* The rating the current one moves towards only depends on these
+			 * values, so only compute it, including the NewGRF callback, if
+			 * one of them changed since the last time. */
+			bool statue = Company::IsValidID(st->owner) && HasBit(st->town->statues, st->owner);
+			uint64 rating_key = ge->time_since_pickup | (min(ge->max_waiting_cargo, 0xFFFF) << 8) | ((uint)ge->last_speed << 24) |
+					((uint64)st->last_vehicle_type << 32) | ((uint64)ge->last_age << 40) | ((uint64)statue << 48) | ((uint64)1 << 49);
+
+			if (ge->rating_cache_key == rating_key) {
+				rating = ge->rating_cache_value;
+				skip = true;
+			} else if (HasBit(cs->callback_mask, CBM_CARGO_STATION_RATING_CALC)) {
 				/* Perform custom station rating. If it succeeds the speed, days in transit and
 				 * waiting cargo ratings must not be executed. */
 
@@ -3361,11 +3454,13 @@ static void UpdateStationRating(Station *st)
 				uint32 var10 = (st->last_vehicle_type == VEH_INVALID) ? 0x0 : (st->last_vehicle_type + 0x10);
 				uint16 callback = GetCargoCallback(CBID_CARGO_STATION_RATING_CALC, var10, var18, cs);
 				if (callback != CALLBACK_FAILED) {
-					skip = true;
 					rating = GB(callback, 0, 14);
 
 					/* Simulate a 15 bit signed value */
 					if (HasBit(callback, 14)) rating -= 0x4000;
+
+					rating = AddStationRatingBonuses(rating, ge, statue);
+					skip = true;
 				}
 			}
 
@@ -3387,15 +3482,12 @@ static void UpdateStationRating(Station *st)
 				(rating += 10, ge->max_waiting_cargo > 300) ||
 				(rating += 20, ge->max_waiting_cargo > 100) ||
 				(rating += 10, true);
-			}
 
-			if (Company::IsValidID(st->owner) && HasBit(st->town->statues, st->owner)) rating += 26;
+				rating = AddStationRatingBonuses(rating, ge, statue);
+			}
 
-			byte age = ge->last_age;
-			(age >= 3) ||
-			(rating += 10, age >= 2) ||
-			(rating += 10, age >= 1) ||
-			(rating += 13, true);
+			ge->rating_cache_key = rating_key;
+			ge->rating_cache_value = rating;
 
 			{
 				int or_ = ge->rating; // old rating
@@ -3461,9 +3553,28 @@ static void UpdateStationRating(Station *st)
 	}
 }
 
+/** Station, cargo and additionally avoided station of queued reroutes. */
+struct CargoRerouteKey {
+	StationID station; ///< Station to reroute at.
+	CargoID cargo;     ///< Cargo to reroute.
+	StationID avoid2;  ///< Station to be avoided in addition to the next hops.
+
+	bool operator<(const CargoRerouteKey &other) const
+	{
+		if (this->station != other.station) return this->station < other.station;
+		if (this->cargo != other.cargo) return this->cargo < other.cargo;
+		return this->avoid2 < other.avoid2;
+	}
+};
+
+/** Next hops to reroute cargo away from, waiting for FlushCargoReroutes. */
+static std::map<CargoRerouteKey, StationIDSet> _cargo_reroutes;
+
 /**
  * Reroute cargo of type c at station st or in any vehicles unloading there.
  * Make sure the cargo's new next hop is neither "avoid" nor "avoid2".
+ * The cargo is only rerouted by the next FlushCargoReroutes, so that all
+ * reroutes at a station are done in one go.
  * @param st Station to be rerouted at.
  * @param c Type of cargo.
  * @param avoid Original next hop of cargo, avoid this.
@@ -3471,18 +3582,37 @@ static void UpdateStationRating(Station *st)
  */
 void RerouteCargo(Station *st, CargoID c, StationID avoid, StationID avoid2)
 {
-	GoodsEntry &ge = st->goods[c];
+	CargoRerouteKey key = { st->index, c, avoid2 };
+	_cargo_reroutes[key].insert(avoid);
+}
+
+/**
+ * Do all reroutes queued by RerouteCargo. Cargo waiting at the stations is
+ * rerouted per next hop; cargo staged for transfer in the vehicles loading there
+ * is rerouted for all next hops at once.
+ */
+void FlushCargoReroutes()
+{
+	for (std::map<CargoRerouteKey, StationIDSet>::const_iterator it(_cargo_reroutes.begin()); it != _cargo_reroutes.end(); ++it) {
+		const CargoRerouteKey &key = it->first;
+		Station *st = Station::GetIfValid(key.station);
+		if (st == NULL) continue;
+		GoodsEntry &ge = st->goods[key.cargo];
 
-	/* Reroute cargo in station. */
-	ge.cargo.Reroute(UINT_MAX, &ge.cargo, avoid, avoid2, &ge);
+		/* Reroute cargo in station. */
+		for (StationIDSet::const_iterator avoid(it->second.begin()); avoid != it->second.end(); ++avoid) {
+			ge.cargo.Reroute(UINT_MAX, &ge.cargo, *avoid, key.avoid2, &ge);
+		}
 
-	/* Reroute cargo staged to be transferred. */
-	for (std::list<Vehicle *>::iterator it(st->loading_vehicles.begin()); it != st->loading_vehicles.end(); ++it) {
-		for (Vehicle *v = *it; v != NULL; v = v->Next()) {
-			if (v->cargo_type != c) continue;
-			v->cargo.Reroute(UINT_MAX, &v->cargo, avoid, avoid2, &ge);
+		/* Reroute cargo staged to be transferred. */
+		for (std::list<Vehicle *>::iterator v_it(st->loading_vehicles.begin()); v_it != st->loading_vehicles.end(); ++v_it) {
+			for (Vehicle *v = *v_it; v != NULL; v = v->Next()) {
+				if (v->cargo_type != key.cargo) continue;
+				v->cargo.RerouteTransfers(it->second, key.avoid2, &ge);
+			}
 		}
 	}
+	_cargo_reroutes.clear();
 }
 
 /**
@@ -3533,11 +3663,14 @@ void DeleteStaleLinks(Station *from)
 						*(vehicles.Append()) = l->GetFirstSharedVehicle();
 					}
 
+					/* Vehicles sharing their orders often start at the same order with the
+					 * same consist; refreshing the links for those once is enough. */
+					LinkRefresher::RunSet done_runs;
 					Vehicle **iter = vehicles.Begin();
 					while (iter != vehicles.End()) {
 						Vehicle *v = *iter;
 
-						LinkRefresher::Run(v, false); // Don't allow merging. Otherwise lg might get deleted.
+						LinkRefresher::Run(v, false, false, &done_runs); // Don't allow merging. Otherwise lg might get deleted.
 						if (edge.LastUpdate() == _date) {
 							updated = true;
 							break;
@@ -3676,6 +3809,7 @@ void OnTick_Station()
 		/* Clean up the link graph about once a week. */
 		if (Station::IsExpected(st) && (_tick_counter + st->index) % STATION_LINKGRAPH_TICKS == 0) {
 			DeleteStaleLinks(Station::From(st));
+			FlushCargoReroutes();
 		};
 
 		/* Run STATION_ACCEPTANCE_TICKS = 250 tick interval trigger for station animation.
@@ -3700,8 +3834,13 @@ void StationMonthlyLoop()
 			GoodsEntry *ge = &st->goods[i];
 			SB(ge->status, GoodsEntry::GES_LAST_MONTH, 1, GB(ge->status, GoodsEntry::GES_CURRENT_MONTH, 1));
 			ClrBit(ge->status, GoodsEntry::GES_CURRENT_MONTH);
+			ge->cargo.Compact();
 		}
 	}
+
+	/* Vehicles compact their cargo every 32 days in their day proc. */
+	DEBUG(misc, 3, "Compacting cargo lists freed %u cargo packets this month, %u left", _cargo_packets_reclaimed, (uint)CargoPacket::GetNumItems());
+	_cargo_packets_reclaimed = 0;
 }
 
 
@@ -3845,7 +3984,7 @@ void FindStationsAroundTiles(const TileArea &location, StationList *stations, bo
 	uint x = TileX(location.tile);
 	uint y = TileY(location.tile);
 
-	std::set<StationID> seen_stations;
+	std::set<StationID, std::less<StationID>, ScratchAllocator<StationID> > seen_stations;
 
 	/* Scan an area around the building covering the maximum possible station
 	 * to find the possible nearby stations. */
@@ -3895,25 +4034,26 @@ uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, Sourc
 	uint best_rating1 = 0; // rating of st1
 	uint best_rating2 = 0; // rating of st2
 
+	/* Passengers are never served by just a truck stop, other cargo never by just a bus stop. */
+	const StationFacility unusable_facilities = IsCargoInClass(type, CC_PASSENGERS) ? FACIL_TRUCK_STOP : FACIL_BUS_STOP;
+	const bool selectgoods = _settings_game.order.selectgoods;
+
 	for (Station *st : *all_stations) {
 		/* Is the station reserved exclusively for somebody else? */
 		if (st->owner != OWNER_NONE && st->town->exclusive_counter > 0 && st->town->exclusivity != st->owner) continue;
 
-		if (st->goods[type].rating == 0) continue; // Lowest possible rating, better not to give cargo anymore
+		const GoodsEntry &ge = st->goods[type];
+		if (ge.rating == 0) continue; // Lowest possible rating, better not to give cargo anymore
 
-		if (_settings_game.order.selectgoods && !st->goods[type].HasVehicleEverTriedLoading()) continue; // Selectively servicing stations, and not this one
+		if (selectgoods && !ge.HasVehicleEverTriedLoading()) continue; // Selectively servicing stations, and not this one
 
-		if (IsCargoInClass(type, CC_PASSENGERS)) {
-			if (st->facilities == FACIL_TRUCK_STOP) continue; // passengers are never served by just a truck stop
-		} else {
-			if (st->facilities == FACIL_BUS_STOP) continue; // non-passengers are never served by just a bus stop
-		}
+		if (st->facilities == unusable_facilities) continue;
 
 		/* This station can be used, add it to st1/st2 */
-		if (st1 == NULL || st->goods[type].rating >= best_rating1) {
-			st2 = st1; best_rating2 = best_rating1; st1 = st; best_rating1 = st->goods[type].rating;
-		} else if (st2 == NULL || st->goods[type].rating >= best_rating2) {
-			st2 = st; best_rating2 = st->goods[type].rating;
+		if (st1 == NULL || ge.rating >= best_rating1) {
+			st2 = st1; best_rating2 = best_rating1; st1 = st; best_rating1 = ge.rating;
+		} else if (st2 == NULL || ge.rating >= best_rating2) {
+			st2 = st; best_rating2 = ge.rating;
 		}
 	}
 
@@ -3975,6 +4115,7 @@ void BuildOilRig(TileIndex tile)
 	st->dock_tile = tile;
 	st->facilities = FACIL_AIRPORT | FACIL_DOCK;
 	st->build_date = _date;
+	_airport_kdtree.Insert(st->index);
 
 	st->rect.BeforeAddTile(tile, StationRect::ADD_FORCE);
 
@@ -3991,6 +4132,7 @@ void DeleteOilRig(TileIndex tile)
 	MakeWaterKeepingClass(tile, OWNER_NONE);
 
 	st->dock_tile = INVALID_TILE;
+	if (st->facilities & FACIL_AIRPORT) _airport_kdtree.Remove(st->index);
 	st->airport.Clear();
 	st->facilities &= ~(FACIL_AIRPORT | FACIL_DOCK);
 	st->airport.flags = 0;
@@ -4274,6 +4416,7 @@ void FlowStat::Invalidate()
 {
 	assert(!this->shares.empty());
 	SharesMap new_shares;
+	new_shares.reserve(this->shares.size() + 1);
 	uint i = 0;
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		new_shares[++i] = it->second;
@@ -4299,6 +4442,7 @@ void FlowStat::ChangeShare(StationID st, int flow)
 	uint added_shares = 0;
 	uint last_share = 0;
 	SharesMap new_shares;
+	new_shares.reserve(this->shares.size() + 1);
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		if (it->second == st) {
 			if (flow < 0) {
@@ -4345,6 +4489,7 @@ void FlowStat::RestrictShare(StationID st)
 	uint flow = 0;
 	uint last_share = 0;
 	SharesMap new_shares;
+	new_shares.reserve(this->shares.size() + 1);
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		if (flow == 0) {
 			if (it->first > this->unrestricted) return; // Not present or already restricted.
@@ -4390,6 +4535,7 @@ void FlowStat::ReleaseShare(StationID st)
 	}
 	if (flow == 0) return;
 	SharesMap new_shares;
+	new_shares.reserve(this->shares.size() + 1);
 	new_shares[flow] = st;
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		if (it->second != st) {
@@ -4411,6 +4557,7 @@ void FlowStat::ScaleToMonthly(uint runtime)
 {
 	assert(runtime > 0);
 	SharesMap new_shares;
+	new_shares.reserve(this->shares.size() + 1);
 	uint share = 0;
 	for (SharesMap::iterator i = this->shares.begin(); i != this->shares.end(); ++i) {
 		share = max(share + 1, i->first * 30 / runtime);
@@ -4496,7 +4643,7 @@ StationIDStack FlowStatMap::DeleteFlows(StationID via)
 		s_flows.ChangeShare(via, INT_MIN);
 		if (s_flows.GetShares()->empty()) {
 			ret.Push(f_it->first);
-			this->erase(f_it++);
+			f_it = this->erase(f_it);
 		} else {
 			++f_it;
 		}
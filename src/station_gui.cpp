@@ -38,7 +38,9 @@
 
 #include "table/strings.h"
 
+#include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "safeguards.h"
@@ -158,7 +160,7 @@ protected:
 	static bool include_empty;            // whether we should include stations without waiting cargo
 	static const CargoTypes cargo_filter_max;
 	static CargoTypes cargo_filter;           // bitmap of cargo types to include
-	static const Station *last_station;
+	static std::map<StationID, std::string> sort_names; ///< Cached names for StationNameSorter, so GetString() is called only once per station and sort.
 
 	/* Constants for sorting stations */
 	static const StringID sorter_names[];
@@ -208,22 +210,27 @@ protected:
 		this->vscroll->SetCount(this->stations.Length()); // Update the scrollbar
 	}
 
-	/** Sort stations by their name */
-	static int CDECL StationNameSorter(const Station * const *a, const Station * const *b)
+	/**
+	 * Get the name of a station to sort by, from the cache if it is there.
+	 * @param st The station to get the name of.
+	 * @return The name of the station.
+	 */
+	static const char *GetSortName(const Station *st)
 	{
-		static char buf_cache[64];
-		char buf[64];
-
-		SetDParam(0, (*a)->index);
-		GetString(buf, STR_STATION_NAME, lastof(buf));
-
-		if (*b != last_station) {
-			last_station = *b;
-			SetDParam(0, (*b)->index);
-			GetString(buf_cache, STR_STATION_NAME, lastof(buf_cache));
+		std::map<StationID, std::string>::iterator it = sort_names.find(st->index);
+		if (it == sort_names.end()) {
+			char buf[64];
+			SetDParam(0, st->index);
+			GetString(buf, STR_STATION_NAME, lastof(buf));
+			it = sort_names.insert(std::make_pair(st->index, std::string(buf))).first;
 		}
+		return it->second.c_str();
+	}
 
-		int r = strnatcmp(buf, buf_cache); // Sort by name (natural sorting).
+	/** Sort stations by their name */
+	static int CDECL StationNameSorter(const Station * const *a, const Station * const *b)
+	{
+		int r = strnatcmp(GetSortName(*a), GetSortName(*b)); // Sort by name (natural sorting).
 		if (r == 0) return (*a)->index - (*b)->index;
 		return r;
 	}
@@ -293,10 +300,11 @@ protected:
 	/** Sort the stations list */
 	void SortStationsList()
 	{
-		if (!this->stations.Sort()) return;
+		bool sorted = this->stations.Sort();
 
-		/* Reset name sorter sort cache */
-		this->last_station = NULL;
+		/* Reset name sorter sort cache - station names could change */
+		this->sort_names.clear();
+		if (!sorted) return;
 
 		/* Set the modified widget dirty */
 		this->SetWidgetDirty(WID_STL_LIST);
@@ -655,7 +663,7 @@ byte CompanyStationsWindow::facilities = FACIL_TRAIN | FACIL_TRUCK_STOP | FACIL_
 bool CompanyStationsWindow::include_empty = true;
 const CargoTypes CompanyStationsWindow::cargo_filter_max = ALL_CARGOTYPES;
 CargoTypes CompanyStationsWindow::cargo_filter = ALL_CARGOTYPES;
-const Station *CompanyStationsWindow::last_station = NULL;
+std::map<StationID, std::string> CompanyStationsWindow::sort_names;
 
 /* Available station sorting functions */
 GUIStationList::SortFunction * const CompanyStationsWindow::sorter_funcs[] = {
@@ -19,14 +19,21 @@ inline uint16 Kdtree_StationXYFunc(StationID stid, int dim) { return (dim == 0)
 typedef Kdtree<StationID, decltype(&Kdtree_StationXYFunc), uint16, int> StationKdtree;
 extern StationKdtree _station_kdtree;
 
+inline uint16 Kdtree_AirportXYFunc(StationID stid, int dim) { return (dim == 0) ? TileX(Station::Get(stid)->airport.tile) : TileY(Station::Get(stid)->airport.tile); }
+/** K-d tree of the stations that have an airport, by the north tile of the airport. */
+extern StationKdtree _airport_kdtree;
+
 /**
- * Call a function on all stations whose sign is within a radius of a center tile.
+ * Call a function on all stations whose sign is within a radius of a center tile,
+ * and whose sign tile is accepted by a filter.
+ * The filter only gets the tile, so stations it rejects are never looked up.
  * @param center  Central tile to search around.
  * @param radius  Distance in both X and Y to search within.
+ * @param filter  Predicate taking the TileIndex of the station sign, returning whether to call \a func for the station.
  * @param func    The function to call, must take a single parameter which is Station*.
  */
-template <typename Func>
-void ForAllStationsRadius(TileIndex center, uint radius, Func func)
+template <typename Filter, typename Func>
+void ForAllStationsRadius(TileIndex center, uint radius, Filter filter, Func func)
 {
 	uint16 x1, y1, x2, y2;
 	x1 = (uint16)max<int>(0, TileX(center) - radius);
@@ -34,9 +41,23 @@ void ForAllStationsRadius(TileIndex center, uint radius, Func func)
 	y1 = (uint16)max<int>(0, TileY(center) - radius);
 	y2 = (uint16)min<int>(TileY(center) + radius + 1, MapSizeY());
 
-	_station_kdtree.FindContained(x1, y1, x2, y2, [&](StationID id) {
+	_station_kdtree.FindContained(x1, y1, x2, y2, [&](uint16 x, uint16 y) {
+		return filter(TileXY(x, y));
+	}, [&](StationID id) {
 		func(Station::Get(id));
 	});
 }
 
+/**
+ * Call a function on all stations whose sign is within a radius of a center tile.
+ * @param center  Central tile to search around.
+ * @param radius  Distance in both X and Y to search within.
+ * @param func    The function to call, must take a single parameter which is Station*.
+ */
+template <typename Func>
+void ForAllStationsRadius(TileIndex center, uint radius, Func func)
+{
+	ForAllStationsRadius(center, radius, [](TileIndex) { return true; }, func);
+}
+
 #endif
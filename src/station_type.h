@@ -13,6 +13,7 @@
 #define STATION_TYPE_H
 
 #include "core/smallstack_type.hpp"
+#include "core/flatset_type.hpp"
 #include "tilearea_type.h"
 #include <set>
 
@@ -27,6 +28,7 @@ struct Waypoint;
 
 static const StationID NEW_STATION = 0xFFFE;
 static const StationID INVALID_STATION = 0xFFFF;
+static const RoadStopID INVALID_ROADSTOP = 0xFFFF;
 
 typedef SmallStack<StationID, StationID, INVALID_STATION, 8, 0xFFFD> StationIDStack;
 
@@ -46,6 +48,7 @@ enum StationType {
 enum RoadStopType {
 	ROADSTOP_BUS,    ///< A standard stop for buses
 	ROADSTOP_TRUCK,  ///< A standard stop for trucks
+	ROADSTOP_END,    ///< End of valid types
 };
 
 /** The facilities a station might be having */
@@ -95,7 +98,10 @@ struct StationCompare {
 };
 
 /** List of stations */
-typedef std::set<Station *, StationCompare> StationList;
+typedef FlatSet<Station *, StationCompare> StationList;
+
+/** Set of station IDs */
+typedef std::set<StationID> StationIDSet;
 
 /**
  * Structure contains cached list of stations nearby. The list
@@ -30,6 +30,7 @@
 
 #include "widgets/statusbar_widget.h"
 
+#include "network/network_func.h"
 #include "table/strings.h"
 #include "table/sprites.h"
 
@@ -157,11 +158,19 @@ struct StatusBarWindow : Window {
 			}
 
 			case WID_S_MIDDLE:
+#ifdef ENABLE_NETWORK
+				uint progress;
+#endif /* ENABLE_NETWORK */
 				/* Draw status bar */
 				if (this->saving) { // true when saving is active
 					DrawString(r.left + WD_FRAMERECT_LEFT, r.right - WD_FRAMERECT_RIGHT, r.top + WD_FRAMERECT_TOP, STR_STATUSBAR_SAVING_GAME, TC_FROMSTRING, SA_HOR_CENTER);
 				} else if (_do_autosave) {
 					DrawString(r.left + WD_FRAMERECT_LEFT, r.right - WD_FRAMERECT_RIGHT, r.top + WD_FRAMERECT_TOP, STR_STATUSBAR_AUTOSAVE, TC_FROMSTRING, SA_HOR_CENTER);
+#ifdef ENABLE_NETWORK
+				} else if (NetworkGetCatchUpProgress(&progress)) {
+					SetDParam(0, progress);
+					DrawString(r.left + WD_FRAMERECT_LEFT, r.right - WD_FRAMERECT_RIGHT, r.top + WD_FRAMERECT_TOP, STR_STATUSBAR_CATCHING_UP, TC_FROMSTRING, SA_HOR_CENTER);
+#endif /* ENABLE_NETWORK */
 				} else if (_pause_mode != PM_UNPAUSED) {
 					DrawString(r.left + WD_FRAMERECT_LEFT, r.right - WD_FRAMERECT_RIGHT, r.top + WD_FRAMERECT_TOP, STR_STATUSBAR_PAUSED, TC_FROMSTRING, SA_HOR_CENTER);
 				} else if (this->ticker_scroll < TICKER_STOP && FindWindowById(WC_NEWS_WINDOW, 0) == NULL && _statusbar_news_item != NULL && _statusbar_news_item->string_id != 0) {
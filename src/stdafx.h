@@ -485,6 +485,13 @@ static inline void free(const void *ptr)
 #endif
 #endif
 
+/* Hint to fetch memory into the cache ahead of its use. */
+#if defined(__GNUC__)
+	#define PREFETCH(address) __builtin_prefetch(address)
+#else
+	#define PREFETCH(address)
+#endif
+
 #ifndef IGNORE_UNINITIALIZED_WARNING_START
 	#define IGNORE_UNINITIALIZED_WARNING_START
 	#define IGNORE_UNINITIALIZED_WARNING_STOP
@@ -176,7 +176,8 @@ uint StringData::VersionHashStr(uint hash, const char *s) const
  */
 uint StringData::Version() const
 {
-	uint hash = 0;
+	/* Starting value of the hash; change it when the encoding of the language files changes. */
+	uint hash = 1;
 
 	for (size_t i = 0; i < this->max_strings; i++) {
 		const LangString *ls = this->strings[i];
@@ -979,7 +980,7 @@ void LanguageWriter::WriteLang(const StringData &data)
 			const Case *casep;
 			const char *cmdp;
 
-			/* For undefined strings, just set that it's an empty string */
+			/* For undefined strings, just set that it's an empty string; other strings end with a zero, so they can be used straight from the file. */
 			if (ls == NULL) {
 				this->WriteLength(0);
 				continue;
@@ -1044,6 +1045,7 @@ void LanguageWriter::WriteLang(const StringData &data)
 
 			if (cmdp != NULL) PutCommandString(&buffer, cmdp);
 
+			buffer.AppendByte(0);
 			this->WriteLength(buffer.Length());
 			this->Write(buffer.Begin(), buffer.Length());
 			buffer.Clear();
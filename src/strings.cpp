@@ -39,6 +39,7 @@
 #	include "network/network_content_gui.h"
 #endif /* ENABLE_NETWORK */
 #include <stack>
+#include <string>
 
 #include "table/strings.h"
 #include "table/control_codes.h"
@@ -185,8 +186,9 @@ struct LanguagePack : public LanguagePackHeader {
 	char data[]; // list of strings
 };
 
-static char **_langpack_offs;
-static LanguagePack *_langpack;
+static const char **_langpack_offs;
+static const LanguagePack *_langpack; ///< The language file, mapped into memory.
+static size_t _langpack_len;          ///< Length of the mapped language file.
 static uint _langtab_num[TEXT_TAB_END];   ///< Offset into langpack offs
 static uint _langtab_start[TEXT_TAB_END]; ///< Offset into langpack offs
 static bool _scan_for_gender_data = false;  ///< Are we scanning for the gender of the current string? (instead of formatting it)
@@ -270,6 +272,91 @@ char *GetString(char *buffr, StringID string, const char *last)
 	return GetStringWithArgs(buffr, string, &_global_string_params, last);
 }
 
+/** A string formatted by #GetCachedString. */
+struct CachedString {
+	bool used;        ///< Whether this entry holds a string.
+	StringID string;  ///< The string that was formatted.
+	uint64 params[2]; ///< The parameters it was formatted with.
+	std::string text; ///< The formatted text.
+};
+
+static const uint STRING_CACHE_BUCKET_BITS = 11; ///< Number of bits of the parameter hash used to select a bucket of the string cache.
+static const uint STRING_CACHE_WAYS = 8;         ///< Number of strings each bucket of the string cache holds.
+
+/**
+ * Cache of strings formatted by #GetCachedString. Strings are put into a bucket
+ * by their first parameter only, so all strings of the same object can be
+ * invalidated at once.
+ */
+static CachedString _string_cache[1 << STRING_CACHE_BUCKET_BITS][STRING_CACHE_WAYS];
+static byte _string_cache_next_way[1 << STRING_CACHE_BUCKET_BITS]; ///< Entry of each bucket of the string cache to replace next.
+
+/**
+ * Get the bucket of the string cache for a first string parameter.
+ * @param param1 The first parameter.
+ * @return The index of the bucket.
+ */
+static inline uint GetStringCacheBucket(uint64 param1)
+{
+	return (uint)((param1 * 0x9E3779B97F4A7C15ULL) >> (64 - STRING_CACHE_BUCKET_BITS));
+}
+
+/**
+ * Get a string with two parameters formatted, from a cache if it has been
+ * formatted with the same parameters before. This is meant for strings that
+ * are drawn every frame, like the signs in the viewports.
+ * The parameters must be plain values (no string pointers), and whenever the
+ * text of the strings of an object can change, #InvalidateCachedStrings must
+ * be called with the first parameter.
+ * @param string The string to format.
+ * @param param1 The first parameter.
+ * @param param2 The second parameter.
+ * @return The formatted string; valid until the next call.
+ */
+const char *GetCachedString(StringID string, uint64 param1, uint64 param2)
+{
+	uint bucket = GetStringCacheBucket(param1);
+	CachedString *entries = _string_cache[bucket];
+	for (uint i = 0; i < STRING_CACHE_WAYS; i++) {
+		CachedString &cs = entries[i];
+		if (cs.used && cs.string == string && cs.params[0] == param1 && cs.params[1] == param2) return cs.text.c_str();
+	}
+
+	char buffer[DRAW_STRING_BUFFER];
+	SetDParam(0, param1);
+	SetDParam(1, param2);
+	GetString(buffer, string, lastof(buffer));
+
+	CachedString &cs = entries[_string_cache_next_way[bucket]];
+	_string_cache_next_way[bucket] = (_string_cache_next_way[bucket] + 1) % STRING_CACHE_WAYS;
+	cs.used = true;
+	cs.string = string;
+	cs.params[0] = param1;
+	cs.params[1] = param2;
+	cs.text = buffer;
+	return cs.text.c_str();
+}
+
+/**
+ * Forget the cached strings of an object, because their text could have changed.
+ * @param param1 The first string parameter the object is formatted with, usually its index.
+ */
+void InvalidateCachedStrings(uint64 param1)
+{
+	CachedString *entries = _string_cache[GetStringCacheBucket(param1)];
+	for (uint i = 0; i < STRING_CACHE_WAYS; i++) {
+		if (entries[i].params[0] == param1) entries[i].used = false;
+	}
+}
+
+/** Forget all cached strings, e.g. because the language changed. */
+void ClearStringCache()
+{
+	for (uint b = 0; b < lengthof(_string_cache); b++) {
+		for (uint i = 0; i < STRING_CACHE_WAYS; i++) _string_cache[b][i].used = false;
+	}
+}
+
 
 /**
  * This function is used to "bind" a C string to a OpenTTD dparam slot.
@@ -1717,29 +1804,23 @@ bool ReadLanguagePack(const LanguageMetadata *lang)
 {
 	/* Current language pack */
 	size_t len;
-	LanguagePack *lang_pack = (LanguagePack *)ReadFileToMem(lang->file, &len, 1U << 20);
+	const LanguagePack *lang_pack = (const LanguagePack *)MapFileToMem(lang->file, &len, 1U << 20);
 	if (lang_pack == NULL) return false;
 
-	/* End of read data (+ terminating zero added in ReadFileToMem()) */
-	const char *end = (char *)lang_pack + len + 1;
+	/* End of the mapped data */
+	const char *end = (const char *)lang_pack + len;
 
 	/* We need at least one byte of lang_pack->data */
 	if (end <= lang_pack->data || !lang_pack->IsValid()) {
-		free(lang_pack);
+		UnmapFileFromMem(lang_pack, len);
 		return false;
 	}
 
-#if TTD_ENDIAN == TTD_BIG_ENDIAN
-	for (uint i = 0; i < TEXT_TAB_END; i++) {
-		lang_pack->offsets[i] = ReadLE16Aligned(&lang_pack->offsets[i]);
-	}
-#endif /* TTD_ENDIAN == TTD_BIG_ENDIAN */
-
 	uint count = 0;
 	for (uint i = 0; i < TEXT_TAB_END; i++) {
-		uint16 num = lang_pack->offsets[i];
+		uint16 num = FROM_LE16(lang_pack->offsets[i]);
 		if (num > TAB_SIZE) {
-			free(lang_pack);
+			UnmapFileFromMem(lang_pack, len);
 			return false;
 		}
 
@@ -1749,39 +1830,46 @@ bool ReadLanguagePack(const LanguageMetadata *lang)
 	}
 
 	/* Allocate offsets */
-	char **langpack_offs = MallocT<char *>(count);
+	const char **langpack_offs = MallocT<const char *>(count);
 
-	/* Fill offsets */
-	char *s = lang_pack->data;
-	len = (byte)*s++;
+	/* Fill offsets. Strgen terminates the strings with a zero, so they are
+	 * used straight from the mapped file and its pages are never written. */
+	const char *s = lang_pack->data;
 	for (uint i = 0; i < count; i++) {
-		if (s + len >= end) {
-			free(lang_pack);
+		if (s >= end) {
+			UnmapFileFromMem(lang_pack, len);
 			free(langpack_offs);
 			return false;
 		}
-		if (len >= 0xC0) {
-			len = ((len & 0x3F) << 8) + (byte)*s++;
-			if (s + len >= end) {
-				free(lang_pack);
+		size_t slen = (byte)*s++;
+		if (slen >= 0xC0) {
+			if (s >= end) {
+				UnmapFileFromMem(lang_pack, len);
 				free(langpack_offs);
 				return false;
 			}
+			slen = ((slen & 0x3F) << 8) + (byte)*s++;
+		}
+		if ((size_t)(end - s) < slen || (slen > 0 && s[slen - 1] != '\0')) {
+			UnmapFileFromMem(lang_pack, len);
+			free(langpack_offs);
+			return false;
 		}
-		langpack_offs[i] = s;
-		s += len;
-		len = (byte)*s;
-		*s++ = '\0'; // zero terminate the string
+		/* Undefined strings have no data at all. */
+		langpack_offs[i] = slen > 0 ? s : "";
+		s += slen;
 	}
 
-	free(_langpack);
+	UnmapFileFromMem(_langpack, _langpack_len);
 	_langpack = lang_pack;
+	_langpack_len = len;
 
 	free(_langpack_offs);
 	_langpack_offs = langpack_offs;
 
 	_current_language = lang;
 	_current_text_dir = (TextDirection)_current_language->text_dir;
+	ClearStringCache();
 	const char *c_file = strrchr(_current_language->file, PATHSEPCHAR) + 1;
 	strecpy(_config_language_file, c_file, lastof(_config_language_file));
 	SetCurrentGrfLangID(_current_language->newgrflangid);
@@ -177,6 +177,10 @@ char *GetString(char *buffr, StringID string, const char *last);
 char *GetStringWithArgs(char *buffr, StringID string, StringParameters *args, const char *last, uint case_index = 0, bool game_script = false);
 const char *GetStringPtr(StringID string);
 
+const char *GetCachedString(StringID string, uint64 param1, uint64 param2);
+void InvalidateCachedStrings(uint64 param1);
+void ClearStringCache();
+
 uint ConvertKmhishSpeedToDisplaySpeed(uint speed);
 uint ConvertDisplaySpeedToKmhishSpeed(uint speed);
 
@@ -16,6 +16,7 @@
 #include "genworld.h"
 #include "core/random_func.hpp"
 #include "landscape_type.h"
+#include "thread/thread_pool.h"
 
 #include "safeguards.h"
 
@@ -200,6 +201,9 @@ static HeightMap _height_map = {NULL, 0, 0, 0, 0};
 #define A2H(a) ((a) >> (amplitude_decimal_bits - height_decimal_bits))
 
 
+/** Number of height map rows (or columns) handed to a worker thread at once. */
+static const uint HEIGHT_MAP_ROWS_PER_CHUNK = 16;
+
 /** Walk through all items of _height_map.h */
 #define FOR_ALL_TILES_IN_HEIGHT(h) for (h = _height_map.h; h < &_height_map.h[_height_map.total_size]; h++)
 
@@ -443,12 +447,25 @@ static int *HeightMapMakeHistogram(height_t h_min, height_t h_max, int *hist_buf
 	return hist;
 }
 
-/** Applies sine wave redistribution onto height map */
-static void HeightMapSineTransform(height_t h_min, height_t h_max)
+/** Range of heights a height map transformation works on. */
+struct HeightMapRange {
+	height_t h_min; ///< Lowest height of the range.
+	height_t h_max; ///< Highest height of the range.
+};
+
+/**
+ * Applies sine wave redistribution onto some rows of the height map.
+ * @param data  The #HeightMapRange to transform within.
+ * @param first First row to transform.
+ * @param last  One past the last row to transform.
+ */
+static void HeightMapSineTransformRows(void *data, uint first, uint last)
 {
-	height_t *h;
+	const height_t h_min = ((const HeightMapRange *)data)->h_min;
+	const height_t h_max = ((const HeightMapRange *)data)->h_max;
+	height_t *end = &_height_map.h[last * _height_map.dim_x];
 
-	FOR_ALL_TILES_IN_HEIGHT(h) {
+	for (height_t *h = &_height_map.h[first * _height_map.dim_x]; h < end; h++) {
 		double fheight;
 
 		if (*h < h_min) continue;
@@ -521,66 +538,56 @@ static void HeightMapSineTransform(height_t h_min, height_t h_max)
 }
 
 /**
- * Additional map variety is provided by applying different curve maps
- * to different parts of the map. A randomized low resolution grid contains
- * which curve map to use on each part of the make. This filtered non-linearly
- * to smooth out transitions between curves, so each tile could have between
- * 100% of one map applied or 25% of four maps.
- *
- * The curve maps define different land styles, i.e. lakes, low-lands, hills
- * and mountain ranges, although these are dependent on the landscape style
- * chosen as well.
- *
- * The level parameter dictates the resolution of the grid. A low resolution
- * grid will result in larger continuous areas of a land style, a higher
- * resolution grid splits the style into smaller areas.
- * @param level Rough indication of the size of the grid sections to style. Small level means large grid sections.
+ * Applies sine wave redistribution onto height map.
+ * Every height is transformed on its own, so the rows are spread over the worker threads.
  */
-static void HeightMapCurves(uint level)
+static void HeightMapSineTransform(height_t h_min, height_t h_max)
 {
-	height_t mh = TGPGetMaxHeight() - I2H(1); // height levels above sea level only
+	HeightMapRange range = { h_min, h_max };
+	ThreadPoolParallelFor(&HeightMapSineTransformRows, &range, _height_map.size_y + 1, HEIGHT_MAP_ROWS_PER_CHUNK);
+}
 
-	/** Basically scale height X to height Y. Everything in between is interpolated. */
-	struct control_point_t {
-		height_t x; ///< The height to scale from.
-		height_t y; ///< The height to scale to.
-	};
-	/* Scaled curve maps; value is in height_ts. */
-#define F(fraction) ((height_t)(fraction * mh))
-	const control_point_t curve_map_1[] = { { F(0.0), F(0.0) },                       { F(0.8), F(0.13) },                       { F(1.0), F(0.4)  } };
-	const control_point_t curve_map_2[] = { { F(0.0), F(0.0) }, { F(0.53), F(0.13) }, { F(0.8), F(0.27) },                       { F(1.0), F(0.6)  } };
-	const control_point_t curve_map_3[] = { { F(0.0), F(0.0) }, { F(0.53), F(0.27) }, { F(0.8), F(0.57) },                       { F(1.0), F(0.8)  } };
-	const control_point_t curve_map_4[] = { { F(0.0), F(0.0) }, { F(0.4),  F(0.3)  }, { F(0.7), F(0.8)  }, { F(0.92), F(0.99) }, { F(1.0), F(0.99) } };
-#undef F
+/** Basically scale height X to height Y. Everything in between is interpolated. */
+struct control_point_t {
+	height_t x; ///< The height to scale from.
+	height_t y; ///< The height to scale to.
+};
 
-	/** Helper structure to index the different curve maps. */
-	struct control_point_list_t {
-		size_t length;               ///< The length of the curve map.
-		const control_point_t *list; ///< The actual curve map.
-	};
-	const control_point_list_t curve_maps[] = {
-		{ lengthof(curve_map_1), curve_map_1 },
-		{ lengthof(curve_map_2), curve_map_2 },
-		{ lengthof(curve_map_3), curve_map_3 },
-		{ lengthof(curve_map_4), curve_map_4 },
-	};
+/** Helper structure to index the different curve maps. */
+struct control_point_list_t {
+	size_t length;               ///< The length of the curve map.
+	const control_point_t *list; ///< The actual curve map.
+};
 
-	height_t ht[lengthof(curve_maps)];
-	MemSetT(ht, 0, lengthof(ht));
+/** Number of different curve maps #HeightMapCurves chooses from. */
+static const uint NUM_CURVE_MAPS = 4;
 
-	/* Set up a grid to choose curve maps based on location; attempt to get a somewhat square grid */
-	float factor = sqrt((float)_height_map.size_x / (float)_height_map.size_y);
-	uint sx = Clamp((int)(((1 << level) * factor) + 0.5), 1, 128);
-	uint sy = Clamp((int)(((1 << level) / factor) + 0.5), 1, 128);
-	byte *c = AllocaM(byte, sx * sy);
+/** Everything the workers need to apply the curve maps onto the height map. */
+struct HeightMapCurvesJob {
+	const control_point_list_t *curve_maps; ///< The #NUM_CURVE_MAPS curve maps.
+	const byte *c;                          ///< Grid of the curve map to use per part of the map.
+	uint sx;                                ///< Width of the grid.
+	uint sy;                                ///< Height of the grid.
+};
 
-	for (uint i = 0; i < sx * sy; i++) {
-		c[i] = Random() % lengthof(curve_maps);
-	}
+/**
+ * Apply the curve maps onto some columns of the height map.
+ * @param data  The #HeightMapCurvesJob.
+ * @param first First column to apply the curves onto.
+ * @param last  One past the last column to apply the curves onto.
+ */
+static void HeightMapCurvesColumns(void *data, uint first, uint last)
+{
+	const HeightMapCurvesJob *job = (const HeightMapCurvesJob *)data;
+	const control_point_list_t *curve_maps = job->curve_maps;
+	const byte *c = job->c;
+	const uint sx = job->sx;
+	const uint sy = job->sy;
 
-	/* Apply curves */
-	for (int x = 0; x < _height_map.size_x; x++) {
+	height_t ht[NUM_CURVE_MAPS];
+	MemSetT(ht, 0, lengthof(ht));
 
+	for (int x = first; x < (int)last; x++) {
 		/* Get our X grid positions and bi-linear ratio */
 		float fx = (float)(sx * x) / _height_map.size_x + 1.0f;
 		uint x1 = (uint)fx;
@@ -635,7 +642,7 @@ static void HeightMapCurves(uint level)
 			*h -= I2H(1);
 
 			/* Apply all curve maps that are used on this tile. */
-			for (uint t = 0; t < lengthof(curve_maps); t++) {
+			for (uint t = 0; t < NUM_CURVE_MAPS; t++) {
 				if (!HasBit(corner_bits, t)) continue;
 
 				bool found = false;
@@ -662,12 +669,91 @@ static void HeightMapCurves(uint level)
 	}
 }
 
+/**
+ * Additional map variety is provided by applying different curve maps
+ * to different parts of the map. A randomized low resolution grid contains
+ * which curve map to use on each part of the make. This filtered non-linearly
+ * to smooth out transitions between curves, so each tile could have between
+ * 100% of one map applied or 25% of four maps.
+ *
+ * The curve maps define different land styles, i.e. lakes, low-lands, hills
+ * and mountain ranges, although these are dependent on the landscape style
+ * chosen as well.
+ *
+ * The level parameter dictates the resolution of the grid. A low resolution
+ * grid will result in larger continuous areas of a land style, a higher
+ * resolution grid splits the style into smaller areas.
+ * @param level Rough indication of the size of the grid sections to style. Small level means large grid sections.
+ */
+static void HeightMapCurves(uint level)
+{
+	height_t mh = TGPGetMaxHeight() - I2H(1); // height levels above sea level only
+
+	/* Scaled curve maps; value is in height_ts. */
+#define F(fraction) ((height_t)(fraction * mh))
+	const control_point_t curve_map_1[] = { { F(0.0), F(0.0) },                       { F(0.8), F(0.13) },                       { F(1.0), F(0.4)  } };
+	const control_point_t curve_map_2[] = { { F(0.0), F(0.0) }, { F(0.53), F(0.13) }, { F(0.8), F(0.27) },                       { F(1.0), F(0.6)  } };
+	const control_point_t curve_map_3[] = { { F(0.0), F(0.0) }, { F(0.53), F(0.27) }, { F(0.8), F(0.57) },                       { F(1.0), F(0.8)  } };
+	const control_point_t curve_map_4[] = { { F(0.0), F(0.0) }, { F(0.4),  F(0.3)  }, { F(0.7), F(0.8)  }, { F(0.92), F(0.99) }, { F(1.0), F(0.99) } };
+#undef F
+
+	const control_point_list_t curve_maps[NUM_CURVE_MAPS] = {
+		{ lengthof(curve_map_1), curve_map_1 },
+		{ lengthof(curve_map_2), curve_map_2 },
+		{ lengthof(curve_map_3), curve_map_3 },
+		{ lengthof(curve_map_4), curve_map_4 },
+	};
+
+	/* Set up a grid to choose curve maps based on location; attempt to get a somewhat square grid */
+	float factor = sqrt((float)_height_map.size_x / (float)_height_map.size_y);
+	uint sx = Clamp((int)(((1 << level) * factor) + 0.5), 1, 128);
+	uint sy = Clamp((int)(((1 << level) / factor) + 0.5), 1, 128);
+	byte *c = AllocaM(byte, sx * sy);
+
+	for (uint i = 0; i < sx * sy; i++) {
+		c[i] = Random() % lengthof(curve_maps);
+	}
+
+	/* Apply curves; every tile only depends on the grid and its own height. */
+	HeightMapCurvesJob job = { curve_maps, c, sx, sy };
+	ThreadPoolParallelFor(&HeightMapCurvesColumns, &job, _height_map.size_x, HEIGHT_MAP_ROWS_PER_CHUNK);
+}
+
+/** Everything the workers need to move the water level of the height map. */
+struct HeightMapWaterLevelJob {
+	height_t h_water_level; ///< Height that becomes the new sea level.
+	height_t h_max;         ///< Highest height in the height map.
+	height_t h_max_new;     ///< Highest height after the transformation.
+};
+
+/**
+ * Transform some rows of the height map into the new (normalized) heights.
+ * @param data  The #HeightMapWaterLevelJob.
+ * @param first First row to transform.
+ * @param last  One past the last row to transform.
+ */
+static void HeightMapAdjustWaterLevelRows(void *data, uint first, uint last)
+{
+	const HeightMapWaterLevelJob *job = (const HeightMapWaterLevelJob *)data;
+	const height_t h_water_level = job->h_water_level;
+	const height_t h_max = job->h_max;
+	const height_t h_max_new = job->h_max_new;
+	height_t *end = &_height_map.h[last * _height_map.dim_x];
+
+	for (height_t *h = &_height_map.h[first * _height_map.dim_x]; h < end; h++) {
+		/* Transform height from range h_water_level..h_max into 0..h_max_new range */
+		*h = (height_t)(((int)h_max_new) * (*h - h_water_level) / (h_max - h_water_level)) + I2H(1);
+		/* Make sure all values are in the proper range (0..h_max_new) */
+		if (*h < 0) *h = I2H(0);
+		if (*h >= h_max_new) *h = h_max_new - 1;
+	}
+}
+
 /** Adjusts heights in height map to contain required amount of water tiles */
 static void HeightMapAdjustWaterLevel(amplitude_t water_percent, height_t h_max_new)
 {
 	height_t h_min, h_max, h_avg, h_water_level;
 	int64 water_tiles, desired_water_tiles;
-	height_t *h;
 	int *hist;
 
 	HeightMapGetMinMaxAvg(&h_min, &h_max, &h_avg);
@@ -692,13 +778,8 @@ static void HeightMapAdjustWaterLevel(amplitude_t water_percent, height_t h_max_
 	 *   values from range: h_water_level..h_max are transformed into 0..h_max_new
 	 *   where h_max_new is depending on terrain type and map size.
 	 */
-	FOR_ALL_TILES_IN_HEIGHT(h) {
-		/* Transform height from range h_water_level..h_max into 0..h_max_new range */
-		*h = (height_t)(((int)h_max_new) * (*h - h_water_level) / (h_max - h_water_level)) + I2H(1);
-		/* Make sure all values are in the proper range (0..h_max_new) */
-		if (*h < 0) *h = I2H(0);
-		if (*h >= h_max_new) *h = h_max_new - 1;
-	}
+	HeightMapWaterLevelJob job = { h_water_level, h_max, h_max_new };
+	ThreadPoolParallelFor(&HeightMapAdjustWaterLevelRows, &job, _height_map.size_y + 1, HEIGHT_MAP_ROWS_PER_CHUNK);
 
 	free(hist_buf);
 }
@@ -973,6 +1054,25 @@ static void TgenSetTileHeight(TileIndex tile, int height)
 	}
 }
 
+/**
+ * Transfer some rows of the height map into the map.
+ * Every tile is only written by the row it is in, so the rows can be done in parallel
+ * unless setting the height also updates the slope cache.
+ * @param data  Pointer to the maximum allowed tile height.
+ * @param first First row to transfer.
+ * @param last  One past the last row to transfer.
+ */
+static void TgenSetTileHeightRows(void *data, uint first, uint last)
+{
+	const int max_height = *(const int *)data;
+
+	for (int y = first; y < (int)last; y++) {
+		for (int x = 0; x < _height_map.size_x; x++) {
+			TgenSetTileHeight(TileXY(x, y), Clamp(H2I(_height_map.height(x, y)), 0, max_height));
+		}
+	}
+}
+
 /**
  * The main new land generator using Perlin noise. Desert landscape is handled
  * different to all others to give a desert valley between two high mountains.
@@ -1002,11 +1102,13 @@ void GenerateTerrainPerlin()
 	int max_height = H2I(TGPGetMaxHeight());
 
 	/* Transfer height map into OTTD map */
-	for (int y = 0; y < _height_map.size_y; y++) {
-		for (int x = 0; x < _height_map.size_x; x++) {
-			TgenSetTileHeight(TileXY(x, y), Clamp(H2I(_height_map.height(x, y)), 0, max_height));
-		}
-	}
+#ifdef WITH_SLOPE_CACHE
+	/* Setting a height also updates the cached slopes of the row above it, which
+	 * belongs to another chunk, so with the slope cache the rows are done in order. */
+	TgenSetTileHeightRows(&max_height, 0, _height_map.size_y);
+#else
+	ThreadPoolParallelFor(&TgenSetTileHeightRows, &max_height, _height_map.size_y, HEIGHT_MAP_ROWS_PER_CHUNK);
+#endif /* WITH_SLOPE_CACHE */
 
 	IncreaseGeneratingWorldProgress(GWP_LANDSCAPE);
 
@@ -0,0 +1,365 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.cpp Implementation of the pool of worker threads. */
+
+#include "../stdafx.h"
+#include "thread.h"
+#include "thread_pool.h"
+#include "../core/math_func.hpp"
+#include "../core/mem_func.hpp"
+#include "../core/smallvec_type.hpp"
+#include "../debug.h"
+#include <deque>
+#include <algorithm>
+
+#include "../safeguards.h"
+
+/** Maximum number of worker threads we start, regardless of the number of cores. */
+static const uint MAX_POOL_WORKERS = 16;
+
+uint _max_worker_threads; ///< Configured maximum number of worker threads; 0 to use one less than the number of cores.
+
+/** The range based job the pool is currently working on. */
+struct ThreadPoolJob {
+	ThreadPoolProc proc; ///< Procedure to call for each range.
+	void *data;          ///< Data to pass to the procedure.
+	uint count;          ///< Total number of items; 0 when there is no job.
+	uint chunk_size;     ///< Number of items handed out at once.
+	uint next;           ///< First item that has not been handed out yet.
+	uint finished;       ///< Number of items that have been processed.
+};
+
+/** The states a task goes through. */
+enum ThreadPoolTaskState {
+	TPTS_QUEUED,  ///< Waiting in a queue for a thread to run it.
+	TPTS_RUNNING, ///< Being run by a thread.
+	TPTS_DONE,    ///< Finished running.
+};
+
+/** A task that is run by one of the worker threads. */
+struct ThreadPoolTask {
+	ThreadPoolTaskProc proc;   ///< Procedure to run.
+	void *data;                ///< Data to pass to the procedure.
+	ThreadPoolTaskState state; ///< State of the task; changes to #TPTS_DONE are protected by #mutex, the others by #_pool_mutex.
+	ThreadMutex *mutex;        ///< Wakes the thread waiting for the task to finish.
+	uint queue;                ///< The queue the task has been put in.
+};
+
+/** Queue of tasks of a worker; the worker takes from the front, the others steal from the back. */
+typedef std::deque<ThreadPoolTask *> ThreadPoolQueue;
+
+static ThreadMutex *_pool_mutex = NULL;      ///< Protects #_pool_job and the queues, and wakes the workers.
+static ThreadMutex *_pool_done_mutex = NULL; ///< Wakes the thread waiting for the job to finish.
+static SmallVector<ThreadObject *, 16> _pool_workers; ///< The running worker threads.
+static ThreadPoolQueue _pool_queues[MAX_POOL_WORKERS]; ///< The task queue of each worker.
+static uint _pool_queued_tasks = 0;          ///< Number of tasks in all queues.
+static uint _pool_next_queue = 0;            ///< The queue the next task is put in.
+static ThreadPoolJob _pool_job;              ///< The current job.
+static bool _pool_exit = false;              ///< Whether the workers have to stop.
+
+/**
+ * Take the next range of items of the current job and process it.
+ * @pre #_pool_mutex is held and the job has unassigned items.
+ * @post #_pool_mutex is held.
+ */
+static void ProcessNextPoolChunk()
+{
+	uint first = _pool_job.next;
+	uint last = min(_pool_job.count, first + _pool_job.chunk_size);
+	_pool_job.next = last;
+	ThreadPoolProc proc = _pool_job.proc;
+	void *data = _pool_job.data;
+
+	/* Wake another worker when there is more to do; events do not stack on all platforms. */
+	if (last < _pool_job.count || _pool_queued_tasks != 0) _pool_mutex->SendSignal();
+
+	_pool_mutex->EndCritical();
+	proc(data, first, last);
+	_pool_mutex->BeginCritical();
+
+	_pool_job.finished += last - first;
+	if (_pool_job.finished == _pool_job.count) {
+		_pool_done_mutex->BeginCritical();
+		_pool_done_mutex->SendSignal();
+		_pool_done_mutex->EndCritical();
+	}
+}
+
+/**
+ * Take a task from the queue of a worker, or steal one from another queue.
+ * @param worker The worker to take a task for.
+ * @return The task, or \c NULL when all queues are empty.
+ * @pre #_pool_mutex is held.
+ */
+static ThreadPoolTask *TakePoolTask(uint worker)
+{
+	if (_pool_queued_tasks == 0) return NULL;
+
+	ThreadPoolTask *task;
+	if (!_pool_queues[worker].empty()) {
+		task = _pool_queues[worker].front();
+		_pool_queues[worker].pop_front();
+	} else {
+		uint victim = worker;
+		do {
+			victim = (victim + 1) % _pool_workers.Length();
+		} while (_pool_queues[victim].empty());
+		task = _pool_queues[victim].back();
+		_pool_queues[victim].pop_back();
+	}
+	_pool_queued_tasks--;
+	return task;
+}
+
+/**
+ * Run a task that has just been taken from its queue.
+ * @param task The task to run.
+ * @pre #_pool_mutex is held.
+ * @post #_pool_mutex is held.
+ */
+static void RunPoolTask(ThreadPoolTask *task)
+{
+	task->state = TPTS_RUNNING;
+	_pool_mutex->EndCritical();
+
+	try {
+		task->proc(task->data);
+	} catch (OTTDThreadExitSignal) {
+	}
+
+	task->mutex->BeginCritical();
+	task->state = TPTS_DONE;
+	task->mutex->SendSignal();
+	task->mutex->EndCritical();
+
+	_pool_mutex->BeginCritical();
+}
+
+/**
+ * Main loop of a worker thread.
+ * @param arg The index of the worker.
+ */
+static void ThreadPoolWorker(void *arg)
+{
+	uint worker = (uint)(size_t)arg;
+
+	_pool_mutex->BeginCritical();
+	while (!_pool_exit) {
+		/* Prefer the range based job; the thread that started it is waiting for it. */
+		if (_pool_job.next < _pool_job.count) {
+			ProcessNextPoolChunk();
+			continue;
+		}
+
+		ThreadPoolTask *task = TakePoolTask(worker);
+		if (task == NULL) {
+			_pool_mutex->WaitForSignal();
+			continue;
+		}
+
+		if (_pool_queued_tasks != 0) _pool_mutex->SendSignal();
+		RunPoolTask(task);
+	}
+	/* Pass the exit signal on to the next worker. */
+	_pool_mutex->SendSignal();
+	_pool_mutex->EndCritical();
+}
+
+/**
+ * Start the worker threads. Unless configured otherwise there is one less
+ * than the number of cores as the calling thread takes part in the work too,
+ * but at least one so background tasks do not have to run on the main thread.
+ */
+void InitThreadPool()
+{
+	if (_pool_mutex != NULL) return;
+
+	_pool_mutex = ThreadMutex::New();
+	_pool_done_mutex = ThreadMutex::New();
+	_pool_exit = false;
+	_pool_queued_tasks = 0;
+	_pool_next_queue = 0;
+	MemSetT(&_pool_job, 0);
+
+	uint cores = GetCPUCoreCount();
+	uint workers = _max_worker_threads != 0 ? _max_worker_threads : max(cores - 1, 1U);
+	workers = min(workers, MAX_POOL_WORKERS);
+	for (uint i = 0; i < workers; i++) {
+		ThreadObject *thread;
+		if (!ThreadObject::New(&ThreadPoolWorker, (void *)(size_t)i, &thread, "ottd:worker")) break;
+		*_pool_workers.Append() = thread;
+	}
+	DEBUG(misc, 1, "Started %u worker threads", _pool_workers.Length());
+}
+
+/** Stop all worker threads. */
+void UninitThreadPool()
+{
+	if (_pool_mutex == NULL) return;
+
+	_pool_mutex->BeginCritical();
+	_pool_exit = true;
+	_pool_mutex->SendSignal();
+	_pool_mutex->EndCritical();
+
+	for (uint i = 0; i < _pool_workers.Length(); i++) {
+		_pool_workers[i]->Join();
+		delete _pool_workers[i];
+	}
+	_pool_workers.Clear();
+
+	/* Everything that was submitted must have been waited for. */
+	for (uint i = 0; i < lengthof(_pool_queues); i++) assert(_pool_queues[i].empty());
+
+	delete _pool_mutex;
+	delete _pool_done_mutex;
+	_pool_mutex = NULL;
+	_pool_done_mutex = NULL;
+}
+
+/**
+ * Forget about the worker threads without stopping them. For a child process
+ * made by fork(), in which only the calling thread exists, so from then on
+ * all work submitted to the pool is done by the calling thread.
+ */
+void DetachThreadPool()
+{
+	_pool_workers.Clear();
+}
+
+/**
+ * Get the number of worker threads, not counting the calling thread.
+ * @return The number of workers; 0 when the pool is not running.
+ */
+uint GetThreadPoolWorkerCount()
+{
+	return _pool_workers.Length();
+}
+
+/**
+ * Process \a count items by calling \a proc for ranges of at most
+ * \a chunk_size items, spread over the worker threads and the calling thread.
+ * Returns once all items have been processed. Without workers, or when
+ * everything fits in one range, \a proc is called directly.
+ * When another thread is already using the pool, \a proc is called directly too.
+ * @param proc       Procedure processing a range of items.
+ * @param data       Data to pass to \a proc.
+ * @param count      The number of items.
+ * @param chunk_size The maximum number of items per range.
+ * @note The pool must have been started from the main thread (#InitThreadPool) before
+ *       other threads use it; \a proc must not change shared state.
+ */
+void ThreadPoolParallelFor(ThreadPoolProc proc, void *data, uint count, uint chunk_size)
+{
+	if (count == 0) return;
+	assert(chunk_size > 0);
+	InitThreadPool();
+	if (_pool_workers.Length() == 0 || count <= chunk_size) {
+		proc(data, 0, count);
+		return;
+	}
+
+	_pool_mutex->BeginCritical();
+	if (_pool_job.count != 0) {
+		/* Another thread is using the pool; do the work ourselves. */
+		_pool_mutex->EndCritical();
+		proc(data, 0, count);
+		return;
+	}
+	_pool_job.proc = proc;
+	_pool_job.data = data;
+	_pool_job.count = count;
+	_pool_job.chunk_size = chunk_size;
+	_pool_job.next = 0;
+	_pool_job.finished = 0;
+	_pool_mutex->SendSignal();
+
+	while (_pool_job.next < _pool_job.count) ProcessNextPoolChunk();
+
+	while (_pool_job.finished < _pool_job.count) {
+		_pool_done_mutex->BeginCritical();
+		_pool_mutex->EndCritical();
+		_pool_done_mutex->WaitForSignal();
+		_pool_done_mutex->EndCritical();
+		_pool_mutex->BeginCritical();
+	}
+
+	MemSetT(&_pool_job, 0);
+	_pool_mutex->EndCritical();
+}
+
+/**
+ * Run \a proc in the background on one of the worker threads. The tasks are
+ * spread over the queues of the workers; a worker without work of its own
+ * steals from the others.
+ * @param proc Procedure to run.
+ * @param data Data to pass to \a proc.
+ * @return The task to wait for with #ThreadPoolWaitTask, or \c NULL when
+ *         there are no worker threads; the caller then has to call \a proc itself.
+ * @note \a proc may end itself early by throwing #OTTDThreadExitSignal.
+ */
+ThreadPoolTask *ThreadPoolSubmit(ThreadPoolTaskProc proc, void *data)
+{
+	InitThreadPool();
+	if (_pool_workers.Length() == 0) return NULL;
+
+	ThreadPoolTask *task = new ThreadPoolTask();
+	task->proc = proc;
+	task->data = data;
+	task->state = TPTS_QUEUED;
+	task->mutex = ThreadMutex::New();
+
+	_pool_mutex->BeginCritical();
+	task->queue = _pool_next_queue;
+	_pool_next_queue = (_pool_next_queue + 1) % _pool_workers.Length();
+	_pool_queues[task->queue].push_back(task);
+	_pool_queued_tasks++;
+	_pool_mutex->SendSignal();
+	_pool_mutex->EndCritical();
+
+	return task;
+}
+
+/**
+ * Check whether a task has finished, without waiting for it.
+ * @param task The task to check.
+ * @return True if #ThreadPoolWaitTask would return right away.
+ */
+bool ThreadPoolIsTaskDone(ThreadPoolTask *task)
+{
+	task->mutex->BeginCritical();
+	bool done = task->state == TPTS_DONE;
+	task->mutex->EndCritical();
+	return done;
+}
+
+/**
+ * Wait for a task to finish and free it. A task that has not been started
+ * yet is run by the calling thread instead.
+ * @param task The task to wait for.
+ */
+void ThreadPoolWaitTask(ThreadPoolTask *task)
+{
+	_pool_mutex->BeginCritical();
+	if (task->state == TPTS_QUEUED) {
+		ThreadPoolQueue &queue = _pool_queues[task->queue];
+		queue.erase(std::find(queue.begin(), queue.end(), task));
+		_pool_queued_tasks--;
+		RunPoolTask(task);
+	}
+	_pool_mutex->EndCritical();
+
+	task->mutex->BeginCritical();
+	while (task->state != TPTS_DONE) task->mutex->WaitForSignal();
+	task->mutex->EndCritical();
+
+	delete task->mutex;
+	delete task;
+}
@@ -0,0 +1,42 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.h Pool of worker threads to spread independent work items over. */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/**
+ * Procedure processing a range of work items.
+ * @param data  Caller supplied data shared by all ranges.
+ * @param first First item of the range.
+ * @param last  One past the last item of the range.
+ */
+typedef void (*ThreadPoolProc)(void *data, uint first, uint last);
+
+/**
+ * Procedure of a task running in the background.
+ * @param data Caller supplied data.
+ */
+typedef void (*ThreadPoolTaskProc)(void *data);
+
+struct ThreadPoolTask;
+
+extern uint _max_worker_threads;
+
+void InitThreadPool();
+void UninitThreadPool();
+void DetachThreadPool();
+uint GetThreadPoolWorkerCount();
+void ThreadPoolParallelFor(ThreadPoolProc proc, void *data, uint count, uint chunk_size);
+ThreadPoolTask *ThreadPoolSubmit(ThreadPoolTaskProc proc, void *data);
+void ThreadPoolWaitTask(ThreadPoolTask *task);
+bool ThreadPoolIsTaskDone(ThreadPoolTask *task);
+
+#endif /* THREAD_POOL_H */
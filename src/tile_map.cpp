@@ -11,6 +11,7 @@
 
 #include "stdafx.h"
 #include "tile_map.h"
+#include "slope_func.h"
 
 #include "safeguards.h"
 
@@ -53,12 +54,12 @@ static Slope GetTileSlopeGivenHeight(int hnorth, int hwest, int heast, int hsout
 }
 
 /**
- * Return the slope of a given tile inside the map.
+ * Compute the slope of a tile inside the map from the heights of its corners.
  * @param tile Tile to compute slope of
  * @param h    If not \c NULL, pointer to storage of z height
  * @return Slope of the tile, except for the HALFTILE part
  */
-Slope GetTileSlope(TileIndex tile, int *h)
+static Slope ComputeTileSlope(TileIndex tile, int *h)
 {
 	uint x1 = TileX(tile);
 	uint y1 = TileY(tile);
@@ -73,6 +74,62 @@ Slope GetTileSlope(TileIndex tile, int *h)
 	return GetTileSlopeGivenHeight(hnorth, hwest, heast, hsouth, h);
 }
 
+#ifdef WITH_SLOPE_CACHE
+/**
+ * Get the height of the northern corner of a tile above its lowest corner.
+ * @param s The slope of the tile.
+ * @return The height difference in the same unit as TileHeight.
+ */
+static inline int GetNorthCornerHeightAboveBottom(Slope s)
+{
+	if ((s & SLOPE_N) == 0) return 0;
+	return IsSteepSlope(s) && GetHighestSlopeCorner(s) == CORNER_N ? 2 : 1;
+}
+
+/**
+ * Update the cached slopes after the height of a tile changed. The height
+ * of a tile is the height of the northern corner, which is also a corner
+ * of the tiles to the north-east, north-west and north of it.
+ * @param tile The tile whose height changed.
+ */
+void UpdateTileSlopeCache(TileIndex tile)
+{
+	uint x = TileX(tile);
+	uint y = TileY(tile);
+	for (uint ty = (y > 0 ? y - 1 : 0); ty <= y; ty++) {
+		for (uint tx = (x > 0 ? x - 1 : 0); tx <= x; tx++) {
+			TileIndex t = TileXY(tx, ty);
+			_tile_slope_cache[t] = ComputeTileSlope(t, NULL);
+		}
+	}
+}
+
+/** Compute the cached slopes of all tiles, after the heights were changed without #SetTileHeight. */
+void RebuildTileSlopeCache()
+{
+	for (TileIndex t = 0; t < MapSize(); t++) {
+		_tile_slope_cache[t] = ComputeTileSlope(t, NULL);
+	}
+}
+#endif /* WITH_SLOPE_CACHE */
+
+/**
+ * Return the slope of a given tile inside the map.
+ * @param tile Tile to compute slope of
+ * @param h    If not \c NULL, pointer to storage of z height
+ * @return Slope of the tile, except for the HALFTILE part
+ */
+Slope GetTileSlope(TileIndex tile, int *h)
+{
+#ifdef WITH_SLOPE_CACHE
+	Slope s = (Slope)_tile_slope_cache[tile];
+	if (h != NULL) *h = TileHeight(tile) - GetNorthCornerHeightAboveBottom(s);
+	return s;
+#else
+	return ComputeTileSlope(tile, h);
+#endif /* WITH_SLOPE_CACHE */
+}
+
 /**
  * Return the slope of a given tile, also for tiles outside the map (virtual "black" tiles).
  *
@@ -101,6 +158,11 @@ Slope GetTilePixelSlopeOutsideMap(int x, int y, int *h)
  */
 bool IsTileFlat(TileIndex tile, int *h)
 {
+#ifdef WITH_SLOPE_CACHE
+	if (_tile_slope_cache[tile] != SLOPE_FLAT) return false;
+	if (h != NULL) *h = TileHeight(tile);
+	return true;
+#else
 	uint x1 = TileX(tile);
 	uint y1 = TileY(tile);
 	uint x2 = min(x1 + 1, MapMaxX());
@@ -113,6 +175,7 @@ bool IsTileFlat(TileIndex tile, int *h)
 
 	if (h != NULL) *h = z;
 	return true;
+#endif /* WITH_SLOPE_CACHE */
 }
 
 /**
@@ -122,6 +185,9 @@ bool IsTileFlat(TileIndex tile, int *h)
  */
 int GetTileZ(TileIndex tile)
 {
+#ifdef WITH_SLOPE_CACHE
+	return TileHeight(tile) - GetNorthCornerHeightAboveBottom((Slope)_tile_slope_cache[tile]);
+#else
 	uint x1 = TileX(tile);
 	uint y1 = TileY(tile);
 	uint x2 = min(x1 + 1, MapMaxX());
@@ -133,6 +199,7 @@ int GetTileZ(TileIndex tile)
 	h = min(h, TileHeight(TileXY(x2, y2))); // S corner
 
 	return h;
+#endif /* WITH_SLOPE_CACHE */
 }
 
 /**
@@ -142,6 +209,10 @@ int GetTileZ(TileIndex tile)
  */
 int GetTileMaxZ(TileIndex t)
 {
+#ifdef WITH_SLOPE_CACHE
+	Slope s = (Slope)_tile_slope_cache[t];
+	return TileHeight(t) - GetNorthCornerHeightAboveBottom(s) + GetSlopeMaxZ(s);
+#else
 	uint x1 = TileX(t);
 	uint y1 = TileY(t);
 	uint x2 = min(x1 + 1, MapMaxX());
@@ -153,4 +224,5 @@ int GetTileMaxZ(TileIndex t)
 	h = max<int>(h, TileHeight(TileXY(x2, y2))); // S corner
 
 	return h;
+#endif /* WITH_SLOPE_CACHE */
 }
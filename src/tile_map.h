@@ -46,6 +46,11 @@ static inline uint TileHeightOutsideMap(int x, int y)
 	return TileHeight(TileXY(Clamp(x, 0, MapMaxX()), Clamp(y, 0, MapMaxY())));
 }
 
+#ifdef WITH_SLOPE_CACHE
+void UpdateTileSlopeCache(TileIndex tile);
+void RebuildTileSlopeCache();
+#endif /* WITH_SLOPE_CACHE */
+
 /**
  * Sets the height of a tile.
  *
@@ -61,6 +66,9 @@ static inline void SetTileHeight(TileIndex tile, uint height)
 	assert(tile < MapSize());
 	assert(height <= MAX_TILE_HEIGHT);
 	_m[tile].height = height;
+#ifdef WITH_SLOPE_CACHE
+	UpdateTileSlopeCache(tile);
+#endif /* WITH_SLOPE_CACHE */
 }
 
 /**
@@ -138,6 +146,7 @@ static inline void SetTileType(TileIndex tile, TileType type)
 	 * the upper edges of the map are also VOID tiles. */
 	assert(IsInnerTile(tile) == (type != MP_VOID));
 	SB(_m[tile].type, 4, 4, type);
+	ClearTileLoopIdleAround(tile);
 }
 
 /**
@@ -76,6 +76,14 @@ public:
 		free(this->data);
 	}
 
+	/** Remove all values and release the storage. */
+	void Clear()
+	{
+		free(this->data);
+		this->data = NULL;
+		this->area = TileArea(INVALID_TILE, 0, 0);
+	}
+
 	/**
 	 * Get the total covered area.
 	 * @return The area covered by the matrix.
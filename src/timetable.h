@@ -18,5 +18,6 @@
 void ShowTimetableWindow(const Vehicle *v);
 void UpdateVehicleTimetable(Vehicle *v, bool travelling);
 void SetTimetableParams(int param1, int param2, Ticks ticks);
+void SetTimetableWindowsDirty(const Vehicle *v);
 
 #endif /* TIMETABLE_H */
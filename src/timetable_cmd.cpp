@@ -17,6 +17,7 @@
 #include "vehicle_base.h"
 #include "cmd_helper.h"
 #include "core/sort_func.hpp"
+#include "timetable.h"
 
 #include "table/strings.h"
 
@@ -60,7 +61,9 @@ static void ChangeTimetable(Vehicle *v, VehicleOrderID order_number, uint16 val,
 	}
 	v->orders.list->UpdateTotalDuration(total_delta);
 	v->orders.list->UpdateTimetableDuration(timetable_delta);
+	v->orders.list->InvalidateCompleteTimetable();
 
+	SetTimetableWindowsDirty(v);
 	for (v = v->FirstShared(); v != NULL; v = v->NextShared()) {
 		if (v->cur_real_order_index == order_number && v->current_order.Equals(*order)) {
 			switch (mtf) {
@@ -82,7 +85,6 @@ static void ChangeTimetable(Vehicle *v, VehicleOrderID order_number, uint16 val,
 					NOT_REACHED();
 			}
 		}
-		SetWindowDirty(WC_VEHICLE_TIMETABLE, v->index);
 	}
 }
 
@@ -478,7 +480,5 @@ void UpdateVehicleTimetable(Vehicle *v, bool travelling)
 		}
 	}
 
-	for (v = v->FirstShared(); v != NULL; v = v->NextShared()) {
-		SetWindowDirty(WC_VEHICLE_TIMETABLE, v->index);
-	}
+	SetTimetableWindowsDirty(v);
 }
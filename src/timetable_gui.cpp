@@ -23,6 +23,7 @@
 #include "date_func.h"
 #include "date_gui.h"
 #include "vehicle_gui.h"
+#include "timetable.h"
 #include "settings_type.h"
 
 #include "widgets/timetable_widget.h"
@@ -703,6 +704,21 @@ static WindowDesc _timetable_desc(
 	_nested_timetable_widgets, lengthof(_nested_timetable_widgets)
 );
 
+/**
+ * Mark the timetable windows of a vehicle and all vehicles sharing its orders dirty.
+ * Only the open windows are looked at, so long shared order lists don't make this slower.
+ * @param v The vehicle.
+ */
+void SetTimetableWindowsDirty(const Vehicle *v)
+{
+	Window *w;
+	FOR_ALL_WINDOWS_FROM_BACK(w) {
+		if (w->window_class != WC_VEHICLE_TIMETABLE) continue;
+		const Vehicle *u = Vehicle::GetIfValid(w->window_number);
+		if (u == v || (u != NULL && v->orders.list != NULL && u->orders.list == v->orders.list)) w->SetDirty();
+	}
+}
+
 /**
  * Show the timetable for a given vehicle.
  * @param v The vehicle to show the timetable for.
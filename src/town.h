@@ -28,6 +28,14 @@ struct BuildingCounts {
 
 typedef TileMatrix<CargoTypes, 4> AcceptanceMatrix;
 
+/** Cargo of the houses of a town in one square of an #AcceptanceMatrix. */
+struct TownSquareCargo {
+	uint16 acceptance[NUM_CARGO]; ///< Summed acceptance of the house tiles without cargo callbacks, in 1/8.
+	uint16 callback_houses;       ///< Number of house tiles with cargo callbacks, which are evaluated when needed.
+};
+
+typedef TileMatrix<TownSquareCargo, AcceptanceMatrix::GRID> TownCargoMatrix;
+
 static const uint CUSTOM_TOWN_NUMBER_DIFFICULTY  = 4; ///< value for custom town number in difficulty settings
 static const uint CUSTOM_TOWN_MAX_NUMBER = 5000;  ///< this is the maximum number of towns a user can specify in customisation
 
@@ -88,6 +96,10 @@ struct Town : TownPool::PoolItem<&_town_pool> {
 	CargoTypes cargo_produced;       ///< Bitmap of all cargoes produced by houses in this town.
 	AcceptanceMatrix cargo_accepted; ///< Bitmap of cargoes accepted by houses for each 4*4 map square of the town.
 	CargoTypes cargo_accepted_total; ///< NOSAVE: Bitmap of all cargoes accepted by houses in this town.
+	TownCargoMatrix cargo_square;    ///< NOSAVE: Cargo of the houses for each 4*4 map square of the town, to update #cargo_accepted incrementally.
+	uint32 cargo_accepted_squares[NUM_CARGO]; ///< NOSAVE: Number of squares in #cargo_accepted accepting each cargo.
+	uint32 cargo_produced_houses[NUM_CARGO];  ///< NOSAVE: Number of house tiles without cargo callbacks producing each cargo.
+	CargoTypes cargo_produced_callback;       ///< NOSAVE: Cargoes produced by house tiles with cargo callbacks, as of their last evaluation.
 	StationList stations_near;       ///< NOSAVE: List of nearby stations.
 
 	uint16 time_until_rebuild;     ///< time until we rebuild a house
@@ -19,6 +19,7 @@
 #include "command_func.h"
 #include "industry.h"
 #include "station_base.h"
+#include "station_func.h"
 #include "station_kdtree.h"
 #include "company_base.h"
 #include "news_func.h"
@@ -34,6 +35,7 @@
 #include "window_func.h"
 #include "string_func.h"
 #include "newgrf_cargo.h"
+#include "core/name_registry_type.hpp"
 #include "cheat_type.h"
 #include "animated_tile_func.h"
 #include "date_func.h"
@@ -103,6 +105,7 @@ static bool TestTownOwnsBridge(TileIndex tile, const Town *t)
 
 Town::~Town()
 {
+	_town_names.Invalidate();
 	free(this->name);
 	free(this->text);
 
@@ -771,52 +774,227 @@ static void ChangeTileOwner_Town(TileIndex tile, Owner old_owner, Owner new_owne
 	/* not used */
 }
 
+/**
+ * Check whether the cargo of a house depends on callbacks. Such cargo can change
+ * over time, so it is evaluated when needed instead of being summed up per square.
+ * @param hs The house.
+ * @return True iff the house has callbacks for its acceptance or production.
+ */
+static inline bool HouseHasCargoCallbacks(const HouseSpec *hs)
+{
+	return (hs->callback_mask & ((1 << CBM_HOUSE_ACCEPT_CARGO) | (1 << CBM_HOUSE_CARGO_ACCEPTANCE) | (1 << CBM_HOUSE_PRODUCE_CARGO))) != 0;
+}
+
+/**
+ * Update the bitmap of all cargoes produced by houses in a town.
+ * @param t The town to update.
+ */
+static void UpdateTownCargoProduced(Town *t)
+{
+	t->cargo_produced = t->cargo_produced_callback;
+	for (CargoID cid = 0; cid < NUM_CARGO; cid++) {
+		if (t->cargo_produced_houses[cid] > 0) SetBit(t->cargo_produced, cid);
+	}
+}
+
 /** Update the total cargo acceptance of the whole town.
  * @param t The town to update.
  */
 void UpdateTownCargoTotal(Town *t)
 {
 	t->cargo_accepted_total = 0;
+	MemSetT(t->cargo_accepted_squares, 0, lengthof(t->cargo_accepted_squares));
 
 	const TileArea &area = t->cargo_accepted.GetArea();
 	TILE_AREA_LOOP(tile, area) {
 		if (TileX(tile) % AcceptanceMatrix::GRID == 0 && TileY(tile) % AcceptanceMatrix::GRID == 0) {
-			t->cargo_accepted_total |= t->cargo_accepted[tile];
+			CargoTypes acc = t->cargo_accepted[tile];
+			t->cargo_accepted_total |= acc;
+			CargoID cid;
+			FOR_EACH_SET_CARGO_ID(cid, acc) t->cargo_accepted_squares[cid]++;
 		}
 	}
 }
 
 /**
- * Update accepted town cargoes around a specific tile.
+ * Update the accepted town cargoes of one square from the cargo of the houses
+ * around it, and the total acceptance of the town with it. Only the house tiles
+ * with cargo callbacks are looked at.
  * @param t The town to update.
- * @param start Update the values around this tile.
- * @param update_total Set to true if the total cargo acceptance should be updated.
+ * @param square A tile in the square to update.
  */
-static void UpdateTownCargoes(Town *t, TileIndex start, bool update_total = true)
+static void UpdateTownCargoSquare(Town *t, TileIndex square)
 {
-	CargoArray accepted, produced;
+	CargoArray accepted;
 	CargoTypes dummy = 0;
 
-	/* Gather acceptance for all houses in an area around the start tile.
-	 * The area is composed of the square the tile is in, extended one square in all
-	 * directions as the coverage area of a single station is bigger than just one square. */
+	/* Gather acceptance for all houses in an area around the square.
+	 * The area is composed of the square, extended one square in all directions
+	 * as the coverage area of a single station is bigger than just one square. */
+	TileArea area = AcceptanceMatrix::GetAreaForTile(square, 1);
+	const TileArea &cargo_area = t->cargo_square.GetArea();
+	for (uint y = 0; y < area.h; y += AcceptanceMatrix::GRID) {
+		for (uint x = 0; x < area.w; x += AcceptanceMatrix::GRID) {
+			TileIndex tile = TILE_ADDXY(area.tile, x, y);
+			if (!cargo_area.Contains(tile)) continue;
+
+			const TownSquareCargo &cargo = t->cargo_square[tile];
+			for (CargoID cid = 0; cid < NUM_CARGO; cid++) accepted[cid] += cargo.acceptance[cid];
+			if (cargo.callback_houses == 0) continue;
+
+			TileArea square_area = AcceptanceMatrix::GetAreaForTile(tile);
+			TILE_AREA_LOOP(house_tile, square_area) {
+				if (!IsTileType(house_tile, MP_HOUSE) || GetTownIndex(house_tile) != t->index) continue;
+				if (!HouseHasCargoCallbacks(HouseSpec::Get(GetHouseType(house_tile)))) continue;
+
+				AddAcceptedCargo_Town(house_tile, accepted, &dummy);
+			}
+		}
+	}
+
+	/* Create bitmap of accepted cargoes. */
+	CargoTypes acc = 0;
+	for (CargoID cid = 0; cid < NUM_CARGO; cid++) {
+		if (accepted[cid] >= 8) SetBit(acc, cid);
+	}
+
+	/* Account for the changes in the total acceptance. */
+	CargoTypes &old_acc = t->cargo_accepted[square];
+	CargoTypes changed = old_acc ^ acc;
+	CargoID cid;
+	FOR_EACH_SET_CARGO_ID(cid, changed) {
+		if (HasBit(acc, cid)) {
+			if (t->cargo_accepted_squares[cid]++ == 0) SetBit(t->cargo_accepted_total, cid);
+		} else {
+			if (--t->cargo_accepted_squares[cid] == 0) ClrBit(t->cargo_accepted_total, cid);
+		}
+	}
+	old_acc = acc;
+}
+
+/**
+ * Update accepted town cargoes of all squares whose acceptance depends on a specific tile.
+ * @param t The town to update.
+ * @param start Update the values around this tile.
+ */
+static void UpdateTownCargoesAround(Town *t, TileIndex start)
+{
+	TileArea old_area = t->cargo_accepted.GetArea();
+	t->cargo_accepted.Add(start);
+	const TileArea &new_area = t->cargo_accepted.GetArea();
+
+	/* Squares that were just added to the matrix may accept cargo from houses next to them. */
+	if (old_area.w != new_area.w || old_area.h != new_area.h) {
+		for (uint y = 0; y < new_area.h; y += AcceptanceMatrix::GRID) {
+			for (uint x = 0; x < new_area.w; x += AcceptanceMatrix::GRID) {
+				TileIndex square = TILE_ADDXY(new_area.tile, x, y);
+				if (!old_area.Contains(square)) UpdateTownCargoSquare(t, square);
+			}
+		}
+	}
+
 	TileArea area = AcceptanceMatrix::GetAreaForTile(start, 1);
-	TILE_AREA_LOOP(tile, area) {
-		if (!IsTileType(tile, MP_HOUSE) || GetTownIndex(tile) != t->index) continue;
+	for (uint y = 0; y < area.h; y += AcceptanceMatrix::GRID) {
+		for (uint x = 0; x < area.w; x += AcceptanceMatrix::GRID) {
+			TileIndex square = TILE_ADDXY(area.tile, x, y);
+			if (old_area.Contains(square)) UpdateTownCargoSquare(t, square);
+		}
+	}
+}
+
+/**
+ * Add or remove the cargo of a house tile to or from the cargo of its square.
+ * The accepted cargoes of the squares are not updated; call #UpdateTownCargoesAround
+ * once the tile is in its new state.
+ * @param t The town the house belongs to.
+ * @param tile The house tile.
+ * @param add True to add the cargo, false to remove it.
+ */
+static void ChangeTownHouseCargo(Town *t, TileIndex tile, bool add)
+{
+	TownSquareCargo &cargo = t->cargo_square[tile];
+	CargoArray produced;
 
+	if (HouseHasCargoCallbacks(HouseSpec::Get(GetHouseType(tile)))) {
+		if (add) {
+			cargo.callback_houses++;
+			AddProducedCargo_Town(tile, produced);
+		} else {
+			assert(cargo.callback_houses > 0);
+			cargo.callback_houses--;
+		}
+	} else {
+		CargoArray accepted;
+		CargoTypes dummy = 0;
 		AddAcceptedCargo_Town(tile, accepted, &dummy);
 		AddProducedCargo_Town(tile, produced);
+
+		for (CargoID cid = 0; cid < NUM_CARGO; cid++) {
+			if (add) {
+				cargo.acceptance[cid] += accepted[cid];
+				if (produced[cid] > 0) t->cargo_produced_houses[cid]++;
+			} else {
+				assert(cargo.acceptance[cid] >= accepted[cid]);
+				cargo.acceptance[cid] -= accepted[cid];
+				if (produced[cid] > 0) t->cargo_produced_houses[cid]--;
+			}
+		}
+		produced.Clear();
 	}
 
-	/* Create bitmap of produced and accepted cargoes. */
-	CargoTypes acc = 0;
-	for (uint cid = 0; cid < NUM_CARGO; cid++) {
-		if (accepted[cid] >= 8) SetBit(acc, cid);
-		if (produced[cid] > 0) SetBit(t->cargo_produced, cid);
+	/* Production of houses with callbacks is only forgotten on the next full evaluation. */
+	for (CargoID cid = 0; cid < NUM_CARGO; cid++) {
+		if (produced[cid] > 0) SetBit(t->cargo_produced_callback, cid);
+	}
+	UpdateTownCargoProduced(t);
+}
+
+/**
+ * Evaluate the cargo of the houses with cargo callbacks of a town again,
+ * as the results of the callbacks may have changed.
+ * @param t The town to update.
+ */
+static void UpdateTownCallbackCargoes(Town *t)
+{
+	t->cargo_produced_callback = 0;
+
+	const TileArea &area = t->cargo_square.GetArea();
+	std::vector<TileIndex> squares;
+	for (uint y = 0; y < area.h; y += AcceptanceMatrix::GRID) {
+		for (uint x = 0; x < area.w; x += AcceptanceMatrix::GRID) {
+			TileIndex square = TILE_ADDXY(area.tile, x, y);
+			if (t->cargo_square[square].callback_houses == 0) continue;
+
+			CargoArray produced;
+			TileArea square_area = AcceptanceMatrix::GetAreaForTile(square);
+			TILE_AREA_LOOP(tile, square_area) {
+				if (!IsTileType(tile, MP_HOUSE) || GetTownIndex(tile) != t->index) continue;
+				if (!HouseHasCargoCallbacks(HouseSpec::Get(GetHouseType(tile)))) continue;
+
+				AddProducedCargo_Town(tile, produced);
+			}
+			for (CargoID cid = 0; cid < NUM_CARGO; cid++) {
+				if (produced[cid] > 0) SetBit(t->cargo_produced_callback, cid);
+			}
+
+			/* All squares around this one depend on the callbacks. */
+			TileArea around = AcceptanceMatrix::GetAreaForTile(square, 1);
+			for (uint ay = 0; ay < around.h; ay += AcceptanceMatrix::GRID) {
+				for (uint ax = 0; ax < around.w; ax += AcceptanceMatrix::GRID) {
+					TileIndex around_square = TILE_ADDXY(around.tile, ax, ay);
+					if (t->cargo_accepted.GetArea().Contains(around_square)) squares.push_back(around_square);
+				}
+			}
+		}
 	}
-	t->cargo_accepted[start] = acc;
 
-	if (update_total) UpdateTownCargoTotal(t);
+	std::sort(squares.begin(), squares.end());
+	squares.erase(std::unique(squares.begin(), squares.end()), squares.end());
+	for (std::vector<TileIndex>::const_iterator it = squares.begin(); it != squares.end(); ++it) {
+		UpdateTownCargoSquare(t, *it);
+	}
+
+	UpdateTownCargoProduced(t);
 }
 
 /** Update cargo acceptance for the complete town.
@@ -824,20 +1002,32 @@ static void UpdateTownCargoes(Town *t, TileIndex start, bool update_total = true
  */
 void UpdateTownCargoes(Town *t)
 {
-	t->cargo_produced = 0;
+	t->cargo_square.Clear();
+	MemSetT(t->cargo_produced_houses, 0, lengthof(t->cargo_produced_houses));
+	t->cargo_produced_callback = 0;
+	t->cargo_accepted_total = 0;
+	MemSetT(t->cargo_accepted_squares, 0, lengthof(t->cargo_accepted_squares));
 
 	const TileArea &area = t->cargo_accepted.GetArea();
-	if (area.tile == INVALID_TILE) return;
+	if (area.tile == INVALID_TILE) {
+		UpdateTownCargoProduced(t);
+		return;
+	}
 
-	/* Update acceptance for each grid square. */
+	/* Gather the cargo of all houses, square by square. */
 	TILE_AREA_LOOP(tile, area) {
 		if (TileX(tile) % AcceptanceMatrix::GRID == 0 && TileY(tile) % AcceptanceMatrix::GRID == 0) {
-			UpdateTownCargoes(t, tile, false);
+			t->cargo_accepted[tile] = 0;
 		}
+		if (IsTileType(tile, MP_HOUSE) && GetTownIndex(tile) == t->index) ChangeTownHouseCargo(t, tile, true);
 	}
 
-	/* Update the total acceptance. */
-	UpdateTownCargoTotal(t);
+	/* Update acceptance for each grid square. */
+	for (uint y = 0; y < area.h; y += AcceptanceMatrix::GRID) {
+		for (uint x = 0; x < area.w; x += AcceptanceMatrix::GRID) {
+			UpdateTownCargoSquare(t, TILE_ADDXY(area.tile, x, y));
+		}
+	}
 }
 
 /** Updates the bitmap of all cargoes accepted by houses. */
@@ -1713,6 +1903,12 @@ static void DoCreateTown(Town *t, TileIndex tile, uint32 townnameparts, TownSize
 	}
 	t->townnameparts = townnameparts;
 
+	if (_town_names.IsValid()) {
+		char buf[(MAX_LENGTH_TOWN_NAME_CHARS + 1) * MAX_CHAR_LENGTH];
+		GetTownName(buf, t, lastof(buf));
+		_town_names.Add(buf);
+	}
+
 	t->UpdateVirtCoord();
 	_viewport_sign_kdtree.Insert(ViewportSignKdtreeItem::MakeTown(t->index));
 	InvalidateWindowData(WC_TOWN_DIRECTORY, 0, 0);
@@ -1871,6 +2067,7 @@ CommandCost CmdFoundTown(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 
 		if (t != NULL && !StrEmpty(text)) {
 			t->name = stredup(text);
+			_town_names.Invalidate();
 			t->UpdateVirtCoord();
 		}
 
@@ -2152,6 +2349,9 @@ static inline void ClearMakeHouseTile(TileIndex tile, Town *t, byte counter, byt
 	MakeHouseTile(tile, t->index, counter, stage, type, random_bits);
 	if (HouseSpec::Get(type)->building_flags & BUILDING_IS_ANIMATED) AddAnimatedTile(tile);
 
+	ChangeTownHouseCargo(t, tile, true);
+	UpdateTownCargoesAround(t, tile);
+
 	MarkTileDirtyByTile(tile);
 }
 
@@ -2175,7 +2375,9 @@ static void MakeTownHouse(TileIndex t, Town *town, byte counter, byte stage, Hou
 	if (size & BUILDING_2_TILES_X)   ClearMakeHouseTile(t + TileDiffXY(1, 0), town, counter, stage, ++type, random_bits);
 	if (size & BUILDING_HAS_4_TILES) ClearMakeHouseTile(t + TileDiffXY(1, 1), town, counter, stage, ++type, random_bits);
 
-	if (!_generating_world) FindStationsAroundTiles(TileArea(t, (size & BUILDING_2_TILES_X) ? 2 : 1, (size & BUILDING_2_TILES_Y) ? 2 : 1), &town->stations_near, false);
+	TileArea ta(t, (size & BUILDING_2_TILES_X) ? 2 : 1, (size & BUILDING_2_TILES_Y) ? 2 : 1);
+	if (!_generating_world) FindStationsAroundTiles(ta, &town->stations_near, false);
+	InvalidateStationAcceptanceCache(ta);
 }
 
 
@@ -2358,6 +2560,72 @@ static bool CheckTownBuild2x2House(TileIndex *tile, Town *t, int maxz, bool nosl
 }
 
 
+/** A house that may be built in some town zone and climate. */
+struct TownHouseCandidate {
+	HouseID house;         ///< The house.
+	HouseClassID class_id; ///< Class of the house.
+	uint probability;      ///< Relative probability of choosing the house.
+	uint cumulative;       ///< Sum of the probabilities of this and all earlier candidates in the list.
+
+	/** Order candidates by cumulative probability, for looking up a random number. */
+	static inline bool CumulativeLess(uint r, const TownHouseCandidate &c) { return r < c.cumulative; }
+};
+
+/** Number of town zones times the number of climates including "above the snow line". */
+static const uint NUM_TOWN_HOUSE_CANDIDATE_LISTS = HZB_END * (NUM_LANDSCAPE + 1);
+
+/**
+ * Houses that may be built this year, per town zone and climate, in order of house ID.
+ * They don't depend on the town or the tile, so they are only determined once
+ * after the house specs are loaded or the year changes, instead of for every
+ * attempt to build a house.
+ */
+static std::vector<TownHouseCandidate> _town_house_candidates[NUM_TOWN_HOUSE_CANDIDATE_LISTS];
+static bool _town_house_candidates_valid = false; ///< Whether #_town_house_candidates are up to date with the house specs.
+static Year _town_house_candidates_year;          ///< Year #_town_house_candidates were determined for.
+
+/**
+ * Get the houses that may be built in a town zone and climate.
+ * @param rad Town zone.
+ * @param land Climate, or -1 when above the snow line.
+ * @return The houses, in order of house ID.
+ */
+static const std::vector<TownHouseCandidate> &GetTownHouseCandidates(HouseZonesBits rad, int land)
+{
+	if (!_town_house_candidates_valid || _town_house_candidates_year != _cur_year) {
+		for (uint zone = 0; zone < HZB_END; zone++) {
+			for (int climate = -1; climate < NUM_LANDSCAPE; climate++) {
+				std::vector<TownHouseCandidate> &candidates = _town_house_candidates[zone * (NUM_LANDSCAPE + 1) + climate + 1];
+				candidates.clear();
+
+				/* bits 0-4 are used
+				 * bits 11-15 are used
+				 * bits 5-10 are not used. */
+				uint bitmask = (1 << zone) + (1 << (climate + 12));
+				for (uint i = 0; i < NUM_HOUSES; i++) {
+					const HouseSpec *hs = HouseSpec::Get(i);
+
+					/* Verify that the candidate house spec matches the zone and climate */
+					if ((~hs->building_availability & bitmask) != 0 || !hs->enabled || hs->grf_prop.override != INVALID_HOUSE_ID) continue;
+
+					if (_cur_year < hs->min_year || _cur_year > hs->max_year) continue;
+
+					/* Without NewHouses, all houses have probability '1' */
+					uint probability = _loaded_newgrf_features.has_newhouses ? hs->probability : 1;
+					if (probability == 0) continue;
+
+					TownHouseCandidate candidate = { (HouseID)i, hs->class_id, probability, probability };
+					if (!candidates.empty()) candidate.cumulative += candidates.back().cumulative;
+					candidates.push_back(candidate);
+				}
+			}
+		}
+		_town_house_candidates_valid = true;
+		_town_house_candidates_year = _cur_year;
+	}
+	return _town_house_candidates[rad * (NUM_LANDSCAPE + 1) + land + 1];
+}
+
 /**
  * Tries to build a house at this tile
  * @param t town the house will belong to
@@ -2383,38 +2651,23 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 	int land = _settings_game.game_creation.landscape;
 	if (land == LT_ARCTIC && maxz > HighestSnowLine()) land = -1;
 
-	uint bitmask = (1 << rad) + (1 << (land + 12));
+	/* The first house is chosen from the shared list of candidates with a
+	 * binary search. Only when that one can't be built, the list is copied
+	 * to choose the next ones from the houses not tried yet. */
+	const std::vector<TownHouseCandidate> &candidates = GetTownHouseCandidates(rad, land);
+	uint probability_max = candidates.empty() ? 0 : candidates.back().cumulative;
+	uint first = UINT_MAX; // Index of the first house tried, until the list is copied.
+	bool copied = false;
 
-	/* bits 0-4 are used
-	 * bits 11-15 are used
-	 * bits 5-10 are not used. */
 	HouseID houses[NUM_HOUSES];
 	uint num = 0;
 	uint probs[NUM_HOUSES];
-	uint probability_max = 0;
 
-	/* Generate a list of all possible houses that can be built. */
-	for (uint i = 0; i < NUM_HOUSES; i++) {
-		const HouseSpec *hs = HouseSpec::Get(i);
-
-		/* Verify that the candidate house spec matches the current tile status */
-		if ((~hs->building_availability & bitmask) != 0 || !hs->enabled || hs->grf_prop.override != INVALID_HOUSE_ID) continue;
-
-		/* Don't let these counters overflow. Global counters are 32bit, there will never be that many houses. */
-		if (hs->class_id != HOUSE_NO_CLASS) {
-			/* id_count is always <= class_count, so it doesn't need to be checked */
-			if (t->cache.building_counts.class_count[hs->class_id] == UINT16_MAX) continue;
-		} else {
-			/* If the house has no class, check id_count instead */
-			if (t->cache.building_counts.id_count[i] == UINT16_MAX) continue;
-		}
-
-		/* Without NewHouses, all houses have probability '1' */
-		uint cur_prob = (_loaded_newgrf_features.has_newhouses ? hs->probability : 1);
-		probability_max += cur_prob;
-		probs[num] = cur_prob;
-		houses[num++] = (HouseID)i;
-	}
+	/* Result of checking the surroundings of the tile for each multitile house size, with and without slopes. */
+	enum { SIZE_2x1, SIZE_1x2, SIZE_2x2, SIZE_END };
+	int8 size_allowed[SIZE_END][2];
+	TileIndex size_tile[SIZE_END][2];
+	memset(size_allowed, -1, sizeof(size_allowed));
 
 	TileIndex baseTile = tile;
 
@@ -2426,30 +2679,54 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 		 * So a next 1x1 tile building could be built on the wrong tile. */
 		tile = baseTile;
 
-		uint r = RandomRange(probability_max);
-		uint i;
-		for (i = 0; i < num; i++) {
-			if (probs[i] > r) break;
-			r -= probs[i];
+		if (first != UINT_MAX) {
+			for (uint j = 0; j < candidates.size(); j++) {
+				if (j == first) continue;
+				probs[num] = candidates[j].probability;
+				houses[num++] = candidates[j].house;
+			}
+			first = UINT_MAX;
+			copied = true;
 		}
 
-		HouseID house = houses[i];
-		probability_max -= probs[i];
+		uint r = RandomRange(probability_max);
+		HouseID house;
+		if (!copied) {
+			first = std::upper_bound(candidates.begin(), candidates.end(), r, &TownHouseCandidate::CumulativeLess) - candidates.begin();
+			house = candidates[first].house;
+			probability_max -= candidates[first].probability;
+		} else {
+			uint i;
+			for (i = 0; i < num; i++) {
+				if (probs[i] > r) break;
+				r -= probs[i];
+			}
+
+			house = houses[i];
+			probability_max -= probs[i];
 
-		/* remove tested house from the set */
-		num--;
-		houses[i] = houses[num];
-		probs[i] = probs[num];
+			/* remove tested house from the set */
+			num--;
+			houses[i] = houses[num];
+			probs[i] = probs[num];
+		}
 
 		const HouseSpec *hs = HouseSpec::Get(house);
 
+		/* Don't let these counters overflow. Global counters are 32bit, there will never be that many houses. */
+		if (hs->class_id != HOUSE_NO_CLASS) {
+			/* id_count is always <= class_count, so it doesn't need to be checked */
+			if (t->cache.building_counts.class_count[hs->class_id] == UINT16_MAX) continue;
+		} else {
+			/* If the house has no class, check id_count instead */
+			if (t->cache.building_counts.id_count[house] == UINT16_MAX) continue;
+		}
+
 		if (_loaded_newgrf_features.has_newhouses && !_generating_world &&
 				_game_mode != GM_EDITOR && (hs->extra_flags & BUILDING_IS_HISTORICAL) != 0) {
 			continue;
 		}
 
-		if (_cur_year < hs->min_year || _cur_year > hs->max_year) continue;
-
 		/* Special houses that there can be only one of. */
 		uint oneof = 0;
 
@@ -2465,15 +2742,31 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 		bool noslope = (hs->building_flags & TILE_NOT_SLOPED) != 0;
 		if (noslope && slope != SLOPE_FLAT) continue;
 
+		/* The checks only depend on the size and slope flag, so remember their results for the next houses. */
+		int size = SIZE_END;
 		if (hs->building_flags & TILE_SIZE_2x2) {
-			if (!CheckTownBuild2x2House(&tile, t, maxz, noslope)) continue;
+			size = SIZE_2x2;
 		} else if (hs->building_flags & TILE_SIZE_2x1) {
-			if (!CheckTownBuild2House(&tile, t, maxz, noslope, DIAGDIR_SW)) continue;
+			size = SIZE_2x1;
 		} else if (hs->building_flags & TILE_SIZE_1x2) {
-			if (!CheckTownBuild2House(&tile, t, maxz, noslope, DIAGDIR_SE)) continue;
+			size = SIZE_1x2;
 		} else {
 			/* 1x1 house checks are already done */
 		}
+		if (size != SIZE_END) {
+			int8 &allowed = size_allowed[size][noslope];
+			if (allowed < 0) {
+				size_tile[size][noslope] = tile;
+				switch (size) {
+					case SIZE_2x2: allowed = CheckTownBuild2x2House(&size_tile[size][noslope], t, maxz, noslope); break;
+					case SIZE_2x1: allowed = CheckTownBuild2House(&size_tile[size][noslope], t, maxz, noslope, DIAGDIR_SW); break;
+					case SIZE_1x2: allowed = CheckTownBuild2House(&size_tile[size][noslope], t, maxz, noslope, DIAGDIR_SE); break;
+					default: NOT_REACHED();
+				}
+			}
+			if (!allowed) continue;
+			tile = size_tile[size][noslope];
+		}
 
 		byte random_bits = Random();
 
@@ -2507,7 +2800,6 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 		MakeTownHouse(tile, t, construction_counter, construction_stage, house, random_bits);
 		UpdateTownRadius(t);
 		UpdateTownGrowthRate(t);
-		UpdateTownCargoes(t, tile);
 
 		return true;
 	}
@@ -2525,7 +2817,9 @@ static void DoClearTownHouseHelper(TileIndex tile, Town *t, HouseID house)
 {
 	assert(IsTileType(tile, MP_HOUSE));
 	DecreaseBuildingCount(t, house);
+	ChangeTownHouseCargo(t, tile, false);
 	DoClearSquare(tile);
+	UpdateTownCargoesAround(t, tile);
 	DeleteAnimatedTile(tile);
 
 	DeleteNewGRFInspectWindow(GSF_HOUSES, tile);
@@ -2590,10 +2884,9 @@ void ClearTownHouse(Town *t, TileIndex tile)
 	if (eflags & BUILDING_2_TILES_X)   DoClearTownHouseHelper(tile + TileDiffXY(1, 0), t, ++house);
 	if (eflags & BUILDING_HAS_4_TILES) DoClearTownHouseHelper(tile + TileDiffXY(1, 1), t, ++house);
 
-	UpdateTownRadius(t);
+	InvalidateStationAcceptanceCache(TileArea(tile, (eflags & BUILDING_2_TILES_X) ? 2 : 1, (eflags & BUILDING_2_TILES_Y) ? 2 : 1));
 
-	/* Update cargo acceptance. */
-	UpdateTownCargoes(t, tile);
+	UpdateTownRadius(t);
 }
 
 /**
@@ -2620,6 +2913,7 @@ CommandCost CmdRenameTown(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 	if (flags & DC_EXEC) {
 		free(t->name);
 		t->name = reset ? NULL : stredup(text);
+		_town_names.Invalidate();
 
 		t->UpdateVirtCoord();
 		InvalidateWindowData(WC_TOWN_DIRECTORY, 0, 1);
@@ -3209,10 +3503,10 @@ static void ForAllStationsNearTown(Town *t, Func func)
 	/* The efficiency of this search might be improved for large towns and many stations on the map,
 	 * by using an integer square root approximation giving a value not less than the true square root. */
 	uint search_radius = t->cache.squared_town_zone_radius[0] / 2;
-	ForAllStationsRadius(t->xy, search_radius, [&](const Station * st) {
-		if (DistanceSquare(st->xy, t->xy) <= t->cache.squared_town_zone_radius[0]) {
-			func(st);
-		}
+	ForAllStationsRadius(t->xy, search_radius, [&](TileIndex tile) {
+		return DistanceSquare(tile, t->xy) <= t->cache.squared_town_zone_radius[0];
+	}, [&](const Station * st) {
+		func(st);
 	});
 }
 
@@ -3584,7 +3878,7 @@ void TownsMonthlyLoop()
 		UpdateTownGrowth(t);
 		UpdateTownRating(t);
 		UpdateTownUnwanted(t);
-		UpdateTownCargoes(t);
+		UpdateTownCallbackCargoes(t);
 	}
 
 	UpdateTownCargoBitmap();
@@ -3655,4 +3949,6 @@ void ResetHouses()
 
 	/* Reset any overrides that have been set. */
 	_house_mngr.ResetOverride();
+
+	_town_house_candidates_valid = false;
 }
@@ -17,6 +17,7 @@
 #include "core/random_func.hpp"
 #include "genworld.h"
 #include "gfx_layout.h"
+#include "core/name_registry_type.hpp"
 
 #include "table/townname.h"
 
@@ -74,6 +75,27 @@ char *GetTownName(char *buff, const Town *t, const char *last)
 }
 
 
+/**
+ * Add the names of all towns, custom or generated, to a name registry.
+ * @param registry The registry to fill.
+ */
+static void FillTownNames(NameRegistry &registry)
+{
+	char buf[(MAX_LENGTH_TOWN_NAME_CHARS + 1) * MAX_CHAR_LENGTH];
+
+	const Town *t;
+	FOR_ALL_TOWNS(t) {
+		if (t->name != NULL) {
+			registry.Add(t->name);
+		} else {
+			GetTownName(buf, t, lastof(buf));
+			registry.Add(buf);
+		}
+	}
+}
+
+NameRegistry _town_names(&FillTownNames); ///< The names of the towns, as shown.
+
 /**
  * Verifies the town name is valid and unique.
  * @param r random bits
@@ -85,7 +107,6 @@ bool VerifyTownName(uint32 r, const TownNameParams *par, TownNames *town_names)
 {
 	/* reserve space for extra unicode character and terminating '\0' */
 	char buf1[(MAX_LENGTH_TOWN_NAME_CHARS + 1) * MAX_CHAR_LENGTH];
-	char buf2[(MAX_LENGTH_TOWN_NAME_CHARS + 1) * MAX_CHAR_LENGTH];
 
 	GetTownName(buf1, par, r, lastof(buf1));
 
@@ -96,17 +117,9 @@ bool VerifyTownName(uint32 r, const TownNameParams *par, TownNames *town_names)
 		if (town_names->find(buf1) != town_names->end()) return false;
 		town_names->insert(buf1);
 	} else {
-		const Town *t;
-		FOR_ALL_TOWNS(t) {
-			/* We can't just compare the numbers since
-			 * several numbers may map to a single name. */
-			const char *buf = t->name;
-			if (buf == NULL) {
-				GetTownName(buf2, t, lastof(buf2));
-				buf = buf2;
-			}
-			if (strcmp(buf1, buf) == 0) return false;
-		}
+		/* We can't just compare the numbers since
+		 * several numbers may map to a single name. */
+		if (_town_names.Contains(buf1)) return false;
 	}
 
 	return true;
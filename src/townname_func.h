@@ -20,4 +20,6 @@ char *GetTownName(char *buff, const Town *t, const char *last);
 bool VerifyTownName(uint32 r, const TownNameParams *par, TownNames *town_names = NULL);
 bool GenerateTownName(uint32 *townnameparts, TownNames *town_names = NULL);
 
+extern class NameRegistry _town_names;
+
 #endif /* TOWNNAME_FUNC_H */
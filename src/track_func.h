@@ -735,4 +735,15 @@ static inline DiagDirection VehicleExitDir(Direction direction, TrackBits track)
 	return diagdir;
 }
 
+extern uint32 _track_reservation_version;
+
+/**
+ * Note that a path reservation or the track it lies on has changed,
+ * which makes all cached ends of reservations stale.
+ */
+static inline void NotifyTrackReservationChange()
+{
+	if (++_track_reservation_version == 0) _track_reservation_version = 1;
+}
+
 #endif /* TRACK_FUNC_H */
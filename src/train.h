@@ -20,6 +20,7 @@
 #include "engine_base.h"
 #include "rail_map.h"
 #include "ground_vehicle.hpp"
+#include <deque>
 
 struct Train;
 
@@ -82,11 +83,43 @@ struct TrainCache {
 	int cached_max_curve_speed; ///< max consist speed limited by curves
 };
 
+/** The upcoming track choices of a train, as found by the pathfinder. */
+struct TrainPathCache {
+	std::deque<TrackdirByte> td; ///< Trackdir to take at each choice.
+	std::deque<TileIndex> tile;  ///< Tile of each choice.
+
+	inline bool empty() const { return this->td.empty(); }
+
+	inline size_t size() const
+	{
+		assert(this->td.size() == this->tile.size());
+		return this->td.size();
+	}
+
+	inline void clear()
+	{
+		this->td.clear();
+		this->tile.clear();
+	}
+};
+
+/** The end of the path reservation of a train, as found by FollowTrainReservation. */
+struct TrainReservationCache {
+	uint32 version;         ///< #_track_reservation_version the data is valid for; 0 when not valid.
+	TileIndex start_tile;   ///< Tile the reservation was followed from.
+	TrackdirByte start_td;  ///< Trackdir the reservation was followed from.
+	RailTypeByte railtype;  ///< Rail type of the train when following the reservation.
+	TileIndex end_tile;     ///< Last tile of the reservation.
+	TrackdirByte end_td;    ///< Reserved trackdir on the last tile.
+};
+
 /**
  * 'Train' is either a loco or a wagon.
  */
 struct Train FINAL : public GroundVehicle<Train, VEH_TRAIN> {
 	TrainCache tcache;
+	TrainPathCache path; ///< Cached path, only used for trains that do not reserve their path.
+	mutable TrainReservationCache rcache; ///< Cached end of the path reservation; not saved.
 
 	/* Link between the two ends of a multiheaded engine */
 	Train *other_multiheaded_part;
@@ -122,10 +155,12 @@ struct Train FINAL : public GroundVehicle<Train, VEH_TRAIN> {
 	bool IsInDepot() const { return this->track == TRACK_BIT_DEPOT; }
 	bool Tick();
 	void OnNewDay();
+	void OnServiceDepotSearch();
 	uint Crash(bool flooded = false);
 	Trackdir GetVehicleTrackdir() const;
 	TileIndex GetOrderStationLocation(StationID station);
 	bool FindClosestDepot(TileIndex *location, DestinationID *destination, bool *reverse);
+	void SetDestTile(TileIndex tile);
 
 	void ReserveTrackUnderConsist() const;
 
@@ -36,6 +36,7 @@
 #include "zoom_func.h"
 #include "newgrf_debug.h"
 #include "framerate_type.h"
+#include "core/name_registry_type.hpp"
 
 #include "table/strings.h"
 #include "table/train_cmd.h"
@@ -1399,7 +1400,9 @@ CommandCost CmdSellRailWagon(DoCommandFlag flags, Vehicle *t, uint16 data, uint3
 			DeleteVehicleOrders(first);
 
 			/* Copy other important data from the front engine */
+			_vehicle_names.Remove(new_head->name);
 			new_head->CopyVehicleConfigAndStatistics(first);
+			_vehicle_names.Add(new_head->name);
 			GroupStatistics::CountVehicle(new_head, 1); // after copying over the profit
 		} else if (v->IsPrimaryVehicle() && data & (MAKE_ORDER_BACKUP_FLAG >> 20)) {
 			OrderBackup::Backup(v, user);
@@ -1603,6 +1606,7 @@ void ReverseTrainSwapVeh(Train *v, int l, int r)
 		Swap(a->z_pos, b->z_pos);
 
 		SwapTrainFlags(&a->gv_flags, &b->gv_flags);
+		a->InvalidatePreparedSlopeResistance();
 
 		UpdateStatusAfterSwap(a);
 		UpdateStatusAfterSwap(b);
@@ -1611,6 +1615,7 @@ void ReverseTrainSwapVeh(Train *v, int l, int r)
 		 * This is a little bit redundant way, a->gv_flags will
 		 * be (re)set twice, but it reduces code duplication */
 		SwapTrainFlags(&a->gv_flags, &a->gv_flags);
+		a->InvalidatePreparedSlopeResistance();
 		UpdateStatusAfterSwap(a);
 	}
 }
@@ -1806,6 +1811,7 @@ void ReverseTrainDirection(Train *v)
 
 	/* Clear path reservation in front if train is not stuck. */
 	if (!HasBit(v->flags, VRF_TRAIN_STUCK)) FreeTrainTrackReservation(v);
+	v->path.clear();
 
 	/* Check if we were approaching a rail/road-crossing */
 	TileIndex crossing = TrainApproachingCrossingTile(v);
@@ -2310,11 +2316,14 @@ static const byte _initial_tile_subcoord[6][4][3] = {
  * @param[out] dest State and destination of the requested path
  * @return The best track the train should follow
  */
-static Track DoTrainPathfind(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool do_track_reservation, PBSTileInfo *dest)
+static Track DoTrainPathfind(Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool do_track_reservation, PBSTileInfo *dest)
 {
 	switch (_settings_game.pf.pathfinder_for_trains) {
-		case VPF_NPF: return NPFTrainChooseTrack(v, path_found, do_track_reservation, dest);
-		case VPF_YAPF: return YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest);
+		case VPF_NPF:
+			if (!v->path.empty()) v->path.clear();
+			return NPFTrainChooseTrack(v, path_found, do_track_reservation, dest);
+
+		case VPF_YAPF: return YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest, v->path);
 
 		default: NOT_REACHED();
 	}
@@ -2526,6 +2535,10 @@ static Track ChooseTrainTrack(Train *v, TileIndex tile, DiagDirection enterdir,
 
 	/* Quick return in case only one possible track is available */
 	if (KillFirstBit(tracks) == TRACK_BIT_NONE) {
+		if (!v->path.empty() && v->path.tile.front() == tile) {
+			/* Train expected a choice here, invalidate its path. */
+			v->path.clear();
+		}
 		Track track = FindFirstTrack(tracks);
 		/* We need to check for signals only here, as a junction tile can't have signals. */
 		if (track != INVALID_TRACK && HasPbsSignalOnTrackdir(tile, TrackEnterdirToTrackdir(track, enterdir))) {
@@ -2538,6 +2551,25 @@ static Track ChooseTrainTrack(Train *v, TileIndex tile, DiagDirection enterdir,
 		best_track = track;
 	}
 
+	/* Attempt to follow the cached path; it is only used while the train does not reserve its path. */
+	if (!v->path.empty()) {
+		if (do_track_reservation || v->path.tile.front() != tile) {
+			/* Train didn't expect a choice here, invalidate its path. */
+			v->path.clear();
+		} else {
+			Track track = TrackdirToTrack(v->path.td.front());
+
+			if (HasBit(tracks, track)) {
+				v->path.td.pop_front();
+				v->path.tile.pop_front();
+				return track;
+			}
+
+			/* Train expected a choice which is no longer available. */
+			v->path.clear();
+		}
+	}
+
 	PBSTileInfo   res_dest(tile, INVALID_TRACKDIR, false);
 	DiagDirection dest_enterdir = enterdir;
 	if (do_track_reservation) {
@@ -2789,6 +2821,18 @@ void Train::MarkDirty()
 	this->UpdateAcceleration();
 }
 
+/**
+ * Set the destination of the train. The cached path leads to the old
+ * destination, so it is dropped when the destination changes.
+ * @param tile The new destination.
+ */
+void Train::SetDestTile(TileIndex tile)
+{
+	if (tile == this->dest_tile) return;
+	this->path.clear();
+	this->dest_tile = tile;
+}
+
 /**
  * This function looks at the vehicle and updates its speed (cur_speed
  * and subspeed) variables. Furthermore, it returns the distance that
@@ -3093,6 +3137,7 @@ bool TrainController(Train *v, Vehicle *nomove, bool reverse)
 	Train *first = v->First();
 	Train *prev;
 	bool direction_changed = false; // has direction of any part changed?
+	ViewportDirtyBatch dirty_batch;  // the parts are close together, so mark them dirty in one go
 
 	/* For every vehicle after and including the given vehicle */
 	for (prev = v->Previous(); v != nomove; prev = v, v = v->Next()) {
@@ -3179,6 +3224,9 @@ bool TrainController(Train *v, Vehicle *nomove, bool reverse)
 						/* In front of a red signal */
 						Trackdir i = FindFirstTrackdir(trackdirbits);
 
+						/* Another route might be better now; search again at the next choice. */
+						if (!v->path.empty()) v->path.clear();
+
 						/* Don't handle stuck trains here. */
 						if (HasBit(v->flags, VRF_TRAIN_STUCK)) return false;
 
@@ -3970,6 +4018,12 @@ static void CheckIfTrainNeedsService(Train *v)
 	SetWindowWidgetDirty(WC_VEHICLE_VIEW, v->index, WID_VV_START_STOP);
 }
 
+/** Look for a depot to service at, as queued by the daily check. */
+void Train::OnServiceDepotSearch()
+{
+	if (this->IsFrontEngine()) CheckIfTrainNeedsService(this);
+}
+
 /** Update day counters of the train vehicle. */
 void Train::OnNewDay()
 {
@@ -3980,7 +4034,7 @@ void Train::OnNewDay()
 	if (this->IsFrontEngine()) {
 		CheckVehicleBreakdown(this);
 
-		CheckIfTrainNeedsService(this);
+		if (this->NeedsAutomaticServicing()) QueueServiceDepotSearch(this);
 
 		CheckOrders(this);
 
@@ -657,7 +657,7 @@ static void TileLoop_Trees(TileIndex tile)
 			MarkTileDirtyByTile(tile);
 		}
 	}
-	if (GetTreeCounter(tile) < 15) {
+	if (treeCounter < 15) {
 		AddTreeCounter(tile, 1);
 		return;
 	}
@@ -684,11 +684,12 @@ static void TileLoop_Trees(TileIndex tile)
 						FALLTHROUGH;
 
 					case 2: { // add a neighbouring tree
-						/* Don't plant extra trees if that's not allowed. */
+						/* Don't plant extra trees if that's not allowed. Nothing
+						 * visible changed then, so don't redraw the tile. */
 						if ((_settings_game.game_creation.landscape == LT_TROPIC && GetTropicZone(tile) == TROPICZONE_RAINFOREST) ?
 								_settings_game.construction.extra_tree_placement == ETP_NONE :
 								_settings_game.construction.extra_tree_placement != ETP_ALL) {
-							break;
+							return;
 						}
 
 						TreeType treetype = GetTreeType(tile);
@@ -12,16 +12,37 @@
 #include "stdafx.h"
 #include "tunnelbridge_map.h"
 
+#include <unordered_map>
+
 #include "safeguards.h"
 
+/**
+ * The other portal of each tunnel portal. The index is not part of the game
+ * state; it is rebuilt after loading.
+ */
+static std::unordered_map<TileIndex, TileIndex> _tunnel_partners;
+/** Number of tunnels of each axis in each row or column of the map and at each height, see #GetTunnelLineKey. */
+static std::unordered_map<uint, uint> _tunnels_per_line[AXIS_END];
+static bool _tunnel_index_valid = false; ///< Whether the tunnel index has all tunnels of the map.
 
 /**
- * Gets the other end of the tunnel. Where a vehicle would reappear when it
- * enters at the given tile.
- * @param tile the tile to search from.
- * @return the tile of the other end of the tunnel.
+ * Get the key of the row or column and height of a tunnel in #_tunnels_per_line.
+ * @param tile A tile in the row or column.
+ * @param z The height of the tunnel.
+ * @param axis The axis of the tunnel.
+ * @return The key.
  */
-TileIndex GetOtherTunnelEnd(TileIndex tile)
+static inline uint GetTunnelLineKey(TileIndex tile, int z, Axis axis)
+{
+	return (axis == AXIS_X ? TileY(tile) : TileX(tile)) * (MAX_TILE_HEIGHT + 1) + z;
+}
+
+/**
+ * Walk to the other end of the tunnel.
+ * @param tile One portal of the tunnel.
+ * @return The other portal.
+ */
+static TileIndex WalkToOtherTunnelEnd(TileIndex tile)
 {
 	DiagDirection dir = GetTunnelBridgeDirection(tile);
 	TileIndexDiff delta = TileOffsByDiagDir(dir);
@@ -39,6 +60,93 @@ TileIndex GetOtherTunnelEnd(TileIndex tile)
 	return tile;
 }
 
+/**
+ * Add a tunnel to the index; nothing happens when it is already present,
+ * like when road types are added to it.
+ * @param start_tile One portal of the tunnel.
+ * @param end_tile The other portal of the tunnel.
+ */
+void AddTunnelToIndex(TileIndex start_tile, TileIndex end_tile)
+{
+	if (!_tunnel_index_valid) return;
+	if (!_tunnel_partners.emplace(start_tile, end_tile).second) return;
+	_tunnel_partners.emplace(end_tile, start_tile);
+
+	Axis axis = DiagDirToAxis(GetTunnelBridgeDirection(start_tile));
+	_tunnels_per_line[axis][GetTunnelLineKey(start_tile, GetTileZ(start_tile), axis)]++;
+}
+
+/**
+ * Remove a tunnel from the index, before its portals are removed.
+ * @param tile One portal of the tunnel.
+ */
+void RemoveTunnelFromIndex(TileIndex tile)
+{
+	if (!_tunnel_index_valid) return;
+
+	std::unordered_map<TileIndex, TileIndex>::iterator it = _tunnel_partners.find(tile);
+	assert(it != _tunnel_partners.end());
+	TileIndex other = it->second;
+	_tunnel_partners.erase(it);
+	_tunnel_partners.erase(other);
+
+	Axis axis = DiagDirToAxis(GetTunnelBridgeDirection(tile));
+	std::unordered_map<uint, uint>::iterator line = _tunnels_per_line[axis].find(GetTunnelLineKey(tile, GetTileZ(tile), axis));
+	assert(line != _tunnels_per_line[axis].end());
+	if (--line->second == 0) _tunnels_per_line[axis].erase(line);
+}
+
+/** Forget all tunnels; the map is about to be set up without any. */
+void ResetTunnelIndex()
+{
+	_tunnel_partners.clear();
+	for (uint axis = AXIS_X; axis < AXIS_END; axis++) _tunnels_per_line[axis].clear();
+	_tunnel_index_valid = true;
+}
+
+/**
+ * Stop using the tunnel index, as the map is about to be loaded or converted
+ * without the index being kept up to date.
+ */
+void InvalidateTunnelIndex()
+{
+	ResetTunnelIndex();
+	_tunnel_index_valid = false;
+}
+
+/** Fill the tunnel index with all tunnels on the map. */
+void RebuildTunnelIndex()
+{
+	ResetTunnelIndex();
+
+	for (TileIndex t = 0; t < MapSize(); t++) {
+		if (!IsTunnelTile(t)) continue;
+		/* Only take the northern portals, which face towards the south. */
+		DiagDirection dir = GetTunnelBridgeDirection(t);
+		if (dir != DIAGDIR_SW && dir != DIAGDIR_SE) continue;
+		AddTunnelToIndex(t, WalkToOtherTunnelEnd(t));
+	}
+}
+
+/**
+ * Gets the other end of the tunnel. Where a vehicle would reappear when it
+ * enters at the given tile.
+ * @param tile the tile to search from.
+ * @return the tile of the other end of the tunnel.
+ */
+TileIndex GetOtherTunnelEnd(TileIndex tile)
+{
+	if (_tunnel_index_valid) {
+		std::unordered_map<TileIndex, TileIndex>::const_iterator it = _tunnel_partners.find(tile);
+		if (it != _tunnel_partners.end()) {
+			assert(IsTunnelTile(it->second) && GetTunnelBridgeDirection(it->second) == ReverseDiagDir(GetTunnelBridgeDirection(tile)));
+			return it->second;
+		}
+	}
+
+	return WalkToOtherTunnelEnd(tile);
+}
+
 
 /**
  * Is there a tunnel in the way in the given direction?
@@ -49,6 +157,12 @@ TileIndex GetOtherTunnelEnd(TileIndex tile)
  */
 bool IsTunnelInWayDir(TileIndex tile, int z, DiagDirection dir)
 {
+	/* Without any tunnel of this axis and height in the row or column there is nothing to find. */
+	if (_tunnel_index_valid && IsInsideMM(z, 0, MAX_TILE_HEIGHT + 1)) {
+		Axis axis = DiagDirToAxis(dir);
+		if (_tunnels_per_line[axis].count(GetTunnelLineKey(tile, z, axis)) == 0) return false;
+	}
+
 	TileIndexDiff delta = TileOffsByDiagDir(dir);
 	int height;
 
@@ -41,6 +41,12 @@ TileIndex GetOtherTunnelEnd(TileIndex);
 bool IsTunnelInWay(TileIndex, int z);
 bool IsTunnelInWayDir(TileIndex tile, int z, DiagDirection dir);
 
+void AddTunnelToIndex(TileIndex start_tile, TileIndex end_tile);
+void RemoveTunnelFromIndex(TileIndex tile);
+void ResetTunnelIndex();
+void InvalidateTunnelIndex();
+void RebuildTunnelIndex();
+
 /**
  * Makes a road tunnel entrance
  * @param t the entrance of the tunnel
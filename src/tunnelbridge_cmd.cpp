@@ -23,6 +23,8 @@
 #include "ship.h"
 #include "roadveh.h"
 #include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/road_regions.h"
+#include "pathfinder/water_regions.h"
 #include "newgrf_sound.h"
 #include "autoslope.h"
 #include "tunnelbridge_map.h"
@@ -505,6 +507,8 @@ CommandCost CmdBuildBridge(TileIndex end_tile, DoCommandFlag flags, uint32 p1, u
 				Owner owner_tram = HasBit(prev_roadtypes, ROADTYPE_TRAM) ? GetRoadOwner(tile_start, ROADTYPE_TRAM) : company;
 				MakeRoadBridgeRamp(tile_start, owner, owner_road, owner_tram, bridge_type, dir,                 roadtypes);
 				MakeRoadBridgeRamp(tile_end,   owner, owner_road, owner_tram, bridge_type, ReverseDiagDir(dir), roadtypes);
+				InvalidateRoadRegion(tile_start);
+				InvalidateRoadRegion(tile_end);
 				break;
 			}
 
@@ -512,12 +516,16 @@ CommandCost CmdBuildBridge(TileIndex end_tile, DoCommandFlag flags, uint32 p1, u
 				if (is_new_owner && c != NULL) c->infrastructure.water += (bridge_len + 2) * TUNNELBRIDGE_TRACKBIT_FACTOR;
 				MakeAqueductBridgeRamp(tile_start, owner, dir);
 				MakeAqueductBridgeRamp(tile_end,   owner, ReverseDiagDir(dir));
+				InvalidateWaterRegion(tile_start);
+				InvalidateWaterRegion(tile_end);
 				break;
 
 			default:
 				NOT_REACHED();
 		}
 
+		AddBridgeToIndex(tile_start, tile_end);
+
 		/* Mark all tiles dirty */
 		MarkBridgeDirty(tile_start, tile_end, AxisToDiagDir(direction), z_start);
 		DirtyCompanyInfrastructureWindows(company);
@@ -736,7 +744,10 @@ CommandCost CmdBuildTunnel(TileIndex start_tile, DoCommandFlag flags, uint32 p1,
 			}
 			MakeRoadTunnel(start_tile, company, direction,                 rts);
 			MakeRoadTunnel(end_tile,   company, ReverseDiagDir(direction), rts);
+			InvalidateRoadRegion(start_tile);
+			InvalidateRoadRegion(end_tile);
 		}
+		AddTunnelToIndex(start_tile, end_tile);
 		DirtyCompanyInfrastructureWindows(company);
 	}
 
@@ -827,6 +838,8 @@ static CommandCost DoClearTunnel(TileIndex tile, DoCommandFlag flags)
 	uint len = GetTunnelBridgeLength(tile, endtile) + 2; // Don't forget the end tiles.
 
 	if (flags & DC_EXEC) {
+		RemoveTunnelFromIndex(tile);
+
 		if (GetTunnelBridgeTransportType(tile) == TRANSPORT_RAIL) {
 			/* We first need to request values before calling DoClearSquare */
 			DiagDirection dir = GetTunnelBridgeDirection(tile);
@@ -868,6 +881,8 @@ static CommandCost DoClearTunnel(TileIndex tile, DoCommandFlag flags)
 
 			DoClearSquare(tile);
 			DoClearSquare(endtile);
+			InvalidateRoadRegion(tile);
+			InvalidateRoadRegion(endtile);
 		}
 	}
 	return CommandCost(EXPENSES_CONSTRUCTION, _price[PR_CLEAR_TUNNEL] * len);
@@ -942,8 +957,13 @@ static CommandCost DoClearBridge(TileIndex tile, DoCommandFlag flags)
 		}
 		DirtyCompanyInfrastructureWindows(owner);
 
+		RemoveBridgeFromIndex(tile);
 		DoClearSquare(tile);
 		DoClearSquare(endtile);
+		InvalidateRoadRegion(tile);
+		InvalidateRoadRegion(endtile);
+		InvalidateWaterRegion(tile);
+		InvalidateWaterRegion(endtile);
 		for (TileIndex c = tile + delta; c != endtile; c += delta) {
 			/* do not let trees appear from 'nowhere' after removing bridge */
 			if (IsNormalRoadTile(c) && GetRoadside(c) == ROADSIDE_TREES) {
@@ -1820,6 +1840,7 @@ static VehicleEnterTileStatus VehicleEnter_TunnelBridge(Vehicle *v, TileIndex ti
 					t->track = TRACK_BIT_WORMHOLE;
 					ClrBit(t->gv_flags, GVF_GOINGUP_BIT);
 					ClrBit(t->gv_flags, GVF_GOINGDOWN_BIT);
+					t->InvalidatePreparedSlopeResistance();
 					break;
 				}
 
@@ -1829,6 +1850,7 @@ static VehicleEnterTileStatus VehicleEnter_TunnelBridge(Vehicle *v, TileIndex ti
 					/* There are no slopes inside bridges / tunnels. */
 					ClrBit(rv->gv_flags, GVF_GOINGUP_BIT);
 					ClrBit(rv->gv_flags, GVF_GOINGDOWN_BIT);
+					rv->InvalidatePreparedSlopeResistance();
 					break;
 				}
 
@@ -26,6 +26,7 @@
 #include "newgrf_station.h"
 #include "group_gui.h"
 #include "strings_func.h"
+#include "string_func.h"
 #include "zoom_func.h"
 #include "date_func.h"
 #include "vehicle_func.h"
@@ -36,6 +37,7 @@
 #include "depot_func.h"
 #include "network/network.h"
 #include "core/pool_func.hpp"
+#include "core/mem_func.hpp"
 #include "economy_base.h"
 #include "articulated_vehicles.h"
 #include "roadstop_base.h"
@@ -45,6 +47,7 @@
 #include "sound_func.h"
 #include "effectvehicle_func.h"
 #include "effectvehicle_base.h"
+#include "disaster_vehicle.h"
 #include "vehiclelist.h"
 #include "bridge_map.h"
 #include "tunnel_map.h"
@@ -53,45 +56,38 @@
 #include "linkgraph/linkgraph.h"
 #include "linkgraph/refresh.h"
 #include "framerate_type.h"
+#include "console_func.h"
+#include "thread/thread_pool.h"
+#include "pathfinder/pathfinder_stats.h"
+#include "core/name_registry_type.hpp"
+
+#include <set>
+#include <vector>
+#include <chrono>
 
 #include "table/strings.h"
 
 #include "safeguards.h"
 
-/* Number of bits in the hash to use from each vehicle coord */
-static const uint GEN_HASHX_BITS = 6;
-static const uint GEN_HASHY_BITS = 6;
-
-/* Size of each hash bucket */
-static const uint GEN_HASHX_BUCKET_BITS = 7;
-static const uint GEN_HASHY_BUCKET_BITS = 6;
-
-/* Compute hash for vehicle coord */
-#define GEN_HASHX(x)    GB((x), GEN_HASHX_BUCKET_BITS + ZOOM_LVL_SHIFT, GEN_HASHX_BITS)
-#define GEN_HASHY(y)   (GB((y), GEN_HASHY_BUCKET_BITS + ZOOM_LVL_SHIFT, GEN_HASHY_BITS) << GEN_HASHX_BITS)
-#define GEN_HASH(x, y) (GEN_HASHY(y) + GEN_HASHX(x))
-
-/* Maximum size until hash repeats */
-static const int GEN_HASHX_SIZE = 1 << (GEN_HASHX_BUCKET_BITS + GEN_HASHX_BITS + ZOOM_LVL_SHIFT);
-static const int GEN_HASHY_SIZE = 1 << (GEN_HASHY_BUCKET_BITS + GEN_HASHY_BITS + ZOOM_LVL_SHIFT);
-
-/* Increments to reach next bucket in hash table */
-static const int GEN_HASHX_INC = 1;
-static const int GEN_HASHY_INC = 1 << GEN_HASHX_BITS;
-
-/* Mask to wrap-around buckets */
-static const uint GEN_HASHX_MASK =  (1 << GEN_HASHX_BITS) - 1;
-static const uint GEN_HASHY_MASK = ((1 << GEN_HASHY_BITS) - 1) << GEN_HASHX_BITS;
-
 VehicleID _new_vehicle_id;
 uint16 _returned_refit_capacity;      ///< Stores the capacity after a refit operation.
 uint16 _returned_mail_refit_capacity; ///< Stores the mail capacity after a refit operation (Aircraft only).
+uint32 _vehicle_tick_stamp;           ///< Stamp of the vehicle tick in progress for which values have been prepared, 0 if none.
 
 
 /** The pool with all our precious vehicles. */
 VehiclePool _vehicle_pool("Vehicle");
 INSTANTIATE_POOL_METHODS(Vehicle)
 
+/**
+ * Get the size of a vehicle slot in the pool, which has to fit every type of vehicle.
+ * @return Size of the largest vehicle type.
+ */
+/* static */ size_t Vehicle::GetPoolSlotSize()
+{
+	return max(max(max(sizeof(Train), sizeof(RoadVehicle)), max(sizeof(Ship), sizeof(Aircraft))), max(sizeof(EffectVehicle), sizeof(DisasterVehicle)));
+}
+
 
 /**
  * Determine shared bounds of all sprites.
@@ -377,17 +373,62 @@ const int TOTAL_HASH_MASK = TOTAL_HASH_SIZE - 1;
  * Profiling results show that 0 is fastest. */
 const int HASH_RES = 0;
 
-static Vehicle *_vehicle_tile_hash[TOTAL_HASH_SIZE];
+/**
+ * Bucket of the tile location hash. The vehicles are stored in a compact array,
+ * so walking a bucket does not chase pointers through the vehicle pool.
+ * The bucket holds the vehicles rather than their IDs, as every lookup calls
+ * its callback with the vehicle anyway. The pointers stay valid: the pool only
+ * reallocates its array of item pointers, never the items themselves; a vehicle
+ * leaves its bucket before it is freed; and #ResetVehicleHash empties all
+ * buckets when the pool is cleaned, which bypasses the destructors.
+ */
+struct VehicleTileHashBucket : SmallVector<Vehicle *, 4> {
+};
+
+static VehicleTileHashBucket _vehicle_tile_hash[TOTAL_HASH_SIZE];
+
+/**
+ * Tile location hash holding only the road vehicles. Road vehicles looking for
+ * the vehicle ahead of them in their lane only care about other road vehicles,
+ * so they walk this hash instead of wading through trains, effect vehicles
+ * and aircraft shadows in #_vehicle_tile_hash.
+ */
+static VehicleTileHashBucket _road_vehicle_tile_hash[TOTAL_HASH_SIZE];
+
+/**
+ * Call \a proc for the vehicles in a bucket of the tile location hash.
+ * @param bucket The bucket to walk.
+ * @param tile When not #INVALID_TILE, only call \a proc for vehicles on this tile.
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The proc that determines whether a vehicle will be "found".
+ * @param find_first Whether to return on the first found or iterate over all vehicles.
+ * @return The first vehicle \a proc returned when \a find_first is set, otherwise NULL.
+ */
+static inline Vehicle *VehicleFromTileHashBucket(VehicleTileHashBucket &bucket, TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
+{
+	for (uint i = 0; i < bucket.Length();) {
+		Vehicle *v = bucket[i];
+		if (tile != INVALID_TILE && v->tile != tile) {
+			i++;
+			continue;
+		}
+
+		Vehicle *a = proc(v, data);
+		if (find_first && a != NULL) return a;
+
+		/* When proc removed the vehicle from the bucket, another one took its place. */
+		if (i < bucket.Length() && bucket[i] == v) i++;
+	}
+
+	return NULL;
+}
 
-static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first)
+static Vehicle *VehicleFromTileHash(VehicleTileHashBucket *hash, int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first)
 {
 	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
 		for (int x = xl; ; x = (x + 1) & HASH_MASK) {
-			Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
-			for (; v != NULL; v = v->hash_tile_next) {
-				Vehicle *a = proc(v, data);
-				if (find_first && a != NULL) return a;
-			}
+			Vehicle *a = VehicleFromTileHashBucket(hash[(x + y) & TOTAL_HASH_MASK], INVALID_TILE, data, proc, find_first);
+			if (a != NULL) return a;
 			if (x == xu) break;
 		}
 		if (y == yu) break;
@@ -406,9 +447,10 @@ static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, void *data,
  * @param proc The proc that determines whether a vehicle will be "found".
  * @param find_first Whether to return on the first found or iterate over
  *                   all vehicles
+ * @param hash The tile location hash to search in.
  * @return the best matching or first vehicle (depending on find_first).
  */
-static Vehicle *VehicleFromPosXY(int x, int y, void *data, VehicleFromPosProc *proc, bool find_first)
+static Vehicle *VehicleFromPosXY(int x, int y, void *data, VehicleFromPosProc *proc, bool find_first, VehicleTileHashBucket *hash = _vehicle_tile_hash)
 {
 	const int COLL_DIST = 6;
 
@@ -418,7 +460,7 @@ static Vehicle *VehicleFromPosXY(int x, int y, void *data, VehicleFromPosProc *p
 	int yl = GB((y - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
 	int yu = GB((y + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
 
-	return VehicleFromTileHash(xl, yl, xu, yu, data, proc, find_first);
+	return VehicleFromTileHash(hash, xl, yl, xu, yu, data, proc, find_first);
 }
 
 /**
@@ -464,22 +506,15 @@ bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
  * @param proc The proc that determines whether a vehicle will be "found".
  * @param find_first Whether to return on the first found or iterate over
  *                   all vehicles
+ * @param hash The tile location hash to search in.
  * @return the best matching or first vehicle (depending on find_first).
  */
-static Vehicle *VehicleFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
+static Vehicle *VehicleFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first, VehicleTileHashBucket *hash = _vehicle_tile_hash)
 {
 	int x = GB(TileX(tile), HASH_RES, HASH_BITS);
 	int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
 
-	Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
-	for (; v != NULL; v = v->hash_tile_next) {
-		if (v->tile != tile) continue;
-
-		Vehicle *a = proc(v, data);
-		if (find_first && a != NULL) return a;
-	}
-
-	return NULL;
+	return VehicleFromTileHashBucket(hash[(x + y) & TOTAL_HASH_MASK], tile, data, proc, find_first);
 }
 
 /**
@@ -515,6 +550,31 @@ bool HasVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
 	return VehicleFromPos(tile, data, proc, true) != NULL;
 }
 
+/**
+ * Like #FindVehicleOnPos, but only calls \a proc for road vehicles.
+ * The same rules about the order independence of \a proc apply.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The proc that determines whether a vehicle will be "found".
+ */
+void FindRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
+{
+	VehicleFromPos(tile, data, proc, false, _road_vehicle_tile_hash);
+}
+
+/**
+ * Like #FindVehicleOnPosXY, but only calls \a proc for road vehicles.
+ * The same rules about the order independence of \a proc apply.
+ * @param x    The X location on the map
+ * @param y    The Y location on the map
+ * @param data Arbitrary data passed to proc
+ * @param proc The proc that determines whether a vehicle will be "found".
+ */
+void FindRoadVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
+{
+	VehicleFromPosXY(x, y, data, proc, false, _road_vehicle_tile_hash);
+}
+
 /**
  * Callback that returns 'real' vehicles lower or at height \c *(int*)data .
  * @param v Vehicle to examine.
@@ -609,73 +669,246 @@ CommandCost EnsureNoTrainOnTrackBits(TileIndex tile, TrackBits track_bits)
 	return CommandCost();
 }
 
+/**
+ * Move a road vehicle to another bucket of the road vehicle tile location hash.
+ * @param v The road vehicle to move.
+ * @param new_hash The bucket to move to, or NULL to remove it from the hash.
+ */
+static void UpdateRoadVehicleTileHash(RoadVehicle *v, VehicleTileHashBucket *new_hash)
+{
+	VehicleTileHashBucket *old_hash = v->hash_road_current;
+	if (old_hash == new_hash) return;
+
+	if (old_hash != NULL) {
+		assert((*old_hash)[v->hash_road_pos] == v);
+		RoadVehicle *last = RoadVehicle::From(*(old_hash->End() - 1));
+		last->hash_road_pos = v->hash_road_pos;
+		old_hash->Erase(old_hash->Get(v->hash_road_pos));
+	}
+
+	if (new_hash != NULL) {
+		v->hash_road_pos = new_hash->Length();
+		*new_hash->Append() = v;
+	}
+
+	v->hash_road_current = new_hash;
+}
+
 static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 {
-	Vehicle **old_hash = v->hash_tile_current;
-	Vehicle **new_hash;
+	VehicleTileHashBucket *old_hash = v->hash_tile_current;
+	VehicleTileHashBucket *new_hash;
+	uint hash_index = 0;
 
 	if (remove) {
 		new_hash = NULL;
 	} else {
 		int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
 		int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-		new_hash = &_vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+		hash_index = (x + y) & TOTAL_HASH_MASK;
+		new_hash = &_vehicle_tile_hash[hash_index];
 	}
 
+	if (v->type == VEH_ROAD) UpdateRoadVehicleTileHash(RoadVehicle::From(v), remove ? NULL : &_road_vehicle_tile_hash[hash_index]);
+
 	if (old_hash == new_hash) return;
 
-	/* Remove from the old position in the hash table */
+	/* Remove from the old position in the hash table; the last vehicle of the bucket takes its place. */
 	if (old_hash != NULL) {
-		if (v->hash_tile_next != NULL) v->hash_tile_next->hash_tile_prev = v->hash_tile_prev;
-		*v->hash_tile_prev = v->hash_tile_next;
+		assert((*old_hash)[v->hash_tile_pos] == v);
+		Vehicle *last = *(old_hash->End() - 1);
+		last->hash_tile_pos = v->hash_tile_pos;
+		old_hash->Erase(old_hash->Get(v->hash_tile_pos));
 	}
 
-	/* Insert vehicle at beginning of the new position in the hash table */
+	/* Append the vehicle to the new position in the hash table */
 	if (new_hash != NULL) {
-		v->hash_tile_next = *new_hash;
-		if (v->hash_tile_next != NULL) v->hash_tile_next->hash_tile_prev = &v->hash_tile_next;
-		v->hash_tile_prev = new_hash;
-		*new_hash = v;
+		v->hash_tile_pos = new_hash->Length();
+		*new_hash->Append() = v;
 	}
 
 	/* Remember current hash position */
 	v->hash_tile_current = new_hash;
 }
 
-static Vehicle *_vehicle_viewport_hash[1 << (GEN_HASHX_BITS + GEN_HASHY_BITS)];
+/**
+ * Print the occupancy of the tile location hash to the console.
+ */
+void PrintVehicleTileHashStats()
+{
+	static const uint HISTOGRAM_SIZE = 8;
+	uint histogram[HISTOGRAM_SIZE] = {};
+	uint vehicles = 0;
+	uint longest = 0;
+
+	for (uint i = 0; i < TOTAL_HASH_SIZE; i++) {
+		uint length = _vehicle_tile_hash[i].Length();
+		vehicles += length;
+		longest = max(longest, length);
+		histogram[min(length, HISTOGRAM_SIZE - 1)]++;
+	}
 
-static void UpdateVehicleViewportHash(Vehicle *v, int x, int y)
+	IConsolePrintF(CC_DEFAULT, "Vehicle tile hash: %u buckets, %u vehicles, longest bucket %u", TOTAL_HASH_SIZE, vehicles, longest);
+	for (uint i = 0; i < HISTOGRAM_SIZE; i++) {
+		IConsolePrintF(CC_DEFAULT, "  %u%s vehicles: %u buckets", i, i == HISTOGRAM_SIZE - 1 ? "+" : "", histogram[i]);
+	}
+}
+
+/**
+ * Entry of the viewport hash. The bounding box is kept next to the vehicle,
+ * so walking a bucket only touches the vehicles that are actually drawn.
+ */
+struct VehicleViewportHashEntry {
+	Rect coord; ///< Copy of Vehicle::coord.
+	Vehicle *v; ///< The vehicle.
+};
+
+/** Bucket of the viewport hash. */
+struct VehicleViewportHashBucket : SmallVector<VehicleViewportHashEntry, 4> {
+};
+
+/* Minimum size of each hash bucket, in bits of the viewport coordinates */
+static const uint GEN_HASHX_MIN_BUCKET_BITS = 7 + ZOOM_LVL_SHIFT;
+static const uint GEN_HASHY_MIN_BUCKET_BITS = 6 + ZOOM_LVL_SHIFT;
+
+/* Bounds of the number of buckets in the hash, in bits */
+static const uint GEN_HASH_MIN_BITS = 12;
+static const uint GEN_HASH_MAX_BITS = 18;
+
+static std::vector<VehicleViewportHashBucket> _vehicle_viewport_hash; ///< The viewport hash of the vehicles.
+static uint _vehicle_viewport_hash_bits_x;        ///< Number of bits in the hash to use from the x coordinate.
+static uint _vehicle_viewport_hash_bits_y;        ///< Number of bits in the hash to use from the y coordinate.
+static uint _vehicle_viewport_hash_bucket_bits_x; ///< Width of each bucket, in bits of the x coordinate.
+static uint _vehicle_viewport_hash_bucket_bits_y; ///< Height of each bucket, in bits of the y coordinate.
+static uint _vehicle_viewport_hash_max_bits;      ///< Number of bits of a hash covering the whole map with the smallest buckets.
+static uint _vehicle_viewport_hash_count;         ///< Number of vehicles in the viewport hash.
+static uint _vehicle_viewport_hash_map_size;      ///< Size of the map the layout of the viewport hash was chosen for.
+
+/* Compute hash for vehicle coord */
+static inline uint GenHashX(int x) { return GB(x, _vehicle_viewport_hash_bucket_bits_x, _vehicle_viewport_hash_bits_x); }
+static inline uint GenHashY(int y) { return GB(y, _vehicle_viewport_hash_bucket_bits_y, _vehicle_viewport_hash_bits_y) << _vehicle_viewport_hash_bits_x; }
+static inline uint GenHash(int x, int y) { return GenHashY(y) + GenHashX(x); }
+
+/**
+ * Choose the layout of the viewport hash and empty it.
+ * The hash covers the whole map without wrapping around, with about one bucket
+ * per vehicle; when that would need too many buckets, the buckets get larger.
+ * @param vehicles Number of vehicles to prepare the hash for.
+ */
+static void SetupVehicleViewportHash(uint vehicles)
 {
-	Vehicle **old_hash, **new_hash;
-	int old_x = v->coord.left;
-	int old_y = v->coord.top;
+	/* Extent of the map in viewport coordinates, see RemapCoords. */
+	uint extent_x = (MapSizeX() + MapSizeY()) * TILE_SIZE * 2 * ZOOM_LVL_BASE;
+	uint extent_y = (MapSizeX() + MapSizeY()) * TILE_SIZE * ZOOM_LVL_BASE;
 
-	new_hash = (x == INVALID_COORD) ? NULL : &_vehicle_viewport_hash[GEN_HASH(x, y)];
-	old_hash = (old_x == INVALID_COORD) ? NULL : &_vehicle_viewport_hash[GEN_HASH(old_x, old_y)];
+	_vehicle_viewport_hash_map_size = MapSize();
 
-	if (old_hash == new_hash) return;
+	uint bits_x = max<int>(FindLastBit(extent_x - 1) + 1 - GEN_HASHX_MIN_BUCKET_BITS, 1);
+	uint bits_y = max<int>(FindLastBit(extent_y - 1) + 1 - GEN_HASHY_MIN_BUCKET_BITS, 1);
+	_vehicle_viewport_hash_max_bits = bits_x + bits_y;
 
-	/* remove from hash table? */
-	if (old_hash != NULL) {
-		if (v->hash_viewport_next != NULL) v->hash_viewport_next->hash_viewport_prev = v->hash_viewport_prev;
-		*v->hash_viewport_prev = v->hash_viewport_next;
+	uint budget = Clamp(FindLastBit(max(vehicles, 1U)) + 1, GEN_HASH_MIN_BITS, GEN_HASH_MAX_BITS);
+	while (bits_x + bits_y > budget) {
+		if (bits_x >= bits_y) {
+			bits_x--;
+		} else {
+			bits_y--;
+		}
 	}
 
-	/* insert into hash table? */
-	if (new_hash != NULL) {
-		v->hash_viewport_next = *new_hash;
-		if (v->hash_viewport_next != NULL) v->hash_viewport_next->hash_viewport_prev = &v->hash_viewport_next;
-		v->hash_viewport_prev = new_hash;
-		*new_hash = v;
+	_vehicle_viewport_hash_bits_x = bits_x;
+	_vehicle_viewport_hash_bits_y = bits_y;
+	_vehicle_viewport_hash_bucket_bits_x = FindLastBit(extent_x - 1) + 1 - bits_x;
+	_vehicle_viewport_hash_bucket_bits_y = FindLastBit(extent_y - 1) + 1 - bits_y;
+	_vehicle_viewport_hash_bucket_bits_x = max(_vehicle_viewport_hash_bucket_bits_x, GEN_HASHX_MIN_BUCKET_BITS);
+	_vehicle_viewport_hash_bucket_bits_y = max(_vehicle_viewport_hash_bucket_bits_y, GEN_HASHY_MIN_BUCKET_BITS);
+
+	std::vector<VehicleViewportHashBucket>(1 << (bits_x + bits_y)).swap(_vehicle_viewport_hash);
+	_vehicle_viewport_hash_count = 0;
+}
+
+/**
+ * Move a vehicle to its place in the viewport hash.
+ * @param v The vehicle.
+ * @param coord The new bounding box of the vehicle, or \c NULL to remove it from the hash.
+ */
+static void UpdateVehicleViewportHash(Vehicle *v, const Rect *coord)
+{
+	VehicleViewportHashBucket *old_hash = v->hash_viewport_current;
+	VehicleViewportHashBucket *new_hash = (coord == NULL) ? NULL : &_vehicle_viewport_hash[GenHash(coord->left, coord->top)];
+
+	if (old_hash != new_hash) {
+		/* Remove from the old position in the hash table; the last vehicle of the bucket takes its place. */
+		if (old_hash != NULL) {
+			assert((*old_hash)[v->hash_viewport_pos].v == v);
+			Vehicle *last = (old_hash->End() - 1)->v;
+			last->hash_viewport_pos = v->hash_viewport_pos;
+			old_hash->Erase(old_hash->Get(v->hash_viewport_pos));
+			_vehicle_viewport_hash_count--;
+		}
+
+		/* Append the vehicle to the new position in the hash table */
+		if (new_hash != NULL) {
+			v->hash_viewport_pos = new_hash->Length();
+			new_hash->Append()->v = v;
+			_vehicle_viewport_hash_count++;
+		}
+
+		v->hash_viewport_current = new_hash;
 	}
+
+	if (new_hash != NULL) (*new_hash)[v->hash_viewport_pos].coord = *coord;
+}
+
+/**
+ * Give the viewport hash more buckets when the number of vehicles outgrew it,
+ * or a new layout when it was chosen for a map of another size.
+ */
+static void GrowVehicleViewportHash()
+{
+	uint bits = _vehicle_viewport_hash_bits_x + _vehicle_viewport_hash_bits_y;
+	if (_vehicle_viewport_hash_map_size == MapSize() &&
+			(bits >= min(GEN_HASH_MAX_BITS, _vehicle_viewport_hash_max_bits) || _vehicle_viewport_hash_count <= (2U << bits))) {
+		return;
+	}
+
+	SetupVehicleViewportHash(_vehicle_viewport_hash_count);
+
+	Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		if (v->hash_viewport_current == NULL) continue;
+		v->hash_viewport_current = NULL;
+		UpdateVehicleViewportHash(v, &v->coord);
+	}
+}
+
+/**
+ * Print the layout and occupancy of the viewport hash to the console.
+ */
+void PrintVehicleViewportHashStats()
+{
+	uint longest = 0;
+	for (const VehicleViewportHashBucket &bucket : _vehicle_viewport_hash) longest = max(longest, bucket.Length());
+
+	IConsolePrintF(CC_DEFAULT, "Vehicle viewport hash: %u x %u buckets of %u x %u, %u vehicles, longest bucket %u",
+			1U << _vehicle_viewport_hash_bits_x, 1U << _vehicle_viewport_hash_bits_y,
+			1U << _vehicle_viewport_hash_bucket_bits_x, 1U << _vehicle_viewport_hash_bucket_bits_y,
+			_vehicle_viewport_hash_count, longest);
 }
 
 void ResetVehicleHash()
 {
 	Vehicle *v;
-	FOR_ALL_VEHICLES(v) { v->hash_tile_current = NULL; }
-	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
-	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+	FOR_ALL_VEHICLES(v) {
+		v->hash_tile_current = NULL;
+		if (v->type == VEH_ROAD) RoadVehicle::From(v)->hash_road_current = NULL;
+		v->hash_viewport_current = NULL;
+	}
+	SetupVehicleViewportHash((uint)Vehicle::GetNumItems());
+	for (uint i = 0; i < TOTAL_HASH_SIZE; i++) {
+		_vehicle_tile_hash[i].Clear();
+		_road_vehicle_tile_hash[i].Clear();
+	}
 }
 
 void ResetVehicleColourMap()
@@ -691,9 +924,43 @@ void ResetVehicleColourMap()
 typedef SmallMap<Vehicle *, bool, 4> AutoreplaceMap;
 static AutoreplaceMap _vehicles_to_autoreplace;
 
+/**
+ * Vehicles waiting for their search for a depot to service at. These
+ * searches do not need an answer in the tick they are asked for, so they
+ * are spread over the next ticks. The set is ordered by vehicle index, so
+ * it only depends on which vehicles have #VF_SERVICE_SEARCH_QUEUED set.
+ */
+static std::set<VehicleID> _service_depot_searches;
+static const uint SERVICE_DEPOT_SEARCH_SPREAD = 8; ///< Number of ticks the queued depot searches are spread over.
+
+/**
+ * Queue the search for a depot to service at for a vehicle.
+ * @param v The vehicle.
+ */
+void QueueServiceDepotSearch(Vehicle *v)
+{
+	SetBit(v->vehicle_flags, VF_SERVICE_SEARCH_QUEUED);
+	_service_depot_searches.insert(v->index);
+}
+
+/** Run the queued depot searches that are due this tick. */
+static void RunServiceDepotSearches()
+{
+	if (_game_mode != GM_NORMAL) return;
+
+	for (uint n = CeilDiv((uint)_service_depot_searches.size(), SERVICE_DEPOT_SEARCH_SPREAD); n > 0 && !_service_depot_searches.empty(); n--) {
+		Vehicle *v = Vehicle::Get(*_service_depot_searches.begin());
+		_service_depot_searches.erase(_service_depot_searches.begin());
+
+		ClrBit(v->vehicle_flags, VF_SERVICE_SEARCH_QUEUED);
+		v->OnServiceDepotSearch();
+	}
+}
+
 void InitializeVehicles()
 {
 	_vehicles_to_autoreplace.Reset();
+	_service_depot_searches.clear();
 	ResetVehicleHash();
 }
 
@@ -804,6 +1071,8 @@ void Vehicle::PreDestructor()
 {
 	if (CleaningPool()) return;
 
+	if (HasBit(this->vehicle_flags, VF_SERVICE_SEARCH_QUEUED)) _service_depot_searches.erase(this->index);
+
 	if (Station::IsValidID(this->last_station_visited)) {
 		Station *st = Station::Get(this->last_station_visited);
 		st->loading_vehicles.remove(this);
@@ -864,15 +1133,22 @@ void Vehicle::PreDestructor()
 	StopGlobalFollowVehicle(this);
 
 	ReleaseDisastersTargetingVehicle(this->index);
+
+	/* Leave the tile hash while the derived part, which holds the position
+	 * in the road vehicle tile hash, still exists. */
+	UpdateVehicleTileHash(this, true);
 }
 
 Vehicle::~Vehicle()
 {
 	if (CleaningPool()) {
 		this->cargo.OnCleanPool();
+		_vehicle_names.Invalidate();
 		return;
 	}
 
+	_vehicle_names.Remove(this->name);
+
 	/* sometimes, eg. for disaster vehicles, when company bankrupts, when removing crashed/flooded vehicles,
 	 * it may happen that vehicle chain is deleted when visible */
 	if (!(this->vehstatus & VS_HIDDEN)) this->MarkAllViewportsDirty();
@@ -882,8 +1158,9 @@ Vehicle::~Vehicle()
 
 	delete v;
 
-	UpdateVehicleTileHash(this, true);
-	UpdateVehicleViewportHash(this, INVALID_COORD, 0);
+	/* Vehicles of companies already left the tile hash in PreDestructor. */
+	if (this->type >= VEH_COMPANY_END) UpdateVehicleTileHash(this, true);
+	UpdateVehicleViewportHash(this, NULL);
 	DeleteVehicleNews(this->index, INVALID_STRING_ID);
 	DeleteNewGRFInspectWindow(GetGrfSpecFeature(this->type), this->index);
 }
@@ -909,6 +1186,12 @@ void VehicleEnteredDepotThisTick(Vehicle *v)
  * Increases the day counter for all vehicles and calls 1-day and 32-day handlers.
  * Each tick, it processes vehicles with "index % DAY_TICKS == _date_fract",
  * so each day, all vehicles are processes in DAY_TICKS steps.
+ * @note Unlike #PrepareVehicleTicks this can't be split into a parallel and a
+ *       serial phase: breakdown checks draw from the game's random generator,
+ *       and the running costs, servicing checks and the 32-day callback all
+ *       resolve NewGRF callbacks, which share the temporary storage. The depot
+ *       searches for servicing, the expensive part, are already deferred and
+ *       spread over later ticks by #RunServiceDepotSearches.
  */
 static void RunVehicleDayProc()
 {
@@ -935,16 +1218,129 @@ static void RunVehicleDayProc()
 			}
 		}
 
+		/* Merge the cargo packets that piled up in the last 32 days. */
+		if ((v->day_counter & 0x1F) == 0) v->cargo.Compact();
+
 		/* This is called once per day for each vehicle, but not in the first tick of the day */
 		v->OnNewDay();
 	}
 }
 
+/** Number of consists a worker thread prepares at once. */
+static const uint VEHICLE_PREPARE_CHUNK_SIZE = 128;
+
+/**
+ * Prepare the tick of a range of consists.
+ * @param data  Array with the front vehicles of the consists.
+ * @param first First consist to prepare.
+ * @param last  One past the last consist to prepare.
+ */
+static void PrepareVehicleTickRange(void *data, uint first, uint last)
+{
+	Vehicle **consists = (Vehicle **)data;
+	for (uint i = first; i < last; i++) {
+		Vehicle *v = consists[i];
+		if (v->type == VEH_TRAIN) {
+			Train::From(v)->PrepareSlopeResistance();
+		} else {
+			RoadVehicle::From(v)->PrepareSlopeResistance();
+		}
+	}
+}
+
+/**
+ * Read-only phase of the vehicle tick. Values that only depend on the state of
+ * a single consist are computed up front for all trains and road vehicles, spread
+ * over the worker threads. The serial tick in pool order then uses them as long as
+ * nothing invalidated them, so the outcome is exactly the same as without this phase.
+ */
+static void PrepareVehicleTicks()
+{
+	static SmallVector<Vehicle *, 64> consists;
+	consists.Clear();
+
+	static uint32 tick_counter = 0;
+	if (++tick_counter == 0) tick_counter = 1;
+	_vehicle_tick_stamp = tick_counter;
+
+	Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		if (v->vehstatus & VS_CRASHED) continue;
+		if ((v->type == VEH_TRAIN && Train::From(v)->IsFrontEngine()) || (v->type == VEH_ROAD && RoadVehicle::From(v)->IsFrontEngine())) {
+			*consists.Append() = v;
+		}
+	}
+
+	ThreadPoolParallelFor(&PrepareVehicleTickRange, consists.Begin(), consists.Length(), VEHICLE_PREPARE_CHUNK_SIZE);
+}
+
+/** The time spent ticking vehicles, by company and vehicle type, indexed like #_pathfinder_stats. They are not part of the game state. */
+VehicleTickStats _vehicle_tick_stats[PF_STATS_NO_COMPANY + 1][VEH_COMPANY_END];
+bool _vehicle_tick_stats_enabled = false; ///< Whether the vehicle ticks are timed; only once someone asked for #_vehicle_tick_stats.
+
+/** Forget all vehicle tick statistics. */
+void ResetVehicleTickStats()
+{
+	MemSetT(&_vehicle_tick_stats[0][0], 0, lengthof(_vehicle_tick_stats) * VEH_COMPANY_END);
+}
+
+/** Start timing the vehicle ticks, when that is not done already. */
+void StartVehicleTickStats()
+{
+	if (_vehicle_tick_stats_enabled) return;
+
+	_vehicle_tick_stats_enabled = true;
+	ResetVehicleTickStats();
+}
+
+/**
+ * Print the time spent ticking the vehicles of each company to the console,
+ * together with the part of it spent in the pathfinders.
+ */
+void ConPrintVehicleTickStats()
+{
+	static const char * const TYPE_NAMES[VEH_COMPANY_END] = { "trains", "road vehicles", "ships", "aircraft" };
+
+	uint64 total_ns = 0;
+	for (uint c = 0; c < lengthof(_vehicle_tick_stats); c++) {
+		for (VehicleType type = VEH_BEGIN; type < VEH_COMPANY_END; type++) total_ns += _vehicle_tick_stats[c][type].time_ns;
+	}
+	if (total_ns == 0) {
+		IConsolePrint(CC_DEFAULT, "No vehicle ticks recorded.");
+		return;
+	}
+
+	for (uint c = 0; c < lengthof(_vehicle_tick_stats); c++) {
+		for (VehicleType type = VEH_BEGIN; type < VEH_COMPANY_END; type++) {
+			const VehicleTickStats &stats = _vehicle_tick_stats[c][type];
+			if (stats.ticks == 0) continue;
+
+			char name[512];
+			if (c == PF_STATS_NO_COMPANY) {
+				strecpy(name, "No company", lastof(name));
+			} else if (Company::IsValidID(c)) {
+				char company[448];
+				SetDParam(0, c);
+				GetString(company, STR_COMPANY_NAME, lastof(company));
+				seprintf(name, lastof(name), "Company %u (%s)", c + 1, company);
+			} else {
+				seprintf(name, lastof(name), "Company %u", c + 1);
+			}
+
+			uint64 pf_us = _pathfinder_stats[c][type].time_us;
+			IConsolePrintF(CC_DEFAULT, "%s, %s: " OTTD_PRINTF64 " ticks, " OTTD_PRINTF64 " us (%.2f us per tick, %.1f%% of all), pathfinder " OTTD_PRINTF64 " us",
+					name, TYPE_NAMES[type], stats.ticks, stats.time_ns / 1000,
+					stats.time_ns / 1000.0 / stats.ticks, 100.0 * stats.time_ns / total_ns, pf_us);
+		}
+	}
+}
+
 void CallVehicleTicks()
 {
 	_vehicles_to_autoreplace.Clear();
 
 	RunVehicleDayProc();
+	RunServiceDepotSearches();
 
 	{
 		PerformanceMeasurer framerate(PFE_GL_ECONOMY);
@@ -956,10 +1352,28 @@ void CallVehicleTicks()
 	PerformanceAccumulator::Reset(PFE_GL_SHIPS);
 	PerformanceAccumulator::Reset(PFE_GL_AIRCRAFT);
 
+	if (_settings_client.gui.threaded_vehicle_ticks) PrepareVehicleTicks();
+
 	Vehicle *v;
 	FOR_ALL_VEHICLES(v) {
+		/* Only the primary vehicles do the bulk of the work; the owner and type are
+		 * taken before the tick as the vehicle could be deleted by it. */
+		VehicleTickStats *stats = NULL;
+		std::chrono::steady_clock::time_point start;
+		if (_vehicle_tick_stats_enabled && v->IsPrimaryVehicle()) {
+			stats = &_vehicle_tick_stats[v->owner < MAX_COMPANIES ? (uint)v->owner : PF_STATS_NO_COMPANY][v->type];
+			start = std::chrono::steady_clock::now();
+		}
+
 		/* Vehicle could be deleted in this tick */
-		if (!v->Tick()) {
+		bool alive = v->Tick();
+
+		if (stats != NULL) {
+			stats->ticks++;
+			stats->time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		if (!alive) {
 			assert(Vehicle::Get(vehicle_index) == NULL);
 			continue;
 		}
@@ -1025,6 +1439,9 @@ void CallVehicleTicks()
 			}
 		}
 	}
+	_vehicle_tick_stamp = 0;
+
+	GrowVehicleViewportHash();
 
 	Backup<CompanyByte> cur_company(_current_company, FILE_LINE);
 	for (AutoreplaceMap::iterator it = _vehicles_to_autoreplace.Begin(); it != _vehicles_to_autoreplace.End(); it++) {
@@ -1116,40 +1533,63 @@ void ViewportAddVehicles(DrawPixelInfo *dpi)
 	const int t = dpi->top;
 	const int b = dpi->top + dpi->height;
 
+	/* Maximum size until hash repeats */
+	const int hash_x_size = 1 << (_vehicle_viewport_hash_bucket_bits_x + _vehicle_viewport_hash_bits_x);
+	const int hash_y_size = 1 << (_vehicle_viewport_hash_bucket_bits_y + _vehicle_viewport_hash_bits_y);
+
+	/* Increments to reach next bucket in hash table */
+	const uint hash_x_inc = 1;
+	const uint hash_y_inc = 1 << _vehicle_viewport_hash_bits_x;
+
+	/* Mask to wrap-around buckets */
+	const uint hash_x_mask = (1 << _vehicle_viewport_hash_bits_x) - 1;
+	const uint hash_y_mask = ((1 << _vehicle_viewport_hash_bits_y) - 1) << _vehicle_viewport_hash_bits_x;
+
 	/* The hash area to scan */
-	int xl, xu, yl, yu;
+	uint xl, xu, yl, yu;
 
-	if (dpi->width + (MAX_VEHICLE_PIXEL_X * ZOOM_LVL_BASE) < GEN_HASHX_SIZE) {
-		xl = GEN_HASHX(l - MAX_VEHICLE_PIXEL_X * ZOOM_LVL_BASE);
-		xu = GEN_HASHX(r);
+	if (dpi->width + (MAX_VEHICLE_PIXEL_X * ZOOM_LVL_BASE) < hash_x_size) {
+		xl = GenHashX(l - MAX_VEHICLE_PIXEL_X * ZOOM_LVL_BASE);
+		xu = GenHashX(r);
 	} else {
 		/* scan whole hash row */
 		xl = 0;
-		xu = GEN_HASHX_MASK;
+		xu = hash_x_mask;
 	}
 
-	if (dpi->height + (MAX_VEHICLE_PIXEL_Y * ZOOM_LVL_BASE) < GEN_HASHY_SIZE) {
-		yl = GEN_HASHY(t - MAX_VEHICLE_PIXEL_Y * ZOOM_LVL_BASE);
-		yu = GEN_HASHY(b);
+	if (dpi->height + (MAX_VEHICLE_PIXEL_Y * ZOOM_LVL_BASE) < hash_y_size) {
+		yl = GenHashY(t - MAX_VEHICLE_PIXEL_Y * ZOOM_LVL_BASE);
+		yu = GenHashY(b);
 	} else {
 		/* scan whole column */
 		yl = 0;
-		yu = GEN_HASHY_MASK;
+		yu = hash_y_mask;
 	}
 
-	for (int y = yl;; y = (y + GEN_HASHY_INC) & GEN_HASHY_MASK) {
-		for (int x = xl;; x = (x + GEN_HASHX_INC) & GEN_HASHX_MASK) {
-			const Vehicle *v = _vehicle_viewport_hash[x + y]; // already masked & 0xFFF
+	/* Vehicles smaller than a pixel in both directions would not show up at all. */
+	const int min_size = (1 << dpi->zoom) - 1;
 
-			while (v != NULL) {
-				if (!(v->vehstatus & VS_HIDDEN) &&
-						l <= v->coord.right &&
-						t <= v->coord.bottom &&
-						r >= v->coord.left &&
-						b >= v->coord.top) {
-					DoDrawVehicle(v);
+	/* Vehicles whose image still has to be determined; that changes their place in the hash. */
+	static SmallVector<Vehicle *, 16> outdated;
+	outdated.Clear();
+
+	for (uint y = yl;; y = (y + hash_y_inc) & hash_y_mask) {
+		for (uint x = xl;; x = (x + hash_x_inc) & hash_x_mask) {
+			const VehicleViewportHashBucket &bucket = _vehicle_viewport_hash[x + y];
+
+			for (const VehicleViewportHashEntry *e = bucket.Begin(); e != bucket.End(); e++) {
+				if (l <= e->coord.right &&
+						t <= e->coord.bottom &&
+						r >= e->coord.left &&
+						b >= e->coord.top &&
+						(e->coord.right - e->coord.left > min_size || e->coord.bottom - e->coord.top > min_size) &&
+						!(e->v->vehstatus & VS_HIDDEN)) {
+					if (e->v->sprite_seq_outdated) {
+						*outdated.Append() = e->v;
+					} else {
+						DoDrawVehicle(e->v);
+					}
 				}
-				v = v->hash_viewport_next;
 			}
 
 			if (x == xu) break;
@@ -1157,6 +1597,15 @@ void ViewportAddVehicles(DrawPixelInfo *dpi)
 
 		if (y == yu) break;
 	}
+
+	for (Vehicle **it = outdated.Begin(); it != outdated.End(); it++) {
+		Vehicle *v = *it;
+		v->GetImage(v->direction, EIT_ON_MAP, &v->sprite_seq);
+		v->sprite_seq_outdated = false;
+		/* The new image may be larger than the old one, which may leave parts outside of this area undrawn. */
+		v->Vehicle::UpdateViewport(true);
+		if (l <= v->coord.right && t <= v->coord.bottom && r >= v->coord.left && b >= v->coord.top) DoDrawVehicle(v);
+	}
 }
 
 /**
@@ -1578,24 +2027,37 @@ void Vehicle::UpdateViewport(bool dirty)
 	new_coord.right  += pt.x + 2 * ZOOM_LVL_BASE;
 	new_coord.bottom += pt.y + 2 * ZOOM_LVL_BASE;
 
-	UpdateVehicleViewportHash(this, new_coord.left, new_coord.top);
+	UpdateVehicleViewportHash(this, &new_coord);
 
 	Rect old_coord = this->coord;
 	this->coord = new_coord;
 
 	if (dirty) {
 		if (old_coord.left == INVALID_COORD) {
-			this->MarkAllViewportsDirty();
+			::MarkAllViewportsDirty(this->coord.left, this->coord.top, this->coord.right, this->coord.bottom);
 		} else {
-			::MarkAllViewportsDirty(
-					min(old_coord.left,   this->coord.left),
-					min(old_coord.top,    this->coord.top),
-					max(old_coord.right,  this->coord.right),
-					max(old_coord.bottom, this->coord.bottom));
+			Rect area;
+			area.left   = min(old_coord.left,   this->coord.left);
+			area.top    = min(old_coord.top,    this->coord.top);
+			area.right  = max(old_coord.right,  this->coord.right);
+			area.bottom = max(old_coord.bottom, this->coord.bottom);
+			::MarkAllViewportsDirty(area.left, area.top, area.right, area.bottom);
 		}
 	}
 }
 
+/**
+ * Check whether the vehicle is shown by, or close to, any viewport.
+ * The margin is large enough that the vehicle can not be seen when it is outside of it,
+ * whatever its image.
+ * @return True iff the vehicle is near a viewport.
+ */
+bool Vehicle::IsNearAnyViewport() const
+{
+	Point pt = RemapCoords(this->x_pos + this->x_offs, this->y_pos + this->y_offs, this->z_pos);
+	return IsPointNearAnyViewport(pt.x, pt.y, MAX_VEHICLE_PIXEL_X * ZOOM_LVL_BASE, MAX_VEHICLE_PIXEL_Y * ZOOM_LVL_BASE);
+}
+
 /**
  * Update the position of the vehicle, and update the viewport.
  */
@@ -2033,6 +2495,8 @@ void Vehicle::BeginLoading()
 {
 	assert(IsTileType(this->tile, MP_STATION) || this->type == VEH_SHIP);
 
+	this->consist_reserved = false;
+
 	if (this->current_order.IsType(OT_GOTO_STATION) &&
 			this->current_order.GetDestination() == this->last_station_visited) {
 		this->DeleteUnreachedImplicitOrders();
@@ -51,6 +51,7 @@ enum VehicleFlags {
 	VF_PATHFINDER_LOST,         ///< Vehicle's pathfinder is lost.
 	VF_SERVINT_IS_CUSTOM,       ///< Service interval is custom.
 	VF_SERVINT_IS_PERCENT,      ///< Service interval is percent.
+	VF_SERVICE_SEARCH_QUEUED,   ///< Vehicle is waiting for its search for a depot to service at.
 };
 
 /** Bit numbers used to indicate which of the #NewGRFCache values are valid. */
@@ -183,13 +184,15 @@ struct VehicleSpriteSeq {
 	void Draw(int x, int y, PaletteID default_pal, bool force_pal) const;
 };
 
-/** A vehicle pool for a little over 1 million vehicles. */
-typedef Pool<Vehicle, VehicleID, 512, 0xFF000> VehiclePool;
+/** A vehicle pool for a little over 1 million vehicles, stored in slabs so iterating them walks contiguous memory. */
+typedef Pool<Vehicle, VehicleID, 512, 0xFF000, PT_NORMAL, false, true, true> VehiclePool;
 extern VehiclePool _vehicle_pool;
 
 /* Some declarations of functions, so we can make them friendly */
 struct SaveLoad;
 struct GroundVehicleCache;
+struct VehicleTileHashBucket;
+struct VehicleViewportHashBucket;
 extern const SaveLoad *GetVehicleDescription(VehicleType vt);
 struct LoadgameState;
 extern bool LoadOldVehicle(LoadgameState *ls, int num);
@@ -236,39 +239,33 @@ public:
 	 */
 	TileIndex dest_tile;
 
-	Money profit_this_year;             ///< Profit this year << 8, low 8 bits are fract
-	Money profit_last_year;             ///< Profit last year << 8, low 8 bits are fract
-	Money value;                        ///< Value of the vehicle
+	/* Movement state that is touched every tick is kept together near the start of the vehicle. */
+	int32 x_pos;                        ///< x coordinate.
+	int32 y_pos;                        ///< y coordinate.
+	int32 z_pos;                        ///< z coordinate.
+	DirectionByte direction;            ///< facing
 
-	CargoPayment *cargo_payment;        ///< The cargo payment we're currently in
+	uint16 cur_speed;                   ///< current speed
+	byte subspeed;                      ///< fractional speed
+	byte acceleration;                  ///< used by train & aircraft
+	uint32 motion_counter;              ///< counter to occasionally play a vehicle sound.
+	byte progress;                      ///< The percentage (if divided by 256) this vehicle already crossed the tile unit.
 
-	Rect coord;                         ///< NOSAVE: Graphical bounding box of the vehicle, i.e. what to redraw on moves.
+	byte day_counter;                   ///< Increased by one for each day
+	byte tick_counter;                  ///< Increased by one for each tick
+	byte running_ticks;                 ///< Number of ticks this vehicle was not stopped this day
 
-	Vehicle *hash_viewport_next;        ///< NOSAVE: Next vehicle in the visual location hash.
-	Vehicle **hash_viewport_prev;       ///< NOSAVE: Previous vehicle in the visual location hash.
+	byte vehstatus;                     ///< Status
 
-	Vehicle *hash_tile_next;            ///< NOSAVE: Next vehicle in the tile location hash.
-	Vehicle **hash_tile_prev;           ///< NOSAVE: Previous vehicle in the tile location hash.
-	Vehicle **hash_tile_current;        ///< NOSAVE: Cache of the current hash chain.
+	Rect coord;                         ///< NOSAVE: Graphical bounding box of the vehicle, i.e. what to redraw on moves.
 
-	SpriteID colourmap;                 ///< NOSAVE: cached colour mapping
+	VehicleViewportHashBucket *hash_viewport_current; ///< NOSAVE: Bucket of the visual location hash the vehicle is in.
+	uint hash_viewport_pos;             ///< NOSAVE: Position of the vehicle within #hash_viewport_current.
 
-	/* Related to age and service time */
-	Year build_year;                    ///< Year the vehicle has been built.
-	Date age;                           ///< Age in days
-	Date max_age;                       ///< Maximum age
-	Date date_of_last_service;          ///< Last date the vehicle had a service at a depot.
-	uint16 reliability;                 ///< Reliability.
-	uint16 reliability_spd_dec;         ///< Reliability decrease speed.
-	byte breakdown_ctr;                 ///< Counter for managing breakdown events. @see Vehicle::HandleBreakdown
-	byte breakdown_delay;               ///< Counter for managing breakdown length.
-	byte breakdowns_since_last_service; ///< Counter for the amount of breakdowns.
-	byte breakdown_chance;              ///< Current chance of breakdowns.
+	VehicleTileHashBucket *hash_tile_current; ///< NOSAVE: Bucket of the tile location hash the vehicle is in.
+	uint hash_tile_pos;                 ///< NOSAVE: Position of the vehicle within #hash_tile_current.
 
-	int32 x_pos;                        ///< x coordinate.
-	int32 y_pos;                        ///< y coordinate.
-	int32 z_pos;                        ///< z coordinate.
-	DirectionByte direction;            ///< facing
+	SpriteID colourmap;                 ///< NOSAVE: cached colour mapping
 
 	OwnerByte owner;                    ///< Which company owns the vehicle?
 	/**
@@ -278,6 +275,7 @@ public:
 	 */
 	byte spritenum;
 	VehicleSpriteSeq sprite_seq;        ///< Vehicle appearance.
+	bool sprite_seq_outdated;           ///< NOSAVE: #sprite_seq was not updated when the vehicle last changed, because no viewport was near; it is updated when a viewport draws the vehicle.
 	byte x_extent;                      ///< x-extent of vehicle bounding box
 	byte y_extent;                      ///< y-extent of vehicle bounding box
 	byte z_extent;                      ///< z-extent of vehicle bounding box
@@ -287,15 +285,27 @@ public:
 	int8 y_offs;                        ///< y offset for vehicle sprite
 	EngineID engine_type;               ///< The type of engine used for this vehicle.
 
+	Money profit_this_year;             ///< Profit this year << 8, low 8 bits are fract
+	Money profit_last_year;             ///< Profit last year << 8, low 8 bits are fract
+	Money value;                        ///< Value of the vehicle
+
+	CargoPayment *cargo_payment;        ///< The cargo payment we're currently in
+
+	/* Related to age and service time */
+	Year build_year;                    ///< Year the vehicle has been built.
+	Date age;                           ///< Age in days
+	Date max_age;                       ///< Maximum age
+	Date date_of_last_service;          ///< Last date the vehicle had a service at a depot.
+	uint16 reliability;                 ///< Reliability.
+	uint16 reliability_spd_dec;         ///< Reliability decrease speed.
+	byte breakdown_ctr;                 ///< Counter for managing breakdown events. @see Vehicle::HandleBreakdown
+	byte breakdown_delay;               ///< Counter for managing breakdown length.
+	byte breakdowns_since_last_service; ///< Counter for the amount of breakdowns.
+	byte breakdown_chance;              ///< Current chance of breakdowns.
+
 	TextEffectID fill_percent_te_id;    ///< a text-effect id to a loading indicator object
 	UnitID unitnumber;                  ///< unit number, for display purposes only
 
-	uint16 cur_speed;                   ///< current speed
-	byte subspeed;                      ///< fractional speed
-	byte acceleration;                  ///< used by train & aircraft
-	uint32 motion_counter;              ///< counter to occasionally play a vehicle sound.
-	byte progress;                      ///< The percentage (if divided by 256) this vehicle already crossed the tile unit.
-
 	byte random_bits;                   ///< Bits used for determining which randomized variational spritegroups to use when drawing.
 	byte waiting_triggers;              ///< Triggers to be yet matched before rerandomizing the random bits.
 
@@ -310,11 +320,6 @@ public:
 	uint16 cargo_age_counter;           ///< Ticks till cargo is aged next.
 	int8 trip_occupancy;                ///< NOSAVE: Occupancy of vehicle of the current trip (updated after leaving a station).
 
-	byte day_counter;                   ///< Increased by one for each day
-	byte tick_counter;                  ///< Increased by one for each tick
-	byte running_ticks;                 ///< Number of ticks this vehicle was not stopped this day
-
-	byte vehstatus;                     ///< Status
 	Order current_order;                ///< The current order (+ status, like: loading)
 
 	union {
@@ -323,6 +328,7 @@ public:
 	} orders;                           ///< The orders currently assigned to the vehicle.
 
 	uint16 load_unload_ticks;           ///< Ticks to wait before starting next cycle.
+	bool consist_reserved;              ///< NOSAVE: All parts of the consist are full or have reserved cargo for their remaining capacity, so reserving again does nothing until the next loading cycle.
 	GroupID group_id;                   ///< Index of group Pool array
 	byte subtype;                       ///< subtype (Filled with values from #AircraftSubType/#DisasterSubType/#EffectVehicleType/#GroundVehicleSubtypeFlags)
 
@@ -335,6 +341,8 @@ public:
 	/** We want to 'destruct' the right class. */
 	virtual ~Vehicle();
 
+	static size_t GetPoolSlotSize();
+
 	void BeginLoading();
 	void CancelReservation(StationID next, Station *st);
 	void LeaveStation();
@@ -532,6 +540,12 @@ public:
 	 */
 	virtual void OnNewDay() {};
 
+	/**
+	 * Look for a depot to service at, if the vehicle needs servicing.
+	 * Called for the vehicles queued by #QueueServiceDepotSearch.
+	 */
+	virtual void OnServiceDepotSearch() {};
+
 	/**
 	 * Crash the (whole) vehicle chain.
 	 * @param flooded whether the cause of the crash is flooding or not.
@@ -759,6 +773,7 @@ public:
 	void UpdatePosition();
 	void UpdateViewport(bool dirty);
 	void UpdatePositionAndViewport();
+	bool IsNearAnyViewport() const;
 	void MarkAllViewportsDirty() const;
 
 	inline uint16 GetServiceInterval() const { return this->service_interval; }
@@ -1141,8 +1156,19 @@ struct SpecializedVehicle : public Vehicle {
 		/* Explicitly choose method to call to prevent vtable dereference -
 		 * it gives ~3% runtime improvements in games with many vehicles */
 		if (update_delta) ((T *)this)->T::UpdateDeltaXY();
+
+		/* The images of trains, road vehicles and ships may come from NewGRF callbacks.
+		 * Far away from all viewports getting them is put off until a viewport draws
+		 * the vehicle; until then the bounds of the old image are used. */
+		if ((Type == VEH_TRAIN || Type == VEH_ROAD || Type == VEH_SHIP) && !this->IsNearAnyViewport()) {
+			this->sprite_seq_outdated = true;
+			if (force_update) this->Vehicle::UpdateViewport(true);
+			return;
+		}
+
 		VehicleSpriteSeq seq;
 		((T *)this)->T::GetImage(this->direction, EIT_ON_MAP, &seq);
+		this->sprite_seq_outdated = false;
 		if (force_update || this->sprite_seq != seq) {
 			this->sprite_seq = seq;
 			this->Vehicle::UpdateViewport(true);
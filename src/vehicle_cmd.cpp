@@ -31,6 +31,7 @@
 #include "ship.h"
 #include "newgrf.h"
 #include "company_base.h"
+#include "core/name_registry_type.hpp"
 
 #include "table/strings.h"
 
@@ -704,6 +705,19 @@ CommandCost CmdDepotMassAutoReplace(TileIndex tile, DoCommandFlag flags, uint32
 	return cost;
 }
 
+/**
+ * Add the custom names of all vehicles to a name registry.
+ * @param registry The registry to fill.
+ */
+static void FillVehicleNames(NameRegistry &registry)
+{
+	const Vehicle *v;
+
+	FOR_ALL_VEHICLES(v) registry.Add(v->name);
+}
+
+NameRegistry _vehicle_names(&FillVehicleNames); ///< The custom names of the vehicles.
+
 /**
  * Test if a name is unique among vehicle names.
  * @param name Name to test.
@@ -711,13 +725,7 @@ CommandCost CmdDepotMassAutoReplace(TileIndex tile, DoCommandFlag flags, uint32
  */
 static bool IsUniqueVehicleName(const char *name)
 {
-	const Vehicle *v;
-
-	FOR_ALL_VEHICLES(v) {
-		if (v->name != NULL && strcmp(v->name, name) == 0) return false;
-	}
-
-	return true;
+	return !_vehicle_names.Contains(name);
 }
 
 /**
@@ -763,6 +771,7 @@ static void CloneVehicleName(const Vehicle *src, Vehicle *dst)
 		/* Check the name is unique. */
 		if (IsUniqueVehicleName(buf)) {
 			dst->name = stredup(buf);
+			_vehicle_names.Add(dst->name);
 			break;
 		}
 	}
@@ -1039,8 +1048,10 @@ CommandCost CmdRenameVehicle(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 	}
 
 	if (flags & DC_EXEC) {
+		_vehicle_names.Remove(v->name);
 		free(v->name);
 		v->name = reset ? NULL : stredup(text);
+		_vehicle_names.Add(v->name);
 		InvalidateWindowClassesData(GetWindowClassForVehicleType(v->type), 1);
 		MarkWholeScreenDirty();
 	}
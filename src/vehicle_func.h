@@ -21,6 +21,8 @@
 #include "newgrf_config.h"
 #include "track_type.h"
 #include "livery.h"
+#include "company_type.h"
+#include "pathfinder/pathfinder_stats.h"
 
 #define is_custom_sprite(x) (x >= 0xFD)
 #define IS_CUSTOM_FIRSTHEAD_SPRITE(x) (x == 0xFD)
@@ -41,18 +43,36 @@ bool IsValidImageIndex(uint8 image_index);
 typedef Vehicle *VehicleFromPosProc(Vehicle *v, void *data);
 
 void VehicleServiceInDepot(Vehicle *v);
+void QueueServiceDepotSearch(Vehicle *v);
 uint CountVehiclesInChain(const Vehicle *v);
 void FindVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 void FindVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
 bool HasVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
+void FindRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
+void FindRoadVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
 void CallVehicleTicks();
+
+/** Time spent ticking the primary vehicles of one company and vehicle type. */
+struct VehicleTickStats {
+	uint64 ticks;   ///< Number of vehicle ticks.
+	uint64 time_ns; ///< Total wall time of those ticks in nanoseconds, including the pathfinder calls.
+};
+
+extern VehicleTickStats _vehicle_tick_stats[PF_STATS_NO_COMPANY + 1][VEH_COMPANY_END];
+extern bool _vehicle_tick_stats_enabled;
+
+void ResetVehicleTickStats();
+void StartVehicleTickStats();
+void ConPrintVehicleTickStats();
 uint8 CalcPercentVehicleFilled(const Vehicle *v, StringID *colour);
 
 void VehicleLengthChanged(const Vehicle *u);
 
 byte VehicleRandomBits();
 void ResetVehicleHash();
+void PrintVehicleTileHashStats();
+void PrintVehicleViewportHashStats();
 void ResetVehicleColourMap();
 
 byte GetBestFittingSubType(Vehicle *v_from, Vehicle *v_for, CargoID dest_cargo_type);
@@ -169,6 +189,8 @@ CommandCost EnsureNoTrainOnTrackBits(TileIndex tile, TrackBits track_bits);
 extern VehicleID _new_vehicle_id;
 extern uint16 _returned_refit_capacity;
 extern uint16 _returned_mail_refit_capacity;
+extern uint32 _vehicle_tick_stamp;
+extern class NameRegistry _vehicle_names;
 
 bool CanVehicleUseStation(EngineID engine_type, const struct Station *st);
 bool CanVehicleUseStation(const Vehicle *v, const struct Station *st);
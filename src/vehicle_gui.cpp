@@ -39,6 +39,9 @@
 #include "tilehighlight_func.h"
 #include "zoom_func.h"
 
+#include <map>
+#include <string>
+
 #include "safeguards.h"
 
 
@@ -180,15 +183,15 @@ DropDownList *BaseVehicleListWindow::BuildActionDropdownList(bool show_autorepla
 	return list;
 }
 
-/* cached values for VehicleNameSorter to spare many GetString() calls */
-static const Vehicle *_last_vehicle[2] = { NULL, NULL };
+/* cached names for VehicleNameSorter, so GetString() is called only once per vehicle and sort */
+static std::map<VehicleID, std::string> _vehicle_sort_names;
 
 void BaseVehicleListWindow::SortVehicleList()
 {
-	if (this->vehicles.Sort()) return;
+	this->vehicles.Sort();
 
 	/* invalidate cached values for name sorter - vehicle names could change */
-	_last_vehicle[0] = _last_vehicle[1] = NULL;
+	_vehicle_sort_names.clear();
 }
 
 void DepotSortList(VehicleList *list)
@@ -1090,24 +1093,27 @@ static int CDECL VehicleNumberSorter(const Vehicle * const *a, const Vehicle * c
 	return (*a)->unitnumber - (*b)->unitnumber;
 }
 
-/** Sort vehicles by their name */
-static int CDECL VehicleNameSorter(const Vehicle * const *a, const Vehicle * const *b)
+/**
+ * Get the name of a vehicle to sort by, from the cache if it is there.
+ * @param v The vehicle to get the name of.
+ * @return The name of the vehicle.
+ */
+static const char *GetVehicleSortName(const Vehicle *v)
 {
-	static char last_name[2][64];
-
-	if (*a != _last_vehicle[0]) {
-		_last_vehicle[0] = *a;
-		SetDParam(0, (*a)->index);
-		GetString(last_name[0], STR_VEHICLE_NAME, lastof(last_name[0]));
-	}
-
-	if (*b != _last_vehicle[1]) {
-		_last_vehicle[1] = *b;
-		SetDParam(0, (*b)->index);
-		GetString(last_name[1], STR_VEHICLE_NAME, lastof(last_name[1]));
+	std::map<VehicleID, std::string>::iterator it = _vehicle_sort_names.find(v->index);
+	if (it == _vehicle_sort_names.end()) {
+		char buf[64];
+		SetDParam(0, v->index);
+		GetString(buf, STR_VEHICLE_NAME, lastof(buf));
+		it = _vehicle_sort_names.insert(std::make_pair(v->index, std::string(buf))).first;
 	}
+	return it->second.c_str();
+}
 
-	int r = strnatcmp(last_name[0], last_name[1]); // Sort by name (natural sorting).
+/** Sort vehicles by their name */
+static int CDECL VehicleNameSorter(const Vehicle * const *a, const Vehicle * const *b)
+{
+	int r = strnatcmp(GetVehicleSortName(*a), GetVehicleSortName(*b)); // Sort by name (natural sorting).
 	return (r != 0) ? r : VehicleNumberSorter(a, b);
 }
 
@@ -25,6 +25,8 @@
 #include "../core/random_func.hpp"
 #include "../core/math_func.hpp"
 #include "../framerate_type.h"
+#include "../viewport_func.h"
+#include "dirty_rect.h"
 #include "allegro_v.h"
 #include <allegro.h>
 
@@ -40,37 +42,29 @@ static FVideoDriver_Allegro iFVideoDriver_Allegro;
 
 static BITMAP *_allegro_screen;
 
-#define MAX_DIRTY_RECTS 100
-static PointDimension _dirty_rects[MAX_DIRTY_RECTS];
-static int _num_dirty_rects;
+static DirtyRectList _dirty_rects;
 
 void VideoDriver_Allegro::MakeDirty(int left, int top, int width, int height)
 {
-	if (_num_dirty_rects < MAX_DIRTY_RECTS) {
-		_dirty_rects[_num_dirty_rects].x = left;
-		_dirty_rects[_num_dirty_rects].y = top;
-		_dirty_rects[_num_dirty_rects].width = width;
-		_dirty_rects[_num_dirty_rects].height = height;
-	}
-	_num_dirty_rects++;
+	_dirty_rects.Add(left, top, width, height);
 }
 
 static void DrawSurfaceToScreen()
 {
 	PerformanceMeasurer framerate(PFE_VIDEO);
 
-	int n = _num_dirty_rects;
-	if (n == 0) return;
+	if (_dirty_rects.IsEmpty()) return;
 
-	_num_dirty_rects = 0;
-	if (n > MAX_DIRTY_RECTS) {
+	if (_dirty_rects.IsAll()) {
+		_dirty_rects.Clear();
 		blit(_allegro_screen, screen, 0, 0, 0, 0, _allegro_screen->w, _allegro_screen->h);
 		return;
 	}
 
-	for (int i = 0; i < n; i++) {
+	for (uint i = 0; i < _dirty_rects.Length(); i++) {
 		blit(_allegro_screen, screen, _dirty_rects[i].x, _dirty_rects[i].y, _dirty_rects[i].x, _dirty_rects[i].y, _dirty_rects[i].width, _dirty_rects[i].height);
 	}
+	_dirty_rects.Clear();
 }
 
 
@@ -484,6 +478,7 @@ void VideoDriver_Allegro::MainLoop()
 	uint32 cur_ticks = GetTime();
 	uint32 last_cur_ticks = cur_ticks;
 	uint32 next_tick = cur_ticks + MILLISECONDS_PER_TICK;
+	uint32 next_draw_tick = cur_ticks + GetDrawInterval();
 
 	CheckPaletteAnim();
 
@@ -508,9 +503,15 @@ void VideoDriver_Allegro::MainLoop()
 		}
 
 		cur_ticks = GetTime();
-		if (cur_ticks >= next_tick || (_fast_forward && !_pause_mode) || cur_ticks < prev_cur_ticks) {
+		/* Game ticks and drawing have their own schedule, so fast forwarding is not limited by drawing. */
+		bool tick = cur_ticks >= next_tick || (_fast_forward && !_pause_mode) || cur_ticks < prev_cur_ticks;
+		bool draw = cur_ticks >= next_draw_tick || cur_ticks < prev_cur_ticks;
+		if (tick || draw) {
 			_realtime_tick += cur_ticks - last_cur_ticks;
 			last_cur_ticks = cur_ticks;
+		}
+
+		if (tick) {
 			next_tick = cur_ticks + MILLISECONDS_PER_TICK;
 
 			bool old_ctrl_pressed = _ctrl_pressed;
@@ -528,12 +529,17 @@ void VideoDriver_Allegro::MainLoop()
 			if (old_ctrl_pressed != _ctrl_pressed) HandleCtrlChanged();
 
 			GameLoop();
+		}
+
+		if (draw) {
+			next_draw_tick = cur_ticks + GetDrawInterval();
 
 			UpdateWindows();
 			CheckPaletteAnim();
 			DrawSurfaceToScreen();
-		} else {
-			CSleep(1);
+		} else if (!tick) {
+			/* Use the spare time for loading sprites, otherwise sleep. */
+			if (!PrefetchViewportSprites()) CSleep(1);
 			NetworkDrawChatMessage();
 			DrawMouseCursor();
 			DrawSurfaceToScreen();
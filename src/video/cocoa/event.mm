@@ -37,6 +37,7 @@
 #include "../../core/math_func.hpp"
 #include "../../texteff.hpp"
 #include "../../window_func.h"
+#include "../../viewport_func.h"
 
 #import <sys/time.h> /* gettimeofday */
 
@@ -709,7 +710,8 @@ void QZ_GameLoop()
 #ifdef _DEBUG
 			uint32 st0 = GetTick();
 #endif
-			CSleep(1);
+			/* Use the spare time for loading sprites, otherwise sleep. */
+			if (!PrefetchViewportSprites()) CSleep(1);
 #ifdef _DEBUG
 			st += GetTick() - st0;
 #endif
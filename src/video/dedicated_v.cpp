@@ -24,7 +24,12 @@
 #include "../company_func.h"
 #include "../core/random_func.hpp"
 #include "../saveload/saveload.h"
+#include "../framerate_type.h"
+#include "../string_func.h"
 #include "dedicated_v.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
 
 #ifdef __OS2__
 #	include <sys/time.h> /* gettimeofday */
@@ -163,6 +168,10 @@ const char *VideoDriver_Dedicated::Start(const char * const *parm)
 	OS2_SwitchToConsoleMode();
 #endif
 
+	this->benchmark_ticks = max(GetDriverParamInt(parm, "benchmark", 0), 0);
+	const char *benchmark_file = GetDriverParam(parm, "benchmark_file");
+	this->benchmark_file = benchmark_file == NULL ? NULL : stredup(benchmark_file);
+
 	DEBUG(driver, 1, "Loading dedicated server");
 	return NULL;
 }
@@ -173,6 +182,7 @@ void VideoDriver_Dedicated::Stop()
 	CloseWindowsConsoleThread();
 #endif
 	free(_dedicated_video_mem);
+	free(this->benchmark_file);
 }
 
 void VideoDriver_Dedicated::MakeDirty(int left, int top, int width, int height) {}
@@ -289,6 +299,11 @@ void VideoDriver_Dedicated::MainLoop()
 		return;
 	}
 
+	if (this->benchmark_ticks != 0) {
+		this->RunBenchmark();
+		return;
+	}
+
 	while (!_exit_game) {
 		uint32 prev_cur_ticks = cur_ticks; // to check for wrapping
 		InteractiveRandom(); // randomness
@@ -317,4 +332,102 @@ void VideoDriver_Dedicated::MainLoop()
 	}
 }
 
+/**
+ * Get the time of a percentile of sorted durations.
+ * @param sorted The durations in microseconds, sorted.
+ * @param percent The percentile wanted.
+ * @return The duration at the percentile, in milliseconds.
+ */
+static double GetPercentileMilliseconds(const std::vector<uint32> &sorted, uint percent)
+{
+	return sorted[min<size_t>(sorted.size() * percent / 100, sorted.size() - 1)] / 1000.0;
+}
+
+/**
+ * Run the loaded game for the requested number of ticks as fast as possible,
+ * without pacing them to real time, and write how long the ticks and the
+ * parts of them took as JSON. Afterwards the game is quit.
+ */
+void VideoDriver_Dedicated::RunBenchmark()
+{
+	FILE *f = stdout;
+	if (this->benchmark_file != NULL) {
+		f = fopen(this->benchmark_file, "w");
+		if (f == NULL) {
+			DEBUG(misc, 0, "Cannot open benchmark file %s, aborting", this->benchmark_file);
+			_exit_game = true;
+			return;
+		}
+	}
+
+	DEBUG(misc, 0, "Running %u ticks for the benchmark", this->benchmark_ticks);
+
+	/* Without clients nobody can unpause a paused game. */
+	_pause_mode = PM_UNPAUSED;
+
+	std::vector<uint32> tick_us;
+	tick_us.reserve(this->benchmark_ticks);
+	ResetPerformanceTotals();
+
+	/* The time each performance element took in each tick, for its percentiles.
+	 * Derived from the change of the totals, as the elements only keep their last measurements. */
+	std::vector<uint32> element_us[PFE_MAX];
+	double element_ms[PFE_MAX] = {};
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while (tick_us.size() < this->benchmark_ticks && !_exit_game) {
+		std::chrono::steady_clock::time_point tick_start = std::chrono::steady_clock::now();
+		GameLoop();
+		tick_us.push_back((uint32)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tick_start).count());
+
+		for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) {
+			double total_ms;
+			if (GetPerformanceTotals(e, &total_ms) == 0) continue;
+			element_us[e].push_back((uint32)((total_ms - element_ms[e]) * 1000));
+			element_ms[e] = total_ms;
+		}
+
+		UpdateWindows();
+	}
+	double seconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000000.0;
+
+	uint64 total_us = 0;
+	for (std::vector<uint32>::const_iterator it = tick_us.begin(); it != tick_us.end(); it++) total_us += *it;
+	std::sort(tick_us.begin(), tick_us.end());
+	size_t ticks = tick_us.size();
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"ticks\": " PRINTF_SIZE ",\n", ticks);
+	fprintf(f, "  \"seconds\": %.3f,\n", seconds);
+	fprintf(f, "  \"ticks_per_second\": %.2f,\n", seconds > 0 ? ticks / seconds : 0.0);
+	if (ticks > 0) {
+		fprintf(f, "  \"tick_ms\": { \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n",
+				total_us / 1000.0 / ticks, GetPercentileMilliseconds(tick_us, 50), GetPercentileMilliseconds(tick_us, 95),
+				GetPercentileMilliseconds(tick_us, 99), tick_us[ticks - 1] / 1000.0);
+	}
+	fprintf(f, "  \"elements\": {");
+	bool first = true;
+	for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) {
+		double total_ms;
+		uint32 count = GetPerformanceTotals(e, &total_ms);
+		if (count == 0) continue;
+
+		fprintf(f, "%s\n    \"%s\": { \"count\": %u, \"total_ms\": %.3f, \"mean_ms\": %.4f", first ? "" : ",", GetPerformanceElementKey(e), count, total_ms, total_ms / count);
+		first = false;
+
+		/* Percentiles per tick; elements that are measured less often include the ticks they did not run in. */
+		std::vector<uint32> &us = element_us[e];
+		if (!us.empty()) {
+			std::sort(us.begin(), us.end());
+			fprintf(f, ", \"tick_p50_ms\": %.4f, \"tick_p95_ms\": %.4f, \"tick_p99_ms\": %.4f, \"tick_max_ms\": %.4f",
+					GetPercentileMilliseconds(us, 50), GetPercentileMilliseconds(us, 95), GetPercentileMilliseconds(us, 99), (double)us.back() / 1000);
+		}
+		fprintf(f, " }");
+	}
+	fprintf(f, "\n  }\n}\n");
+
+	if (f != stdout) fclose(f);
+	_exit_game = true;
+}
+
 #endif /* ENABLE_NETWORK */
@@ -16,6 +16,12 @@
 
 /** The dedicated server video driver. */
 class VideoDriver_Dedicated : public VideoDriver {
+private:
+	uint benchmark_ticks; ///< Number of ticks to run as fast as possible before quitting; 0 for running as normal server.
+	char *benchmark_file; ///< File to write the results of the benchmark to; NULL for writing them to stdout.
+
+	void RunBenchmark();
+
 public:
 	/* virtual */ const char *Start(const char * const *param);
 
@@ -0,0 +1,102 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file dirty_rect.cpp Merging the areas of the screen a video driver has to present. */
+
+#include "../stdafx.h"
+#include "../core/math_func.hpp"
+#include "dirty_rect.h"
+
+#include "../safeguards.h"
+
+/** Areas are merged when at most one in this many pixels of the merged area did not change. */
+static const int64 MERGE_WASTE_RATIO = 8;
+
+/**
+ * Get the number of pixels of an area.
+ * @param r The area.
+ * @return The number of pixels.
+ */
+static inline int64 Area(const PointDimension &r)
+{
+	return (int64)r.width * r.height;
+}
+
+/**
+ * Get the smallest area containing two areas.
+ * @param a The first area.
+ * @param b The second area.
+ * @return The bounding area.
+ */
+static PointDimension Union(const PointDimension &a, const PointDimension &b)
+{
+	PointDimension u;
+	u.x = min(a.x, b.x);
+	u.y = min(a.y, b.y);
+	u.width = max(a.x + a.width, b.x + b.width) - u.x;
+	u.height = max(a.y + a.height, b.y + b.height) - u.y;
+	return u;
+}
+
+/**
+ * Get the number of pixels two areas have in common.
+ * @param a The first area.
+ * @param b The second area.
+ * @return The number of pixels in both areas.
+ */
+static int64 OverlapArea(const PointDimension &a, const PointDimension &b)
+{
+	int width = min(a.x + a.width, b.x + b.width) - max(a.x, b.x);
+	int height = min(a.y + a.height, b.y + b.height) - max(a.y, b.y);
+	if (width <= 0 || height <= 0) return 0;
+	return (int64)width * height;
+}
+
+/**
+ * Add an area that changed.
+ * @param left   The left most column of the area.
+ * @param top    The top most line of the area.
+ * @param width  The width of the area.
+ * @param height The height of the area.
+ */
+void DirtyRectList::Add(int left, int top, int width, int height)
+{
+	if (this->all || width <= 0 || height <= 0) return;
+
+	PointDimension r = { left, top, width, height };
+
+	/* Merge with every area without adding many unchanged pixels; the merged area may then merge with areas rejected before. */
+	for (uint i = 0; i < this->count;) {
+		PointDimension u = Union(this->rects[i], r);
+		int64 waste = Area(u) - Area(this->rects[i]) - Area(r) + OverlapArea(this->rects[i], r);
+		if (waste * MERGE_WASTE_RATIO <= Area(u)) {
+			r = u;
+			this->rects[i] = this->rects[--this->count];
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	if (this->count == MAX_RECTS) {
+		uint best = 0;
+		int64 best_growth = Area(Union(this->rects[0], r)) - Area(this->rects[0]);
+		for (uint i = 1; i < this->count; i++) {
+			int64 growth = Area(Union(this->rects[i], r)) - Area(this->rects[i]);
+			if (growth < best_growth) {
+				best = i;
+				best_growth = growth;
+			}
+		}
+		this->rects[best] = Union(this->rects[best], r);
+		return;
+	}
+
+	this->rects[this->count++] = r;
+}
@@ -0,0 +1,82 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file dirty_rect.h Collecting the areas of the screen a video driver has to present. */
+
+#ifndef VIDEO_DIRTY_RECT_H
+#define VIDEO_DIRTY_RECT_H
+
+#include "../core/geometry_type.hpp"
+
+/**
+ * The areas of the screen that changed since they were last presented.
+ * Areas that overlap or nearly touch are merged when that adds few pixels
+ * that did not change, so the list stays short without presenting much
+ * more than needed. When the list is full a new area is merged into the
+ * area that grows the least by it.
+ */
+class DirtyRectList {
+public:
+	static const uint MAX_RECTS = 100; ///< Maximum number of areas in the list.
+
+private:
+	PointDimension rects[MAX_RECTS]; ///< The dirty areas.
+	uint count;                      ///< Number of dirty areas.
+	bool all;                        ///< Whether the whole screen is dirty.
+
+public:
+	DirtyRectList() : count(0), all(false) {}
+
+	void Add(int left, int top, int width, int height);
+
+	/** Mark the whole screen dirty. */
+	inline void MarkAll()
+	{
+		this->count = 0;
+		this->all = true;
+	}
+
+	/** Forget all dirty areas. */
+	inline void Clear()
+	{
+		this->count = 0;
+		this->all = false;
+	}
+
+	/**
+	 * Check whether nothing is dirty.
+	 * @return True if there is nothing to present.
+	 */
+	inline bool IsEmpty() const { return this->count == 0 && !this->all; }
+
+	/**
+	 * Check whether the whole screen is dirty.
+	 * @return True if the whole screen has to be presented; the list of areas is empty then.
+	 */
+	inline bool IsAll() const { return this->all; }
+
+	/**
+	 * Get the number of dirty areas.
+	 * @return The number of areas.
+	 */
+	inline uint Length() const { return this->count; }
+
+	/**
+	 * Get a dirty area.
+	 * @param index The index of the area.
+	 * @return The area.
+	 */
+	inline const PointDimension &operator[](uint index) const
+	{
+		assert(index < this->count);
+		return this->rects[index];
+	}
+};
+
+#endif /* VIDEO_DIRTY_RECT_H */
@@ -23,6 +23,8 @@
 #include "../core/math_func.hpp"
 #include "../fileio_func.h"
 #include "../framerate_type.h"
+#include "../viewport_func.h"
+#include "dirty_rect.h"
 #include "sdl_v.h"
 #include <SDL.h>
 
@@ -44,21 +46,20 @@ static ThreadMutex *_draw_mutex = NULL;
 static volatile bool _draw_continue;
 static Palette _local_palette;
 
-#define MAX_DIRTY_RECTS 100
-static SDL_Rect _dirty_rects[MAX_DIRTY_RECTS];
-static int _num_dirty_rects;
+static DirtyRectList _dirty_rects;
 static int _use_hwpalette;
 static int _requested_hwpalette; /* Did we request a HWPALETTE for the current video mode? */
 
+/** Areas of the real screen to push to the display by the next present. */
+static SDL_Rect _present_rects[DirtyRectList::MAX_RECTS];
+/** Number of areas in #_present_rects. */
+static int _present_count;
+/** Whether a frame has been handed to the draw thread that it did not present yet; protected by #_draw_mutex. */
+static bool _present_pending;
+
 void VideoDriver_SDL::MakeDirty(int left, int top, int width, int height)
 {
-	if (_num_dirty_rects < MAX_DIRTY_RECTS) {
-		_dirty_rects[_num_dirty_rects].x = left;
-		_dirty_rects[_num_dirty_rects].y = top;
-		_dirty_rects[_num_dirty_rects].w = width;
-		_dirty_rects[_num_dirty_rects].h = height;
-	}
-	_num_dirty_rects++;
+	_dirty_rects.Add(left, top, width, height);
 }
 
 static void UpdatePalette(bool init = false)
@@ -146,27 +147,91 @@ static void CheckPaletteAnim()
 	}
 }
 
-static void DrawSurfaceToScreen()
+/**
+ * Copy the dirty areas of the screen the game draws on to the real screen
+ * and queue them for #PresentSurface.
+ */
+static void PrepareSurfaceForPresent()
+{
+	_present_count = 0;
+	if (_dirty_rects.IsEmpty()) return;
+
+	if (_dirty_rects.IsAll()) {
+		_present_rects[0].x = 0;
+		_present_rects[0].y = 0;
+		_present_rects[0].w = _sdl_realscreen->w;
+		_present_rects[0].h = _sdl_realscreen->h;
+		_present_count = 1;
+	} else {
+		_present_count = _dirty_rects.Length();
+		for (int i = 0; i < _present_count; i++) {
+			_present_rects[i].x = _dirty_rects[i].x;
+			_present_rects[i].y = _dirty_rects[i].y;
+			_present_rects[i].w = _dirty_rects[i].width;
+			_present_rects[i].h = _dirty_rects[i].height;
+		}
+	}
+	_dirty_rects.Clear();
+
+	if (_sdl_screen != _sdl_realscreen) {
+		for (int i = 0; i < _present_count; i++) {
+			/* SDL_BlitSurface clips the destination rectangle, so give it a copy. */
+			SDL_Rect dst = _present_rects[i];
+			SDL_BlitSurface(_sdl_screen, &_present_rects[i], _sdl_realscreen, &dst);
+		}
+	}
+}
+
+/** Push the areas queued by #PrepareSurfaceForPresent from the real screen to the display. */
+static void PresentSurface()
 {
 	PerformanceMeasurer framerate(PFE_VIDEO);
 
-	int n = _num_dirty_rects;
-	if (n == 0) return;
+	if (_present_count != 0) SDL_UpdateRects(_sdl_realscreen, _present_count, _present_rects);
+	_present_count = 0;
+}
 
-	_num_dirty_rects = 0;
-	if (n > MAX_DIRTY_RECTS) {
-		if (_sdl_screen != _sdl_realscreen) {
-			SDL_BlitSurface(_sdl_screen, NULL, _sdl_realscreen, NULL);
-		}
-		SDL_UpdateRect(_sdl_realscreen, 0, 0, 0, 0);
-	} else {
-		if (_sdl_screen != _sdl_realscreen) {
-			for (int i = 0; i < n; i++) {
-				SDL_BlitSurface(_sdl_screen, &_dirty_rects[i], _sdl_realscreen, &_dirty_rects[i]);
-			}
-		}
-		SDL_UpdateRects(_sdl_realscreen, n, _dirty_rects);
+static void DrawSurfaceToScreen()
+{
+	PrepareSurfaceForPresent();
+	PresentSurface();
+}
+
+/**
+ * Hand the dirty areas of the screen to the draw thread, unless it did not
+ * get to present the previous frame yet. In that case the areas stay dirty
+ * and are handed over with the next frame, so the game does not wait for it.
+ * @pre The caller holds #_draw_mutex.
+ */
+static void HandFrameToDrawThread()
+{
+	if (_present_pending) return;
+
+	CheckPaletteAnim();
+	PrepareSurfaceForPresent();
+	if (_present_count == 0) return;
+
+	_present_pending = true;
+	_draw_mutex->SendSignal();
+}
+
+/**
+ * Take back a frame that was handed to the draw thread but not presented yet,
+ * so the real screen can be changed or drawn without the draw thread. The
+ * whole screen is presented next time instead.
+ */
+static void WaitForPresent()
+{
+	if (_draw_mutex == NULL) return;
+
+	/* The draw thread only presents while it holds the mutex. */
+	_draw_mutex->BeginCritical(true);
+	if (_present_pending) {
+		_present_pending = false;
+		_present_count = 0;
+		_dirty_rects.MarkAll();
 	}
+	_draw_mutex->EndCritical(true);
 }
 
 static void DrawSurfaceToScreenThread(void *)
@@ -175,14 +240,15 @@ static void DrawSurfaceToScreenThread(void *)
 	_draw_mutex->BeginCritical();
 	_draw_mutex->SendSignal();
 
-	/* Now wait for the first thing to draw! */
-	_draw_mutex->WaitForSignal();
-
-	while (_draw_continue) {
-		CheckPaletteAnim();
-		/* Then just draw and wait till we stop */
-		DrawSurfaceToScreen();
-		_draw_mutex->WaitForSignal();
+	for (;;) {
+		/* Wait for the next frame to present. */
+		while (!_present_pending && _draw_continue) _draw_mutex->WaitForSignal();
+		if (!_draw_continue) break;
+
+		/* SDL is not thread-safe, so present while holding the mutex; the
+		 * game only lets go of it while it runs the game loop. */
+		PresentSurface();
+		_present_pending = false;
 	}
 
 	_draw_mutex->EndCritical();
@@ -320,6 +386,9 @@ bool VideoDriver_SDL::CreateMainSurface(uint w, uint h)
 
 	if (want_hwpalette) DEBUG(driver, 1, "SDL: requesting hardware palette");
 
+	/* The draw thread may not have presented the old screen yet. */
+	WaitForPresent();
+
 	/* Free any previously allocated shadow surface */
 	if (_sdl_screen != NULL && _sdl_screen != _sdl_realscreen) SDL_FreeSurface(_sdl_screen);
 
@@ -382,7 +451,7 @@ bool VideoDriver_SDL::CreateMainSurface(uint w, uint h)
 	}
 
 	/* Delay drawing for this cycle; the next cycle will redraw the whole screen */
-	_num_dirty_rects = 0;
+	_dirty_rects.Clear();
 
 	_screen.width = newscreen->w;
 	_screen.height = newscreen->h;
@@ -602,7 +671,7 @@ int VideoDriver_SDL::PollEvent()
 			/* Force a redraw of the entire screen. Note
 			 * that SDL 1.2 seems to do this automatically
 			 * in most cases, but 1.3 / 2.0 does not. */
-		        _num_dirty_rects = MAX_DIRTY_RECTS + 1;
+			_dirty_rects.MarkAll();
 			break;
 		}
 	}
@@ -660,6 +729,7 @@ void VideoDriver_SDL::MainLoop()
 	uint32 cur_ticks = SDL_GetTicks();
 	uint32 last_cur_ticks = cur_ticks;
 	uint32 next_tick = cur_ticks + MILLISECONDS_PER_TICK;
+	uint32 next_draw_tick = cur_ticks + GetDrawInterval();
 	uint32 mod;
 	int numkeys;
 	Uint8 *keys;
@@ -723,9 +793,15 @@ void VideoDriver_SDL::MainLoop()
 		}
 
 		cur_ticks = SDL_GetTicks();
-		if (cur_ticks >= next_tick || (_fast_forward && !_pause_mode) || cur_ticks < prev_cur_ticks) {
+		/* Game ticks and drawing have their own schedule, so fast forwarding is not limited by drawing. */
+		bool tick = cur_ticks >= next_tick || (_fast_forward && !_pause_mode) || cur_ticks < prev_cur_ticks;
+		bool draw = cur_ticks >= next_draw_tick || cur_ticks < prev_cur_ticks;
+		if (tick || draw) {
 			_realtime_tick += cur_ticks - last_cur_ticks;
 			last_cur_ticks = cur_ticks;
+		}
+
+		if (tick) {
 			next_tick = cur_ticks + MILLISECONDS_PER_TICK;
 
 			bool old_ctrl_pressed = _ctrl_pressed;
@@ -755,14 +831,21 @@ void VideoDriver_SDL::MainLoop()
 			GameLoop();
 
 			if (_draw_mutex != NULL) _draw_mutex->BeginCritical();
+		}
+
+		if (draw) {
+			next_draw_tick = cur_ticks + GetDrawInterval();
 
 			UpdateWindows();
 			_local_palette = _cur_palette;
-		} else {
-			/* Release the thread while sleeping */
-			if (_draw_mutex != NULL) _draw_mutex->EndCritical();
-			CSleep(1);
-			if (_draw_mutex != NULL) _draw_mutex->BeginCritical();
+		} else if (!tick) {
+			/* Use the spare time for loading sprites, otherwise sleep. */
+			if (!PrefetchViewportSprites()) {
+				/* Release the thread while sleeping */
+				if (_draw_mutex != NULL) _draw_mutex->EndCritical();
+				CSleep(1);
+				if (_draw_mutex != NULL) _draw_mutex->BeginCritical();
+			}
 
 			NetworkDrawChatMessage();
 			DrawMouseCursor();
@@ -770,9 +853,10 @@ void VideoDriver_SDL::MainLoop()
 
 		/* End of the critical part. */
 		if (_draw_mutex != NULL && !HasModalProgress()) {
-			_draw_mutex->SendSignal();
+			HandFrameToDrawThread();
 		} else {
 			/* Oh, we didn't have threads, then just draw unthreaded */
+			WaitForPresent();
 			CheckPaletteAnim();
 			DrawSurfaceToScreen();
 		}
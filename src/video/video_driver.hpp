@@ -14,6 +14,7 @@
 
 #include "../driver.h"
 #include "../core/geometry_type.hpp"
+#include "../settings_type.h"
 
 /** The base of all video drivers. */
 class VideoDriver : public Driver {
@@ -98,6 +99,17 @@ public:
 	static VideoDriver *GetInstance() {
 		return static_cast<VideoDriver*>(*DriverFactoryBase::GetActiveDriver(Driver::DT_VIDEO));
 	}
+
+protected:
+	/**
+	 * Get the number of milliseconds between two redraws of the screen.
+	 * Drawing is scheduled separately from the game ticks.
+	 * @return The interval derived from the refresh rate setting.
+	 */
+	static uint32 GetDrawInterval()
+	{
+		return 1000 / max<uint>(_settings_client.gui.refresh_rate, 1);
+	}
 };
 
 extern char *_ini_videodriver;
@@ -24,6 +24,7 @@
 #include "../window_gui.h"
 #include "../window_func.h"
 #include "../framerate_type.h"
+#include "../viewport_func.h"
 #include "win32_v.h"
 #include <windows.h>
 #include <imm.h>
@@ -1188,6 +1189,7 @@ void VideoDriver_Win32::MainLoop()
 	uint32 cur_ticks = GetTickCount();
 	uint32 last_cur_ticks = cur_ticks;
 	uint32 next_tick = cur_ticks + MILLISECONDS_PER_TICK;
+	uint32 next_draw_tick = cur_ticks + GetDrawInterval();
 
 	if (_draw_threaded) {
 		/* Initialise the mutex first, because that's the thing we *need*
@@ -1242,9 +1244,18 @@ void VideoDriver_Win32::MainLoop()
 		}
 
 		cur_ticks = GetTickCount();
-		if (cur_ticks >= next_tick || (_fast_forward && !_pause_mode) || cur_ticks < prev_cur_ticks) {
+		/* Game ticks and drawing have their own schedule, so fast forwarding is not limited by drawing. */
+		bool tick = cur_ticks >= next_tick || (_fast_forward && !_pause_mode) || cur_ticks < prev_cur_ticks;
+		bool draw = cur_ticks >= next_draw_tick || cur_ticks < prev_cur_ticks;
+		if (tick || draw) {
 			_realtime_tick += cur_ticks - last_cur_ticks;
 			last_cur_ticks = cur_ticks;
+		}
+
+		/* Flush GDI buffer to ensure we don't conflict with the drawing thread. */
+		GdiFlush();
+
+		if (tick) {
 			next_tick = cur_ticks + MILLISECONDS_PER_TICK;
 
 			bool old_ctrl_pressed = _ctrl_pressed;
@@ -1265,27 +1276,28 @@ void VideoDriver_Win32::MainLoop()
 
 			if (old_ctrl_pressed != _ctrl_pressed) HandleCtrlChanged();
 
-			/* Flush GDI buffer to ensure we don't conflict with the drawing thread. */
-			GdiFlush();
-
 			/* The game loop is the part that can run asynchronously.
 			 * The rest except sleeping can't. */
 			if (_draw_threaded) _draw_mutex->EndCritical();
 			GameLoop();
 			if (_draw_threaded) _draw_mutex->BeginCritical();
+		}
+
+		if (draw) {
+			next_draw_tick = cur_ticks + GetDrawInterval();
 
 			if (_force_full_redraw) MarkWholeScreenDirty();
 
 			UpdateWindows();
 			CheckPaletteAnim();
-		} else {
-			/* Flush GDI buffer to ensure we don't conflict with the drawing thread. */
-			GdiFlush();
-
-			/* Release the thread while sleeping */
-			if (_draw_threaded) _draw_mutex->EndCritical();
-			Sleep(1);
-			if (_draw_threaded) _draw_mutex->BeginCritical();
+		} else if (!tick) {
+			/* Use the spare time for loading sprites, otherwise sleep. */
+			if (!PrefetchViewportSprites()) {
+				/* Release the thread while sleeping */
+				if (_draw_threaded) _draw_mutex->EndCritical();
+				Sleep(1);
+				if (_draw_threaded) _draw_mutex->BeginCritical();
+			}
 
 			NetworkDrawChatMessage();
 			DrawMouseCursor();
@@ -89,8 +89,22 @@
 #include "command_func.h"
 #include "network/network_func.h"
 #include "framerate_type.h"
+#include "thread/thread_pool.h"
+#include "town_map.h"
+#include "console_func.h"
+#include "core/random_func.hpp"
+#include "spritecache.h"
+#include "progress.h"
+#include "elrail_func.h"
+#include "rail_map.h"
+#include "road_map.h"
+#include "tunnelbridge_map.h"
+#include "newgrf_canal.h"
 
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <chrono>
 
 #include "table/strings.h"
 #include "table/string_colours.h"
@@ -182,6 +196,11 @@ static void MarkViewportDirty(const ViewPort *vp, int left, int top, int right,
 
 static ViewportDrawer _vd;
 
+/* Largest number of sprites collected for one viewport draw; the vectors of #_vd keep that capacity. */
+static uint _vd_peak_tile_sprites = 0;   ///< Peak length of #ViewportDrawer::tile_sprites_to_draw.
+static uint _vd_peak_parent_sprites = 0; ///< Peak length of #ViewportDrawer::parent_sprites_to_draw.
+static uint _vd_peak_child_sprites = 0;  ///< Peak length of #ViewportDrawer::child_screen_sprites_to_draw.
+
 TileHighlightData _thd;
 static TileInfo *_cur_ti;
 bool _draw_bounding_boxes = false;
@@ -189,6 +208,76 @@ bool _draw_dirty_blocks = false;
 uint _dirty_block_colour = 0;
 static VpSpriteSorter _vp_sprite_sorter = NULL;
 
+/** Kinds of calls to the viewport drawing functions that are recorded for a tile. */
+enum TileDrawCallType {
+	TDC_GROUND_SPRITE,   ///< #DrawGroundSpriteAt
+	TDC_OFFSET_GROUND,   ///< #OffsetGroundSprite
+	TDC_SORTABLE_SPRITE, ///< #AddSortableSpriteToDraw
+	TDC_CHILD_SPRITE,    ///< #AddChildSpriteScreen
+	TDC_START_COMBINE,   ///< #StartSpriteCombine
+	TDC_END_COMBINE,     ///< #EndSpriteCombine
+};
+
+/**
+ * A recorded call to one of the functions the draw_tile_proc of a tile uses
+ * to add its sprites to the viewport. The calls are recorded instead of the
+ * sprites they add, as the latter depend on the clipping by the area drawn.
+ */
+struct TileDrawCall {
+	SpriteID image;
+	PaletteID pal;
+	const SubSprite *sub;
+	int32 x;             ///< X position, or X offset for ground and child sprites.
+	int32 y;             ///< Y position, or Y offset for ground and child sprites.
+	int32 z;             ///< Z position.
+	int16 w;             ///< Bounding box extent towards positive X; pixel X offset for ground sprites.
+	int16 h;             ///< Bounding box extent towards positive Y; pixel Y offset for ground sprites.
+	int16 dz;            ///< Bounding box extent towards positive Z.
+	int16 bb_offset_x;   ///< Bounding box extent towards negative X.
+	int16 bb_offset_y;   ///< Bounding box extent towards negative Y.
+	int16 bb_offset_z;   ///< Bounding box extent towards negative Z.
+	byte type;           ///< Kind of call, see #TileDrawCallType.
+	bool transparent;    ///< Whether to draw the sprite transparently.
+	bool scale;          ///< Whether the offsets of a child sprite need scaling.
+};
+
+typedef SmallVector<TileDrawCall, 4> TileDrawCallVector;
+
+/**
+ * The recorded calls of the draw_tile_proc of a tile. They are replayed
+ * instead of calling the draw_tile_proc as long as the map contents of the
+ * tile did not change and the tile and its neighbours were not marked dirty.
+ */
+struct CachedTileDraw {
+	TileIndex tile;           ///< The tile the calls were recorded for.
+	uint32 generation;        ///< Value of #_tile_draw_cache_generation the calls were recorded at; 0 if not valid.
+	uint32 state[4];          ///< Map contents, slope and height of the tile the calls were recorded for.
+	ZoomLevel zoom;           ///< Zoom level the calls were recorded at.
+	Slope drawn_tileh;        ///< Slope of the tile after drawing it, i.e. on top of its foundation.
+	int drawn_z;              ///< Height of the tile after drawing it, i.e. on top of its foundation.
+	TileDrawCallVector calls; ///< The recorded calls.
+};
+
+static const uint TILE_DRAW_CACHE_BITS = 8; ///< Number of bits of the tile coordinates used to find the slot of a tile in #_tile_draw_cache.
+static const uint TILE_DRAW_CACHE_MASK = (1 << TILE_DRAW_CACHE_BITS) - 1;
+
+static CachedTileDraw _tile_draw_cache[1 << (2 * TILE_DRAW_CACHE_BITS)]; ///< The cache; tiles share slots when they are a multiple of 256 tiles apart.
+static uint32 _tile_draw_cache_generation = 1; ///< Entries recorded at another generation are not valid.
+static TileDrawCallVector *_tile_draw_record = NULL; ///< Where to record the calls of the tile being drawn; NULL if not recording.
+
+/**
+ * Record a call to a viewport drawing function, if the calls of a tile are being recorded.
+ * @param type Kind of call.
+ * @return The record to fill, or NULL if nothing is being recorded.
+ */
+static inline TileDrawCall *RecordTileDrawCall(TileDrawCallType type)
+{
+	if (_tile_draw_record == NULL) return NULL;
+	TileDrawCall *call = _tile_draw_record->Append();
+	call->type = type;
+	return call;
+}
+
 static Point MapXYZToViewport(const ViewPort *vp, int x, int y, int z)
 {
 	Point p = RemapCoords(x, y, z);
@@ -508,6 +597,41 @@ static void AddTileSpriteToDraw(SpriteID image, PaletteID pal, int32 x, int32 y,
 	ts->y = pt.y + extra_offs_y;
 }
 
+/**
+ * Add a child sprite to a parent sprite, without recording the call.
+ * @see AddChildSpriteScreen
+ */
+static void AddChildSprite(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale)
+{
+	assert((image & SPRITE_MASK) < MAX_SPRITES);
+
+	/* If the ParentSprite was clipped by the viewport bounds, do not draw the ChildSprites either */
+	if (_vd.last_child == NULL) return;
+
+	/* make the sprites transparent with the right palette */
+	if (transparent) {
+		SetBit(image, PALETTE_MODIFIER_TRANSPARENT);
+		pal = PALETTE_TO_TRANSPARENT;
+	}
+
+	*_vd.last_child = _vd.child_screen_sprites_to_draw.Length();
+
+	ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Append();
+	cs->image = image;
+	cs->pal = pal;
+	cs->sub = sub;
+	cs->x = scale ? x * ZOOM_LVL_BASE : x;
+	cs->y = scale ? y * ZOOM_LVL_BASE : y;
+	cs->next = -1;
+
+	/* Append the sprite to the active ChildSprite list.
+	 * If the active ParentSprite is a foundation, update last_foundation_child as well.
+	 * Note: ChildSprites of foundations are NOT sequential in the vector, as selection sprites are added at last. */
+	if (_vd.last_foundation_child[0] == _vd.last_child) _vd.last_foundation_child[0] = &cs->next;
+	if (_vd.last_foundation_child[1] == _vd.last_child) _vd.last_foundation_child[1] = &cs->next;
+	_vd.last_child = &cs->next;
+}
+
 /**
  * Adds a child sprite to the active foundation.
  *
@@ -530,7 +654,7 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
 	int *old_child = _vd.last_child;
 	_vd.last_child = _vd.last_foundation_child[foundation_part];
 
-	AddChildSpriteScreen(image, pal, offs.x + extra_offs_x, offs.y + extra_offs_y, false, sub, false);
+	AddChildSprite(image, pal, offs.x + extra_offs_x, offs.y + extra_offs_y, false, sub, false);
 
 	/* Switch back to last ChildSprite list */
 	_vd.last_child = old_child;
@@ -551,6 +675,18 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
  */
 void DrawGroundSpriteAt(SpriteID image, PaletteID pal, int32 x, int32 y, int z, const SubSprite *sub, int extra_offs_x, int extra_offs_y)
 {
+	TileDrawCall *call = RecordTileDrawCall(TDC_GROUND_SPRITE);
+	if (call != NULL) {
+		call->image = image;
+		call->pal = pal;
+		call->sub = sub;
+		call->x = x;
+		call->y = y;
+		call->z = z;
+		call->w = extra_offs_x;
+		call->h = extra_offs_y;
+	}
+
 	/* Switch to first foundation part, if no foundation was drawn */
 	if (_vd.foundation_part == FOUNDATION_PART_NONE) _vd.foundation_part = FOUNDATION_PART_NORMAL;
 
@@ -586,6 +722,12 @@ void DrawGroundSprite(SpriteID image, PaletteID pal, const SubSprite *sub, int e
  */
 void OffsetGroundSprite(int x, int y)
 {
+	TileDrawCall *call = RecordTileDrawCall(TDC_OFFSET_GROUND);
+	if (call != NULL) {
+		call->x = x;
+		call->y = y;
+	}
+
 	/* Switch to next foundation part */
 	switch (_vd.foundation_part) {
 		case FOUNDATION_PART_NONE:
@@ -628,7 +770,7 @@ static void AddCombinedSprite(SpriteID image, PaletteID pal, int x, int y, int z
 		return;
 
 	const ParentSpriteToDraw *pstd = _vd.parent_sprites_to_draw.End() - 1;
-	AddChildSpriteScreen(image, pal, pt.x - pstd->left, pt.y - pstd->top, false, sub, false);
+	AddChildSprite(image, pal, pt.x - pstd->left, pt.y - pstd->top, false, sub, false);
 }
 
 /**
@@ -662,6 +804,23 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	TileDrawCall *call = RecordTileDrawCall(TDC_SORTABLE_SPRITE);
+	if (call != NULL) {
+		call->image = image;
+		call->pal = pal;
+		call->sub = sub;
+		call->x = x;
+		call->y = y;
+		call->z = z;
+		call->w = w;
+		call->h = h;
+		call->dz = dz;
+		call->bb_offset_x = bb_offset_x;
+		call->bb_offset_y = bb_offset_y;
+		call->bb_offset_z = bb_offset_z;
+		call->transparent = transparent;
+	}
+
 	/* make the sprites transparent with the right palette */
 	if (transparent) {
 		SetBit(image, PALETTE_MODIFIER_TRANSPARENT);
@@ -755,6 +914,7 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
  */
 void StartSpriteCombine()
 {
+	RecordTileDrawCall(TDC_START_COMBINE);
 	assert(_vd.combine_sprites == SPRITE_COMBINE_NONE);
 	_vd.combine_sprites = SPRITE_COMBINE_PENDING;
 }
@@ -765,6 +925,7 @@ void StartSpriteCombine()
  */
 void EndSpriteCombine()
 {
+	RecordTileDrawCall(TDC_END_COMBINE);
 	assert(_vd.combine_sprites != SPRITE_COMBINE_NONE);
 	_vd.combine_sprites = SPRITE_COMBINE_NONE;
 }
@@ -813,33 +974,18 @@ bool IsInsideRotatedRectangle(int x, int y)
  */
 void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale)
 {
-	assert((image & SPRITE_MASK) < MAX_SPRITES);
-
-	/* If the ParentSprite was clipped by the viewport bounds, do not draw the ChildSprites either */
-	if (_vd.last_child == NULL) return;
-
-	/* make the sprites transparent with the right palette */
-	if (transparent) {
-		SetBit(image, PALETTE_MODIFIER_TRANSPARENT);
-		pal = PALETTE_TO_TRANSPARENT;
+	TileDrawCall *call = RecordTileDrawCall(TDC_CHILD_SPRITE);
+	if (call != NULL) {
+		call->image = image;
+		call->pal = pal;
+		call->sub = sub;
+		call->x = x;
+		call->y = y;
+		call->transparent = transparent;
+		call->scale = scale;
 	}
 
-	*_vd.last_child = _vd.child_screen_sprites_to_draw.Length();
-
-	ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Append();
-	cs->image = image;
-	cs->pal = pal;
-	cs->sub = sub;
-	cs->x = scale ? x * ZOOM_LVL_BASE : x;
-	cs->y = scale ? y * ZOOM_LVL_BASE : y;
-	cs->next = -1;
-
-	/* Append the sprite to the active ChildSprite list.
-	 * If the active ParentSprite is a foundation, update last_foundation_child as well.
-	 * Note: ChildSprites of foundations are NOT sequential in the vector, as selection sprites are added at last. */
-	if (_vd.last_foundation_child[0] == _vd.last_child) _vd.last_foundation_child[0] = &cs->next;
-	if (_vd.last_foundation_child[1] == _vd.last_child) _vd.last_foundation_child[1] = &cs->next;
-	_vd.last_child = &cs->next;
+	AddChildSprite(image, pal, x, y, transparent, sub, scale);
 }
 
 static void AddStringToDraw(int x, int y, StringID string, uint64 params_1, uint64 params_2, Colours colour, uint16 width)
@@ -1060,6 +1206,155 @@ static int GetViewportY(Point tile)
 	return (tile.y * (int)(TILE_PIXELS / 2) + tile.x * (int)(TILE_PIXELS / 2) - TilePixelHeightOutsideMap(tile.x, tile.y)) << ZOOM_LVL_SHIFT;
 }
 
+/**
+ * Check whether a rail type has sprites of a NewGRF. Those are resolved with
+ * variables like the date and the town zone, which are not part of the map.
+ * @param rt The rail type.
+ * @return True if any of the sprites of the rail type come from a NewGRF.
+ */
+static bool HasCustomRailTypeSprites(RailType rt)
+{
+	const RailtypeInfo *rti = GetRailTypeInfo(rt);
+	for (uint i = 0; i < RTSG_END; i++) {
+		if (rti->group[i] != NULL) return true;
+	}
+	return false;
+}
+
+/**
+ * Check whether any of the canal and water sprites come from a NewGRF. Their
+ * callbacks read more than the map, e.g. the date or random bits.
+ * @return True if any canal or water feature has a NewGRF sprite group.
+ */
+static bool HasCustomWaterSprites()
+{
+	for (uint i = 0; i < CF_END; i++) {
+		if (_water_feature[i].group != NULL) return true;
+	}
+	return false;
+}
+
+/**
+ * Check whether the sprites of a tile only depend on the map contents of the
+ * tile and its neighbours, so the calls of its draw_tile_proc can be cached.
+ * Stations, industries, objects and NewGRF houses are drawn with callbacks
+ * that read much more, e.g. the cargo waiting or the production, and tiles
+ * below bridges show state of the bridge heads. The same goes for rail types
+ * and canals with NewGRF sprites.
+ * @param ti The tile.
+ * @param tile_type Type of the tile.
+ * @return True if the draw calls of the tile can be cached.
+ */
+static bool CanCacheTileDraw(const TileInfo *ti, TileType tile_type)
+{
+	if (IsBridgeAbove(ti->tile)) return false;
+
+	switch (tile_type) {
+		case MP_CLEAR:
+		case MP_TREES:
+			return true;
+
+		case MP_RAILWAY:
+			return !HasCustomRailTypeSprites(GetRailType(ti->tile));
+
+		case MP_ROAD:
+			return !IsLevelCrossing(ti->tile) || !HasCustomRailTypeSprites(GetRailType(ti->tile));
+
+		case MP_WATER:
+			return !HasCustomWaterSprites();
+
+		case MP_TUNNELBRIDGE:
+			return GetTunnelBridgeTransportType(ti->tile) != TRANSPORT_RAIL || !HasCustomRailTypeSprites(GetRailType(ti->tile));
+
+		case MP_HOUSE:
+			return HouseSpec::Get(GetHouseType(ti->tile))->grf_prop.spritegroup[0] == NULL;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Get the slot of a tile in #_tile_draw_cache.
+ * @param x X coordinate of the tile.
+ * @param y Y coordinate of the tile.
+ * @return The slot.
+ */
+static inline CachedTileDraw *GetCachedTileDraw(uint x, uint y)
+{
+	return &_tile_draw_cache[(x & TILE_DRAW_CACHE_MASK) | (y & TILE_DRAW_CACHE_MASK) << TILE_DRAW_CACHE_BITS];
+}
+
+/**
+ * Get the map contents of a tile that is being drawn, including its slope
+ * and height, in a compact form to check caches of the drawing against.
+ * @param ti The tile.
+ * @param[out] state The contents of the tile.
+ */
+void GetTileDrawState(const TileInfo *ti, uint32 state[4])
+{
+	TileIndex t = ti->tile;
+	state[0] = _m[t].type | _m[t].height << 8 | _m[t].m2 << 16;
+	state[1] = _m[t].m1 | _m[t].m3 << 8 | _m[t].m4 << 16 | _m[t].m5 << 24;
+	state[2] = _me[t].m6 | _me[t].m7 << 8 | _me[t].m8 << 16;
+	state[3] = ti->tileh | ti->z << 8;
+}
+
+/**
+ * Draw a tile using the cached calls of its draw_tile_proc, if they are still
+ * valid. Otherwise call the draw_tile_proc and record its calls.
+ * @param ti The tile.
+ * @param tile_type Type of the tile.
+ */
+static void DrawTileCached(TileInfo *ti, TileType tile_type)
+{
+	TileIndex t = ti->tile;
+	uint32 state[4];
+	GetTileDrawState(ti, state);
+
+	CachedTileDraw *entry = GetCachedTileDraw(TileX(t), TileY(t));
+	if (entry->generation == _tile_draw_cache_generation && entry->tile == t && entry->zoom == _vd.dpi.zoom && memcmp(entry->state, state, sizeof(state)) == 0) {
+		for (const TileDrawCall *call = entry->calls.Begin(); call != entry->calls.End(); call++) {
+			switch (call->type) {
+				case TDC_GROUND_SPRITE:   DrawGroundSpriteAt(call->image, call->pal, call->x, call->y, call->z, call->sub, call->w, call->h); break;
+				case TDC_OFFSET_GROUND:   OffsetGroundSprite(call->x, call->y); break;
+				case TDC_SORTABLE_SPRITE: AddSortableSpriteToDraw(call->image, call->pal, call->x, call->y, call->w, call->h, call->dz, call->z, call->transparent, call->bb_offset_x, call->bb_offset_y, call->bb_offset_z, call->sub); break;
+				case TDC_CHILD_SPRITE:    AddChildSpriteScreen(call->image, call->pal, call->x, call->y, call->transparent, call->sub, call->scale); break;
+				case TDC_START_COMBINE:   StartSpriteCombine(); break;
+				case TDC_END_COMBINE:     EndSpriteCombine(); break;
+				default: NOT_REACHED();
+			}
+		}
+		/* Drawing a foundation moves the tile on top of it, which the tile selection is drawn on. */
+		ti->tileh = entry->drawn_tileh;
+		ti->z = entry->drawn_z;
+		return;
+	}
+
+	entry->calls.Clear();
+	_tile_draw_record = &entry->calls;
+	_tile_type_procs[tile_type]->draw_tile_proc(ti);
+	_tile_draw_record = NULL;
+
+	entry->tile = t;
+	entry->generation = _tile_draw_cache_generation;
+	memcpy(entry->state, state, sizeof(state));
+	entry->zoom = _vd.dpi.zoom;
+	entry->drawn_tileh = ti->tileh;
+	entry->drawn_z = ti->z;
+}
+
+/**
+ * Invalidate the cached draw calls of all tiles, e.g. because settings that
+ * influence the drawing of all tiles like transparency were changed.
+ */
+void InvalidateTileDrawCache()
+{
+	_tile_draw_cache_generation++;
+	if (_tile_draw_cache_generation == 0) _tile_draw_cache_generation = 1;
+	InvalidateAllCatenaryLayouts();
+}
+
 /**
  * Add the landscape to the viewport, i.e. all ground tiles and buildings.
  */
@@ -1170,7 +1465,11 @@ static void ViewportAddLandscape()
 				_vd.last_foundation_child[0] = NULL;
 				_vd.last_foundation_child[1] = NULL;
 
-				_tile_type_procs[tile_type]->draw_tile_proc(&tile_info);
+				if (tile_info.tile != INVALID_TILE && CanCacheTileDraw(&tile_info, tile_type)) {
+					DrawTileCached(&tile_info, tile_type);
+				} else {
+					_tile_type_procs[tile_type]->draw_tile_proc(&tile_info);
+				}
 				if (tile_info.tile != INVALID_TILE) DrawTileSelection(&tile_info);
 			}
 		}
@@ -1341,6 +1640,9 @@ void ViewportSign::UpdatePosition(int center, int top, StringID str, StringID st
 {
 	if (this->width_normal != 0) this->MarkDirty();
 
+	/* The text of the sign may have changed. */
+	InvalidateCachedStrings(GetDParam(0));
+
 	this->top = top;
 
 	char buffer[DRAW_STRING_BUFFER];
@@ -1401,8 +1703,11 @@ static bool ViewportSortParentSpritesChecker()
 	return true;
 }
 
-/** Sort parent sprites pointer array */
-static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
+/**
+ * Sort parent sprites pointer array by comparing every sprite with all sprites after it.
+ * This is the reference for the order of the other sorters.
+ */
+static void ViewportSortParentSpritesQuadratic(ParentSpriteToSortVector *psdv)
 {
 	ParentSpriteToDraw **psdvend = psdv->End();
 	ParentSpriteToDraw **psd = psdv->Begin();
@@ -1459,6 +1764,119 @@ static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
 	}
 }
 
+/**
+ * Check whether a sprite has to be drawn before another sprite, according to the
+ * comparison of #ViewportSortParentSpritesQuadratic.
+ * @param ps The sprite that comes first in the current order.
+ * @param ps2 The sprite that comes later in the current order.
+ * @return True if \a ps2 has to be moved in front of \a ps.
+ */
+static inline bool IsParentSpriteBefore(const ParentSpriteToDraw *ps, const ParentSpriteToDraw *ps2)
+{
+	if (ps->xmax < ps2->xmin || ps->ymax < ps2->ymin || ps->zmax < ps2->zmin) return false;
+
+	if (ps->xmin <= ps2->xmax && ps->ymin <= ps2->ymax && ps->zmin <= ps2->zmax) {
+		/* The bounding boxes overlap, so use X+Y+Z of the centres. */
+		return ps->xmin + ps->xmax + ps->ymin + ps->ymax + ps->zmin + ps->zmax >
+				ps2->xmin + ps2->xmax + ps2->ymin + ps2->ymax + ps2->zmin + ps2->zmax;
+	}
+	return true;
+}
+
+static const uint32 SPRITE_ORDER_COMPARED = UINT32_MAX;     ///< Order of a sprite that has been compared, but sprites moved in front of it still need to be output.
+static const uint32 SPRITE_ORDER_DONE     = UINT32_MAX - 1; ///< Order of a sprite that has been output.
+
+/**
+ * Sort parent sprites pointer array, resulting in the same order as
+ * #ViewportSortParentSpritesQuadratic without comparing all pairs.
+ *
+ * That sorter takes the first sprite not compared yet, compares it with all
+ * sprites after it and moves the ones that have to be drawn before it to the
+ * front. A sprite can only be moved in front of a sprite when its minimum X
+ * and Y are not larger than the other's maximum X and Y. So here the sprites
+ * not compared yet are kept sorted by minimum X + Y and only the ones up to
+ * the maximum X + Y of the sprite to compare are visited. As the sprites are
+ * mostly compared from north to south, these are few. The order still to
+ * output is kept as stack, with the first sprite at the top; moving sprites
+ * to the front means pushing them once more and skipping the old entries.
+ * @note Sprites are referred to by their index in the unsorted array, so no state is needed in #ParentSpriteToDraw.
+ */
+static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
+{
+	uint count = psdv->Length();
+	if (count < 2) return;
+
+	std::vector<ParentSpriteToDraw *> sprites(psdv->Begin(), psdv->End());
+
+	/* The sprites not compared yet sorted by minimum X + Y, as single linked list over the ranks with the head at count. */
+	std::vector<uint> by_key(count);
+	std::vector<int64> key(count);
+	for (uint i = 0; i < count; i++) {
+		by_key[i] = i;
+		key[i] = (int64)sprites[i]->xmin + sprites[i]->ymin;
+	}
+	std::sort(by_key.begin(), by_key.end(), [&key](uint a, uint b) { return key[a] < key[b]; });
+	std::vector<uint> next(count + 1);
+	for (uint i = 0; i < count; i++) next[i] = i + 1;
+	next[count] = 0;
+
+	/* Position in the order still to output; higher values come first. */
+	std::vector<uint32> order(count);
+	std::vector<uint> stack;
+	stack.reserve(count * 2);
+	uint32 next_order = 0;
+	for (uint i = count; i-- > 0;) {
+		order[i] = next_order++;
+		stack.push_back(i);
+	}
+
+	std::vector<uint> preceding;
+	ParentSpriteToDraw **out = psdv->Begin();
+	while (!stack.empty()) {
+		uint s = stack.back();
+		stack.pop_back();
+
+		if (order[s] == SPRITE_ORDER_DONE) continue;
+		if (order[s] == SPRITE_ORDER_COMPARED) {
+			order[s] = SPRITE_ORDER_DONE;
+			*out++ = sprites[s];
+			continue;
+		}
+
+		const ParentSpriteToDraw *ps = sprites[s];
+		/* The maximum may be one less than the minimum for thin slices, so use both to also find ps itself. */
+		int64 limit = (int64)max(ps->xmin, ps->xmax) + max(ps->ymin, ps->ymax);
+		preceding.clear();
+		uint prev = count;
+		for (uint cur = next[count]; cur != count && key[by_key[cur]] <= limit; cur = next[cur]) {
+			uint s2 = by_key[cur];
+			if (s2 == s) {
+				/* Remove ps from the sprites not compared yet. */
+				next[prev] = next[cur];
+				continue;
+			}
+			if (IsParentSpriteBefore(ps, sprites[s2])) preceding.push_back(s2);
+			prev = cur;
+		}
+
+		if (preceding.empty()) {
+			order[s] = SPRITE_ORDER_DONE;
+			*out++ = sprites[s];
+			continue;
+		}
+
+		/* Push ps and then the sprites to move in front of it, the one that comes last in the current order at the top. */
+		std::sort(preceding.begin(), preceding.end(), [&order](uint a, uint b) { return order[a] > order[b]; });
+		order[s] = SPRITE_ORDER_COMPARED;
+		stack.push_back(s);
+		for (std::vector<uint>::iterator it = preceding.begin(); it != preceding.end(); it++) {
+			order[*it] = next_order++;
+			stack.push_back(*it);
+		}
+	}
+	assert(out == psdv->End());
+}
+
 static void ViewportDrawParentSprites(const ParentSpriteToSortVector *psd, const ChildScreenSpriteToDrawVector *csstdv)
 {
 	const ParentSpriteToDraw * const *psd_end = psd->End();
@@ -1529,9 +1947,6 @@ static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *
 		int y = UnScaleByZoom(ss->y, zoom);
 		int h = VPSM_TOP + (small ? FONT_HEIGHT_SMALL : FONT_HEIGHT_NORMAL) + VPSM_BOTTOM;
 
-		SetDParam(0, ss->params[0]);
-		SetDParam(1, ss->params[1]);
-
 		if (ss->colour != INVALID_COLOUR) {
 			/* Do not draw signs nor station names if they are set invisible */
 			if (IsInvisibilitySet(TO_SIGNS) && ss->string != STR_WHITE_SIGN) continue;
@@ -1551,11 +1966,20 @@ static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *
 			}
 		}
 
-		DrawString(x + VPSM_LEFT, x + w - 1 - VPSM_RIGHT, y + VPSM_TOP, ss->string, colour, SA_HOR_CENTER);
+		DrawString(x + VPSM_LEFT, x + w - 1 - VPSM_RIGHT, y + VPSM_TOP, GetCachedString(ss->string, ss->params[0], ss->params[1]), colour, SA_HOR_CENTER);
 	}
 }
 
-void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom)
+/**
+ * Collect the sprites to draw for an area of a viewport in #_vd, and make the
+ * list of parent sprites to sort.
+ * @param vp The viewport.
+ * @param left Left edge of the area, in viewport coordinates.
+ * @param top Top edge of the area, in viewport coordinates.
+ * @param right Right edge of the area, in viewport coordinates.
+ * @param bottom Bottom edge of the area, in viewport coordinates.
+ */
+static void ViewportCollectSprites(const ViewPort *vp, int left, int top, int right, int bottom)
 {
 	DrawPixelInfo *old_dpi = _cur_dpi;
 	_cur_dpi = &_vd.dpi;
@@ -1584,14 +2008,58 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 
 	DrawTextEffects(&_vd.dpi);
 
-	if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
-
+	_vd.parent_sprites_to_sort.Reserve(_vd.parent_sprites_to_draw.Length());
 	ParentSpriteToDraw *psd_end = _vd.parent_sprites_to_draw.End();
 	for (ParentSpriteToDraw *it = _vd.parent_sprites_to_draw.Begin(); it != psd_end; it++) {
 		*_vd.parent_sprites_to_sort.Append() = it;
 	}
 
-	_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
+	_cur_dpi = old_dpi;
+}
+
+/** Forget the sprites collected in #_vd. */
+static void ViewportClearSprites()
+{
+	_vd_peak_tile_sprites = max(_vd_peak_tile_sprites, _vd.tile_sprites_to_draw.Length());
+	_vd_peak_parent_sprites = max(_vd_peak_parent_sprites, _vd.parent_sprites_to_draw.Length());
+	_vd_peak_child_sprites = max(_vd_peak_child_sprites, _vd.child_screen_sprites_to_draw.Length());
+
+	_vd.string_sprites_to_draw.Clear();
+	_vd.tile_sprites_to_draw.Clear();
+	_vd.parent_sprites_to_draw.Clear();
+	_vd.parent_sprites_to_sort.Clear();
+	_vd.child_screen_sprites_to_draw.Clear();
+}
+
+/**
+ * Get the largest number of sprites that were collected for drawing one viewport area.
+ * The sprite buffers keep that capacity, so drawing does not allocate until a new peak is reached.
+ * @param[out] tile   Peak number of ground sprites.
+ * @param[out] parent Peak number of sortable sprites.
+ * @param[out] child  Peak number of child sprites.
+ */
+void GetViewportSpriteStats(uint *tile, uint *parent, uint *child)
+{
+	*tile = _vd_peak_tile_sprites;
+	*parent = _vd_peak_parent_sprites;
+	*child = _vd_peak_child_sprites;
+}
+
+/**
+ * Draw the sprites collected in #_vd by #ViewportCollectSprites, after the parent sprites are sorted.
+ * @param vp The viewport.
+ */
+static void ViewportDrawSprites(const ViewPort *vp)
+{
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_cur_dpi = &_vd.dpi;
+
+	int mask = ScaleByZoom(-1, vp->zoom);
+	int x = UnScaleByZoom(_vd.dpi.left - (vp->virtual_left & mask), vp->zoom) + vp->left;
+	int y = UnScaleByZoom(_vd.dpi.top - (vp->virtual_top & mask), vp->zoom) + vp->top;
+
+	if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+
 	ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
 
 	if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
@@ -1620,36 +2088,124 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 
 	_cur_dpi = old_dpi;
 
-	_vd.string_sprites_to_draw.Clear();
-	_vd.tile_sprites_to_draw.Clear();
-	_vd.parent_sprites_to_draw.Clear();
-	_vd.parent_sprites_to_sort.Clear();
-	_vd.child_screen_sprites_to_draw.Clear();
+	ViewportClearSprites();
+}
+
+void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom)
+{
+	ViewportCollectSprites(vp, left, top, right, bottom);
+	_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
+	ViewportDrawSprites(vp);
 }
 
 /**
- * Make sure we don't draw a too big area at a time.
- * If we do, the sprite memory will overflow.
+ * Exchange the collected sprites of two drawers, without copying them.
+ * @param a The one drawer.
+ * @param b The other drawer.
  */
-static void ViewportDrawChk(const ViewPort *vp, int left, int top, int right, int bottom)
+static void SwapViewportDrawer(ViewportDrawer *a, ViewportDrawer *b)
+{
+	Swap(a->dpi, b->dpi);
+	a->string_sprites_to_draw.Swap(b->string_sprites_to_draw);
+	a->tile_sprites_to_draw.Swap(b->tile_sprites_to_draw);
+	a->parent_sprites_to_draw.Swap(b->parent_sprites_to_draw);
+	a->parent_sprites_to_sort.Swap(b->parent_sprites_to_sort);
+	a->child_screen_sprites_to_draw.Swap(b->child_screen_sprites_to_draw);
+}
+
+/**
+ * Sort the parent sprites of a range of chunks of a viewport.
+ * @param data The drawers of the chunks.
+ * @param first First chunk to sort.
+ * @param last One past the last chunk to sort.
+ */
+static void ViewportSortChunksProc(void *data, uint first, uint last)
+{
+	ViewportDrawer **drawers = (ViewportDrawer **)data;
+	for (uint i = first; i < last; i++) _vp_sprite_sorter(&drawers[i]->parent_sprites_to_sort);
+}
+
+static const uint VIEWPORT_MAX_CHUNK_AREA = 180000; ///< Largest area in pixels at normal zoom that is drawn in one go.
+static const uint VIEWPORT_MIN_CHUNK_AREA = 16384;  ///< Smallest area in pixels at normal zoom an area is split into for sorting the chunks in parallel.
+
+/**
+ * Split an area of a viewport in chunks in which the sprites are collected,
+ * sorted and drawn separately.
+ * @param vp The viewport.
+ * @param left Left edge of the area, in screen coordinates.
+ * @param top Top edge of the area, in screen coordinates.
+ * @param right Right edge of the area, in screen coordinates.
+ * @param bottom Bottom edge of the area, in screen coordinates.
+ * @param max_area Largest area of a chunk, in pixels at normal zoom.
+ * @param[out] chunks The chunks, in screen coordinates.
+ */
+static void ViewportSplitChunks(const ViewPort *vp, int left, int top, int right, int bottom, uint64 max_area, SmallVector<Rect, 16> &chunks)
 {
-	if (ScaleByZoom(bottom - top, vp->zoom) * ScaleByZoom(right - left, vp->zoom) > 180000 * ZOOM_LVL_BASE * ZOOM_LVL_BASE) {
+	if ((uint64)ScaleByZoom(bottom - top, vp->zoom) * ScaleByZoom(right - left, vp->zoom) > max_area * ZOOM_LVL_BASE * ZOOM_LVL_BASE) {
 		if ((bottom - top) > (right - left)) {
 			int t = (top + bottom) >> 1;
-			ViewportDrawChk(vp, left, top, right, t);
-			ViewportDrawChk(vp, left, t, right, bottom);
+			ViewportSplitChunks(vp, left, top, right, t, max_area, chunks);
+			ViewportSplitChunks(vp, left, t, right, bottom, max_area, chunks);
 		} else {
 			int t = (left + right) >> 1;
-			ViewportDrawChk(vp, left, top, t, bottom);
-			ViewportDrawChk(vp, t, top, right, bottom);
+			ViewportSplitChunks(vp, left, top, t, bottom, max_area, chunks);
+			ViewportSplitChunks(vp, t, top, right, bottom, max_area, chunks);
 		}
 	} else {
-		ViewportDoDraw(vp,
-			ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom(top - vp->top, vp->zoom) + vp->virtual_top,
-			ScaleByZoom(right - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom(bottom - vp->top, vp->zoom) + vp->virtual_top
-		);
+		Rect *r = chunks.Append();
+		r->left = ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left;
+		r->top = ScaleByZoom(top - vp->top, vp->zoom) + vp->virtual_top;
+		r->right = ScaleByZoom(right - vp->left, vp->zoom) + vp->virtual_left;
+		r->bottom = ScaleByZoom(bottom - vp->top, vp->zoom) + vp->virtual_top;
+	}
+}
+
+/**
+ * Draw an area of a viewport in chunks. With worker threads the area is
+ * split in more chunks, of which the parent sprites are sorted in parallel.
+ * Collecting the sprites runs NewGRF callbacks and drawing them may load
+ * sprites into the sprite cache, so those parts stay on this thread.
+ * @param vp The viewport.
+ * @param left Left edge of the area, in screen coordinates.
+ * @param top Top edge of the area, in screen coordinates.
+ * @param right Right edge of the area, in screen coordinates.
+ * @param bottom Bottom edge of the area, in screen coordinates.
+ */
+static void ViewportDrawChk(const ViewPort *vp, int left, int top, int right, int bottom)
+{
+	static SmallVector<Rect, 16> chunks;
+	static SmallVector<ViewportDrawer *, 16> drawers; ///< Drawers of the chunks; kept so their memory is reused.
+
+	InitThreadPool();
+	uint workers = GetThreadPoolWorkerCount();
+	uint64 max_area = VIEWPORT_MAX_CHUNK_AREA;
+	if (workers > 0) {
+		/* Give every thread a few chunks, so a chunk with many sprites does not keep the others waiting. */
+		uint64 area = (uint64)ScaleByZoom(bottom - top, vp->zoom) * ScaleByZoom(right - left, vp->zoom) / (ZOOM_LVL_BASE * ZOOM_LVL_BASE);
+		max_area = Clamp<uint64>(area / (4 * (workers + 1)), VIEWPORT_MIN_CHUNK_AREA, VIEWPORT_MAX_CHUNK_AREA);
+	}
+
+	chunks.Clear();
+	ViewportSplitChunks(vp, left, top, right, bottom, max_area, chunks);
+
+	if (workers == 0 || chunks.Length() == 1) {
+		for (const Rect *r = chunks.Begin(); r != chunks.End(); r++) ViewportDoDraw(vp, r->left, r->top, r->right, r->bottom);
+		return;
+	}
+
+	while (drawers.Length() < chunks.Length()) *drawers.Append() = new ViewportDrawer();
+
+	for (uint i = 0; i < chunks.Length(); i++) {
+		const Rect *r = chunks.Get(i);
+		ViewportCollectSprites(vp, r->left, r->top, r->right, r->bottom);
+		SwapViewportDrawer(&_vd, drawers[i]);
+	}
+
+	ThreadPoolParallelFor(&ViewportSortChunksProc, drawers.Begin(), chunks.Length(), 1);
+
+	for (uint i = 0; i < chunks.Length(); i++) {
+		SwapViewportDrawer(&_vd, drawers[i]);
+		ViewportDrawSprites(vp);
 	}
 }
 
@@ -1670,6 +2226,104 @@ static inline void ViewportDraw(const ViewPort *vp, int left, int top, int right
 	ViewportDrawChk(vp, left, top, right, bottom);
 }
 
+static const uint VIEWPORT_PREFETCH_BUDGET = 2; ///< Milliseconds spent at most on prefetching sprites in one go.
+
+/** State of prefetching the sprites around the main viewport. */
+struct ViewportPrefetch {
+	int virtual_left;              ///< Virtual left coordinate of the viewport the sprites are prefetched for.
+	int virtual_top;               ///< Virtual top coordinate of the viewport the sprites are prefetched for.
+	int virtual_width;             ///< Virtual width of the viewport the sprites are prefetched for.
+	int virtual_height;            ///< Virtual height of the viewport the sprites are prefetched for.
+	ZoomLevel zoom;                ///< Zoom level of the viewport the sprites are prefetched for.
+	SmallVector<Rect, 16> chunks;  ///< Chunks around the viewport of which the sprites still have to be collected, in viewport coordinates.
+};
+
+static ViewportPrefetch _vp_prefetch;
+
+/**
+ * Queue the sprites of a chunk of a viewport for prefetching, by collecting
+ * them as if the chunk were drawn.
+ * @param vp The viewport.
+ * @param r The chunk, in viewport coordinates.
+ */
+static void ViewportPrefetchChunk(const ViewPort *vp, const Rect &r)
+{
+	/* Nothing is drawn, but collecting the sprites needs a valid draw context. */
+	DrawPixelInfo dpi = _screen;
+	dpi.left = 0;
+	dpi.top = 0;
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_cur_dpi = &dpi;
+
+	ViewportCollectSprites(vp, r.left, r.top, r.right, r.bottom);
+
+	for (const TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Begin(); ts != _vd.tile_sprites_to_draw.End(); ts++) {
+		PrefetchSprite(ts->image & SPRITE_MASK);
+	}
+	for (const ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Begin(); cs != _vd.child_screen_sprites_to_draw.End(); cs++) {
+		PrefetchSprite(cs->image & SPRITE_MASK);
+	}
+	/* Parent sprites are loaded already, to find out whether they are inside the chunk. */
+
+	ViewportClearSprites();
+	_cur_dpi = old_dpi;
+}
+
+/**
+ * Load the sprites just outside the main viewport into the sprite cache, so
+ * scrolling or zooming out does not have to load them while drawing. The
+ * sprite cache holds all zoom levels of a sprite, and the area around the
+ * viewport is half its size on every side, which is exactly what becomes
+ * visible when zooming out one level.
+ * Called when the video driver would otherwise sleep; every call does
+ * at most #VIEWPORT_PREFETCH_BUDGET milliseconds of work.
+ * @return True if there is more to prefetch, false if the driver can sleep.
+ */
+bool PrefetchViewportSprites()
+{
+	/* The map may be changed by another thread meanwhile. */
+	if (HasModalProgress()) return false;
+
+	const Window *w = FindWindowById(WC_MAIN_WINDOW, 0);
+	if (w == NULL || w->viewport == NULL) return false;
+	const ViewPort *vp = w->viewport;
+
+	if (vp->virtual_left != _vp_prefetch.virtual_left || vp->virtual_top != _vp_prefetch.virtual_top ||
+			vp->virtual_width != _vp_prefetch.virtual_width || vp->virtual_height != _vp_prefetch.virtual_height || vp->zoom != _vp_prefetch.zoom) {
+		_vp_prefetch.virtual_left = vp->virtual_left;
+		_vp_prefetch.virtual_top = vp->virtual_top;
+		_vp_prefetch.virtual_width = vp->virtual_width;
+		_vp_prefetch.virtual_height = vp->virtual_height;
+		_vp_prefetch.zoom = vp->zoom;
+
+		int left = vp->left;
+		int top = vp->top;
+		int right = vp->left + vp->width;
+		int bottom = vp->top + vp->height;
+		int margin_x = vp->width / 2;
+		int margin_y = vp->height / 2;
+
+		_vp_prefetch.chunks.Clear();
+		ViewportSplitChunks(vp, left - margin_x, top - margin_y, right + margin_x, top, VIEWPORT_MAX_CHUNK_AREA, _vp_prefetch.chunks);
+		ViewportSplitChunks(vp, left - margin_x, bottom, right + margin_x, bottom + margin_y, VIEWPORT_MAX_CHUNK_AREA, _vp_prefetch.chunks);
+		ViewportSplitChunks(vp, left - margin_x, top, left, bottom, VIEWPORT_MAX_CHUNK_AREA, _vp_prefetch.chunks);
+		ViewportSplitChunks(vp, right, top, right + margin_x, bottom, VIEWPORT_MAX_CHUNK_AREA, _vp_prefetch.chunks);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	do {
+		if (!ProcessSpritePrefetchQueue()) {
+			if (_vp_prefetch.chunks.Length() == 0) return false;
+
+			Rect r = *(_vp_prefetch.chunks.End() - 1);
+			_vp_prefetch.chunks.Erase(_vp_prefetch.chunks.End() - 1);
+			ViewportPrefetchChunk(vp, r);
+		}
+	} while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(VIEWPORT_PREFETCH_BUDGET));
+
+	return true;
+}
+
 /**
  * Draw the viewport of this window.
  */
@@ -1799,26 +2453,122 @@ static void MarkViewportDirty(const ViewPort *vp, int left, int top, int right,
 	);
 }
 
+static uint _viewport_dirty_batch_depth = 0; ///< Number of active #ViewportDirtyBatch instances.
+static Rect _viewport_dirty_pending;         ///< Merged area marked dirty in the active batch; empty when left > right.
+static uint64 _viewport_dirty_pending_area;  ///< Sum of the areas merged into #_viewport_dirty_pending.
+
+/**
+ * Get the area of a rectangle.
+ * @param r The rectangle.
+ * @return Its area.
+ */
+static inline uint64 GetRectArea(const Rect &r)
+{
+	return (uint64)(r.right - r.left + 1) * (uint64)(r.bottom - r.top + 1);
+}
+
+/**
+ * Mark all viewports that display an area as dirty right away.
+ * @param left   Left   edge of area to repaint.
+ * @param top    Top    edge of area to repaint.
+ * @param right  Right  edge of area to repaint.
+ * @param bottom Bottom edge of area to repaint.
+ */
+static void MarkAllViewportsDirtyNow(int left, int top, int right, int bottom)
+{
+	Window *w;
+	FOR_ALL_WINDOWS_FROM_BACK(w) {
+		ViewPort *vp = w->viewport;
+		if (vp != NULL) {
+			assert(vp->width != 0);
+			MarkViewportDirty(vp, left, top, right, bottom);
+		}
+	}
+}
+
+/**
+ * Check whether a point is shown by, or close to, any viewport of a window.
+ * @param x        X coordinate of the point. (viewport coordinates, that is wrt. #ZOOM_LVL_NORMAL)
+ * @param y        Y coordinate of the point. (viewport coordinates, that is wrt. #ZOOM_LVL_NORMAL)
+ * @param margin_x Horizontal distance to the viewports within which the point counts as close.
+ * @param margin_y Vertical distance to the viewports within which the point counts as close.
+ * @return True iff the point is within the margins of the area shown by a viewport.
+ */
+bool IsPointNearAnyViewport(int x, int y, int margin_x, int margin_y)
+{
+	const Window *w;
+	FOR_ALL_WINDOWS_FROM_BACK(w) {
+		const ViewPort *vp = w->viewport;
+		if (vp == NULL) continue;
+		if (x >= vp->virtual_left - margin_x && x < vp->virtual_left + vp->virtual_width + margin_x &&
+				y >= vp->virtual_top - margin_y && y < vp->virtual_top + vp->virtual_height + margin_y) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Mark the area collected by the active #ViewportDirtyBatch dirty. */
+static void FlushViewportDirtyBatch()
+{
+	if (_viewport_dirty_pending.left > _viewport_dirty_pending.right) return;
+	MarkAllViewportsDirtyNow(_viewport_dirty_pending.left, _viewport_dirty_pending.top, _viewport_dirty_pending.right, _viewport_dirty_pending.bottom);
+	_viewport_dirty_pending.left = 0;
+	_viewport_dirty_pending.right = -1;
+}
+
 /**
  * Mark all viewports that display an area as dirty (in need of repaint).
  * @param left   Left   edge of area to repaint. (viewport coordinates, that is wrt. #ZOOM_LVL_NORMAL)
  * @param top    Top    edge of area to repaint. (viewport coordinates, that is wrt. #ZOOM_LVL_NORMAL)
  * @param right  Right  edge of area to repaint. (viewport coordinates, that is wrt. #ZOOM_LVL_NORMAL)
  * @param bottom Bottom edge of area to repaint. (viewport coordinates, that is wrt. #ZOOM_LVL_NORMAL)
+ * While a #ViewportDirtyBatch exists the area is merged with the areas marked before.
  * @ingroup dirty
  */
 void MarkAllViewportsDirty(int left, int top, int right, int bottom)
 {
-	Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		ViewPort *vp = w->viewport;
-		if (vp != NULL) {
-			assert(vp->width != 0);
-			MarkViewportDirty(vp, left, top, right, bottom);
+	if (_viewport_dirty_batch_depth == 0) {
+		MarkAllViewportsDirtyNow(left, top, right, bottom);
+		return;
+	}
+
+	Rect r = { left, top, right, bottom };
+	if (_viewport_dirty_pending.left <= _viewport_dirty_pending.right) {
+		Rect merged;
+		merged.left   = min(_viewport_dirty_pending.left,   r.left);
+		merged.top    = min(_viewport_dirty_pending.top,    r.top);
+		merged.right  = max(_viewport_dirty_pending.right,  r.right);
+		merged.bottom = max(_viewport_dirty_pending.bottom, r.bottom);
+
+		/* Only merge while the bounding box does not redraw much more than the areas themselves,
+		 * which would happen with diagonal trains or far apart tiles. */
+		uint64 area = _viewport_dirty_pending_area + GetRectArea(r);
+		if (GetRectArea(merged) <= 2 * area) {
+			_viewport_dirty_pending = merged;
+			_viewport_dirty_pending_area = area;
+			return;
 		}
+		FlushViewportDirtyBatch();
+	}
+
+	_viewport_dirty_pending = r;
+	_viewport_dirty_pending_area = GetRectArea(r);
+}
+
+ViewportDirtyBatch::ViewportDirtyBatch()
+{
+	if (_viewport_dirty_batch_depth++ == 0) {
+		_viewport_dirty_pending.left = 0;
+		_viewport_dirty_pending.right = -1;
 	}
 }
 
+ViewportDirtyBatch::~ViewportDirtyBatch()
+{
+	if (--_viewport_dirty_batch_depth == 0) FlushViewportDirtyBatch();
+}
+
 void ConstrainAllViewportsZoom()
 {
 	Window *w;
@@ -1842,6 +2592,14 @@ void ConstrainAllViewportsZoom()
  */
 void MarkTileDirtyByTile(TileIndex tile, int bridge_level_offset, int tile_height_override)
 {
+	/* The sprites of a tile may depend on its neighbours, e.g. for catenary or water borders. */
+	for (uint y = TileY(tile) - 1; y != TileY(tile) + 2; y++) {
+		for (uint x = TileX(tile) - 1; x != TileX(tile) + 2; x++) {
+			GetCachedTileDraw(x, y)->generation = 0;
+			InvalidateCatenaryLayout(x, y);
+		}
+	}
+
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, tile_height_override * TILE_HEIGHT);
 	MarkAllViewportsDirty(
 			pt.x - MAX_TILE_EXTENT_LEFT,
@@ -3260,30 +4018,53 @@ void ResetObjectToPlace()
 	SetObjectToPlace(SPR_CURSOR_MOUSE, PAL_NONE, HT_NONE, WC_MAIN_WINDOW, 0);
 }
 
-Point GetViewportStationMiddle(const ViewPort *vp, const Station *st)
+/**
+ * Get the position of a station in virtual coordinates, which do not change
+ * when a viewport is scrolled or zoomed.
+ * @param st The station.
+ * @return The position of the station sign tile in virtual coordinates.
+ */
+Point GetStationVirtualMiddle(const Station *st)
 {
 	int x = TileX(st->xy) * TILE_SIZE;
 	int y = TileY(st->xy) * TILE_SIZE;
 	int z = GetSlopePixelZ(Clamp(x, 0, MapSizeX() * TILE_SIZE - 1), Clamp(y, 0, MapSizeY() * TILE_SIZE - 1));
 
-	Point p = RemapCoords(x, y, z);
+	return RemapCoords(x, y, z);
+}
+
+/**
+ * Convert virtual coordinates to the screen coordinates of a viewport.
+ * @param vp The viewport.
+ * @param p The virtual coordinates.
+ * @return The screen coordinates.
+ */
+Point VirtualToViewportCoords(const ViewPort *vp, Point p)
+{
 	p.x = UnScaleByZoom(p.x - vp->virtual_left, vp->zoom) + vp->left;
 	p.y = UnScaleByZoom(p.y - vp->virtual_top, vp->zoom) + vp->top;
 	return p;
 }
 
+Point GetViewportStationMiddle(const ViewPort *vp, const Station *st)
+{
+	return VirtualToViewportCoords(vp, GetStationVirtualMiddle(st));
+}
+
 /** Helper class for getting the best sprite sorter. */
 struct ViewportSSCSS {
 	VpSorterChecker fct_checker; ///< The check function.
 	VpSpriteSorter fct_sorter;   ///< The sorting function.
+	const char *name;            ///< Name of the sorter, for the benchmark.
 };
 
 /** List of sorters ordered from best to worst. */
 static ViewportSSCSS _vp_sprite_sorters[] = {
+	{ &ViewportSortParentSpritesChecker, &ViewportSortParentSprites, "sweep" },
 #ifdef WITH_SSE
-	{ &ViewportSortParentSpritesSSE41Checker, &ViewportSortParentSpritesSSE41 },
+	{ &ViewportSortParentSpritesSSE41Checker, &ViewportSortParentSpritesSSE41, "quadratic-sse4.1" },
 #endif
-	{ &ViewportSortParentSpritesChecker, &ViewportSortParentSprites }
+	{ &ViewportSortParentSpritesChecker, &ViewportSortParentSpritesQuadratic, "quadratic" },
 };
 
 /** Choose the "best" sprite sorter and set _vp_sprite_sorter. */
@@ -3298,6 +4079,89 @@ void InitializeSpriteSorter()
 	assert(_vp_sprite_sorter != NULL);
 }
 
+/**
+ * Measure the available sprite sorters with sprites resembling a densely
+ * built town, and check that they all result in the same order as the
+ * quadratic sorter.
+ * @param count Number of sprites to sort.
+ * @param runs Number of times to sort them per sorter.
+ */
+void BenchmarkSpriteSorters(uint count, uint runs)
+{
+	/* Per tile a ground sprite with foundation and a building of random size and position, in the order ViewportAddLandscape adds them. */
+	uint side = max<uint>(1, IntSqrt(count / 2));
+	Randomizer random;
+	random.SetSeed(0x5350524B);
+	std::vector<ParentSpriteToDraw> sprites(count);
+	uint n = 0;
+	for (uint row = 0; n < count; row++) {
+		for (uint tx = 0; tx <= row && n < count; tx++) {
+			uint ty = row - tx;
+			if (tx >= side || ty >= side) continue;
+			int height = random.Next(4) * TILE_HEIGHT;
+			for (uint part = 0; part < 2 && n < count; part++) {
+				ParentSpriteToDraw *ps = &sprites[n++];
+				memset(ps, 0, sizeof(*ps));
+				if (part == 0) {
+					ps->xmin = tx * TILE_SIZE;
+					ps->ymin = ty * TILE_SIZE;
+					ps->zmin = height;
+					ps->xmax = ps->xmin + TILE_SIZE - 1;
+					ps->ymax = ps->ymin + TILE_SIZE - 1;
+					ps->zmax = ps->zmin + TILE_HEIGHT - 1;
+				} else {
+					ps->xmin = tx * TILE_SIZE + random.Next(6);
+					ps->ymin = ty * TILE_SIZE + random.Next(6);
+					ps->zmin = height + TILE_HEIGHT;
+					ps->xmax = ps->xmin + 4 + random.Next(TILE_SIZE - 10);
+					ps->ymax = ps->ymin + 4 + random.Next(TILE_SIZE - 10);
+					ps->zmax = ps->zmin + 8 + random.Next(56);
+				}
+			}
+		}
+		if (row > 2 * side) break;
+	}
+	count = n;
+
+	ParentSpriteToSortVector input;
+	for (uint i = 0; i < count; i++) *input.Append() = &sprites[i];
+	ParentSpriteToSortVector reference;
+	ParentSpriteToSortVector sorted;
+
+	IConsolePrintF(CC_DEFAULT, "Sorting %u sprites %u times:", count, runs);
+	for (int i = lengthof(_vp_sprite_sorters) - 1; i >= 0; i--) {
+		const ViewportSSCSS &sorter = _vp_sprite_sorters[i];
+		if (!sorter.fct_checker()) continue;
+
+		std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();
+		for (uint run = 0; run < runs; run++) {
+			sorted.Clear();
+			for (uint j = 0; j < count; j++) {
+				sprites[j].comparison_done = false;
+				*sorted.Append() = input[j];
+			}
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			sorter.fct_sorter(&sorted);
+			total += std::chrono::steady_clock::now() - start;
+		}
+
+		bool same = true;
+		if (reference.Length() == 0) {
+			reference.Swap(sorted);
+		} else {
+			for (uint j = 0; j < count; j++) {
+				if (sorted[j] != reference[j]) {
+					same = false;
+					break;
+				}
+			}
+		}
+
+		double ms = std::chrono::duration<double, std::milli>(total).count() / max<uint>(1, runs);
+		IConsolePrintF(same ? CC_DEFAULT : CC_ERROR, "  %-18s %10.3f ms per sort%s", sorter.name, ms, same ? "" : ", order differs!");
+	}
+}
+
 /**
  * Scroll players main viewport.
  * @param tile tile to center viewport on
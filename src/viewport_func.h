@@ -18,6 +18,8 @@
 #include "tile_map.h"
 #include "station_type.h"
 
+struct TileInfo;
+
 static const int TILE_HEIGHT_STEP = 50; ///< One Z unit tile height difference is displayed as 50m.
 
 void SetSelectionRed(bool);
@@ -30,6 +32,19 @@ Point GetTileBelowCursor();
 void UpdateViewportPosition(Window *w);
 
 void MarkAllViewportsDirty(int left, int top, int right, int bottom);
+bool IsPointNearAnyViewport(int x, int y, int margin_x, int margin_y);
+
+/**
+ * While an instance exists, areas passed to #MarkAllViewportsDirty are not
+ * marked dirty right away, but merged with the areas marked before, as long
+ * as that does not mark much more than the areas themselves. Meant for
+ * marking many areas that are close together, like the parts of a consist
+ * or the tiles of a construction drag.
+ */
+struct ViewportDirtyBatch {
+	ViewportDirtyBatch();
+	~ViewportDirtyBatch();
+};
 
 bool DoZoomInOutWindow(ZoomStateChange how, Window *w);
 void ZoomInOrOutToCursorWindow(bool in, Window * w);
@@ -56,6 +71,9 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 void ViewportAddString(const DrawPixelInfo *dpi, ZoomLevel small_from, const ViewportSign *sign, StringID string_normal, StringID string_small, StringID string_small_shadow, uint64 params_1, uint64 params_2 = 0, Colours colour = INVALID_COLOUR);
 
 
+void InvalidateTileDrawCache();
+void GetTileDrawState(const TileInfo *ti, uint32 state[4]);
+
 void StartSpriteCombine();
 void EndSpriteCombine();
 
@@ -65,6 +83,8 @@ void SetTileSelectSize(int w, int h);
 void SetTileSelectBigSize(int ox, int oy, int sx, int sy);
 
 void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom);
+bool PrefetchViewportSprites();
+void GetViewportSpriteStats(uint *tile, uint *parent, uint *child);
 
 bool ScrollWindowToTile(TileIndex tile, Window *w, bool instant = false);
 bool ScrollWindowTo(int x, int y, int z, Window *w, bool instant = false);
@@ -92,5 +112,7 @@ static inline void MarkTileDirtyByTile(TileIndex tile, int bridge_level_offset =
 }
 
 Point GetViewportStationMiddle(const ViewPort *vp, const Station *st);
+Point GetStationVirtualMiddle(const Station *st);
+Point VirtualToViewportCoords(const ViewPort *vp, Point p);
 
 #endif /* VIEWPORT_FUNC_H */
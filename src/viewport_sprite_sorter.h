@@ -54,5 +54,6 @@ void ViewportSortParentSpritesSSE41(ParentSpriteToSortVector *psdv);
 #endif
 
 void InitializeSpriteSorter();
+void BenchmarkSpriteSorters(uint count, uint runs);
 
 #endif /* VIEWPORT_SPRITE_SORTER_H */
@@ -28,6 +28,7 @@ enum FloodingBehaviour {
 FloodingBehaviour GetFloodingBehaviour(TileIndex tile);
 
 void TileLoop_Water(TileIndex tile);
+bool IsWaterTileLoopIdle(TileIndex tile);
 bool FloodHalftile(TileIndex t);
 void DoFloodTile(TileIndex target);
 
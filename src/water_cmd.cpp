@@ -17,6 +17,7 @@
 #include "town.h"
 #include "news_func.h"
 #include "depot_base.h"
+#include "depot_kdtree.h"
 #include "depot_func.h"
 #include "water.h"
 #include "industry_map.h"
@@ -39,6 +40,7 @@
 #include "company_base.h"
 #include "company_gui.h"
 #include "newgrf_generic.h"
+#include "pathfinder/water_regions.h"
 
 #include "table/strings.h"
 
@@ -137,6 +139,7 @@ CommandCost CmdBuildShipDepot(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 
 	if (flags & DC_EXEC) {
 		Depot *depot = new Depot(tile);
+		_depot_kdtree.Insert(depot->index);
 		depot->build_date = _date;
 
 		if (wc1 == WATER_CLASS_CANAL || wc2 == WATER_CLASS_CANAL) {
@@ -148,6 +151,8 @@ CommandCost CmdBuildShipDepot(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 
 		MakeShipDepot(tile,  _current_company, depot->index, DEPOT_PART_NORTH, axis, wc1);
 		MakeShipDepot(tile2, _current_company, depot->index, DEPOT_PART_SOUTH, axis, wc2);
+		InvalidateWaterRegion(tile);
+		InvalidateWaterRegion(tile2);
 		MarkTileDirtyByTile(tile);
 		MarkTileDirtyByTile(tile2);
 		MakeDefaultName(depot);
@@ -204,6 +209,7 @@ void MakeWaterKeepingClass(TileIndex tile, Owner o)
 		default: break;
 	}
 
+	InvalidateWaterRegion(tile);
 	MarkTileDirtyByTile(tile);
 }
 
@@ -303,6 +309,9 @@ static CommandCost DoBuildLock(TileIndex tile, DiagDirection dir, DoCommandFlag
 		}
 
 		MakeLock(tile, _current_company, dir, wc_lower, wc_upper, wc_middle);
+		InvalidateWaterRegion(tile);
+		InvalidateWaterRegion(tile - delta);
+		InvalidateWaterRegion(tile + delta);
 		MarkTileDirtyByTile(tile);
 		MarkTileDirtyByTile(tile - delta);
 		MarkTileDirtyByTile(tile + delta);
@@ -348,6 +357,7 @@ static CommandCost RemoveLock(TileIndex tile, DoCommandFlag flags)
 		} else {
 			DoClearSquare(tile);
 		}
+		InvalidateWaterRegion(tile);
 		MakeWaterKeepingClass(tile + delta, GetTileOwner(tile + delta));
 		MakeWaterKeepingClass(tile - delta, GetTileOwner(tile - delta));
 		MarkCanalsAndRiversAroundDirty(tile);
@@ -447,6 +457,7 @@ CommandCost CmdBuildCanal(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 					}
 					break;
 			}
+			InvalidateWaterRegion(tile);
 			MarkTileDirtyByTile(tile);
 			MarkCanalsAndRiversAroundDirty(tile);
 		}
@@ -490,6 +501,7 @@ static CommandCost ClearTile_Water(TileIndex tile, DoCommandFlag flags)
 					DirtyCompanyInfrastructureWindows(owner);
 				}
 				DoClearSquare(tile);
+				InvalidateWaterRegion(tile);
 				MarkCanalsAndRiversAroundDirty(tile);
 			}
 
@@ -505,6 +517,7 @@ static CommandCost ClearTile_Water(TileIndex tile, DoCommandFlag flags)
 
 			if (flags & DC_EXEC) {
 				DoClearSquare(tile);
+				InvalidateWaterRegion(tile);
 				MarkCanalsAndRiversAroundDirty(tile);
 			}
 			if (IsSlopeWithOneCornerRaised(slope)) {
@@ -1090,6 +1103,8 @@ void DoFloodTile(TileIndex target)
 	}
 
 	if (flooded) {
+		InvalidateWaterRegion(target);
+
 		/* Mark surrounding canal tiles dirty too to avoid glitches */
 		MarkCanalsAndRiversAroundDirty(target);
 
@@ -1134,6 +1149,7 @@ static void DoDryUp(TileIndex tile)
 
 			if (DoCommand(tile, 0, 0, DC_EXEC, CMD_LANDSCAPE_CLEAR).Succeeded()) {
 				MakeClear(tile, CLEAR_GRASS, 3);
+				InvalidateWaterRegion(tile);
 				MarkTileDirtyByTile(tile);
 			}
 			break;
@@ -1193,6 +1209,29 @@ void TileLoop_Water(TileIndex tile)
 	}
 }
 
+/**
+ * Check whether the tile loop of a water tile does nothing, apart from the
+ * ambient sound effect, as long as neither it nor its neighbours change type.
+ * That is the case for non-coast water tiles surrounded by water only, which
+ * make up most of the sea.
+ * @param tile The water tile to check.
+ * @return True if flooding and drying up cannot happen at the tile.
+ */
+bool IsWaterTileLoopIdle(TileIndex tile)
+{
+	assert(IsTileType(tile, MP_WATER));
+
+	if (IsCoast(tile)) return false;
+	/* Do not look beyond the map edges; tiles there have void neighbours anyway. */
+	if (TileX(tile) == 0 || TileY(tile) == 0) return false;
+
+	for (Direction dir = DIR_BEGIN; dir < DIR_END; dir++) {
+		TileIndex dest = tile + TileOffsByDir(dir);
+		if (dest >= MapSize() || !IsTileType(dest, MP_WATER)) return false;
+	}
+	return true;
+}
+
 void ConvertGroundTilesIntoWaterTiles()
 {
 	int z;
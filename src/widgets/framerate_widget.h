@@ -18,6 +18,10 @@ enum FramerateWindowWidgets {
 	WID_FRW_RATE_GAMELOOP,
 	WID_FRW_RATE_DRAWING,
 	WID_FRW_RATE_FACTOR,
+	WID_FRW_RATE_PF_CACHE,
+	WID_FRW_INVALIDATIONS,
+	WID_FRW_LINE_CACHE,
+	WID_FRW_VIEWPORT_SPRITES,
 	WID_FRW_INFO_DATA_POINTS,
 	WID_FRW_TIMES_NAMES,
 	WID_FRW_TIMES_CURRENT,
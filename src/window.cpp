@@ -11,6 +11,8 @@
 
 #include "stdafx.h"
 #include <stdarg.h>
+#include <algorithm>
+#include <vector>
 #include "company_func.h"
 #include "gfx_func.h"
 #include "console_func.h"
@@ -60,6 +62,15 @@ Window *_z_front_window = NULL;
 /** List of windows opened at the screen sorted from the back. */
 Window *_z_back_window  = NULL;
 
+/**
+ * The windows opened at the screen per window class, including windows that are deleted but not yet freed.
+ * This lets finding the windows of a class skip all windows of other classes.
+ */
+static std::vector<Window *> _class_windows[WC_END];
+
+static uint64 _scheduled_invalidations = 0; ///< Number of GUI-scope invalidations that have been scheduled.
+static uint64 _merged_invalidations = 0;    ///< Number of GUI-scope invalidations that were merged into an already scheduled one.
+
 /** If false, highlight is white, otherwise the by the widget defined colour. */
 bool _window_highlight_colour = false;
 
@@ -1103,6 +1114,52 @@ Window::~Window()
 	const_cast<volatile WindowClass &>(this->window_class) = WC_INVALID;
 }
 
+/**
+ * Add a window to the window class index.
+ * @param w Window to add
+ */
+static void AddWindowToClassIndex(Window *w)
+{
+	assert(w->window_class < WC_END);
+	w->index_class = w->window_class;
+	_class_windows[w->index_class].push_back(w);
+}
+
+/**
+ * Remove a window from the window class index.
+ * @param w Window to remove
+ */
+static void RemoveWindowFromClassIndex(Window *w)
+{
+	std::vector<Window *> &windows = _class_windows[w->index_class];
+	std::vector<Window *>::iterator it = std::find(windows.begin(), windows.end(), w);
+	assert(it != windows.end());
+	*it = windows.back();
+	windows.pop_back();
+}
+
+/**
+ * Get the windows of a class, in no particular order.
+ * @param cls Window class
+ * @return The windows that were opened with this class; deleted ones have to be skipped.
+ */
+static inline const std::vector<Window *> &GetClassWindows(WindowClass cls)
+{
+	static const std::vector<Window *> none;
+	return cls < WC_END ? _class_windows[cls] : none;
+}
+
+/**
+ * Change the class of a window that has been opened already.
+ * @param cls The new window class.
+ */
+void Window::ChangeWindowClass(WindowClass cls)
+{
+	RemoveWindowFromClassIndex(this);
+	this->window_class = cls;
+	AddWindowToClassIndex(this);
+}
+
 /**
  * Find a window by its class and window number
  * @param cls Window class
@@ -1111,12 +1168,22 @@ Window::~Window()
  */
 Window *FindWindowById(WindowClass cls, WindowNumber number)
 {
-	Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		if (w->window_class == cls && w->window_number == number) return w;
+	Window *found = NULL;
+	const std::vector<Window *> &windows = GetClassWindows(cls);
+	for (std::vector<Window *>::const_iterator it = windows.begin(); it != windows.end(); it++) {
+		Window *w = *it;
+		if (w->window_class != cls || w->window_number != number) continue;
+		if (found != NULL) {
+			/* Several windows match; return the back most one, like we always did. */
+			FOR_ALL_WINDOWS_FROM_BACK(w) {
+				if (w->window_class == cls && w->window_number == number) return w;
+			}
+			NOT_REACHED();
+		}
+		found = w;
 	}
 
-	return NULL;
+	return found;
 }
 
 /**
@@ -1127,12 +1194,22 @@ Window *FindWindowById(WindowClass cls, WindowNumber number)
  */
 Window *FindWindowByClass(WindowClass cls)
 {
-	Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		if (w->window_class == cls) return w;
+	Window *found = NULL;
+	const std::vector<Window *> &windows = GetClassWindows(cls);
+	for (std::vector<Window *>::const_iterator it = windows.begin(); it != windows.end(); it++) {
+		Window *w = *it;
+		if (w->window_class != cls) continue;
+		if (found != NULL) {
+			/* Several windows match; return the back most one, like we always did. */
+			FOR_ALL_WINDOWS_FROM_BACK(w) {
+				if (w->window_class == cls) return w;
+			}
+			NOT_REACHED();
+		}
+		found = w;
 	}
 
-	return NULL;
+	return found;
 }
 
 /**
@@ -1474,6 +1551,7 @@ void Window::InitializeData(WindowNumber window_number)
 
 	/* Insert the window into the correct location in the z-ordering. */
 	AddWindowToZOrdering(this);
+	AddWindowToClassIndex(this);
 }
 
 /**
@@ -1878,6 +1956,7 @@ void InitWindowSystem()
 
 	_z_back_window = NULL;
 	_z_front_window = NULL;
+	for (uint i = 0; i < lengthof(_class_windows); i++) _class_windows[i].clear();
 	_focused_window = NULL;
 	_mouseover_last_w = NULL;
 	_last_scroll_window = NULL;
@@ -1908,6 +1987,7 @@ void UnInitWindowSystem()
 
 	_z_front_window = NULL;
 	_z_back_window = NULL;
+	for (uint i = 0; i < lengthof(_class_windows); i++) _class_windows[i].clear();
 }
 
 /**
@@ -3079,6 +3159,7 @@ void InputLoop()
 		if (w->window_class != WC_INVALID) continue;
 
 		RemoveWindowFromZOrdering(w);
+		RemoveWindowFromClassIndex(w);
 		free(w);
 	}
 
@@ -3116,6 +3197,7 @@ void UpdateWindows()
 	if (delta_ms == 0) return;
 
 	PerformanceMeasurer framerate(PFE_DRAWING);
+	framerate.SetExpectedRate(_settings_client.gui.refresh_rate);
 	PerformanceAccumulator::Reset(PFE_DRAWWORLD);
 
 	CallWindowRealtimeTickEvent(delta_ms);
@@ -3198,8 +3280,9 @@ void UpdateWindows()
  */
 void SetWindowDirty(WindowClass cls, WindowNumber number)
 {
-	const Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
+	const std::vector<Window *> &windows = GetClassWindows(cls);
+	for (std::vector<Window *>::const_iterator it = windows.begin(); it != windows.end(); it++) {
+		const Window *w = *it;
 		if (w->window_class == cls && w->window_number == number) w->SetDirty();
 	}
 }
@@ -3212,8 +3295,9 @@ void SetWindowDirty(WindowClass cls, WindowNumber number)
  */
 void SetWindowWidgetDirty(WindowClass cls, WindowNumber number, byte widget_index)
 {
-	const Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
+	const std::vector<Window *> &windows = GetClassWindows(cls);
+	for (std::vector<Window *>::const_iterator it = windows.begin(); it != windows.end(); it++) {
+		const Window *w = *it;
 		if (w->window_class == cls && w->window_number == number) {
 			w->SetWidgetDirty(widget_index);
 		}
@@ -3226,8 +3310,9 @@ void SetWindowWidgetDirty(WindowClass cls, WindowNumber number, byte widget_inde
  */
 void SetWindowClassesDirty(WindowClass cls)
 {
-	Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
+	const std::vector<Window *> &windows = GetClassWindows(cls);
+	for (std::vector<Window *>::const_iterator it = windows.begin(); it != windows.end(); it++) {
+		const Window *w = *it;
 		if (w->window_class == cls) w->SetDirty();
 	}
 }
@@ -3241,8 +3326,14 @@ void Window::InvalidateData(int data, bool gui_scope)
 {
 	this->SetDirty();
 	if (!gui_scope) {
-		/* Schedule GUI-scope invalidation for next redraw. */
-		*this->scheduled_invalidation_data.Append() = data;
+		/* Schedule GUI-scope invalidation for next redraw. All scheduled
+		 * invalidations see the same state when they are processed, so
+		 * processing the same data a second time would only redo the work. */
+		if (this->scheduled_invalidation_data.Include(data)) {
+			_merged_invalidations++;
+		} else {
+			_scheduled_invalidations++;
+		}
 	}
 	this->OnInvalidateData(data, gui_scope);
 }
@@ -3298,8 +3389,10 @@ void Window::ProcessHighlightedInvalidations()
  */
 void InvalidateWindowData(WindowClass cls, WindowNumber number, int data, bool gui_scope)
 {
-	Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
+	/* Invalidating may open windows of the same class, so don't hold on to iterators. */
+	const std::vector<Window *> &windows = GetClassWindows(cls);
+	for (size_t i = 0; i < windows.size(); i++) {
+		Window *w = windows[i];
 		if (w->window_class == cls && w->window_number == number) {
 			w->InvalidateData(data, gui_scope);
 		}
@@ -3316,15 +3409,27 @@ void InvalidateWindowData(WindowClass cls, WindowNumber number, int data, bool g
  */
 void InvalidateWindowClassesData(WindowClass cls, int data, bool gui_scope)
 {
-	Window *w;
-
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
+	/* Invalidating may open windows of the same class, so don't hold on to iterators. */
+	const std::vector<Window *> &windows = GetClassWindows(cls);
+	for (size_t i = 0; i < windows.size(); i++) {
+		Window *w = windows[i];
 		if (w->window_class == cls) {
 			w->InvalidateData(data, gui_scope);
 		}
 	}
 }
 
+/**
+ * Get the statistics of the scheduled GUI-scope window invalidations.
+ * @param[out] scheduled Number of invalidations that have been scheduled.
+ * @param[out] merged    Number of invalidations that were merged into an already scheduled one.
+ */
+void GetWindowInvalidationStats(uint64 *scheduled, uint64 *merged)
+{
+	*scheduled = _scheduled_invalidations;
+	*merged = _merged_invalidations;
+}
+
 /**
  * Dispatch OnGameTick event over all windows
  */
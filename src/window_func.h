@@ -37,6 +37,7 @@ void InputLoop();
 
 void InvalidateWindowData(WindowClass cls, WindowNumber number, int data = 0, bool gui_scope = false);
 void InvalidateWindowClassesData(WindowClass cls, int data = 0, bool gui_scope = false);
+void GetWindowInvalidationStats(uint64 *scheduled, uint64 *merged);
 
 void DeleteNonVitalWindows();
 void DeleteAllNonVitalWindows();
@@ -305,6 +305,7 @@ public:
 	WindowFlags flags;          ///< Window flags
 	WindowClass window_class;   ///< Window class
 	WindowNumber window_number; ///< Window number within the window class
+	WindowClass index_class;    ///< Window class the window is listed under in the window class index.
 
 	uint8 timeout_timer;      ///< Timer value of the WF_TIMEOUT for flags.
 	uint8 white_border_timer; ///< Timer value of the WF_WHITE_BORDER for flags.
@@ -355,6 +356,8 @@ public:
 	void CreateNestedTree(bool fill_nested = true);
 	void FinishInitNested(WindowNumber window_number = 0);
 
+	void ChangeWindowClass(WindowClass cls);
+
 	/**
 	 * Set the timeout flag of the window and initiate the timer.
 	 */
@@ -693,6 +693,7 @@ enum WindowClass {
 	 */
 	WC_FRAMETIME_GRAPH,
 
+	WC_END,              ///< End of the window classes.
 	WC_INVALID = 0xFFFF, ///< Invalid window.
 };
 